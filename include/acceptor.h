@@ -0,0 +1,70 @@
+#ifndef ACCEPTOR_H
+#define ACCEPTOR_H
+
+#include <time.h>
+#include <stdatomic.h>
+#include "tslog.h"
+
+// Vários sockets TCP ouvindo na mesma porta (SO_REUSEPORT), cada um com a
+// sua thread de accept fixada numa CPU. O kernel espalha as conexões entre
+// os sockets pelo hash do endereço do cliente, então uma rajada não passa
+// por uma thread só. O handler de cada conexão é criado pela thread que a
+// aceitou e herda a CPU dela: leituras, respostas e os buffers da conexão
+// (line_reader, anel do io_uring) ficam no mesmo núcleo.
+// Uma thread sem lista de CPUs é o comportamento antigo: um socket, sem
+// SO_REUSEPORT e sem afinidade. Kernel sem SO_REUSEPORT (ou
+// SCHEDULER_REUSEPORT=0) volta para ele, com aviso no log.
+
+#define ACCEPTOR_MAX 64
+#define ACCEPTOR_REUSEPORT_ENV "SCHEDULER_REUSEPORT"    // "0": um acceptor só
+#define ACCEPTOR_RATE_WINDOW 60         // segundos da taxa de accept
+
+typedef struct {
+    _Alignas(64) int index;             // um acceptor por linha de cache
+    int cpu;                            // -1 = sem afinidade
+    int listen_socket;
+    tslog_t *logger;
+    atomic_long accepted;
+    atomic_int active;                  // conexões abertas agora
+    // Accepts por segundo (anel de ACCEPTOR_RATE_WINDOW); só a thread do
+    // acceptor escreve
+    atomic_long rate_count[ACCEPTOR_RATE_WINDOW];
+    atomic_long rate_second[ACCEPTOR_RATE_WINDOW];
+} acceptor_t;
+
+typedef struct {
+    acceptor_t acceptors[ACCEPTOR_MAX];
+    int count;
+    time_t started;
+    tslog_t *logger;
+} acceptor_set_t;
+
+typedef struct {
+    int index;
+    int cpu;
+    long accepted;
+    int active;
+    double rate;                        // accepts/s no último minuto
+} acceptor_stats_t;
+
+// "0-3,6" -> {0, 1, 2, 3, 6}; retorna quantas CPUs ou -1 se a lista é inválida
+int acceptor_parse_cpus(const char *spec, int *cpus, int max);
+
+// Cria `count` sockets na porta (um só sem SO_REUSEPORT: ver set->count).
+// Sem lista de CPUs: nenhuma afinidade com um acceptor, as CPUs permitidas
+// ao processo em rodízio com vários.
+// -1 (com log) se a porta está ocupada ou algum socket falhou.
+int acceptor_set_init(acceptor_set_t *set, int port, int backlog, int count,
+                      const int *cpus, int cpu_count, tslog_t *logger);
+void acceptor_set_destroy(acceptor_set_t *set);
+
+// Fixa a thread atual na CPU do acceptor (as threads que ela criar herdam)
+void acceptor_pin(acceptor_t *acceptor);
+// Conexão aceita e entregue a um handler / handler terminou
+void acceptor_opened(acceptor_t *acceptor);
+void acceptor_closed(acceptor_t *acceptor);
+
+// Contadores por acceptor; retorna quantos foram preenchidos
+int acceptor_set_get_stats(acceptor_set_t *set, acceptor_stats_t *stats, int max);
+
+#endif
@@ -0,0 +1,43 @@
+#ifndef CAPABILITY_H
+#define CAPABILITY_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <pthread.h>
+
+// Capacidades: tags livres ("python3", "lua", "python3.11", "gpu") que o
+// worker anuncia no registro e que o job exige com needs=. Cada tag recebe
+// um bit na primeira vez que aparece; um conjunto de tags vira uma máscara
+// e "o worker atende o job" é (exigidas & ~oferecidas) == 0, em O(1).
+// Os bits não são estáveis entre execuções: o que se persiste são os nomes.
+
+#define CAPABILITY_MAX 64               // bits da máscara
+#define CAPABILITY_NAME_MAX 32
+#define CAPABILITY_LIST_MAX 256         // "tag,tag,..." anunciado por um worker
+
+typedef uint64_t cap_mask_t;
+
+typedef struct {
+    char names[CAPABILITY_MAX][CAPABILITY_NAME_MAX];
+    int count;
+    pthread_mutex_t mutex;
+} capability_registry_t;
+
+int capability_registry_init(capability_registry_t *reg);
+void capability_registry_destroy(capability_registry_t *reg);
+
+// "a,b,c" -> máscara, registrando as tags novas. Retorna -1 se a lista é
+// inválida ou não há mais bits livres.
+int capability_intern(capability_registry_t *reg, const char *list, cap_mask_t *mask);
+// Como capability_intern, mas sem registrar: retorna 1 (e o nome em
+// `unknown`) se alguma tag nunca foi vista, ou seja, ninguém a oferece
+int capability_lookup(capability_registry_t *reg, const char *list, cap_mask_t *mask,
+                      char *unknown, size_t unknown_size);
+// Máscara -> "a,b,c" (ordem dos bits); "" para a máscara vazia
+void capability_format(capability_registry_t *reg, cap_mask_t mask, char *buffer, size_t size);
+
+static inline int capability_satisfies(cap_mask_t offered, cap_mask_t required) {
+    return (required & ~offered) == 0;
+}
+
+#endif
@@ -0,0 +1,28 @@
+#ifndef CRON_EXPR_H
+#define CRON_EXPR_H
+
+#include <stdint.h>
+#include <time.h>
+
+// Expressão cron de 5 campos: "minuto hora dia-do-mês mês dia-da-semana".
+// Cada campo aceita *, números, intervalos (a-b), listas (a,b) e passos
+// (*/n, a-b/n). Dia da semana vai de 0 a 7 (0 e 7 = domingo). Também aceita
+// @hourly, @daily, @weekly, @monthly e @yearly. Avaliada no fuso local.
+
+typedef struct {
+    uint64_t minutes;           // bit i = minuto i
+    uint32_t hours;
+    uint32_t days;              // bits 1..31
+    uint16_t months;            // bits 1..12
+    uint8_t weekdays;           // bits 0..6
+    int any_day;                // dia-do-mês era *
+    int any_weekday;            // dia-da-semana era *
+} cron_expr_t;
+
+// Retorna 0 se a expressão é válida
+int cron_expr_parse(const char *text, cron_expr_t *expr);
+// Primeiro instante (minuto cheio) estritamente depois de `after`; -1 se não
+// houver nenhum nos próximos anos (ex.: 31 de fevereiro)
+time_t cron_expr_next(const cron_expr_t *expr, time_t after);
+
+#endif
@@ -4,14 +4,70 @@
 #include <sqlite3.h>
 #include "../common/protocol.h"
 #include "../include/tslog.h"
+#include "../include/job_stats.h"
+#include "../include/idempotency.h"
+
+// Linha da tabela jobs devolvida pelas consultas de histórico
+typedef struct {
+    int job_id;
+    char script[MAX_SCRIPT_SIZE];
+    int priority;
+    int status;
+    char submitted_at[32];
+    char completed_at[32];
+    char result[MAX_RESULT_SIZE];
+    double execution_time;
+} job_record_t;
+
+// Agendamento persistido (ver job_scheduler.h): modelo do job e próximo disparo
+typedef struct {
+    int schedule_id;
+    job_t job;
+    time_t next_run;
+    int every;
+    char cron[JOB_CRON_MAX];
+    int jitter;
+} schedule_record_t;
 
 // Inicialização e finalização
+// Arquivo do banco (padrão scheduler.db); chamar antes de database_init
+void database_set_file(const char *path);
 int database_init(tslog_t *logger);
 void database_close();
 
 // Operações com jobs
 int database_save_job(const job_t *job);
 int database_update_job_result(int job_id, int success, const char *result, double exec_time);
+// Estado final sem resultado do worker (ex.: dead-letter), com o motivo em result_text
+int database_update_job_status(int job_id, job_status_t status, int attempts, const char *reason);
 int database_get_job_stats(int *total, int *completed, int *failed, double *avg_time);
 
+// Consultas de leitura: usam o pool somente leitura (snapshot WAL) e nunca
+// disputam a conexão de escrita usada por submissões e resultados
+int database_get_job_history(int limit, int offset,
+                             void (*callback)(const job_record_t *rec, void *arg), void *arg);
+int database_get_job(int job_id, job_record_t *rec);   // 0 = achou, 1 = não existe
+// Maior job_id já gravado (0 = nenhum, -1 = erro)
+int database_get_max_job_id(void);
+
+// Tabela de resumo das estatísticas incrementais
+int database_save_stats(const job_stats_row_t *rows, int count);
+int database_load_stats(void (*callback)(const job_stats_row_t *row, void *arg), void *arg);
+
+// Agendamentos (jobs adiados e recorrentes)
+int database_save_schedule(const schedule_record_t *rec);
+int database_update_schedule(int schedule_id, time_t next_run);
+int database_delete_schedule(int schedule_id);
+int database_load_schedules(void (*callback)(const schedule_record_t *rec, void *arg), void *arg);
+
+// Chaves de idempotência: gravação em lote (também apaga as vencidas) e
+// carregamento das ainda válidas, da mais antiga para a mais nova
+int database_save_idempotency_keys(const idempotency_record_t *rows, int count, time_t now);
+int database_load_idempotency_keys(time_t now, void (*callback)(const idempotency_record_t *rec, void *arg),
+                                   void *arg);
+
+// Conjuntos de capacidades já anunciados ("tag,tag"; ver worker_manager_can_satisfy)
+int database_save_worker_profile(const char *tags);
+int database_load_worker_profiles(void (*callback)(const char *tags, void *arg), void *arg);
+
 #endif
\ No newline at end of file
@@ -0,0 +1,38 @@
+#ifndef HIER_WHEEL_H
+#define HIER_WHEEL_H
+
+#include "timing_wheel.h"
+
+// Timing wheel hierárquica: 4 níveis de 256 slots. O nível 0 tem um slot por
+// tick; cada nível acima cobre 256 vezes mais tempo. Timers distantes entram
+// num nível alto e descem (cascata) quando o slot dele chega, no máximo uma
+// vez por nível, então agendar e vencer são O(1) mesmo com milhões de timers
+// espalhados por meses. Com tick de 1s o alcance é de 2^32 s; além disso o
+// timer fica no último slot do nível mais alto e é reavaliado na cascata.
+// Usa os mesmos nós da timing_wheel (timing_wheel_pending serve aqui).
+// Não é thread-safe: quem usa protege com o próprio mutex.
+
+#define HIER_WHEEL_LEVELS 4
+#define HIER_WHEEL_BITS 8
+#define HIER_WHEEL_SLOTS (1 << HIER_WHEEL_BITS)
+
+typedef struct {
+    timer_node_t slots[HIER_WHEEL_LEVELS][HIER_WHEEL_SLOTS];
+    int tick_ms;
+    long current;               // último tick processado
+    long origin_ms;             // relógio monotônico no tick 0
+    long count;                 // timers agendados
+} hier_wheel_t;
+
+int hier_wheel_init(hier_wheel_t *wheel, int tick_ms);
+void hier_wheel_destroy(hier_wheel_t *wheel);
+
+// (Re)agenda o timer para daqui a delay_ms (arredondado para cima em ticks)
+void hier_wheel_schedule(hier_wheel_t *wheel, timer_node_t *node, long delay_ms);
+void hier_wheel_cancel(hier_wheel_t *wheel, timer_node_t *node);
+
+// Processa os ticks até agora e chama `expire` para cada timer vencido (já
+// fora da roda: o callback pode reagendá-lo ou liberar o nó). Retorna quantos venceram.
+int hier_wheel_advance(hier_wheel_t *wheel, void (*expire)(timer_node_t *node, void *arg), void *arg);
+
+#endif
@@ -0,0 +1,96 @@
+#ifndef IDEMPOTENCY_H
+#define IDEMPOTENCY_H
+
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "int_map.h"
+#include "tslog.h"
+#include "../src/common/protocol.h"
+
+// Chaves de idempotência: JOB?key=<chave>:... reenviado (o cliente não soube
+// se a submissão chegou) recebe a resposta da primeira vez em vez de criar
+// outro job. As chaves vivem `ttl` segundos, no máximo `max_keys` ao todo;
+// cada faixa (hash da chave) tem trava própria e duas listas na ordem de
+// chegada, que com o ttl fixo também é a ordem de vencimento: as pendentes
+// (submissão em curso) e as respondidas. Só as respondidas são despejadas,
+// então expirar e despejar a mais antiga custam O(1); com a faixa cheia só
+// de pendentes, ela passa do limite até os commits chegarem.
+// Persistência: as chaves novas são gravadas em lote a cada
+// IDEMPOTENCY_FLUSH_INTERVAL segundos (e no carregamento as que ainda não
+// venceram voltam), então uma queda perde no máximo esse intervalo.
+
+#define IDEMPOTENCY_STRIPES 64
+#define IDEMPOTENCY_DEFAULT_TTL 600             // segundos
+#define IDEMPOTENCY_DEFAULT_MAX 500000          // chaves lembradas (~60 MB)
+#define IDEMPOTENCY_FLUSH_INTERVAL 2            // segundos entre gravações
+#define IDEMPOTENCY_PENDING_RETRY_MS 200        // duplicata da submissão ainda em curso
+
+typedef enum {
+    IDEMPOTENCY_PENDING,        // a primeira submissão ainda está sendo tratada
+    IDEMPOTENCY_JOB,            // respondida com JOB_ACCEPTED:<id>
+    IDEMPOTENCY_SCHEDULE        // respondida com JOB_SCHEDULED:<id>:<primeiro disparo>
+} idempotency_kind_t;
+
+typedef struct {
+    char key[JOB_KEY_MAX];
+    idempotency_kind_t kind;
+    int id;
+    time_t first_run;
+    time_t expires_at;
+} idempotency_record_t;
+
+typedef struct idempotency_entry {
+    idempotency_record_t rec;
+    struct idempotency_entry *next;     // outra chave com o mesmo hash
+    struct idempotency_entry *older;    // ordem de chegada
+    struct idempotency_entry *newer;
+} idempotency_entry_t;
+
+typedef struct {
+    idempotency_entry_t *oldest;        // próxima a vencer
+    idempotency_entry_t *newest;
+} idempotency_list_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int_map_t heads;                    // hash da chave -> lista de entradas
+    idempotency_list_t pending;         // submissões em curso
+    idempotency_list_t answered;        // a mais antiga é a próxima despejada
+    int live;                           // entradas da faixa
+    idempotency_record_t *dirty;        // ainda não gravadas
+    int dirty_count;
+    int dirty_capacity;
+} idempotency_stripe_t;
+
+typedef struct {
+    idempotency_stripe_t stripes[IDEMPOTENCY_STRIPES];
+    int ttl;
+    int stripe_capacity;                // max_keys / IDEMPOTENCY_STRIPES
+    tslog_t *logger;
+    atomic_long hits;                   // duplicatas respondidas
+    atomic_long misses;                 // chaves novas
+    atomic_long evicted;                // despejadas antes de vencer (limite de chaves)
+} idempotency_t;
+
+int idempotency_init(idempotency_t *idem, int ttl, int max_keys, tslog_t *logger);
+void idempotency_destroy(idempotency_t *idem);
+
+// Reserva a chave para a submissão atual: 0 se é nova (terminar com commit
+// ou release), 1 se já existe (cópia em *existing; kind PENDING quer dizer
+// que a primeira ainda está em curso)
+int idempotency_claim(idempotency_t *idem, const char *key, idempotency_record_t *existing);
+void idempotency_commit(idempotency_t *idem, const char *key, idempotency_kind_t kind,
+                        int id, time_t first_run);
+// A submissão foi recusada: a chave volta a valer para uma nova tentativa
+void idempotency_release(idempotency_t *idem, const char *key);
+
+// Grava em lote as chaves novas e apaga as vencidas do banco
+int idempotency_flush(idempotency_t *idem);
+// Restaura as chaves ainda válidas
+int idempotency_load(idempotency_t *idem);
+
+long idempotency_count(idempotency_t *idem);
+void idempotency_get_counters(idempotency_t *idem, long *hits, long *misses, long *evicted);
+
+#endif
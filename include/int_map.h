@@ -0,0 +1,35 @@
+#ifndef INT_MAP_H
+#define INT_MAP_H
+
+#include <stddef.h>
+
+// Tabela hash de chave inteira (ids de worker, job, ...) com encadeamento.
+// Busca, inserção e remoção em O(1) médio; cresce ao passar de 75% de carga.
+// Não é thread-safe: quem usa protege com o próprio mutex.
+
+typedef struct int_map_entry {
+    int key;
+    void *value;
+    struct int_map_entry *next;
+} int_map_entry_t;
+
+typedef struct {
+    int_map_entry_t **buckets;
+    size_t capacity;            // sempre potência de 2
+    size_t size;
+} int_map_t;
+
+int int_map_init(int_map_t *map, size_t capacity);
+void int_map_destroy(int_map_t *map);
+
+void* int_map_get(const int_map_t *map, int key);
+// Insere ou substitui; retorna -1 se faltar memória
+int int_map_put(int_map_t *map, int key, void *value);
+// Retorna o valor removido (NULL se a chave não existia)
+void* int_map_remove(int_map_t *map, int key);
+// Chave para nomes (clientes, batches): FNV-1a de 31 bits. Nomes diferentes
+// podem colidir; quem usa compara o nome e sonda key + 1.
+int int_map_string_key(const char *str);
+void int_map_foreach(const int_map_t *map, void (*callback)(int key, void *value, void *arg), void *arg);
+
+#endif
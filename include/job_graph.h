@@ -0,0 +1,97 @@
+#ifndef JOB_GRAPH_H
+#define JOB_GRAPH_H
+
+#include <pthread.h>
+#include "job_queue.h"
+#include "int_map.h"
+#include "tslog.h"
+#include "../src/common/protocol.h"
+
+// Dependências entre jobs ("after=12,15,@etl"). Um job com dependências
+// pendentes fica fora da fila, com um contador de dependências não
+// resolvidas; cada dependência guarda as arestas reversas (quem espera por
+// ela). Ao terminar, um job só visita os próprios dependentes: O(grau de
+// saída). Falha ou cancelamento se propagam pelos dependentes.
+//
+// Batch: "batch=<nome>" coloca o job num grupo; "after=@<nome>" depende de
+// todos os membros ainda não terminados do grupo (um membro que já falhou
+// faz o dependente falhar). É o jeito barato de declarar fan-in grande.
+//
+// Ciclos são impossíveis por construção: só se pode depender de ids que já
+// existem na submissão (o próprio id e ids futuros são rejeitados).
+
+#define JOB_GRAPH_MAX_DEPS 256      // ids explícitos em after=
+
+typedef enum {
+    GRAPH_WAITING,              // segurado aqui até zerar `unresolved`
+    GRAPH_QUEUED                // na fila ou executando; só acompanhado
+} graph_state_t;
+
+typedef struct job_batch job_batch_t;
+
+typedef struct graph_node {
+    int job_id;
+    graph_state_t state;
+    int unresolved;
+    int *dependents;            // arestas reversas (ids)
+    int dependent_count;
+    int dependent_capacity;
+    job_t *job;                 // cópia do job enquanto WAITING
+    job_batch_t *batch;
+    int batch_index;            // posição em batch->pending
+    struct graph_node *next;    // pilha da propagação de falhas
+} graph_node_t;
+
+struct job_batch {
+    char name[JOB_CLIENT_MAX];
+    int map_key;
+    int *pending;               // membros ainda não terminados
+    int pending_count;
+    int pending_capacity;
+    long members;
+    long failed;
+    int last_failed;            // causa registrada nos dependentes que nascem falhados
+};
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int_map_t nodes;            // job_id -> graph_node_t* (só jobs não terminados)
+    int_map_t batches;          // hash do nome -> job_batch_t*
+    job_queue_t *queue;
+    tslog_t *logger;
+    long waiting;
+    long released;
+    long failed;                // falhas/cancelamentos propagados
+    // Opcional (ex.: notificações): job que o grafo encerrou sem executar
+    void (*on_final)(int job_id, job_status_t status, const char *batch, const char *needs, void *arg);
+    void *final_arg;
+} job_graph_t;
+
+int job_graph_init(job_graph_t *graph, job_queue_t *queue, tslog_t *logger);
+void job_graph_destroy(job_graph_t *graph);
+
+// Submete um job com dependências (after) e/ou grupo (batch). O job vai
+// direto para a fila se nada estiver pendente. Retorna o id do job ou -1
+// com a mensagem em `error`.
+int job_graph_submit(job_graph_t *graph, job_t *job, const char *after, const char *batch,
+                     char *error, size_t error_size);
+// Resultado final de um job (sucesso, falha ou dead-letter): libera ou
+// derruba os dependentes. Ids desconhecidos são ignorados em O(1).
+void job_graph_finish(job_graph_t *graph, int job_id, int success);
+// Cancela um job que ainda aguarda dependências (e os dependentes dele)
+int job_graph_cancel(job_graph_t *graph, int job_id);
+// Job já liberado que foi cancelado na fila ou em execução: os dependentes
+// são cancelados como se ele tivesse sido cancelado aqui
+void job_graph_finish_cancelled(job_graph_t *graph, int job_id);
+// Batch do job ainda acompanhado pelo grafo (antes de job_graph_finish);
+// -1 se ele não tem batch ou já saiu
+int job_graph_batch_of(job_graph_t *graph, int job_id, char *batch, size_t size);
+// Chamado sem o mutex do grafo para cada job cancelado aqui ou derrubado por
+// uma dependência (defina antes de haver tráfego)
+void job_graph_set_final_hook(job_graph_t *graph,
+                              void (*hook)(int job_id, job_status_t status, const char *batch,
+                                           const char *needs, void *arg),
+                              void *arg);
+void job_graph_get_counters(job_graph_t *graph, long *waiting, long *released, long *failed);
+
+#endif
@@ -0,0 +1,74 @@
+#ifndef JOB_INDEX_H
+#define JOB_INDEX_H
+
+#include <time.h>
+#include <pthread.h>
+#include "int_map.h"
+#include "../src/common/protocol.h"
+
+// Índice de estado por id de job, para STATUS e LIST_JOBS. Cada transição
+// (fila, lease, resultado, cancelamento) atualiza a entrada do job; a
+// consulta só trava a faixa do id (JOB_INDEX_STRIPES travas de leitura e
+// escrita), nunca o mutex da fila nem o SQLite: milhares de clientes
+// consultando não disputam com quem tira jobs da fila.
+// Jobs terminados ficam no índice até serem os mais antigos de
+// JOB_INDEX_RETAIN terminados; depois disso só o banco sabe deles.
+
+#define JOB_INDEX_STRIPES 64
+#define JOB_INDEX_RETAIN 65536          // jobs terminados mantidos
+#define JOB_INDEX_PAGE_MAX 100          // jobs por página de LIST_JOBS
+
+typedef struct {
+    int job_id;
+    job_status_t status;
+    int worker_id;              // 0 = nenhum (pendente ou terminado sem worker)
+    int attempts;
+    int priority;
+    char client[JOB_CLIENT_MAX];
+    time_t submitted_at;
+    time_t updated_at;
+} job_index_entry_t;
+
+typedef struct {
+    pthread_rwlock_t lock;
+    int_map_t entries;          // job_id -> job_index_entry_t*
+} job_index_stripe_t;
+
+typedef struct {
+    job_index_stripe_t stripes[JOB_INDEX_STRIPES];
+    pthread_mutex_t finished_mutex;
+    int *finished;              // anel dos terminados, do mais antigo ao mais novo
+    int finished_head;
+    int finished_count;
+    // Opcional (ex.: replicação): cada transição, conhecida ou não do índice
+    void (*on_update)(int job_id, job_status_t status, int worker_id, int attempts, void *arg);
+    void *update_arg;
+} job_index_t;
+
+// Filtro de LIST_JOBS: status < 0 e client "" aceitam qualquer um
+typedef struct {
+    int status;
+    char client[JOB_CLIENT_MAX];
+    int after;                  // cursor: só ids maiores
+} job_index_filter_t;
+
+int job_index_init(job_index_t *index);
+void job_index_destroy(job_index_t *index);
+
+// Job novo ou que voltou a existir no servidor (cria ou sobrescreve a entrada)
+void job_index_track(job_index_t *index, const job_t *job, job_status_t status);
+// Transição de um job conhecido; ignora ids que o índice não tem
+void job_index_update(job_index_t *index, int job_id, job_status_t status, int worker_id, int attempts);
+// Retorna -1 se o id não está no índice
+int job_index_get(job_index_t *index, int job_id, job_index_entry_t *out);
+// Até `max` entradas em ordem de id depois de filter->after; retorna quantas
+int job_index_list(job_index_t *index, const job_index_filter_t *filter,
+                   job_index_entry_t *out, int max);
+int job_index_is_final(job_status_t status);
+// Chamado por job_index_update depois de soltar a faixa (defina antes de
+// haver tráfego: não é sincronizado)
+void job_index_set_update_hook(job_index_t *index,
+                               void (*hook)(int job_id, job_status_t status, int worker_id,
+                                            int attempts, void *arg), void *arg);
+
+#endif
@@ -2,22 +2,152 @@
 #define JOB_QUEUE_H
 
 #include "tslog.h"
-#include "../src/common/protocol.h"  
+#include "job_stats.h"
+#include "int_map.h"
+#include "capability.h"
+#include "runtime_history.h"
+#include "job_index.h"
+#include "../src/common/protocol.h"
 #include <pthread.h>
 
+// Política de escolha do próximo job:
+// - Cada cliente (opção client= do JOB, ou o IP da conexão) tem a própria
+//   fila, um heap pela prioridade efetiva. Com envelhecimento de A segundos
+//   a prioridade efetiva é prioridade + espera/A; como todos os jobs
+//   envelhecem no mesmo ritmo, a ordem entre eles não muda com o tempo e a
+//   chave fica fixa no heap (prioridade × A − submissão). A = 0 desliga
+//   o envelhecimento (prioridade estrita, FIFO entre iguais).
+// - Entre clientes, deficit round-robin: cada um atende até `weight` jobs
+//   por rodada. Um cliente inundando a fila não atrasa os outros.
+// - Jobs que exigem capacidades (needs=, ver capability.h) ficam numa faixa
+//   por conjunto de capacidades, cada uma com o próprio rodízio de clientes.
+//   Quem tira um job diz o que os workers livres oferecem e só olha as faixas
+//   compatíveis (revezando entre elas): o custo depende do número de
+//   conjuntos distintos, nunca do número de jobs.
+// - Modo EDF (--queue-mode edf): jobs com prazo (deadline=) saem antes dos
+//   demais, o de prazo mais cedo primeiro, num heap por faixa; entre faixas
+//   vale a de prazo mais próximo. Jobs sem prazo seguem a política acima.
+// - Em qualquer modo, um job com prazo que não cabe mais (agora + duração
+//   estimada pelo histórico do script > prazo) é descartado ao sair da fila
+//   como EXPIRADO, em vez de ocupar um worker à toa.
+// Push e pop custam O(log n) no heap do cliente e O(1) no rodízio.
+// Um mapa id -> nó acha qualquer job pendente em O(1); cada nó sabe a
+// própria posição no heap, então cancelar um pendente custa O(log n).
+//
+// Admissão: a fila tem marcas alta e baixa de profundidade e de memória dos
+// jobs pendentes. Ao passar da alta, job_queue_admit recusa novas submissões
+// (com o tempo estimado para a fila drenar até a baixa) até ela descer
+// abaixo da baixa; a histerese evita alternar a cada job. Só a submissão de
+// clientes passa pela admissão: jobs já aceitos (agendados, liberados por
+// dependência, novas tentativas) sempre entram.
+
+#define JOB_QUEUE_DEFAULT_AGING 30      // segundos por ponto de prioridade
+#define JOB_QUEUE_DEFAULT_WEIGHT 1
+#define JOB_QUEUE_MAX_WEIGHT 1000
+#define JOB_QUEUE_EXPIRE_BATCH 16       // descartes por prazo numa única retirada
+#define JOB_QUEUE_DEFAULT_HIGH 50000    // jobs pendentes (marca alta)
+#define JOB_QUEUE_DEFAULT_MEM_MB 256    // memória dos jobs pendentes (marca alta)
+#define JOB_QUEUE_LOW_PERCENT 80        // marca baixa padrão, em % da alta
+#define JOB_QUEUE_RETRY_MIN_MS 200      // faixa do retry-after sugerido
+#define JOB_QUEUE_RETRY_MAX_MS 30000
+
+typedef enum {
+    JOB_QUEUE_FAIR,                     // prioridade envelhecida + rodízio entre clientes
+    JOB_QUEUE_EDF                       // prazo mais cedo primeiro (earliest deadline first)
+} job_queue_mode_t;
+
+struct job_flow;
+struct job_lane;
+
 typedef struct job_node {
     job_t job;
-    struct job_node *next;
+    long key;                   // prioridade efetiva "congelada" (ver acima)
+    unsigned long seq;          // desempate FIFO
+    double enqueued_at;         // relógio monotônico, para o tempo de espera
+    int heap_index;             // posição no heap onde está (fluxo ou EDF)
+    struct job_flow *flow;      // NULL = heap EDF da faixa
+    struct job_lane *lane;
 } job_node_t;
 
+typedef struct job_flow {
+    char client[JOB_CLIENT_MAX];
+    struct job_lane *lane;      // conjunto de capacidades dos jobs deste fluxo
+    int map_key;
+    int weight;
+    int deficit;
+    job_node_t **heap;
+    int size;
+    int capacity;
+    struct job_flow *prev;      // anel dos clientes com jobs pendentes
+    struct job_flow *next;
+    // Métricas
+    long enqueued;
+    long dequeued;
+    double wait_total;
+    double wait_max;
+} job_flow_t;
+
+// Faixa: jobs que exigem exatamente o mesmo conjunto de capacidades
+typedef struct job_lane {
+    cap_mask_t needs;
+    job_flow_t *active;         // cursor do rodízio da faixa (NULL = vazia)
+    job_node_t **edf;           // modo EDF: heap pelo prazo
+    int edf_size;
+    int edf_capacity;
+    int size;                   // jobs nos fluxos + no heap EDF
+    struct job_lane *next;
+} job_lane_t;
+
 typedef struct {
-    job_node_t *head;
-    job_node_t *tail;
+    char client[JOB_CLIENT_MAX];
+    char needs[JOB_NEEDS_MAX];  // capacidades da faixa ("" = qualquer worker)
+    int weight;
+    int depth;                  // jobs pendentes
+    long enqueued;
+    long dequeued;
+    double avg_wait;            // segundos
+    double max_wait;
+    double head_wait;           // espera do próximo job do cliente
+} job_client_stats_t;
+
+typedef struct {
+    int_map_t flows;            // hash de (cliente, faixa) -> job_flow_t*
+    int_map_t weights;          // hash do cliente -> peso configurado
+    int_map_t nodes;            // job_id -> job_node_t* dos pendentes
+    job_lane_t *lanes;
+    job_lane_t *lane_cursor;    // última faixa atendida (rodízio entre faixas)
+    capability_registry_t *caps;  // opcional: sem ele tudo cai na faixa vazia
+    unsigned long wakeups;      // ver job_queue_wake
     int size;
     int next_job_id;
+    int id_shard;               // ids só desta shard (ver shard_ring.h); -1 = todos
+    int aging;                  // segundos por ponto de prioridade (0 = estrita)
+    job_queue_mode_t mode;
+    runtime_history_t *history; // opcional: estimativa de duração para os prazos
+    void (*on_expire)(int job_id, const char *needs, void *arg);   // opcional (ex.: job_graph)
+    void *expire_arg;
+    void (*on_enqueue)(const job_t *job, void *arg);    // opcional (ex.: replicação)
+    void *enqueue_arg;
+    void (*on_dequeue)(const job_t *job, void *arg);    // opcional (ex.: lease_table)
+    void *dequeue_arg;
+    unsigned long next_seq;
+    
+    // Admissão (ver job_queue_admit); 0 = sem limite
+    int high_watermark;         // jobs
+    int low_watermark;
+    size_t high_bytes;
+    size_t low_bytes;
+    int overloaded;             // acima da alta até descer abaixo da baixa
+    long admitted;
+    long rejected;
+    double drain_interval;      // média móvel de segundos entre retiradas
+    double last_pop;
+    
     pthread_mutex_t mutex;
     pthread_cond_t not_empty;
     tslog_t *logger;
+    job_stats_t *stats;     // opcional: contadores atualizados a cada transição
+    job_index_t *index;     // opcional: estado por id para STATUS/LIST_JOBS
 } job_queue_t;
 
 // Inicialização/destruição
@@ -30,4 +160,71 @@ int job_queue_pop(job_queue_t *queue, job_t *job);
 int job_queue_size(job_queue_t *queue);
 void job_queue_list(job_queue_t *queue);
 
-#endif
\ No newline at end of file
+int job_queue_push_priority(job_queue_t *queue, const job_t *job);
+int job_queue_pop_priority(job_queue_t *queue, job_t *job);
+// Como job_queue_pop_priority, mas desiste após timeout_ms (retorna 1 se vazia)
+int job_queue_pop_timed(job_queue_t *queue, job_t *job, int timeout_ms);
+// Só considera faixas atendidas por alguma das máscaras em `offers` (uma por
+// perfil de worker livre). Retorna 1 se nada serviu até timeout_ms ou se
+// job_queue_wake foi chamada (as ofertas mudaram: recalcular e tentar de novo).
+int job_queue_pop_for(job_queue_t *queue, job_t *job, const cap_mask_t *offers, int offer_count,
+                      int timeout_ms);
+void job_queue_wake(job_queue_t *queue);
+// Jobs que esperam antes de entrar na fila (dependências, ver job_graph.h)
+// reservam o id na submissão e entram depois com ele
+int job_queue_reserve_id(job_queue_t *queue);
+// Ids continuam de onde a execução anterior parou (chaves de idempotência
+// restauradas apontam para eles)
+void job_queue_set_next_id(job_queue_t *queue, int next_id);
+// Servidor dono da shard `shard`: ids novos só com id % SHARD_MAX == shard
+void job_queue_set_shard(job_queue_t *queue, int shard);
+int job_queue_push_reserved(job_queue_t *queue, const job_t *job, int persist);
+// Devolve um job que saiu da fila sem terminar (mantém o id)
+int job_queue_requeue(job_queue_t *queue, const job_t *job);
+// Tira um job pendente pelo id (cancelamento), copiando-o em `job` se não
+// for NULL. Retorna -1 se o job não está na fila.
+int job_queue_remove(job_queue_t *queue, int job_id, job_t *job);
+
+// Modo da fila; só pode mudar com a fila vazia (retorna -1 caso contrário)
+int job_queue_set_mode(job_queue_t *queue, job_queue_mode_t mode);
+// "fair" ou "edf"; retorna -1 se desconhecido
+int job_queue_mode_from_name(const char *name, job_queue_mode_t *mode);
+const char* job_queue_mode_name(job_queue_mode_t mode);
+void job_queue_attach_history(job_queue_t *queue, runtime_history_t *history);
+// Chamado (sem o mutex da fila) para cada job descartado por prazo, com as
+// capacidades que ele exigia
+void job_queue_set_expire_hook(job_queue_t *queue, void (*hook)(int job_id, const char *needs, void *arg),
+                               void *arg);
+// Chamado com o mutex da fila para cada job que entra (já com id): a ordem
+// das chamadas é a ordem da fila. O gancho não pode usar a fila.
+void job_queue_set_enqueue_hook(job_queue_t *queue, void (*hook)(const job_t *job, void *arg), void *arg);
+// Chamado com o mutex da fila para cada job que sai para execução: entre a
+// fila e quem o recebe, o job nunca fica onde um cancelamento não o acha.
+// O gancho não pode usar a fila.
+void job_queue_set_dequeue_hook(job_queue_t *queue, void (*hook)(const job_t *job, void *arg), void *arg);
+
+// Marcas de admissão (jobs e bytes; 0 = sem limite). Baixa 0 = 80% da alta.
+void job_queue_set_watermarks(job_queue_t *queue, int high, int low, size_t high_bytes, size_t low_bytes);
+// 0 se a submissão pode entrar; 1 se a fila está sobrecarregada, com a
+// sugestão de espera em *retry_after_ms
+int job_queue_admit(job_queue_t *queue, int *retry_after_ms);
+// Memória aproximada dos jobs pendentes
+size_t job_queue_bytes(job_queue_t *queue);
+// Prazo na submissão: 1 se já venceu ou se não cabe na duração estimada
+// pelo histórico do script (em *estimate, -1 sem histórico); 0 sem prazo
+int job_queue_admit_deadline(job_queue_t *queue, const job_t *job, double *estimate);
+
+// Política: envelhecimento (recalcula as chaves pendentes) e peso por cliente
+void job_queue_set_aging(job_queue_t *queue, int seconds);
+int job_queue_set_weight(job_queue_t *queue, const char *client, int weight);
+void job_queue_foreach_client(job_queue_t *queue,
+                              void (*callback)(const job_client_stats_t *stats, void *arg), void *arg);
+
+// Estatísticas
+void job_queue_attach_stats(job_queue_t *queue, job_stats_t *stats);
+void job_queue_attach_index(job_queue_t *queue, job_index_t *index);
+void job_queue_attach_capabilities(job_queue_t *queue, capability_registry_t *caps);
+void job_queue_stats(job_queue_t *queue, int *total, int *pending, int *running, int *completed);
+void job_queue_get_stats(job_queue_t *queue, int *total, int *pending, int *running, int *completed);
+
+#endif
@@ -0,0 +1,62 @@
+#ifndef JOB_SCHEDULER_H
+#define JOB_SCHEDULER_H
+
+#include <pthread.h>
+#include "job_queue.h"
+#include "int_map.h"
+#include "hier_wheel.h"
+#include "cron_expr.h"
+#include "database.h"
+#include "tslog.h"
+#include "../src/common/protocol.h"
+
+// Jobs adiados (at=/delay=) e recorrentes (every=/cron=). Cada agendamento
+// fica na timing wheel hierárquica até vencer e só então entra na fila de
+// prontos; agendar e disparar são O(1). Os agendamentos são gravados na
+// tabela schedules e recarregados no início: os que venceram com o servidor
+// parado disparam uma vez (sem rajada de execuções perdidas).
+// O jitter soma um atraso aleatório em [0, jitter] s a cada disparo, sem
+// mudar o horário planejado do próximo.
+
+#define SCHEDULER_TICK_MS 1000
+#define SCHEDULER_POLL_MS 250
+
+typedef struct schedule {
+    schedule_record_t rec;
+    cron_expr_t cron;
+    timer_node_t timer;
+} schedule_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int_map_t schedules;        // schedule_id -> schedule_t*
+    hier_wheel_t wheel;
+    job_queue_t *queue;
+    tslog_t *logger;
+    int next_schedule_id;
+    int id_shard;               // como job_queue_t.id_shard
+    unsigned int rand_state;
+    long fired;                 // disparos desde o início
+    int running;
+} job_scheduler_t;
+
+int job_scheduler_init(job_scheduler_t *sched, job_queue_t *queue, tslog_t *logger);
+void job_scheduler_destroy(job_scheduler_t *sched);
+// Recarrega os agendamentos persistidos (chamar depois de database_init)
+int job_scheduler_load(job_scheduler_t *sched);
+
+// Agenda o job conforme as opções de tempo. Retorna o id do agendamento
+// (e o primeiro disparo em *first_run) ou -1 se as opções forem inválidas.
+int job_scheduler_add(job_scheduler_t *sched, const job_t *job, const job_options_t *opts,
+                      time_t *first_run);
+// Ids de agendamento só da shard (ver shard_ring.h); chamar antes de load
+void job_scheduler_set_shard(job_scheduler_t *sched, int shard);
+// 0 se removido, -1 se não existe
+int job_scheduler_cancel(job_scheduler_t *sched, int schedule_id);
+int job_scheduler_count(job_scheduler_t *sched);
+// Move para a fila os agendamentos vencidos
+int job_scheduler_tick(job_scheduler_t *sched);
+
+void* job_scheduler_thread_func(void *arg);
+
+#endif
@@ -0,0 +1,109 @@
+#ifndef JOB_STATS_H
+#define JOB_STATS_H
+
+#include <stdatomic.h>
+#include <pthread.h>
+#include <time.h>
+#include "int_map.h"
+#include "../src/common/protocol.h"
+
+// Estatísticas de jobs mantidas incrementalmente a cada transição de estado.
+// Nenhuma consulta percorre a fila ou a tabela de jobs: tudo é lido de
+// contadores atômicos, em tempo constante. Os contadores por worker ficam
+// num mapa pelo id real (ids não se repetem numa execução) e saem quando o
+// worker se desconecta.
+
+#define JOB_STATS_PRIORITIES 11      // índices 1..10 (0 = fora da faixa)
+#define JOB_STATS_WINDOWS 60         // janelas de 1 minuto (última hora)
+#define JOB_STATS_HIST_BUCKETS 16    // histograma log2 do tempo de execução (ms)
+
+typedef struct {
+    atomic_long submitted;
+    atomic_long started;
+    atomic_long completed;
+    atomic_long failed;
+    atomic_long exec_time_us;        // soma dos tempos de execução
+    atomic_long hist[JOB_STATS_HIST_BUCKETS];
+} job_counters_t;
+
+typedef struct {
+    atomic_long minute;              // minuto (epoch / 60) representado pelo slot
+    job_counters_t counters;
+} job_stats_window_t;
+
+// Desfecho de jobs com prazo (deadline=), para dimensionar a frota pelo SLO
+typedef enum {
+    DEADLINE_MET,                    // concluído com sucesso antes do prazo
+    DEADLINE_MISSED,                 // concluído depois do prazo ou com falha
+    DEADLINE_EXPIRED,                // descartado na fila: não caberia mais no prazo
+    DEADLINE_REJECTED,               // recusado na submissão
+    DEADLINE_OUTCOMES
+} deadline_outcome_t;
+
+typedef struct {
+    job_counters_t total;
+    job_counters_t by_priority[JOB_STATS_PRIORITIES];
+    pthread_mutex_t workers_mutex;   // protege by_worker
+    int_map_t by_worker;             // worker_id -> job_counters_t*, workers conectados
+    job_stats_window_t windows[JOB_STATS_WINDOWS];
+    atomic_long pending;             // jobs aguardando na fila
+    atomic_long running;             // jobs em execução
+    atomic_long deadline[DEADLINE_OUTCOMES];
+} job_stats_t;
+
+// Cópia não atômica dos contadores, usada para leitura e persistência
+typedef struct {
+    long submitted;
+    long started;
+    long completed;
+    long failed;
+    long exec_time_us;
+    long hist[JOB_STATS_HIST_BUCKETS];
+} job_stats_snapshot_t;
+
+// Linha da tabela de resumo (scope: "total", "priority" ou "worker")
+typedef struct {
+    char scope[16];
+    int key;
+    job_stats_snapshot_t snap;
+} job_stats_row_t;
+
+int job_stats_init(job_stats_t *stats);
+void job_stats_destroy(job_stats_t *stats);
+
+// Transições de estado
+void job_stats_record_submit(job_stats_t *stats, int priority);
+void job_stats_record_start(job_stats_t *stats, int priority, int worker_id);
+// Desfecho de um job com prazo; DEADLINE_EXPIRED também o tira dos pendentes
+void job_stats_record_deadline(job_stats_t *stats, deadline_outcome_t outcome);
+// Worker escolhido depois de o job sair da fila (start registrado com worker 0)
+void job_stats_record_assign(job_stats_t *stats, int worker_id);
+// Job em execução que voltou para a fila (entrega falhou, worker morreu, ...)
+void job_stats_record_requeue(job_stats_t *stats);
+// Job cancelado pelo cliente, ainda na fila ou já em execução
+void job_stats_record_cancel(job_stats_t *stats, int was_running);
+void job_stats_record_finish(job_stats_t *stats, int priority, int worker_id,
+                             int success, double exec_time);
+// Worker saiu do registro: os contadores dele são descartados
+void job_stats_forget_worker(job_stats_t *stats, int worker_id);
+
+// Consultas O(1)
+void job_stats_get_total(job_stats_t *stats, job_stats_snapshot_t *snap);
+void job_stats_get_priority(job_stats_t *stats, int priority, job_stats_snapshot_t *snap);
+void job_stats_get_worker(job_stats_t *stats, int worker_id, job_stats_snapshot_t *snap);
+// Ids dos workers com contadores, em ordem crescente; retorna quantos (até max)
+int job_stats_list_workers(job_stats_t *stats, int *ids, int max);
+void job_stats_get_window(job_stats_t *stats, int minutes, job_stats_snapshot_t *snap);
+long job_stats_pending(job_stats_t *stats);
+long job_stats_running(job_stats_t *stats);
+long job_stats_deadline(job_stats_t *stats, deadline_outcome_t outcome);
+
+// Derivados de um snapshot
+double job_stats_avg_time(const job_stats_snapshot_t *snap);
+double job_stats_percentile(const job_stats_snapshot_t *snap, double p);
+
+// Persistência na tabela de resumo
+int job_stats_persist(job_stats_t *stats);
+int job_stats_load(job_stats_t *stats);
+
+#endif
@@ -0,0 +1,141 @@
+#ifndef LEASE_TABLE_H
+#define LEASE_TABLE_H
+
+#include <pthread.h>
+#include "job_queue.h"
+#include "int_map.h"
+#include "timing_wheel.h"
+#include "runtime_history.h"
+#include "tslog.h"
+#include "../src/common/protocol.h"
+
+// Jobs em execução (entregues a um worker e ainda sem resultado). Cada
+// lease tem um prazo na timing wheel: timeout do job + folga. Lease vencido
+// ou órfão (worker morreu) volta para a fila após um backoff exponencial;
+// depois de `max_attempts` tentativas o job vai para dead-letter.
+// Garante execução at-least-once sem varrer nada. Cada entrega ganha um
+// número de lease que vai no JOB e volta no resultado: o resultado atrasado
+// de uma tentativa anterior não fecha a nova, mesmo no mesmo worker.
+//
+// Execução especulativa (hedging, opcional): se o job ainda roda quando
+// passa do percentil configurado das durações recentes do script, um
+// segundo timer pede uma cópia em outro worker. Vale o primeiro resultado
+// com sucesso; a outra cópia é cancelada. Uma falha de uma das cópias só a
+// descarta enquanto a outra continua. O orçamento limita as cópias
+// simultâneas a uma fração dos leases ativos; jobs com hedge=0 nunca são
+// duplicados.
+//
+// O lease nasce quando o job sai da fila (gancho da fila, ainda com o mutex
+// dela), antes de haver worker: um cancelamento entre a retirada e a entrega
+// encontra o job aqui, e a entrega desiste em lease_table_acquire.
+// Ordem dos locks: worker manager, fila, tabela.
+
+#define LEASE_GRACE_SECONDS 10
+#define LEASE_MAX_ATTEMPTS 3
+#define LEASE_BACKOFF_BASE_MS 1000
+#define LEASE_BACKOFF_MAX_MS 60000
+#define LEASE_WHEEL_SLOTS 1024
+#define LEASE_WHEEL_TICK_MS 250
+#define LEASE_HEDGE_MIN_MS 500          // não duplica antes disso, qualquer que seja o percentil
+#define LEASE_HEDGE_RETRY_MS 1000       // sem worker livre para a cópia: tenta de novo
+#define LEASE_HEDGE_DEFAULT_BUDGET 10   // % dos leases ativos que podem ter cópia
+
+typedef enum {
+    LEASE_ACTIVE,               // com um worker
+    LEASE_BACKOFF,              // esperando para voltar à fila
+    LEASE_DISPATCHING,          // fora da fila, ainda sem worker
+    LEASE_CANCELLED             // cancelado antes da entrega
+} lease_state_t;
+
+typedef struct lease {
+    job_t job;
+    int worker_id;
+    lease_state_t state;
+    timer_node_t timer;
+    timer_node_t hedge_timer;   // quando pedir a cópia especulativa
+    int hedge_worker_id;        // cópia em execução (0 = nenhuma)
+    int hedged;                 // a cópia já foi pedida nesta tentativa
+    int hedge_promoted;         // a cópia assumiu depois que a original caiu
+} lease_t;
+
+typedef struct {
+    pthread_mutex_t mutex;
+    int_map_t leases;           // job_id -> lease_t*
+    timing_wheel_t timers;
+    job_queue_t *queue;
+    tslog_t *logger;
+    int max_attempts;
+    int next_lease_id;
+    long requeued;              // contadores para o monitor
+    long dead_lettered;
+    void (*on_dead_letter)(const job_t *job, void *arg);   // opcional (ex.: job_graph)
+    void *dead_letter_arg;
+    
+    runtime_history_t *history; // durações por script, para o percentil
+    int hedge_percentile;       // 0 = sem execução especulativa
+    int hedge_budget;           // % dos leases ativos
+    int hedges_active;
+    long hedged;                // cópias lançadas
+    long hedge_won;             // a cópia entregou primeiro
+    long hedge_lost;            // a original entregou primeiro
+    long hedge_skipped;         // barradas pelo orçamento
+    // Pede a cópia (ex.: worker manager); chamado sem locks da tabela.
+    // Retorna -1 se não havia worker livre.
+    int (*on_hedge)(const job_t *job, int worker_id, void *arg);
+    void *hedge_arg;
+} lease_table_t;
+
+int lease_table_init(lease_table_t *table, job_queue_t *queue, tslog_t *logger);
+void lease_table_destroy(lease_table_t *table);
+void lease_table_set_max_attempts(lease_table_t *table, int attempts);
+// Chamado (sem locks da tabela) para cada job que vai para dead-letter
+void lease_table_set_dead_letter_hook(lease_table_t *table,
+                                      void (*hook)(const job_t *job, void *arg), void *arg);
+
+// Percentil (1-99; 0 desliga) e orçamento em % dos leases ativos
+void lease_table_set_hedging(lease_table_t *table, runtime_history_t *history,
+                             int percentile, int budget);
+void lease_table_set_hedge_hook(lease_table_t *table,
+                                int (*hook)(const job_t *job, int worker_id, void *arg), void *arg);
+// A cópia pedida foi entregue a `worker_id`. Retorna -1 se não cabe mais
+// (o job terminou, o lease venceu ou o orçamento acabou).
+int lease_table_attach_hedge(lease_table_t *table, int job_id, int worker_id);
+
+// Job a caminho do worker: ativa o lease com prazo timeout + folga e grava
+// o número dele em job->lease_id. Retorna 1 se o job foi cancelado depois de
+// sair da fila (não entregar).
+int lease_table_acquire(lease_table_t *table, job_t *job, int worker_id);
+// Resultado recebido: fecha o lease e copia o job. Retorna -1 se o job não
+// está com esse worker nesse lease (resultado atrasado de um lease já
+// vencido). Em `other` volta o worker da outra cópia, que deve ser cancelada
+// (0 = nenhuma).
+int lease_table_complete(lease_table_t *table, int job_id, int lease_id, int worker_id, job_t *job,
+                         int *other);
+// Uma das duas cópias falhou: ela sai e a outra segue com o lease. Retorna
+// -1 se o job não tem outra cópia em execução (o resultado vale).
+int lease_table_drop_copy(lease_table_t *table, int job_id, int lease_id, int worker_id);
+// A entrega falhou antes de o worker receber o job: volta à fila sem contar
+// tentativa (ou some, se foi cancelado nesse meio tempo)
+int lease_table_cancel(lease_table_t *table, int job_id);
+// O worker recusou o job (JOB_REJECT, sem slot livre): volta à fila sem
+// contar tentativa; com outra cópia em execução, só esta sai. Retorna -1 se
+// o job não está com esse worker nesse lease.
+int lease_table_reject(lease_table_t *table, int job_id, int lease_id, int worker_id);
+// Job cancelado pelo cliente: fecha o lease (ativo ou em backoff) e devolve
+// em `workers` quem executa as cópias (0 = ninguém), para serem avisados.
+// Job ainda a caminho do worker fica marcado para a entrega desistir.
+// Retorna -1 se o job não tem lease.
+int lease_table_abort(lease_table_t *table, int job_id, job_t *job, int workers[2]);
+// O worker morreu ou desconectou com o job: nova tentativa com backoff
+void lease_table_orphan(lease_table_t *table, int job_id, int worker_id);
+
+// Processa os prazos vencidos. Para cada lease ativo vencido chama
+// on_expire(worker_id, job_id, arg) sem nenhum lock da tabela.
+void lease_table_check(lease_table_t *table,
+                       void (*on_expire)(int worker_id, int job_id, void *arg), void *arg);
+int lease_table_count(lease_table_t *table);
+void lease_table_get_counters(lease_table_t *table, long *requeued, long *dead_lettered);
+void lease_table_get_hedge_counters(lease_table_t *table, long *hedged, long *won, long *lost,
+                                    long *skipped);
+
+#endif
@@ -3,11 +3,21 @@
 
 #include "job_queue.h"
 #include "worker_manager.h"
+#include "job_scheduler.h"
+#include "job_graph.h"
+#include "replication.h"
+#include "notifier.h"
+#include "acceptor.h"
 #include "../include/tslog.h"
 
 typedef struct monitor_cli_t {
     job_queue_t *queue;
     worker_manager_t *wm;  // ADICIONADO
+    job_scheduler_t *scheduler;  // opcional: agendamentos pendentes nas estatísticas
+    job_graph_t *graph;          // opcional: jobs aguardando dependências
+    replication_t *replication;  // opcional: papel e atraso da replicação
+    notifier_t *notifier;        // opcional: assinaturas de notificações
+    acceptor_set_t *acceptors;   // opcional: conexões e accepts por CPU
     tslog_t *logger;
     int running;
     pthread_mutex_t display_mutex;
@@ -16,6 +26,11 @@ typedef struct monitor_cli_t {
 // CORRIGIDO: adicionar worker_manager_t *wm
 int monitor_cli_init(monitor_cli_t *mon, job_queue_t *queue, worker_manager_t *wm, tslog_t *logger);
 void monitor_cli_destroy(monitor_cli_t *mon);
+void monitor_cli_attach_scheduler(monitor_cli_t *mon, job_scheduler_t *scheduler);
+void monitor_cli_attach_graph(monitor_cli_t *mon, job_graph_t *graph);
+void monitor_cli_attach_replication(monitor_cli_t *mon, replication_t *replication);
+void monitor_cli_attach_notifier(monitor_cli_t *mon, notifier_t *notifier);
+void monitor_cli_attach_acceptors(monitor_cli_t *mon, acceptor_set_t *acceptors);
 void monitor_cli_refresh(monitor_cli_t *mon);
 void* monitor_thread_func(void *arg);
 
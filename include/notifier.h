@@ -0,0 +1,112 @@
+#ifndef NOTIFIER_H
+#define NOTIFIER_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "int_map.h"
+#include "tslog.h"
+#include "../src/common/protocol.h"
+
+// Notificações de término por push. Uma conexão de cliente assina tópicos
+// ("SUBSCRIBE:job=<id>", "SUBSCRIBE:batch=<nome>", "SUBSCRIBE:tag=<tag>",
+// esta última casando com as capacidades exigidas pelo job) e, quando um
+// job chega a um estado final (resultado do worker, cancelamento,
+// dead-letter, prazo, dependência que falhou), recebe na mesma conexão
+//   NOTIFY:<tópico>:<id>:<STATUS>:<tempo>:<saída escapada>
+// Cada tópico guarda a lista dos assinantes: a linha é montada uma vez por
+// tópico e compartilhada (contagem de referências) por todos eles, então um
+// batch com mil assinantes custa uma formatação e mil ponteiros.
+// Cada assinante tem um buffer de NOTIFY_BUFFER linhas esvaziado pela sua
+// própria thread de envio: quem publica nunca espera por um socket. Quem não
+// lê rápido perde as mais antigas e recebe "NOTIFY_LOST:<n>" antes da
+// próxima (o resto se descobre com STATUS). Tópicos job= valem para um único
+// término e somem depois dele.
+
+#define NOTIFY_TOPIC_MAX 48             // "job=<id>", "batch=<nome>", "tag=<tag>"
+#define NOTIFY_BUFFER 256               // linhas pendentes por conexão
+#define NOTIFY_TOPICS_PER_CONN 4096     // assinaturas por conexão
+#define NOTIFY_SEND_BATCH 32            // linhas por writev
+
+typedef struct notify_message {
+    atomic_int refs;                    // assinantes que ainda não enviaram
+    size_t len;
+    char line[];                        // com o '\n'
+} notify_message_t;
+
+typedef struct notify_topic notify_topic_t;
+typedef struct notifier notifier_t;
+
+typedef struct {
+    int socket;
+    pthread_mutex_t send_mutex;         // linhas inteiras: respostas da conexão e notificações
+    pthread_cond_t ready;               // com o mutex do notifier
+    notify_message_t *buffer[NOTIFY_BUFFER];
+    int head;
+    int count;
+    long lost;                          // descartadas desde a última NOTIFY_LOST
+    int broken;                         // envio falhou: só descarta até o detach
+    int stopping;
+    notify_topic_t **topics;            // assinados por esta conexão
+    int topic_count;
+    int topic_capacity;
+    pthread_t thread;
+    notifier_t *notifier;
+} notify_subscriber_t;
+
+struct notify_topic {
+    char name[NOTIFY_TOPIC_MAX];
+    int map_key;
+    notify_subscriber_t **subscribers;
+    int count;
+    int capacity;
+};
+
+struct notifier {
+    pthread_mutex_t mutex;              // folha: nunca chama outro módulo com ela
+    int_map_t topics;                   // int_map_string_key do nome (sondagem) -> tópico
+    tslog_t *logger;
+    int subscribers;
+    long published;                     // linhas montadas (tópicos com assinantes)
+    long delivered;                     // colocadas em buffers
+    long dropped;                       // descartadas por buffer cheio
+};
+
+// Estado final de um job
+typedef struct {
+    int job_id;
+    job_status_t status;
+    double exec_time;
+    const char *output;                 // NULL/"" = sem saída
+    const char *batch;                  // NULL/"" = sem batch
+    const char *tags;                   // capacidades exigidas, "tag,tag"
+} notify_event_t;
+
+int notifier_init(notifier_t *notifier, tslog_t *logger);
+void notifier_destroy(notifier_t *notifier);
+
+// Conexão que passa a receber notificações (inicia a thread de envio);
+// NULL se faltar memória
+notify_subscriber_t *notifier_attach(notifier_t *notifier, int socket);
+// Conexão fechando: sai de todos os tópicos, para a thread e libera (o
+// socket continua de quem chamou)
+void notifier_detach(notifier_t *notifier, notify_subscriber_t *sub);
+// Resposta na conexão de um assinante, sem intercalar com notificações
+int notifier_reply(notify_subscriber_t *sub, const char *line);
+
+// "job=12", "batch=etl", "tag=gpu" -> nome canônico do tópico; -1 se inválido
+int notifier_parse_topic(const char *spec, char *topic, size_t size);
+// 0 = assinado (ou já era), -1 = limite por conexão ou memória
+int notifier_subscribe(notifier_t *notifier, notify_subscriber_t *sub, const char *topic);
+// -1 se a conexão não assinava o tópico (ou job= já foi notificado)
+int notifier_unsubscribe(notifier_t *notifier, notify_subscriber_t *sub, const char *topic);
+
+// Job terminou: uma linha por tópico com assinantes (job=, batch=, cada tag)
+void notifier_publish(notifier_t *notifier, const notify_event_t *event);
+// Só para este assinante, pelo buffer (ex.: job que já tinha terminado)
+void notifier_deliver(notifier_t *notifier, notify_subscriber_t *sub, const char *topic,
+                      const notify_event_t *event);
+
+void notifier_get_counters(notifier_t *notifier, int *subscribers, int *topics,
+                           long *published, long *dropped);
+
+#endif
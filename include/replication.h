@@ -0,0 +1,127 @@
+#ifndef REPLICATION_H
+#define REPLICATION_H
+
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include "int_map.h"
+#include "job_queue.h"
+#include "job_index.h"
+#include "idempotency.h"
+#include "tslog.h"
+#include "../src/common/protocol.h"
+
+// Replicação primário/standby por envio de log. O primário (--replication)
+// registra cada transição de job num anel de REPLICATION_LOG_SIZE registros
+// numerados: E (job entrou na fila, com o script), S (status, worker e
+// tentativas) e K (chave de idempotência respondida). Um standby conecta com
+// REPLICATE:<próximo seq>, recebe "R:<seq>:<ms>:<registro>" em lotes e
+// devolve ACK:<seq aplicado>; sem novidades o primário manda um H a cada
+// REPLICATION_HEARTBEAT_MS. Quem chega sem histórico (ou atrasado além do
+// anel) recebe RESYNC e o conjunto de jobs vivos, mantido junto com o log
+// sob a mesma trava, então a foto e o fluxo nunca se desencontram.
+// O registro sai no caminho da submissão só como formatar uma linha e
+// guardar o ponteiro: o envio é da thread da conexão do standby.
+//
+// O standby aplica os registros ao índice (STATUS/LIST_JOBS funcionam nele),
+// ao próprio banco e às chaves de idempotência, e guarda os jobs vivos fora
+// da fila. Sem contato com o primário por failover_timeout segundos ele
+// assume: os jobs pendentes e os que estavam em execução entram na sua fila
+// (at-least-once, como um lease perdido) e ele passa a aceitar submissões e
+// workers. Antes disso responde ERROR:NOT_PRIMARY a tudo que não é leitura.
+// Não replicados: agendamentos e jobs esperando dependências (ficam no
+// banco do primário).
+
+#define REPLICATION_LOG_SIZE 65536          // registros guardados para reconexão
+#define REPLICATION_BATCH 256               // registros por envio
+#define REPLICATION_HEARTBEAT_MS 500
+#define REPLICATION_ACK_MS 200
+#define REPLICATION_DEFAULT_FAILOVER 3      // segundos sem o primário até assumir
+#define REPLICATION_MAX_PEERS 4             // standbys conectados ao mesmo tempo
+#define REPLICATION_NOT_PRIMARY "ERROR:NOT_PRIMARY"
+
+typedef enum {
+    REPLICATION_OFF,            // servidor sozinho, sem log
+    REPLICATION_PRIMARY,
+    REPLICATION_STANDBY
+} replication_role_t;
+
+typedef struct {
+    long seq;
+    long ts_ms;                 // relógio do primário ao registrar
+    char *body;                 // "E:...", "S:..." ou "K:..."
+} replication_slot_t;
+
+// Job vivo no primário: linha E original e o estado atual
+typedef struct {
+    char *body;
+    job_status_t status;
+    int worker_id;
+    int attempts;
+} replication_live_t;
+
+// Job vivo no standby, fora da fila até a promoção
+typedef struct {
+    job_t job;
+    int running;
+} replication_replica_t;
+
+typedef struct {
+    int active;
+    char peer[64];
+    long acked;                 // último seq aplicado pelo standby
+} replication_peer_t;
+
+typedef struct replication {
+    atomic_int role;
+    pthread_mutex_t mutex;
+    pthread_cond_t appended;
+    tslog_t *logger;
+    job_queue_t *queue;
+    job_index_t *index;
+    idempotency_t *idem;
+
+    // Primário
+    int logging;                // registra transições (primário ou standby promovido)
+    replication_slot_t *ring;
+    long head;                  // último seq registrado (0 = nenhum)
+    int_map_t live;             // job_id -> replication_live_t*
+    replication_peer_t peers[REPLICATION_MAX_PEERS];
+
+    // Standby
+    char primary_host[64];
+    int primary_port;
+    int failover_timeout;
+    int_map_t replicas;         // job_id -> replication_replica_t*
+    int max_job_id;
+    long applied;               // último seq aplicado
+    long primary_head;          // último seq conhecido do primário
+    long applied_ts_ms;         // relógio do primário no último aplicado
+    time_t last_contact;        // 0 = nunca falou com o primário
+    long applied_total;
+    long resyncs;
+} replication_t;
+
+int replication_init(replication_t *repl, job_queue_t *queue, job_index_t *index,
+                     idempotency_t *idem, tslog_t *logger);
+void replication_destroy(replication_t *repl);
+// Primário: passa a registrar as transições para standbys
+void replication_enable(replication_t *repl);
+// Standby do primário em host:port; assume após failover_timeout segundos sem ele
+int replication_set_standby(replication_t *repl, const char *primary, int failover_timeout);
+int replication_is_standby(replication_t *repl);
+
+// Ganchos das transições (não fazem nada se o log está desligado)
+void replication_log_enqueue(replication_t *repl, const job_t *job);
+void replication_log_status(replication_t *repl, int job_id, job_status_t status, int worker_id, int attempts);
+void replication_log_key(replication_t *repl, const char *key, idempotency_kind_t kind, int id, time_t first_run);
+
+// Primário: atende um standby que mandou REPLICATE:<from> até a conexão cair
+void replication_serve(replication_t *repl, int sock, line_reader_t *reader, long from, const char *peer);
+// Standby: segue o primário e promove este servidor quando ele some
+void* replication_follow_thread(void *arg);
+
+// "REPL:<papel>:<seq>:<atraso em registros>:<atraso em ms>:<standbys>"
+void replication_format_status(replication_t *repl, char *buffer, size_t size);
+
+#endif
@@ -0,0 +1,41 @@
+#ifndef RUNTIME_HISTORY_H
+#define RUNTIME_HISTORY_H
+
+#include <pthread.h>
+#include "int_map.h"
+
+// Histórico de duração por hash do script: média móvel exponencial e desvio
+// médio (como o estimador de RTT do TCP). A estimativa conservadora
+// média + 2 desvios decide se um job com prazo ainda cabe (ver job_queue.h).
+// As últimas RUNTIME_HISTORY_SAMPLES durações ficam num anel, de onde saem
+// os percentis que disparam a execução especulativa (ver lease_table.h).
+// Scripts diferentes com o mesmo hash dividem a entrada.
+
+#define RUNTIME_HISTORY_MAX 4096        // scripts acompanhados; os demais ficam sem estimativa
+#define RUNTIME_HISTORY_ALPHA 0.2       // peso da última amostra na média
+#define RUNTIME_HISTORY_MIN_SAMPLES 3   // antes disso não há estimativa
+#define RUNTIME_HISTORY_SAMPLES 32      // amostras recentes para os percentis
+
+typedef struct {
+    double mean;                // segundos
+    double deviation;           // desvio médio absoluto
+    long samples;
+    float recent[RUNTIME_HISTORY_SAMPLES];  // anel; posição samples % tamanho
+} runtime_entry_t;
+
+typedef struct {
+    int_map_t entries;          // hash do script -> runtime_entry_t*
+    pthread_mutex_t mutex;
+} runtime_history_t;
+
+int runtime_history_init(runtime_history_t *history);
+void runtime_history_destroy(runtime_history_t *history);
+
+void runtime_history_record(runtime_history_t *history, const char *script, double seconds);
+// Duração estimada (média + 2 desvios) ou -1 sem histórico suficiente
+double runtime_history_estimate(runtime_history_t *history, const char *script);
+// Percentil (1-100) das durações recentes ou -1 sem histórico suficiente
+double runtime_history_percentile(runtime_history_t *history, const char *script, int percentile);
+int runtime_history_count(runtime_history_t *history);
+
+#endif
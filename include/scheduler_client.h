@@ -0,0 +1,182 @@
+#ifndef SCHEDULER_CLIENT_H
+#define SCHEDULER_CLIENT_H
+
+#include <pthread.h>
+#include <stdatomic.h>
+#include "tslog.h"
+#include "../src/common/protocol.h"
+#include "../src/common/shard_ring.h"
+
+// libscheduler-client: acesso ao servidor (ou às shards) para quem submete e
+// consulta jobs. Uma thread da biblioteca mantém até pool_size conexões
+// persistentes por shard e, em cada uma, até pipeline_depth pedidos em voo:
+// as respostas do servidor vêm na ordem dos pedidos da conexão, então cada
+// linha recebida completa o pedido mais antigo dela. Conexão perdida ou
+// resposta atrasada além de response_timeout_ms: a conexão é refeita e os
+// pedidos em voo são reenviados (submissões sempre levam chave de
+// idempotência, então reenviar nunca duplica um job). RETRY_AFTER espera o
+// que o servidor sugeriu, com backoff exponencial e jitter; ERROR:NOT_PRIMARY
+// troca para o standby da shard (ver shard_ring.h) e tenta de novo.
+//
+// Três formas de uso para submit, status e espera pelo resultado:
+//  - callback: a função roda na thread da biblioteca quando a resposta chega
+//    (não pode bloquear nem chamar a API bloqueante);
+//  - future: sched_future_wait/sched_future_reply em qualquer thread;
+//  - bloqueante: as duas anteriores juntas, para a CLI.
+// Uma única thread pode manter milhares de submissões em voo pela API
+// assíncrona; o limite é max_outstanding (depois disso retorna -1).
+//
+// Assinaturas (job=, batch=, tag=; ver notifier.h no servidor): o término
+// chega por push na conexão do pool onde a assinatura foi feita. Se ela cai,
+// a biblioteca assina de novo ao reconectar e avisa com `lost` (o que
+// terminou no meio tempo só se descobre com STATUS).
+
+#define SCHED_POOL_SIZE 4                   // conexões por shard
+#define SCHED_PIPELINE_DEPTH 128            // pedidos em voo por conexão
+#define SCHED_MAX_OUTSTANDING 65536         // pedidos aceitos e não respondidos
+#define SCHED_RESPONSE_TIMEOUT_MS 10000     // sem resposta: reconecta e reenvia
+#define SCHED_SUBMIT_RETRIES 8              // RETRY_AFTER/perdas seguidas antes de desistir
+#define SCHED_BACKOFF_MAX_MS 60000
+#define SCHED_LOST_RETRY_MS 500             // primeira espera depois de perder a resposta
+#define SCHED_CONNECT_RETRIES 3             // falhas de conexão seguidas até falhar os pedidos
+#define SCHED_RECONNECT_MS 200              // primeira espera para reconectar (dobra a cada falha)
+#define SCHED_WAIT_POLL_MS 50               // espera pelo resultado: primeira consulta
+#define SCHED_WAIT_POLL_MAX_MS 1000
+#define SCHED_TOPIC_MAX 48
+#define SCHED_RESUBSCRIBE_MS 5000           // servidor fora: nova tentativa de assinar
+
+typedef enum {
+    SCHED_OK,                   // resposta do servidor em reply->line
+    SCHED_REJECTED,             // o servidor respondeu ERROR:...
+    SCHED_UNAVAILABLE,          // sem servidor, ou desistiu depois das tentativas
+    SCHED_TIMEOUT               // sched_client_wait*: o job não terminou no prazo
+} sched_result_t;
+
+typedef struct {
+    sched_result_t result;
+    int id;                     // job/agendamento criado ou consultado (0 = nenhum)
+    int scheduled;              // submit: JOB_SCHEDULED (id é do agendamento)
+    job_status_t status;        // status/wait: estado do job
+    char line[PROTOCOL_LINE_MAX];   // resposta crua do servidor ("" se não houve)
+} sched_reply_t;
+
+typedef void (*sched_callback_t)(const sched_reply_t *reply, void *arg);
+
+typedef struct {
+    char topic[SCHED_TOPIC_MAX];    // assinatura que casou ("job=12", "batch=etl", "tag=gpu")
+    int id;
+    job_status_t status;
+    double exec_time;
+    char output[MAX_RESULT_SIZE];
+    long lost;                      // > 0: notificações perdidas (só topic preenchido)
+} sched_notification_t;
+
+typedef void (*sched_notify_t)(const sched_notification_t *notification, void *arg);
+
+typedef struct {
+    int pool_size;
+    int pipeline_depth;
+    int max_outstanding;
+    int response_timeout_ms;
+    int submit_retries;
+} sched_client_config_t;
+
+typedef struct sched_request sched_request_t;
+typedef struct sched_conn sched_conn_t;
+typedef struct sched_timer_heap sched_timer_heap_t;
+typedef struct sched_subscription sched_subscription_t;
+
+typedef struct {
+    shard_ring_t ring;
+    sched_client_config_t config;
+    tslog_t *logger;            // opcional
+
+    pthread_t thread;
+    int wake_fd;                // eventfd: pedidos novos ou parada
+    int epoll_fd;
+    atomic_int stop;
+
+    pthread_mutex_t mutex;      // protege incoming
+    sched_request_t *incoming;  // pedidos das threads do usuário, ainda não vistos
+    sched_request_t *incoming_tail;
+    atomic_int outstanding;
+
+    // Só a thread da biblioteca mexe daqui para baixo
+    sched_conn_t *conns;        // pool_size por shard
+    sched_request_t **backlog;  // por shard: fila dos que esperam conexão/espaço
+    sched_request_t **backlog_tail;
+    int *connect_failures;      // por shard: tentativas seguidas sem conectar
+    long *retry_at;             // por shard: próxima tentativa de conexão (ms)
+    sched_timer_heap_t *timers; // reenvios e consultas agendadas
+    sched_subscription_t *subscriptions;
+    unsigned int seed;
+} sched_client_t;
+
+typedef struct sched_future sched_future_t;
+
+void sched_client_config_init(sched_client_config_t *config);
+// Copia o anel de shards; config NULL = padrões. Inicia a thread da biblioteca.
+int sched_client_init(sched_client_t *client, const shard_ring_t *ring,
+                      const sched_client_config_t *config, tslog_t *logger);
+// Espera nada: pedidos ainda em voo completam com SCHED_UNAVAILABLE
+void sched_client_destroy(sched_client_t *client);
+
+// Shard que recebe a submissão (dependências, batch, cliente ou chave; ver
+// shard_ring.h) ou -1 se as dependências estão em shards diferentes ou fora
+// do anel. opts->key precisa estar preenchida.
+int sched_client_route(const sched_client_t *client, const job_options_t *opts);
+// Shard dona do job/agendamento, ou -1 se ela não está no anel
+int sched_client_owner(const sched_client_t *client, int id);
+// Chave única por submissão ("host-pid-ns")
+void sched_client_make_key(char *key, size_t size);
+
+// Assíncrono (callback na thread da biblioteca). Retorna -1 se o pedido não
+// foi aceito (opções inválidas, rota impossível ou max_outstanding atingido);
+// nesse caso o callback não é chamado.
+int sched_client_submit_async(sched_client_t *client, const char *script, const job_options_t *opts,
+                              sched_callback_t callback, void *arg);
+int sched_client_status_async(sched_client_t *client, int job_id, sched_callback_t callback, void *arg);
+// Completa quando o job termina (status final) ou, com timeout_ms > 0, com
+// SCHED_TIMEOUT depois desse tempo
+int sched_client_wait_async(sched_client_t *client, int job_id, int timeout_ms,
+                            sched_callback_t callback, void *arg);
+// Uma linha qualquer do protocolo (CANCEL:, LIST_JOBS, ...) para a shard
+int sched_client_command_async(sched_client_t *client, int shard, const char *line,
+                               sched_callback_t callback, void *arg);
+
+// Futures: NULL se o pedido não foi aceito; liberar com sched_future_free
+sched_future_t *sched_client_submit_future(sched_client_t *client, const char *script,
+                                           const job_options_t *opts);
+sched_future_t *sched_client_status_future(sched_client_t *client, int job_id);
+sched_future_t *sched_client_wait_future(sched_client_t *client, int job_id, int timeout_ms);
+sched_future_t *sched_client_command_future(sched_client_t *client, int shard, const char *line);
+// 0 quando completou; 1 se timeout_ms (> 0) passou antes
+int sched_future_wait(sched_future_t *future, int timeout_ms);
+const sched_reply_t *sched_future_reply(sched_future_t *future);
+void sched_future_free(sched_future_t *future);
+
+// Assina o tópico em cada shard que pode publicá-lo (job=: a dona; batch=:
+// a do batch; tag=: todas) e espera a confirmação. O callback roda na thread
+// da biblioteca. Retorna -1 se o tópico é inválido, o job não existe ou não
+// há servidor. Não chamar de dentro de um callback. Assinaturas job= acabam
+// sozinhas depois da notificação.
+int sched_client_subscribe(sched_client_t *client, const char *topic, sched_notify_t notify, void *arg);
+// Sem espera: notificações já a caminho podem chegar até o servidor confirmar
+int sched_client_unsubscribe(sched_client_t *client, const char *topic);
+
+// Bloqueantes: 0 com a resposta em *reply, -1 se o pedido não foi aceito
+int sched_client_submit(sched_client_t *client, const char *script, const job_options_t *opts,
+                        sched_reply_t *reply);
+int sched_client_status(sched_client_t *client, int job_id, sched_reply_t *reply);
+int sched_client_wait(sched_client_t *client, int job_id, int timeout_ms, sched_reply_t *reply);
+int sched_client_command(sched_client_t *client, int shard, const char *line, sched_reply_t *reply);
+
+// Conexão avulsa (worker, consultas a um servidor fora do anel): conecta à
+// shard ou ao seu standby, registrando no logger (pode ser NULL)
+int sched_connect(const shard_t *shard, tslog_t *logger);
+// Um pedido e sua resposta numa conexão própria ("" se não veio em
+// timeout_ms; 0 = esperar sempre). Retorna -1 se não conectou.
+int sched_call(const shard_t *shard, const char *line, char *response, size_t size, int timeout_ms,
+               tslog_t *logger);
+
+#endif
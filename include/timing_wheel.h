@@ -0,0 +1,39 @@
+#ifndef TIMING_WHEEL_H
+#define TIMING_WHEEL_H
+
+#include <stddef.h>
+
+// Timing wheel com hash: cada timer cai no slot (tick de expiração % slots).
+// Agendar, reagendar e cancelar são O(1); cada tick visita um único slot,
+// então o custo não depende de quantos timers existem. Timers mais distantes
+// que uma volta ficam no slot e são ignorados até o tick certo.
+// Não é thread-safe: quem usa protege com o próprio mutex.
+
+typedef struct timer_node {
+    struct timer_node *prev;
+    struct timer_node *next;    // NULL = não agendado
+    long expires;               // tick absoluto
+    void *data;
+} timer_node_t;
+
+typedef struct {
+    timer_node_t *slots;        // sentinelas das listas circulares
+    size_t mask;
+    int tick_ms;
+    long current;               // último tick processado
+    long origin_ms;             // relógio monotônico no tick 0
+} timing_wheel_t;
+
+int timing_wheel_init(timing_wheel_t *wheel, size_t slots, int tick_ms);
+void timing_wheel_destroy(timing_wheel_t *wheel);
+
+// (Re)agenda o timer para daqui a delay_ms (arredondado para cima em ticks)
+void timing_wheel_schedule(timing_wheel_t *wheel, timer_node_t *node, long delay_ms);
+void timing_wheel_cancel(timer_node_t *node);
+int timing_wheel_pending(const timer_node_t *node);
+
+// Processa os ticks até agora e chama `expire` para cada timer vencido (já
+// fora da roda: o callback pode reagendá-lo ou liberar o nó). Retorna quantos venceram.
+int timing_wheel_advance(timing_wheel_t *wheel, void (*expire)(timer_node_t *node, void *arg), void *arg);
+
+#endif
@@ -4,6 +4,7 @@
 #include <stdio.h>
 #include <time.h>
 #include <pthread.h>
+#include <stdatomic.h>
 
 typedef enum {
     TSLOG_ERROR,
@@ -12,19 +13,74 @@ typedef enum {
     TSLOG_DEBUG
 } tslog_level_t;
 
+// Política quando o buffer da thread está cheio (modo assíncrono)
+typedef enum {
+    TSLOG_OVERFLOW_BLOCK,   // espera o writer abrir espaço
+    TSLOG_OVERFLOW_DROP,    // descarta a mensagem e incrementa o contador
+    TSLOG_OVERFLOW_SYNC     // escreve direto no arquivo (preservando a ordem da thread)
+} tslog_overflow_t;
+
+typedef struct tslog_ring tslog_ring_t;
+typedef struct tslog_rotation tslog_rotation_t;
+
 typedef struct {
-    FILE *log_file;
+    int fd;
+    char *filename;
     tslog_level_t level;
     pthread_mutex_t mutex;
     char *timestamp_format;
+
+    // Modo assíncrono: buffers por thread drenados por uma thread escritora
+    int async;
+    tslog_overflow_t overflow;
+    size_t ring_size;
+    _Atomic(tslog_ring_t*) rings;
+    pthread_t writer;
+    atomic_int writer_stop;
+    atomic_int writer_sleeping;
+    pthread_mutex_t wake_mutex;
+    pthread_cond_t wake_cond;
+    atomic_long dropped;
+    unsigned long async_id;     // distingue instâncias no cache por thread
+    char *batch;                // buffer de agregação para write() grandes
+
+    // Modo binário: id da format string + argumentos crus (ver tslog-decode)
+    int binary;
+    void *formats;
+
+    // Rotação e reabertura do arquivo (ver tslog_enable_rotation)
+    tslog_rotation_t *rotation;
+    atomic_int reopen_requested;
 } tslog_t;
 
 // Inicialização e destruição
 int tslog_init(tslog_t *logger, const char *filename, tslog_level_t level);
 void tslog_destroy(tslog_t *logger);
 
+// Modo assíncrono: ring_size em bytes por thread (0 = padrão de 64 KiB)
+int tslog_enable_async(tslog_t *logger, size_t ring_size, tslog_overflow_t overflow);
+// Garante que tudo que foi registrado até aqui chegou ao arquivo
+void tslog_flush(tslog_t *logger);
+// Descarrega os buffers em falhas (SIGSEGV, SIGABRT, ...) e em SIGTERM/SIGINT antes de morrer
+void tslog_install_crash_handler(tslog_t *logger);
+long tslog_dropped(tslog_t *logger);
+// Grava registros binários (id do formato + argumentos) em vez de texto.
+// Chamar logo após tslog_init, de preferência com um arquivo dedicado.
+int tslog_enable_binary(tslog_t *logger);
+
+// Rotação do arquivo: ao passar de max_bytes (0 = sem limite) ou a cada
+// interval segundos (0 = desligado) o arquivo atual vira <nome>.<data-hora>.
+// Os segmentos são comprimidos (gzip) por uma thread em background quando
+// compress != 0 e apenas os `keep` mais recentes são mantidos.
+int tslog_enable_rotation(tslog_t *logger, size_t max_bytes, int interval, int keep, int compress);
+// Pede a reabertura do arquivo na próxima escrita (pode ser chamada de um handler de sinal)
+void tslog_reopen(tslog_t *logger);
+// SIGHUP passa a chamar tslog_reopen (para uso com logrotate externo)
+void tslog_install_sighup(tslog_t *logger);
+
 // Funções de logging
-void tslog_log(tslog_t *logger, tslog_level_t level, const char *format, ...);
+void tslog_log(tslog_t *logger, tslog_level_t level, const char *format, ...)
+    __attribute__((format(printf, 3, 4)));
 void tslog_error(tslog_t *logger, const char *format, ...);
 void tslog_warn(tslog_t *logger, const char *format, ...);
 void tslog_info(tslog_t *logger, const char *format, ...);
@@ -33,4 +89,73 @@ void tslog_debug(tslog_t *logger, const char *format, ...);
 const char* tslog_level_to_string(tslog_level_t level);
 void tslog_get_timestamp(char *buffer, size_t size, const char *format);
 
-#endif
\ No newline at end of file
+// Nível mínimo em tempo de compilação: chamadas abaixo dele somem do binário
+// (ex.: -DTSLOG_MIN_LEVEL=TSLOG_INFO remove todos os tslog_debug)
+#ifndef TSLOG_MIN_LEVEL
+#define TSLOG_MIN_LEVEL TSLOG_DEBUG
+#endif
+
+static inline int tslog_enabled(const tslog_t *logger, tslog_level_t level) {
+    return logger != NULL && level <= logger->level;
+}
+
+// As funções por nível são macros: o nível é verificado antes de qualquer
+// argumento ser avaliado. Para chamar a função diretamente use (tslog_info)(...).
+#define TSLOG_EMIT(logger, lvl, ...) \
+    do { \
+        if ((lvl) <= TSLOG_MIN_LEVEL && tslog_enabled((logger), (lvl))) \
+            tslog_log((logger), (lvl), __VA_ARGS__); \
+    } while (0)
+
+#define tslog_error(logger, ...) TSLOG_EMIT(logger, TSLOG_ERROR, __VA_ARGS__)
+#define tslog_warn(logger, ...)  TSLOG_EMIT(logger, TSLOG_WARN, __VA_ARGS__)
+#define tslog_info(logger, ...)  TSLOG_EMIT(logger, TSLOG_INFO, __VA_ARGS__)
+#define tslog_debug(logger, ...) TSLOG_EMIT(logger, TSLOG_DEBUG, __VA_ARGS__)
+
+// Limite por ponto de chamada, configurável por subsistema em tempo de
+// execução: no máximo `per_second` mensagens por segundo (0 = sem limite) e/ou
+// 1 a cada `sample_every` (<= 1 = todas). As descartadas viram um resumo
+// "N mensagens suprimidas" quando a janela de um segundo vira: na próxima
+// chamada do site ou, no modo assíncrono, pela thread escritora mesmo que o
+// site não seja mais chamado.
+typedef struct tslog_subsystem tslog_subsystem_t;
+
+typedef struct tslog_site {
+    const char *subsystem;
+    const char *file;
+    int line;
+    tslog_level_t level;
+    _Atomic(tslog_subsystem_t*) config;
+    struct tslog_site *next;
+    atomic_long window;
+    atomic_int count;
+    atomic_long seen;
+    atomic_long suppressed;
+    _Atomic(tslog_t*) logger;   // quem recebe o resumo
+} tslog_site_t;
+
+int tslog_set_rate_limit(const char *subsystem, int per_second, int sample_every);
+int tslog_get_rate_limit(const char *subsystem, int *per_second, int *sample_every, long *suppressed);
+void tslog_foreach_rate_limit(void (*callback)(const char *subsystem, int per_second,
+                                               int sample_every, long suppressed, void *arg),
+                              void *arg);
+int tslog_site_allow(tslog_t *logger, tslog_site_t *site);
+// Registra os resumos pendentes (chamado também por tslog_destroy)
+void tslog_report_suppressed(tslog_t *logger);
+// Só os resumos de janelas já encerradas (a thread escritora chama a cada segundo)
+void tslog_report_due(tslog_t *logger);
+
+#define TSLOG_EMIT_LIMITED(logger, lvl, subsys, ...) \
+    do { \
+        static tslog_site_t tslog_site_ = { .subsystem = (subsys), .file = __FILE__, \
+                                            .line = __LINE__, .level = (lvl) }; \
+        if ((lvl) <= TSLOG_MIN_LEVEL && tslog_enabled((logger), (lvl)) && \
+            tslog_site_allow((logger), &tslog_site_)) \
+            tslog_log((logger), (lvl), __VA_ARGS__); \
+    } while (0)
+
+#define tslog_warn_limited(logger, subsys, ...)  TSLOG_EMIT_LIMITED(logger, TSLOG_WARN, subsys, __VA_ARGS__)
+#define tslog_info_limited(logger, subsys, ...)  TSLOG_EMIT_LIMITED(logger, TSLOG_INFO, subsys, __VA_ARGS__)
+#define tslog_debug_limited(logger, subsys, ...) TSLOG_EMIT_LIMITED(logger, TSLOG_DEBUG, subsys, __VA_ARGS__)
+
+#endif
@@ -2,25 +2,137 @@
 #define WORKER_MANAGER_H
 
 #include "../common/protocol.h"
+#include "../common/local_transport.h"
 #include "job_queue.h"
+#include "int_map.h"
+#include "timing_wheel.h"
+#include "lease_table.h"
+#include "capability.h"
 #include "../include/tslog.h"
 
+#define WORKER_MAX_SLOTS 16          // jobs simultâneos por worker
+#define WORKER_WHEEL_SLOTS 256
+#define WORKER_WHEEL_TICK_MS 250     // resolução da detecção de workers mortos
+#define WORKER_LIST_INTERVAL 30      // segundos entre listagens no log
+#define WORKER_LATENCY_ALPHA 0.2     // peso da última amostra na média de latência
+#define WORKER_MAX_OFFERS 64         // perfis considerados por rodada do dispatcher
+
+// Escolha do worker que recebe o próximo job (modo push)
+typedef enum {
+    PLACEMENT_P2C,                   // sorteia dois e fica com o de menor carga
+    PLACEMENT_ROUND_ROBIN,
+    PLACEMENT_LEAST_LOADED           // percorre todos os disponíveis (O(n))
+} placement_policy_t;
+
+typedef struct {
+    int job_id;
+    int priority;
+    long leased_at;                  // ms monotônico da entrega, para a latência
+} worker_lease_t;
+
+// Perfil: conjunto de capacidades anunciado por um ou mais workers. Cada
+// perfil tem o próprio vetor de workers com slot livre, então achar quem
+// atende um job só olha os perfis compatíveis, nunca a frota inteira.
+// Perfis não são removidos: eles dizem se algum worker já atendeu (e
+// portanto pode atender) um conjunto de capacidades.
+typedef struct worker_profile {
+    cap_mask_t caps;
+    char tags[CAPABILITY_LIST_MAX];
+    struct worker_entry **available;
+    int available_count;
+    int available_capacity;
+    int workers;                     // registrados agora com este perfil
+} worker_profile_t;
+
+typedef struct worker_entry {
+    worker_info_t info;
+    worker_profile_t *profile;
+    int socket;                      // conexão do worker (fechada quando a entrada é liberada)
+    int slots;                       // jobs simultâneos; 0 = worker antigo, modo pull
+    worker_lease_t leased[WORKER_MAX_SLOTS];  // jobs entregues ainda sem resultado
+    int leased_count;
+    int available_index;             // posição em profile->available (-1 = sem slot livre)
+    int refs;                        // envios em andamento fora do lock
+    int removed;                     // já saiu do registro; liberado com refs == 0
+    pthread_mutex_t send_mutex;      // dispatcher e handler escrevem no mesmo socket
+    shm_channel_t *channel;          // worker local: JOBs pelo anel (NULL = só o socket)
+    timer_node_t heartbeat_timer;    // prazo para a próxima mensagem do worker
+} worker_entry_t;
+
 typedef struct worker_manager_t {
     int sockfd;
     job_queue_t *queue;
+    lease_table_t *leases;           // opcional: prazos e novas tentativas dos jobs entregues
+    capability_registry_t *caps;     // opcional: sem ele todo worker tem o perfil vazio
     tslog_t *logger;
-    pthread_mutex_t lock;
+    pthread_mutex_t lock;            // ordem: lock -> leases->mutex -> fila
+    int_map_t workers;               // worker_id -> worker_entry_t*
+    timing_wheel_t heartbeats;
+    int next_worker_id;
+    int heartbeat_timeout;           // segundos sem mensagem até declarar o worker morto
+    int running;
+
+    // Workers push com slot livre, em vetores densos por perfil: sorteio e
+    // remoção em O(1)
+    worker_profile_t **profiles;
+    int profile_count;
+    int profile_capacity;
+    int available_count;             // soma dos perfis
+    pthread_cond_t capacity_cond;
+    placement_policy_t policy;
+    unsigned int rr_cursor;
+    unsigned int rand_state;
 } worker_manager_t;
 
 int worker_manager_init(worker_manager_t *manager, tslog_t *logger, job_queue_t *queue);
 void worker_manager_destroy(worker_manager_t *manager);
+void worker_manager_set_timeout(worker_manager_t *manager, int seconds);
+void worker_manager_attach_leases(worker_manager_t *manager, lease_table_t *leases);
+void worker_manager_attach_capabilities(worker_manager_t *manager, capability_registry_t *caps);
+// Perfil conhecido de execuções anteriores (tabela worker_profiles)
+int worker_manager_add_profile(worker_manager_t *manager, const char *tags);
+// 1 se algum worker já registrado oferece tudo o que `needs` pede; 0 com o
+// motivo em `reason`. Sem nenhum perfil conhecido ainda, aceita.
+int worker_manager_can_satisfy(worker_manager_t *manager, const char *needs,
+                               char *reason, size_t reason_size);
+void worker_manager_set_policy(worker_manager_t *manager, placement_policy_t policy);
+// "p2c", "round-robin" ou "least-loaded"; retorna -1 se desconhecida
+int worker_manager_policy_from_name(const char *name, placement_policy_t *policy);
+const char* worker_manager_policy_name(placement_policy_t policy);
 
-int worker_manager_register(worker_manager_t *manager, int socket, const char *hostname);
+// Registra o worker e responde REGISTERED:<id>. slots > 0 ativa o modo push;
+// caps é a lista "tag,tag" anunciada ("" = nenhuma capacidade especial).
+// A partir daqui o socket pertence ao worker manager, que o fecha.
+int worker_manager_register(worker_manager_t *manager, int socket, const char *hostname, int slots,
+                            const char *caps);
+// Capacidades do worker, para o modo pull; -1 se ele não está registrado
+int worker_manager_get_caps(worker_manager_t *manager, int worker_id, cap_mask_t *caps);
+// Jobs que o worker ainda executava voltam para a fila (ver lease_table.h)
+void worker_manager_unregister(worker_manager_t *manager, int worker_id);
+// Modo pull: abre o lease do job que o handler tirou da fila para o worker.
+// Retorna 1 se o job foi cancelado nesse meio tempo e -1 se o worker não o
+// pode receber; nos dois casos o job não deve ser enviado.
 int worker_manager_assign_job(worker_manager_t *manager, int worker_id, job_t *job);
+// Resultado chegou: libera o slot e devolve a prioridade do job (para as estatísticas)
+int worker_manager_release_job(worker_manager_t *manager, int worker_id, int job_id, int *priority);
+// A outra cópia do job venceu: libera o slot e manda CANCEL:<id> ao worker (modo push)
+int worker_manager_cancel_job(worker_manager_t *manager, int worker_id, int job_id);
+// Worker push local entregou o canal de memória compartilhada: os JOBs
+// passam a ir pelo anel e o canal é fechado junto com a entrada. -1 se o
+// worker não existe, é pull ou já tem canal (o canal continua de quem chamou).
+int worker_manager_attach_channel(worker_manager_t *manager, int worker_id, shm_channel_t *channel);
+// Envia uma linha ao worker, serializada com os envios do dispatcher
+int worker_manager_send(worker_manager_t *manager, int worker_id, const char *line);
+// Qualquer mensagem do worker conta como heartbeat
 void worker_manager_heartbeat(worker_manager_t *manager, int worker_id);
 void worker_manager_check_heartbeats(worker_manager_t *manager);
+// Copia o estado do worker; retorna -1 se ele não está registrado
+int worker_manager_get(worker_manager_t *manager, int worker_id, worker_info_t *info);
+int worker_manager_count(worker_manager_t *manager);
 void worker_manager_list(worker_manager_t *manager);
 
 void* worker_monitor_thread_func(void *arg);
+// Tira da fila jobs que algum worker push livre atende e os entrega conforme a política
+void* worker_dispatcher_thread_func(void *arg);
 
-#endif
\ No newline at end of file
+#endif
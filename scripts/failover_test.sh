@@ -0,0 +1,82 @@
+#!/bin/bash
+# Primário com --replication e um standby; submete jobs lentos, derruba o
+# primário com kill -9 no meio da execução e confere que o standby assume e
+# que todos os jobs terminam (os que estavam rodando são executados de novo).
+# Uso: scripts/failover_test.sh [jobs] [segundos por job]
+
+JOBS=${1:-20}
+JOB_SECONDS=${2:-1}
+PRIMARY_PORT=${PRIMARY_PORT:-9200}
+STANDBY_PORT=${STANDBY_PORT:-9201}
+FAILOVER=${FAILOVER:-3}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+RUN_DIR=$(mktemp -d /tmp/failover_test.XXXXXX)
+PIDS=()
+
+cleanup() {
+    for pid in "${PIDS[@]}"; do kill "$pid" 2>/dev/null; done
+    wait 2>/dev/null
+}
+trap cleanup EXIT INT TERM
+
+SPEC="127.0.0.1:$PRIMARY_PORT/127.0.0.1:$STANDBY_PORT"
+
+# Jobs com o status dado, somando as páginas de até 100
+count_status() {
+    local total=0 after=0 page
+    while :; do
+        page=$("$ROOT/client" --shards "$SPEC" list --status "$1" --limit 100 --after "$after")
+        total=$((total + $(echo "$page" | tail -n +2 | grep -c "^[0-9]")))
+        after=$(echo "$page" | sed -n 's/^Mais jobs: use --after //p')
+        [ -z "$after" ] && break
+    done
+    echo "$total"
+}
+
+cd "$RUN_DIR" || exit 1
+
+mkdir primary standby
+(cd primary && exec "$ROOT/server" --port "$PRIMARY_PORT" --replication </dev/null >/dev/null 2>&1) &
+PRIMARY=$!
+PIDS+=($PRIMARY)
+sleep 0.5
+(cd standby && exec "$ROOT/server" --port "$STANDBY_PORT" --standby-of "127.0.0.1:$PRIMARY_PORT" \
+    --failover-timeout "$FAILOVER" </dev/null >/dev/null 2>&1) &
+PIDS+=($!)
+sleep 1
+
+"$ROOT/worker" --shards "$SPEC" --slots 4 >/dev/null 2>&1 &
+PIDS+=($!)
+
+echo "Submetendo $JOBS jobs de ${JOB_SECONDS}s..."
+for ((i = 0; i < JOBS; i++)); do
+    "$ROOT/client" --shards "$SPEC" submit "sleep $JOB_SECONDS; echo job $i" >/dev/null
+done
+sleep 1
+"$ROOT/client" --shards "$SPEC" replication
+
+echo "kill -9 no primário (pid $PRIMARY)"
+start=$(date +%s.%N)
+kill -9 "$PRIMARY"
+
+# Espera o standby aceitar submissões
+for ((t = 0; t < 100; t++)); do
+    state=$("$ROOT/client" --port "$STANDBY_PORT" replication)
+    case "$state" in *REPL:PRIMARY*) break ;; esac
+    sleep 0.1
+done
+end=$(date +%s.%N)
+echo "Standby promovido em $(awk -v a="$start" -v b="$end" 'BEGIN { printf "%.1f", b - a }')s: $state"
+
+echo "Submissão depois do failover:"
+"$ROOT/client" --shards "$SPEC" submit "echo depois do failover"
+
+for ((t = 0; t < 180; t++)); do
+    left=$(( $(count_status PENDING) + $(count_status RUNNING) ))
+    [ "$left" -eq 0 ] && break
+    sleep 1
+done
+completed=$(count_status COMPLETED)
+echo "Concluídos no novo primário: $completed de $((JOBS + 1)); pendentes ou em execução: $left"
+echo "Logs e bancos em $RUN_DIR"
+[ "$left" -eq 0 ]
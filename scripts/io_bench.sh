@@ -0,0 +1,75 @@
+#!/bin/bash
+# Chamadas de sistema por job no servidor e no worker (tools/syscount): sobe
+# os dois sob o contador, submete jobs com "client load" e divide o total
+# pelo número de jobs. Mede duas vezes, com SCHEDULER_IO_URING=0 (caminho
+# portável) e sem ele; num build sem IO_URING=1 as duas medidas usam o
+# caminho portável.
+# Uso: make IO_URING=1 && make syscount && scripts/io_bench.sh [jobs] [slots]
+
+JOBS=${1:-2000}
+SLOTS=${2:-4}
+PORT=${PORT:-9300}
+SCRIPT=${SCRIPT:-true}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+RUN_DIR=$(mktemp -d /tmp/io_bench.XXXXXX)
+PIDS=()
+
+cleanup() {
+    for pid in "${PIDS[@]}"; do kill "$pid" 2>/dev/null; done
+    wait 2>/dev/null
+}
+trap cleanup EXIT INT TERM
+
+if [ ! -x "$ROOT/syscount" ]; then
+    echo "Compile o contador antes: make syscount"
+    exit 1
+fi
+# io_uring só no socket TCP: sem o socket local
+export SCHEDULER_TRANSPORT=tcp
+
+# Há jobs com o status dado?
+has_status() {
+    "$ROOT/client" --port "$PORT" list --status "$1" --limit 1 | tail -n +2 | grep -q "^[0-9]"
+}
+
+# Medida: <nome> <valor de SCHEDULER_IO_URING>
+measure() {
+    local dir="$RUN_DIR/$1"
+    mkdir -p "$dir"
+    (cd "$dir" && SCHEDULER_IO_URING=$2 exec "$ROOT/syscount" server.count \
+        "$ROOT/server" --port "$PORT" --no-unix </dev/null >/dev/null 2>&1) &
+    local server=$!
+    sleep 0.5
+    (cd "$dir" && SCHEDULER_IO_URING=$2 exec "$ROOT/syscount" worker.count \
+        "$ROOT/worker" --port "$PORT" --slots "$SLOTS" </dev/null >/dev/null 2>&1) &
+    local worker=$!
+    PIDS=($server $worker)
+    sleep 1
+
+    # Só a carga conta: registro e inicialização ficam de fora
+    kill -USR1 "$server" "$worker"
+    sleep 0.2
+    (cd "$dir" && "$ROOT/client" --port "$PORT" load "$JOBS" "$SCRIPT" >/dev/null)
+    for ((t = 0; t < 600; t++)); do
+        has_status PENDING || has_status RUNNING || break
+        sleep 0.2
+    done
+
+    kill -TERM "$server" "$worker"
+    wait "$server" "$worker" 2>/dev/null
+    PIDS=()
+
+    local s w
+    s=$(awk '/^total/ { print $2 }' "$dir/server.count")
+    w=$(awk '/^total/ { print $2 }' "$dir/worker.count")
+    awk -v name="$1" -v s="$s" -v w="$w" -v n="$JOBS" 'BEGIN {
+        printf "%-9s servidor %8d (%6.1f/job)  worker %8d (%6.1f/job)  total %6.1f/job\n",
+               name, s, s / n, w, w / n, (s + w) / n }'
+    echo "          servidor: $(sed -n '2,6p' "$dir/server.count" | paste -sd ',' | sed 's/,/, /g')"
+    echo "          worker:   $(sed -n '2,6p' "$dir/worker.count" | paste -sd ',' | sed 's/,/, /g')"
+}
+
+echo "$JOBS jobs \"$SCRIPT\", worker com $SLOTS slots"
+measure portavel 0
+measure io_uring 1
+echo "Contagens completas em $RUN_DIR"
@@ -0,0 +1,81 @@
+#!/bin/bash
+# Sobe N shards do servidor em portas locais e mede a vazão de submissão com
+# 1 shard e com N; depois um worker puxa de todas até esvaziar as filas.
+# Uso: scripts/shard_test.sh [shards] [jobs] [clientes paralelos]
+
+SHARDS=${1:-4}
+JOBS=${2:-400}
+PARALLEL=${3:-16}
+BASE_PORT=${BASE_PORT:-9100}
+ROOT=$(cd "$(dirname "$0")/.." && pwd)
+RUN_DIR=$(mktemp -d /tmp/shard_test.XXXXXX)
+PIDS=()
+
+cleanup() {
+    for pid in "${PIDS[@]}"; do kill "$pid" 2>/dev/null; done
+    wait 2>/dev/null
+}
+trap cleanup EXIT INT TERM
+
+# Sobe as shards 0..n-1 e deixa em SPEC a lista para client/worker
+start_shards() {
+    local n=$1
+    SPEC=""
+    for ((i = 0; i < n; i++)); do
+        local port=$((BASE_PORT + i))
+        "$ROOT/server" --port "$port" --shard "$i" </dev/null >/dev/null 2>&1 &
+        PIDS+=($!)
+        SPEC+="${SPEC:+,}$i=127.0.0.1:$port"
+    done
+    sleep 1
+}
+
+stop_shards() {
+    cleanup
+    PIDS=()
+}
+
+# Submete JOBS jobs com PARALLEL clientes; imprime jobs/s
+submit_all() {
+    local start end
+    start=$(date +%s.%N)
+    seq "$JOBS" | xargs -P "$PARALLEL" -I{} "$ROOT/client" --shards "$SPEC" submit "echo job {}" >/dev/null
+    end=$(date +%s.%N)
+    awk -v n="$JOBS" -v a="$start" -v b="$end" 'BEGIN { printf "%.1f", n / (b - a) }'
+}
+
+# Jobs de cada shard com o status dado (primeira página basta para contar até 100)
+count_status() {
+    "$ROOT/client" --shards "$SPEC" list --status "$1" --limit 100 | tail -n +2 | grep -c "^[0-9]"
+}
+
+cd "$RUN_DIR" || exit 1
+
+echo "=== 1 shard ==="
+start_shards 1
+single=$(submit_all)
+echo "Submissões: $single jobs/s"
+stop_shards
+rm -f scheduler.shard*.db*
+
+echo "=== $SHARDS shards ==="
+start_shards "$SHARDS"
+multi=$(submit_all)
+echo "Submissões: $multi jobs/s (x$(awk -v a="$multi" -v b="$single" 'BEGIN { printf "%.2f", a / b }'))"
+
+echo "Distribuição por shard (hash consistente da chave de idempotência):"
+for ((i = 0; i < SHARDS; i++)); do
+    pending=$("$ROOT/client" --port $((BASE_PORT + i)) list --status PENDING --limit 100 | tail -n +2 | grep -c "^[0-9]")
+    echo "  shard $i: $pending pendentes (primeira página)"
+done
+
+echo "Worker puxando de todas as shards..."
+"$ROOT/worker" --shards "$SPEC" --slots 8 >/dev/null 2>&1 &
+PIDS+=($!)
+for ((t = 0; t < 120; t++)); do
+    left=$(( $(count_status PENDING) + $(count_status RUNNING) ))
+    [ "$left" -eq 0 ] && break
+    sleep 1
+done
+echo "Pendentes ou em execução restantes: $left"
+echo "Logs e bancos em $RUN_DIR"
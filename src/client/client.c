@@ -2,75 +2,401 @@
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
-#include <sys/socket.h>
-#include <netinet/in.h>
-#include <arpa/inet.h>
+#include <time.h>
+#include <pthread.h>
+#include <stdatomic.h>
 #include "../common/protocol.h"
+#include "../common/shard_ring.h"
 #include "../include/tslog.h"
+#include "../include/scheduler_client.h"
 
-#define BUFFER_SIZE 2048
+#define BUFFER_SIZE PROTOCOL_LINE_MAX
+#define LIST_PAGE_MAX 100           // igual a JOB_INDEX_PAGE_MAX do servidor
 
 tslog_t logger;
+// Servidores: um só (--port) ou as shards de --shards / SCHEDULER_SHARDS
+static shard_ring_t shards;
+// Conexões persistentes com eles (ver scheduler_client.h)
+static sched_client_t scheduler;
 
 void print_usage() {
-    printf("Uso: client <comando> [argumentos]\n");
+    printf("Uso: client [--port porta | --shards [n=]host:porta[/host:porta],...] <comando> [argumentos]\n");
     printf("Comandos:\n");
-    printf("  submit <script>    - Submeter um job\n");
-    printf("  list               - Listar jobs no servidor\n");
+    printf("  submit [opções] <script> - Submeter um job\n");
+    printf("      --priority n --timeout s   prioridade (1-10) e timeout\n");
+    printf("      --at epoch | --delay s     não executar antes desse instante\n");
+    printf("      --every s | --cron \"expr\" repetir (intervalo ou cron de 5 campos)\n");
+    printf("      --jitter s                 atraso aleatório em cada disparo\n");
+    printf("      --client nome              cliente/tenant na fila justa (padrão: IP)\n");
+    printf("      --after id,id,@batch       só executar depois desses jobs\n");
+    printf("      --batch nome               incluir o job no batch\n");
+    printf("      --needs tag,tag            capacidades exigidas do worker (ex.: gpu,python3.11)\n");
+    printf("      --deadline epoch | --due s prazo para terminar (recusado se inviável)\n");
+    printf("      --hedge 0                  nunca executar cópia especulativa (não idempotente)\n");
+    printf("      --key chave                chave de idempotência (padrão: gerada por submissão)\n");
+    printf("  cancel <id>        - Cancelar job pendente ou em execução\n");
+    printf("  status <id>        - Estado de um job\n");
+    printf("  wait <id> [s]      - Esperar o job terminar (no máximo s segundos)\n");
+    printf("  unschedule <id>    - Remover um job agendado\n");
+    printf("  list [opções]      - Listar jobs no servidor (páginas de até 100)\n");
+    printf("      --status S --client nome   filtros (PENDING, RUNNING, COMPLETED, ...)\n");
+    printf("      --after id --limit n       continuar a partir do cursor da página anterior\n");
+    printf("  load <n> <script>  - Submeter n jobs de uma vez (assíncrono) e medir a vazão\n");
+    printf("  watch [opções] <tópico>... - Receber términos por push: job=<id>, batch=<nome>, tag=<tag>\n");
+    printf("      --count n --timeout s      parar depois de n notificações ou s segundos\n");
+    printf("  replication        - Papel e atraso de replicação de cada servidor\n");
     printf("  interactive        - Modo interativo\n");
+    printf("Com várias shards a submissão vai para a dona das dependências, do batch,\n");
+    printf("do --client ou da chave (hash consistente); status/cancel pelo id do job.\n");
+    printf("Com standby (host:porta/host:porta) o cliente passa ao outro servidor se\n");
+    printf("o primeiro sumir ou responder ERROR:NOT_PRIMARY.\n");
 }
 
-int connect_to_server() {
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        tslog_error(&logger, "Erro ao criar socket");
+// Mostra a resposta de um pedido bloqueante
+static int print_reply(int rc, const sched_reply_t *reply) {
+    if (rc != 0) {
+        printf("Erro: pedido não enviado (veja client.log)\n");
         return -1;
     }
-    
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(SERVER_PORT);
-    
-    if (inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr) <= 0) {
-        tslog_error(&logger, "Endereço inválido");
-        close(sock);
+    if (reply->result == SCHED_UNAVAILABLE && !reply->line[0]) {
+        printf("Servidor indisponível - desistindo\n");
         return -1;
     }
-    
-    if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        tslog_error(&logger, "Erro ao conectar com servidor");
-        close(sock);
-        return -1;
+    if (reply->line[0]) {
+        printf("Resposta do servidor: %s\n", reply->line);
     }
-    
-    tslog_info(&logger, "Conectado ao servidor");
-    return sock;
+    return reply->result == SCHED_OK ? 0 : -1;
+}
+
+int submit_job_with_options(const char *script, const job_options_t *opts) {
+    // A biblioteca gera a chave de idempotência e cuida de RETRY_AFTER,
+    // respostas perdidas e failover, reenviando com a mesma chave
+    sched_reply_t reply;
+    return print_reply(sched_client_submit(&scheduler, script, opts, &reply), &reply);
 }
 
 int submit_job(const char *script) {
-    int sock = connect_to_server();
-    if (sock < 0) return -1;
-    
-    char message[BUFFER_SIZE];
-    snprintf(message, BUFFER_SIZE, "JOB:%s", script);
-    
-    if (write(sock, message, strlen(message)) < 0) {
-        tslog_error(&logger, "Erro ao enviar job");
-        close(sock);
+    return submit_job_with_options(script, NULL);
+}
+
+// Linha de comando para a dona do job/agendamento `id`
+static int send_to_owner(const char *prefix, int id) {
+    char message[64];
+    snprintf(message, sizeof(message), "%s:%d", prefix, id);
+    int shard = sched_client_owner(&scheduler, id);
+    if (shard < 0) {
+        printf("Erro: %d pertence à shard %d, fora da lista\n", id, shard_of_id(id));
         return -1;
     }
+    sched_reply_t reply;
+    return print_reply(sched_client_command(&scheduler, shard, message, &reply), &reply);
+}
+
+int cancel_job(int job_id) {
+    return send_to_owner("CANCEL", job_id);
+}
+
+int job_status(int job_id) {
+    return send_to_owner("STATUS", job_id);
+}
+
+int wait_job(int job_id, int timeout_s) {
+    sched_reply_t reply;
+    int rc = sched_client_wait(&scheduler, job_id, timeout_s * 1000, &reply);
+    if (rc == 0 && reply.result == SCHED_TIMEOUT) {
+        printf("Job %d ainda não terminou após %ds\n", job_id, timeout_s);
+        return -1;
+    }
+    return print_reply(rc, &reply);
+}
+
+typedef struct {
+    int id;
+    char status[16];
+    char client[JOB_CLIENT_MAX];
+    int priority;
+    int worker;
+    int attempts;
+} list_item_t;
+
+static int compare_items(const void *a, const void *b) {
+    return ((const list_item_t*)a)->id - ((const list_item_t*)b)->id;
+}
+
+// "list [--status S] [--client c] [--after id] [--limit n]"
+int list_jobs(int argc, char *argv[]) {
+    char message[256] = "LIST_JOBS";
+    size_t used = strlen(message);
+    int limit = LIST_PAGE_MAX;
+    for (int i = 2; i + 1 < argc; i += 2) {
+        const char *key = strncmp(argv[i], "--", 2) == 0 ? argv[i] + 2 : "";
+        if (strcmp(key, "status") != 0 && strcmp(key, "client") != 0 &&
+            strcmp(key, "after") != 0 && strcmp(key, "limit") != 0) {
+            printf("Opção desconhecida: %s\n", argv[i]);
+            return -1;
+        }
+        if (strcmp(key, "limit") == 0) {
+            limit = atoi(argv[i + 1]);
+        }
+        used += (size_t)snprintf(message + used, sizeof(message) - used, "%c%s=%s",
+                                 used == 9 ? '?' : '&', key, argv[i + 1]);
+        if (used >= sizeof(message)) return -1;
+    }
     
-    char response[BUFFER_SIZE];
-    ssize_t bytes_read = read(sock, response, BUFFER_SIZE - 1);
-    if (bytes_read > 0) {
-        response[bytes_read] = '\0';
-        printf("Resposta do servidor: %s\n", response);
+    // Todas as shards ao mesmo tempo; cada uma devolve a sua página em ordem
+    // de id e a junção só vai até o menor cursor entre elas (além dele alguma
+    // shard ainda tem jobs não vistos)
+    sched_future_t *pages[SHARD_MAX];
+    for (int s = 0; s < shards.count; s++) {
+        pages[s] = sched_client_command_future(&scheduler, s, message);
+    }
+    list_item_t *items = malloc((size_t)shards.count * LIST_PAGE_MAX * sizeof(list_item_t));
+    int total = 0, cutoff = 0, more = 0, failed = !items;
+    for (int s = 0; s < shards.count; s++) {
+        if (!pages[s]) {
+            failed = 1;
+            continue;
+        }
+        sched_future_wait(pages[s], 0);
+        char response[BUFFER_SIZE];
+        snprintf(response, sizeof(response), "%s", sched_future_reply(pages[s])->line);
+        sched_future_free(pages[s]);
+        
+        int count, cursor, offset = 0;
+        if (failed || sscanf(response, "JOBS:%d:%d:%n", &count, &cursor, &offset) != 2) {
+            if (!failed) {
+                printf("Resposta do servidor %s:%d: %s\n", shards.shards[s].host, shards.shards[s].port,
+                       response[0] ? response : "(nenhuma)");
+            }
+            failed = 1;
+            continue;
+        }
+        if (cursor > 0) {
+            more = 1;
+            if (cutoff == 0 || cursor < cutoff) cutoff = cursor;
+        }
+        char *save = NULL;
+        for (char *item = strtok_r(response + offset, ";", &save); item && total < shards.count * LIST_PAGE_MAX;
+             item = strtok_r(NULL, ";", &save)) {
+            list_item_t *it = &items[total];
+            if (sscanf(item, "%d,%15[^,],%31[^,],%d,%d,%d", &it->id, it->status, it->client,
+                       &it->priority, &it->worker, &it->attempts) == 6) {
+                total++;
+            }
+        }
     }
+    if (failed) {
+        free(items);
+        return -1;
+    }
+    qsort(items, total, sizeof(list_item_t), compare_items);
     
-    close(sock);
+    printf("%-8s %-12s %-16s %4s %7s %10s\n", "ID", "STATUS", "CLIENTE", "PRI", "WORKER", "TENTATIVAS");
+    int shown = 0;
+    for (; shown < total && shown < limit && (cutoff == 0 || items[shown].id <= cutoff); shown++) {
+        const list_item_t *it = &items[shown];
+        printf("%-8d %-12s %-16s %4d %7d %10d\n", it->id, it->status, it->client, it->priority,
+               it->worker, it->attempts);
+    }
+    if (shown > 0 && (more || shown < total)) {
+        printf("Mais jobs: use --after %d\n", items[shown - 1].id);
+    }
+    free(items);
     return 0;
 }
 
+// Notificações: o callback roda na thread da biblioteca
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t arrived;
+    int received;
+} watch_t;
+
+static void watch_callback(const sched_notification_t *n, void *arg) {
+    watch_t *watch = (watch_t*)arg;
+    if (n->lost > 0) {
+        printf("[%s] %ld notificações perdidas (use status)\n", n->topic, n->lost);
+    } else {
+        printf("[%s] job %d %s (%.2fs): %s\n", n->topic, n->id, protocol_status_name(n->status),
+               n->exec_time, n->output);
+    }
+    fflush(stdout);
+    pthread_mutex_lock(&watch->mutex);
+    if (n->lost == 0) watch->received++;
+    pthread_cond_signal(&watch->arrived);
+    pthread_mutex_unlock(&watch->mutex);
+}
+
+// "watch [--count n] [--timeout s] job=12 batch=etl tag=gpu"
+int watch_topics(int argc, char *argv[]) {
+    int count = 0, timeout_s = 0, topics = 0;
+    watch_t watch;
+    memset(&watch, 0, sizeof(watch));
+    pthread_mutex_init(&watch.mutex, NULL);
+    pthread_cond_init(&watch.arrived, NULL);
+
+    for (int i = 2; i < argc; i++) {
+        if (strcmp(argv[i], "--count") == 0 && i + 1 < argc) {
+            count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--timeout") == 0 && i + 1 < argc) {
+            timeout_s = atoi(argv[++i]);
+        } else if (sched_client_subscribe(&scheduler, argv[i], watch_callback, &watch) != 0) {
+            printf("Erro: não foi possível assinar %s (veja client.log)\n", argv[i]);
+        } else {
+            topics++;
+        }
+    }
+    if (topics == 0) return -1;
+
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_s;
+    int rc = 0;
+    pthread_mutex_lock(&watch.mutex);
+    while ((count == 0 || watch.received < count) && rc == 0) {
+        if (timeout_s > 0) {
+            rc = pthread_cond_timedwait(&watch.arrived, &watch.mutex, &deadline);
+        } else {
+            pthread_cond_wait(&watch.arrived, &watch.mutex);
+        }
+    }
+    pthread_mutex_unlock(&watch.mutex);
+    // A biblioteca para (e com ela os callbacks) antes de o watch_t sumir
+    sched_client_destroy(&scheduler);
+    pthread_mutex_destroy(&watch.mutex);
+    pthread_cond_destroy(&watch.arrived);
+    return count > 0 && watch.received < count ? -1 : 0;
+}
+
+// Papel e atraso de replicação de cada servidor (e do standby, se houver)
+int replication_status(void) {
+    for (int s = 0; s < shards.count; s++) {
+        shard_t servers[2] = {shards.shards[s], shards.shards[s]};
+        int count = 1;
+        if (servers[0].standby_host[0]) {
+            snprintf(servers[1].host, sizeof(servers[1].host), "%s", servers[0].standby_host);
+            servers[1].port = servers[0].standby_port;
+            servers[0].standby_host[0] = servers[1].standby_host[0] = '\0';
+            count = 2;
+        }
+        for (int i = 0; i < count; i++) {
+            char response[BUFFER_SIZE];
+            if (sched_call(&servers[i], "REPL_STATUS", response, sizeof(response), 0, &logger) != 0) {
+                printf("%s:%d: sem conexão\n", servers[i].host, servers[i].port);
+            } else {
+                printf("%s:%d: %s\n", servers[i].host, servers[i].port, response);
+            }
+        }
+    }
+    return 0;
+}
+
+int unschedule_job(int schedule_id) {
+    return send_to_owner("UNSCHEDULE", schedule_id);
+}
+
+// Carga: uma thread põe as n submissões em voo pela API assíncrona e espera
+// os callbacks (rodam na thread da biblioteca)
+typedef struct {
+    pthread_mutex_t mutex;
+    pthread_cond_t done;
+    int remaining;
+    atomic_int accepted;
+    atomic_int rejected;
+    atomic_int unavailable;
+} load_t;
+
+static void load_callback(const sched_reply_t *reply, void *arg) {
+    load_t *load = (load_t*)arg;
+    if (reply->result == SCHED_OK) {
+        atomic_fetch_add(&load->accepted, 1);
+    } else if (reply->result == SCHED_REJECTED) {
+        atomic_fetch_add(&load->rejected, 1);
+    } else {
+        atomic_fetch_add(&load->unavailable, 1);
+    }
+    pthread_mutex_lock(&load->mutex);
+    if (--load->remaining == 0) pthread_cond_signal(&load->done);
+    pthread_mutex_unlock(&load->mutex);
+}
+
+int load_jobs(int count, const char *script) {
+    load_t load;
+    memset(&load, 0, sizeof(load));
+    pthread_mutex_init(&load.mutex, NULL);
+    pthread_cond_init(&load.done, NULL);
+    load.remaining = count;
+    
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    int refused = 0;
+    for (int i = 0; i < count; i++) {
+        if (sched_client_submit_async(&scheduler, script, NULL, load_callback, &load) != 0) {
+            refused++;
+        }
+    }
+    pthread_mutex_lock(&load.mutex);
+    load.remaining -= refused;
+    while (load.remaining > 0) {
+        pthread_cond_wait(&load.done, &load.mutex);
+    }
+    pthread_mutex_unlock(&load.mutex);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    
+    double elapsed = (double)(end.tv_sec - start.tv_sec) + (double)(end.tv_nsec - start.tv_nsec) / 1e9;
+    printf("%d submissões em %.2fs (%.0f jobs/s): %d aceitas, %d recusadas, %d sem servidor, %d não enviadas\n",
+           count, elapsed, elapsed > 0 ? count / elapsed : 0.0, atomic_load(&load.accepted),
+           atomic_load(&load.rejected), atomic_load(&load.unavailable), refused);
+    pthread_mutex_destroy(&load.mutex);
+    pthread_cond_destroy(&load.done);
+    return refused == 0 && atomic_load(&load.accepted) == count ? 0 : -1;
+}
+
+// Lê as opções de "submit" até o script; retorna o índice do script ou -1
+static int parse_submit_options(int argc, char *argv[], job_options_t *opts) {
+    memset(opts, 0, sizeof(*opts));
+    
+    int i = 2;
+    for (; i < argc - 1 && strncmp(argv[i], "--", 2) == 0; i += 2) {
+        const char *value = argv[i + 1];
+        if (strcmp(argv[i], "--priority") == 0) {
+            opts->priority = atoi(value);
+        } else if (strcmp(argv[i], "--timeout") == 0) {
+            opts->timeout = atoi(value);
+        } else if (strcmp(argv[i], "--at") == 0) {
+            opts->run_at = (time_t)atol(value);
+        } else if (strcmp(argv[i], "--delay") == 0) {
+            opts->delay = atoi(value);
+        } else if (strcmp(argv[i], "--every") == 0) {
+            opts->every = atoi(value);
+        } else if (strcmp(argv[i], "--cron") == 0) {
+            snprintf(opts->cron, sizeof(opts->cron), "%s", value);
+        } else if (strcmp(argv[i], "--jitter") == 0) {
+            opts->jitter = atoi(value);
+        } else if (strcmp(argv[i], "--after") == 0) {
+            snprintf(opts->after, sizeof(opts->after), "%s", value);
+        } else if (strcmp(argv[i], "--deadline") == 0) {
+            opts->deadline = (time_t)atol(value);
+        } else if (strcmp(argv[i], "--due") == 0) {
+            opts->due = atoi(value);
+        } else if (strcmp(argv[i], "--hedge") == 0) {
+            opts->no_hedge = atoi(value) == 0;
+        } else if (strcmp(argv[i], "--needs") == 0) {
+            snprintf(opts->needs, sizeof(opts->needs), "%s", value);
+        } else if (strcmp(argv[i], "--batch") == 0) {
+            snprintf(opts->batch, sizeof(opts->batch), "%s", value);
+        } else if (strcmp(argv[i], "--key") == 0) {
+            snprintf(opts->key, sizeof(opts->key), "%s", value);
+        } else if (strcmp(argv[i], "--client") == 0) {
+            snprintf(opts->client, sizeof(opts->client), "%s", value);
+        } else {
+            printf("Opção desconhecida: %s\n", argv[i]);
+            return -1;
+        }
+    }
+    return i < argc ? i : -1;
+}
+
 void interactive_mode() {
     printf("Modo interativo - Ctrl+C para sair\n");
     
@@ -105,19 +431,55 @@ int main(int argc, char *argv[]) {
         return 1;
     }
     
-    if (argc < 2) {
+    // Opções globais antes do comando; depois delas argv[1] é o comando
+    const char *shard_spec = NULL;
+    int port = SERVER_PORT;
+    while (argc >= 3 && (strcmp(argv[1], "--shards") == 0 || strcmp(argv[1], "--port") == 0)) {
+        if (strcmp(argv[1], "--shards") == 0) {
+            shard_spec = argv[2];
+        } else {
+            port = atoi(argv[2]);
+        }
+        argv += 2;
+        argc -= 2;
+    }
+    
+    if (argc < 2 || shard_ring_configure(&shards, shard_spec, port) != 0) {
         print_usage();
         tslog_destroy(&logger);
         return 1;
     }
+    if (sched_client_init(&scheduler, &shards, NULL, &logger) != 0) {
+        fprintf(stderr, "Erro ao inicializar a biblioteca cliente\n");
+        tslog_destroy(&logger);
+        return 1;
+    }
     
     if (strcmp(argv[1], "submit") == 0) {
-        if (argc < 3) {
+        job_options_t opts;
+        int script = parse_submit_options(argc, argv, &opts);
+        if (script < 0) {
             printf("Erro: script não especificado\n");
             print_usage();
         } else {
-            submit_job(argv[2]);
+            submit_job_with_options(argv[script], &opts);
         }
+    } else if (strcmp(argv[1], "cancel") == 0 && argc >= 3) {
+        cancel_job(atoi(argv[2]));
+    } else if (strcmp(argv[1], "status") == 0 && argc >= 3) {
+        job_status(atoi(argv[2]));
+    } else if (strcmp(argv[1], "wait") == 0 && argc >= 3) {
+        wait_job(atoi(argv[2]), argc >= 4 ? atoi(argv[3]) : 0);
+    } else if (strcmp(argv[1], "load") == 0 && argc >= 4) {
+        load_jobs(atoi(argv[2]), argv[3]);
+    } else if (strcmp(argv[1], "watch") == 0 && argc >= 3) {
+        watch_topics(argc, argv);
+    } else if (strcmp(argv[1], "list") == 0) {
+        list_jobs(argc, argv);
+    } else if (strcmp(argv[1], "unschedule") == 0 && argc >= 3) {
+        unschedule_job(atoi(argv[2]));
+    } else if (strcmp(argv[1], "replication") == 0) {
+        replication_status();
     } else if (strcmp(argv[1], "interactive") == 0) {
         interactive_mode();
     } else {
@@ -125,6 +487,7 @@ int main(int argc, char *argv[]) {
         print_usage();
     }
     
+    sched_client_destroy(&scheduler);
     tslog_destroy(&logger);
     return 0;
 } 
\ No newline at end of file
@@ -5,129 +5,708 @@
 #include <sys/socket.h>
 #include <netinet/in.h>
 #include <arpa/inet.h>
-#include <unistd.h>
+#include <pthread.h>
+#include <stdint.h>
+#include <signal.h>
+#include <time.h>
+#include <stdatomic.h>
 #include "../common/protocol.h"
 #include "../common/job_executor.h"  
+#include "../common/shard_ring.h"
+#include "../common/local_transport.h"
+#include "../common/uring.h"
 #include "../../include/tslog.h"
-#define BUFFER_SIZE 4096
+#include "../../include/scheduler_client.h"
+#define BUFFER_SIZE PROTOCOL_LINE_MAX
+#define DEFAULT_SLOTS 2
+#define WORKER_MAX_PENDING 16   // igual a WORKER_MAX_SLOTS do servidor
+#define WORKER_CAPS_MAX 256     // igual a CAPABILITY_LIST_MAX do servidor
+#define WORKER_PULL_WAIT_MS 250 // espera numa shard depois de uma varredura vazia
+#define WORKER_RECONNECT_INTERVAL 5  // segundos entre tentativas numa shard caída
+
+typedef struct {
+    int job_id;
+    int lease_id;               // devolvido no resultado (ver lease_table.h)
+    char script[MAX_SCRIPT_SIZE];
+    int timeout;
+} worker_job_t;
 
 tslog_t logger;
+static line_reader_t reader;
+#ifdef SCHED_IO_URING
+static uring_conn_t *reader_io;         // recv multishot do socket do servidor
+#endif
+static pthread_mutex_t send_mutex = PTHREAD_MUTEX_INITIALIZER;
 
-int connect_to_server() {
-    int sock = socket(AF_INET, SOCK_STREAM, 0);
-    if (sock < 0) {
-        tslog_error(&logger, "Erro ao criar socket");
-        return -1;
+// Jobs recebidos e ainda não iniciados. O servidor nunca entrega mais que
+// `slots` jobs de uma vez; se o buffer transbordar mesmo assim, o job é
+// devolvido com JOB_REJECT.
+static worker_job_t pending[WORKER_MAX_PENDING];
+static int pending_head = 0, pending_count = 0;
+static int stopping = 0;
+static pthread_mutex_t pending_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t pending_cond = PTHREAD_COND_INITIALIZER;
+static int server_sock = -1;
+static int session = 0;         // muda a cada conexão do modo push
+// Jobs em execução, um por executor: CANCEL mata o grupo de processos
+typedef struct {
+    int job_id;                 // 0 = executor livre
+    pid_t pid;                  // 0 = ainda não iniciado
+    int cancelled;
+} running_job_t;
+static running_job_t running[WORKER_MAX_PENDING];
+// Capacidades anunciadas no registro: interpretadores detectados + --caps
+static char capabilities[WORKER_CAPS_MAX] = "";
+// Servidores: um só (push) ou várias shards (pull de todas, ver pull_loop)
+static shard_ring_t shards;
+// Modo push pelo socket local: jobs e resultados pelos anéis do canal de
+// memória compartilhada (ver local_transport.h)
+static shm_channel_t channel;
+static int shm_open_channel = 0;        // canal criado (SHM_ATTACH enviado)
+static atomic_int shm_active;           // servidor respondeu SHM_ATTACHED
+static atomic_int shm_stopping;
+static pthread_t shm_thread;
+static pthread_mutex_t shm_mutex = PTHREAD_MUTEX_INITIALIZER;   // consumidor do anel de jobs
+
+// Com várias shards o worker não se compromete com slots em nenhuma: cada
+// executor livre pede job (REQUEST_JOB) às shards em rodízio, uma conexão
+// registrada em modo pull por shard
+typedef struct {
+    const shard_t *shard;
+    int sock;                   // -1 = desconectada
+    int generation;             // muda a cada reconexão
+    line_reader_t reader;
+    pthread_mutex_t exchange;   // um REQUEST_JOB e sua resposta por vez
+    time_t retry_at;            // próxima tentativa de reconexão
+} shard_conn_t;
+static shard_conn_t conns[SHARD_MAX];
+static int conn_count = 0;
+
+// Loop principal, executores e thread de heartbeat escrevem no mesmo socket
+static int send_line(int sock, const char *line) {
+    pthread_mutex_lock(&send_mutex);
+    int rc = protocol_send_line(sock, line);
+    pthread_mutex_unlock(&send_mutex);
+    return rc;
+}
+
+// Mantém o worker vivo no servidor durante jobs longos
+static void* heartbeat_thread(void *arg) {
+    int sock = (int)(intptr_t)arg;
+    int mine = session;
+    
+    while (1) {
+        sleep(WORKER_HEARTBEAT_INTERVAL);
+        // Reconectou (failover): o descritor antigo pode ser de outra conexão
+        if (mine != session || send_line(sock, "HEARTBEAT") != 0) break;
     }
+    return NULL;
+}
+
+int connect_to_server(const shard_t *shard) {
+    return sched_connect(shard, &logger);
+}
+
+static void add_capability(const char *tag) {
+    size_t len = strlen(capabilities);
+    snprintf(capabilities + len, sizeof(capabilities) - len, "%s%s", len ? "," : "", tag);
+}
+
+// Interpretadores que o executor usa (ver protocol_script_runtime): anuncia o
+// nome e a versão, ex. "python3,python3.11" ou "lua,lua5.4"
+static void detect_runtime(const char *name, const char *command, const char *format,
+                           const char *version_prefix) {
+    FILE *fp = popen(command, "r");
+    if (!fp) return;
     
-    struct sockaddr_in server_addr;
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_port = htons(SERVER_PORT);
+    char line[128] = "";
+    int major = 0, minor = 0;
+    int found = fgets(line, sizeof(line), fp) != NULL && sscanf(line, format, &major, &minor) == 2;
+    int status = pclose(fp);
+    if (!found || status != 0) return;
     
-    if (inet_pton(AF_INET, "127.0.0.1", &server_addr.sin_addr) <= 0) {
-        tslog_error(&logger, "Endereço inválido");
-        close(sock);
-        return -1;
+    char tag[64];
+    snprintf(tag, sizeof(tag), "%s%d.%d", version_prefix, major, minor);
+    add_capability(name);
+    add_capability(tag);
+}
+
+// slots = 0: modo pull (o worker pede cada job com REQUEST_JOB)
+#ifdef SCHED_IO_URING
+// Passa a leitura do socket do modo push para um recv multishot (io_uring).
+// Só a leitura: as escritas continuam diretas, sob send_mutex. O socket
+// local fica com read, por causa dos descritores de SHM_ATTACH, e as
+// conexões pull também: elas passam de um executor para outro e o anel
+// só deve ser usado pela thread que armou o recv.
+static uring_conn_t *reader_attach_uring(line_reader_t *lr, int sock) {
+    if (local_is_unix(sock) || !uring_available()) return NULL;
+    uring_conn_t *io = malloc(sizeof(uring_conn_t));
+    if (!io || uring_conn_init(io, sock) != 0) {
+        free(io);
+        return NULL;
     }
+    line_reader_set_source(lr, uring_conn_fill, io);
+    return io;
+}
+
+static void reader_detach_uring(uring_conn_t **io) {
+    if (*io) {
+        uring_conn_destroy(*io);
+        free(*io);
+        *io = NULL;
+    }
+}
+#endif
+
+int register_worker(int sock, line_reader_t *reader, int slots) {
+    char hostname[64] = "localhost";
+    gethostname(hostname, sizeof(hostname) - 1);
     
-    if (connect(sock, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        tslog_error(&logger, "Erro ao conectar com servidor");
-        close(sock);
-        return -1;
+    char message[BUFFER_SIZE];
+    snprintf(message, BUFFER_SIZE, "REGISTER_WORKER:%s:%d:%s", hostname, slots, capabilities);
+    send_line(sock, message);
+    
+    char response[BUFFER_SIZE];
+    int worker_id = 0;
+    if (line_reader_next(reader, sock, response, sizeof(response)) > 0 &&
+        sscanf(response, "REGISTERED:%d", &worker_id) == 1) {
+        tslog_info(&logger, "Worker %d registrado no servidor (%d slots, capacidades [%s])",
+                   worker_id, slots, capabilities);
+        return worker_id;
     }
     
-    tslog_info(&logger, "Conectado ao servidor");
-    return sock;
+    tslog_error(&logger, "Registro recusado pelo servidor");
+    return -1;
+}
+
+// "JOB:<id>:<lease>:<script escapado>:<timeout>"
+static int parse_job(const char *line, worker_job_t *job) {
+    char payload[BUFFER_SIZE];
+    int offset = 0;
+    
+    if (sscanf(line, "JOB:%d:%d:%n", &job->job_id, &job->lease_id, &offset) != 2) return -1;
+    
+    // O script vai até o último ':' (seguido do timeout)
+    snprintf(payload, sizeof(payload), "%s", line + offset);
+    char *last = strrchr(payload, ':');
+    job->timeout = 30;
+    if (last) {
+        *last = '\0';
+        job->timeout = atoi(last + 1);
+    }
+    protocol_unescape(payload);
+    strncpy(job->script, payload, MAX_SCRIPT_SIZE - 1);
+    job->script[MAX_SCRIPT_SIZE - 1] = '\0';
+    return 0;
 }
 
-void register_worker(int sock) {
+static void format_job_result(char *message, size_t size, const worker_job_t *job, int success,
+                              const char *output, double exec_time) {
+    char escaped[MAX_RESULT_SIZE * 2];
+    protocol_escape(output, escaped, sizeof(escaped));
+    snprintf(message, size, "JOB_RESULT:%d:%d:%d:%.2f:%s", job->job_id, job->lease_id, success, exec_time,
+             escaped);
+}
+
+void send_job_result(int sock, const worker_job_t *job, int success, const char *output, double exec_time) {
+    // Anel de resultados: sem escape e sem passar pelo socket (cheio: a linha)
+    if (atomic_load(&shm_active)) {
+        pthread_mutex_lock(&send_mutex);
+        int rc = shm_channel_push_result(&channel, job->job_id, job->lease_id, success, exec_time, output);
+        pthread_mutex_unlock(&send_mutex);
+        if (rc == 0) {
+            tslog_info(&logger, "Resultado do job %d enviado", job->job_id);
+            return;
+        }
+    }
+    
     char message[BUFFER_SIZE];
-    snprintf(message, BUFFER_SIZE, "REGISTER_WORKER");
-    write(sock, message, strlen(message));
-    tslog_info(&logger, "Worker registrado no servidor");
+    format_job_result(message, sizeof(message), job, success, output, exec_time);
+    
+    send_line(sock, message);
+    tslog_info(&logger, "Resultado do job %d enviado", job->job_id);
 }
 
-int request_job(int sock) {
-    char message[BUFFER_SIZE] = "REQUEST_JOB";
-    write(sock, message, strlen(message));
+static void job_started(pid_t pid, void *arg) {
+    running_job_t *slot = (running_job_t*)arg;
+    pthread_mutex_lock(&pending_mutex);
+    slot->pid = pid;
+    if (slot->cancelled) {
+        kill(-pid, SIGKILL);
+    }
+    pthread_mutex_unlock(&pending_mutex);
+}
+
+// CANCEL:<id> do servidor: a cópia especulativa perdeu (ou vice-versa)
+static void cancel_job(int job_id) {
+    int found = 0;
     
-    char response[BUFFER_SIZE];
-    ssize_t bytes_read = read(sock, response, BUFFER_SIZE - 1);
+    pthread_mutex_lock(&pending_mutex);
+    for (int i = 0; i < pending_count; i++) {
+        int index = (pending_head + i) % WORKER_MAX_PENDING;
+        if (pending[index].job_id == job_id) {
+            // Ainda não começou: sai da fila local preservando a ordem
+            for (int j = i; j < pending_count - 1; j++) {
+                pending[(pending_head + j) % WORKER_MAX_PENDING] =
+                    pending[(pending_head + j + 1) % WORKER_MAX_PENDING];
+            }
+            pending_count--;
+            found = 1;
+            break;
+        }
+    }
+    for (int i = 0; i < WORKER_MAX_PENDING && !found; i++) {
+        if (running[i].job_id == job_id) {
+            running[i].cancelled = 1;
+            if (running[i].pid > 0) {
+                kill(-running[i].pid, SIGKILL);
+            }
+            found = 1;
+        }
+    }
+    pthread_mutex_unlock(&pending_mutex);
     
-    if (bytes_read <= 0) {
-        return -1;
+    if (found) {
+        tslog_info(&logger, "Job %d cancelado pelo servidor", job_id);
     }
+}
+
+// Executa o job já marcado no slot; retorna -1 se foi cancelado no caminho
+static int run_job(running_job_t *slot, const worker_job_t *job, char *output, size_t size,
+                   int *success, double *exec_time) {
+    tslog_info(&logger, "Executando job %d: %.80s", job->job_id, job->script);
     
-    response[bytes_read] = '\0';
+    *exec_time = execute_script_tracked(job->script, output, size, job->timeout, success,
+                                        job_started, slot);
     
-    if (strncmp(response, "JOB:", 4) == 0) {
-        int job_id;
-        char script[MAX_SCRIPT_SIZE];
-        int timeout;
-        
-        sscanf(response, "JOB:%d:%[^:]:%d", &job_id, script, &timeout);
-        tslog_info(&logger, "Job recebido: ID=%d, Script=%s", job_id, script);
+    pthread_mutex_lock(&pending_mutex);
+    int cancelled = slot->cancelled;
+    slot->job_id = 0;
+    slot->pid = 0;
+    pthread_mutex_unlock(&pending_mutex);
+    return cancelled ? -1 : 0;
+}
+
+static void* executor_thread(void *arg) {
+    running_job_t *slot = (running_job_t*)arg;
+    
+    while (1) {
+        pthread_mutex_lock(&pending_mutex);
+        while (pending_count == 0 && !stopping) {
+            pthread_cond_wait(&pending_cond, &pending_mutex);
+        }
+        if (pending_count == 0) {
+            pthread_mutex_unlock(&pending_mutex);
+            break;
+        }
+        worker_job_t job = pending[pending_head];
+        pending_head = (pending_head + 1) % WORKER_MAX_PENDING;
+        pending_count--;
+        slot->job_id = job.job_id;
+        slot->pid = 0;
+        slot->cancelled = 0;
+        pthread_mutex_unlock(&pending_mutex);
         
-        return job_id;
-    } else if (strcmp(response, "NO_JOBS") == 0) {
-        tslog_debug(&logger, "Nenhum job disponível");
-        return 0;
+        char output[MAX_RESULT_SIZE];
+        int success;
+        double exec_time;
+        // O servidor já liberou o slot de um job cancelado e não espera mais o resultado
+        if (run_job(slot, &job, output, sizeof(output), &success, &exec_time) == 0) {
+            send_job_result(server_sock, &job, success, output, exec_time);
+        }
     }
+    return NULL;
+}
+
+static void enqueue_job(const worker_job_t *job) {
+    pthread_mutex_lock(&pending_mutex);
+    int full = pending_count >= WORKER_MAX_PENDING;
+    if (!full) {
+        pending[(pending_head + pending_count) % WORKER_MAX_PENDING] = *job;
+        pending_count++;
+        pthread_cond_signal(&pending_cond);
+    }
+    pthread_mutex_unlock(&pending_mutex);
     
-    return -1;
+    // Sem slot livre: o servidor devolve o job à fila na hora, sem esperar o lease vencer
+    if (full) {
+        char line[64];
+        snprintf(line, sizeof(line), "JOB_REJECT:%d:%d", job->job_id, job->lease_id);
+        send_line(server_sock, line);
+        tslog_warn(&logger, "Job %d recebido sem slot livre - devolvido ao servidor", job->job_id);
+    }
 }
 
-void send_job_result(int sock, int job_id, int success, const char *output, double exec_time) {
-    char message[BUFFER_SIZE];
-    snprintf(message, BUFFER_SIZE, "JOB_RESULT:%d:%d:%.2f:%s", 
-             job_id, success, exec_time, output);
+/* ---- Canal de memória compartilhada (modo push, socket local) ---- */
+
+static void shm_drain_jobs(void) {
+    worker_job_t job;
+    pthread_mutex_lock(&shm_mutex);
+    while (shm_channel_pop_job(&channel, &job.job_id, &job.lease_id, job.script, sizeof(job.script),
+                               &job.timeout) == 1) {
+        tslog_info(&logger, "Job recebido: ID=%d", job.job_id);
+        enqueue_job(&job);
+    }
+    pthread_mutex_unlock(&shm_mutex);
+}
+
+static void* shm_job_reader(void *arg) {
+    (void)arg;
+    while (shm_channel_wait(channel.job_event) == 0 && !atomic_load(&shm_stopping)) {
+        shm_drain_jobs();
+    }
+    return NULL;
+}
+
+// Cria o canal e o oferece ao servidor; sem canal o worker segue pelo socket
+static void shm_start(int sock) {
+    if (shm_channel_create(&channel) != 0) {
+        tslog_warn(&logger, "Memória compartilhada indisponível: jobs pelo socket");
+        return;
+    }
+    atomic_store(&shm_stopping, 0);
+    if (pthread_create(&shm_thread, NULL, shm_job_reader, NULL) != 0) {
+        shm_channel_close(&channel);
+        return;
+    }
+    shm_open_channel = 1;
     
-    write(sock, message, strlen(message));
-    tslog_info(&logger, "Resultado do job %d enviado", job_id);
+    int fds[SHM_CHANNEL_FDS];
+    shm_channel_fds(&channel, fds);
+    pthread_mutex_lock(&send_mutex);
+    local_send_line_fds(sock, "SHM_ATTACH", fds, SHM_CHANNEL_FDS);
+    pthread_mutex_unlock(&send_mutex);
 }
 
-void worker_loop() {
-    int sock = connect_to_server();
-    if (sock < 0) return;
+// Conexão caiu ou servidor recusou: nenhum executor usa o canal depois daqui
+static void shm_stop(void) {
+    if (!shm_open_channel) return;
+    pthread_mutex_lock(&send_mutex);
+    atomic_store(&shm_active, 0);
+    pthread_mutex_unlock(&send_mutex);
     
-    register_worker(sock);
+    atomic_store(&shm_stopping, 1);
+    shm_channel_wake(channel.job_event);
+    pthread_join(shm_thread, NULL);
+    shm_channel_close(&channel);
+    shm_open_channel = 0;
+}
+
+// Modo push: o servidor escolhe o worker e envia JOB quando há slot livre.
+// Retorna -1 se não conectou ou o registro foi recusado, 0 se a conexão caiu.
+int worker_loop(const shard_t *shard, int slots) {
+    int sock = connect_to_server(shard);
+    if (sock < 0) return -1;
+    server_sock = sock;
+    session++;
     
-    while (1) {
-        int job_id = request_job(sock);
-        
-    if (job_id > 0) {
-    char output[MAX_RESULT_SIZE];
-    double exec_time;
+    line_reader_init(&reader);
+    if (register_worker(sock, &reader, slots) < 0) {
+        close(sock);
+        return -1;
+    }
+    
+    pthread_mutex_lock(&pending_mutex);
+    stopping = 0;
+    pending_head = 0;
+    pending_count = 0;
+    pthread_mutex_unlock(&pending_mutex);
+    
+    pthread_t heartbeat;
+    if (pthread_create(&heartbeat, NULL, heartbeat_thread, (void*)(intptr_t)sock) == 0) {
+        pthread_detach(heartbeat);
+    }
+    
+    pthread_t executors[WORKER_MAX_PENDING];
+    int started = 0;
+    for (int i = 0; i < slots; i++) {
+        if (pthread_create(&executors[started], NULL, executor_thread, &running[started]) == 0) {
+            started++;
+        }
+    }
+    
+    if (local_is_unix(sock)) {
+        shm_start(sock);
+    }
+#ifdef SCHED_IO_URING
+    reader_io = reader_attach_uring(&reader, sock);
+#endif
+    
+    char line[BUFFER_SIZE];
+    while (line_reader_next(&reader, sock, line, sizeof(line)) >= 0) {
+        worker_job_t job;
+        if (strncmp(line, "JOB:", 4) == 0 && parse_job(line, &job) == 0) {
+            tslog_info(&logger, "Job recebido: ID=%d", job.job_id);
+            enqueue_job(&job);
+        } else if (strncmp(line, "CANCEL:", 7) == 0) {
+            // O JOB pode estar no anel ainda: ele foi escrito antes do CANCEL
+            if (shm_open_channel) shm_drain_jobs();
+            cancel_job(atoi(line + 7));
+        } else if (strcmp(line, "SHM_ATTACHED") == 0) {
+            atomic_store(&shm_active, 1);
+            tslog_info(&logger, "Jobs e resultados pela memória compartilhada");
+        } else if (strcmp(line, "SHM_REFUSED") == 0) {
+            tslog_warn(&logger, "Servidor recusou a memória compartilhada: jobs pelo socket");
+            shm_stop();
+        }
+    }
+    tslog_error(&logger, "Conexão com servidor perdida");
+    
+    pthread_mutex_lock(&pending_mutex);
+    stopping = 1;
+    pending_count = 0;   // o servidor trata os não iniciados como órfãos: nova tentativa com backoff
+    pthread_cond_broadcast(&pending_cond);
+    pthread_mutex_unlock(&pending_mutex);
+    
+    for (int i = 0; i < started; i++) {
+        pthread_join(executors[i], NULL);
+    }
+    shm_stop();
+#ifdef SCHED_IO_URING
+    reader_detach_uring(&reader_io);
+#endif
+    
+    close(sock);
+    return 0;
+}
+
+/* ---- Várias shards (pull) ---- */
+
+// Conecta e registra em modo pull. Chamar com conn->exchange.
+static int conn_open(shard_conn_t *conn) {
+    time_t now = time(NULL);
+    if (now < conn->retry_at) return -1;
+    conn->retry_at = now + WORKER_RECONNECT_INTERVAL;
+    
+    int sock = connect_to_server(conn->shard);
+    if (sock < 0) return -1;
+    line_reader_init(&conn->reader);
+    if (register_worker(sock, &conn->reader, 0) < 0) {
+        // Standby ainda não promovido respondeu: na próxima, o outro endereço
+        shard_ring_failover(&shards, conn->shard);
+        close(sock);
+        return -1;
+    }
+    
+    pthread_mutex_lock(&send_mutex);
+    conn->sock = sock;
+    conn->generation++;
+    pthread_mutex_unlock(&send_mutex);
+    return 0;
+}
+
+// Fecha sob send_mutex: nenhum resultado é escrito num descritor reutilizado.
+// Chamar com conn->exchange.
+static void conn_drop(shard_conn_t *conn) {
+    tslog_error(&logger, "Conexão com a shard %d (%s:%d) perdida", conn->shard->number,
+                conn->shard->host, conn->shard->port);
+    pthread_mutex_lock(&send_mutex);
+    close(conn->sock);
+    conn->sock = -1;
+    pthread_mutex_unlock(&send_mutex);
+    conn->retry_at = time(NULL) + WORKER_RECONNECT_INTERVAL;
+}
+
+// Pede um job à shard esperando até wait_ms. Chamar com conn->exchange.
+// Retorna 1 com o job em *job, 0 se não havia, -1 se a shard está fora.
+static int pull_job(shard_conn_t *conn, int wait_ms, worker_job_t *job) {
+    if (conn->sock < 0 && conn_open(conn) != 0) return -1;
+    
+    char line[BUFFER_SIZE];
+    snprintf(line, sizeof(line), "REQUEST_JOB:%d", wait_ms);
+    if (send_line(conn->sock, line) != 0) {
+        conn_drop(conn);
+        return -1;
+    }
+    while (line_reader_next(&conn->reader, conn->sock, line, sizeof(line)) >= 0) {
+        if (line[0] == '\0') continue;
+        if (strncmp(line, "CANCEL:", 7) == 0) {
+            cancel_job(atoi(line + 7));
+            continue;
+        }
+        return strncmp(line, "JOB:", 4) == 0 && parse_job(line, job) == 0 ? 1 : 0;
+    }
+    conn_drop(conn);
+    return -1;
+}
+
+// O resultado volta pela conexão que entregou o job; se ela caiu depois, o
+// servidor já devolveu o job à fila e o resultado é descartado
+static void send_pull_result(shard_conn_t *conn, int generation, const worker_job_t *job,
+                             int success, const char *output, double exec_time) {
+    char message[BUFFER_SIZE];
+    format_job_result(message, sizeof(message), job, success, output, exec_time);
     
-    if (job_id % 2 == 0) {
-        exec_time = execute_script("print('Python Job', __import__('time').time())", 
-                                  output, sizeof(output), 30);
+    pthread_mutex_lock(&send_mutex);
+    int sent = conn->sock >= 0 && conn->generation == generation &&
+               protocol_send_line(conn->sock, message) == 0;
+    pthread_mutex_unlock(&send_mutex);
+    
+    if (sent) {
+        tslog_info(&logger, "Resultado do job %d enviado à shard %d", job->job_id, conn->shard->number);
     } else {
-        exec_time = execute_script("print('Lua Job', os.time())", 
-                                  output, sizeof(output), 30);
+        tslog_warn(&logger, "Resultado do job %d descartado: shard %d reconectada", job->job_id,
+                   conn->shard->number);
     }
+}
+
+static void* pull_heartbeat_thread(void *arg) {
+    (void)arg;
     
-    int success = (exec_time >= 0);
-    send_job_result(sock, job_id, success, output, exec_time);
+    while (1) {
+        sleep(WORKER_HEARTBEAT_INTERVAL);
+        pthread_mutex_lock(&send_mutex);
+        for (int i = 0; i < conn_count; i++) {
+            if (conns[i].sock >= 0) {
+                protocol_send_line(conns[i].sock, "HEARTBEAT");
+            }
+        }
+        pthread_mutex_unlock(&send_mutex);
+    }
+    return NULL;
 }
+
+// Executor livre: varre as shards sem esperar (REQUEST_JOB:0), começando
+// por uma diferente a cada volta, e pula as que outro executor está usando;
+// se nenhuma tinha job, espera um pouco numa delas
+static void* pull_executor_thread(void *arg) {
+    running_job_t *slot = (running_job_t*)arg;
+    int next = (int)(slot - running) % conn_count;
+    
+    while (1) {
+        worker_job_t job;
+        shard_conn_t *from = NULL;
+        int generation = 0;
+        
+        for (int i = 0; i < conn_count && !from; i++) {
+            shard_conn_t *conn = &conns[(next + i) % conn_count];
+            if (pthread_mutex_trylock(&conn->exchange) != 0) continue;
+            if (pull_job(conn, 0, &job) == 1) {
+                from = conn;
+                generation = conn->generation;
+            }
+            pthread_mutex_unlock(&conn->exchange);
+        }
+        if (!from) {
+            shard_conn_t *conn = &conns[next];
+            pthread_mutex_lock(&conn->exchange);
+            int rc = pull_job(conn, WORKER_PULL_WAIT_MS, &job);
+            if (rc == 1) {
+                from = conn;
+                generation = conn->generation;
+            }
+            pthread_mutex_unlock(&conn->exchange);
+            if (rc < 0) {
+                usleep(WORKER_PULL_WAIT_MS * 1000);
+            }
+        }
+        next = (next + 1) % conn_count;
+        if (!from) continue;
         
+        tslog_info(&logger, "Job recebido da shard %d: ID=%d", from->shard->number, job.job_id);
+        pthread_mutex_lock(&pending_mutex);
+        slot->job_id = job.job_id;
+        slot->pid = 0;
+        slot->cancelled = 0;
+        pthread_mutex_unlock(&pending_mutex);
+        
+        char output[MAX_RESULT_SIZE];
+        int success;
+        double exec_time;
+        if (run_job(slot, &job, output, sizeof(output), &success, &exec_time) == 0) {
+            send_pull_result(from, generation, &job, success, output, exec_time);
+        }
     }
+    return NULL;
+}
+
+void pull_loop(int slots) {
+    conn_count = shards.count;
+    for (int i = 0; i < conn_count; i++) {
+        conns[i].shard = &shards.shards[i];
+        conns[i].sock = -1;
+        pthread_mutex_init(&conns[i].exchange, NULL);
+        pthread_mutex_lock(&conns[i].exchange);
+        conn_open(&conns[i]);
+        pthread_mutex_unlock(&conns[i].exchange);
+    }
+    tslog_info(&logger, "Pull de %d shards com %d executores", conn_count, slots);
     
-    close(sock);
+    pthread_t heartbeat;
+    if (pthread_create(&heartbeat, NULL, pull_heartbeat_thread, NULL) == 0) {
+        pthread_detach(heartbeat);
+    }
+    
+    pthread_t executors[WORKER_MAX_PENDING];
+    int started = 0;
+    for (int i = 0; i < slots; i++) {
+        if (pthread_create(&executors[started], NULL, pull_executor_thread, &running[started]) == 0) {
+            started++;
+        }
+    }
+    for (int i = 0; i < started; i++) {
+        pthread_join(executors[i], NULL);
+    }
 }
 
 int main(int argc, char *argv[]) {
+    int slots = DEFAULT_SLOTS;
+    const char *extra_caps = NULL;
+    const char *shard_spec = NULL;
+    int port = SERVER_PORT;
+    
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--slots") == 0 && i + 1 < argc) {
+            slots = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--caps") == 0 && i + 1 < argc) {
+            extra_caps = argv[++i];
+        } else if (strcmp(argv[i], "--shards") == 0 && i + 1 < argc) {
+            shard_spec = argv[++i];
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else {
+            fprintf(stderr, "Uso: %s [--slots n] [--caps tag,tag] [--port porta | --shards [n=]host:porta[/host:porta],...]\n",
+                    argv[0]);
+            return 1;
+        }
+    }
+    if (shard_ring_configure(&shards, shard_spec, port) != 0) {
+        fprintf(stderr, "Lista de shards inválida\n");
+        return 1;
+    }
+    if (slots < 1) slots = 1;
+    if (slots > WORKER_MAX_PENDING) slots = WORKER_MAX_PENDING;
+    
     if (tslog_init(&logger, "worker.log", TSLOG_INFO) != 0) {
         fprintf(stderr, "Erro ao inicializar logger do worker\n");
         return 1;
     }
     
     tslog_info(&logger, "=== WORKER INICIADO ===");
-    tslog_info(&logger, "Worker pronto para processar jobs");
     
-    worker_loop();
+    detect_runtime("python3", "python3 --version 2>&1", "Python %d.%d", "python");
+    detect_runtime("lua", "lua -v 2>&1", "Lua %d.%d", "lua");
+    if (extra_caps && extra_caps[0]) {
+        add_capability(extra_caps);
+    }
+    tslog_info(&logger, "Worker pronto para processar jobs (%d slots)", slots);
+    
+    if (shards.count > 1) {
+        pull_loop(slots);
+    } else if (shards.shards[0].standby_host[0]) {
+        // Com standby o worker não termina com a conexão: volta ao primário
+        // ou, recusado ou fora do ar, tenta o outro servidor
+        while (1) {
+            if (worker_loop(&shards.shards[0], slots) < 0) {
+                shard_ring_failover(&shards, &shards.shards[0]);
+            }
+            sleep(WORKER_RECONNECT_INTERVAL);
+        }
+    } else {
+        worker_loop(&shards.shards[0], slots);
+    }
     
     tslog_info(&logger, "Worker finalizado");
     tslog_destroy(&logger);
     return 0;
-}
\ No newline at end of file
+}
@@ -1,26 +1,111 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <pthread.h>
 #include <sqlite3.h>
 #include "database.h"
 #include "../include/tslog.h"
 
 #define DB_FILE "scheduler.db"
+#define DB_FILE_MAX 256
+#define DB_READ_POOL_SIZE 4
+#define DB_BUSY_TIMEOUT_MS 5000
 
+static char db_file[DB_FILE_MAX] = DB_FILE;
+
+// Conexão única de escrita, serializada por db_write_mutex
 sqlite3 *db = NULL;
 tslog_t *db_logger = NULL;
+static pthread_mutex_t db_write_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Pool de conexões somente leitura. Com o journal em WAL cada leitura roda
+// sobre um snapshot próprio e nunca bloqueia (nem é bloqueada por) o escritor.
+static sqlite3 *read_pool[DB_READ_POOL_SIZE];
+static int read_free[DB_READ_POOL_SIZE];
+static int read_free_count = 0;
+static pthread_mutex_t read_pool_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t read_pool_available = PTHREAD_COND_INITIALIZER;
+
+static int read_pool_open(void) {
+    for (int i = 0; i < DB_READ_POOL_SIZE; i++) {
+        int rc = sqlite3_open_v2(db_file, &read_pool[i],
+                                 SQLITE_OPEN_READONLY | SQLITE_OPEN_NOMUTEX, NULL);
+        if (rc != SQLITE_OK) {
+            tslog_error(db_logger, "Não pode abrir conexão de leitura: %s", 
+                        sqlite3_errmsg(read_pool[i]));
+            sqlite3_close(read_pool[i]);
+            read_pool[i] = NULL;
+            return -1;
+        }
+        sqlite3_busy_timeout(read_pool[i], DB_BUSY_TIMEOUT_MS);
+        read_free[read_free_count++] = i;
+    }
+    
+    tslog_info(db_logger, "Pool de leitura aberto (%d conexões)", DB_READ_POOL_SIZE);
+    return 0;
+}
+
+static void read_pool_close(void) {
+    pthread_mutex_lock(&read_pool_mutex);
+    for (int i = 0; i < DB_READ_POOL_SIZE; i++) {
+        if (read_pool[i]) {
+            sqlite3_close(read_pool[i]);
+            read_pool[i] = NULL;
+        }
+    }
+    read_free_count = 0;
+    pthread_mutex_unlock(&read_pool_mutex);
+}
+
+// Retira uma conexão do pool e abre uma transação de leitura (snapshot)
+static sqlite3 *read_acquire(int *slot) {
+    pthread_mutex_lock(&read_pool_mutex);
+    while (read_free_count == 0) {
+        pthread_cond_wait(&read_pool_available, &read_pool_mutex);
+    }
+    *slot = read_free[--read_free_count];
+    sqlite3 *conn = read_pool[*slot];
+    pthread_mutex_unlock(&read_pool_mutex);
+    
+    if (conn) {
+        sqlite3_exec(conn, "BEGIN;", NULL, NULL, NULL);
+    }
+    return conn;
+}
+
+static void read_release(int slot) {
+    sqlite3 *conn = read_pool[slot];
+    if (conn) {
+        sqlite3_exec(conn, "COMMIT;", NULL, NULL, NULL);
+    }
+    
+    pthread_mutex_lock(&read_pool_mutex);
+    read_free[read_free_count++] = slot;
+    pthread_cond_signal(&read_pool_available);
+    pthread_mutex_unlock(&read_pool_mutex);
+}
+
+void database_set_file(const char *path) {
+    if (path && path[0]) {
+        snprintf(db_file, sizeof(db_file), "%s", path);
+    }
+}
 
 int database_init(tslog_t *logger) {
     int rc;
     db_logger = logger;
     
-    rc = sqlite3_open(DB_FILE, &db);
+    rc = sqlite3_open(db_file, &db);
     if (rc) {
         tslog_error(db_logger, "Não pode abrir database: %s", sqlite3_errmsg(db));
         return -1;
     }
     
-    tslog_info(db_logger, "Database SQLite aberto: %s", DB_FILE);
+    tslog_info(db_logger, "Database SQLite aberto: %s", db_file);
+    
+    // WAL permite leitores concorrentes com o escritor
+    sqlite3_busy_timeout(db, DB_BUSY_TIMEOUT_MS);
+    sqlite3_exec(db, "PRAGMA journal_mode=WAL; PRAGMA synchronous=NORMAL;", NULL, NULL, NULL);
     
     // Criar tabelas se não existirem
     const char *sql = 
@@ -46,7 +131,52 @@ int database_init(tslog_t *logger) {
         "registered_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
         "last_heartbeat DATETIME,"
         "is_active INTEGER DEFAULT 1"
-        ");";
+        ");"
+
+        // Resumo incremental das estatísticas (ver job_stats.c)
+        "CREATE TABLE IF NOT EXISTS job_stats_summary ("
+        "scope TEXT NOT NULL,"
+        "key INTEGER NOT NULL,"
+        "submitted INTEGER NOT NULL,"
+        "started INTEGER NOT NULL,"
+        "completed INTEGER NOT NULL,"
+        "failed INTEGER NOT NULL,"
+        "exec_time_us INTEGER NOT NULL,"
+        "histogram TEXT NOT NULL,"
+        "updated_at DATETIME DEFAULT CURRENT_TIMESTAMP,"
+        "PRIMARY KEY (scope, key)"
+        ");"
+
+        // Jobs adiados e recorrentes ainda por disparar
+        "CREATE TABLE IF NOT EXISTS schedules ("
+        "schedule_id INTEGER PRIMARY KEY,"
+        "script TEXT NOT NULL,"
+        "priority INTEGER NOT NULL,"
+        "timeout INTEGER NOT NULL,"
+        "next_run INTEGER NOT NULL,"
+        "every INTEGER NOT NULL DEFAULT 0,"
+        "cron TEXT,"
+        "jitter INTEGER NOT NULL DEFAULT 0,"
+        "created_at DATETIME DEFAULT CURRENT_TIMESTAMP"
+        ");"
+
+        // Conjuntos de capacidades já anunciados por workers (ver capability.h)
+        "CREATE TABLE IF NOT EXISTS worker_profiles ("
+        "tags TEXT PRIMARY KEY,"
+        "first_seen DATETIME DEFAULT CURRENT_TIMESTAMP"
+        ");"
+
+        // Chaves de idempotência das submissões (ver idempotency.h)
+        "CREATE TABLE IF NOT EXISTS idempotency_keys ("
+        "key TEXT PRIMARY KEY,"
+        "kind INTEGER NOT NULL,"
+        "id INTEGER NOT NULL,"
+        "first_run INTEGER NOT NULL DEFAULT 0,"
+        "expires_at INTEGER NOT NULL"
+        ");"
+
+        "CREATE INDEX IF NOT EXISTS idx_idempotency_expires ON idempotency_keys(expires_at);"
+        "CREATE INDEX IF NOT EXISTS idx_jobs_job_id ON jobs(job_id);";
     
     char *err_msg = NULL;
     rc = sqlite3_exec(db, sql, NULL, 0, &err_msg);
@@ -58,22 +188,46 @@ int database_init(tslog_t *logger) {
         return -1;
     }
     
+    // Colunas adicionadas depois da primeira versão do esquema: em bancos
+    // antigos o ALTER cria a coluna, nos novos falha com "duplicate column"
+    sqlite3_exec(db, "ALTER TABLE jobs ADD COLUMN attempts INTEGER DEFAULT 0;", NULL, 0, NULL);
+    sqlite3_exec(db, "ALTER TABLE jobs ADD COLUMN client TEXT;", NULL, 0, NULL);
+    sqlite3_exec(db, "ALTER TABLE schedules ADD COLUMN client TEXT;", NULL, 0, NULL);
+    sqlite3_exec(db, "ALTER TABLE jobs ADD COLUMN needs TEXT;", NULL, 0, NULL);
+    sqlite3_exec(db, "ALTER TABLE schedules ADD COLUMN needs TEXT;", NULL, 0, NULL);
+    sqlite3_exec(db, "ALTER TABLE jobs ADD COLUMN deadline INTEGER;", NULL, 0, NULL);
+    sqlite3_exec(db, "ALTER TABLE schedules ADD COLUMN no_hedge INTEGER DEFAULT 0;", NULL, 0, NULL);
+    
     tslog_info(db_logger, "Tabelas do database criadas/verificadas");
+    
+    // O pool só é aberto depois que o arquivo e as tabelas existem
+    if (read_pool_open() != 0) {
+        read_pool_close();
+        sqlite3_close(db);
+        db = NULL;
+        return -1;
+    }
     return 0;
 }
 
 void database_close() {
+    read_pool_close();
+    
+    pthread_mutex_lock(&db_write_mutex);
     if (db) {
         sqlite3_close(db);
+        db = NULL;
         tslog_info(db_logger, "Database fechado");
     }
+    pthread_mutex_unlock(&db_write_mutex);
 }
 
-int database_save_job(const job_t *job) {
+static int save_job_locked(const job_t *job) {
     if (!db || !job) return -1;
     
-    const char *sql = "INSERT INTO jobs (job_id, script, priority, timeout, status, submitted_at) "
-                     "VALUES (?, ?, ?, ?, ?, datetime('now'));";
+    // OR IGNORE: um standby recebe de novo os jobs vivos a cada ressincronização
+    const char *sql = "INSERT OR IGNORE INTO jobs (job_id, script, priority, timeout, status, client, needs, deadline, submitted_at) "
+                     "VALUES (?, ?, ?, ?, ?, ?, ?, ?, datetime('now'));";
     
     sqlite3_stmt *stmt;
     int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
@@ -88,6 +242,13 @@ int database_save_job(const job_t *job) {
     sqlite3_bind_int(stmt, 3, job->priority);
     sqlite3_bind_int(stmt, 4, job->timeout);
     sqlite3_bind_int(stmt, 5, job->status);
+    sqlite3_bind_text(stmt, 6, job->client, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 7, job->needs, -1, SQLITE_STATIC);
+    if (job->deadline) {
+        sqlite3_bind_int64(stmt, 8, (sqlite3_int64)job->deadline);
+    } else {
+        sqlite3_bind_null(stmt, 8);
+    }
     
     rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
@@ -97,11 +258,18 @@ int database_save_job(const job_t *job) {
         return -1;
     }
     
-    tslog_debug(db_logger, "Job %d salvo no database", job->job_id);
+    tslog_debug_limited(db_logger, "database", "Job %d salvo no database", job->job_id);
     return 0;
 }
 
-int database_update_job_result(int job_id, int success, const char *result, double exec_time) {
+int database_save_job(const job_t *job) {
+    pthread_mutex_lock(&db_write_mutex);
+    int rc = save_job_locked(job);
+    pthread_mutex_unlock(&db_write_mutex);
+    return rc;
+}
+
+static int update_job_result_locked(int job_id, int success, const char *result, double exec_time) {
     if (!db) return -1;
     
     const char *sql = "UPDATE jobs SET completed_at = datetime('now'), result_text = ?, "
@@ -129,17 +297,22 @@ int database_update_job_result(int job_id, int success, const char *result, doub
         return -1;
     }
     
-    tslog_debug(db_logger, "Resultado do job %d atualizado no database", job_id);
+    tslog_debug_limited(db_logger, "database", "Resultado do job %d atualizado no database", job_id);
     return 0;
 }
 
-int database_get_job_stats(int *total, int *completed, int *failed, double *avg_time) {
+int database_update_job_result(int job_id, int success, const char *result, double exec_time) {
+    pthread_mutex_lock(&db_write_mutex);
+    int rc = update_job_result_locked(job_id, success, result, exec_time);
+    pthread_mutex_unlock(&db_write_mutex);
+    return rc;
+}
+
+static int update_job_status_locked(int job_id, job_status_t status, int attempts, const char *reason) {
     if (!db) return -1;
     
-    const char *sql = "SELECT COUNT(*), "
-                     "SUM(CASE WHEN success = 1 THEN 1 ELSE 0 END), "
-                     "SUM(CASE WHEN success = 0 THEN 1 ELSE 0 END), "
-                     "AVG(execution_time) FROM jobs WHERE success IS NOT NULL;";
+    const char *sql = "UPDATE jobs SET completed_at = datetime('now'), result_text = ?, "
+                     "status = ?, attempts = ?, success = 0 WHERE job_id = ?;";
     
     sqlite3_stmt *stmt;
     int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
@@ -149,14 +322,559 @@ int database_get_job_stats(int *total, int *completed, int *failed, double *avg_
         return -1;
     }
     
+    sqlite3_bind_text(stmt, 1, reason, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 2, status);
+    sqlite3_bind_int(stmt, 3, attempts);
+    sqlite3_bind_int(stmt, 4, job_id);
+    
+    rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    if (rc != SQLITE_DONE) {
+        tslog_error(db_logger, "Erro atualizando status do job: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+    return 0;
+}
+
+int database_update_job_status(int job_id, job_status_t status, int attempts, const char *reason) {
+    pthread_mutex_lock(&db_write_mutex);
+    int rc = update_job_status_locked(job_id, status, attempts, reason);
+    pthread_mutex_unlock(&db_write_mutex);
+    return rc;
+}
+
+int database_get_job_stats(int *total, int *completed, int *failed, double *avg_time) {
+    if (!db) return -1;
+    
+    int slot;
+    sqlite3 *conn = read_acquire(&slot);
+    if (!conn) return -1;
+    
+    // Lê a linha agregada mantida por job_stats_persist em vez de varrer a tabela jobs
+    const char *sql = "SELECT completed + failed, completed, failed, exec_time_us "
+                     "FROM job_stats_summary WHERE scope = 'total' AND key = 0;";
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(conn, sql, -1, &stmt, NULL);
+    
+    if (rc != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(conn));
+        read_release(slot);
+        return -1;
+    }
+    
+    *total = 0;
+    *completed = 0;
+    *failed = 0;
+    *avg_time = 0.0;
+    
     rc = sqlite3_step(stmt);
     if (rc == SQLITE_ROW) {
         *total = sqlite3_column_int(stmt, 0);
         *completed = sqlite3_column_int(stmt, 1);
         *failed = sqlite3_column_int(stmt, 2);
-        *avg_time = sqlite3_column_double(stmt, 3);
+        if (*total > 0) {
+            *avg_time = sqlite3_column_int64(stmt, 3) / 1e6 / *total;
+        }
+    }
+    
+    sqlite3_finalize(stmt);
+    read_release(slot);
+    return 0;
+}
+
+static int save_stats_locked(const job_stats_row_t *rows, int count) {
+    if (!db || !rows) return -1;
+    
+    const char *sql = "INSERT OR REPLACE INTO job_stats_summary "
+                     "(scope, key, submitted, started, completed, failed, exec_time_us, histogram, updated_at) "
+                     "VALUES (?, ?, ?, ?, ?, ?, ?, ?, datetime('now'));";
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    
+    if (rc != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+    
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    
+    for (int i = 0; i < count; i++) {
+        const job_stats_snapshot_t *snap = &rows[i].snap;
+        char histogram[JOB_STATS_HIST_BUCKETS * 21];
+        size_t off = 0;
+        
+        for (int b = 0; b < JOB_STATS_HIST_BUCKETS; b++) {
+            off += snprintf(histogram + off, sizeof(histogram) - off, 
+                            b ? ",%ld" : "%ld", snap->hist[b]);
+        }
+        
+        sqlite3_bind_text(stmt, 1, rows[i].scope, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, rows[i].key);
+        sqlite3_bind_int64(stmt, 3, snap->submitted);
+        sqlite3_bind_int64(stmt, 4, snap->started);
+        sqlite3_bind_int64(stmt, 5, snap->completed);
+        sqlite3_bind_int64(stmt, 6, snap->failed);
+        sqlite3_bind_int64(stmt, 7, snap->exec_time_us);
+        sqlite3_bind_text(stmt, 8, histogram, -1, SQLITE_TRANSIENT);
+        
+        rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        
+        if (rc != SQLITE_DONE) {
+            tslog_error(db_logger, "Erro salvando estatísticas: %s", sqlite3_errmsg(db));
+            sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+            sqlite3_finalize(stmt);
+            return -1;
+        }
+    }
+    
+    sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+    sqlite3_finalize(stmt);
+    
+    tslog_debug(db_logger, "%d linhas de estatísticas persistidas", count);
+    return 0;
+}
+
+int database_save_stats(const job_stats_row_t *rows, int count) {
+    pthread_mutex_lock(&db_write_mutex);
+    int rc = save_stats_locked(rows, count);
+    pthread_mutex_unlock(&db_write_mutex);
+    return rc;
+}
+
+int database_load_stats(void (*callback)(const job_stats_row_t *row, void *arg), void *arg) {
+    if (!db || !callback) return -1;
+    
+    int slot;
+    sqlite3 *conn = read_acquire(&slot);
+    if (!conn) return -1;
+    
+    const char *sql = "SELECT scope, key, submitted, started, completed, failed, "
+                     "exec_time_us, histogram FROM job_stats_summary;";
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(conn, sql, -1, &stmt, NULL);
+    
+    if (rc != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(conn));
+        read_release(slot);
+        return -1;
+    }
+    
+    int count = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        job_stats_row_t row;
+        memset(&row, 0, sizeof(row));
+        
+        snprintf(row.scope, sizeof(row.scope), "%s", (const char*)sqlite3_column_text(stmt, 0));
+        row.key = sqlite3_column_int(stmt, 1);
+        row.snap.submitted = sqlite3_column_int64(stmt, 2);
+        row.snap.started = sqlite3_column_int64(stmt, 3);
+        row.snap.completed = sqlite3_column_int64(stmt, 4);
+        row.snap.failed = sqlite3_column_int64(stmt, 5);
+        row.snap.exec_time_us = sqlite3_column_int64(stmt, 6);
+        
+        const char *histogram = (const char*)sqlite3_column_text(stmt, 7);
+        for (int b = 0; b < JOB_STATS_HIST_BUCKETS && histogram && *histogram; b++) {
+            char *end;
+            row.snap.hist[b] = strtol(histogram, &end, 10);
+            histogram = (*end == ',') ? end + 1 : end;
+        }
+        
+        callback(&row, arg);
+        count++;
+    }
+    
+    sqlite3_finalize(stmt);
+    read_release(slot);
+    tslog_info(db_logger, "%d linhas de estatísticas carregadas", count);
+    return 0;
+}
+
+static void fill_job_record(sqlite3_stmt *stmt, job_record_t *rec) {
+    memset(rec, 0, sizeof(*rec));
+    rec->job_id = sqlite3_column_int(stmt, 0);
+    snprintf(rec->script, sizeof(rec->script), "%s", 
+             (const char*)sqlite3_column_text(stmt, 1));
+    rec->priority = sqlite3_column_int(stmt, 2);
+    rec->status = sqlite3_column_int(stmt, 3);
+    
+    const char *submitted = (const char*)sqlite3_column_text(stmt, 4);
+    const char *completed = (const char*)sqlite3_column_text(stmt, 5);
+    const char *result = (const char*)sqlite3_column_text(stmt, 6);
+    snprintf(rec->submitted_at, sizeof(rec->submitted_at), "%s", submitted ? submitted : "");
+    snprintf(rec->completed_at, sizeof(rec->completed_at), "%s", completed ? completed : "");
+    snprintf(rec->result, sizeof(rec->result), "%s", result ? result : "");
+    rec->execution_time = sqlite3_column_double(stmt, 7);
+}
+
+#define JOB_RECORD_COLUMNS "job_id, script, priority, status, submitted_at, completed_at, " \
+                           "result_text, execution_time"
+
+int database_get_job_history(int limit, int offset,
+                             void (*callback)(const job_record_t *rec, void *arg), void *arg) {
+    if (!db || !callback) return -1;
+    
+    int slot;
+    sqlite3 *conn = read_acquire(&slot);
+    if (!conn) return -1;
+    
+    const char *sql = "SELECT " JOB_RECORD_COLUMNS " FROM jobs "
+                     "ORDER BY id DESC LIMIT ? OFFSET ?;";
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(conn, sql, -1, &stmt, NULL);
+    
+    if (rc != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(conn));
+        read_release(slot);
+        return -1;
+    }
+    
+    sqlite3_bind_int(stmt, 1, limit);
+    sqlite3_bind_int(stmt, 2, offset);
+    
+    int count = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        job_record_t rec;
+        fill_job_record(stmt, &rec);
+        callback(&rec, arg);
+        count++;
+    }
+    
+    sqlite3_finalize(stmt);
+    read_release(slot);
+    return count;
+}
+
+int database_get_max_job_id(void) {
+    if (!db) return -1;
+    
+    int slot;
+    sqlite3 *conn = read_acquire(&slot);
+    if (!conn) return -1;
+    
+    sqlite3_stmt *stmt;
+    int max_id = -1;
+    if (sqlite3_prepare_v2(conn, "SELECT COALESCE(MAX(job_id), 0) FROM jobs;", -1, &stmt, NULL) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW) {
+            max_id = sqlite3_column_int(stmt, 0);
+        }
+        sqlite3_finalize(stmt);
+    } else {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(conn));
+    }
+    read_release(slot);
+    return max_id;
+}
+
+int database_get_job(int job_id, job_record_t *rec) {
+    if (!db || !rec) return -1;
+    
+    int slot;
+    sqlite3 *conn = read_acquire(&slot);
+    if (!conn) return -1;
+    
+    const char *sql = "SELECT " JOB_RECORD_COLUMNS " FROM jobs "
+                     "WHERE job_id = ? ORDER BY id DESC LIMIT 1;";
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(conn, sql, -1, &stmt, NULL);
+    
+    if (rc != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(conn));
+        read_release(slot);
+        return -1;
+    }
+    
+    sqlite3_bind_int(stmt, 1, job_id);
+    
+    int found = 0;
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        fill_job_record(stmt, rec);
+        found = 1;
+    }
+    
+    sqlite3_finalize(stmt);
+    read_release(slot);
+    return found ? 0 : 1;
+}
+
+static int save_schedule_locked(const schedule_record_t *rec) {
+    if (!db || !rec) return -1;
+    
+    const char *sql = "INSERT OR REPLACE INTO schedules "
+                     "(schedule_id, script, priority, timeout, next_run, every, cron, jitter, client, needs, no_hedge) "
+                     "VALUES (?, ?, ?, ?, ?, ?, ?, ?, ?, ?, ?);";
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    
+    if (rc != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+    
+    sqlite3_bind_int(stmt, 1, rec->schedule_id);
+    sqlite3_bind_text(stmt, 2, rec->job.script, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 3, rec->job.priority);
+    sqlite3_bind_int(stmt, 4, rec->job.timeout);
+    sqlite3_bind_int64(stmt, 5, (sqlite3_int64)rec->next_run);
+    sqlite3_bind_int(stmt, 6, rec->every);
+    if (rec->cron[0]) {
+        sqlite3_bind_text(stmt, 7, rec->cron, -1, SQLITE_STATIC);
+    } else {
+        sqlite3_bind_null(stmt, 7);
+    }
+    sqlite3_bind_int(stmt, 8, rec->jitter);
+    sqlite3_bind_text(stmt, 9, rec->job.client, -1, SQLITE_STATIC);
+    sqlite3_bind_text(stmt, 10, rec->job.needs, -1, SQLITE_STATIC);
+    sqlite3_bind_int(stmt, 11, rec->job.no_hedge);
+    
+    rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    if (rc != SQLITE_DONE) {
+        tslog_error(db_logger, "Erro salvando agendamento: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+    return 0;
+}
+
+int database_save_schedule(const schedule_record_t *rec) {
+    pthread_mutex_lock(&db_write_mutex);
+    int rc = save_schedule_locked(rec);
+    pthread_mutex_unlock(&db_write_mutex);
+    return rc;
+}
+
+// UPDATE/DELETE de uma linha de schedules por id
+static int exec_schedule_locked(const char *sql, int schedule_id, time_t next_run) {
+    if (!db) return -1;
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db, sql, -1, &stmt, NULL);
+    
+    if (rc != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+    
+    sqlite3_bind_int(stmt, 1, schedule_id);
+    if (sqlite3_bind_parameter_count(stmt) > 1) {
+        sqlite3_bind_int64(stmt, 2, (sqlite3_int64)next_run);
+    }
+    
+    rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    
+    if (rc != SQLITE_DONE) {
+        tslog_error(db_logger, "Erro atualizando agendamento %d: %s", schedule_id, sqlite3_errmsg(db));
+        return -1;
+    }
+    return 0;
+}
+
+int database_update_schedule(int schedule_id, time_t next_run) {
+    pthread_mutex_lock(&db_write_mutex);
+    int rc = exec_schedule_locked("UPDATE schedules SET next_run = ?2 WHERE schedule_id = ?1;",
+                                  schedule_id, next_run);
+    pthread_mutex_unlock(&db_write_mutex);
+    return rc;
+}
+
+int database_delete_schedule(int schedule_id) {
+    pthread_mutex_lock(&db_write_mutex);
+    int rc = exec_schedule_locked("DELETE FROM schedules WHERE schedule_id = ?1;", schedule_id, 0);
+    pthread_mutex_unlock(&db_write_mutex);
+    return rc;
+}
+
+int database_load_schedules(void (*callback)(const schedule_record_t *rec, void *arg), void *arg) {
+    if (!db || !callback) return -1;
+    
+    int slot;
+    sqlite3 *conn = read_acquire(&slot);
+    if (!conn) return -1;
+    
+    const char *sql = "SELECT schedule_id, script, priority, timeout, next_run, every, cron, jitter, client, needs, "
+                     "no_hedge FROM schedules ORDER BY schedule_id;";
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(conn, sql, -1, &stmt, NULL);
+    
+    if (rc != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(conn));
+        read_release(slot);
+        return -1;
+    }
+    
+    int count = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        schedule_record_t rec;
+        memset(&rec, 0, sizeof(rec));
+        
+        rec.schedule_id = sqlite3_column_int(stmt, 0);
+        const char *script = (const char*)sqlite3_column_text(stmt, 1);
+        snprintf(rec.job.script, sizeof(rec.job.script), "%s", script ? script : "");
+        rec.job.priority = sqlite3_column_int(stmt, 2);
+        rec.job.timeout = sqlite3_column_int(stmt, 3);
+        rec.next_run = (time_t)sqlite3_column_int64(stmt, 4);
+        rec.every = sqlite3_column_int(stmt, 5);
+        const char *cron = (const char*)sqlite3_column_text(stmt, 6);
+        snprintf(rec.cron, sizeof(rec.cron), "%s", cron ? cron : "");
+        rec.jitter = sqlite3_column_int(stmt, 7);
+        const char *client = (const char*)sqlite3_column_text(stmt, 8);
+        snprintf(rec.job.client, sizeof(rec.job.client), "%s", client ? client : "");
+        const char *needs = (const char*)sqlite3_column_text(stmt, 9);
+        snprintf(rec.job.needs, sizeof(rec.job.needs), "%s", needs ? needs : "");
+        rec.job.no_hedge = sqlite3_column_int(stmt, 10);
+        
+        callback(&rec, arg);
+        count++;
+    }
+    
+    sqlite3_finalize(stmt);
+    read_release(slot);
+    tslog_info(db_logger, "%d agendamentos carregados", count);
+    return 0;
+}
+
+static int save_idempotency_locked(const idempotency_record_t *rows, int count, time_t now) {
+    if (!db) return -1;
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db, "INSERT OR REPLACE INTO idempotency_keys "
+                                    "(key, kind, id, first_run, expires_at) VALUES (?, ?, ?, ?, ?);",
+                                -1, &stmt, NULL);
+    if (rc != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(db));
+        return -1;
+    }
+    
+    sqlite3_exec(db, "BEGIN;", NULL, NULL, NULL);
+    
+    for (int i = 0; i < count; i++) {
+        sqlite3_bind_text(stmt, 1, rows[i].key, -1, SQLITE_STATIC);
+        sqlite3_bind_int(stmt, 2, rows[i].kind);
+        sqlite3_bind_int(stmt, 3, rows[i].id);
+        sqlite3_bind_int64(stmt, 4, (sqlite3_int64)rows[i].first_run);
+        sqlite3_bind_int64(stmt, 5, (sqlite3_int64)rows[i].expires_at);
+        
+        rc = sqlite3_step(stmt);
+        sqlite3_reset(stmt);
+        
+        if (rc != SQLITE_DONE) {
+            tslog_error(db_logger, "Erro salvando chaves de idempotência: %s", sqlite3_errmsg(db));
+            sqlite3_exec(db, "ROLLBACK;", NULL, NULL, NULL);
+            sqlite3_finalize(stmt);
+            return -1;
+        }
+    }
+    sqlite3_finalize(stmt);
+    
+    char sql[96];
+    snprintf(sql, sizeof(sql), "DELETE FROM idempotency_keys WHERE expires_at <= %lld;", (long long)now);
+    sqlite3_exec(db, sql, NULL, NULL, NULL);
+    sqlite3_exec(db, "COMMIT;", NULL, NULL, NULL);
+    
+    tslog_debug(db_logger, "%d chaves de idempotência persistidas", count);
+    return 0;
+}
+
+int database_save_idempotency_keys(const idempotency_record_t *rows, int count, time_t now) {
+    pthread_mutex_lock(&db_write_mutex);
+    int rc = save_idempotency_locked(rows, count, now);
+    pthread_mutex_unlock(&db_write_mutex);
+    return rc;
+}
+
+int database_load_idempotency_keys(time_t now, void (*callback)(const idempotency_record_t *rec, void *arg),
+                                   void *arg) {
+    if (!db || !callback) return -1;
+    
+    int slot;
+    sqlite3 *conn = read_acquire(&slot);
+    if (!conn) return -1;
+    
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn, "SELECT key, kind, id, first_run, expires_at FROM idempotency_keys "
+                                 "WHERE expires_at > ? ORDER BY expires_at;", -1, &stmt, NULL) != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(conn));
+        read_release(slot);
+        return -1;
+    }
+    sqlite3_bind_int64(stmt, 1, (sqlite3_int64)now);
+    
+    int count = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        idempotency_record_t rec;
+        memset(&rec, 0, sizeof(rec));
+        snprintf(rec.key, sizeof(rec.key), "%s", (const char*)sqlite3_column_text(stmt, 0));
+        rec.kind = (idempotency_kind_t)sqlite3_column_int(stmt, 1);
+        rec.id = sqlite3_column_int(stmt, 2);
+        rec.first_run = (time_t)sqlite3_column_int64(stmt, 3);
+        rec.expires_at = (time_t)sqlite3_column_int64(stmt, 4);
+        callback(&rec, arg);
+        count++;
     }
     
     sqlite3_finalize(stmt);
+    read_release(slot);
+    tslog_info(db_logger, "%d chaves de idempotência carregadas", count);
     return 0;
-}
\ No newline at end of file
+}
+
+int database_save_worker_profile(const char *tags) {
+    if (!tags) return -1;
+    
+    pthread_mutex_lock(&db_write_mutex);
+    if (!db) {
+        pthread_mutex_unlock(&db_write_mutex);
+        return -1;
+    }
+    
+    sqlite3_stmt *stmt;
+    int rc = sqlite3_prepare_v2(db, "INSERT OR IGNORE INTO worker_profiles (tags) VALUES (?);",
+                                -1, &stmt, NULL);
+    if (rc == SQLITE_OK) {
+        sqlite3_bind_text(stmt, 1, tags, -1, SQLITE_STATIC);
+        rc = sqlite3_step(stmt) == SQLITE_DONE ? SQLITE_OK : SQLITE_ERROR;
+        sqlite3_finalize(stmt);
+    }
+    if (rc != SQLITE_OK) {
+        tslog_error(db_logger, "Erro salvando perfil de worker: %s", sqlite3_errmsg(db));
+    }
+    pthread_mutex_unlock(&db_write_mutex);
+    return rc == SQLITE_OK ? 0 : -1;
+}
+
+int database_load_worker_profiles(void (*callback)(const char *tags, void *arg), void *arg) {
+    if (!db || !callback) return -1;
+    
+    int slot;
+    sqlite3 *conn = read_acquire(&slot);
+    if (!conn) return -1;
+    
+    sqlite3_stmt *stmt;
+    if (sqlite3_prepare_v2(conn, "SELECT tags FROM worker_profiles;", -1, &stmt, NULL) != SQLITE_OK) {
+        tslog_error(db_logger, "Erro preparando SQL: %s", sqlite3_errmsg(conn));
+        read_release(slot);
+        return -1;
+    }
+    
+    int count = 0;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char *tags = (const char*)sqlite3_column_text(stmt, 0);
+        callback(tags ? tags : "", arg);
+        count++;
+    }
+    
+    sqlite3_finalize(stmt);
+    read_release(slot);
+    tslog_info(db_logger, "%d perfis de capacidades de workers carregados", count);
+    return 0;
+}
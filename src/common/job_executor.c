@@ -1,37 +1,87 @@
+#define _GNU_SOURCE     // pipe2
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 #include <unistd.h>
+#include <fcntl.h>
+#include <signal.h>
 #include <sys/wait.h>
 #include <time.h>
 #include "job_executor.h"
 #include "../../include/tslog.h"
+#include "protocol.h"
+#include "uring.h"
 
-double execute_script(const char *script, char *output, size_t output_size, int timeout) {
+double execute_script_tracked(const char *script, char *output, size_t output_size, int timeout,
+                              int *succeeded, void (*started)(pid_t pid, void *arg), void *arg) {
     FILE *fp;
     char command[2048];  // Aumentado para comandos maiores
     char temp_output[4096];
     double execution_time = 0.0;
     
-    // Detectar tipo de script e criar comando apropriado
-    if (strstr(script, "python") != NULL || strstr(script, ".py") != NULL) {
+    if (succeeded) *succeeded = 0;
+    
+    // Detectar tipo de script e criar comando apropriado. Com --foreground o
+    // `timeout` fica no grupo de processos do script (ver execute_script_tracked)
+    const char *runtime = protocol_script_runtime(script);
+    if (runtime && strcmp(runtime, "python3") == 0) {
         // Usar python3 explicitamente
-        snprintf(command, sizeof(command), "timeout %d python3 -c \"%s\" 2>&1", timeout, script);
-    } else if (strstr(script, "lua") != NULL || strstr(script, ".lua") != NULL) {
+        snprintf(command, sizeof(command), "timeout --foreground %d python3 -c \"%s\" 2>&1", timeout, script);
+    } else if (runtime && strcmp(runtime, "lua") == 0) {
         // Usar lua explicitamente
-        snprintf(command, sizeof(command), "timeout %d lua -e \"%s\" 2>&1", timeout, script);
+        snprintf(command, sizeof(command), "timeout --foreground %d lua -e \"%s\" 2>&1", timeout, script);
     } else {
         // Comando genérico
-        snprintf(command, sizeof(command), "timeout %d %s 2>&1", timeout, script);
+        snprintf(command, sizeof(command), "timeout --foreground %d %s 2>&1", timeout, script);
     }
     
     tslog_info(NULL, "Executando comando: %s", command);  // Log para debug
     
-    clock_t start = clock();
+    // Tempo de parede: clock() mede só a CPU deste processo, quase nada com popen
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
     
-    // Executar comando
-    fp = popen(command, "r");
+    // Executar comando (como popen, mas com o pid para quem precisa cancelar).
+    // O pipe é close-on-exec, como no popen: sem isso o script de outro slot,
+    // criado no meio tempo, herda a ponta de escrita e atrasa o EOF deste.
+    // O dup2 no filho tira a flag do stdout.
+    int fds[2];
+    if (pipe2(fds, O_CLOEXEC) != 0) {
+        snprintf(output, output_size, "Erro ao executar comando: %s", command);
+        return -1.0;
+    }
+    pid_t pid = fork();
+    if (pid < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        snprintf(output, output_size, "Erro ao executar comando: %s", command);
+        return -1.0;
+    }
+    if (pid == 0) {
+        setpgid(0, 0);
+        dup2(fds[1], STDOUT_FILENO);
+        close(fds[0]);
+        close(fds[1]);
+        execl("/bin/sh", "sh", "-c", command, (char*)NULL);
+        _exit(127);
+    }
+    close(fds[1]);
+    setpgid(pid, pid);   // também no pai: o grupo já existe quando started() roda
+    if (started) started(pid, arg);
+    
+#ifdef SCHED_IO_URING
+    // READ_FIXED no buffer registrado da thread: um io_uring_enter por
+    // pedaço, sem as leituras de 256 bytes do stdio
+    if (uring_read_pipe(fds[0], temp_output, sizeof(temp_output)) >= 0) {
+        close(fds[0]);
+        goto reap;
+    }
+#endif
+    fp = fdopen(fds[0], "r");
     if (fp == NULL) {
+        close(fds[0]);
+        kill(-pid, SIGKILL);
+        waitpid(pid, NULL, 0);
         snprintf(output, output_size, "Erro ao executar comando: %s", command);
         return -1.0;
     }
@@ -50,10 +100,15 @@ double execute_script(const char *script, char *output, size_t output_size, int
         }
     }
     
-    int status = pclose(fp);
-    clock_t end = clock();
+    fclose(fp);
+#ifdef SCHED_IO_URING
+reap:;
+#endif
+    int status = 0;
+    waitpid(pid, &status, 0);
+    clock_gettime(CLOCK_MONOTONIC, &end);
     
-    execution_time = ((double)(end - start)) / CLOCKS_PER_SEC;
+    execution_time = (double)(end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
     
     // Processar resultado
     if (WIFEXITED(status)) {
@@ -68,7 +123,10 @@ double execute_script(const char *script, char *output, size_t output_size, int
                 temp_output[strlen(temp_output)-1] = '\0';
             }
             snprintf(output, output_size, "%s", temp_output);
+            if (succeeded) *succeeded = 1;
         }
+    } else if (WIFSIGNALED(status)) {
+        snprintf(output, output_size, "Script interrompido pelo sinal %d", WTERMSIG(status));
     } else {
         snprintf(output, output_size, "Script terminou anormalmente. Status: %d", status);
     }
@@ -76,10 +134,19 @@ double execute_script(const char *script, char *output, size_t output_size, int
     return execution_time;
 }
 
+double execute_script_status(const char *script, char *output, size_t output_size, int timeout,
+                             int *succeeded) {
+    return execute_script_tracked(script, output, output_size, timeout, succeeded, NULL, NULL);
+}
+
+double execute_script(const char *script, char *output, size_t output_size, int timeout) {
+    return execute_script_status(script, output, output_size, timeout, NULL);
+}
+
 // Função auxiliar para testar scripts de arquivo
 double execute_script_file(const char *filename, char *output, size_t output_size, int timeout) {
     char command[1024];
-    snprintf(command, sizeof(command), "timeout %d %s 2>&1", timeout, filename);
+    snprintf(command, sizeof(command), "timeout --foreground %d %s 2>&1", timeout, filename);
     return execute_script(command, output, output_size, timeout);
 }
 
@@ -1,6 +1,17 @@
 #ifndef JOB_EXECUTOR_H
 #define JOB_EXECUTOR_H
 
+#include <stddef.h>
+#include <sys/types.h>
+
 double execute_script(const char *script, char *output, size_t output_size, int timeout);
+// Como execute_script; *succeeded = 1 só se o script saiu com status 0
+double execute_script_status(const char *script, char *output, size_t output_size, int timeout,
+                             int *succeeded);
+// Como execute_script_status; started(pid, arg) é chamado logo depois do
+// fork. O script roda no próprio grupo de processos, então kill(-pid, ...)
+// interrompe o interpretador junto com o `timeout` e o shell.
+double execute_script_tracked(const char *script, char *output, size_t output_size, int timeout,
+                              int *succeeded, void (*started)(pid_t pid, void *arg), void *arg);
 
 #endif
\ No newline at end of file
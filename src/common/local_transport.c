@@ -0,0 +1,283 @@
+#define _GNU_SOURCE     // memfd_create, F_ADD_SEALS
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include "local_transport.h"
+
+void local_socket_path(int port, char *path, size_t size) {
+    snprintf(path, size, "%s/agendador-%d.sock", LOCAL_SOCKET_DIR, port);
+}
+
+int local_host_is_loopback(const char *host) {
+    const char *mode = getenv(LOCAL_TRANSPORT_ENV);
+    if (mode && strcmp(mode, "tcp") == 0) return 0;
+    return strcmp(host, "127.0.0.1") == 0 || strcmp(host, "::1") == 0 ||
+           strcmp(host, "localhost") == 0;
+}
+
+static int unix_address(int port, struct sockaddr_un *addr) {
+    memset(addr, 0, sizeof(*addr));
+    addr->sun_family = AF_UNIX;
+    local_socket_path(port, addr->sun_path, sizeof(addr->sun_path));
+    return 0;
+}
+
+int local_listen(int port, int backlog) {
+    struct sockaddr_un addr;
+    unix_address(port, &addr);
+
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    // A porta TCP já é nossa: o arquivo que sobrou é de um servidor que caiu
+    unlink(addr.sun_path);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(sock, backlog) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+void local_unlink(int port) {
+    char path[sizeof(((struct sockaddr_un*)0)->sun_path)];
+    local_socket_path(port, path, sizeof(path));
+    unlink(path);
+}
+
+int local_connect(const char *host, int port) {
+    if (!local_host_is_loopback(host)) return -1;
+
+    struct sockaddr_un addr;
+    unix_address(port, &addr);
+    int sock = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    if (connect(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+int local_is_unix(int sock) {
+    struct sockaddr_storage addr;
+    socklen_t len = sizeof(addr);
+    if (getsockname(sock, (struct sockaddr*)&addr, &len) < 0) return 0;
+    return addr.ss_family == AF_UNIX;
+}
+
+int local_send_line_fds(int sock, const char *line, const int *fds, int count) {
+    char buffer[PROTOCOL_LINE_MAX];
+    int len = snprintf(buffer, sizeof(buffer), "%s\n", line);
+    if (len < 0 || (size_t)len >= sizeof(buffer) || count > SHM_CHANNEL_FDS) return -1;
+
+    union {
+        struct cmsghdr header;
+        char data[CMSG_SPACE(sizeof(int) * SHM_CHANNEL_FDS)];
+    } control;
+    memset(&control, 0, sizeof(control));
+    struct iovec iov = {buffer, (size_t)len};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data;
+    msg.msg_controllen = CMSG_SPACE(sizeof(int) * (size_t)count);
+
+    struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg);
+    cmsg->cmsg_level = SOL_SOCKET;
+    cmsg->cmsg_type = SCM_RIGHTS;
+    cmsg->cmsg_len = CMSG_LEN(sizeof(int) * (size_t)count);
+    memcpy(CMSG_DATA(cmsg), fds, sizeof(int) * (size_t)count);
+
+    // A linha é curta: um sendmsg só, para os descritores irem com ela
+    ssize_t n;
+    do {
+        n = sendmsg(sock, &msg, MSG_NOSIGNAL);
+    } while (n < 0 && errno == EINTR);
+    return n == len ? 0 : -1;
+}
+
+/* ---- Canal de memória compartilhada ---- */
+
+int shm_channel_create(shm_channel_t *channel) {
+    memset(channel, 0, sizeof(*channel));
+    channel->memfd = channel->job_event = channel->result_event = -1;
+
+    channel->memfd = memfd_create("agendador-worker", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (channel->memfd < 0 || ftruncate(channel->memfd, sizeof(shm_area_t)) < 0) goto fail;
+    // O servidor mapeia a mesma área: sem os selos o worker poderia
+    // encolher o arquivo e derrubá-lo com SIGBUS
+    if (fcntl(channel->memfd, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_SEAL) < 0) goto fail;
+
+    channel->area = mmap(NULL, sizeof(shm_area_t), PROT_READ | PROT_WRITE, MAP_SHARED, channel->memfd, 0);
+    if (channel->area == MAP_FAILED) {
+        channel->area = NULL;
+        goto fail;
+    }
+    channel->area->magic = SHM_CHANNEL_MAGIC;
+    channel->area->slots = SHM_RING_SLOTS;
+
+    channel->job_event = eventfd(0, EFD_CLOEXEC);
+    channel->result_event = eventfd(0, EFD_CLOEXEC);
+    if (channel->job_event < 0 || channel->result_event < 0) goto fail;
+    return 0;
+
+fail:
+    shm_channel_close(channel);
+    return -1;
+}
+
+int shm_channel_open(shm_channel_t *channel, const int *fds, int count) {
+    memset(channel, 0, sizeof(*channel));
+    channel->memfd = count > 0 ? fds[0] : -1;
+    channel->job_event = count > 1 ? fds[1] : -1;
+    channel->result_event = count > 2 ? fds[2] : -1;
+    if (count != SHM_CHANNEL_FDS) goto fail;
+
+    struct stat st;
+    int seals = fcntl(channel->memfd, F_GET_SEALS);
+    if (fstat(channel->memfd, &st) < 0 || (size_t)st.st_size != sizeof(shm_area_t) ||
+        seals < 0 || !(seals & F_SEAL_SHRINK)) {
+        goto fail;
+    }
+    channel->area = mmap(NULL, sizeof(shm_area_t), PROT_READ | PROT_WRITE, MAP_SHARED, channel->memfd, 0);
+    if (channel->area == MAP_FAILED) {
+        channel->area = NULL;
+        goto fail;
+    }
+    if (channel->area->magic != SHM_CHANNEL_MAGIC || channel->area->slots != SHM_RING_SLOTS) goto fail;
+    return 0;
+
+fail:
+    shm_channel_close(channel);
+    return -1;
+}
+
+void shm_channel_close(shm_channel_t *channel) {
+    if (channel->area) munmap(channel->area, sizeof(shm_area_t));
+    if (channel->memfd >= 0) close(channel->memfd);
+    if (channel->job_event >= 0) close(channel->job_event);
+    if (channel->result_event >= 0) close(channel->result_event);
+    channel->area = NULL;
+    channel->memfd = channel->job_event = channel->result_event = -1;
+}
+
+void shm_channel_fds(const shm_channel_t *channel, int *fds) {
+    fds[0] = channel->memfd;
+    fds[1] = channel->job_event;
+    fds[2] = channel->result_event;
+}
+
+void shm_channel_wake(int event_fd) {
+    uint64_t one = 1;
+    ssize_t n;
+    do {
+        n = write(event_fd, &one, sizeof(one));
+    } while (n < 0 && errno == EINTR);
+}
+
+int shm_channel_wait(int event_fd) {
+    uint64_t value;
+    ssize_t n;
+    do {
+        n = read(event_fd, &value, sizeof(value));
+    } while (n < 0 && errno == EINTR);
+    return n == sizeof(value) ? 0 : -1;
+}
+
+// Índices só crescem (uint32 dá a volta sem problema); tail - head é a
+// ocupação. O conteúdo do slot é publicado pelo release do índice.
+static int bounded_len(int len, size_t max) {
+    if (len < 0) return 0;
+    return (size_t)len >= max ? (int)max - 1 : len;
+}
+
+int shm_channel_push_job(shm_channel_t *channel, int job_id, int lease_id, const char *script, int timeout) {
+    shm_area_t *area = channel->area;
+    uint32_t tail = atomic_load_explicit(&area->job_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&area->job_head, memory_order_acquire);
+    if (tail - head >= SHM_RING_SLOTS) return -1;
+
+    shm_job_slot_t *slot = &area->jobs[tail % SHM_RING_SLOTS];
+    int len = bounded_len((int)strlen(script), sizeof(slot->script));
+    slot->job_id = job_id;
+    slot->lease_id = lease_id;
+    slot->timeout = timeout;
+    slot->len = len;
+    memcpy(slot->script, script, (size_t)len);
+    slot->script[len] = '\0';
+    atomic_store_explicit(&area->job_tail, tail + 1, memory_order_release);
+    shm_channel_wake(channel->job_event);
+    return 0;
+}
+
+int shm_channel_pop_job(shm_channel_t *channel, int *job_id, int *lease_id, char *script, size_t size,
+                        int *timeout) {
+    shm_area_t *area = channel->area;
+    uint32_t head = atomic_load_explicit(&area->job_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&area->job_tail, memory_order_acquire);
+    if (head == tail) return 0;
+
+    shm_job_slot_t *slot = &area->jobs[head % SHM_RING_SLOTS];
+    int len = bounded_len(slot->len, size < sizeof(slot->script) ? size : sizeof(slot->script));
+    *job_id = slot->job_id;
+    *lease_id = slot->lease_id;
+    *timeout = slot->timeout;
+    memcpy(script, slot->script, (size_t)len);
+    script[len] = '\0';
+    atomic_store_explicit(&area->job_head, head + 1, memory_order_release);
+    return 1;
+}
+
+int shm_channel_push_result(shm_channel_t *channel, int job_id, int lease_id, int success, double exec_time,
+                            const char *output) {
+    shm_area_t *area = channel->area;
+    uint32_t tail = atomic_load_explicit(&area->result_tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&area->result_head, memory_order_acquire);
+    if (tail - head >= SHM_RING_SLOTS) return -1;
+
+    shm_result_slot_t *slot = &area->results[tail % SHM_RING_SLOTS];
+    int len = bounded_len((int)strlen(output), sizeof(slot->output));
+    slot->job_id = job_id;
+    slot->lease_id = lease_id;
+    slot->success = success;
+    slot->exec_time = exec_time;
+    slot->len = len;
+    memcpy(slot->output, output, (size_t)len);
+    slot->output[len] = '\0';
+    atomic_store_explicit(&area->result_tail, tail + 1, memory_order_release);
+    shm_channel_wake(channel->result_event);
+    return 0;
+}
+
+// O worker escreve a área: o servidor limita tudo o que lê dela
+int shm_channel_pop_result(shm_channel_t *channel, int *job_id, int *lease_id, int *success, double *exec_time,
+                           char *output, size_t size) {
+    shm_area_t *area = channel->area;
+    uint32_t head = atomic_load_explicit(&area->result_head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&area->result_tail, memory_order_acquire);
+    if (head == tail) return 0;
+    if (tail - head > SHM_RING_SLOTS) {
+        // Índices corrompidos pelo outro lado: descarta tudo
+        atomic_store_explicit(&area->result_head, tail, memory_order_release);
+        return 0;
+    }
+
+    shm_result_slot_t *slot = &area->results[head % SHM_RING_SLOTS];
+    int len = bounded_len(slot->len, size < sizeof(slot->output) ? size : sizeof(slot->output));
+    *job_id = slot->job_id;
+    *lease_id = slot->lease_id;
+    *success = slot->success;
+    *exec_time = slot->exec_time;
+    memcpy(output, slot->output, (size_t)len);
+    output[len] = '\0';
+    atomic_store_explicit(&area->result_head, head + 1, memory_order_release);
+    return 1;
+}
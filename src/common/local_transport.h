@@ -0,0 +1,103 @@
+#ifndef LOCAL_TRANSPORT_H
+#define LOCAL_TRANSPORT_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include "protocol.h"
+
+// Transporte local para quem roda na mesma máquina do servidor.
+//  - Controle: além da porta TCP o servidor ouve em LOCAL_SOCKET_DIR/
+//    agendador-<porta>.sock (AF_UNIX, mesmo protocolo texto). shard_connect
+//    tenta esse caminho primeiro quando o host é de loopback e cai para TCP
+//    se ele não existir; SCHEDULER_TRANSPORT=tcp força TCP.
+//  - Dados: um worker em modo push conectado pelo socket local cria um
+//    canal de memória compartilhada (memfd selado com dois anéis e dois
+//    eventfd) e o entrega ao servidor com "SHM_ATTACH" (descritores via
+//    SCM_RIGHTS). Depois de "SHM_ATTACHED", scripts e saídas passam pelos
+//    anéis sem escape e sem cópia pelo kernel; os eventfd só acordam o outro
+//    lado. CANCEL, HEARTBEAT e o resto continuam no socket. Anel cheio: a
+//    linha JOB/JOB_RESULT de sempre vai pelo socket.
+
+#define LOCAL_SOCKET_DIR "/tmp"
+#define LOCAL_TRANSPORT_ENV "SCHEDULER_TRANSPORT"   // "tcp": nunca usar o socket local
+#define SHM_RING_SLOTS 32                           // por direção (> WORKER_MAX_SLOTS)
+#define SHM_CHANNEL_MAGIC 0x41475348u               // "AGSH"
+#define SHM_CHANNEL_FDS 3                           // memfd, eventfd de jobs, eventfd de resultados
+
+// Caminho do socket local do servidor na porta `port`
+void local_socket_path(int port, char *path, size_t size);
+// 127.0.0.1, ::1 ou localhost (e o transporte local não foi desligado)
+int local_host_is_loopback(const char *host);
+// Servidor: cria o socket local (remove um arquivo antigo); -1 se falhar
+int local_listen(int port, int backlog);
+void local_unlink(int port);
+// Conecta ao socket local do servidor em host:port; -1 se o host não é
+// local ou não há servidor ouvindo nele
+int local_connect(const char *host, int port);
+// 1 se o socket é AF_UNIX
+int local_is_unix(int sock);
+// Uma linha com descritores anexados (SCM_RIGHTS)
+int local_send_line_fds(int sock, const char *line, const int *fds, int count);
+
+typedef struct {
+    int job_id;
+    int lease_id;
+    int timeout;
+    int len;
+    char script[MAX_SCRIPT_SIZE];
+} shm_job_slot_t;
+
+typedef struct {
+    int job_id;
+    int lease_id;
+    int success;
+    double exec_time;
+    int len;
+    char output[MAX_RESULT_SIZE];
+} shm_result_slot_t;
+
+// Os dois anéis têm um produtor e um consumidor: o servidor escreve jobs
+// (com o send_mutex do worker) e o worker os lê; o worker escreve resultados
+// (com o seu send_mutex) e a thread do canal no servidor os lê
+typedef struct {
+    uint32_t magic;
+    uint32_t slots;
+    _Atomic uint32_t job_head;          // próximo a ler (worker)
+    _Atomic uint32_t job_tail;          // próximo a escrever (servidor)
+    _Atomic uint32_t result_head;       // servidor
+    _Atomic uint32_t result_tail;       // worker
+    shm_job_slot_t jobs[SHM_RING_SLOTS];
+    shm_result_slot_t results[SHM_RING_SLOTS];
+} shm_area_t;
+
+typedef struct {
+    shm_area_t *area;
+    int memfd;
+    int job_event;                      // servidor -> worker
+    int result_event;                   // worker -> servidor
+} shm_channel_t;
+
+// Worker: cria o memfd selado (tamanho fixo) e os eventfd
+int shm_channel_create(shm_channel_t *channel);
+// Servidor: valida e mapeia os descritores recebidos (assume os três, mesmo
+// se falhar)
+int shm_channel_open(shm_channel_t *channel, const int *fds, int count);
+void shm_channel_close(shm_channel_t *channel);
+// Descritores na ordem de SHM_ATTACH
+void shm_channel_fds(const shm_channel_t *channel, int *fds);
+
+// -1 se o anel está cheio (o chamador usa o socket)
+int shm_channel_push_job(shm_channel_t *channel, int job_id, int lease_id, const char *script, int timeout);
+// 1 com o job, 0 se o anel está vazio
+int shm_channel_pop_job(shm_channel_t *channel, int *job_id, int *lease_id, char *script, size_t size,
+                        int *timeout);
+int shm_channel_push_result(shm_channel_t *channel, int job_id, int lease_id, int success, double exec_time,
+                            const char *output);
+int shm_channel_pop_result(shm_channel_t *channel, int *job_id, int *lease_id, int *success, double *exec_time,
+                           char *output, size_t size);
+// Bloqueia até o outro lado escrever no eventfd; -1 se ele foi fechado
+int shm_channel_wait(int event_fd);
+void shm_channel_wake(int event_fd);
+
+#endif
@@ -0,0 +1,306 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <unistd.h>
+#include "protocol.h"
+
+// Mensagens trafegam como linhas de texto terminadas em '\n'.
+// O leitor mantém um buffer por conexão para lidar com leituras parciais
+// e com várias mensagens chegando no mesmo read().
+
+void line_reader_init(line_reader_t *lr) {
+    lr->len = 0;
+    lr->fd_count = 0;
+    lr->source = NULL;
+    lr->source_ctx = NULL;
+}
+
+void line_reader_set_source(line_reader_t *lr, line_source_t source, void *ctx) {
+    lr->source = source;
+    lr->source_ctx = ctx;
+}
+
+int line_reader_take_fds(line_reader_t *lr, int *fds, int max) {
+    int count = lr->fd_count < max ? lr->fd_count : max;
+    memcpy(fds, lr->fds, sizeof(int) * (size_t)count);
+    for (int i = count; i < lr->fd_count; i++) close(lr->fds[i]);
+    lr->fd_count = 0;
+    return count;
+}
+
+void line_reader_close_fds(line_reader_t *lr) {
+    for (int i = 0; i < lr->fd_count; i++) close(lr->fds[i]);
+    lr->fd_count = 0;
+}
+
+// read() com os descritores que vierem junto (só em AF_UNIX); o que não
+// cabe em lr->fds é fechado
+static ssize_t read_chunk(line_reader_t *lr, int fd) {
+    union {
+        struct cmsghdr header;
+        char data[CMSG_SPACE(sizeof(int) * LINE_READER_FDS)];
+    } control;
+    if (lr->source) return lr->source(lr->source_ctx, lr->data + lr->len, sizeof(lr->data) - lr->len);
+
+    struct iovec iov = {lr->data + lr->len, sizeof(lr->data) - lr->len};
+    struct msghdr msg;
+    memset(&msg, 0, sizeof(msg));
+    msg.msg_iov = &iov;
+    msg.msg_iovlen = 1;
+    msg.msg_control = control.data;
+    msg.msg_controllen = sizeof(control.data);
+
+    ssize_t n = recvmsg(fd, &msg, MSG_CMSG_CLOEXEC);
+    if (n < 0 && errno == ENOTSOCK) return read(fd, iov.iov_base, iov.iov_len);
+    if (n <= 0) return n;
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg)) {
+        if (cmsg->cmsg_level != SOL_SOCKET || cmsg->cmsg_type != SCM_RIGHTS) continue;
+        int count = (int)((cmsg->cmsg_len - CMSG_LEN(0)) / sizeof(int));
+        int *fds = (int*)CMSG_DATA(cmsg);
+        for (int i = 0; i < count; i++) {
+            if (lr->fd_count < LINE_READER_FDS) {
+                lr->fds[lr->fd_count++] = fds[i];
+            } else {
+                close(fds[i]);
+            }
+        }
+    }
+    return n;
+}
+
+ssize_t line_reader_next(line_reader_t *lr, int fd, char *line, size_t size) {
+    while (1) {
+        char *nl = memchr(lr->data, '\n', lr->len);
+        if (nl != NULL) {
+            size_t line_len = (size_t)(nl - lr->data);
+            size_t copy = line_len < size - 1 ? line_len : size - 1;
+            memcpy(line, lr->data, copy);
+            line[copy] = '\0';
+            if (copy > 0 && line[copy - 1] == '\r') {
+                line[--copy] = '\0';
+            }
+
+            size_t consumed = line_len + 1;
+            memmove(lr->data, lr->data + consumed, lr->len - consumed);
+            lr->len -= consumed;
+            return (ssize_t)copy;
+        }
+
+        if (lr->len == sizeof(lr->data)) {
+            // Linha maior que o buffer: descarta o excedente
+            lr->len = 0;
+        }
+
+        ssize_t n = read_chunk(lr, fd);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        lr->len += (size_t)n;
+    }
+}
+
+int protocol_send_line(int fd, const char *line) {
+    char buffer[PROTOCOL_LINE_MAX];
+    int len = snprintf(buffer, sizeof(buffer), "%s\n", line);
+    if (len < 0) return -1;
+    if ((size_t)len >= sizeof(buffer)) {
+        len = sizeof(buffer) - 1;
+        buffer[len - 1] = '\n';
+    }
+
+    size_t sent = 0;
+    while (sent < (size_t)len) {
+        // MSG_NOSIGNAL: par desconectado vira erro em vez de SIGPIPE
+        ssize_t n = send(fd, buffer + sent, (size_t)len - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        sent += (size_t)n;
+    }
+    return 0;
+}
+
+void protocol_escape(const char *src, char *dst, size_t size) {
+    size_t j = 0;
+    for (size_t i = 0; src[i] != '\0' && j + 2 < size; i++) {
+        switch (src[i]) {
+            case '\n': dst[j++] = '\\'; dst[j++] = 'n'; break;
+            case '\r': dst[j++] = '\\'; dst[j++] = 'r'; break;
+            case '\\': dst[j++] = '\\'; dst[j++] = '\\'; break;
+            default:   dst[j++] = src[i]; break;
+        }
+    }
+    dst[j] = '\0';
+}
+
+void protocol_unescape(char *str) {
+    char *out = str;
+    for (char *in = str; *in != '\0'; in++) {
+        if (*in == '\\' && in[1] != '\0') {
+            in++;
+            switch (*in) {
+                case 'n': *out++ = '\n'; break;
+                case 'r': *out++ = '\r'; break;
+                default:  *out++ = *in; break;
+            }
+        } else {
+            *out++ = *in;
+        }
+    }
+    *out = '\0';
+}
+
+const char* protocol_script_runtime(const char *script) {
+    if (strstr(script, "python") != NULL || strstr(script, ".py") != NULL) return "python3";
+    if (strstr(script, "lua") != NULL || strstr(script, ".lua") != NULL) return "lua";
+    return NULL;
+}
+
+static const char *status_names[] = {
+    "PENDING", "RUNNING", "COMPLETED", "FAILED", "TIMEOUT", "DEAD_LETTER", "CANCELLED", "EXPIRED"
+};
+
+const char* protocol_status_name(job_status_t status) {
+    return (unsigned)status < sizeof(status_names) / sizeof(status_names[0]) ? status_names[status] : "UNKNOWN";
+}
+
+int protocol_status_from_name(const char *name, job_status_t *status) {
+    for (size_t i = 0; i < sizeof(status_names) / sizeof(status_names[0]); i++) {
+        if (strcmp(name, status_names[i]) == 0) {
+            *status = (job_status_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+// Caracteres aceitos em nomes de cliente, de batch e de capacidade
+#define NAME_CHARS "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_.-"
+
+// Valor inteiro não negativo de uma opção
+static int option_int(const char *value, long *out) {
+    char *end;
+    long v = strtol(value, &end, 10);
+    if (end == value || *end != '\0' || v < 0) return -1;
+    *out = v;
+    return 0;
+}
+
+const char* protocol_parse_job(const char *line, job_options_t *opts) {
+    memset(opts, 0, sizeof(*opts));
+    if (strncmp(line, "JOB", 3) != 0) return NULL;
+    line += 3;
+    if (*line == ':') return line + 1;
+    if (*line != '?') return NULL;
+
+    // As opções terminam no primeiro ':'; o script pode conter ':' à vontade
+    const char *colon = strchr(line + 1, ':');
+    if (!colon || (size_t)(colon - line) > 1024) return NULL;
+
+    char options[1025];
+    memcpy(options, line + 1, (size_t)(colon - line - 1));
+    options[colon - line - 1] = '\0';
+
+    char *save = NULL;
+    for (char *item = strtok_r(options, "&", &save); item; item = strtok_r(NULL, "&", &save)) {
+        char *value = strchr(item, '=');
+        if (!value) return NULL;
+        *value++ = '\0';
+
+        long v = 0;
+        if (strcmp(item, "cron") == 0) {
+            if (strlen(value) >= sizeof(opts->cron)) return NULL;
+            strcpy(opts->cron, value);
+            continue;
+        }
+        if (strcmp(item, "client") == 0 || strcmp(item, "batch") == 0) {
+            char *dst = item[0] == 'c' ? opts->client : opts->batch;
+            if (!*value || strlen(value) >= JOB_CLIENT_MAX || value[strspn(value, NAME_CHARS)]) {
+                return NULL;
+            }
+            strcpy(dst, value);
+            continue;
+        }
+        if (strcmp(item, "key") == 0) {
+            if (!*value || strlen(value) >= sizeof(opts->key) || value[strspn(value, NAME_CHARS)]) {
+                return NULL;
+            }
+            strcpy(opts->key, value);
+            continue;
+        }
+        if (strcmp(item, "after") == 0) {
+            if (!*value || strlen(value) >= sizeof(opts->after) ||
+                value[strspn(value, NAME_CHARS ",@")]) {
+                return NULL;
+            }
+            strcpy(opts->after, value);
+            continue;
+        }
+        if (strcmp(item, "needs") == 0) {
+            if (!*value || strlen(value) >= sizeof(opts->needs) ||
+                value[strspn(value, NAME_CHARS ",")]) {
+                return NULL;
+            }
+            strcpy(opts->needs, value);
+            continue;
+        }
+        if (option_int(value, &v) != 0) return NULL;
+
+        if (strcmp(item, "priority") == 0 && v >= 1 && v <= 10) {
+            opts->priority = (int)v;
+        } else if (strcmp(item, "timeout") == 0 && v >= 1) {
+            opts->timeout = (int)v;
+        } else if (strcmp(item, "at") == 0) {
+            opts->run_at = (time_t)v;
+        } else if (strcmp(item, "delay") == 0) {
+            opts->delay = (int)v;
+        } else if (strcmp(item, "every") == 0 && v >= 1) {
+            opts->every = (int)v;
+        } else if (strcmp(item, "jitter") == 0) {
+            opts->jitter = (int)v;
+        } else if (strcmp(item, "deadline") == 0 && v >= 1) {
+            opts->deadline = (time_t)v;
+        } else if (strcmp(item, "due") == 0 && v >= 1) {
+            opts->due = (int)v;
+        } else if (strcmp(item, "hedge") == 0 && (v == 0 || v == 1)) {
+            opts->no_hedge = !v;
+        } else {
+            return NULL;
+        }
+    }
+    return colon + 1;
+}
+
+int protocol_format_job(const job_options_t *opts, const char *script, char *buffer, size_t size) {
+    char options[1024] = "";
+    size_t off = 0;
+
+#define APPEND_OPTION(fmt, value) \
+    off += (size_t)snprintf(options + off, off < sizeof(options) ? sizeof(options) - off : 0, \
+                            "%s" fmt, off ? "&" : "", value)
+
+    if (opts) {
+        if (opts->priority) APPEND_OPTION("priority=%d", opts->priority);
+        if (opts->timeout)  APPEND_OPTION("timeout=%d", opts->timeout);
+        if (opts->run_at)   APPEND_OPTION("at=%ld", (long)opts->run_at);
+        if (opts->delay)    APPEND_OPTION("delay=%d", opts->delay);
+        if (opts->every)    APPEND_OPTION("every=%d", opts->every);
+        if (opts->cron[0])  APPEND_OPTION("cron=%s", opts->cron);
+        if (opts->jitter)   APPEND_OPTION("jitter=%d", opts->jitter);
+        if (opts->client[0]) APPEND_OPTION("client=%s", opts->client);
+        if (opts->after[0]) APPEND_OPTION("after=%s", opts->after);
+        if (opts->batch[0]) APPEND_OPTION("batch=%s", opts->batch);
+        if (opts->needs[0]) APPEND_OPTION("needs=%s", opts->needs);
+        if (opts->deadline) APPEND_OPTION("deadline=%ld", (long)opts->deadline);
+        if (opts->due)      APPEND_OPTION("due=%d", opts->due);
+        if (opts->no_hedge) APPEND_OPTION("hedge=%d", 0);
+        if (opts->key[0])   APPEND_OPTION("key=%s", opts->key);
+    }
+#undef APPEND_OPTION
+
+    if (off >= sizeof(options)) return -1;
+    int len = off ? snprintf(buffer, size, "JOB?%s:%s", options, script)
+                  : snprintf(buffer, size, "JOB:%s", script);
+    return (len < 0 || (size_t)len >= size) ? -1 : 0;
+}
@@ -3,17 +3,27 @@
 
 #include <stddef.h>
 #include <time.h>
+#include <sys/types.h>
 #define MAX_SCRIPT_SIZE 1024
 #define MAX_RESULT_SIZE 2048
 #define SERVER_PORT 8080
 #define WORKER_TIMEOUT 30  // segundos
+#define WORKER_HEARTBEAT_INTERVAL 5  // segundos entre HEARTBEATs do worker
+#define REQUEST_JOB_WAIT_MS 1000  // espera máxima de REQUEST_JOB[:<ms>] por um job
+#define PROTOCOL_LINE_MAX 4608  // maior linha do protocolo texto (resultado escapado + cabeçalho)
+#define JOB_CLIENT_MAX 32       // nome do cliente/tenant (fila justa, ver job_queue.h)
+#define JOB_NEEDS_MAX 128       // capacidades exigidas, "tag,tag" (ver capability.h)
+#define JOB_KEY_MAX 64          // chave de idempotência (ver idempotency.h)
 
 typedef enum {
     JOB_PENDING = 0,
     JOB_RUNNING = 1,
     JOB_COMPLETED = 2,
     JOB_FAILED = 3,
-    JOB_TIMEOUT = 4
+    JOB_TIMEOUT = 4,
+    JOB_DEAD_LETTER = 5,        // esgotou as tentativas (ver lease_table.h)
+    JOB_CANCELLED = 6,
+    JOB_EXPIRED = 7             // prazo não cabia mais: descartado antes de rodar
 } job_status_t;
 
 typedef enum {
@@ -42,6 +52,12 @@ typedef struct {
     time_t submitted_at;        
     time_t started_at;         
     int assigned_worker;        
+    int attempts;               // tentativas que terminaram sem resultado
+    char client[JOB_CLIENT_MAX];  // quem submeteu ("" = anônimo)
+    char needs[JOB_NEEDS_MAX];  // capacidades que o worker precisa ter ("" = qualquer um)
+    time_t deadline;            // concluir até este instante (0 = sem prazo)
+    int no_hedge;               // não executar cópia especulativa (job não idempotente)
+    int lease_id;               // entrega em curso (ver lease_table.h); volta no resultado
 } job_t;
 
 typedef struct {
@@ -50,6 +66,7 @@ typedef struct {
     int active_jobs;
     time_t last_heartbeat;      
     int is_alive;               
+    double avg_latency;         // média móvel (s) entre entrega e resultado
 } worker_info_t;
 
 typedef struct {
@@ -62,8 +79,76 @@ typedef struct {
     } data;
 } message_t;
 
+// Opções de submissão: "JOB?chave=valor&chave=valor:<script>". Sem opções a
+// linha continua sendo "JOB:<script>".
+#define JOB_CRON_MAX 64
+#define JOB_AFTER_MAX 512
+
+typedef struct {
+    int priority;               // 0 = padrão do servidor
+    int timeout;                // 0 = padrão do servidor
+    time_t run_at;              // at=<epoch>: não roda antes desse instante
+    int delay;                  // delay=<s>: relativo ao relógio do servidor
+    int every;                  // every=<s>: recorrente com intervalo fixo
+    char cron[JOB_CRON_MAX];    // cron=<expr>: recorrente (ver cron_expr.h)
+    int jitter;                 // jitter=<s>: atraso aleatório em cada disparo
+    char client[JOB_CLIENT_MAX];  // client=<nome>: fila justa por cliente
+    char after[JOB_AFTER_MAX];  // after=<id>,<id>,@<batch>: só roda depois deles
+    char batch[JOB_CLIENT_MAX]; // batch=<nome>: entra no grupo (ver job_graph.h)
+    char needs[JOB_NEEDS_MAX];  // needs=<tag>,<tag>: capacidades exigidas do worker
+    time_t deadline;            // deadline=<epoch>: prazo de conclusão
+    int due;                    // due=<s>: prazo relativo ao relógio do servidor
+    int no_hedge;               // hedge=0: nunca duplicar o job (não idempotente)
+    char key[JOB_KEY_MAX];      // key=<chave>: reenvio com a mesma chave não duplica o job
+} job_options_t;
+
+// Lê a linha "JOB..." e preenche as opções; retorna o script ou NULL se a
+// linha ou alguma opção for inválida
+const char* protocol_parse_job(const char *line, job_options_t *opts);
+// Monta a linha "JOB..." com as opções diferentes de zero
+int protocol_format_job(const job_options_t *opts, const char *script, char *buffer, size_t size);
+
+// Interpretador que o executor usa para o script ("python3", "lua") ou NULL
+// para o shell. O servidor o inclui nas capacidades exigidas do job.
+const char* protocol_script_runtime(const char *script);
+
+// Nome do status nas respostas STATUS/LIST_JOBS ("PENDING", "RUNNING", ...)
+const char* protocol_status_name(job_status_t status);
+// Retorna -1 se o nome é desconhecido
+int protocol_status_from_name(const char *name, job_status_t *status);
+
 // Funções de serialização
 int serialize_message(const message_t *msg, char *buffer, size_t size);
 int deserialize_message(const char *buffer, size_t size, message_t *msg);
 
+// Protocolo texto: uma mensagem por linha terminada em '\n'
+#define LINE_READER_FDS 4       // descritores recebidos por SCM_RIGHTS (sockets AF_UNIX)
+
+// Fonte alternativa de bytes (ex.: io_uring, ver uring.h): como read(),
+// retorna <= 0 em EOF/erro
+typedef ssize_t (*line_source_t)(void *ctx, char *buf, size_t size);
+
+typedef struct {
+    char data[PROTOCOL_LINE_MAX];
+    size_t len;
+    int fds[LINE_READER_FDS];   // chegaram com os dados lidos; esperam quem os pegue
+    int fd_count;
+    line_source_t source;       // NULL = recvmsg/read no descritor
+    void *source_ctx;
+} line_reader_t;
+
+void line_reader_init(line_reader_t *lr);
+void line_reader_set_source(line_reader_t *lr, line_source_t source, void *ctx);
+// Retorna o tamanho da linha lida (sem '\n') ou -1 em EOF/erro
+ssize_t line_reader_next(line_reader_t *lr, int fd, char *line, size_t size);
+// Passa os descritores recebidos para quem chamou; retorna quantos
+int line_reader_take_fds(line_reader_t *lr, int *fds, int max);
+// Fecha os que ninguém pegou
+void line_reader_close_fds(line_reader_t *lr);
+int protocol_send_line(int fd, const char *line);
+
+// Escapa '\n', '\r' e '\\' para que saídas multilinha caibam em uma linha
+void protocol_escape(const char *src, char *dst, size_t size);
+void protocol_unescape(char *str);
+
 #endif
\ No newline at end of file
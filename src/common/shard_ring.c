@@ -0,0 +1,209 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <netdb.h>
+#include <sys/socket.h>
+#include "shard_ring.h"
+#include "local_transport.h"
+
+// FNV-1a com o finalizador do MurmurHash3: chaves parecidas ("shard-3#17",
+// "shard-3#18") caem longe umas das outras no anel
+uint64_t shard_hash(const char *key) {
+    uint64_t h = 1469598103934665603ULL;
+    for (const unsigned char *p = (const unsigned char*)key; *p; p++) {
+        h ^= *p;
+        h *= 1099511628211ULL;
+    }
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+int shard_of_id(int id) {
+    return id > 0 ? id % SHARD_MAX : -1;
+}
+
+int shard_align_id(int value, int shard) {
+    if (shard < 0) return value;
+    int id = value - value % SHARD_MAX + shard;
+    if (id < value) id += SHARD_MAX;
+    if (id <= 0) id += SHARD_MAX;
+    return id;
+}
+
+static int compare_points(const void *a, const void *b) {
+    uint64_t pa = ((const shard_point_t*)a)->point;
+    uint64_t pb = ((const shard_point_t*)b)->point;
+    return pa < pb ? -1 : pa > pb;
+}
+
+// Os pontos dependem só do número da shard: mudar host/porta ou a ordem da
+// lista não move nenhuma chave
+static void build_points(shard_ring_t *ring) {
+    ring->point_count = 0;
+    for (int i = 0; i < ring->count; i++) {
+        for (int v = 0; v < SHARD_VNODES; v++) {
+            char label[32];
+            snprintf(label, sizeof(label), "shard-%d#%d", ring->shards[i].number, v);
+            ring->points[ring->point_count].point = shard_hash(label);
+            ring->points[ring->point_count].index = i;
+            ring->point_count++;
+        }
+    }
+    qsort(ring->points, ring->point_count, sizeof(shard_point_t), compare_points);
+}
+
+// "host:porta" em [item, end)
+static int parse_address(const char *item, const char *end, char *host, int *port) {
+    const char *colon = NULL;
+    for (const char *p = item; p < end; p++) {
+        if (*p == ':') colon = p;
+    }
+    if (!colon || colon == item || (size_t)(colon - item) >= SHARD_HOST_MAX) return -1;
+    snprintf(host, SHARD_HOST_MAX, "%.*s", (int)(colon - item), item);
+
+    char digits[16];
+    size_t len = (size_t)(end - colon - 1);
+    if (len == 0 || len >= sizeof(digits)) return -1;
+    memcpy(digits, colon + 1, len);
+    digits[len] = '\0';
+    *port = atoi(digits);
+    return *port > 0 && *port <= 65535 ? 0 : -1;
+}
+
+// Lida direto da especificação, sem cópia: não há tamanho máximo a
+// respeitar nem lista cortada no meio de um endereço
+int shard_ring_parse(shard_ring_t *ring, const char *spec) {
+    if (!ring || !spec) return -1;
+    memset(ring, 0, sizeof(*ring));
+
+    for (const char *item = spec; *item; ) {
+        const char *end = strchr(item, ',');
+        if (!end) end = item + strlen(item);
+        const char *next = *end ? end + 1 : end;
+        if (end == item) {              // ",," ou vírgula no fim
+            item = next;
+            continue;
+        }
+        if (ring->count == SHARD_MAX) return -1;
+        shard_t *shard = &ring->shards[ring->count];
+
+        shard->number = ring->count;
+        const char *eq = memchr(item, '=', (size_t)(end - item));
+        if (eq) {
+            char *number_end;
+            shard->number = (int)strtol(item, &number_end, 10);
+            if (number_end != eq) return -1;
+            item = eq + 1;
+        }
+        const char *slash = memchr(item, '/', (size_t)(end - item));
+        if (slash) {
+            if (parse_address(slash + 1, end, shard->standby_host, &shard->standby_port) != 0) return -1;
+        }
+        if (parse_address(item, slash ? slash : end, shard->host, &shard->port) != 0) return -1;
+        if (shard->number < 0 || shard->number >= SHARD_MAX) return -1;
+        for (int i = 0; i < ring->count; i++) {
+            if (ring->shards[i].number == shard->number) return -1;
+        }
+        ring->count++;
+        item = next;
+    }
+    if (ring->count == 0) return -1;
+
+    build_points(ring);
+    return 0;
+}
+
+void shard_ring_single(shard_ring_t *ring, const char *host, int port) {
+    memset(ring, 0, sizeof(*ring));
+    ring->shards[0].number = -1;
+    snprintf(ring->shards[0].host, sizeof(ring->shards[0].host), "%s", host);
+    ring->shards[0].port = port;
+    ring->count = 1;
+}
+
+int shard_ring_configure(shard_ring_t *ring, const char *spec, int port) {
+    if (!spec || !spec[0]) spec = getenv(SHARD_ENV);
+    if (spec && spec[0]) return shard_ring_parse(ring, spec);
+    shard_ring_single(ring, "127.0.0.1", port);
+    return 0;
+}
+
+const shard_t *shard_ring_route(const shard_ring_t *ring, const char *key) {
+    if (!ring || ring->count == 0) return NULL;
+    if (ring->count == 1) return &ring->shards[0];
+
+    // Primeiro ponto >= hash (busca binária), dando a volta no fim do anel
+    uint64_t h = shard_hash(key ? key : "");
+    int lo = 0, hi = ring->point_count;
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (ring->points[mid].point < h) {
+            lo = mid + 1;
+        } else {
+            hi = mid;
+        }
+    }
+    return &ring->shards[ring->points[lo % ring->point_count].index];
+}
+
+const shard_t *shard_ring_owner(const shard_ring_t *ring, int id) {
+    if (!ring || ring->count == 0) return NULL;
+    if (ring->count == 1) return &ring->shards[0];
+
+    int number = shard_of_id(id);
+    for (int i = 0; i < ring->count; i++) {
+        if (ring->shards[i].number == number) return &ring->shards[i];
+    }
+    return NULL;
+}
+
+static int connect_address(const char *host, int port_number) {
+    struct addrinfo hints, *res = NULL;
+    char port[16];
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_UNSPEC;
+    hints.ai_socktype = SOCK_STREAM;
+    snprintf(port, sizeof(port), "%d", port_number);
+    if (getaddrinfo(host, port, &hints, &res) != 0) return -1;
+
+    int sock = -1;
+    for (struct addrinfo *ai = res; ai; ai = ai->ai_next) {
+        sock = socket(ai->ai_family, ai->ai_socktype, ai->ai_protocol);
+        if (sock < 0) continue;
+        if (connect(sock, ai->ai_addr, ai->ai_addrlen) == 0) break;
+        close(sock);
+        sock = -1;
+    }
+    freeaddrinfo(res);
+    return sock;
+}
+
+// Mesma máquina: o socket local do servidor, se ele estiver ouvindo
+static int connect_endpoint(const char *host, int port) {
+    int sock = local_connect(host, port);
+    return sock >= 0 ? sock : connect_address(host, port);
+}
+
+int shard_connect(const shard_t *shard) {
+    int sock = connect_endpoint(shard->host, shard->port);
+    if (sock < 0 && shard->standby_host[0]) {
+        sock = connect_endpoint(shard->standby_host, shard->standby_port);
+    }
+    return sock;
+}
+
+int shard_ring_failover(shard_ring_t *ring, const shard_t *shard) {
+    if (!ring || !shard || !shard->standby_host[0]) return -1;
+    shard_t *target = &ring->shards[shard - ring->shards];
+    shard_t old = *target;
+    memcpy(target->host, old.standby_host, sizeof(target->host));
+    target->port = old.standby_port;
+    memcpy(target->standby_host, old.host, sizeof(target->standby_host));
+    target->standby_port = old.port;
+    return 0;
+}
@@ -0,0 +1,67 @@
+#ifndef SHARD_RING_H
+#define SHARD_RING_H
+
+#include <stdint.h>
+
+// Várias instâncias do servidor, cada uma dona de uma shard. Duas regras:
+//  - submissões vão para a shard escolhida por hash consistente da chave de
+//    roteamento (batch, cliente/tenant ou chave de idempotência): cada shard
+//    ocupa SHARD_VNODES pontos do anel, derivados só do seu número, então
+//    incluir ou tirar uma shard move ~1/N das chaves e nada mais;
+//  - o id de um job (ou agendamento) criado na shard n satisfaz
+//    id % SHARD_MAX == n: STATUS, CANCEL e dependências vão direto à dona,
+//    que nunca muda depois de criado.
+// Especificação: "[n=]host:porta[/host:porta],..." (sem n, a posição na
+// lista; depois da barra, o standby da shard, ver replication.h), ou a
+// variável de ambiente SCHEDULER_SHARDS com o mesmo formato.
+
+#define SHARD_MAX 32                // números de shard possíveis (0..31)
+#define SHARD_VNODES 128            // pontos no anel por shard
+#define SHARD_HOST_MAX 64
+#define SHARD_ENV "SCHEDULER_SHARDS"
+
+typedef struct {
+    int number;                     // 0..SHARD_MAX-1, ou -1 = servidor único
+    char host[SHARD_HOST_MAX];
+    int port;
+    char standby_host[SHARD_HOST_MAX];  // "" = sem standby
+    int standby_port;
+} shard_t;
+
+typedef struct {
+    uint64_t point;
+    int index;                      // em shards[]
+} shard_point_t;
+
+typedef struct {
+    shard_t shards[SHARD_MAX];
+    int count;
+    shard_point_t points[SHARD_MAX * SHARD_VNODES];   // ordenados por point
+    int point_count;
+} shard_ring_t;
+
+// Lê a especificação; retorna -1 se inválida ou com números repetidos
+int shard_ring_parse(shard_ring_t *ring, const char *spec);
+// Um único servidor, sem divisão de ids
+void shard_ring_single(shard_ring_t *ring, const char *host, int port);
+// --shards (spec), senão SCHEDULER_SHARDS, senão 127.0.0.1:port
+int shard_ring_configure(shard_ring_t *ring, const char *spec, int port);
+
+// Shard das submissões com esta chave de roteamento
+const shard_t *shard_ring_route(const shard_ring_t *ring, const char *key);
+// Dona do job/agendamento `id`; NULL se a shard não está no anel
+const shard_t *shard_ring_owner(const shard_ring_t *ring, int id);
+
+uint64_t shard_hash(const char *key);
+int shard_of_id(int id);
+// Menor id >= value no espaço da shard (shard < 0: o próprio value)
+int shard_align_id(int value, int shard);
+
+// Conecta ao servidor da shard (se não responder, ao standby); retorna o
+// socket ou -1. Host de loopback: o socket local primeiro (local_transport.h)
+int shard_connect(const shard_t *shard);
+// O servidor da shard respondeu ERROR:NOT_PRIMARY ou sumiu: troca o
+// endereço principal com o do standby. Retorna -1 se a shard não tem standby.
+int shard_ring_failover(shard_ring_t *ring, const shard_t *shard);
+
+#endif
@@ -0,0 +1,444 @@
+#include "uring.h"
+
+#ifdef SCHED_IO_URING
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/syscall.h>
+#include <sys/uio.h>
+#include "protocol.h"
+
+#define TAG_RECV 1
+#define TAG_SEND 2
+#define TAG_READ 3
+
+static int sys_setup(unsigned entries, struct io_uring_params *params) {
+    return (int)syscall(__NR_io_uring_setup, entries, params);
+}
+
+static int sys_enter(int fd, unsigned to_submit, unsigned min_complete, unsigned flags) {
+    return (int)syscall(__NR_io_uring_enter, fd, to_submit, min_complete, flags, NULL, 0);
+}
+
+static int sys_register(int fd, unsigned opcode, void *arg, unsigned count) {
+    return (int)syscall(__NR_io_uring_register, fd, opcode, arg, count);
+}
+
+int uring_available(void) {
+    static atomic_int state = -1;       // -1 = ainda não testado
+    int value = atomic_load(&state);
+    if (value >= 0) return value;
+
+    const char *env = getenv(URING_ENV);
+    value = 0;
+    if (!env || strcmp(env, "0") != 0) {
+        uring_t probe;
+        if (uring_init(&probe, 2) == 0) {
+            uring_destroy(&probe);
+            value = 1;
+        }
+    }
+    atomic_store(&state, value);
+    return value;
+}
+
+int uring_init(uring_t *ring, unsigned entries) {
+    struct io_uring_params params;
+    memset(ring, 0, sizeof(*ring));
+    memset(&params, 0, sizeof(params));
+    // Completações processadas só quando a thread entra no kernel: menos
+    // interrupções para quem espera no próprio anel
+    params.flags = IORING_SETUP_COOP_TASKRUN;
+    ring->fd = sys_setup(entries, &params);
+    if (ring->fd < 0 && errno == EINVAL) {
+        params.flags = 0;
+        ring->fd = sys_setup(entries, &params);
+    }
+    if (ring->fd < 0) return -1;
+
+    ring->sq_entries = params.sq_entries;
+    ring->sq_size = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+    ring->cq_size = params.cq_off.cqes + params.cq_entries * sizeof(struct io_uring_cqe);
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        if (ring->cq_size > ring->sq_size) ring->sq_size = ring->cq_size;
+        ring->cq_size = ring->sq_size;
+    }
+    ring->sq_ptr = mmap(NULL, ring->sq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                        ring->fd, IORING_OFF_SQ_RING);
+    if (ring->sq_ptr == MAP_FAILED) goto fail;
+    if (params.features & IORING_FEAT_SINGLE_MMAP) {
+        ring->cq_ptr = ring->sq_ptr;
+    } else {
+        ring->cq_ptr = mmap(NULL, ring->cq_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                            ring->fd, IORING_OFF_CQ_RING);
+        if (ring->cq_ptr == MAP_FAILED) goto fail;
+    }
+    ring->sqes_size = params.sq_entries * sizeof(struct io_uring_sqe);
+    ring->sqes = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE,
+                      ring->fd, IORING_OFF_SQES);
+    if (ring->sqes == MAP_FAILED) goto fail;
+
+    char *sq = ring->sq_ptr, *cq = ring->cq_ptr;
+    ring->sq_head = (unsigned*)(sq + params.sq_off.head);
+    ring->sq_tail = (unsigned*)(sq + params.sq_off.tail);
+    ring->sq_mask = (unsigned*)(sq + params.sq_off.ring_mask);
+    ring->sq_array = (unsigned*)(sq + params.sq_off.array);
+    ring->cq_head = (unsigned*)(cq + params.cq_off.head);
+    ring->cq_tail = (unsigned*)(cq + params.cq_off.tail);
+    ring->cq_mask = (unsigned*)(cq + params.cq_off.ring_mask);
+    ring->cqes = (struct io_uring_cqe*)(cq + params.cq_off.cqes);
+    return 0;
+
+fail:
+    if (ring->sqes && ring->sqes != MAP_FAILED) munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr && ring->cq_ptr != MAP_FAILED && ring->cq_ptr != ring->sq_ptr) munmap(ring->cq_ptr, ring->cq_size);
+    if (ring->sq_ptr && ring->sq_ptr != MAP_FAILED) munmap(ring->sq_ptr, ring->sq_size);
+    close(ring->fd);
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+    return -1;
+}
+
+// Fechar o anel cancela o que ainda estava pendente (recv/accept multishot)
+void uring_destroy(uring_t *ring) {
+    if (ring->fd < 0) return;
+    close(ring->fd);
+    munmap(ring->sqes, ring->sqes_size);
+    if (ring->cq_ptr != ring->sq_ptr) munmap(ring->cq_ptr, ring->cq_size);
+    munmap(ring->sq_ptr, ring->sq_size);
+    if (ring->buf_ring) munmap(ring->buf_ring, ring->buf_ring_size);
+    free(ring->buffers);
+    memset(ring, 0, sizeof(*ring));
+    ring->fd = -1;
+}
+
+struct io_uring_sqe *uring_get_sqe(uring_t *ring) {
+    unsigned head = atomic_load_explicit((_Atomic unsigned*)ring->sq_head, memory_order_acquire);
+    unsigned tail = *ring->sq_tail + ring->to_submit;
+    if (tail - head >= ring->sq_entries) return NULL;
+
+    unsigned index = tail & *ring->sq_mask;
+    struct io_uring_sqe *sqe = &ring->sqes[index];
+    memset(sqe, 0, sizeof(*sqe));
+    ring->sq_array[index] = index;
+    ring->to_submit++;
+    return sqe;
+}
+
+int uring_enter(uring_t *ring, unsigned wait_nr) {
+    unsigned submit = ring->to_submit;
+    if (submit > 0) {
+        atomic_store_explicit((_Atomic unsigned*)ring->sq_tail, *ring->sq_tail + submit, memory_order_release);
+        ring->to_submit = 0;
+    }
+    if (submit == 0 && wait_nr == 0) return 0;
+
+    int rc;
+    do {
+        rc = sys_enter(ring->fd, submit, wait_nr, wait_nr ? IORING_ENTER_GETEVENTS : 0);
+        // Interrompido depois de submeter: só falta esperar
+        if (rc < 0 && errno == EINTR) submit = 0;
+    } while (rc < 0 && errno == EINTR);
+    return rc < 0 ? -1 : 0;
+}
+
+struct io_uring_cqe *uring_peek_cqe(uring_t *ring) {
+    unsigned head = *ring->cq_head;
+    unsigned tail = atomic_load_explicit((_Atomic unsigned*)ring->cq_tail, memory_order_acquire);
+    if (head == tail) return NULL;
+    return &ring->cqes[head & *ring->cq_mask];
+}
+
+void uring_cqe_seen(uring_t *ring) {
+    atomic_store_explicit((_Atomic unsigned*)ring->cq_head, *ring->cq_head + 1, memory_order_release);
+}
+
+/* ---- Buffers ---- */
+
+int uring_setup_buffers(uring_t *ring, int group, unsigned count, unsigned size) {
+    ring->buf_ring_size = count * sizeof(struct io_uring_buf);
+    ring->buf_ring = mmap(NULL, ring->buf_ring_size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+    if (ring->buf_ring == MAP_FAILED) {
+        ring->buf_ring = NULL;
+        return -1;
+    }
+    ring->buffers = malloc((size_t)count * size);
+    if (!ring->buffers) return -1;
+    ring->buf_count = count;
+    ring->buf_size = size;
+    ring->buf_group = group;
+
+    struct io_uring_buf_reg reg;
+    memset(&reg, 0, sizeof(reg));
+    reg.ring_addr = (unsigned long)ring->buf_ring;
+    reg.ring_entries = count;
+    reg.bgid = (unsigned short)group;
+    if (sys_register(ring->fd, IORING_REGISTER_PBUF_RING, &reg, 1) < 0) return -1;
+
+    for (unsigned bid = 0; bid < count; bid++) {
+        uring_recycle_buffer(ring, bid);
+    }
+    return 0;
+}
+
+char *uring_buffer(uring_t *ring, unsigned bid) {
+    return ring->buffers + (size_t)bid * ring->buf_size;
+}
+
+void uring_recycle_buffer(uring_t *ring, unsigned bid) {
+    unsigned short tail = ring->buf_ring->tail;
+    struct io_uring_buf *buf = &ring->buf_ring->bufs[tail & (ring->buf_count - 1)];
+    buf->addr = (unsigned long)uring_buffer(ring, bid);
+    buf->len = ring->buf_size;
+    buf->bid = (unsigned short)bid;
+    atomic_store_explicit((_Atomic unsigned short*)&ring->buf_ring->tail, (unsigned short)(tail + 1),
+                          memory_order_release);
+}
+
+int uring_register_buffer(uring_t *ring, void *base, size_t len) {
+    struct iovec iov = {base, len};
+    return sys_register(ring->fd, IORING_REGISTER_BUFFERS, &iov, 1) < 0 ? -1 : 0;
+}
+
+void uring_prep_recv_multishot(struct io_uring_sqe *sqe, int fd, int group, unsigned long long data) {
+    sqe->opcode = IORING_OP_RECV;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_RECV_MULTISHOT;
+    sqe->flags = IOSQE_BUFFER_SELECT;
+    sqe->buf_group = (unsigned short)group;
+    sqe->user_data = data;
+}
+
+void uring_prep_accept_multishot(struct io_uring_sqe *sqe, int fd, unsigned long long data) {
+    sqe->opcode = IORING_OP_ACCEPT;
+    sqe->fd = fd;
+    sqe->ioprio = IORING_ACCEPT_MULTISHOT;
+    sqe->user_data = data;
+}
+
+void uring_prep_send(struct io_uring_sqe *sqe, int fd, const void *buf, size_t len, unsigned long long data) {
+    sqe->opcode = IORING_OP_SEND;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long)buf;
+    sqe->len = (unsigned)len;
+    sqe->msg_flags = MSG_NOSIGNAL | MSG_WAITALL;
+    sqe->user_data = data;
+}
+
+void uring_prep_read_fixed(struct io_uring_sqe *sqe, int fd, void *buf, size_t len, unsigned long long data) {
+    sqe->opcode = IORING_OP_READ_FIXED;
+    sqe->fd = fd;
+    sqe->addr = (unsigned long)buf;
+    sqe->len = (unsigned)len;
+    sqe->off = (unsigned long long)-1;     // pipe: posição corrente
+    sqe->buf_index = 0;
+    sqe->user_data = data;
+}
+
+/* ---- Conexões ---- */
+
+int uring_conn_init(uring_conn_t *conn, int fd) {
+    memset(conn, 0, sizeof(*conn));
+    conn->fd = fd;
+    if (uring_init(&conn->ring, URING_ENTRIES) != 0) return -1;
+    if (uring_setup_buffers(&conn->ring, 0, URING_CONN_BUFFERS, URING_CONN_BUFFER_SIZE) != 0) {
+        uring_destroy(&conn->ring);
+        return -1;
+    }
+    return 0;
+}
+
+// Um SEND por vez: o próximo só sai quando o anterior completou, então as
+// linhas chegam na ordem em que foram acumuladas
+static void start_send(uring_conn_t *conn) {
+    if (conn->out_sending || conn->out_len == 0) return;
+    struct io_uring_sqe *sqe = uring_get_sqe(&conn->ring);
+    if (!sqe) return;
+    conn->out_sending = conn->out_len;
+    uring_prep_send(sqe, conn->fd, conn->out, conn->out_sending, TAG_SEND);
+}
+
+static void arm_recv(uring_conn_t *conn) {
+    if (conn->armed || conn->eof) return;
+    struct io_uring_sqe *sqe = uring_get_sqe(&conn->ring);
+    if (!sqe) return;
+    uring_prep_recv_multishot(sqe, conn->fd, conn->ring.buf_group, TAG_RECV);
+    conn->armed = 1;
+}
+
+static void reap(uring_conn_t *conn) {
+    struct io_uring_cqe *cqe;
+    while ((cqe = uring_peek_cqe(&conn->ring)) != NULL) {
+        int res = cqe->res;
+        unsigned flags = cqe->flags;
+        unsigned long long tag = cqe->user_data;
+        uring_cqe_seen(&conn->ring);
+
+        if (tag == TAG_RECV) {
+            if (res > 0 && (flags & IORING_CQE_F_BUFFER)) {
+                int slot = (conn->ready_head + conn->ready_count) % URING_CONN_BUFFERS;
+                conn->ready[slot] = flags >> IORING_CQE_BUFFER_SHIFT;
+                conn->ready_len[slot] = (size_t)res;
+                conn->ready_count++;
+            } else if (res != -ENOBUFS) {
+                // 0 = o outro lado não escreve mais (pode ainda ler as
+                // respostas); ENOBUFS só pede um novo recv
+                conn->eof = 1;
+            }
+            if (!(flags & IORING_CQE_F_MORE)) conn->armed = 0;
+        } else if (tag == TAG_SEND) {
+            if (res < 0) {
+                conn->broken = 1;
+                conn->out_len = 0;
+            } else {
+                size_t sent = (size_t)res;
+                memmove(conn->out, conn->out + sent, conn->out_len - sent);
+                conn->out_len -= sent;
+            }
+            conn->out_sending = 0;
+        }
+    }
+}
+
+ssize_t uring_conn_fill(void *ctx, char *buf, size_t size) {
+    uring_conn_t *conn = (uring_conn_t*)ctx;
+
+    while (conn->ready_count == 0) {
+        if (conn->eof) return -1;
+        arm_recv(conn);
+        start_send(conn);
+        if (uring_enter(&conn->ring, 1) != 0) {
+            conn->eof = conn->broken = 1;
+            return -1;
+        }
+        reap(conn);
+    }
+
+    unsigned bid = conn->ready[conn->ready_head];
+    size_t available = conn->ready_len[conn->ready_head] - conn->offset;
+    size_t n = available < size ? available : size;
+    memcpy(buf, uring_buffer(&conn->ring, bid) + conn->offset, n);
+    conn->offset += n;
+    if (conn->offset == conn->ready_len[conn->ready_head]) {
+        uring_recycle_buffer(&conn->ring, bid);
+        conn->ready_head = (conn->ready_head + 1) % URING_CONN_BUFFERS;
+        conn->ready_count--;
+        conn->offset = 0;
+    }
+    return (ssize_t)n;
+}
+
+// O buffer não cresce com um SEND em voo (ele aponta para out): a linha
+// espera o envio terminar
+int uring_conn_queue(uring_conn_t *conn, const char *line) {
+    if (conn->broken) return -1;
+    size_t len = strlen(line);
+    if (len >= PROTOCOL_LINE_MAX) len = PROTOCOL_LINE_MAX - 1;
+
+    while (conn->out_len + len + 1 > conn->out_cap) {
+        if (conn->out_sending && uring_conn_flush(conn) != 0) return -1;
+        size_t cap = conn->out_cap ? conn->out_cap * 2 : 2 * PROTOCOL_LINE_MAX;
+        char *out = realloc(conn->out, cap);
+        if (!out) return -1;
+        conn->out = out;
+        conn->out_cap = cap;
+    }
+    memcpy(conn->out + conn->out_len, line, len);
+    conn->out[conn->out_len + len] = '\n';
+    conn->out_len += len + 1;
+    return 0;
+}
+
+int uring_conn_flush(uring_conn_t *conn) {
+    while ((conn->out_len > 0 || conn->out_sending) && !conn->broken) {
+        start_send(conn);
+        if (uring_enter(&conn->ring, 1) != 0) {
+            conn->broken = 1;
+            break;
+        }
+        reap(conn);
+    }
+    return conn->broken ? -1 : 0;
+}
+
+void uring_conn_destroy(uring_conn_t *conn) {
+    uring_conn_flush(conn);
+    uring_destroy(&conn->ring);
+    free(conn->out);
+    conn->out = NULL;
+    conn->out_len = conn->out_cap = 0;
+}
+
+/* ---- Pipe do filho ---- */
+
+typedef struct {
+    uring_t ring;
+    char buffer[URING_CONN_BUFFER_SIZE];    // registrado (IORING_REGISTER_BUFFERS)
+} pipe_ring_t;
+
+static pthread_key_t pipe_key;
+static pthread_once_t pipe_once = PTHREAD_ONCE_INIT;
+
+static void pipe_ring_free(void *value) {
+    pipe_ring_t *pr = (pipe_ring_t*)value;
+    uring_destroy(&pr->ring);
+    free(pr);
+}
+
+static void pipe_key_create(void) {
+    pthread_key_create(&pipe_key, pipe_ring_free);
+}
+
+// Um anel por thread executora, criado no primeiro job
+static pipe_ring_t *pipe_ring(void) {
+    pthread_once(&pipe_once, pipe_key_create);
+    pipe_ring_t *pr = pthread_getspecific(pipe_key);
+    if (pr) return pr;
+
+    pr = calloc(1, sizeof(pipe_ring_t));
+    if (!pr) return NULL;
+    if (uring_init(&pr->ring, 4) != 0) {
+        free(pr);
+        return NULL;
+    }
+    if (uring_register_buffer(&pr->ring, pr->buffer, sizeof(pr->buffer)) != 0) {
+        uring_destroy(&pr->ring);
+        free(pr);
+        return NULL;
+    }
+    pthread_setspecific(pipe_key, pr);
+    return pr;
+}
+
+ssize_t uring_read_pipe(int fd, char *out, size_t size) {
+    pipe_ring_t *pr = uring_available() ? pipe_ring() : NULL;
+    if (!pr || size == 0) return -1;
+
+    size_t limit = size - 1 < sizeof(pr->buffer) ? size - 1 : sizeof(pr->buffer);
+    size_t total = 0;
+    while (total < limit) {
+        struct io_uring_sqe *sqe = uring_get_sqe(&pr->ring);
+        if (!sqe) break;
+        uring_prep_read_fixed(sqe, fd, pr->buffer + total, limit - total, TAG_READ);
+        if (uring_enter(&pr->ring, 1) != 0) break;
+
+        struct io_uring_cqe *cqe = uring_peek_cqe(&pr->ring);
+        int res = cqe ? cqe->res : -EIO;
+        if (cqe) uring_cqe_seen(&pr->ring);
+        if (res == -EINTR || res == -EAGAIN) continue;
+        if (res <= 0) break;
+        total += (size_t)res;
+    }
+    memcpy(out, pr->buffer, total);
+    out[total] = '\0';
+    return (ssize_t)total;
+}
+
+#endif
@@ -0,0 +1,121 @@
+#ifndef URING_H
+#define URING_H
+
+// Backend io_uring opcional (make IO_URING=1 define SCHED_IO_URING), com as
+// chamadas de sistema diretas (sem liburing). Sem a flag nada daqui é
+// compilado e servidor e worker usam read/send/accept como sempre.
+//
+// Um anel por thread que faz I/O: o handler de cada conexão TCP do
+// servidor, a thread que aceita conexões, o leitor do socket do worker e
+// cada executor (pipe do filho). Os anéis não são compartilhados entre
+// threads, então nada aqui tem lock.
+//  - Leitura de socket: um recv multishot com buffers fornecidos (anel de
+//    buffers registrado no kernel); cada io_uring_enter traz todos os
+//    pedaços que chegaram desde o último.
+//  - Escrita: as respostas do handler ficam num buffer e vão num único
+//    SEND, submetido no mesmo io_uring_enter que espera o próximo pedido.
+//  - Accept: multishot, uma submissão para todas as conexões.
+//  - Pipe do filho: READ_FIXED num buffer registrado uma vez por thread.
+
+#ifdef SCHED_IO_URING
+
+#include <stddef.h>
+#include <sys/types.h>
+#include <linux/io_uring.h>
+
+#define URING_ENTRIES 16
+#define URING_CONN_BUFFERS 8            // buffers de recv por conexão
+#define URING_CONN_BUFFER_SIZE 4096
+#define URING_ENV "SCHEDULER_IO_URING"  // "0": usar o caminho portável mesmo compilado
+
+typedef struct {
+    int fd;
+    unsigned *sq_head;
+    unsigned *sq_tail;
+    unsigned *sq_mask;
+    unsigned *sq_array;
+    struct io_uring_sqe *sqes;
+    unsigned *cq_head;
+    unsigned *cq_tail;
+    unsigned *cq_mask;
+    struct io_uring_cqe *cqes;
+    void *sq_ptr;
+    void *cq_ptr;
+    size_t sq_size;
+    size_t cq_size;
+    size_t sqes_size;
+    unsigned sq_entries;
+    unsigned to_submit;                 // preparadas desde o último enter
+
+    // Buffers fornecidos (recv multishot): anel registrado com IORING_REGISTER_PBUF_RING
+    struct io_uring_buf_ring *buf_ring;
+    size_t buf_ring_size;
+    char *buffers;
+    unsigned buf_count;
+    unsigned buf_size;
+    int buf_group;
+} uring_t;
+
+// 1 se o kernel aceita io_uring (e URING_ENV não desligou); testado uma vez
+int uring_available(void);
+int uring_init(uring_t *ring, unsigned entries);
+void uring_destroy(uring_t *ring);
+
+// NULL se a fila de submissão está cheia (chame uring_enter antes)
+struct io_uring_sqe *uring_get_sqe(uring_t *ring);
+// Submete as preparadas e espera até wait_nr completarem: um io_uring_enter
+int uring_enter(uring_t *ring, unsigned wait_nr);
+// Próxima completação ou NULL; uring_cqe_seen libera a posição
+struct io_uring_cqe *uring_peek_cqe(uring_t *ring);
+void uring_cqe_seen(uring_t *ring);
+
+int uring_setup_buffers(uring_t *ring, int group, unsigned count, unsigned size);
+char *uring_buffer(uring_t *ring, unsigned bid);
+// Devolve o buffer ao kernel (só memória: sem chamada de sistema)
+void uring_recycle_buffer(uring_t *ring, unsigned bid);
+int uring_register_buffer(uring_t *ring, void *base, size_t len);
+
+void uring_prep_recv_multishot(struct io_uring_sqe *sqe, int fd, int group, unsigned long long data);
+void uring_prep_accept_multishot(struct io_uring_sqe *sqe, int fd, unsigned long long data);
+void uring_prep_send(struct io_uring_sqe *sqe, int fd, const void *buf, size_t len, unsigned long long data);
+void uring_prep_read_fixed(struct io_uring_sqe *sqe, int fd, void *buf, size_t len, unsigned long long data);
+
+// Conexão com recv multishot e respostas acumuladas. Uma thread por vez.
+typedef struct {
+    uring_t ring;
+    int fd;
+    int armed;                          // recv multishot ativo
+    int eof;                            // recv deu 0 ou erro: sem mais pedidos
+    int broken;                         // SEND falhou: nada mais sai pelo socket
+    unsigned ready[URING_CONN_BUFFERS]; // buffers recebidos ainda não consumidos
+    size_t ready_len[URING_CONN_BUFFERS];
+    int ready_head;
+    int ready_count;
+    size_t offset;                      // já consumido de ready[ready_head]
+    char *out;                          // respostas ainda não enviadas
+    size_t out_len;
+    size_t out_cap;
+    size_t out_sending;                 // bytes de out no SEND em voo (0 = nenhum)
+} uring_conn_t;
+
+int uring_conn_init(uring_conn_t *conn, int fd);
+// Envia o que falta e libera o anel (o socket continua de quem chamou)
+void uring_conn_destroy(uring_conn_t *conn);
+// Fonte do line_reader (line_reader_set_source): envia as respostas
+// acumuladas e espera dados no mesmo io_uring_enter
+ssize_t uring_conn_fill(void *ctx, char *buf, size_t size);
+// Acumula a linha (com '\n'); vai no próximo fill ou flush. Continua
+// valendo depois do EOF de leitura (shutdown(SHUT_WR) do outro lado): as
+// respostas aos pedidos já lidos ainda saem
+int uring_conn_queue(uring_conn_t *conn, const char *line);
+// Espera o envio de tudo o que foi acumulado (antes de outra thread
+// escrever no socket); -1 se o envio falhou
+int uring_conn_flush(uring_conn_t *conn);
+
+// Lê o pipe até EOF ou `size - 1` bytes com READ_FIXED no buffer
+// registrado da thread; retorna o total lido (texto terminado em '\0')
+// ou -1 se o anel não está disponível
+ssize_t uring_read_pipe(int fd, char *out, size_t size);
+
+#endif
+#endif
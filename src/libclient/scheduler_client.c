@@ -0,0 +1,1227 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <stdint.h>
+#include <sys/time.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include "scheduler_client.h"
+
+#define EVENT_BATCH 64
+#define WAKE_EVENT UINT32_MAX
+#define RECONNECT_MAX_MS 5000
+#define TIMEOUT_CHECK_MS 100        // granularidade do response_timeout
+
+typedef enum {
+    REQUEST_SUBMIT,
+    REQUEST_COMMAND,
+    REQUEST_WAIT,                   // STATUS repetido até o job terminar
+    REQUEST_SUBSCRIBE,
+    REQUEST_UNSUBSCRIBE
+} request_kind_t;
+
+struct sched_request {
+    request_kind_t kind;
+    int shard;
+    char *line;                     // sem o '\n'
+    int job_id;                     // REQUEST_WAIT
+    long deadline_ms;               // REQUEST_WAIT: 0 = sem prazo
+    int poll_ms;
+    int attempts;                   // RETRY_AFTER/perdas seguidas
+    long backoff;
+    int failed_over;                // REQUEST_COMMAND/SUBSCRIBE: já trocou de servidor
+    sched_subscription_t *sub;      // REQUEST_SUBSCRIBE
+    long sent_ms;
+    long due_ms;                    // no heap de timers
+    sched_callback_t callback;
+    void *arg;
+    sched_request_t *next;
+};
+
+struct sched_conn {
+    int shard;
+    int sock;                       // -1 = fechada
+    line_reader_t reader;
+    sched_request_t *head;          // em voo, na ordem de envio
+    sched_request_t *tail;
+    int inflight;
+    char *out;                      // linhas ainda não aceitas pelo socket
+    size_t out_len;
+    size_t out_sent;
+    size_t out_cap;
+    int want_write;                 // EPOLLOUT ligado
+};
+
+// Só a thread da biblioteca mexe depois de criada
+struct sched_subscription {
+    char topic[SCHED_TOPIC_MAX];
+    int shard;
+    int conn;                       // conexão onde o servidor a tem; -1 = nenhuma
+    int pending;                    // SUBSCRIBE em voo
+    int removed;                    // unsubscribe: liberar quando não houver SUBSCRIBE em voo
+    int listed;                     // já em client->subscriptions
+    sched_notify_t notify;
+    void *arg;
+    sched_subscription_t *next;
+};
+
+struct sched_timer_heap {
+    sched_request_t **items;        // min-heap por due_ms
+    int size;
+    int capacity;
+};
+
+struct sched_future {
+    pthread_mutex_t mutex;
+    pthread_cond_t done_cond;
+    int done;
+    int refs;                       // quem chamou + o callback
+    sched_reply_t reply;
+};
+
+static long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static int is_final(job_status_t status) {
+    return status != JOB_PENDING && status != JOB_RUNNING;
+}
+
+void sched_client_config_init(sched_client_config_t *config) {
+    config->pool_size = SCHED_POOL_SIZE;
+    config->pipeline_depth = SCHED_PIPELINE_DEPTH;
+    config->max_outstanding = SCHED_MAX_OUTSTANDING;
+    config->response_timeout_ms = SCHED_RESPONSE_TIMEOUT_MS;
+    config->submit_retries = SCHED_SUBMIT_RETRIES;
+}
+
+/* ---- Conexões avulsas ---- */
+
+int sched_connect(const shard_t *shard, tslog_t *logger) {
+    int sock = shard_connect(shard);
+    if (sock < 0) {
+        if (logger) tslog_error(logger, "Erro ao conectar com servidor %s:%d", shard->host, shard->port);
+        return -1;
+    }
+    if (logger) tslog_info(logger, "Conectado ao servidor %s:%d", shard->host, shard->port);
+    return sock;
+}
+
+int sched_call(const shard_t *shard, const char *line, char *response, size_t size, int timeout_ms,
+               tslog_t *logger) {
+    int sock = sched_connect(shard, logger);
+    if (sock < 0) return -1;
+
+    if (timeout_ms > 0) {
+        struct timeval tv = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+    }
+    if (protocol_send_line(sock, line) < 0) {
+        if (logger) tslog_error(logger, "Erro ao enviar comando");
+        close(sock);
+        return -1;
+    }
+
+    line_reader_t reader;
+    line_reader_init(&reader);
+    response[0] = '\0';
+    line_reader_next(&reader, sock, response, size);
+    close(sock);
+    return 0;
+}
+
+/* ---- Roteamento ---- */
+
+void sched_client_make_key(char *key, size_t size) {
+    static atomic_uint sequence;
+    char host[32] = "local";
+    struct timespec now;
+    gethostname(host, sizeof(host) - 1);
+    host[strspn(host, "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ0123456789_.-")] = '\0';
+    clock_gettime(CLOCK_REALTIME, &now);
+    // Sequência: submissões no mesmo nanossegundo (API assíncrona) não colidem
+    snprintf(key, size, "%.20s-%d-%lx%08lx-%x", host, (int)getpid(), (long)now.tv_sec, now.tv_nsec,
+             atomic_fetch_add(&sequence, 1));
+}
+
+static int index_of(const sched_client_t *client, const shard_t *shard) {
+    return shard ? (int)(shard - client->ring.shards) : -1;
+}
+
+// Acumula em *target a shard escolhida; -1 se já havia outra
+static int same_shard(int *target, int shard) {
+    if (*target >= 0 && *target != shard) return -1;
+    *target = shard;
+    return 0;
+}
+
+// A dona das dependências por id (o grafo de dependências é local a cada
+// servidor, então têm de estar todas juntas), senão a do batch, a do
+// cliente/tenant ou, por último, a da chave de idempotência (reenvios da
+// mesma submissão caem sempre no mesmo servidor)
+int sched_client_route(const sched_client_t *client, const job_options_t *opts) {
+    int target = -1;
+    char route_key[JOB_KEY_MAX + 16];
+
+    char after[sizeof(opts->after)];
+    snprintf(after, sizeof(after), "%s", opts->after);
+    char *save = NULL;
+    for (char *dep = strtok_r(after, ",", &save); dep; dep = strtok_r(NULL, ",", &save)) {
+        int owner;
+        if (dep[0] == '@') {
+            snprintf(route_key, sizeof(route_key), "batch:%s", dep + 1);
+            owner = index_of(client, shard_ring_route(&client->ring, route_key));
+        } else if ((owner = sched_client_owner(client, atoi(dep))) < 0) {
+            return -1;
+        }
+        if (same_shard(&target, owner) != 0) {
+            if (client->logger) tslog_error(client->logger, "Dependências em shards diferentes: %s", opts->after);
+            return -1;
+        }
+    }
+    if (opts->batch[0]) {
+        snprintf(route_key, sizeof(route_key), "batch:%s", opts->batch);
+        if (same_shard(&target, index_of(client, shard_ring_route(&client->ring, route_key))) != 0) {
+            if (client->logger) {
+                tslog_error(client->logger, "Batch %s fica em outra shard que as dependências", opts->batch);
+            }
+            return -1;
+        }
+    }
+    if (target >= 0) return target;
+
+    if (opts->client[0]) {
+        snprintf(route_key, sizeof(route_key), "client:%s", opts->client);
+    } else {
+        snprintf(route_key, sizeof(route_key), "key:%s", opts->key);
+    }
+    return index_of(client, shard_ring_route(&client->ring, route_key));
+}
+
+int sched_client_owner(const sched_client_t *client, int id) {
+    int shard = index_of(client, shard_ring_owner(&client->ring, id));
+    if (shard < 0 && client->logger) {
+        tslog_error(client->logger, "Id %d pertence à shard %d, fora da lista", id, shard_of_id(id));
+    }
+    return shard;
+}
+
+/* ---- Timers (min-heap por due_ms) ---- */
+
+static void heap_swap(sched_timer_heap_t *heap, int a, int b) {
+    sched_request_t *tmp = heap->items[a];
+    heap->items[a] = heap->items[b];
+    heap->items[b] = tmp;
+}
+
+static int timer_add(sched_timer_heap_t *heap, sched_request_t *req, long due_ms) {
+    if (heap->size == heap->capacity) {
+        int capacity = heap->capacity ? heap->capacity * 2 : 256;
+        sched_request_t **grown = realloc(heap->items, (size_t)capacity * sizeof(sched_request_t*));
+        if (!grown) return -1;
+        heap->items = grown;
+        heap->capacity = capacity;
+    }
+    req->due_ms = due_ms;
+    int i = heap->size++;
+    heap->items[i] = req;
+    while (i > 0 && heap->items[(i - 1) / 2]->due_ms > heap->items[i]->due_ms) {
+        heap_swap(heap, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    return 0;
+}
+
+static sched_request_t *timer_pop(sched_timer_heap_t *heap) {
+    if (heap->size == 0) return NULL;
+    sched_request_t *top = heap->items[0];
+    heap->items[0] = heap->items[--heap->size];
+    int i = 0;
+    while (1) {
+        int left = 2 * i + 1, right = left + 1, smallest = i;
+        if (left < heap->size && heap->items[left]->due_ms < heap->items[smallest]->due_ms) smallest = left;
+        if (right < heap->size && heap->items[right]->due_ms < heap->items[smallest]->due_ms) smallest = right;
+        if (smallest == i) break;
+        heap_swap(heap, i, smallest);
+        i = smallest;
+    }
+    return top;
+}
+
+/* ---- Pedidos ---- */
+
+static void backlog_push(sched_client_t *client, sched_request_t *req) {
+    req->next = NULL;
+    if (client->backlog_tail[req->shard]) {
+        client->backlog_tail[req->shard]->next = req;
+    } else {
+        client->backlog[req->shard] = req;
+    }
+    client->backlog_tail[req->shard] = req;
+}
+
+// Lista (já encadeada) volta para a frente da fila da shard
+static void backlog_push_front(sched_client_t *client, int shard, sched_request_t *head, sched_request_t *tail) {
+    if (!head) return;
+    tail->next = client->backlog[shard];
+    client->backlog[shard] = head;
+    if (!client->backlog_tail[shard]) client->backlog_tail[shard] = tail;
+}
+
+static void parse_reply(sched_reply_t *reply) {
+    char status[16];
+    if (sscanf(reply->line, "JOB_ACCEPTED:%d", &reply->id) == 1) {
+        return;
+    }
+    if (sscanf(reply->line, "JOB_SCHEDULED:%d", &reply->id) == 1) {
+        reply->scheduled = 1;
+        return;
+    }
+    if (sscanf(reply->line, "JOB_STATUS:%d:%15[^:]", &reply->id, status) == 2) {
+        protocol_status_from_name(status, &reply->status);
+        return;
+    }
+    if (strncmp(reply->line, "ERROR:", 6) == 0) {
+        reply->result = SCHED_REJECTED;
+    }
+}
+
+static sched_request_t *new_request(sched_client_t *client, request_kind_t kind, int shard, const char *line,
+                                    sched_callback_t callback, void *arg);
+static int timer_add(sched_timer_heap_t *heap, sched_request_t *req, long due_ms);
+static int conn_queue(sched_conn_t *conn, sched_request_t *req);
+static void conn_flush(sched_client_t *client, sched_conn_t *conn);
+
+/* ---- Assinaturas ---- */
+
+static void subscription_unlink(sched_client_t *client, sched_subscription_t *sub) {
+    for (sched_subscription_t **p = &client->subscriptions; *p; p = &(*p)->next) {
+        if (*p == sub) {
+            *p = sub->next;
+            break;
+        }
+    }
+    free(sub);
+}
+
+// SUBSCRIBE (de novo) pela fila da shard, depois de delay_ms
+static void resubscribe(sched_client_t *client, sched_subscription_t *sub, long delay_ms) {
+    char line[SCHED_TOPIC_MAX + 16];
+    snprintf(line, sizeof(line), "SUBSCRIBE:%s", sub->topic);
+    sched_request_t *req = new_request(client, REQUEST_SUBSCRIBE, sub->shard, line, NULL, NULL);
+    if (!req) return;
+    req->sub = sub;
+    sub->pending = 1;
+    if (delay_ms > 0 && timer_add(client->timers, req, now_ms() + delay_ms) == 0) return;
+    backlog_push(client, req);
+}
+
+// UNSUBSCRIBE na conexão que tem a assinatura (a resposta vem na ordem dela)
+static void unsubscribe_on(sched_client_t *client, sched_subscription_t *sub) {
+    sched_conn_t *conn = &client->conns[sub->conn];
+    char line[SCHED_TOPIC_MAX + 16];
+    snprintf(line, sizeof(line), "UNSUBSCRIBE:%s", sub->topic);
+    sched_request_t *req = new_request(client, REQUEST_UNSUBSCRIBE, sub->shard, line, NULL, NULL);
+    if (!req) return;
+    if (conn->sock < 0 || conn_queue(conn, req) != 0) {
+        free(req->line);
+        free(req);
+        atomic_fetch_sub(&client->outstanding, 1);
+        return;
+    }
+    if (!conn->want_write) conn_flush(client, conn);
+}
+
+static void notify_lost(sched_subscription_t *sub, long lost) {
+    sched_notification_t notification;
+    memset(&notification, 0, sizeof(notification));
+    snprintf(notification.topic, sizeof(notification.topic), "%s", sub->topic);
+    notification.lost = lost;
+    sub->notify(&notification, sub->arg);
+}
+
+// Resposta (ou falha) de um SUBSCRIBE
+static void subscription_done(sched_client_t *client, sched_request_t *req, const char *line) {
+    sched_subscription_t *sub = req->sub;
+    int ok = line && strncmp(line, "SUBSCRIBED:", 11) == 0;
+    sub->pending = 0;
+    if (!ok) sub->conn = -1;
+
+    if (sub->removed) {
+        if (ok) unsubscribe_on(client, sub);
+        subscription_unlink(client, sub);
+    } else if (!ok && !req->callback && !atomic_load(&client->stop)) {
+        // Reassinatura interna: o servidor voltará a existir
+        resubscribe(client, sub, SCHED_RESUBSCRIBE_MS);
+    }
+}
+
+// Conexão perdida: o servidor esqueceu as assinaturas que estavam nela
+static void subscriptions_lost(sched_client_t *client, int conn_index) {
+    sched_subscription_t *sub = client->subscriptions;
+    while (sub) {
+        sched_subscription_t *next = sub->next;
+        if (sub->conn == conn_index) {
+            sub->conn = -1;
+            if (sub->removed && !sub->pending) {
+                subscription_unlink(client, sub);
+            } else if (!sub->removed) {
+                notify_lost(sub, 1);
+                if (!sub->pending) resubscribe(client, sub, 0);
+            }
+        }
+        sub = next;
+    }
+}
+
+// "NOTIFY:<tópico>:<id>:<STATUS>:<tempo>:<saída>" ou "NOTIFY_LOST:<n>"
+static void dispatch_notification(sched_client_t *client, int conn_index, const char *line) {
+    sched_notification_t notification;
+    memset(&notification, 0, sizeof(notification));
+    if (strncmp(line, "NOTIFY_LOST:", 12) == 0) {
+        for (sched_subscription_t *sub = client->subscriptions; sub; sub = sub->next) {
+            if (sub->conn == conn_index && !sub->removed) notify_lost(sub, atol(line + 12));
+        }
+        return;
+    }
+
+    const char *topic = line + 7;
+    size_t topic_len = strcspn(topic, ":");
+    char status[16];
+    int offset = 0;
+    if (topic_len >= sizeof(notification.topic) ||
+        sscanf(topic + topic_len, ":%d:%15[^:]:%lf:%n", &notification.id, status, &notification.exec_time,
+               &offset) != 3 || protocol_status_from_name(status, &notification.status) != 0) {
+        if (client->logger) tslog_warn(client->logger, "Notificação mal formatada: %.80s", line);
+        return;
+    }
+    memcpy(notification.topic, topic, topic_len);
+    snprintf(notification.output, sizeof(notification.output), "%s", topic + topic_len + offset);
+    protocol_unescape(notification.output);
+
+    // job= vale para um término só: o servidor já esqueceu a assinatura
+    int once = strncmp(notification.topic, "job=", 4) == 0;
+    sched_subscription_t *sub = client->subscriptions;
+    while (sub) {
+        sched_subscription_t *next = sub->next;
+        if (sub->conn == conn_index && strcmp(sub->topic, notification.topic) == 0) {
+            if (!sub->removed) sub->notify(&notification, sub->arg);
+            if (once) {
+                sub->conn = -1;
+                sub->removed = 1;
+                if (!sub->pending) subscription_unlink(client, sub);
+            }
+        }
+        sub = next;
+    }
+}
+
+static void complete(sched_client_t *client, sched_request_t *req, sched_result_t result, const char *line) {
+    if (req->kind == REQUEST_SUBSCRIBE) {
+        subscription_done(client, req, result == SCHED_OK ? line : NULL);
+    }
+    sched_reply_t reply;
+    memset(&reply, 0, sizeof(reply));
+    reply.result = result;
+    reply.status = JOB_PENDING;
+    reply.id = req->kind == REQUEST_WAIT ? req->job_id : 0;
+    if (line) {
+        snprintf(reply.line, sizeof(reply.line), "%s", line);
+        if (result == SCHED_OK) parse_reply(&reply);
+    }
+    if (req->callback) req->callback(&reply, req->arg);
+    free(req->line);
+    free(req);
+    atomic_fetch_sub(&client->outstanding, 1);
+}
+
+// RETRY_AFTER ou resposta perdida: espera o sugerido, dobrando a cada vez
+// seguida, com jitter para os clientes não voltarem juntos
+static void retry_later(sched_client_t *client, sched_request_t *req, long hint, const char *line) {
+    if (++req->attempts > client->config.submit_retries) {
+        if (client->logger) {
+            tslog_warn(client->logger, "Desistindo depois de %s (%d tentativas)",
+                       line && line[0] ? line : "perder a conexão", req->attempts);
+        }
+        complete(client, req, line && line[0] ? SCHED_REJECTED : SCHED_UNAVAILABLE, line);
+        return;
+    }
+    req->backoff = req->backoff ? req->backoff * 2 : hint;
+    if (req->backoff < hint) req->backoff = hint;
+    if (req->backoff > SCHED_BACKOFF_MAX_MS) req->backoff = SCHED_BACKOFF_MAX_MS;
+    long delay = req->backoff + rand_r(&client->seed) % (req->backoff / 2 + 1);
+    if (client->logger) {
+        tslog_warn(client->logger, "%s: nova tentativa em %ldms", line && line[0] ? line : "Sem resposta", delay);
+    }
+    if (timer_add(client->timers, req, now_ms() + delay) != 0) {
+        complete(client, req, SCHED_UNAVAILABLE, line);
+    }
+}
+
+static void schedule_poll(sched_client_t *client, sched_request_t *req) {
+    long due = now_ms() + req->poll_ms;
+    if (req->deadline_ms && due > req->deadline_ms) due = req->deadline_ms;
+    req->poll_ms = req->poll_ms * 2 < SCHED_WAIT_POLL_MAX_MS ? req->poll_ms * 2 : SCHED_WAIT_POLL_MAX_MS;
+    if (timer_add(client->timers, req, due) != 0) {
+        complete(client, req, SCHED_UNAVAILABLE, NULL);
+    }
+}
+
+static int failover(sched_client_t *client, int shard) {
+    return shard_ring_failover(&client->ring, &client->ring.shards[shard]);
+}
+
+static void handle_reply(sched_client_t *client, sched_request_t *req, const char *line) {
+    int not_primary = strcmp(line, "ERROR:NOT_PRIMARY") == 0;
+
+    switch (req->kind) {
+    case REQUEST_SUBMIT:
+        if (strncmp(line, "RETRY_AFTER:", 12) == 0) {
+            retry_later(client, req, atol(line + 12), line);
+        } else if (not_primary) {
+            // Standby ainda não promovido: como uma resposta perdida
+            failover(client, req->shard);
+            retry_later(client, req, SCHED_LOST_RETRY_MS, line);
+        } else {
+            complete(client, req, SCHED_OK, line);
+        }
+        break;
+
+    case REQUEST_SUBSCRIBE:
+    case REQUEST_UNSUBSCRIBE:
+    case REQUEST_COMMAND:
+        if (not_primary && !req->failed_over && failover(client, req->shard) == 0) {
+            if (req->sub) req->sub->conn = -1;
+            req->failed_over = 1;
+            backlog_push_front(client, req->shard, req, req);
+        } else {
+            complete(client, req, SCHED_OK, line);
+        }
+        break;
+
+    case REQUEST_WAIT: {
+        char name[16];
+        job_status_t status;
+        if (not_primary) {
+            failover(client, req->shard);
+        } else if (sscanf(line, "JOB_STATUS:%*d:%15[^:]", name) != 1 ||
+                   protocol_status_from_name(name, &status) != 0) {
+            complete(client, req, SCHED_OK, line);      // ERROR:job desconhecido
+            break;
+        } else if (is_final(status)) {
+            complete(client, req, SCHED_OK, line);
+            break;
+        }
+        if (req->deadline_ms && now_ms() >= req->deadline_ms) {
+            complete(client, req, SCHED_TIMEOUT, line);
+        } else {
+            schedule_poll(client, req);
+        }
+        break;
+    }
+    }
+}
+
+/* ---- Conexões do pool ---- */
+
+static void conn_update_events(sched_client_t *client, sched_conn_t *conn, int want_write) {
+    if (conn->want_write == want_write) return;
+    struct epoll_event ev;
+    ev.events = EPOLLIN | (want_write ? EPOLLOUT : 0);
+    ev.data.u32 = (uint32_t)(conn - client->conns);
+    epoll_ctl(client->epoll_fd, EPOLL_CTL_MOD, conn->sock, &ev);
+    conn->want_write = want_write;
+}
+
+// Conexão perdida ou muda: os pedidos em voo voltam para a frente da fila
+// da shard e saem de novo numa conexão nova
+static void conn_fail(sched_client_t *client, sched_conn_t *conn, const char *reason) {
+    const shard_t *shard = &client->ring.shards[conn->shard];
+    if (client->logger && atomic_load(&client->stop)) {
+        tslog_debug(client->logger, "Conexão com %s:%d fechada", shard->host, shard->port);
+    } else if (client->logger) {
+        tslog_warn(client->logger, "Conexão com %s:%d: %s (%d pedidos em voo reenviados)",
+                   shard->host, shard->port, reason, conn->inflight);
+    }
+    close(conn->sock);
+    conn->sock = -1;
+    conn->out_len = conn->out_sent = 0;
+    conn->want_write = 0;
+
+    sched_request_t *head = NULL, *tail = NULL;
+    sched_request_t *req = conn->head;
+    while (req) {
+        sched_request_t *next = req->next;
+        if (req->kind == REQUEST_SUBMIT && ++req->attempts > client->config.submit_retries) {
+            complete(client, req, SCHED_UNAVAILABLE, NULL);
+        } else {
+            req->next = NULL;
+            if (tail) tail->next = req; else head = req;
+            tail = req;
+        }
+        req = next;
+    }
+    conn->head = conn->tail = NULL;
+    conn->inflight = 0;
+    backlog_push_front(client, conn->shard, head, tail);
+    if (!atomic_load(&client->stop)) subscriptions_lost(client, (int)(conn - client->conns));
+}
+
+static void conn_flush(sched_client_t *client, sched_conn_t *conn) {
+    while (conn->out_sent < conn->out_len) {
+        ssize_t n = send(conn->sock, conn->out + conn->out_sent, conn->out_len - conn->out_sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            conn_update_events(client, conn, 1);
+            return;
+        }
+        if (n <= 0) {
+            conn_fail(client, conn, "erro no envio");
+            return;
+        }
+        conn->out_sent += (size_t)n;
+    }
+    conn->out_len = conn->out_sent = 0;
+    conn_update_events(client, conn, 0);
+}
+
+static int conn_queue(sched_conn_t *conn, sched_request_t *req) {
+    size_t need = strlen(req->line) + 1;
+    if (conn->out_len + need > conn->out_cap) {
+        // Compacta o que já saiu antes de crescer
+        if (conn->out_sent > 0) {
+            memmove(conn->out, conn->out + conn->out_sent, conn->out_len - conn->out_sent);
+            conn->out_len -= conn->out_sent;
+            conn->out_sent = 0;
+        }
+        size_t cap = conn->out_cap ? conn->out_cap : 16 * 1024;
+        while (cap < conn->out_len + need) cap *= 2;
+        if (cap != conn->out_cap) {
+            char *grown = realloc(conn->out, cap);
+            if (!grown) return -1;
+            conn->out = grown;
+            conn->out_cap = cap;
+        }
+    }
+    memcpy(conn->out + conn->out_len, req->line, need - 1);
+    conn->out[conn->out_len + need - 1] = '\n';
+    conn->out_len += need;
+
+    req->next = NULL;
+    req->sent_ms = now_ms();
+    if (conn->tail) conn->tail->next = req; else conn->head = req;
+    conn->tail = req;
+    conn->inflight++;
+    return 0;
+}
+
+static void conn_read(sched_client_t *client, sched_conn_t *conn) {
+    char line[PROTOCOL_LINE_MAX];
+    while (conn->sock >= 0) {
+        errno = 0;      // conexão fechada não mexe em errno
+        if (line_reader_next(&conn->reader, conn->sock, line, sizeof(line)) < 0) {
+            if (errno != EAGAIN && errno != EWOULDBLOCK) {
+                conn_fail(client, conn, "conexão fechada pelo servidor");
+            }
+            return;
+        }
+        // Push do servidor: não responde a nenhum pedido
+        if (strncmp(line, "NOTIFY", 6) == 0) {
+            dispatch_notification(client, (int)(conn - client->conns), line);
+            continue;
+        }
+        sched_request_t *req = conn->head;
+        if (!req) continue;     // linha sem pedido (não deveria acontecer)
+        conn->head = req->next;
+        if (!conn->head) conn->tail = NULL;
+        conn->inflight--;
+        handle_reply(client, req, line);
+    }
+}
+
+static int conn_open(sched_client_t *client, sched_conn_t *conn) {
+    const shard_t *shard = &client->ring.shards[conn->shard];
+    int sock = sched_connect(shard, client->logger);
+    if (sock < 0) return -1;
+
+    int flag = 1;
+    setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, &flag, sizeof(flag));
+    fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK);
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u32 = (uint32_t)(conn - client->conns);
+    if (epoll_ctl(client->epoll_fd, EPOLL_CTL_ADD, sock, &ev) != 0) {
+        close(sock);
+        return -1;
+    }
+    conn->sock = sock;
+    conn->want_write = 0;
+    line_reader_init(&conn->reader);
+    return 0;
+}
+
+// Conexão da shard com espaço no pipeline, abrindo outra do pool quando as
+// abertas já têm pedidos em voo. NULL se não há nenhuma agora.
+static sched_conn_t *pick_conn(sched_client_t *client, int shard, long now) {
+    sched_conn_t *pool = &client->conns[shard * client->config.pool_size];
+    sched_conn_t *best = NULL, *closed = NULL;
+    for (int i = 0; i < client->config.pool_size; i++) {
+        if (pool[i].sock < 0) {
+            if (!closed) closed = &pool[i];
+        } else if (pool[i].inflight < client->config.pipeline_depth &&
+                   (!best || pool[i].inflight < best->inflight)) {
+            best = &pool[i];
+        }
+    }
+    if ((best && best->inflight == 0) || !closed || now < client->retry_at[shard]) return best;
+
+    if (conn_open(client, closed) == 0) {
+        client->connect_failures[shard] = 0;
+        return closed;
+    }
+    int failures = ++client->connect_failures[shard];
+    long delay = (long)SCHED_RECONNECT_MS << (failures - 1 < 5 ? failures - 1 : 5);
+    client->retry_at[shard] = now + (delay < RECONNECT_MAX_MS ? delay : RECONNECT_MAX_MS);
+    return best;
+}
+
+// Nenhuma conexão com a shard depois de SCHED_CONNECT_RETRIES tentativas:
+// os pedidos esperando por ela falham
+static void fail_backlog(sched_client_t *client, int shard) {
+    sched_request_t *req = client->backlog[shard];
+    client->backlog[shard] = client->backlog_tail[shard] = NULL;
+    client->connect_failures[shard] = 0;
+    while (req) {
+        sched_request_t *next = req->next;
+        complete(client, req, SCHED_UNAVAILABLE, NULL);
+        req = next;
+    }
+}
+
+static void pump(sched_client_t *client, int shard, long now) {
+    while (client->backlog[shard]) {
+        sched_conn_t *conn = pick_conn(client, shard, now);
+        if (!conn) {
+            if (client->connect_failures[shard] >= SCHED_CONNECT_RETRIES) fail_backlog(client, shard);
+            break;
+        }
+        sched_request_t *req = client->backlog[shard];
+        client->backlog[shard] = req->next;
+        if (!client->backlog[shard]) client->backlog_tail[shard] = NULL;
+
+        if (req->kind == REQUEST_WAIT && req->deadline_ms && now >= req->deadline_ms) {
+            complete(client, req, SCHED_TIMEOUT, NULL);
+            continue;
+        }
+        if (conn_queue(conn, req) != 0) {
+            complete(client, req, SCHED_UNAVAILABLE, NULL);
+        } else if (req->sub) {
+            req->sub->conn = (int)(conn - client->conns);
+        }
+    }
+    // Um send por conexão com tudo o que foi enfileirado nela
+    sched_conn_t *pool = &client->conns[shard * client->config.pool_size];
+    for (int i = 0; i < client->config.pool_size; i++) {
+        if (pool[i].sock >= 0 && !pool[i].want_write && pool[i].out_sent < pool[i].out_len) {
+            conn_flush(client, &pool[i]);
+        }
+    }
+}
+
+/* ---- Thread da biblioteca ---- */
+
+// Pedido de unsubscribe do usuário: as assinaturas do tópico param de
+// notificar já; no servidor saem pela conexão onde estão
+static void unsubscribe_local(sched_client_t *client, const char *topic) {
+    sched_subscription_t *sub = client->subscriptions;
+    while (sub) {
+        sched_subscription_t *next = sub->next;
+        if (!sub->removed && strcmp(sub->topic, topic) == 0) {
+            sub->removed = 1;
+            if (!sub->pending) {
+                if (sub->conn >= 0) unsubscribe_on(client, sub);
+                subscription_unlink(client, sub);
+            }
+        }
+        sub = next;
+    }
+}
+
+static void take_incoming(sched_client_t *client) {
+    uint64_t count;
+    if (read(client->wake_fd, &count, sizeof(count)) < 0 && errno != EAGAIN) return;
+
+    pthread_mutex_lock(&client->mutex);
+    sched_request_t *req = client->incoming;
+    client->incoming = client->incoming_tail = NULL;
+    pthread_mutex_unlock(&client->mutex);
+
+    while (req) {
+        sched_request_t *next = req->next;
+        if (req->kind == REQUEST_UNSUBSCRIBE) {
+            unsubscribe_local(client, req->line + 12);
+            complete(client, req, SCHED_OK, NULL);
+        } else {
+            if (req->sub && !req->sub->listed) {
+                req->sub->listed = 1;
+                req->sub->next = client->subscriptions;
+                client->subscriptions = req->sub;
+            }
+            backlog_push(client, req);
+        }
+        req = next;
+    }
+}
+
+static void check_response_timeouts(sched_client_t *client, long now) {
+    int total = client->ring.count * client->config.pool_size;
+    for (int i = 0; i < total; i++) {
+        sched_conn_t *conn = &client->conns[i];
+        if (conn->sock >= 0 && conn->head && now - conn->head->sent_ms > client->config.response_timeout_ms) {
+            conn_fail(client, conn, "sem resposta no prazo");
+        }
+    }
+}
+
+static int next_timeout(sched_client_t *client, long now) {
+    long timeout = -1;
+    if (client->timers->size > 0) {
+        timeout = client->timers->items[0]->due_ms - now;
+    }
+    for (int s = 0; s < client->ring.count; s++) {
+        if (!client->backlog[s]) continue;
+        long wait = client->retry_at[s] - now;
+        if (timeout < 0 || wait < timeout) timeout = wait;
+    }
+    if (atomic_load(&client->outstanding) > 0 && (timeout < 0 || timeout > TIMEOUT_CHECK_MS)) {
+        timeout = TIMEOUT_CHECK_MS;
+    }
+    return timeout < 0 ? -1 : (int)(timeout > 0 ? timeout : 0);
+}
+
+static void fail_everything(sched_client_t *client) {
+    take_incoming(client);
+    int total = client->ring.count * client->config.pool_size;
+    for (int i = 0; i < total; i++) {
+        sched_conn_t *conn = &client->conns[i];
+        if (conn->sock >= 0) conn_fail(client, conn, "");
+    }
+    for (int s = 0; s < client->ring.count; s++) fail_backlog(client, s);
+    sched_request_t *req;
+    while ((req = timer_pop(client->timers)) != NULL) {
+        complete(client, req, SCHED_UNAVAILABLE, NULL);
+    }
+}
+
+static void *client_thread(void *arg) {
+    sched_client_t *client = (sched_client_t*)arg;
+    struct epoll_event events[EVENT_BATCH];
+
+    while (!atomic_load(&client->stop)) {
+        int n = epoll_wait(client->epoll_fd, events, EVENT_BATCH, next_timeout(client, now_ms()));
+        if (n < 0 && errno != EINTR) break;
+
+        for (int i = 0; i < n; i++) {
+            if (events[i].data.u32 == WAKE_EVENT) {
+                take_incoming(client);
+                continue;
+            }
+            sched_conn_t *conn = &client->conns[events[i].data.u32];
+            if (conn->sock < 0) continue;
+            if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) conn_read(client, conn);
+            if (conn->sock >= 0 && (events[i].events & EPOLLOUT)) conn_flush(client, conn);
+        }
+
+        long now = now_ms();
+        while (client->timers->size > 0 && client->timers->items[0]->due_ms <= now) {
+            sched_request_t *req = timer_pop(client->timers);
+            backlog_push(client, req);
+        }
+        check_response_timeouts(client, now);
+        for (int s = 0; s < client->ring.count; s++) {
+            if (client->backlog[s]) pump(client, s, now);
+        }
+    }
+
+    fail_everything(client);
+    return NULL;
+}
+
+int sched_client_init(sched_client_t *client, const shard_ring_t *ring,
+                      const sched_client_config_t *config, tslog_t *logger) {
+    if (!client || !ring || ring->count == 0) return -1;
+    memset(client, 0, sizeof(*client));
+    client->ring = *ring;
+    client->logger = logger;
+    if (config) {
+        client->config = *config;
+    } else {
+        sched_client_config_init(&client->config);
+    }
+    if (client->config.pool_size < 1) client->config.pool_size = 1;
+    if (client->config.pipeline_depth < 1) client->config.pipeline_depth = 1;
+    client->seed = (unsigned int)time(NULL) ^ (unsigned int)getpid();
+
+    int total = ring->count * client->config.pool_size;
+    client->conns = calloc((size_t)total, sizeof(sched_conn_t));
+    client->backlog = calloc(SHARD_MAX, sizeof(sched_request_t*));
+    client->backlog_tail = calloc(SHARD_MAX, sizeof(sched_request_t*));
+    client->connect_failures = calloc(SHARD_MAX, sizeof(int));
+    client->retry_at = calloc(SHARD_MAX, sizeof(long));
+    client->timers = calloc(1, sizeof(sched_timer_heap_t));
+    client->wake_fd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    client->epoll_fd = epoll_create1(EPOLL_CLOEXEC);
+    if (!client->conns || !client->backlog || !client->backlog_tail || !client->connect_failures ||
+        !client->retry_at || !client->timers || client->wake_fd < 0 || client->epoll_fd < 0) {
+        goto fail;
+    }
+    for (int i = 0; i < total; i++) {
+        client->conns[i].shard = i / client->config.pool_size;
+        client->conns[i].sock = -1;
+    }
+
+    struct epoll_event ev;
+    ev.events = EPOLLIN;
+    ev.data.u32 = WAKE_EVENT;
+    if (epoll_ctl(client->epoll_fd, EPOLL_CTL_ADD, client->wake_fd, &ev) != 0) goto fail;
+
+    pthread_mutex_init(&client->mutex, NULL);
+    if (pthread_create(&client->thread, NULL, client_thread, client) != 0) {
+        pthread_mutex_destroy(&client->mutex);
+        goto fail;
+    }
+    return 0;
+
+fail:
+    if (client->wake_fd >= 0) close(client->wake_fd);
+    if (client->epoll_fd >= 0) close(client->epoll_fd);
+    free(client->conns);
+    free(client->backlog);
+    free(client->backlog_tail);
+    free(client->connect_failures);
+    free(client->retry_at);
+    free(client->timers);
+    return -1;
+}
+
+void sched_client_destroy(sched_client_t *client) {
+    if (!client || !client->conns) return;
+    atomic_store(&client->stop, 1);
+    uint64_t one = 1;
+    if (write(client->wake_fd, &one, sizeof(one)) < 0) {
+        // eventfd cheio: a thread já tem o que acordar
+    }
+    pthread_join(client->thread, NULL);
+
+    int total = client->ring.count * client->config.pool_size;
+    for (int i = 0; i < total; i++) free(client->conns[i].out);
+    while (client->subscriptions) {
+        sched_subscription_t *next = client->subscriptions->next;
+        free(client->subscriptions);
+        client->subscriptions = next;
+    }
+    close(client->wake_fd);
+    close(client->epoll_fd);
+    pthread_mutex_destroy(&client->mutex);
+    free(client->conns);
+    free(client->backlog);
+    free(client->backlog_tail);
+    free(client->connect_failures);
+    free(client->retry_at);
+    free(client->timers->items);
+    free(client->timers);
+    client->conns = NULL;
+}
+
+/* ---- API ---- */
+
+static sched_request_t *new_request(sched_client_t *client, request_kind_t kind, int shard, const char *line,
+                                    sched_callback_t callback, void *arg) {
+    if (shard < 0 || shard >= client->ring.count) return NULL;
+    if (atomic_fetch_add(&client->outstanding, 1) >= client->config.max_outstanding) {
+        atomic_fetch_sub(&client->outstanding, 1);
+        return NULL;
+    }
+    sched_request_t *req = calloc(1, sizeof(sched_request_t));
+    if (req) req->line = strdup(line);
+    if (!req || !req->line) {
+        free(req);
+        atomic_fetch_sub(&client->outstanding, 1);
+        return NULL;
+    }
+    req->kind = kind;
+    req->shard = shard;
+    req->callback = callback;
+    req->arg = arg;
+    return req;
+}
+
+static int start(sched_client_t *client, sched_request_t *req) {
+    pthread_mutex_lock(&client->mutex);
+    if (client->incoming_tail) {
+        client->incoming_tail->next = req;
+    } else {
+        client->incoming = req;
+    }
+    client->incoming_tail = req;
+    pthread_mutex_unlock(&client->mutex);
+
+    uint64_t one = 1;
+    if (write(client->wake_fd, &one, sizeof(one)) < 0 && errno != EAGAIN) return -1;
+    return 0;
+}
+
+int sched_client_submit_async(sched_client_t *client, const char *script, const job_options_t *opts,
+                              sched_callback_t callback, void *arg) {
+    // Toda submissão leva uma chave de idempotência: reenviar depois de uma
+    // conexão perdida nunca cria um segundo job
+    job_options_t keyed;
+    if (opts) {
+        keyed = *opts;
+    } else {
+        memset(&keyed, 0, sizeof(keyed));
+    }
+    if (!keyed.key[0]) {
+        sched_client_make_key(keyed.key, sizeof(keyed.key));
+    }
+
+    char message[PROTOCOL_LINE_MAX];
+    if (protocol_format_job(&keyed, script, message, sizeof(message)) != 0) return -1;
+    sched_request_t *req = new_request(client, REQUEST_SUBMIT, sched_client_route(client, &keyed), message,
+                                       callback, arg);
+    return req ? start(client, req) : -1;
+}
+
+int sched_client_status_async(sched_client_t *client, int job_id, sched_callback_t callback, void *arg) {
+    char message[64];
+    snprintf(message, sizeof(message), "STATUS:%d", job_id);
+    sched_request_t *req = new_request(client, REQUEST_COMMAND, sched_client_owner(client, job_id), message,
+                                       callback, arg);
+    return req ? start(client, req) : -1;
+}
+
+int sched_client_wait_async(sched_client_t *client, int job_id, int timeout_ms,
+                            sched_callback_t callback, void *arg) {
+    char message[64];
+    snprintf(message, sizeof(message), "STATUS:%d", job_id);
+    sched_request_t *req = new_request(client, REQUEST_WAIT, sched_client_owner(client, job_id), message,
+                                       callback, arg);
+    if (!req) return -1;
+    req->job_id = job_id;
+    req->poll_ms = SCHED_WAIT_POLL_MS;
+    req->deadline_ms = timeout_ms > 0 ? now_ms() + timeout_ms : 0;
+    return start(client, req);
+}
+
+int sched_client_command_async(sched_client_t *client, int shard, const char *line,
+                               sched_callback_t callback, void *arg) {
+    sched_request_t *req = new_request(client, REQUEST_COMMAND, shard, line, callback, arg);
+    return req ? start(client, req) : -1;
+}
+
+int sched_client_unsubscribe(sched_client_t *client, const char *topic) {
+    if (strlen(topic) >= SCHED_TOPIC_MAX) return -1;
+    char line[SCHED_TOPIC_MAX + 16];
+    snprintf(line, sizeof(line), "UNSUBSCRIBE:%s", topic);
+    sched_request_t *req = new_request(client, REQUEST_UNSUBSCRIBE, 0, line, NULL, NULL);
+    return req ? start(client, req) : -1;
+}
+
+/* ---- Futures ---- */
+
+static void future_release(sched_future_t *future) {
+    pthread_mutex_lock(&future->mutex);
+    int last = --future->refs == 0;
+    pthread_mutex_unlock(&future->mutex);
+    if (last) {
+        pthread_mutex_destroy(&future->mutex);
+        pthread_cond_destroy(&future->done_cond);
+        free(future);
+    }
+}
+
+static void future_complete(const sched_reply_t *reply, void *arg) {
+    sched_future_t *future = (sched_future_t*)arg;
+    pthread_mutex_lock(&future->mutex);
+    future->reply = *reply;
+    future->done = 1;
+    pthread_cond_broadcast(&future->done_cond);
+    pthread_mutex_unlock(&future->mutex);
+    future_release(future);
+}
+
+static sched_future_t *new_future(void) {
+    sched_future_t *future = calloc(1, sizeof(sched_future_t));
+    if (!future) return NULL;
+    pthread_mutex_init(&future->mutex, NULL);
+    pthread_cond_init(&future->done_cond, NULL);
+    future->refs = 2;
+    return future;
+}
+
+// O pedido não foi aceito: o callback nunca vai soltar a sua referência
+static sched_future_t *started(sched_future_t *future, int rc) {
+    if (rc == 0) return future;
+    future->refs = 1;
+    future_release(future);
+    return NULL;
+}
+
+sched_future_t *sched_client_submit_future(sched_client_t *client, const char *script,
+                                           const job_options_t *opts) {
+    sched_future_t *future = new_future();
+    return future ? started(future, sched_client_submit_async(client, script, opts, future_complete, future)) : NULL;
+}
+
+sched_future_t *sched_client_status_future(sched_client_t *client, int job_id) {
+    sched_future_t *future = new_future();
+    return future ? started(future, sched_client_status_async(client, job_id, future_complete, future)) : NULL;
+}
+
+sched_future_t *sched_client_wait_future(sched_client_t *client, int job_id, int timeout_ms) {
+    sched_future_t *future = new_future();
+    return future ? started(future, sched_client_wait_async(client, job_id, timeout_ms, future_complete, future))
+                  : NULL;
+}
+
+sched_future_t *sched_client_command_future(sched_client_t *client, int shard, const char *line) {
+    sched_future_t *future = new_future();
+    return future ? started(future, sched_client_command_async(client, shard, line, future_complete, future))
+                  : NULL;
+}
+
+int sched_future_wait(sched_future_t *future, int timeout_ms) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+    deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+    deadline.tv_nsec %= 1000000000L;
+
+    pthread_mutex_lock(&future->mutex);
+    int rc = 0;
+    while (!future->done && rc == 0) {
+        if (timeout_ms > 0) {
+            rc = pthread_cond_timedwait(&future->done_cond, &future->mutex, &deadline);
+        } else {
+            pthread_cond_wait(&future->done_cond, &future->mutex);
+        }
+    }
+    int done = future->done;
+    pthread_mutex_unlock(&future->mutex);
+    return done ? 0 : 1;
+}
+
+const sched_reply_t *sched_future_reply(sched_future_t *future) {
+    return &future->reply;
+}
+
+void sched_future_free(sched_future_t *future) {
+    if (future) future_release(future);
+}
+
+// Shards que podem publicar o tópico; retorna quantas
+static int topic_shards(sched_client_t *client, const char *topic, int *shards) {
+    if (strncmp(topic, "job=", 4) == 0) {
+        int owner = sched_client_owner(client, atoi(topic + 4));
+        if (owner < 0) return 0;
+        shards[0] = owner;
+        return 1;
+    }
+    if (strncmp(topic, "batch=", 6) == 0) {
+        // A mesma rota das submissões com batch= (ver sched_client_route)
+        char route_key[SCHED_TOPIC_MAX + 8];
+        snprintf(route_key, sizeof(route_key), "batch:%s", topic + 6);
+        shards[0] = index_of(client, shard_ring_route(&client->ring, route_key));
+        return shards[0] >= 0 ? 1 : 0;
+    }
+    for (int s = 0; s < client->ring.count; s++) shards[s] = s;
+    return client->ring.count;
+}
+
+int sched_client_subscribe(sched_client_t *client, const char *topic, sched_notify_t notify, void *arg) {
+    int shards[SHARD_MAX];
+    sched_future_t *futures[SHARD_MAX];
+    if (!notify || strlen(topic) >= SCHED_TOPIC_MAX) return -1;
+    int count = topic_shards(client, topic, shards);
+    if (count == 0) return -1;
+
+    char line[SCHED_TOPIC_MAX + 16];
+    snprintf(line, sizeof(line), "SUBSCRIBE:%s", topic);
+    int issued = 0;
+    for (; issued < count; issued++) {
+        sched_subscription_t *sub = calloc(1, sizeof(sched_subscription_t));
+        sched_future_t *future = sub ? new_future() : NULL;
+        sched_request_t *req = future ? new_request(client, REQUEST_SUBSCRIBE, shards[issued], line,
+                                                    future_complete, future) : NULL;
+        if (!req) {
+            free(sub);
+            if (future) started(future, -1);
+            break;
+        }
+        snprintf(sub->topic, sizeof(sub->topic), "%s", topic);
+        sub->shard = shards[issued];
+        sub->conn = -1;
+        sub->pending = 1;
+        sub->notify = notify;
+        sub->arg = arg;
+        req->sub = sub;
+        futures[issued] = future;
+        start(client, req);
+    }
+
+    int ok = issued == count;
+    for (int i = 0; i < issued; i++) {
+        sched_future_wait(futures[i], 0);
+        if (strncmp(sched_future_reply(futures[i])->line, "SUBSCRIBED:", 11) != 0) {
+            if (ok && client->logger) {
+                tslog_error(client->logger, "Assinatura de %s recusada: %s", topic,
+                            sched_future_reply(futures[i])->line[0] ? sched_future_reply(futures[i])->line
+                                                                   : "sem servidor");
+            }
+            ok = 0;
+        }
+        sched_future_free(futures[i]);
+    }
+    if (!ok) {
+        sched_client_unsubscribe(client, topic);
+        return -1;
+    }
+    return 0;
+}
+
+/* ---- Bloqueantes ---- */
+
+static int finish(sched_future_t *future, sched_reply_t *reply) {
+    if (!future) return -1;
+    sched_future_wait(future, 0);
+    if (reply) *reply = *sched_future_reply(future);
+    sched_future_free(future);
+    return 0;
+}
+
+int sched_client_submit(sched_client_t *client, const char *script, const job_options_t *opts,
+                        sched_reply_t *reply) {
+    return finish(sched_client_submit_future(client, script, opts), reply);
+}
+
+int sched_client_status(sched_client_t *client, int job_id, sched_reply_t *reply) {
+    return finish(sched_client_status_future(client, job_id), reply);
+}
+
+int sched_client_wait(sched_client_t *client, int job_id, int timeout_ms, sched_reply_t *reply) {
+    return finish(sched_client_wait_future(client, job_id, timeout_ms), reply);
+}
+
+int sched_client_command(sched_client_t *client, int shard, const char *line, sched_reply_t *reply) {
+    return finish(sched_client_command_future(client, shard, line), reply);
+}
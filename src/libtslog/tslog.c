@@ -1,46 +1,517 @@
 #include "tslog.h"
+#include "tslog_binary.h"
+#include "tslog_internal.h"
 #include <stdarg.h>
 #include <string.h>
 #include <stdlib.h>
+#include <stdint.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sched.h>
+
+#define TSLOG_LINE_MAX 4096
+#define TSLOG_DEFAULT_RING_SIZE (64 * 1024)
+#define TSLOG_MIN_RING_SIZE (8 * 1024)
+#define TSLOG_BATCH_SIZE (64 * 1024)
+#define TSLOG_TLS_SLOTS 4
+#define TSLOG_RING_PAD 0xFFFFFFFFu
+#define TSLOG_WRITER_IDLE_MS 20
+
+// Buffer circular de bytes de uma thread (um produtor, um consumidor).
+// Cada registro é [uint32 tamanho][linha formatada], alinhado a 8 bytes;
+// um tamanho TSLOG_RING_PAD indica que o restante até o fim do buffer é vazio.
+// O consumidor é sempre quem detém logger->mutex (writer, flush ou fallback sync).
+struct tslog_ring {
+    struct tslog_ring *next;
+    atomic_int owned;           // 1 enquanto alguma thread usa este buffer
+    size_t size;                // potência de 2
+    char *buf;
+    atomic_size_t head __attribute__((aligned(64)));   // escrito pelo produtor
+    atomic_size_t tail __attribute__((aligned(64)));   // escrito pelo consumidor
+};
+
+typedef struct {
+    tslog_t *logger;
+    unsigned long async_id;
+    tslog_ring_t *ring;
+} tls_slot_t;
+
+static __thread tls_slot_t tls_slots[TSLOG_TLS_SLOTS];
+static pthread_key_t tls_key;
+static pthread_once_t tls_once = PTHREAD_ONCE_INIT;
+static atomic_ulong next_async_id = 1;
+static tslog_t *crash_logger = NULL;
+static volatile sig_atomic_t crashing = 0;
+
+void tslog_write_all(int fd, const char *data, size_t len) {
+    while (len > 0) {
+        ssize_t n = write(fd, data, len);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return;
+        data += n;
+        len -= (size_t)n;
+    }
+}
+
+// Toda escrita no arquivo passa por aqui, sempre com logger->mutex travado
+static void write_all(tslog_t *logger, const char *data, size_t len) {
+    if (!crashing) {
+        tslog_rotation_before_write(logger, len);
+    }
+    tslog_write_all(logger->fd, data, len);
+}
+
+static size_t record_size(size_t len) {
+    return (4 + len + 7) & ~(size_t)7;
+}
+
+static int ring_push(tslog_ring_t *ring, const char *line, size_t len) {
+    size_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+    size_t pos = head & (ring->size - 1);
+    size_t need = record_size(len);
+    size_t contiguous = ring->size - pos;
+    size_t total = need > contiguous ? contiguous + need : need;
+
+    if (ring->size - (head - tail) < total) {
+        return -1;
+    }
+
+    if (need > contiguous) {
+        uint32_t pad = TSLOG_RING_PAD;
+        memcpy(ring->buf + pos, &pad, 4);
+        head += contiguous;
+        pos = 0;
+    }
+
+    uint32_t len32 = (uint32_t)len;
+    memcpy(ring->buf + pos, &len32, 4);
+    memcpy(ring->buf + pos + 4, line, len);
+    atomic_store_explicit(&ring->head, head + need, memory_order_release);
+    return 0;
+}
+
+// Consome todos os registros do buffer para logger->batch, esvaziando o batch
+// no arquivo quando enche. Chamar com logger->mutex travado.
+static void drain_ring(tslog_t *logger, tslog_ring_t *ring, size_t *used) {
+    size_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    size_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    while (tail != head) {
+        size_t pos = tail & (ring->size - 1);
+        uint32_t len;
+        memcpy(&len, ring->buf + pos, 4);
+
+        if (len == TSLOG_RING_PAD) {
+            tail += ring->size - pos;
+            continue;
+        }
+
+        if (*used + len > TSLOG_BATCH_SIZE) {
+            write_all(logger, logger->batch, *used);
+            *used = 0;
+        }
+        memcpy(logger->batch + *used, ring->buf + pos + 4, len);
+        *used += len;
+        tail += record_size(len);
+    }
+
+    atomic_store_explicit(&ring->tail, tail, memory_order_release);
+}
+
+static int drain_all(tslog_t *logger) {
+    size_t used = 0;
+    int wrote = 0;
+
+    for (tslog_ring_t *ring = atomic_load(&logger->rings); ring; ring = ring->next) {
+        size_t before = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+        drain_ring(logger, ring, &used);
+        if (atomic_load_explicit(&ring->tail, memory_order_relaxed) != before) wrote = 1;
+    }
+
+    if (used > 0) {
+        write_all(logger, logger->batch, used);
+    }
+    return wrote;
+}
+
+static int rings_pending(tslog_t *logger) {
+    for (tslog_ring_t *ring = atomic_load(&logger->rings); ring; ring = ring->next) {
+        if (atomic_load(&ring->head) != atomic_load(&ring->tail)) return 1;
+    }
+    return 0;
+}
+
+static void tls_release(void *unused) {
+    (void)unused;
+    for (int i = 0; i < TSLOG_TLS_SLOTS; i++) {
+        tslog_t *logger = tls_slots[i].logger;
+        if (logger && logger->async && logger->async_id == tls_slots[i].async_id) {
+            // O buffer pode ter registros pendentes; o writer os drena e
+            // outra thread pode adotá-lo depois, mantendo a ordem
+            atomic_store(&tls_slots[i].ring->owned, 0);
+        }
+        tls_slots[i].logger = NULL;
+        tls_slots[i].ring = NULL;
+    }
+}
+
+static void tls_key_create(void) {
+    pthread_key_create(&tls_key, tls_release);
+}
+
+static tslog_ring_t *ring_acquire(tslog_t *logger) {
+    // Reaproveita o buffer de uma thread que já terminou
+    for (tslog_ring_t *ring = atomic_load(&logger->rings); ring; ring = ring->next) {
+        int expected = 0;
+        if (atomic_load(&ring->owned) == 0 &&
+            atomic_compare_exchange_strong(&ring->owned, &expected, 1)) {
+            return ring;
+        }
+    }
+
+    tslog_ring_t *ring = calloc(1, sizeof(tslog_ring_t));
+    if (!ring) return NULL;
+    ring->buf = malloc(logger->ring_size);
+    if (!ring->buf) {
+        free(ring);
+        return NULL;
+    }
+    ring->size = logger->ring_size;
+    atomic_init(&ring->owned, 1);
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+
+    tslog_ring_t *first = atomic_load(&logger->rings);
+    do {
+        ring->next = first;
+    } while (!atomic_compare_exchange_weak(&logger->rings, &first, ring));
+
+    return ring;
+}
+
+static tslog_ring_t *thread_ring(tslog_t *logger) {
+    tls_slot_t *free_slot = NULL;
+
+    for (int i = 0; i < TSLOG_TLS_SLOTS; i++) {
+        tls_slot_t *slot = &tls_slots[i];
+        if (slot->logger == logger) {
+            if (slot->async_id == logger->async_id) return slot->ring;
+            // Logger reinicializado no mesmo endereço: o buffer antigo já foi liberado
+            free_slot = slot;
+            break;
+        }
+        if (!free_slot && slot->logger == NULL) {
+            free_slot = slot;
+        }
+    }
+
+    if (!free_slot) return NULL;
+
+    pthread_once(&tls_once, tls_key_create);
+    tslog_ring_t *ring = ring_acquire(logger);
+    if (!ring) return NULL;
+
+    free_slot->logger = logger;
+    free_slot->async_id = logger->async_id;
+    free_slot->ring = ring;
+    pthread_setspecific(tls_key, tls_slots);
+    return ring;
+}
+
+static void wake_writer(tslog_t *logger) {
+    if (atomic_load(&logger->writer_sleeping)) {
+        pthread_mutex_lock(&logger->wake_mutex);
+        pthread_cond_signal(&logger->wake_cond);
+        pthread_mutex_unlock(&logger->wake_mutex);
+    }
+}
+
+static void report_dropped(tslog_t *logger, long *reported) {
+    long dropped = atomic_load(&logger->dropped);
+    if (dropped == *reported || logger->binary) return;
+
+    char timestamp[64];
+    char line[256];
+    tslog_get_timestamp(timestamp, sizeof(timestamp), logger->timestamp_format);
+    int len = snprintf(line, sizeof(line), "[%s] [WARN] tslog: %ld mensagens descartadas (buffer cheio)\n",
+                       timestamp, dropped - *reported);
+    write_all(logger, line, (size_t)len);
+    *reported = dropped;
+}
+
+static void* writer_thread(void *arg) {
+    tslog_t *logger = (tslog_t*)arg;
+    long reported = 0;
+    long last_due = 0;
+
+    while (1) {
+        pthread_mutex_lock(&logger->mutex);
+        int wrote = drain_all(logger);
+        report_dropped(logger, &reported);
+        pthread_mutex_unlock(&logger->mutex);
+
+        // Resumos de rajadas que pararam: o site não vai ser chamado de novo
+        struct timespec now;
+        clock_gettime(CLOCK_REALTIME_COARSE, &now);
+        if ((long)now.tv_sec != last_due) {
+            last_due = (long)now.tv_sec;
+            tslog_report_due(logger);
+        }
+
+        if (wrote) continue;
+        if (atomic_load(&logger->writer_stop)) break;
+
+        struct timespec deadline;
+        clock_gettime(CLOCK_REALTIME, &deadline);
+        deadline.tv_nsec += TSLOG_WRITER_IDLE_MS * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
+        }
+
+        pthread_mutex_lock(&logger->wake_mutex);
+        atomic_store(&logger->writer_sleeping, 1);
+        if (!rings_pending(logger) && !atomic_load(&logger->writer_stop)) {
+            pthread_cond_timedwait(&logger->wake_cond, &logger->wake_mutex, &deadline);
+        }
+        atomic_store(&logger->writer_sleeping, 0);
+        pthread_mutex_unlock(&logger->wake_mutex);
+    }
+
+    return NULL;
+}
+
+static void sync_write(tslog_t *logger, const char *line, size_t len) {
+    pthread_mutex_lock(&logger->mutex);
+    write_all(logger, line, len);
+    pthread_mutex_unlock(&logger->mutex);
+}
+
+static void async_write(tslog_t *logger, const char *line, size_t len) {
+    tslog_ring_t *ring = thread_ring(logger);
+    if (!ring) {
+        sync_write(logger, line, len);
+        return;
+    }
+
+    while (ring_push(ring, line, len) != 0) {
+        switch (logger->overflow) {
+            case TSLOG_OVERFLOW_DROP:
+                atomic_fetch_add(&logger->dropped, 1);
+                return;
+
+            case TSLOG_OVERFLOW_SYNC: {
+                // Esvazia o próprio buffer antes, para não inverter a ordem da thread
+                size_t used = 0;
+                pthread_mutex_lock(&logger->mutex);
+                drain_ring(logger, ring, &used);
+                if (used > 0) write_all(logger, logger->batch, used);
+                write_all(logger, line, len);
+                pthread_mutex_unlock(&logger->mutex);
+                return;
+            }
+
+            case TSLOG_OVERFLOW_BLOCK:
+            default:
+                wake_writer(logger);
+                sched_yield();
+                break;
+        }
+    }
+
+    // Acordar o writer custa um futex; abaixo de meio buffer ele drena
+    // sozinho na próxima volta (no máximo TSLOG_WRITER_IDLE_MS)
+    size_t used = atomic_load_explicit(&ring->head, memory_order_relaxed) -
+                  atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    if (used >= ring->size / 2) {
+        wake_writer(logger);
+    }
+}
+
+static void crash_handler(int sig) {
+    tslog_t *logger = crash_logger;
+    crashing = 1;
+
+    if (logger && logger->async) {
+        // Melhor esforço: se o mutex estiver preso pela thread que falhou,
+        // drena mesmo assim (write é async-signal-safe)
+        int locked = pthread_mutex_trylock(&logger->mutex) == 0;
+        drain_all(logger);
+        if (locked) pthread_mutex_unlock(&logger->mutex);
+    }
+
+    signal(sig, SIG_DFL);
+    raise(sig);
+}
 
 int tslog_init(tslog_t *logger, const char *filename, tslog_level_t level) {
     if (!logger) return -1;
-    
+
+    memset(logger, 0, sizeof(*logger));
+
     // Inicializar mutex
     if (pthread_mutex_init(&logger->mutex, NULL) != 0) {
         return -1;
     }
-    
+
     // Abrir arquivo de log
-    logger->log_file = fopen(filename, "a");
-    if (!logger->log_file) {
+    logger->fd = open(filename, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (logger->fd < 0) {
         pthread_mutex_destroy(&logger->mutex);
         return -1;
     }
-    
+    logger->filename = strdup(filename);
+    atomic_init(&logger->reopen_requested, 0);
+
     logger->level = level;
     logger->timestamp_format = "%Y-%m-%d %H:%M:%S";
-    
+
     return 0;
 }
 
+int tslog_enable_async(tslog_t *logger, size_t ring_size, tslog_overflow_t overflow) {
+    if (!logger || logger->async) return -1;
+
+    size_t size = TSLOG_MIN_RING_SIZE;
+    if (ring_size == 0) ring_size = TSLOG_DEFAULT_RING_SIZE;
+    while (size < ring_size) size <<= 1;
+
+    logger->batch = malloc(TSLOG_BATCH_SIZE);
+    if (!logger->batch) return -1;
+
+    logger->ring_size = size;
+    logger->overflow = overflow;
+    atomic_init(&logger->rings, NULL);
+    atomic_init(&logger->writer_stop, 0);
+    atomic_init(&logger->writer_sleeping, 0);
+    atomic_init(&logger->dropped, 0);
+    logger->async_id = atomic_fetch_add(&next_async_id, 1);
+    pthread_mutex_init(&logger->wake_mutex, NULL);
+    pthread_cond_init(&logger->wake_cond, NULL);
+
+    if (pthread_create(&logger->writer, NULL, writer_thread, logger) != 0) {
+        pthread_mutex_destroy(&logger->wake_mutex);
+        pthread_cond_destroy(&logger->wake_cond);
+        free(logger->batch);
+        logger->batch = NULL;
+        return -1;
+    }
+
+    logger->async = 1;
+    return 0;
+}
+
+void tslog_flush(tslog_t *logger) {
+    if (!logger || !logger->async) return;
+
+    pthread_mutex_lock(&logger->mutex);
+    drain_all(logger);
+    pthread_mutex_unlock(&logger->mutex);
+}
+
+void tslog_install_crash_handler(tslog_t *logger) {
+    crash_logger = logger;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = crash_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESETHAND;
+
+    int signals[] = {SIGSEGV, SIGABRT, SIGBUS, SIGFPE, SIGILL, SIGTERM, SIGINT};
+    for (size_t i = 0; i < sizeof(signals) / sizeof(signals[0]); i++) {
+        sigaction(signals[i], &sa, NULL);
+    }
+}
+
+long tslog_dropped(tslog_t *logger) {
+    return logger && logger->async ? atomic_load(&logger->dropped) : 0;
+}
+
 void tslog_destroy(tslog_t *logger) {
     if (!logger) return;
-    
+
+    tslog_report_suppressed(logger);
+
+    if (logger->async) {
+        atomic_store(&logger->writer_stop, 1);
+        pthread_mutex_lock(&logger->wake_mutex);
+        pthread_cond_signal(&logger->wake_cond);
+        pthread_mutex_unlock(&logger->wake_mutex);
+        pthread_join(logger->writer, NULL);
+    }
+
     pthread_mutex_lock(&logger->mutex);
-    
-    if (logger->log_file && logger->log_file != stdout && logger->log_file != stderr) {
-        fclose(logger->log_file);
+
+    if (logger->async) {
+        drain_all(logger);
+
+        tslog_ring_t *ring = atomic_load(&logger->rings);
+        while (ring) {
+            tslog_ring_t *next = ring->next;
+            free(ring->buf);
+            free(ring);
+            ring = next;
+        }
+        atomic_store(&logger->rings, NULL);
+        free(logger->batch);
+        logger->batch = NULL;
+        logger->async = 0;
+        pthread_mutex_destroy(&logger->wake_mutex);
+        pthread_cond_destroy(&logger->wake_cond);
+    }
+
+    if (crash_logger == logger) {
+        crash_logger = NULL;
+    }
+
+    free(logger->formats);
+    logger->formats = NULL;
+    logger->binary = 0;
+
+    tslog_rotation_destroy(logger);
+    free(logger->filename);
+    logger->filename = NULL;
+
+    if (logger->fd > STDERR_FILENO) {
+        close(logger->fd);
     }
-    
+    logger->fd = -1;
+
     pthread_mutex_unlock(&logger->mutex);
     pthread_mutex_destroy(&logger->mutex);
 }
 
 void tslog_get_timestamp(char *buffer, size_t size, const char *format) {
     time_t now = time(NULL);
-    struct tm *timeinfo = localtime(&now);
-    strftime(buffer, size, format, timeinfo);
+    struct tm timeinfo;
+    localtime_r(&now, &timeinfo);
+    strftime(buffer, size, format, &timeinfo);
+}
+
+// Relógio em cache por thread: localtime/strftime rodam no máximo uma vez por
+// segundo; nas demais linhas o timestamp formatado é reaproveitado.
+static __thread time_t cached_sec = -1;
+static __thread const char *cached_format = NULL;
+static __thread char cached_timestamp[64];
+static __thread size_t cached_timestamp_len = 0;
+
+static const char *tslog_cached_timestamp(const char *format, struct timespec *now, size_t *len) {
+    clock_gettime(CLOCK_REALTIME_COARSE, now);
+
+    if (now->tv_sec != cached_sec || format != cached_format) {
+        struct tm timeinfo;
+        localtime_r(&now->tv_sec, &timeinfo);
+        cached_timestamp_len = strftime(cached_timestamp, sizeof(cached_timestamp), format, &timeinfo);
+        cached_sec = now->tv_sec;
+        cached_format = format;
+    }
+
+    *len = cached_timestamp_len;
+    return cached_timestamp;
 }
 
 const char* tslog_level_to_string(tslog_level_t level) {
@@ -53,78 +524,338 @@ const char* tslog_level_to_string(tslog_level_t level) {
     }
 }
 
-void tslog_log(tslog_t *logger, tslog_level_t level, const char *format, ...) {
-    if (!logger || level > logger->level) return;
-    
+/* ---------- Modo binário ---------- */
+
+#define TSLOG_FORMAT_SLOTS 4096
+
+typedef struct {
+    _Atomic(const char*) key;   // endereço da format string (literal)
+    atomic_uint id;             // 0 enquanto o id ainda não foi publicado
+} format_slot_t;
+
+typedef struct {
+    format_slot_t slots[TSLOG_FORMAT_SLOTS];
+    atomic_uint next_id;
+} format_table_t;
+
+static atomic_uint next_thread_id = 1;
+static __thread uint32_t thread_id = 0;
+
+int tslog_parse_spec(const char *p, tslog_spec_t *spec) {
+    const char *start = p;
+    int longs = 0;
+
+    memset(spec, 0, sizeof(*spec));
+    if (*p++ != '%') return -1;
+
+    if (*p == '%') {
+        spec->conversion = '%';
+        spec->length = 2;
+        return 0;
+    }
+
+    while (*p && strchr("-+ #0'", *p)) p++;
+    if (*p == '*') {
+        spec->star_width = 1;
+        p++;
+    } else {
+        while (*p >= '0' && *p <= '9') p++;
+    }
+    if (*p == '.') {
+        p++;
+        if (*p == '*') {
+            spec->star_precision = 1;
+            p++;
+        } else {
+            while (*p >= '0' && *p <= '9') p++;
+        }
+    }
+    while (*p && strchr("hlLqjzt", *p)) {
+        if (*p == 'l' || *p == 'q' || *p == 'j' || *p == 'z' || *p == 't') longs++;
+        if (*p == 'L') spec->long_double = 1;
+        p++;
+    }
+
+    spec->conversion = *p;
+    switch (*p) {
+        case 'd': case 'i': case 'u': case 'o': case 'x': case 'X':
+            spec->arg_type = longs ? 'l' : 'i';
+            break;
+        case 'c':
+            spec->arg_type = 'i';
+            break;
+        case 'e': case 'E': case 'f': case 'F': case 'g': case 'G': case 'a': case 'A':
+            spec->arg_type = 'd';
+            break;
+        case 's':
+            spec->arg_type = 's';
+            break;
+        case 'p':
+            spec->arg_type = 'p';
+            break;
+        default:
+            return -1;
+    }
+
+    spec->length = (size_t)(p - start) + 1;
+    return 0;
+}
+
+static size_t put_bytes(char *buf, size_t off, size_t cap, const void *data, size_t len) {
+    if (off + len > cap) return cap + 1;
+    memcpy(buf + off, data, len);
+    return off + len;
+}
+
+// Codifica os argumentos conforme a format string. Retorna o tamanho ou -1.
+static int encode_args(char *buf, size_t cap, const char *format, va_list args) {
+    size_t off = 0;
+
+    for (const char *p = format; *p && off <= cap; p++) {
+        if (*p != '%') continue;
+
+        tslog_spec_t spec;
+        if (tslog_parse_spec(p, &spec) != 0) return -1;
+        p += spec.length - 1;
+        if (spec.conversion == '%') continue;
+
+        for (int star = 0; star < spec.star_width + spec.star_precision; star++) {
+            int32_t v = va_arg(args, int);
+            off = put_bytes(buf, off, cap, "i", 1);
+            off = put_bytes(buf, off, cap, &v, sizeof(v));
+        }
+
+        switch (spec.arg_type) {
+            case 'i': {
+                int32_t v = va_arg(args, int);
+                off = put_bytes(buf, off, cap, "i", 1);
+                off = put_bytes(buf, off, cap, &v, sizeof(v));
+                break;
+            }
+            case 'l': {
+                int64_t v = va_arg(args, long long);
+                off = put_bytes(buf, off, cap, "l", 1);
+                off = put_bytes(buf, off, cap, &v, sizeof(v));
+                break;
+            }
+            case 'd': {
+                double v = spec.long_double ? (double)va_arg(args, long double)
+                                            : va_arg(args, double);
+                off = put_bytes(buf, off, cap, "d", 1);
+                off = put_bytes(buf, off, cap, &v, sizeof(v));
+                break;
+            }
+            case 'p': {
+                uint64_t v = (uint64_t)(uintptr_t)va_arg(args, void*);
+                off = put_bytes(buf, off, cap, "p", 1);
+                off = put_bytes(buf, off, cap, &v, sizeof(v));
+                break;
+            }
+            case 's': {
+                const char *str = va_arg(args, const char*);
+                if (!str) str = "(null)";
+                size_t len = strlen(str);
+                if (len > 1024) len = 1024;
+                uint16_t len16 = (uint16_t)len;
+                off = put_bytes(buf, off, cap, "s", 1);
+                off = put_bytes(buf, off, cap, &len16, sizeof(len16));
+                off = put_bytes(buf, off, cap, str, len);
+                break;
+            }
+        }
+    }
+
+    return off <= cap ? (int)off : -1;
+}
+
+// Procura (ou registra) o id da format string. *is_new indica que o registro
+// 'F' precisa ser emitido por quem chamou. Retorna 0 se a tabela estiver cheia.
+static uint32_t format_id(format_table_t *table, const char *format, int *is_new) {
+    size_t h = ((uintptr_t)format >> 3) * 0x9E3779B97F4A7C15ull;
+    *is_new = 0;
+
+    for (size_t probe = 0; probe < TSLOG_FORMAT_SLOTS; probe++) {
+        format_slot_t *slot = &table->slots[(h + probe) & (TSLOG_FORMAT_SLOTS - 1)];
+        const char *key = atomic_load_explicit(&slot->key, memory_order_acquire);
+
+        if (key == NULL) {
+            if (atomic_compare_exchange_strong(&slot->key, &key, format)) {
+                uint32_t id = atomic_fetch_add(&table->next_id, 1);
+                atomic_store_explicit(&slot->id, id, memory_order_release);
+                *is_new = 1;
+                return id;
+            }
+        }
+
+        if (key == format) {
+            uint32_t id;
+            while ((id = atomic_load_explicit(&slot->id, memory_order_acquire)) == 0) {
+                sched_yield();
+            }
+            return id;
+        }
+    }
+
+    return 0;
+}
+
+static void emit(tslog_t *logger, const char *data, size_t len) {
+    if (logger->async) {
+        async_write(logger, data, len);
+    } else {
+        sync_write(logger, data, len);
+    }
+}
+
+static void tslog_vlog_binary(tslog_t *logger, tslog_level_t level, const char *format, va_list args) {
+    char record[TSLOG_LINE_MAX];
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+
+    if (thread_id == 0) {
+        thread_id = atomic_fetch_add(&next_thread_id, 1);
+    }
+
+    uint8_t lvl = (uint8_t)level;
+    int64_t sec = now.tv_sec;
+    uint32_t nsec = (uint32_t)now.tv_nsec;
+    int is_new;
+    uint32_t id = format_id((format_table_t*)logger->formats, format, &is_new);
+
+    if (is_new) {
+        uint16_t len = (uint16_t)strnlen(format, TSLOG_LINE_MAX - 16);
+        size_t off = 0;
+        off = put_bytes(record, off, sizeof(record), "F", 1);
+        off = put_bytes(record, off, sizeof(record), &id, sizeof(id));
+        off = put_bytes(record, off, sizeof(record), &len, sizeof(len));
+        off = put_bytes(record, off, sizeof(record), format, len);
+        emit(logger, record, off);
+    }
+
+    const size_t header = 1 + 1 + 4 + 8 + 4 + 4 + 2;
+    va_list copy;
+    va_copy(copy, args);
+    int args_len = id ? encode_args(record + header, sizeof(record) - header, format, copy) : -1;
+    va_end(copy);
+
+    size_t off = 0;
+    if (args_len >= 0) {
+        uint16_t len16 = (uint16_t)args_len;
+        off = put_bytes(record, off, sizeof(record), "R", 1);
+        off = put_bytes(record, off, sizeof(record), &lvl, 1);
+        off = put_bytes(record, off, sizeof(record), &id, sizeof(id));
+        off = put_bytes(record, off, sizeof(record), &sec, sizeof(sec));
+        off = put_bytes(record, off, sizeof(record), &nsec, sizeof(nsec));
+        off = put_bytes(record, off, sizeof(record), &thread_id, sizeof(thread_id));
+        off = put_bytes(record, off, sizeof(record), &len16, sizeof(len16));
+        off += (size_t)args_len;
+    } else {
+        // Tabela cheia ou formato não suportado: grava o texto já formatado
+        int text = vsnprintf(record + header, sizeof(record) - header, format, args);
+        if (text < 0) text = 0;
+        if ((size_t)text >= sizeof(record) - header) text = (int)(sizeof(record) - header - 1);
+        uint16_t len16 = (uint16_t)text;
+        off = put_bytes(record, off, sizeof(record), "S", 1);
+        off = put_bytes(record, off, sizeof(record), &lvl, 1);
+        off = put_bytes(record, off, sizeof(record), &sec, sizeof(sec));
+        off = put_bytes(record, off, sizeof(record), &nsec, sizeof(nsec));
+        off = put_bytes(record, off, sizeof(record), &thread_id, sizeof(thread_id));
+        off = put_bytes(record, off, sizeof(record), &len16, sizeof(len16));
+        memmove(record + off, record + header, (size_t)text);
+        off += (size_t)text;
+    }
+
+    emit(logger, record, off);
+}
+
+int tslog_enable_binary(tslog_t *logger) {
+    if (!logger || logger->binary) return -1;
+
+    format_table_t *table = calloc(1, sizeof(format_table_t));
+    if (!table) return -1;
+    atomic_init(&table->next_id, 1);
+
+    logger->formats = table;
+    logger->binary = 1;
+
     pthread_mutex_lock(&logger->mutex);
-    
-    // Timestamp
-    char timestamp[64];
-    tslog_get_timestamp(timestamp, sizeof(timestamp), logger->timestamp_format);
-    
-    // Nível do log
+    write_all(logger, TSLOG_BIN_MAGIC, TSLOG_BIN_MAGIC_LEN);
+    pthread_mutex_unlock(&logger->mutex);
+    return 0;
+}
+
+/* ---------- Texto ---------- */
+
+// Formata a linha completa fora de qualquer lock e a entrega ao backend
+static void tslog_vlog(tslog_t *logger, tslog_level_t level, const char *format, va_list args) {
+    if (!tslog_enabled(logger, level)) return;
+
+    if (logger->binary) {
+        tslog_vlog_binary(logger, level, format, args);
+        return;
+    }
+
+    char line[TSLOG_LINE_MAX];
+    struct timespec now;
+    size_t ts_len;
+    const char *timestamp = tslog_cached_timestamp(logger->timestamp_format, &now, &ts_len);
     const char *level_str = tslog_level_to_string(level);
-    
-    // Imprimir cabeçalho
-    fprintf(logger->log_file, "[%s] [%s] ", timestamp, level_str);
-    
-    // Imprimir mensagem
+    size_t level_len = strlen(level_str);
+
+    // Cabeçalho montado à mão: evita um snprintf por linha
+    size_t len = 0;
+    line[len++] = '[';
+    memcpy(line + len, timestamp, ts_len);
+    len += ts_len;
+    line[len++] = ']';
+    line[len++] = ' ';
+    line[len++] = '[';
+    memcpy(line + len, level_str, level_len);
+    len += level_len;
+    line[len++] = ']';
+    line[len++] = ' ';
+
+    int msg = vsnprintf(line + len, sizeof(line) - len - 1, format, args);
+    if (msg < 0) msg = 0;
+    len += (size_t)msg;
+    if (len > sizeof(line) - 2) len = sizeof(line) - 2;
+    line[len++] = '\n';
+
+    emit(logger, line, len);
+}
+
+void tslog_log(tslog_t *logger, tslog_level_t level, const char *format, ...) {
     va_list args;
     va_start(args, format);
-    vfprintf(logger->log_file, format, args);
+    tslog_vlog(logger, level, format, args);
     va_end(args);
-    
-    fprintf(logger->log_file, "\n");
-    fflush(logger->log_file);
-    
-    pthread_mutex_unlock(&logger->mutex);
 }
 
-// Funções específicas por nível
-void tslog_error(tslog_t *logger, const char *format, ...) {
+// Funções específicas por nível (os nomes entre parênteses evitam as macros do header)
+void (tslog_error)(tslog_t *logger, const char *format, ...) {
     va_list args;
     va_start(args, format);
-    pthread_mutex_lock(&logger->mutex);
-    fprintf(logger->log_file, "[ERROR] ");
-    vfprintf(logger->log_file, format, args);
-    fprintf(logger->log_file, "\n");
-    fflush(logger->log_file);
-    pthread_mutex_unlock(&logger->mutex);
+    tslog_vlog(logger, TSLOG_ERROR, format, args);
     va_end(args);
 }
 
-void tslog_warn(tslog_t *logger, const char *format, ...) {
+void (tslog_warn)(tslog_t *logger, const char *format, ...) {
     va_list args;
     va_start(args, format);
-    pthread_mutex_lock(&logger->mutex);
-    fprintf(logger->log_file, "[WARN] ");
-    vfprintf(logger->log_file, format, args);
-    fprintf(logger->log_file, "\n");
-    fflush(logger->log_file);
-    pthread_mutex_unlock(&logger->mutex);
+    tslog_vlog(logger, TSLOG_WARN, format, args);
     va_end(args);
 }
 
-void tslog_info(tslog_t *logger, const char *format, ...) {
+void (tslog_info)(tslog_t *logger, const char *format, ...) {
     va_list args;
     va_start(args, format);
-    pthread_mutex_lock(&logger->mutex);
-    fprintf(logger->log_file, "[INFO] ");
-    vfprintf(logger->log_file, format, args);
-    fprintf(logger->log_file, "\n");
-    fflush(logger->log_file);
-    pthread_mutex_unlock(&logger->mutex);
+    tslog_vlog(logger, TSLOG_INFO, format, args);
     va_end(args);
 }
 
-void tslog_debug(tslog_t *logger, const char *format, ...) {
+void (tslog_debug)(tslog_t *logger, const char *format, ...) {
     va_list args;
     va_start(args, format);
-    pthread_mutex_lock(&logger->mutex);
-    fprintf(logger->log_file, "[DEBUG] ");
-    vfprintf(logger->log_file, format, args);
-    fprintf(logger->log_file, "\n");
-    fflush(logger->log_file);
-    pthread_mutex_unlock(&logger->mutex);
+    tslog_vlog(logger, TSLOG_DEBUG, format, args);
     va_end(args);
-}
\ No newline at end of file
+}
@@ -0,0 +1,33 @@
+#ifndef TSLOG_BINARY_H
+#define TSLOG_BINARY_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// Formato do log binário (modo tslog_enable_binary), lido por tools/tslog_decode.c.
+//
+// O arquivo começa com TSLOG_BIN_MAGIC e segue com registros:
+//   'F' u32 id, u16 tam, bytes           definição de format string
+//   'R' u8 nível, u32 id, i64 seg, u32 nseg, u32 thread, u16 tam, args
+//   'S' u8 nível, i64 seg, u32 nseg, u32 thread, u16 tam, bytes (texto já formatado)
+// Os argumentos de 'R' são codificados em ordem, cada um com um tag:
+//   'i' i32, 'l' i64, 'd' double, 'p' u64, 's' u16 tam + bytes
+// Inteiros em ordem de bytes do host: o arquivo é decodificado na mesma arquitetura.
+
+#define TSLOG_BIN_MAGIC "TSLOGBIN1\n"
+#define TSLOG_BIN_MAGIC_LEN 10
+
+typedef struct {
+    size_t length;          // bytes do especificador, incluindo o '%'
+    char conversion;        // 'd', 's', 'f', ... ou '%'
+    char arg_type;          // 'i', 'l', 'd', 's', 'p' ou 0 (sem argumento)
+    int star_width;         // largura vem de um argumento int
+    int star_precision;     // precisão vem de um argumento int
+    int long_double;        // modificador 'L' (o decoder grava como double)
+} tslog_spec_t;
+
+// Interpreta o especificador que começa em `p` (que aponta para '%').
+// Retorna 0 em sucesso ou -1 se o especificador for inválido/não suportado.
+int tslog_parse_spec(const char *p, tslog_spec_t *spec);
+
+#endif
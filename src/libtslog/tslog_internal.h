@@ -0,0 +1,15 @@
+#ifndef TSLOG_INTERNAL_H
+#define TSLOG_INTERNAL_H
+
+#include "tslog.h"
+
+// Funções compartilhadas entre os arquivos da libtslog (não fazem parte da API)
+
+void tslog_write_all(int fd, const char *data, size_t len);
+
+// Chamada com logger->mutex travado antes de cada escrita no arquivo:
+// reabre (SIGHUP) ou rotaciona o arquivo se necessário e contabiliza os bytes.
+void tslog_rotation_before_write(tslog_t *logger, size_t len);
+void tslog_rotation_destroy(tslog_t *logger);
+
+#endif
@@ -0,0 +1,180 @@
+#include "tslog.h"
+#include <string.h>
+
+#define TSLOG_MAX_SUBSYSTEMS 32
+#define TSLOG_SUBSYSTEM_NAME 32
+
+struct tslog_subsystem {
+    char name[TSLOG_SUBSYSTEM_NAME];
+    atomic_int per_second;
+    atomic_int sample_every;
+    atomic_long suppressed;     // total desde o início, para o monitor
+};
+
+// Tabela fixa: entradas nunca são removidas, então os sites podem guardar o
+// ponteiro e ler a configuração sem lock. Inserções são serializadas.
+static tslog_subsystem_t subsystems[TSLOG_MAX_SUBSYSTEMS];
+static atomic_int subsystem_count = 0;
+static pthread_mutex_t subsystems_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+// Sites que já registraram algo, para os resumos no encerramento
+static _Atomic(tslog_site_t*) sites = NULL;
+
+static tslog_subsystem_t* find_subsystem(const char *name) {
+    int count = atomic_load_explicit(&subsystem_count, memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        if (strcmp(subsystems[i].name, name) == 0) {
+            return &subsystems[i];
+        }
+    }
+    return NULL;
+}
+
+// Subsistemas desconhecidos são criados sem limite, para que uma
+// configuração feita depois alcance sites que já estão em uso
+static tslog_subsystem_t* get_subsystem(const char *name) {
+    tslog_subsystem_t *sub = find_subsystem(name);
+    if (sub) return sub;
+
+    pthread_mutex_lock(&subsystems_mutex);
+    sub = find_subsystem(name);
+    int count = atomic_load(&subsystem_count);
+    if (!sub && count < TSLOG_MAX_SUBSYSTEMS) {
+        sub = &subsystems[count];
+        snprintf(sub->name, sizeof(sub->name), "%s", name);
+        atomic_init(&sub->per_second, 0);
+        atomic_init(&sub->sample_every, 1);
+        atomic_init(&sub->suppressed, 0);
+        atomic_store_explicit(&subsystem_count, count + 1, memory_order_release);
+    }
+    pthread_mutex_unlock(&subsystems_mutex);
+
+    return sub;
+}
+
+int tslog_set_rate_limit(const char *subsystem, int per_second, int sample_every) {
+    if (!subsystem || per_second < 0) return -1;
+
+    tslog_subsystem_t *sub = get_subsystem(subsystem);
+    if (!sub) return -1;
+
+    atomic_store(&sub->per_second, per_second);
+    atomic_store(&sub->sample_every, sample_every > 1 ? sample_every : 1);
+    return 0;
+}
+
+int tslog_get_rate_limit(const char *subsystem, int *per_second, int *sample_every, long *suppressed) {
+    tslog_subsystem_t *sub = subsystem ? find_subsystem(subsystem) : NULL;
+    if (!sub) return -1;
+
+    if (per_second) *per_second = atomic_load(&sub->per_second);
+    if (sample_every) *sample_every = atomic_load(&sub->sample_every);
+    if (suppressed) *suppressed = atomic_load(&sub->suppressed);
+    return 0;
+}
+
+void tslog_foreach_rate_limit(void (*callback)(const char *subsystem, int per_second,
+                                               int sample_every, long suppressed, void *arg),
+                              void *arg) {
+    int count = atomic_load_explicit(&subsystem_count, memory_order_acquire);
+    for (int i = 0; i < count; i++) {
+        callback(subsystems[i].name, atomic_load(&subsystems[i].per_second),
+                 atomic_load(&subsystems[i].sample_every),
+                 atomic_load(&subsystems[i].suppressed), arg);
+    }
+}
+
+static void report(tslog_t *logger, tslog_site_t *site, long suppressed) {
+    tslog_log(logger, site->level, "[%s] %ld mensagens suprimidas (%s:%d)",
+              site->subsystem, suppressed, site->file, site->line);
+}
+
+// Primeiro uso do site: resolve o subsistema e entra na lista global
+static tslog_subsystem_t* attach_site(tslog_site_t *site) {
+    tslog_subsystem_t *sub = get_subsystem(site->subsystem);
+    if (!sub) return NULL;
+
+    tslog_subsystem_t *expected = NULL;
+    if (atomic_compare_exchange_strong(&site->config, &expected, sub)) {
+        tslog_site_t *head = atomic_load(&sites);
+        do {
+            site->next = head;
+        } while (!atomic_compare_exchange_weak(&sites, &head, site));
+        return sub;
+    }
+    return expected;
+}
+
+int tslog_site_allow(tslog_t *logger, tslog_site_t *site) {
+    tslog_subsystem_t *sub = atomic_load_explicit(&site->config, memory_order_acquire);
+    if (!sub && !(sub = attach_site(site))) return 1;
+
+    int per_second = atomic_load_explicit(&sub->per_second, memory_order_relaxed);
+    int sample_every = atomic_load_explicit(&sub->sample_every, memory_order_relaxed);
+    if (per_second == 0 && sample_every <= 1 &&
+        atomic_load_explicit(&site->suppressed, memory_order_relaxed) == 0) {
+        return 1;
+    }
+
+    // Janela de um segundo: na virada, zera o contador e emite o resumo
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    long window = atomic_load_explicit(&site->window, memory_order_relaxed);
+    if (window != (long)now.tv_sec &&
+        atomic_compare_exchange_strong(&site->window, &window, (long)now.tv_sec)) {
+        atomic_store_explicit(&site->count, 0, memory_order_relaxed);
+        long suppressed = atomic_exchange(&site->suppressed, 0);
+        if (suppressed > 0) {
+            report(logger, site, suppressed);
+        }
+    }
+
+    int allowed = 1;
+    if (sample_every > 1 &&
+        atomic_fetch_add_explicit(&site->seen, 1, memory_order_relaxed) % sample_every != 0) {
+        allowed = 0;
+    } else if (per_second > 0 &&
+               atomic_fetch_add_explicit(&site->count, 1, memory_order_relaxed) >= per_second) {
+        allowed = 0;
+    }
+
+    if (!allowed) {
+        if (atomic_load_explicit(&site->logger, memory_order_relaxed) != logger) {
+            atomic_store_explicit(&site->logger, logger, memory_order_relaxed);
+        }
+        atomic_fetch_add_explicit(&site->suppressed, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&sub->suppressed, 1, memory_order_relaxed);
+    }
+    return allowed;
+}
+
+void tslog_report_due(tslog_t *logger) {
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME_COARSE, &now);
+    for (tslog_site_t *site = atomic_load(&sites); site; site = site->next) {
+        if (atomic_load_explicit(&site->logger, memory_order_relaxed) != logger ||
+            atomic_load_explicit(&site->suppressed, memory_order_relaxed) == 0) {
+            continue;
+        }
+        // Mesma virada de janela que tslog_site_allow: só um dos dois emite
+        long window = atomic_load_explicit(&site->window, memory_order_relaxed);
+        if (window == (long)now.tv_sec ||
+            !atomic_compare_exchange_strong(&site->window, &window, (long)now.tv_sec)) {
+            continue;
+        }
+        atomic_store_explicit(&site->count, 0, memory_order_relaxed);
+        long suppressed = atomic_exchange(&site->suppressed, 0);
+        if (suppressed > 0 && tslog_enabled(logger, site->level)) {
+            report(logger, site, suppressed);
+        }
+    }
+}
+
+void tslog_report_suppressed(tslog_t *logger) {
+    for (tslog_site_t *site = atomic_load(&sites); site; site = site->next) {
+        long suppressed = atomic_exchange(&site->suppressed, 0);
+        if (suppressed > 0 && tslog_enabled(logger, site->level)) {
+            report(logger, site, suppressed);
+        }
+    }
+}
@@ -0,0 +1,336 @@
+#include "tslog.h"
+#include "tslog_binary.h"
+#include "tslog_internal.h"
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <signal.h>
+#include <dirent.h>
+#include <libgen.h>
+#include <sys/stat.h>
+#include <zlib.h>
+
+#define TSLOG_PATH_MAX 512
+
+// A troca de arquivo acontece sob logger->mutex, que no modo assíncrono só é
+// disputado pela thread escritora: os produtores nunca esperam pela rotação.
+// Compressão e limpeza dos segmentos antigos ficam na thread `compressor`.
+struct tslog_rotation {
+    size_t max_bytes;
+    int interval;
+    int keep;
+    int compress;
+
+    size_t file_size;
+    time_t opened_at;
+    char last_stamp[32];
+    int sequence;
+
+    pthread_t compressor;
+    pthread_mutex_t mutex;
+    pthread_cond_t pending_cond;
+    int pending;    // houve rotação desde a última varredura
+    int stop;
+};
+
+static tslog_t *sighup_logger = NULL;
+
+static int gzip_file(const char *path) {
+    char gz_path[TSLOG_PATH_MAX + 4];
+    snprintf(gz_path, sizeof(gz_path), "%s.gz", path);
+
+    int in = open(path, O_RDONLY);
+    if (in < 0) return -1;
+
+    gzFile out = gzopen(gz_path, "wb6");
+    if (!out) {
+        close(in);
+        return -1;
+    }
+
+    char buffer[64 * 1024];
+    ssize_t n;
+    int rc = 0;
+    while ((n = read(in, buffer, sizeof(buffer))) > 0) {
+        if (gzwrite(out, buffer, (unsigned)n) != n) {
+            rc = -1;
+            break;
+        }
+    }
+
+    close(in);
+    if (gzclose(out) != Z_OK) rc = -1;
+
+    if (rc == 0) {
+        unlink(path);
+    } else {
+        unlink(gz_path);
+    }
+    return rc;
+}
+
+// Compara ignorando o ".gz": "x" < "x.001" < "x.002", a ordem em que foram criados
+static int compare_names(const void *a, const void *b) {
+    const char *x = *(char* const*)a, *y = *(char* const*)b;
+    size_t lx = strlen(x), ly = strlen(y);
+    if (lx > 3 && strcmp(x + lx - 3, ".gz") == 0) lx -= 3;
+    if (ly > 3 && strcmp(y + ly - 3, ".gz") == 0) ly -= 3;
+
+    int cmp = strncmp(x, y, lx < ly ? lx : ly);
+    if (cmp != 0) return cmp;
+    return (lx > ly) - (lx < ly);
+}
+
+// Lista os segmentos <base>.<AAAAMMDD-HHMMSS>[.N][.gz] do mais antigo para o
+// mais novo. Os nomes carregam a data em formato ordenável.
+static int list_segments(const char *dir, const char *base, char ***out) {
+    size_t base_len = strlen(base);
+    DIR *d = opendir(dir);
+    if (!d) return 0;
+
+    char **names = NULL;
+    int count = 0, cap = 0;
+    struct dirent *entry;
+
+    while ((entry = readdir(d)) != NULL) {
+        if (strncmp(entry->d_name, base, base_len) != 0 || entry->d_name[base_len] != '.') continue;
+        const char *suffix = entry->d_name + base_len + 1;
+        if (strlen(suffix) < 15 || suffix[8] != '-') continue;
+
+        if (count == cap) {
+            cap = cap ? cap * 2 : 16;
+            names = realloc(names, (size_t)cap * sizeof(char*));
+        }
+        names[count++] = strdup(entry->d_name);
+    }
+    closedir(d);
+
+    if (count > 0) {
+        qsort(names, (size_t)count, sizeof(char*), compare_names);
+    }
+    *out = names;
+    return count;
+}
+
+// Comprime os segmentos pendentes e apaga os mais antigos além de `keep`.
+// Varre o diretório em vez de manter uma fila: nada se perde se várias
+// rotações acontecerem enquanto a thread ainda está comprimindo.
+static void process_segments(const char *filename, int compress, int keep) {
+    char dir_buf[TSLOG_PATH_MAX], base_buf[TSLOG_PATH_MAX];
+    snprintf(dir_buf, sizeof(dir_buf), "%s", filename);
+    snprintf(base_buf, sizeof(base_buf), "%s", filename);
+    const char *dir = dirname(dir_buf);
+    const char *base = basename(base_buf);
+
+    char **names = NULL;
+    int count = list_segments(dir, base, &names);
+    int first = keep > 0 && count > keep ? count - keep : 0;
+
+    for (int i = 0; i < count; i++) {
+        char path[TSLOG_PATH_MAX * 2];
+        snprintf(path, sizeof(path), "%s/%s", dir, names[i]);
+
+        size_t len = strlen(names[i]);
+        int compressed = len > 3 && strcmp(names[i] + len - 3, ".gz") == 0;
+
+        if (i < first) {
+            unlink(path);
+        } else if (compress && !compressed) {
+            gzip_file(path);
+        }
+        free(names[i]);
+    }
+    free(names);
+}
+
+static void* compressor_thread(void *arg) {
+    tslog_t *logger = (tslog_t*)arg;
+    tslog_rotation_t *rot = logger->rotation;
+
+    pthread_mutex_lock(&rot->mutex);
+    while (1) {
+        while (!rot->pending && !rot->stop) {
+            pthread_cond_wait(&rot->pending_cond, &rot->mutex);
+        }
+        if (!rot->pending && rot->stop) break;
+
+        rot->pending = 0;
+        pthread_mutex_unlock(&rot->mutex);
+
+        process_segments(logger->filename, rot->compress, rot->keep);
+
+        pthread_mutex_lock(&rot->mutex);
+    }
+    pthread_mutex_unlock(&rot->mutex);
+
+    return NULL;
+}
+
+static void open_current(tslog_t *logger) {
+    int fd = open(logger->filename, O_WRONLY | O_CREAT | O_APPEND, 0644);
+    if (fd < 0) return;   // mantém o descritor antigo: melhor que perder linhas
+
+    int old = logger->fd;
+    logger->fd = fd;
+    if (old > STDERR_FILENO) close(old);
+
+    struct stat st;
+    size_t size = fstat(fd, &st) == 0 ? (size_t)st.st_size : 0;
+
+    if (logger->binary && size == 0) {
+        tslog_write_all(fd, TSLOG_BIN_MAGIC, TSLOG_BIN_MAGIC_LEN);
+        size = TSLOG_BIN_MAGIC_LEN;
+    }
+
+    if (logger->rotation) {
+        logger->rotation->file_size = size;
+        logger->rotation->opened_at = time(NULL);
+    }
+}
+
+static int segment_exists(const char *path) {
+    char gz_path[TSLOG_PATH_MAX + 4];
+    snprintf(gz_path, sizeof(gz_path), "%s.gz", path);
+    return access(path, F_OK) == 0 || access(gz_path, F_OK) == 0;
+}
+
+static void rotate(tslog_t *logger) {
+    tslog_rotation_t *rot = logger->rotation;
+    char stamp[32];
+    char target[TSLOG_PATH_MAX];
+    time_t now = time(NULL);
+    struct tm timeinfo;
+
+    localtime_r(&now, &timeinfo);
+    strftime(stamp, sizeof(stamp), "%Y%m%d-%H%M%S", &timeinfo);
+
+    // Várias rotações no mesmo segundo: sufixo crescente, para que a ordem
+    // dos nomes continue sendo a ordem de criação mesmo depois da retenção
+    // apagar os primeiros. O segmento pode já estar comprimido (.gz).
+    if (strcmp(stamp, rot->last_stamp) == 0) {
+        rot->sequence++;
+    } else {
+        snprintf(rot->last_stamp, sizeof(rot->last_stamp), "%s", stamp);
+        rot->sequence = 0;
+    }
+    do {
+        if (rot->sequence == 0) {
+            snprintf(target, sizeof(target), "%s.%s", logger->filename, stamp);
+        } else {
+            snprintf(target, sizeof(target), "%s.%s.%03d", logger->filename, stamp, rot->sequence);
+        }
+    } while (segment_exists(target) && ++rot->sequence < 1000);
+
+    // rename + open: as escritas seguintes vão para o arquivo novo
+    if (rename(logger->filename, target) != 0) {
+        rot->opened_at = now;
+        return;
+    }
+    open_current(logger);
+
+    pthread_mutex_lock(&rot->mutex);
+    rot->pending = 1;
+    pthread_cond_signal(&rot->pending_cond);
+    pthread_mutex_unlock(&rot->mutex);
+}
+
+void tslog_rotation_before_write(tslog_t *logger, size_t len) {
+    if (atomic_exchange(&logger->reopen_requested, 0)) {
+        open_current(logger);
+    }
+
+    tslog_rotation_t *rot = logger->rotation;
+    if (!rot) return;
+
+    int by_size = rot->max_bytes > 0 && rot->file_size > 0 &&
+                  rot->file_size + len > rot->max_bytes;
+    int by_time = rot->interval > 0 && time(NULL) - rot->opened_at >= rot->interval;
+
+    if (by_size || by_time) {
+        rotate(logger);
+    }
+    rot->file_size += len;
+}
+
+int tslog_enable_rotation(tslog_t *logger, size_t max_bytes, int interval, int keep, int compress) {
+    if (!logger || logger->rotation || !logger->filename) return -1;
+
+    tslog_rotation_t *rot = calloc(1, sizeof(tslog_rotation_t));
+    if (!rot) return -1;
+
+    rot->max_bytes = max_bytes;
+    rot->interval = interval;
+    rot->keep = keep;
+    rot->compress = compress;
+    rot->opened_at = time(NULL);
+
+    struct stat st;
+    if (fstat(logger->fd, &st) == 0) {
+        rot->file_size = (size_t)st.st_size;
+    }
+
+    pthread_mutex_init(&rot->mutex, NULL);
+    pthread_cond_init(&rot->pending_cond, NULL);
+
+    pthread_mutex_lock(&logger->mutex);
+    logger->rotation = rot;
+    pthread_mutex_unlock(&logger->mutex);
+
+    if (pthread_create(&rot->compressor, NULL, compressor_thread, logger) != 0) {
+        pthread_mutex_lock(&logger->mutex);
+        logger->rotation = NULL;
+        pthread_mutex_unlock(&logger->mutex);
+        pthread_mutex_destroy(&rot->mutex);
+        pthread_cond_destroy(&rot->pending_cond);
+        free(rot);
+        return -1;
+    }
+
+    return 0;
+}
+
+// Chamada de tslog_destroy depois que a thread escritora terminou
+void tslog_rotation_destroy(tslog_t *logger) {
+    tslog_rotation_t *rot = logger->rotation;
+
+    if (sighup_logger == logger) {
+        sighup_logger = NULL;
+    }
+    if (!rot) return;
+
+    // Termina de comprimir o que já foi rotacionado
+    pthread_mutex_lock(&rot->mutex);
+    rot->stop = 1;
+    pthread_cond_signal(&rot->pending_cond);
+    pthread_mutex_unlock(&rot->mutex);
+    pthread_join(rot->compressor, NULL);
+
+    pthread_mutex_destroy(&rot->mutex);
+    pthread_cond_destroy(&rot->pending_cond);
+    free(rot);
+    logger->rotation = NULL;
+}
+
+void tslog_reopen(tslog_t *logger) {
+    if (logger) {
+        atomic_store(&logger->reopen_requested, 1);
+    }
+}
+
+static void sighup_handler(int sig) {
+    (void)sig;
+    tslog_reopen(sighup_logger);
+}
+
+void tslog_install_sighup(tslog_t *logger) {
+    sighup_logger = logger;
+
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = sighup_handler;
+    sigemptyset(&sa.sa_mask);
+    sa.sa_flags = SA_RESTART;
+    sigaction(SIGHUP, &sa, NULL);
+}
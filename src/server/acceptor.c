@@ -0,0 +1,199 @@
+#define _GNU_SOURCE     // sched_getaffinity, pthread_setaffinity_np
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sched.h>
+#include <pthread.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include "acceptor.h"
+
+int acceptor_parse_cpus(const char *spec, int *cpus, int max) {
+    int count = 0;
+    const char *p = spec;
+    while (*p) {
+        char *end;
+        long first = strtol(p, &end, 10);
+        if (end == p || first < 0 || first >= CPU_SETSIZE) return -1;
+        long last = first;
+        if (*end == '-') {
+            p = end + 1;
+            last = strtol(p, &end, 10);
+            if (end == p || last < first || last >= CPU_SETSIZE) return -1;
+        }
+        for (long cpu = first; cpu <= last; cpu++) {
+            if (count >= max) return -1;
+            cpus[count++] = (int)cpu;
+        }
+        if (*end == ',') {
+            end++;
+        } else if (*end != '\0') {
+            return -1;
+        }
+        p = end;
+    }
+    return count;
+}
+
+// CPUs em que o processo pode rodar (taskset, cgroup)
+static int allowed_cpus(int *cpus, int max) {
+    cpu_set_t set;
+    if (sched_getaffinity(0, sizeof(set), &set) != 0) return 0;
+    int count = 0;
+    for (int cpu = 0; cpu < CPU_SETSIZE && count < max; cpu++) {
+        if (CPU_ISSET(cpu, &set)) cpus[count++] = cpu;
+    }
+    return count;
+}
+
+// Kernel sem SO_REUSEPORT recusa a opção (ENOPROTOOPT)
+static int reuseport_available(void) {
+    const char *env = getenv(ACCEPTOR_REUSEPORT_ENV);
+    if (env && strcmp(env, "0") == 0) return 0;
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return 0;
+    int opt = 1;
+    int rc = setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt));
+    close(sock);
+    return rc == 0;
+}
+
+static int bind_socket(int port, int reuseport) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    if (sock < 0) return -1;
+    int opt = 1;
+    setsockopt(sock, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
+    if (reuseport && setsockopt(sock, SOL_SOCKET, SO_REUSEPORT, &opt, sizeof(opt)) < 0) {
+        close(sock);
+        return -1;
+    }
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = INADDR_ANY;
+    addr.sin_port = htons(port);
+    if (bind(sock, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
+        int saved = errno;
+        close(sock);
+        errno = saved;
+        return -1;
+    }
+    return sock;
+}
+
+int acceptor_set_init(acceptor_set_t *set, int port, int backlog, int count,
+                      const int *cpus, int cpu_count, tslog_t *logger) {
+    if (!set || count < 1 || count > ACCEPTOR_MAX) return -1;
+    memset(set, 0, sizeof(*set));
+    set->logger = logger;
+    set->started = time(NULL);
+
+    if (count > 1 && !reuseport_available()) {
+        tslog_warn(logger, "SO_REUSEPORT indisponível: um acceptor na porta %d, sem afinidade", port);
+        count = 1;
+        cpus = NULL;
+        cpu_count = 0;
+    }
+
+    int allowed[ACCEPTOR_MAX];
+    if (cpu_count <= 0 && count > 1) {
+        cpus = allowed;
+        cpu_count = allowed_cpus(allowed, ACCEPTOR_MAX);
+    }
+
+    // SO_REUSEPORT deixaria outro servidor do mesmo usuário entrar no grupo
+    // e dividir as conexões em silêncio: primeiro confere que a porta está livre
+    int reuseport = count > 1;
+    if (reuseport) {
+        int probe = bind_socket(port, 0);
+        if (probe < 0) {
+            tslog_error(logger, "Erro no bind da porta %d: %s", port, strerror(errno));
+            return -1;
+        }
+        close(probe);
+    }
+
+    for (int i = 0; i < count; i++) {
+        acceptor_t *acceptor = &set->acceptors[i];
+        acceptor->index = i;
+        acceptor->logger = logger;
+        acceptor->cpu = cpu_count > 0 ? cpus[i % cpu_count] : -1;
+        acceptor->listen_socket = bind_socket(port, reuseport);
+        if (acceptor->listen_socket < 0 || listen(acceptor->listen_socket, backlog) < 0) {
+            tslog_error(logger, "Erro no bind/listen da porta %d (acceptor %d): %s", port, i, strerror(errno));
+            if (acceptor->listen_socket >= 0) close(acceptor->listen_socket);
+            set->count = i;
+            acceptor_set_destroy(set);
+            return -1;
+        }
+        set->count = i + 1;
+    }
+    return 0;
+}
+
+void acceptor_set_destroy(acceptor_set_t *set) {
+    if (!set) return;
+    for (int i = 0; i < set->count; i++) {
+        if (set->acceptors[i].listen_socket >= 0) close(set->acceptors[i].listen_socket);
+        set->acceptors[i].listen_socket = -1;
+    }
+    set->count = 0;
+}
+
+void acceptor_pin(acceptor_t *acceptor) {
+    if (acceptor->cpu < 0) return;
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(acceptor->cpu, &set);
+    int rc = pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+    if (rc != 0) {
+        tslog_warn(acceptor->logger, "Acceptor %d: não foi possível fixar na CPU %d (%s)",
+                   acceptor->index, acceptor->cpu, strerror(rc));
+        acceptor->cpu = -1;
+    }
+}
+
+void acceptor_opened(acceptor_t *acceptor) {
+    atomic_fetch_add_explicit(&acceptor->accepted, 1, memory_order_relaxed);
+    atomic_fetch_add_explicit(&acceptor->active, 1, memory_order_relaxed);
+
+    long now = (long)time(NULL);
+    int slot = (int)(now % ACCEPTOR_RATE_WINDOW);
+    if (atomic_load_explicit(&acceptor->rate_second[slot], memory_order_relaxed) != now) {
+        atomic_store_explicit(&acceptor->rate_count[slot], 0, memory_order_relaxed);
+        atomic_store_explicit(&acceptor->rate_second[slot], now, memory_order_relaxed);
+    }
+    atomic_fetch_add_explicit(&acceptor->rate_count[slot], 1, memory_order_relaxed);
+}
+
+void acceptor_closed(acceptor_t *acceptor) {
+    atomic_fetch_sub_explicit(&acceptor->active, 1, memory_order_relaxed);
+}
+
+int acceptor_set_get_stats(acceptor_set_t *set, acceptor_stats_t *stats, int max) {
+    long now = (long)time(NULL);
+    // Servidor recém-iniciado: divide pelo tempo que ele tem, não pela janela
+    long window = now - (long)set->started + 1;
+    if (window > ACCEPTOR_RATE_WINDOW) window = ACCEPTOR_RATE_WINDOW;
+
+    int count = set->count < max ? set->count : max;
+    for (int i = 0; i < count; i++) {
+        acceptor_t *acceptor = &set->acceptors[i];
+        long recent = 0;
+        for (int s = 0; s < ACCEPTOR_RATE_WINDOW; s++) {
+            long second = atomic_load_explicit(&acceptor->rate_second[s], memory_order_relaxed);
+            if (now - second < window) {
+                recent += atomic_load_explicit(&acceptor->rate_count[s], memory_order_relaxed);
+            }
+        }
+        stats[i].index = acceptor->index;
+        stats[i].cpu = acceptor->cpu;
+        stats[i].accepted = atomic_load_explicit(&acceptor->accepted, memory_order_relaxed);
+        stats[i].active = atomic_load_explicit(&acceptor->active, memory_order_relaxed);
+        stats[i].rate = (double)recent / (double)window;
+    }
+    return count;
+}
@@ -0,0 +1,93 @@
+#include <stdio.h>
+#include <string.h>
+#include "capability.h"
+
+int capability_registry_init(capability_registry_t *reg) {
+    if (!reg) return -1;
+    memset(reg->names, 0, sizeof(reg->names));
+    reg->count = 0;
+    return pthread_mutex_init(&reg->mutex, NULL) == 0 ? 0 : -1;
+}
+
+void capability_registry_destroy(capability_registry_t *reg) {
+    if (!reg) return;
+    pthread_mutex_destroy(&reg->mutex);
+}
+
+// Bit da tag ou -1. Chamar com o mutex travado.
+static int find_tag(const capability_registry_t *reg, const char *name, size_t len) {
+    for (int i = 0; i < reg->count; i++) {
+        if (strncmp(reg->names[i], name, len) == 0 && reg->names[i][len] == '\0') {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// "a,b,c" -> máscara (vírgulas sobrando são ignoradas). Sem create, retorna 1
+// na primeira tag desconhecida e continua com as demais.
+static int parse_list(capability_registry_t *reg, const char *list, cap_mask_t *mask, int create,
+                      char *unknown, size_t unknown_size) {
+    cap_mask_t result = 0;
+    int missing = 0;
+
+    pthread_mutex_lock(&reg->mutex);
+    for (const char *p = list ? list : ""; *p; ) {
+        size_t len = strcspn(p, ",");
+        if (len >= CAPABILITY_NAME_MAX) {
+            pthread_mutex_unlock(&reg->mutex);
+            return -1;
+        }
+        if (len > 0) {
+            int bit = find_tag(reg, p, len);
+            if (bit < 0 && create) {
+                if (reg->count == CAPABILITY_MAX) {
+                    pthread_mutex_unlock(&reg->mutex);
+                    return -1;
+                }
+                bit = reg->count++;
+                memcpy(reg->names[bit], p, len);
+                reg->names[bit][len] = '\0';
+            }
+            if (bit >= 0) {
+                result |= (cap_mask_t)1 << bit;
+            } else if (!missing) {
+                missing = 1;
+                if (unknown && unknown_size) {
+                    snprintf(unknown, unknown_size, "%.*s", (int)len, p);
+                }
+            }
+        }
+        p += len;
+        if (*p == ',') p++;
+    }
+    pthread_mutex_unlock(&reg->mutex);
+
+    *mask = result;
+    return missing;
+}
+
+int capability_intern(capability_registry_t *reg, const char *list, cap_mask_t *mask) {
+    if (!reg || !mask) return -1;
+    return parse_list(reg, list, mask, 1, NULL, 0);
+}
+
+int capability_lookup(capability_registry_t *reg, const char *list, cap_mask_t *mask,
+                      char *unknown, size_t unknown_size) {
+    if (!reg || !mask) return -1;
+    return parse_list(reg, list, mask, 0, unknown, unknown_size);
+}
+
+void capability_format(capability_registry_t *reg, cap_mask_t mask, char *buffer, size_t size) {
+    size_t off = 0;
+    if (size == 0) return;
+    buffer[0] = '\0';
+
+    pthread_mutex_lock(&reg->mutex);
+    for (int i = 0; i < reg->count && off < size; i++) {
+        if (mask & ((cap_mask_t)1 << i)) {
+            off += (size_t)snprintf(buffer + off, size - off, "%s%s", off ? "," : "", reg->names[i]);
+        }
+    }
+    pthread_mutex_unlock(&reg->mutex);
+}
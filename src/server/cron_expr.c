@@ -0,0 +1,144 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include "cron_expr.h"
+
+#define CRON_MAX_STEPS 100000  // limite de avanços na busca do próximo horário
+
+static const struct {
+    const char *name;
+    const char *expr;
+} macros[] = {
+    {"@yearly",  "0 0 1 1 *"},
+    {"@annually", "0 0 1 1 *"},
+    {"@monthly", "0 0 1 * *"},
+    {"@weekly",  "0 0 * * 0"},
+    {"@daily",   "0 0 * * *"},
+    {"@midnight", "0 0 * * *"},
+    {"@hourly",  "0 * * * *"},
+};
+
+// Lê um campo ("*/15", "1-5", "0,30", ...) e marca os bits em *bits
+static int parse_field(const char *field, int min, int max, uint64_t *bits, int *any) {
+    *bits = 0;
+    *any = strcmp(field, "*") == 0;
+
+    char copy[64];
+    snprintf(copy, sizeof(copy), "%s", field);
+
+    char *save = NULL;
+    for (char *item = strtok_r(copy, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        int lo, hi, step = 1;
+        char *slash = strchr(item, '/');
+        if (slash) {
+            *slash = '\0';
+            char *end;
+            step = (int)strtol(slash + 1, &end, 10);
+            if (*end != '\0' || step < 1) return -1;
+        }
+
+        if (strcmp(item, "*") == 0) {
+            lo = min;
+            hi = max;
+        } else {
+            char *end;
+            lo = (int)strtol(item, &end, 10);
+            if (end == item) return -1;
+            if (*end == '-') {
+                char *start = end + 1;
+                hi = (int)strtol(start, &end, 10);
+                if (end == start) return -1;
+            } else {
+                hi = slash ? max : lo;  // "5/10" = de 5 até o fim, de 10 em 10
+            }
+            if (*end != '\0') return -1;
+        }
+
+        if (lo < min || hi > max || lo > hi) return -1;
+        for (int v = lo; v <= hi; v += step) {
+            *bits |= 1ULL << v;
+        }
+    }
+    return *bits ? 0 : -1;
+}
+
+int cron_expr_parse(const char *text, cron_expr_t *expr) {
+    if (!text || !expr) return -1;
+
+    for (size_t i = 0; i < sizeof(macros) / sizeof(macros[0]); i++) {
+        if (strcmp(text, macros[i].name) == 0) {
+            text = macros[i].expr;
+            break;
+        }
+    }
+
+    char fields[5][64];
+    char extra[2];
+    if (sscanf(text, "%63s %63s %63s %63s %63s %1s",
+               fields[0], fields[1], fields[2], fields[3], fields[4], extra) != 5) {
+        return -1;
+    }
+
+    uint64_t bits;
+    int any;
+    memset(expr, 0, sizeof(*expr));
+
+    if (parse_field(fields[0], 0, 59, &bits, &any) != 0) return -1;
+    expr->minutes = bits;
+    if (parse_field(fields[1], 0, 23, &bits, &any) != 0) return -1;
+    expr->hours = (uint32_t)bits;
+    if (parse_field(fields[2], 1, 31, &bits, &expr->any_day) != 0) return -1;
+    expr->days = (uint32_t)bits;
+    if (parse_field(fields[3], 1, 12, &bits, &any) != 0) return -1;
+    expr->months = (uint16_t)bits;
+    if (parse_field(fields[4], 0, 7, &bits, &expr->any_weekday) != 0) return -1;
+    if (bits & (1ULL << 7)) bits |= 1;  // 7 = domingo
+    expr->weekdays = (uint8_t)(bits & 0x7f);
+    return 0;
+}
+
+// Como no cron tradicional: se os dois campos de dia são restritos, basta um casar
+static int day_matches(const cron_expr_t *expr, const struct tm *tm) {
+    int dom = (expr->days >> tm->tm_mday) & 1;
+    int dow = (expr->weekdays >> tm->tm_wday) & 1;
+    if (expr->any_day && expr->any_weekday) return 1;
+    if (expr->any_day) return dow;
+    if (expr->any_weekday) return dom;
+    return dom || dow;
+}
+
+time_t cron_expr_next(const cron_expr_t *expr, time_t after) {
+    struct tm tm;
+    localtime_r(&after, &tm);
+    tm.tm_sec = 0;
+    tm.tm_min++;
+    tm.tm_isdst = -1;
+    time_t t = mktime(&tm);
+
+    // Avança pelo campo mais grosso que não casa, zerando os de baixo
+    for (int steps = 0; steps < CRON_MAX_STEPS && t != (time_t)-1; steps++) {
+        if (!((expr->months >> (tm.tm_mon + 1)) & 1)) {
+            tm.tm_mon++;
+            tm.tm_mday = 1;
+            tm.tm_hour = 0;
+            tm.tm_min = 0;
+        } else if (!day_matches(expr, &tm)) {
+            tm.tm_mday++;
+            tm.tm_hour = 0;
+            tm.tm_min = 0;
+        } else if (!((expr->hours >> tm.tm_hour) & 1)) {
+            tm.tm_hour++;
+            tm.tm_min = 0;
+        } else if (!((expr->minutes >> tm.tm_min) & 1)) {
+            tm.tm_min++;
+        } else if (t > after) {
+            return t;
+        } else {
+            tm.tm_min++;    // horário repetido na volta do horário de verão
+        }
+        tm.tm_isdst = -1;
+        t = mktime(&tm);
+    }
+    return (time_t)-1;
+}
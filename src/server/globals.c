@@ -4,5 +4,16 @@
 job_queue_t job_queue;
 tslog_t logger;
 worker_manager_t worker_manager;
+lease_table_t job_leases;
+job_scheduler_t job_scheduler;
+job_graph_t job_graph;
+capability_registry_t capabilities;
+runtime_history_t runtime_history;
+job_index_t job_index;
+idempotency_t idempotency;
+replication_t replication;
+notifier_t notifier;
+acceptor_set_t acceptors;
 monitor_cli_t monitor_cli;
+job_stats_t job_stats;
 int server_running = 1;
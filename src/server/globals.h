@@ -4,13 +4,31 @@
 #include "job_queue.h"
 #include "worker_manager.h"
 #include "monitor_cli.h"
+#include "job_stats.h"
+#include "job_scheduler.h"
+#include "job_graph.h"
+#include "idempotency.h"
+#include "replication.h"
+#include "notifier.h"
+#include "acceptor.h"
 #include "../include/tslog.h"
 
 // Declarações globais
 extern job_queue_t job_queue;
 extern tslog_t logger;
 extern worker_manager_t worker_manager;
+extern lease_table_t job_leases;
+extern job_scheduler_t job_scheduler;
+extern job_graph_t job_graph;
+extern capability_registry_t capabilities;
+extern runtime_history_t runtime_history;
+extern job_index_t job_index;
+extern idempotency_t idempotency;
+extern replication_t replication;
+extern notifier_t notifier;
+extern acceptor_set_t acceptors;
 extern monitor_cli_t monitor_cli;
+extern job_stats_t job_stats;
 extern int server_running;
 
 #endif
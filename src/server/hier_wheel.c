@@ -0,0 +1,157 @@
+#include <stdlib.h>
+#include <time.h>
+#include "hier_wheel.h"
+
+#define LEVEL_MASK (HIER_WHEEL_SLOTS - 1)
+#define MAX_DELTA ((1L << (HIER_WHEEL_BITS * HIER_WHEEL_LEVELS)) - 1)
+
+static long monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void list_init(timer_node_t *head) {
+    head->prev = head;
+    head->next = head;
+}
+
+static void list_append(timer_node_t *head, timer_node_t *node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+static void list_unlink(timer_node_t *node) {
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+int hier_wheel_init(hier_wheel_t *wheel, int tick_ms) {
+    for (int level = 0; level < HIER_WHEEL_LEVELS; level++) {
+        for (int i = 0; i < HIER_WHEEL_SLOTS; i++) {
+            list_init(&wheel->slots[level][i]);
+        }
+    }
+    wheel->tick_ms = tick_ms > 0 ? tick_ms : 1;
+    wheel->current = 0;
+    wheel->origin_ms = monotonic_ms();
+    wheel->count = 0;
+    return 0;
+}
+
+// Os nós pertencem a quem os agendou; aqui só são desligados da roda
+void hier_wheel_destroy(hier_wheel_t *wheel) {
+    for (int level = 0; level < HIER_WHEEL_LEVELS; level++) {
+        for (int i = 0; i < HIER_WHEEL_SLOTS; i++) {
+            timer_node_t *head = &wheel->slots[level][i];
+            while (head->next != head) {
+                list_unlink(head->next);
+            }
+        }
+    }
+    wheel->count = 0;
+}
+
+// Escolhe o nível pela distância até o vencimento: o slot de nível L é o
+// byte L do tick de vencimento, e só é visitado quando os bytes abaixo zeram
+static void place(hier_wheel_t *wheel, timer_node_t *node) {
+    long delta = node->expires - wheel->current;
+    long at = node->expires;
+    if (delta < 0) {
+        delta = 0;
+        at = wheel->current;
+    } else if (delta > MAX_DELTA) {
+        at = wheel->current + MAX_DELTA;
+        delta = MAX_DELTA;
+    }
+
+    int level = 0;
+    while (level < HIER_WHEEL_LEVELS - 1 && delta >= (1L << (HIER_WHEEL_BITS * (level + 1)))) {
+        level++;
+    }
+    int index = (int)((at >> (HIER_WHEEL_BITS * level)) & LEVEL_MASK);
+    list_append(&wheel->slots[level][index], node);
+}
+
+void hier_wheel_cancel(hier_wheel_t *wheel, timer_node_t *node) {
+    if (!node->next) return;
+    list_unlink(node);
+    wheel->count--;
+}
+
+void hier_wheel_schedule(hier_wheel_t *wheel, timer_node_t *node, long delay_ms) {
+    hier_wheel_cancel(wheel, node);
+
+    long ticks = (delay_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    if (ticks < 1) ticks = 1;
+
+    // Conta a partir do relógio, não de `current`: a roda pode estar atrasada
+    long now_tick = (monotonic_ms() - wheel->origin_ms) / wheel->tick_ms;
+    if (now_tick < wheel->current) now_tick = wheel->current;
+
+    node->expires = now_tick + ticks;
+    place(wheel, node);
+    wheel->count++;
+}
+
+// Redistribui um slot de nível alto pelos níveis abaixo
+static void cascade(hier_wheel_t *wheel, int level, int index) {
+    timer_node_t pending;
+    list_init(&pending);
+
+    timer_node_t *head = &wheel->slots[level][index];
+    while (head->next != head) {
+        timer_node_t *node = head->next;
+        list_unlink(node);
+        list_append(&pending, node);
+    }
+    while (pending.next != &pending) {
+        timer_node_t *node = pending.next;
+        list_unlink(node);
+        place(wheel, node);
+    }
+}
+
+int hier_wheel_advance(hier_wheel_t *wheel, void (*expire)(timer_node_t *node, void *arg), void *arg) {
+    long target = (monotonic_ms() - wheel->origin_ms) / wheel->tick_ms;
+    if (target <= wheel->current) return 0;
+
+    // Junta os vencidos numa lista própria antes dos callbacks, que podem
+    // cancelar ou reagendar outros timers
+    timer_node_t expired;
+    list_init(&expired);
+
+    while (wheel->current < target && wheel->count > 0) {
+        long tick = ++wheel->current;
+
+        // Ao completar uma volta de um nível, o slot correspondente do nível
+        // de cima desce; a cascata continua enquanto os bytes forem zero
+        for (int level = 1; level < HIER_WHEEL_LEVELS; level++) {
+            if ((tick & ((1L << (HIER_WHEEL_BITS * level)) - 1)) != 0) break;
+            cascade(wheel, level, (int)((tick >> (HIER_WHEEL_BITS * level)) & LEVEL_MASK));
+        }
+
+        timer_node_t *head = &wheel->slots[0][tick & LEVEL_MASK];
+        while (head->next != head) {
+            timer_node_t *node = head->next;
+            list_unlink(node);
+            wheel->count--;
+            list_append(&expired, node);
+        }
+    }
+    // Roda vazia: nada a cascatear, pula direto para o tick atual
+    wheel->current = target;
+
+    int count = 0;
+    while (expired.next != &expired) {
+        timer_node_t *node = expired.next;
+        list_unlink(node);
+        expire(node, arg);
+        count++;
+    }
+    return count;
+}
@@ -0,0 +1,307 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "idempotency.h"
+#include "database.h"
+
+static idempotency_stripe_t *stripe_of(idempotency_t *idem, int hash) {
+    return &idem->stripes[(unsigned)hash % IDEMPOTENCY_STRIPES];
+}
+
+int idempotency_init(idempotency_t *idem, int ttl, int max_keys, tslog_t *logger) {
+    if (!idem || ttl < 1 || max_keys < IDEMPOTENCY_STRIPES) return -1;
+    memset(idem, 0, sizeof(*idem));
+    idem->ttl = ttl;
+    idem->stripe_capacity = max_keys / IDEMPOTENCY_STRIPES;
+    idem->logger = logger;
+    atomic_init(&idem->hits, 0);
+    atomic_init(&idem->misses, 0);
+    atomic_init(&idem->evicted, 0);
+
+    for (int i = 0; i < IDEMPOTENCY_STRIPES; i++) {
+        idempotency_stripe_t *stripe = &idem->stripes[i];
+        if (int_map_init(&stripe->heads, 256) != 0) {
+            while (--i >= 0) {
+                int_map_destroy(&idem->stripes[i].heads);
+                pthread_mutex_destroy(&idem->stripes[i].mutex);
+            }
+            return -1;
+        }
+        pthread_mutex_init(&stripe->mutex, NULL);
+    }
+
+    tslog_info(logger, "Chaves de idempotência: validade %ds, até %d chaves", ttl, max_keys);
+    return 0;
+}
+
+void idempotency_destroy(idempotency_t *idem) {
+    if (!idem) return;
+    for (int i = 0; i < IDEMPOTENCY_STRIPES; i++) {
+        idempotency_stripe_t *stripe = &idem->stripes[i];
+        pthread_mutex_lock(&stripe->mutex);
+        idempotency_list_t *lists[] = {&stripe->pending, &stripe->answered};
+        for (int l = 0; l < 2; l++) {
+            while (lists[l]->oldest) {
+                idempotency_entry_t *next = lists[l]->oldest->newer;
+                free(lists[l]->oldest);
+                lists[l]->oldest = next;
+            }
+        }
+        int_map_destroy(&stripe->heads);
+        free(stripe->dirty);
+        pthread_mutex_unlock(&stripe->mutex);
+        pthread_mutex_destroy(&stripe->mutex);
+    }
+}
+
+/* ---- Faixa (chamar com o mutex da faixa) ---- */
+
+static idempotency_entry_t *find_locked(idempotency_stripe_t *stripe, int hash, const char *key) {
+    for (idempotency_entry_t *e = int_map_get(&stripe->heads, hash); e; e = e->next) {
+        if (strcmp(e->rec.key, key) == 0) return e;
+    }
+    return NULL;
+}
+
+static idempotency_list_t *list_of(idempotency_stripe_t *stripe, idempotency_entry_t *entry) {
+    return entry->rec.kind == IDEMPOTENCY_PENDING ? &stripe->pending : &stripe->answered;
+}
+
+static void list_append(idempotency_list_t *list, idempotency_entry_t *entry) {
+    entry->older = list->newest;
+    entry->newer = NULL;
+    if (list->newest) {
+        list->newest->newer = entry;
+    } else {
+        list->oldest = entry;
+    }
+    list->newest = entry;
+}
+
+static void list_unlink(idempotency_list_t *list, idempotency_entry_t *entry) {
+    if (entry->older) {
+        entry->older->newer = entry->newer;
+    } else {
+        list->oldest = entry->newer;
+    }
+    if (entry->newer) {
+        entry->newer->older = entry->older;
+    } else {
+        list->newest = entry->older;
+    }
+}
+
+// Tira a entrada do mapa e da sua lista e a libera
+static void remove_locked(idempotency_stripe_t *stripe, idempotency_entry_t *entry) {
+    int hash = int_map_string_key(entry->rec.key);
+    idempotency_entry_t *head = int_map_get(&stripe->heads, hash);
+    if (head == entry) {
+        if (entry->next) {
+            int_map_put(&stripe->heads, hash, entry->next);
+        } else {
+            int_map_remove(&stripe->heads, hash);
+        }
+    } else {
+        for (idempotency_entry_t *e = head; e; e = e->next) {
+            if (e->next == entry) {
+                e->next = entry->next;
+                break;
+            }
+        }
+    }
+    list_unlink(list_of(stripe, entry), entry);
+    stripe->live--;
+    free(entry);
+}
+
+// Descarta as vencidas do início das listas e, com a faixa cheia, a
+// respondida mais antiga: a pendente ainda vai receber o commit, e
+// despejá-la deixaria a nova tentativa do cliente criar outro job.
+// As respondidas estão na ordem do commit, quase a de vencimento; uma
+// vencida atrás de outra ainda válida sai depois (o claim confere a validade)
+static void trim_locked(idempotency_t *idem, idempotency_stripe_t *stripe, time_t now) {
+    while (stripe->pending.oldest && stripe->pending.oldest->rec.expires_at <= now) {
+        remove_locked(stripe, stripe->pending.oldest);
+    }
+    while (stripe->answered.oldest && stripe->answered.oldest->rec.expires_at <= now) {
+        remove_locked(stripe, stripe->answered.oldest);
+    }
+    while (stripe->live >= idem->stripe_capacity && stripe->answered.oldest) {
+        remove_locked(stripe, stripe->answered.oldest);
+        atomic_fetch_add(&idem->evicted, 1);
+    }
+}
+
+static idempotency_entry_t *insert_locked(idempotency_stripe_t *stripe,
+                                          const idempotency_record_t *rec) {
+    idempotency_entry_t *entry = malloc(sizeof(idempotency_entry_t));
+    if (!entry) return NULL;
+    entry->rec = *rec;
+
+    int hash = int_map_string_key(rec->key);
+    entry->next = int_map_get(&stripe->heads, hash);
+    if (int_map_put(&stripe->heads, hash, entry) != 0) {
+        free(entry);
+        return NULL;
+    }
+    list_append(list_of(stripe, entry), entry);
+    stripe->live++;
+    return entry;
+}
+
+static int dirty_append_locked(idempotency_stripe_t *stripe, const idempotency_record_t *rec) {
+    if (stripe->dirty_count == stripe->dirty_capacity) {
+        int capacity = stripe->dirty_capacity ? stripe->dirty_capacity * 2 : 64;
+        idempotency_record_t *grown = realloc(stripe->dirty, (size_t)capacity * sizeof(*grown));
+        if (!grown) return -1;
+        stripe->dirty = grown;
+        stripe->dirty_capacity = capacity;
+    }
+    stripe->dirty[stripe->dirty_count++] = *rec;
+    return 0;
+}
+
+/* ---- API ---- */
+
+int idempotency_claim(idempotency_t *idem, const char *key, idempotency_record_t *existing) {
+    if (!idem || !key || !key[0]) return -1;
+    int hash = int_map_string_key(key);
+    idempotency_stripe_t *stripe = stripe_of(idem, hash);
+    time_t now = time(NULL);
+
+    pthread_mutex_lock(&stripe->mutex);
+    idempotency_entry_t *entry = find_locked(stripe, hash, key);
+    if (entry && entry->rec.expires_at > now) {
+        if (existing) *existing = entry->rec;
+        pthread_mutex_unlock(&stripe->mutex);
+        atomic_fetch_add(&idem->hits, 1);
+        return 1;
+    }
+    if (entry) {
+        remove_locked(stripe, entry);
+    }
+    trim_locked(idem, stripe, now);
+
+    idempotency_record_t rec;
+    memset(&rec, 0, sizeof(rec));
+    snprintf(rec.key, sizeof(rec.key), "%s", key);
+    rec.kind = IDEMPOTENCY_PENDING;
+    rec.expires_at = now + idem->ttl;
+    entry = insert_locked(stripe, &rec);
+    pthread_mutex_unlock(&stripe->mutex);
+
+    if (!entry) return -1;
+    atomic_fetch_add(&idem->misses, 1);
+    return 0;
+}
+
+void idempotency_commit(idempotency_t *idem, const char *key, idempotency_kind_t kind,
+                        int id, time_t first_run) {
+    if (!idem || !key || !key[0]) return;
+    int hash = int_map_string_key(key);
+    idempotency_stripe_t *stripe = stripe_of(idem, hash);
+
+    pthread_mutex_lock(&stripe->mutex);
+    // Vencida enquanto pendente (submissão mais longa que o ttl): não há o que completar
+    idempotency_entry_t *entry = find_locked(stripe, hash, key);
+    if (entry && entry->rec.kind == IDEMPOTENCY_PENDING) {
+        // Respondida: passa para o fim da lista de despejo
+        list_unlink(&stripe->pending, entry);
+        entry->rec.kind = kind;
+        entry->rec.id = id;
+        entry->rec.first_run = first_run;
+        list_append(&stripe->answered, entry);
+        if (dirty_append_locked(stripe, &entry->rec) != 0) {
+            tslog_warn(idem->logger, "Sem memória: chave %s não será persistida", key);
+        }
+    }
+    pthread_mutex_unlock(&stripe->mutex);
+}
+
+void idempotency_release(idempotency_t *idem, const char *key) {
+    if (!idem || !key || !key[0]) return;
+    int hash = int_map_string_key(key);
+    idempotency_stripe_t *stripe = stripe_of(idem, hash);
+
+    pthread_mutex_lock(&stripe->mutex);
+    idempotency_entry_t *entry = find_locked(stripe, hash, key);
+    if (entry && entry->rec.kind == IDEMPOTENCY_PENDING) {
+        remove_locked(stripe, entry);
+    }
+    pthread_mutex_unlock(&stripe->mutex);
+}
+
+int idempotency_flush(idempotency_t *idem) {
+    if (!idem) return -1;
+    idempotency_record_t *rows = NULL;
+    int count = 0, capacity = 0;
+
+    // Só a troca dos vetores acontece sob as travas; o banco vem depois
+    for (int i = 0; i < IDEMPOTENCY_STRIPES; i++) {
+        idempotency_stripe_t *stripe = &idem->stripes[i];
+        pthread_mutex_lock(&stripe->mutex);
+        idempotency_record_t *dirty = stripe->dirty;
+        int dirty_count = stripe->dirty_count;
+        stripe->dirty = NULL;
+        stripe->dirty_count = 0;
+        stripe->dirty_capacity = 0;
+        pthread_mutex_unlock(&stripe->mutex);
+
+        if (dirty_count == 0) {
+            free(dirty);
+            continue;
+        }
+        if (count + dirty_count > capacity) {
+            capacity = (count + dirty_count) * 2;
+            idempotency_record_t *grown = realloc(rows, (size_t)capacity * sizeof(*rows));
+            if (!grown) {
+                free(dirty);
+                continue;
+            }
+            rows = grown;
+        }
+        memcpy(rows + count, dirty, (size_t)dirty_count * sizeof(*rows));
+        count += dirty_count;
+        free(dirty);
+    }
+
+    int rc = database_save_idempotency_keys(rows, count, time(NULL));
+    free(rows);
+    return rc;
+}
+
+static void load_record(const idempotency_record_t *rec, void *arg) {
+    idempotency_t *idem = (idempotency_t*)arg;
+    int hash = int_map_string_key(rec->key);
+    idempotency_stripe_t *stripe = stripe_of(idem, hash);
+
+    pthread_mutex_lock(&stripe->mutex);
+    idempotency_entry_t *entry = find_locked(stripe, hash, rec->key);
+    if (entry) {
+        remove_locked(stripe, entry);
+    }
+    trim_locked(idem, stripe, time(NULL));
+    insert_locked(stripe, rec);
+    pthread_mutex_unlock(&stripe->mutex);
+}
+
+int idempotency_load(idempotency_t *idem) {
+    if (!idem) return -1;
+    return database_load_idempotency_keys(time(NULL), load_record, idem);
+}
+
+long idempotency_count(idempotency_t *idem) {
+    long total = 0;
+    for (int i = 0; i < IDEMPOTENCY_STRIPES; i++) {
+        pthread_mutex_lock(&idem->stripes[i].mutex);
+        total += idem->stripes[i].live;
+        pthread_mutex_unlock(&idem->stripes[i].mutex);
+    }
+    return total;
+}
+
+void idempotency_get_counters(idempotency_t *idem, long *hits, long *misses, long *evicted) {
+    if (hits) *hits = atomic_load(&idem->hits);
+    if (misses) *misses = atomic_load(&idem->misses);
+    if (evicted) *evicted = atomic_load(&idem->evicted);
+}
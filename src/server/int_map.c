@@ -0,0 +1,130 @@
+#include <stdlib.h>
+#include <stdint.h>
+#include "int_map.h"
+
+static size_t bucket_of(const int_map_t *map, int key) {
+    // Mistura os bits: ids sequenciais não caem em baldes vizinhos
+    uint32_t h = (uint32_t)key * 2654435761u;
+    return (size_t)(h ^ (h >> 16)) & (map->capacity - 1);
+}
+
+int int_map_init(int_map_t *map, size_t capacity) {
+    size_t size = 16;
+    while (size < capacity) size <<= 1;
+
+    map->buckets = calloc(size, sizeof(int_map_entry_t*));
+    if (!map->buckets) return -1;
+
+    map->capacity = size;
+    map->size = 0;
+    return 0;
+}
+
+void int_map_destroy(int_map_t *map) {
+    if (!map->buckets) return;
+
+    for (size_t i = 0; i < map->capacity; i++) {
+        int_map_entry_t *entry = map->buckets[i];
+        while (entry) {
+            int_map_entry_t *next = entry->next;
+            free(entry);
+            entry = next;
+        }
+    }
+    free(map->buckets);
+    map->buckets = NULL;
+    map->size = 0;
+}
+
+void* int_map_get(const int_map_t *map, int key) {
+    for (int_map_entry_t *entry = map->buckets[bucket_of(map, key)]; entry; entry = entry->next) {
+        if (entry->key == key) return entry->value;
+    }
+    return NULL;
+}
+
+static int grow(int_map_t *map) {
+    size_t old_capacity = map->capacity;
+    int_map_entry_t **old = map->buckets;
+
+    map->buckets = calloc(old_capacity * 2, sizeof(int_map_entry_t*));
+    if (!map->buckets) {
+        map->buckets = old;
+        return -1;
+    }
+    map->capacity = old_capacity * 2;
+
+    for (size_t i = 0; i < old_capacity; i++) {
+        int_map_entry_t *entry = old[i];
+        while (entry) {
+            int_map_entry_t *next = entry->next;
+            size_t b = bucket_of(map, entry->key);
+            entry->next = map->buckets[b];
+            map->buckets[b] = entry;
+            entry = next;
+        }
+    }
+    free(old);
+    return 0;
+}
+
+int int_map_put(int_map_t *map, int key, void *value) {
+    size_t b = bucket_of(map, key);
+    for (int_map_entry_t *entry = map->buckets[b]; entry; entry = entry->next) {
+        if (entry->key == key) {
+            entry->value = value;
+            return 0;
+        }
+    }
+
+    if ((map->size + 1) * 4 > map->capacity * 3) {
+        grow(map);   // sem memória para crescer: segue com mais colisões
+        b = bucket_of(map, key);
+    }
+
+    int_map_entry_t *entry = malloc(sizeof(int_map_entry_t));
+    if (!entry) return -1;
+
+    entry->key = key;
+    entry->value = value;
+    entry->next = map->buckets[b];
+    map->buckets[b] = entry;
+    map->size++;
+    return 0;
+}
+
+void* int_map_remove(int_map_t *map, int key) {
+    int_map_entry_t **link = &map->buckets[bucket_of(map, key)];
+    while (*link) {
+        int_map_entry_t *entry = *link;
+        if (entry->key == key) {
+            void *value = entry->value;
+            *link = entry->next;
+            free(entry);
+            map->size--;
+            return value;
+        }
+        link = &entry->next;
+    }
+    return NULL;
+}
+
+void int_map_foreach(const int_map_t *map, void (*callback)(int key, void *value, void *arg), void *arg) {
+    for (size_t i = 0; i < map->capacity; i++) {
+        int_map_entry_t *entry = map->buckets[i];
+        while (entry) {
+            // Guarda o próximo antes: o callback pode remover a entrada atual
+            int_map_entry_t *next = entry->next;
+            callback(entry->key, entry->value, arg);
+            entry = next;
+        }
+    }
+}
+
+int int_map_string_key(const char *str) {
+    unsigned int h = 2166136261u;
+    for (const char *c = str; *c; c++) {
+        h = (h ^ (unsigned char)*c) * 16777619u;
+    }
+    return (int)(h & 0x7fffffff);
+}
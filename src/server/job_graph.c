@@ -0,0 +1,607 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "job_graph.h"
+#include "database.h"
+
+#define JOB_GRAPH_MAX_BATCH_DEPS 16   // @batch por job
+
+// Cópia do job segurado (node->job aponta para `job`). Alocada na submissão:
+// quando o job é liberado ou derrubado ela passa para a lista de ações, e a
+// propagação não precisa alocar nada (nem perder um dependente por falta de
+// memória).
+typedef struct graph_held {
+    job_t job;                  // primeiro campo: free(node->job) libera tudo
+    struct graph_held *next;
+    int status;                 // derrubado: JOB_FAILED ou JOB_CANCELLED
+    int cause;
+    const job_batch_t *batch;   // batches com membros só são liberados no destroy
+} graph_held_t;
+
+typedef struct {
+    graph_held_t *head;
+    graph_held_t *tail;
+    int count;
+} held_list_t;
+
+// Efeitos colaterais (fila e database) acontecem depois de soltar o mutex;
+// durante a propagação só se anota o que fazer
+typedef struct {
+    held_list_t released;
+    held_list_t failed;
+} graph_actions_t;
+
+static int push_int(int **array, int *count, int *capacity, int value) {
+    if (*count == *capacity) {
+        int new_capacity = *capacity ? *capacity * 2 : 4;
+        int *grown = realloc(*array, (size_t)new_capacity * sizeof(int));
+        if (!grown) return -1;
+        *array = grown;
+        *capacity = new_capacity;
+    }
+    (*array)[(*count)++] = value;
+    return 0;
+}
+
+int job_graph_init(job_graph_t *graph, job_queue_t *queue, tslog_t *logger) {
+    if (!graph || !queue) return -1;
+
+    graph->queue = queue;
+    graph->logger = logger;
+    graph->waiting = 0;
+    graph->released = 0;
+    graph->failed = 0;
+    graph->on_final = NULL;
+    graph->final_arg = NULL;
+
+    if (pthread_mutex_init(&graph->mutex, NULL) != 0) {
+        tslog_error(logger, "Falha ao inicializar mutex do grafo de dependências");
+        return -1;
+    }
+
+    if (int_map_init(&graph->nodes, 256) != 0 || int_map_init(&graph->batches, 16) != 0) {
+        tslog_error(logger, "Falha ao alocar grafo de dependências");
+        int_map_destroy(&graph->nodes);
+        pthread_mutex_destroy(&graph->mutex);
+        return -1;
+    }
+
+    return 0;
+}
+
+static void free_node(graph_node_t *node) {
+    free(node->dependents);
+    free(node->job);
+    free(node);
+}
+
+static void free_node_entry(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    free_node((graph_node_t*)value);
+}
+
+static void free_batch_entry(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    job_batch_t *batch = (job_batch_t*)value;
+    free(batch->pending);
+    free(batch);
+}
+
+void job_graph_destroy(job_graph_t *graph) {
+    if (!graph) return;
+
+    pthread_mutex_lock(&graph->mutex);
+    int_map_foreach(&graph->nodes, free_node_entry, NULL);
+    int_map_destroy(&graph->nodes);
+    int_map_foreach(&graph->batches, free_batch_entry, NULL);
+    int_map_destroy(&graph->batches);
+    pthread_mutex_unlock(&graph->mutex);
+    pthread_mutex_destroy(&graph->mutex);
+}
+
+/* ---- Batches ---- */
+
+static job_batch_t *get_batch(job_graph_t *graph, const char *name, int create) {
+    int key = int_map_string_key(name);
+    job_batch_t *batch;
+    while ((batch = int_map_get(&graph->batches, key)) != NULL) {
+        if (strcmp(batch->name, name) == 0) return batch;
+        key = (key + 1) & 0x7fffffff;
+    }
+    if (!create) return NULL;
+
+    batch = calloc(1, sizeof(job_batch_t));
+    if (!batch) return NULL;
+    snprintf(batch->name, sizeof(batch->name), "%s", name);
+    batch->map_key = key;
+    if (int_map_put(&graph->batches, key, batch) != 0) {
+        free(batch);
+        return NULL;
+    }
+    return batch;
+}
+
+// Tira o job da lista de pendentes do batch (troca com o último: O(1))
+static void batch_detach(job_graph_t *graph, graph_node_t *node, int success) {
+    job_batch_t *batch = node->batch;
+    if (!batch) return;
+
+    int last = batch->pending[--batch->pending_count];
+    if (node->batch_index < batch->pending_count) {
+        batch->pending[node->batch_index] = last;
+        graph_node_t *moved = int_map_get(&graph->nodes, last);
+        if (moved) moved->batch_index = node->batch_index;
+    }
+    if (!success) {
+        batch->failed++;
+        batch->last_failed = node->job_id;
+    }
+    node->batch = NULL;
+}
+
+/* ---- Propagação ---- */
+
+// Tira a cópia do nó e a põe no fim da lista (mantém a ordem de liberação)
+static graph_held_t *take_held(held_list_t *list, graph_node_t *node) {
+    graph_held_t *held = (graph_held_t*)node->job;
+    node->job = NULL;
+    held->next = NULL;
+    if (list->tail) {
+        list->tail->next = held;
+    } else {
+        list->head = held;
+    }
+    list->tail = held;
+    list->count++;
+    return held;
+}
+
+static void note_release(graph_actions_t *actions, graph_node_t *node) {
+    take_held(&actions->released, node);
+}
+
+static void note_failure(graph_actions_t *actions, graph_node_t *node, int status, int cause,
+                         const job_batch_t *batch) {
+    graph_held_t *held = take_held(&actions->failed, node);
+    held->status = status;
+    held->cause = cause;
+    held->batch = batch;
+}
+
+// O nó terminou com `status` (já fora do mapa). Sucesso decrementa os
+// contadores dos dependentes; falha/cancelamento derruba os dependentes e,
+// por uma pilha encadeada nos próprios nós, os dependentes deles. Não aloca
+// memória. Chamar com o mutex.
+static void resolve_locked(job_graph_t *graph, graph_node_t *root, int status, graph_actions_t *actions) {
+    graph_node_t *stack = NULL;
+    graph_node_t *node = root;
+
+    while (node) {
+        int success = status == JOB_COMPLETED;
+        batch_detach(graph, node, success);
+
+        for (int i = 0; i < node->dependent_count; i++) {
+            graph_node_t *dep = int_map_get(&graph->nodes, node->dependents[i]);
+            if (!dep || dep->state != GRAPH_WAITING) continue;
+
+            if (success) {
+                if (--dep->unresolved > 0) continue;
+                dep->state = GRAPH_QUEUED;
+                note_release(actions, dep);
+                graph->waiting--;
+                graph->released++;
+                // Sem dependentes nem batch não há mais o que acompanhar
+                if (dep->dependent_count == 0 && !dep->batch) {
+                    int_map_remove(&graph->nodes, dep->job_id);
+                    free_node(dep);
+                }
+            } else {
+                // Sai do batch antes do mapa: batch_detach de outros membros
+                // precisa achar este nó para corrigir o índice
+                const job_batch_t *batch = dep->batch;
+                batch_detach(graph, dep, 0);
+                int_map_remove(&graph->nodes, dep->job_id);
+                graph->waiting--;
+                graph->failed++;
+                note_failure(actions, dep, status, node->job_id, batch);
+                dep->next = stack;
+                stack = dep;
+            }
+        }
+
+        free_node(node);
+        node = stack;
+        if (stack) stack = stack->next;
+    }
+}
+
+static void run_actions(job_graph_t *graph, graph_actions_t *actions) {
+    graph_held_t *held = actions->released.head;
+    while (held) {
+        graph_held_t *next = held->next;
+        job_queue_push_reserved(graph->queue, &held->job, 0);
+        tslog_info_limited(graph->logger, "queue", "Job %d liberado: dependências concluídas",
+                           held->job.job_id);
+        free(held);
+        held = next;
+    }
+
+    int cancelled = actions->failed.head && actions->failed.head->status == JOB_CANCELLED;
+    held = actions->failed.head;
+    while (held) {
+        graph_held_t *next = held->next;
+        job_status_t status = held->status == JOB_CANCELLED ? JOB_CANCELLED : JOB_FAILED;
+        char reason[96];
+        snprintf(reason, sizeof(reason), "dependência %d %s", held->cause,
+                 status == JOB_CANCELLED ? "cancelada" : "falhou");
+        database_update_job_status(held->job.job_id, status, 0, reason);
+        job_index_update(graph->queue->index, held->job.job_id, status, 0, -1);
+        if (graph->on_final) {
+            graph->on_final(held->job.job_id, status, held->batch ? held->batch->name : "", held->job.needs,
+                            graph->final_arg);
+        }
+        free(held);
+        held = next;
+    }
+    if (actions->failed.count > 0) {
+        tslog_warn(graph->logger, "%d jobs dependentes não vão executar (%s)", actions->failed.count,
+                   cancelled ? "cancelamento" : "falha");
+    }
+}
+
+/* ---- Submissão ---- */
+
+typedef struct {
+    int ids[JOB_GRAPH_MAX_DEPS];
+    int id_count;
+    char batches[JOB_GRAPH_MAX_BATCH_DEPS][JOB_CLIENT_MAX];
+    int batch_count;
+} dep_list_t;
+
+static int parse_after(const char *after, dep_list_t *deps, char *error, size_t error_size) {
+    memset(deps, 0, sizeof(*deps));
+    if (!after || !*after) return 0;
+
+    char copy[JOB_AFTER_MAX];
+    snprintf(copy, sizeof(copy), "%s", after);
+
+    char *save = NULL;
+    for (char *item = strtok_r(copy, ",", &save); item; item = strtok_r(NULL, ",", &save)) {
+        if (item[0] == '@') {
+            if (deps->batch_count == JOB_GRAPH_MAX_BATCH_DEPS || !item[1] ||
+                strlen(item + 1) >= JOB_CLIENT_MAX) {
+                snprintf(error, error_size, "batch inválido: %s", item);
+                return -1;
+            }
+            strcpy(deps->batches[deps->batch_count++], item + 1);
+            continue;
+        }
+
+        char *end;
+        long id = strtol(item, &end, 10);
+        if (*end != '\0' || id <= 0) {
+            snprintf(error, error_size, "dependência inválida: %s", item);
+            return -1;
+        }
+        if (deps->id_count == JOB_GRAPH_MAX_DEPS) {
+            snprintf(error, error_size, "mais de %d dependências (use batch)", JOB_GRAPH_MAX_DEPS);
+            return -1;
+        }
+        deps->ids[deps->id_count++] = (int)id;
+    }
+    return 0;
+}
+
+static int add_edge(graph_node_t *from, graph_node_t *to) {
+    if (push_int(&from->dependents, &from->dependent_count, &from->dependent_capacity, to->job_id) != 0) {
+        return -1;
+    }
+    to->unresolved++;
+    return 0;
+}
+
+// Nó de acompanhamento para um job que está na fila/executando
+static graph_node_t *track_queued(job_graph_t *graph, int job_id) {
+    graph_node_t *node = int_map_get(&graph->nodes, job_id);
+    if (node) return node;
+
+    node = calloc(1, sizeof(graph_node_t));
+    if (!node) return NULL;
+    node->job_id = job_id;
+    node->state = GRAPH_QUEUED;
+    if (int_map_put(&graph->nodes, job_id, node) != 0) {
+        free(node);
+        return NULL;
+    }
+    return node;
+}
+
+// Tira as arestas para `node` que esta submissão criou (são as últimas de
+// cada dependência) e o que ficou sem uso: nós de acompanhamento sem
+// dependentes nem batch e o batch próprio ainda sem membros. Um nó
+// acompanhado de antes sempre tem um dos dois; um batch de antes, membros.
+// Chamar com o mutex.
+static void undo_submit(job_graph_t *graph, graph_node_t *node, const int *track, int track_count,
+                        job_batch_t **dep_batches, int batch_count, job_batch_t *own_batch) {
+    if (node->batch) {
+        batch_detach(graph, node, 1);
+        own_batch->members--;
+    }
+
+    for (int i = 0; i < track_count + batch_count; i++) {
+        job_batch_t *b = i < track_count ? NULL : dep_batches[i - track_count];
+        int member_count = b ? b->pending_count : 1;
+        for (int m = 0; m < member_count; m++) {
+            graph_node_t *dep = int_map_get(&graph->nodes, b ? b->pending[m] : track[i]);
+            if (!dep) continue;
+            while (dep->dependent_count > 0 && dep->dependents[dep->dependent_count - 1] == node->job_id) {
+                dep->dependent_count--;
+            }
+            if (dep->state == GRAPH_QUEUED && dep->dependent_count == 0 && !dep->batch) {
+                int_map_remove(&graph->nodes, dep->job_id);
+                free_node(dep);
+            }
+        }
+    }
+
+    if (own_batch && own_batch->members == 0) {
+        int_map_remove(&graph->batches, own_batch->map_key);
+        free(own_batch->pending);
+        free(own_batch);
+    }
+}
+
+int job_graph_submit(job_graph_t *graph, job_t *job, const char *after, const char *batch,
+                     char *error, size_t error_size) {
+    dep_list_t deps;
+    if (parse_after(after, &deps, error, error_size) != 0) return -1;
+
+    // A cópia do job também vem antes do mutex: se ele ficar segurado, a
+    // liberação não precisa de memória
+    graph_node_t *node = calloc(1, sizeof(graph_node_t));
+    if (node) node->job = malloc(sizeof(graph_held_t));
+    if (!node || !node->job) {
+        free(node);
+        snprintf(error, error_size, "sem memória");
+        return -1;
+    }
+
+    pthread_mutex_lock(&graph->mutex);
+
+    job->job_id = job_queue_reserve_id(graph->queue);
+    job->submitted_at = time(NULL);
+    node->job_id = job->job_id;
+
+    // Passada 1: valida tudo antes de criar qualquer aresta. Jobs fora do
+    // grafo já terminaram ou estão na fila: o database diz qual dos dois.
+    // Consultar sob o mutex fecha a corrida com job_graph_finish, que só é
+    // chamado depois de o resultado ir para o database.
+    int failed_cause = 0, failed_status = JOB_FAILED;
+    int track[JOB_GRAPH_MAX_DEPS];
+    int track_count = 0;
+    job_batch_t *dep_batches[JOB_GRAPH_MAX_BATCH_DEPS];
+    int batch_count = 0;
+    job_batch_t *own_batch = NULL;
+
+    for (int i = 0; i < deps.id_count; i++) {
+        int dep = deps.ids[i];
+        if (dep >= job->job_id) {
+            snprintf(error, error_size, "dependência %d não existe", dep);
+            goto fail;
+        }
+        if (int_map_get(&graph->nodes, dep)) {
+            track[track_count++] = dep;
+            continue;
+        }
+
+        job_record_t rec;
+        if (database_get_job(dep, &rec) != 0) {
+            snprintf(error, error_size, "dependência %d não existe", dep);
+            goto fail;
+        }
+        switch (rec.status) {
+            case JOB_COMPLETED:
+                break;
+            case JOB_PENDING:
+            case JOB_RUNNING:
+                track[track_count++] = dep;
+                break;
+            default:
+                failed_cause = dep;
+                failed_status = rec.status == JOB_CANCELLED ? JOB_CANCELLED : JOB_FAILED;
+                break;
+        }
+    }
+
+    for (int i = 0; i < deps.batch_count; i++) {
+        dep_batches[i] = get_batch(graph, deps.batches[i], 0);
+        if (!dep_batches[i]) {
+            snprintf(error, error_size, "batch %s não existe", deps.batches[i]);
+            goto fail;
+        }
+        batch_count++;
+        if (dep_batches[i]->failed > 0 && !failed_cause) {
+            failed_cause = dep_batches[i]->last_failed;
+            failed_status = JOB_FAILED;
+        }
+    }
+
+    if (batch && *batch) {
+        own_batch = get_batch(graph, batch, 1);
+        if (!own_batch) {
+            snprintf(error, error_size, "sem memória");
+            goto fail;
+        }
+    }
+
+    // Passada 2: arestas reversas a partir das dependências pendentes
+    if (!failed_cause) {
+        for (int i = 0; i < track_count; i++) {
+            graph_node_t *dep = track_queued(graph, track[i]);
+            if (!dep || add_edge(dep, node) != 0) {
+                snprintf(error, error_size, "sem memória");
+                goto fail;
+            }
+        }
+        for (int i = 0; i < deps.batch_count; i++) {
+            job_batch_t *b = dep_batches[i];
+            for (int m = 0; m < b->pending_count; m++) {
+                graph_node_t *member = int_map_get(&graph->nodes, b->pending[m]);
+                if (member && add_edge(member, node) != 0) {
+                    snprintf(error, error_size, "sem memória");
+                    goto fail;
+                }
+            }
+        }
+    }
+
+    if (own_batch) {
+        own_batch->members++;
+        if (failed_cause) {
+            own_batch->failed++;
+            own_batch->last_failed = node->job_id;
+        } else {
+            node->batch_index = own_batch->pending_count;
+            if (push_int(&own_batch->pending, &own_batch->pending_count, &own_batch->pending_capacity,
+                         node->job_id) != 0) {
+                own_batch->members--;
+                snprintf(error, error_size, "sem memória");
+                goto fail;
+            }
+            node->batch = own_batch;
+        }
+    }
+
+    int job_id = job->job_id;
+    int queue_now = 0;
+
+    if (failed_cause) {
+        // Nasce falhado: fica registrado, mas nunca executa
+        graph->failed++;
+        job->status = failed_status;
+        database_save_job(job);
+        char reason[96];
+        snprintf(reason, sizeof(reason), "dependência %d %s", failed_cause,
+                 failed_status == JOB_CANCELLED ? "cancelada" : "falhou");
+        database_update_job_status(job_id, failed_status, 0, reason);
+        job_index_track(graph->queue->index, job, failed_status);
+        free_node(node);
+    } else if (node->unresolved > 0) {
+        node->state = GRAPH_WAITING;
+        if (int_map_put(&graph->nodes, job_id, node) != 0) {
+            snprintf(error, error_size, "sem memória");
+            goto fail;
+        }
+        *node->job = *job;
+        graph->waiting++;
+        job_index_track(graph->queue->index, job, JOB_PENDING);
+        // Gravado sob o mutex: a liberação (que não grava de novo) não pode
+        // passar na frente
+        database_save_job(job);
+    } else {
+        node->state = GRAPH_QUEUED;
+        queue_now = 1;
+        free(node->job);
+        node->job = NULL;
+        if (!node->batch) {
+            free_node(node);
+        } else if (int_map_put(&graph->nodes, job_id, node) != 0) {
+            snprintf(error, error_size, "sem memória");
+            goto fail;
+        }
+    }
+
+    pthread_mutex_unlock(&graph->mutex);
+
+    if (queue_now) {
+        job_queue_push_reserved(graph->queue, job, 1);
+    } else if (!failed_cause) {
+        tslog_info_limited(graph->logger, "queue", "Job %d aguardando %d dependências",
+                           job_id, deps.id_count + deps.batch_count);
+    }
+    return job_id;
+
+fail:
+    undo_submit(graph, node, track, track_count, dep_batches, batch_count, own_batch);
+    pthread_mutex_unlock(&graph->mutex);
+    free_node(node);
+    return -1;
+}
+
+static void finish_with(job_graph_t *graph, int job_id, int status) {
+    graph_actions_t actions;
+    memset(&actions, 0, sizeof(actions));
+
+    pthread_mutex_lock(&graph->mutex);
+    graph_node_t *node = int_map_get(&graph->nodes, job_id);
+    if (!node || node->state != GRAPH_QUEUED) {
+        pthread_mutex_unlock(&graph->mutex);
+        return;
+    }
+    int_map_remove(&graph->nodes, job_id);
+    resolve_locked(graph, node, status, &actions);
+    pthread_mutex_unlock(&graph->mutex);
+
+    run_actions(graph, &actions);
+}
+
+void job_graph_finish(job_graph_t *graph, int job_id, int success) {
+    finish_with(graph, job_id, success ? JOB_COMPLETED : JOB_FAILED);
+}
+
+void job_graph_finish_cancelled(job_graph_t *graph, int job_id) {
+    finish_with(graph, job_id, JOB_CANCELLED);
+}
+
+int job_graph_cancel(job_graph_t *graph, int job_id) {
+    graph_actions_t actions;
+    memset(&actions, 0, sizeof(actions));
+
+    pthread_mutex_lock(&graph->mutex);
+    graph_node_t *node = int_map_get(&graph->nodes, job_id);
+    if (!node || node->state != GRAPH_WAITING) {
+        pthread_mutex_unlock(&graph->mutex);
+        return -1;
+    }
+    int_map_remove(&graph->nodes, job_id);
+    graph->waiting--;
+    const job_batch_t *batch = node->batch;
+    char needs[JOB_NEEDS_MAX];
+    snprintf(needs, sizeof(needs), "%s", node->job ? node->job->needs : "");
+    resolve_locked(graph, node, JOB_CANCELLED, &actions);
+    pthread_mutex_unlock(&graph->mutex);
+
+    database_update_job_status(job_id, JOB_CANCELLED, 0, "cancelado pelo cliente");
+    job_index_update(graph->queue->index, job_id, JOB_CANCELLED, 0, -1);
+    if (graph->on_final) {
+        graph->on_final(job_id, JOB_CANCELLED, batch ? batch->name : "", needs, graph->final_arg);
+    }
+    tslog_info(graph->logger, "Job %d cancelado", job_id);
+    run_actions(graph, &actions);
+    return 0;
+}
+
+int job_graph_batch_of(job_graph_t *graph, int job_id, char *batch, size_t size) {
+    pthread_mutex_lock(&graph->mutex);
+    graph_node_t *node = int_map_get(&graph->nodes, job_id);
+    int rc = node && node->batch ? 0 : -1;
+    if (rc == 0) snprintf(batch, size, "%s", node->batch->name);
+    pthread_mutex_unlock(&graph->mutex);
+    return rc;
+}
+
+void job_graph_set_final_hook(job_graph_t *graph,
+                              void (*hook)(int job_id, job_status_t status, const char *batch,
+                                           const char *needs, void *arg),
+                              void *arg) {
+    graph->on_final = hook;
+    graph->final_arg = arg;
+}
+
+void job_graph_get_counters(job_graph_t *graph, long *waiting, long *released, long *failed) {
+    pthread_mutex_lock(&graph->mutex);
+    if (waiting) *waiting = graph->waiting;
+    if (released) *released = graph->released;
+    if (failed) *failed = graph->failed;
+    pthread_mutex_unlock(&graph->mutex);
+}
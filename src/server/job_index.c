@@ -0,0 +1,192 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "job_index.h"
+
+static job_index_stripe_t *stripe_of(job_index_t *index, int job_id) {
+    return &index->stripes[(unsigned)job_id % JOB_INDEX_STRIPES];
+}
+
+int job_index_is_final(job_status_t status) {
+    return status != JOB_PENDING && status != JOB_RUNNING;
+}
+
+int job_index_init(job_index_t *index) {
+    if (!index) return -1;
+    memset(index, 0, sizeof(*index));
+
+    index->finished = malloc(JOB_INDEX_RETAIN * sizeof(int));
+    if (!index->finished) return -1;
+
+    for (int i = 0; i < JOB_INDEX_STRIPES; i++) {
+        if (int_map_init(&index->stripes[i].entries, 256) != 0 ||
+            pthread_rwlock_init(&index->stripes[i].lock, NULL) != 0) {
+            int_map_destroy(&index->stripes[i].entries);
+            while (--i >= 0) {
+                int_map_destroy(&index->stripes[i].entries);
+                pthread_rwlock_destroy(&index->stripes[i].lock);
+            }
+            free(index->finished);
+            return -1;
+        }
+    }
+    pthread_mutex_init(&index->finished_mutex, NULL);
+    return 0;
+}
+
+static void free_entry(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    free(value);
+}
+
+void job_index_destroy(job_index_t *index) {
+    if (!index) return;
+    for (int i = 0; i < JOB_INDEX_STRIPES; i++) {
+        int_map_foreach(&index->stripes[i].entries, free_entry, NULL);
+        int_map_destroy(&index->stripes[i].entries);
+        pthread_rwlock_destroy(&index->stripes[i].lock);
+    }
+    pthread_mutex_destroy(&index->finished_mutex);
+    free(index->finished);
+    index->finished = NULL;
+}
+
+// O job terminou: entra no fim do anel e, com o anel cheio, o terminado
+// mais antigo sai do índice. Chamar sem nenhuma trava de faixa.
+static void retire(job_index_t *index, int job_id) {
+    int evicted = 0;
+
+    pthread_mutex_lock(&index->finished_mutex);
+    int tail = (index->finished_head + index->finished_count) % JOB_INDEX_RETAIN;
+    if (index->finished_count == JOB_INDEX_RETAIN) {
+        evicted = index->finished[index->finished_head];
+        index->finished_head = (index->finished_head + 1) % JOB_INDEX_RETAIN;
+        tail = (index->finished_head + index->finished_count - 1) % JOB_INDEX_RETAIN;
+    } else {
+        index->finished_count++;
+    }
+    index->finished[tail] = job_id;
+    pthread_mutex_unlock(&index->finished_mutex);
+
+    if (evicted <= 0) return;
+    job_index_stripe_t *stripe = stripe_of(index, evicted);
+    pthread_rwlock_wrlock(&stripe->lock);
+    job_index_entry_t *entry = int_map_get(&stripe->entries, evicted);
+    if (entry && job_index_is_final(entry->status)) {
+        int_map_remove(&stripe->entries, evicted);
+    } else {
+        entry = NULL;
+    }
+    pthread_rwlock_unlock(&stripe->lock);
+    free(entry);
+}
+
+void job_index_track(job_index_t *index, const job_t *job, job_status_t status) {
+    if (!index || !job || job->job_id <= 0) return;
+    job_index_stripe_t *stripe = stripe_of(index, job->job_id);
+    int finished = 0;
+
+    pthread_rwlock_wrlock(&stripe->lock);
+    job_index_entry_t *entry = int_map_get(&stripe->entries, job->job_id);
+    if (!entry && (entry = calloc(1, sizeof(job_index_entry_t))) != NULL &&
+        int_map_put(&stripe->entries, job->job_id, entry) != 0) {
+        free(entry);
+        entry = NULL;
+    }
+    if (entry) {
+        finished = job_index_is_final(status) && (!entry->job_id || !job_index_is_final(entry->status));
+        entry->job_id = job->job_id;
+        entry->status = status;
+        entry->worker_id = job->assigned_worker;
+        entry->attempts = job->attempts;
+        entry->priority = job->priority;
+        snprintf(entry->client, sizeof(entry->client), "%s", job->client);
+        entry->submitted_at = job->submitted_at ? job->submitted_at : time(NULL);
+        entry->updated_at = time(NULL);
+    }
+    pthread_rwlock_unlock(&stripe->lock);
+
+    if (finished) retire(index, job->job_id);
+}
+
+void job_index_update(job_index_t *index, int job_id, job_status_t status, int worker_id, int attempts) {
+    if (!index) return;
+    job_index_stripe_t *stripe = stripe_of(index, job_id);
+    int finished = 0;
+
+    pthread_rwlock_wrlock(&stripe->lock);
+    job_index_entry_t *entry = int_map_get(&stripe->entries, job_id);
+    if (entry) {
+        finished = job_index_is_final(status) && !job_index_is_final(entry->status);
+        entry->status = status;
+        entry->worker_id = worker_id;
+        if (attempts >= 0) entry->attempts = attempts;
+        entry->updated_at = time(NULL);
+    }
+    pthread_rwlock_unlock(&stripe->lock);
+
+    if (finished) retire(index, job_id);
+    if (index->on_update) index->on_update(job_id, status, worker_id, attempts, index->update_arg);
+}
+
+void job_index_set_update_hook(job_index_t *index,
+                               void (*hook)(int job_id, job_status_t status, int worker_id,
+                                            int attempts, void *arg), void *arg) {
+    if (!index) return;
+    index->on_update = hook;
+    index->update_arg = arg;
+}
+
+int job_index_get(job_index_t *index, int job_id, job_index_entry_t *out) {
+    if (!index || !out) return -1;
+    job_index_stripe_t *stripe = stripe_of(index, job_id);
+
+    pthread_rwlock_rdlock(&stripe->lock);
+    job_index_entry_t *entry = int_map_get(&stripe->entries, job_id);
+    if (entry) *out = *entry;
+    pthread_rwlock_unlock(&stripe->lock);
+
+    return entry ? 0 : -1;
+}
+
+typedef struct {
+    const job_index_filter_t *filter;
+    job_index_entry_t *out;
+    int max;
+    int count;
+} list_ctx_t;
+
+// Mantém em out os `max` menores ids que passam no filtro (inserção ordenada)
+static void collect(int key, void *value, void *arg) {
+    (void)key;
+    list_ctx_t *ctx = (list_ctx_t*)arg;
+    const job_index_entry_t *entry = (const job_index_entry_t*)value;
+    const job_index_filter_t *filter = ctx->filter;
+
+    if (entry->job_id <= filter->after) return;
+    if (filter->status >= 0 && (int)entry->status != filter->status) return;
+    if (filter->client[0] && strcmp(entry->client, filter->client) != 0) return;
+    if (ctx->count == ctx->max && entry->job_id > ctx->out[ctx->count - 1].job_id) return;
+
+    int i = ctx->count < ctx->max ? ctx->count++ : ctx->count - 1;
+    while (i > 0 && ctx->out[i - 1].job_id > entry->job_id) {
+        ctx->out[i] = ctx->out[i - 1];
+        i--;
+    }
+    ctx->out[i] = *entry;
+}
+
+// Percorre o índice inteiro, uma faixa por vez: é para listagens
+// administrativas, não para o caminho quente da consulta por id
+int job_index_list(job_index_t *index, const job_index_filter_t *filter,
+                   job_index_entry_t *out, int max) {
+    if (!index || !filter || !out || max <= 0) return 0;
+
+    list_ctx_t ctx = {filter, out, max, 0};
+    for (int i = 0; i < JOB_INDEX_STRIPES; i++) {
+        pthread_rwlock_rdlock(&index->stripes[i].lock);
+        int_map_foreach(&index->stripes[i].entries, collect, &ctx);
+        pthread_rwlock_unlock(&index->stripes[i].lock);
+    }
+    return ctx.count;
+}
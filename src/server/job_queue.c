@@ -1,26 +1,81 @@
 #include "../common/protocol.h"
 #include "job_queue.h"
+#include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <errno.h>
+#include <time.h>
 #include "database.h"
+#include "shard_ring.h"
 
+#define DEFAULT_CLIENT "anonimo"
+
+// Peso configurado de um cliente, valendo para todas as faixas dele
+typedef struct {
+    char client[JOB_CLIENT_MAX];
+    int weight;
+} client_weight_t;
+
+static double monotonic_seconds(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (double)now.tv_sec + now.tv_nsec / 1e9;
+}
 
 int job_queue_init(job_queue_t *queue, tslog_t *logger) {
     if (!queue || !logger) return -1;
     
-    queue->head = NULL;
-    queue->tail = NULL;
+    queue->lanes = NULL;
+    queue->lane_cursor = NULL;
+    queue->caps = NULL;
+    queue->wakeups = 0;
     queue->size = 0;
     queue->next_job_id = 1;
+    queue->id_shard = -1;
+    queue->aging = JOB_QUEUE_DEFAULT_AGING;
+    queue->mode = JOB_QUEUE_FAIR;
+    queue->high_watermark = 0;
+    queue->low_watermark = 0;
+    queue->high_bytes = 0;
+    queue->low_bytes = 0;
+    queue->overloaded = 0;
+    queue->admitted = 0;
+    queue->rejected = 0;
+    queue->drain_interval = 0.0;
+    queue->last_pop = 0.0;
+    queue->history = NULL;
+    queue->on_expire = NULL;
+    queue->expire_arg = NULL;
+    queue->on_enqueue = NULL;
+    queue->enqueue_arg = NULL;
+    queue->on_dequeue = NULL;
+    queue->dequeue_arg = NULL;
+    queue->next_seq = 0;
     queue->logger = logger;
+    queue->stats = NULL;
+    queue->index = NULL;
+    
+    if (int_map_init(&queue->flows, 64) != 0 || int_map_init(&queue->weights, 16) != 0 ||
+        int_map_init(&queue->nodes, 1024) != 0) {
+        int_map_destroy(&queue->flows);
+        int_map_destroy(&queue->weights);
+        tslog_error(logger, "Falha ao alocar tabela de clientes da fila");
+        return -1;
+    }
     
     if (pthread_mutex_init(&queue->mutex, NULL) != 0) {
+        int_map_destroy(&queue->flows);
+        int_map_destroy(&queue->weights);
+        int_map_destroy(&queue->nodes);
         tslog_error(logger, "Falha ao inicializar mutex da fila");
         return -1;
     }
     
     if (pthread_cond_init(&queue->not_empty, NULL) != 0) {
         pthread_mutex_destroy(&queue->mutex);
+        int_map_destroy(&queue->flows);
+        int_map_destroy(&queue->weights);
+        int_map_destroy(&queue->nodes);
         tslog_error(logger, "Falha ao inicializar condition variable");
         return -1;
     }
@@ -29,18 +84,43 @@ int job_queue_init(job_queue_t *queue, tslog_t *logger) {
     return 0;
 }
 
+static void free_flow(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    job_flow_t *flow = (job_flow_t*)value;
+    for (int i = 0; i < flow->size; i++) {
+        free(flow->heap[i]);
+    }
+    free(flow->heap);
+    free(flow);
+}
+
+static void free_weight(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    free(value);
+}
+
 void job_queue_destroy(job_queue_t *queue) {
     if (!queue) return;
     
     pthread_mutex_lock(&queue->mutex);
     
     // Liberar todos os nós
-    job_node_t *current = queue->head;
-    while (current != NULL) {
-        job_node_t *next = current->next;
-        free(current);
-        current = next;
+    int_map_foreach(&queue->flows, free_flow, NULL);
+    int_map_destroy(&queue->flows);
+    int_map_foreach(&queue->weights, free_weight, NULL);
+    int_map_destroy(&queue->weights);
+    int_map_destroy(&queue->nodes);
+    while (queue->lanes) {
+        job_lane_t *next = queue->lanes->next;
+        for (int i = 0; i < queue->lanes->edf_size; i++) {
+            free(queue->lanes->edf[i]);
+        }
+        free(queue->lanes->edf);
+        free(queue->lanes);
+        queue->lanes = next;
     }
+    queue->lane_cursor = NULL;
+    queue->size = 0;
     
     pthread_mutex_unlock(&queue->mutex);
     pthread_mutex_destroy(&queue->mutex);
@@ -49,73 +129,420 @@ void job_queue_destroy(job_queue_t *queue) {
     tslog_info(queue->logger, "Fila de jobs destruída");
 }
 
-int job_queue_push(job_queue_t *queue, const job_t *job) {
-    if (!queue || !job) return -1;
+/* ---- Heaps (por cliente e EDF por faixa) ---- */
+
+// a sai antes de b: maior chave; entre iguais, quem chegou primeiro.
+// No heap EDF a chave é o prazo com sinal trocado.
+static int node_before(const job_node_t *a, const job_node_t *b) {
+    return a->key > b->key || (a->key == b->key && a->seq < b->seq);
+}
+
+// Os sifts mantêm heap_index de cada nó que movem
+static void sift_up(job_node_t **heap, int i) {
+    job_node_t *node = heap[i];
+    while (i > 0) {
+        int parent = (i - 1) / 2;
+        if (!node_before(node, heap[parent])) break;
+        heap[i] = heap[parent];
+        heap[i]->heap_index = i;
+        i = parent;
+    }
+    heap[i] = node;
+    node->heap_index = i;
+}
+
+static void sift_down(job_node_t **heap, int size, int i) {
+    job_node_t *node = heap[i];
+    while (1) {
+        int child = 2 * i + 1;
+        if (child >= size) break;
+        if (child + 1 < size && node_before(heap[child + 1], heap[child])) {
+            child++;
+        }
+        if (!node_before(heap[child], node)) break;
+        heap[i] = heap[child];
+        heap[i]->heap_index = i;
+        i = child;
+    }
+    heap[i] = node;
+    node->heap_index = i;
+}
+
+// Tira o nó de qualquer posição: o último ocupa o lugar e sobe ou desce
+static void heap_delete(job_node_t **heap, int *size, int i) {
+    job_node_t *last = heap[--*size];
+    if (i == *size) return;
+    heap[i] = last;
+    last->heap_index = i;
+    sift_up(heap, i);
+    sift_down(heap, *size, last->heap_index);
+}
+
+// Garante espaço para mais um nó no vetor do heap
+static int heap_reserve(job_node_t ***heap, int size, int *capacity) {
+    if (size < *capacity) return 0;
+    int grown_capacity = *capacity ? *capacity * 2 : 16;
+    job_node_t **grown = realloc(*heap, (size_t)grown_capacity * sizeof(job_node_t*));
+    if (!grown) return -1;
+    *heap = grown;
+    *capacity = grown_capacity;
+    return 0;
+}
+
+// Prioridade efetiva "congelada": ver o comentário em job_queue.h
+static long node_key(const job_queue_t *queue, const job_t *job) {
+    if (queue->aging <= 0) return job->priority;
+    return (long)job->priority * queue->aging - (long)job->submitted_at;
+}
+
+/* ---- Faixas por conjunto de capacidades ---- */
+
+// Busca (ou cria) a faixa do conjunto. Chamar com o mutex travado.
+static job_lane_t *get_lane(job_queue_t *queue, cap_mask_t needs) {
+    job_lane_t *lane;
+    for (lane = queue->lanes; lane; lane = lane->next) {
+        if (lane->needs == needs) return lane;
+    }
     
-    job_node_t *new_node = malloc(sizeof(job_node_t));
-    if (!new_node) {
-        tslog_error(queue->logger, "Falha ao alocar memória para novo job");
-        return -1;
+    lane = calloc(1, sizeof(job_lane_t));
+    if (!lane) return NULL;
+    lane->needs = needs;
+    lane->next = queue->lanes;
+    queue->lanes = lane;
+    return lane;
+}
+
+static int lane_offered(const job_lane_t *lane, const cap_mask_t *offers, int offer_count) {
+    if (!offers) return 1;
+    for (int i = 0; i < offer_count; i++) {
+        if (capability_satisfies(offers[i], lane->needs)) return 1;
+    }
+    return 0;
+}
+
+// Próxima faixa com jobs que alguém pode atender, revezando a partir da
+// última atendida. Chamar com o mutex travado.
+static job_lane_t *next_lane(job_queue_t *queue, const cap_mask_t *offers, int offer_count) {
+    if (queue->size == 0) return NULL;
+    
+    // Modo EDF: a faixa compatível cujo próximo prazo vence primeiro
+    if (queue->mode == JOB_QUEUE_EDF) {
+        job_lane_t *best = NULL;
+        for (job_lane_t *lane = queue->lanes; lane; lane = lane->next) {
+            if (lane->edf_size > 0 && lane_offered(lane, offers, offer_count) &&
+                (!best || node_before(lane->edf[0], best->edf[0]))) {
+                best = lane;
+            }
+        }
+        if (best) return best;
+    }
+    
+    job_lane_t *start = queue->lane_cursor && queue->lane_cursor->next
+                        ? queue->lane_cursor->next : queue->lanes;
+    job_lane_t *lane = start;
+    do {
+        if (lane->size > 0 && lane_offered(lane, offers, offer_count)) {
+            queue->lane_cursor = lane;
+            return lane;
+        }
+        lane = lane->next ? lane->next : queue->lanes;
+    } while (lane != start);
+    return NULL;
+}
+
+/* ---- Rodízio entre clientes (deficit round-robin) ---- */
+
+static int client_weight(job_queue_t *queue, const char *client) {
+    int key = int_map_string_key(client);
+    client_weight_t *entry;
+    while ((entry = int_map_get(&queue->weights, key)) != NULL) {
+        if (strcmp(entry->client, client) == 0) return entry->weight;
+        key = (key + 1) & 0x7fffffff;
     }
+    return JOB_QUEUE_DEFAULT_WEIGHT;
+}
+
+// Busca (ou cria) o fluxo do cliente na faixa. Chamar com o mutex travado.
+static job_flow_t *get_flow(job_queue_t *queue, const char *client, job_lane_t *lane) {
+    if (!client || !client[0]) client = DEFAULT_CLIENT;
     
-    // Copiar job e atribuir ID
-    new_node->job = *job;
-    new_node->job.job_id = queue->next_job_id++;
-    new_node->job.status = JOB_PENDING;
-    new_node->next = NULL;
+    // Colisão de hash entre pares diferentes: sonda a próxima chave
+    unsigned mix = (unsigned)((lane->needs * 0x9E3779B97F4A7C15ULL) >> 33);
+    int key = (int)(((unsigned)int_map_string_key(client) ^ mix) & 0x7fffffff);
+    job_flow_t *flow;
+    while ((flow = int_map_get(&queue->flows, key)) != NULL) {
+        if (flow->lane == lane && strcmp(flow->client, client) == 0) return flow;
+        key = (key + 1) & 0x7fffffff;
+    }
     
-    pthread_mutex_lock(&queue->mutex);
+    flow = calloc(1, sizeof(job_flow_t));
+    if (!flow) return NULL;
+    snprintf(flow->client, sizeof(flow->client), "%s", client);
+    flow->lane = lane;
+    flow->map_key = key;
+    flow->weight = client_weight(queue, client);
     
-    if (queue->tail == NULL) {
-        // Fila vazia
-        queue->head = new_node;
-        queue->tail = new_node;
+    if (int_map_put(&queue->flows, key, flow) != 0) {
+        free(flow);
+        return NULL;
+    }
+    return flow;
+}
+
+// Cliente que passa a ter jobs entra no fim da rodada (logo antes do cursor)
+static void ring_insert(job_lane_t *lane, job_flow_t *flow) {
+    flow->deficit = 0;
+    if (!lane->active) {
+        flow->prev = flow;
+        flow->next = flow;
+        lane->active = flow;
+        return;
+    }
+    job_flow_t *cursor = lane->active;
+    flow->prev = cursor->prev;
+    flow->next = cursor;
+    cursor->prev->next = flow;
+    cursor->prev = flow;
+}
+
+static void ring_remove(job_lane_t *lane, job_flow_t *flow) {
+    if (flow->next == flow) {
+        lane->active = NULL;
     } else {
-        // Adicionar ao final
-        queue->tail->next = new_node;
-        queue->tail = new_node;
+        flow->prev->next = flow->next;
+        flow->next->prev = flow->prev;
+        if (lane->active == flow) lane->active = flow->next;
+    }
+    flow->prev = NULL;
+    flow->next = NULL;
+    flow->deficit = 0;
+}
+
+// Coloca o nó no heap do cliente. Chamar com o mutex travado.
+static int enqueue_locked(job_queue_t *queue, job_node_t *node) {
+    cap_mask_t needs = 0;
+    if (queue->caps && node->job.needs[0] &&
+        capability_intern(queue->caps, node->job.needs, &needs) != 0) {
+        return -1;
+    }
+    job_lane_t *lane = get_lane(queue, needs);
+    if (!lane) return -1;
+    
+    node->seq = queue->next_seq++;
+    node->enqueued_at = monotonic_seconds();
+    node->lane = lane;
+    node->flow = NULL;
+    
+    if (queue->mode == JOB_QUEUE_EDF && node->job.deadline) {
+        if (heap_reserve(&lane->edf, lane->edf_size, &lane->edf_capacity) != 0 ||
+            int_map_put(&queue->nodes, node->job.job_id, node) != 0) {
+            return -1;
+        }
+        node->key = -(long)node->job.deadline;
+        lane->edf[lane->edf_size++] = node;
+        sift_up(lane->edf, lane->edf_size - 1);
+        lane->size++;
+        queue->size++;
+        return 0;
     }
     
+    job_flow_t *flow = get_flow(queue, node->job.client, lane);
+    if (!flow || heap_reserve(&flow->heap, flow->size, &flow->capacity) != 0 ||
+        int_map_put(&queue->nodes, node->job.job_id, node) != 0) {
+        return -1;
+    }
+    
+    node->flow = flow;
+    node->key = node_key(queue, &node->job);
+    flow->heap[flow->size++] = node;
+    sift_up(flow->heap, flow->size - 1);
+    flow->enqueued++;
+    if (flow->size == 1) {
+        ring_insert(lane, flow);
+    }
+    
+    lane->size++;
     queue->size++;
+    return 0;
+}
+
+// Próximo nó da faixa pela política. Chamar com o mutex travado e a faixa não vazia.
+static job_node_t *take_next(job_queue_t *queue, job_lane_t *lane) {
+    lane->size--;
+    queue->size--;
     
-    tslog_info(queue->logger, "Job %d adicionado à fila (script: %s)", 
-               new_node->job.job_id, new_node->job.script);
+    // Ritmo de drenagem para o retry-after; pausas longas (fila vazia) são limitadas
+    double now = monotonic_seconds();
+    if (queue->last_pop > 0) {
+        double interval = now - queue->last_pop;
+        if (interval > 1.0) interval = 1.0;
+        queue->drain_interval = queue->drain_interval > 0
+            ? 0.2 * interval + 0.8 * queue->drain_interval : interval;
+    }
+    queue->last_pop = now;
     
-    // Sinalizar que a fila não está mais vazia
-    pthread_cond_signal(&queue->not_empty);
-    pthread_mutex_unlock(&queue->mutex);
+    if (lane->edf_size > 0) {
+        job_node_t *node = lane->edf[0];
+        heap_delete(lane->edf, &lane->edf_size, 0);
+        int_map_remove(&queue->nodes, node->job.job_id);
+        return node;
+    }
+    
+    job_flow_t *flow = lane->active;
+    
+    // Vez nova do cliente: ganha `weight` jobs de crédito
+    if (flow->deficit <= 0) {
+        flow->deficit += flow->weight;
+    }
+    
+    job_node_t *node = flow->heap[0];
+    heap_delete(flow->heap, &flow->size, 0);
+    int_map_remove(&queue->nodes, node->job.job_id);
+    flow->deficit--;
+    
+    double wait = now - node->enqueued_at;
+    flow->dequeued++;
+    flow->wait_total += wait;
+    if (wait > flow->wait_max) flow->wait_max = wait;
     
-    return new_node->job.job_id;
+    if (flow->size == 0) {
+        ring_remove(lane, flow);
+    } else if (flow->deficit <= 0) {
+        lane->active = flow->next;
+    }
+    return node;
 }
 
-int job_queue_pop(job_queue_t *queue, job_t *job) {
+// O job ainda cabe no prazo? Sem histórico do script, só o prazo vencido conta.
+static int deadline_feasible(job_queue_t *queue, const job_t *job, double *estimate) {
+    *estimate = queue->history ? runtime_history_estimate(queue->history, job->script) : -1;
+    if (!job->deadline) return 1;
+    double needed = *estimate > 0 ? *estimate : 0;
+    return difftime(job->deadline, time(NULL)) >= needed;
+}
+
+typedef struct {
+    int job_id;
+    int attempts;
+    double estimate;
+    char needs[JOB_NEEDS_MAX];
+} expired_job_t;
+
+// Descartes por prazo: banco, estatísticas e gancho, já sem o mutex da fila
+static void finish_expired(job_queue_t *queue, const expired_job_t *expired, int count) {
+    for (int i = 0; i < count; i++) {
+        char reason[128];
+        if (expired[i].estimate > 0) {
+            snprintf(reason, sizeof(reason), "prazo perdido na fila (duração estimada %.1fs)",
+                     expired[i].estimate);
+        } else {
+            snprintf(reason, sizeof(reason), "prazo vencido na fila");
+        }
+        tslog_warn(queue->logger, "Job %d descartado: %s", expired[i].job_id, reason);
+        database_update_job_status(expired[i].job_id, JOB_EXPIRED, expired[i].attempts, reason);
+        job_index_update(queue->index, expired[i].job_id, JOB_EXPIRED, 0, expired[i].attempts);
+        job_stats_record_deadline(queue->stats, DEADLINE_EXPIRED);
+        if (queue->on_expire) {
+            queue->on_expire(expired[i].job_id, expired[i].needs, queue->expire_arg);
+        }
+    }
+}
+
+static job_node_t *new_node(job_queue_t *queue, const job_t *job) {
+    job_node_t *node = malloc(sizeof(job_node_t));
+    if (!node) {
+        tslog_error(queue->logger, "Falha ao alocar memória para novo job");
+        return NULL;
+    }
+    node->job = *job;
+    node->job.status = JOB_PENDING;
+    return node;
+}
+
+// Próximo id livre; com shard os ids pulam de SHARD_MAX em SHARD_MAX.
+// Chamar com o mutex.
+static int take_id_locked(job_queue_t *queue) {
+    int job_id = queue->next_job_id;
+    queue->next_job_id = shard_align_id(job_id + 1, queue->id_shard);
+    return job_id;
+}
+
+// Novo job: recebe id (se ainda não reservado) e horário de submissão.
+// Retorna o id ou -1.
+static int submit(job_queue_t *queue, const job_t *job, int persist, int reserved) {
     if (!queue || !job) return -1;
     
+    job_node_t *node = new_node(queue, job);
+    if (!node) return -1;
+    node->job.submitted_at = time(NULL);
+    
     pthread_mutex_lock(&queue->mutex);
     
-    // Aguardar até que haja jobs na fila
-    while (queue->head == NULL) {
-        tslog_debug(queue->logger, "Fila vazia - aguardando jobs...");
-        pthread_cond_wait(&queue->not_empty, &queue->mutex);
+    if (!reserved) {
+        node->job.job_id = take_id_locked(queue);
     }
-    
-    // Remover do início
-    job_node_t *node = queue->head;
-    *job = node->job;
-    job->status = JOB_RUNNING;
-    
-    queue->head = node->next;
-    if (queue->head == NULL) {
-        queue->tail = NULL;
+    if (enqueue_locked(queue, node) != 0) {
+        pthread_mutex_unlock(&queue->mutex);
+        tslog_error(queue->logger, "Falha ao enfileirar job do cliente %s", job->client);
+        free(node);
+        return -1;
+    }
+    // Ainda com o mutex: um pop logo depois não pode ser sobrescrito por PENDING
+    job_index_track(queue->index, &node->job, JOB_PENDING);
+    if (queue->on_enqueue) {
+        queue->on_enqueue(&node->job, queue->enqueue_arg);
     }
     
-    queue->size--;
-    free(node);
+    tslog_info_limited(queue->logger, "queue", "Job %d adicionado (pri: %d, timeout: %d, cliente: %s)", 
+                       node->job.job_id, node->job.priority, node->job.timeout,
+                       node->job.client[0] ? node->job.client : DEFAULT_CLIENT);
     
-    tslog_info(queue->logger, "Job %d removido da fila para execução", job->job_id);
-    pthread_mutex_unlock(&queue->mutex);
+    // Copiar antes de liberar o mutex: o nó pode ser consumido logo em seguida
+    job_t saved = node->job;
     
-    return 0;
+    // Broadcast: cada espera pode aceitar faixas diferentes
+    pthread_cond_broadcast(&queue->not_empty);
+    pthread_mutex_unlock(&queue->mutex);
+    if (persist) {
+        database_save_job(&saved);
+    }
+    job_stats_record_submit(queue->stats, saved.priority);
+
+    return saved.job_id;
+}
+
+int job_queue_push(job_queue_t *queue, const job_t *job) {
+    return submit(queue, job, 0, 0);
+}
+
+int job_queue_push_priority(job_queue_t *queue, const job_t *job) {
+    return submit(queue, job, 1, 0);
+}
+
+int job_queue_reserve_id(job_queue_t *queue) {
+    pthread_mutex_lock(&queue->mutex);
+    int job_id = take_id_locked(queue);
+    pthread_mutex_unlock(&queue->mutex);
+    return job_id;
+}
+
+void job_queue_set_next_id(job_queue_t *queue, int next_id) {
+    pthread_mutex_lock(&queue->mutex);
+    if (next_id > queue->next_job_id) {
+        queue->next_job_id = shard_align_id(next_id, queue->id_shard);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void job_queue_set_shard(job_queue_t *queue, int shard) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->id_shard = shard;
+    queue->next_job_id = shard_align_id(queue->next_job_id, shard);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+int job_queue_push_reserved(job_queue_t *queue, const job_t *job, int persist) {
+    return submit(queue, job, persist, 1);
 }
 
 int job_queue_size(job_queue_t *queue) {
@@ -128,151 +555,502 @@ int job_queue_size(job_queue_t *queue) {
     return size;
 }
 
-int job_queue_push_priority(job_queue_t *queue, const job_t *job) {
+// Devolve à fila um job já removido, mantendo id e horário de submissão
+// (a espera anterior continua contando para o envelhecimento)
+int job_queue_requeue(job_queue_t *queue, const job_t *job) {
     if (!queue || !job) return -1;
     
-    job_node_t *new_node = malloc(sizeof(job_node_t));
-    if (!new_node) {
-        tslog_error(queue->logger, "Falha ao alocar memória para novo job");
+    job_node_t *node = new_node(queue, job);
+    if (!node) return -1;
+    node->job.assigned_worker = 0;
+    
+    pthread_mutex_lock(&queue->mutex);
+    int rc = enqueue_locked(queue, node);
+    if (rc == 0) {
+        job_index_update(queue->index, job->job_id, JOB_PENDING, 0, job->attempts);
+        pthread_cond_broadcast(&queue->not_empty);
+    }
+    pthread_mutex_unlock(&queue->mutex);
+    
+    if (rc != 0) {
+        tslog_error(queue->logger, "Falha ao devolver job %d à fila", job->job_id);
+        free(node);
         return -1;
     }
     
-    new_node->job = *job;
-    new_node->job.job_id = queue->next_job_id++;
-    new_node->job.status = JOB_PENDING;
-    new_node->job.submitted_at = time(NULL);
-    new_node->next = NULL;
+    job_stats_record_requeue(queue->stats);
+    tslog_info_limited(queue->logger, "queue", "Job %d devolvido à fila", job->job_id);
+    return 0;
+}
+
+int job_queue_remove(job_queue_t *queue, int job_id, job_t *job) {
+    if (!queue) return -1;
     
     pthread_mutex_lock(&queue->mutex);
+    job_node_t *node = int_map_remove(&queue->nodes, job_id);
+    if (node) {
+        job_lane_t *lane = node->lane;
+        job_flow_t *flow = node->flow;
+        if (flow) {
+            heap_delete(flow->heap, &flow->size, node->heap_index);
+            if (flow->size == 0) {
+                ring_remove(lane, flow);
+            }
+        } else {
+            heap_delete(lane->edf, &lane->edf_size, node->heap_index);
+        }
+        lane->size--;
+        queue->size--;
+    }
+    pthread_mutex_unlock(&queue->mutex);
     
-    // Inserção ordenada por prioridade (maior primeiro)
-    if (queue->head == NULL) {
-        // Fila vazia
-        queue->head = new_node;
-        queue->tail = new_node;
-    } else {
-        job_node_t *current = queue->head;
-        job_node_t *prev = NULL;
-        
-        // Encontrar posição baseada na prioridade (decrescente)
-        while (current != NULL && current->job.priority >= job->priority) {
-            prev = current;
-            current = current->next;
+    if (!node) return -1;
+    if (job) *job = node->job;
+    free(node);
+    tslog_info_limited(queue->logger, "queue", "Job %d retirado da fila", job_id);
+    return 0;
+}
+
+int job_queue_pop(job_queue_t *queue, job_t *job) {
+    return job_queue_pop_priority(queue, job);
+}
+
+// Espera comum dos pops: timeout_ms < 0 espera indefinidamente. Retorna 1 se
+// nada serviu no prazo ou se job_queue_wake foi chamada durante a espera.
+static int pop_wait(job_queue_t *queue, job_t *job, const cap_mask_t *offers, int offer_count,
+                    int timeout_ms) {
+    if (!queue || !job) return -1;
+    
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    if (timeout_ms >= 0) {
+        deadline.tv_sec += timeout_ms / 1000;
+        deadline.tv_nsec += (long)(timeout_ms % 1000) * 1000000L;
+        if (deadline.tv_nsec >= 1000000000L) {
+            deadline.tv_sec++;
+            deadline.tv_nsec -= 1000000000L;
         }
-        
-        if (prev == NULL) {
-            // Inserir no início (maior prioridade)
-            new_node->next = queue->head;
-            queue->head = new_node;
-        } else {
-            // Inserir no meio/fim
-            new_node->next = prev->next;
-            prev->next = new_node;
-            
-            if (prev == queue->tail) {
-                queue->tail = new_node;
+    }
+    
+    pthread_mutex_lock(&queue->mutex);
+    
+    unsigned long wakeups = queue->wakeups;
+    expired_job_t expired[JOB_QUEUE_EXPIRE_BATCH];
+    int expired_count = 0;
+    job_node_t *node = NULL;
+    
+    while (!node && expired_count < JOB_QUEUE_EXPIRE_BATCH) {
+        job_lane_t *lane = next_lane(queue, offers, offer_count);
+        if (!lane) {
+            if (queue->wakeups != wakeups || expired_count > 0) break;
+            if (timeout_ms < 0) {
+                tslog_debug(queue->logger, "Fila vazia - aguardando jobs...");
+                pthread_cond_wait(&queue->not_empty, &queue->mutex);
+            } else if (pthread_cond_timedwait(&queue->not_empty, &queue->mutex, &deadline) == ETIMEDOUT) {
+                break;
             }
+            continue;
+        }
+        
+        node = take_next(queue, lane);
+        double estimate;
+        if (!deadline_feasible(queue, &node->job, &estimate)) {
+            expired[expired_count].job_id = node->job.job_id;
+            expired[expired_count].attempts = node->job.attempts;
+            expired[expired_count].estimate = estimate;
+            memcpy(expired[expired_count].needs, node->job.needs, sizeof(node->job.needs));
+            expired_count++;
+            free(node);
+            node = NULL;
         }
     }
     
-    queue->size++;
+    if (node) {
+        job_t assigned = *job;
+        *job = node->job;
+        job->assigned_worker = assigned.assigned_worker;
+        job->status = JOB_RUNNING;
+        job->started_at = time(NULL);
+        free(node);
+        job_index_update(queue->index, job->job_id, JOB_RUNNING, job->assigned_worker, job->attempts);
+        if (queue->on_dequeue) {
+            queue->on_dequeue(job, queue->dequeue_arg);
+        }
+        
+        tslog_info_limited(queue->logger, "queue", "Job %d removido para execução (pri: %d)", 
+                           job->job_id, job->priority);
+    }
     
-    tslog_info(queue->logger, "Job %d adicionado (pri: %d, timeout: %d)", 
-               new_node->job.job_id, new_node->job.priority, new_node->job.timeout);
+    pthread_mutex_unlock(&queue->mutex);
+    finish_expired(queue, expired, expired_count);
     
-    pthread_cond_signal(&queue->not_empty);
+    if (!node) return 1;
+    job_stats_record_start(queue->stats, job->priority, job->assigned_worker);
+    return 0;
+}
+
+int job_queue_pop_priority(job_queue_t *queue, job_t *job) {
+    int rc;
+    while ((rc = pop_wait(queue, job, NULL, 0, -1)) == 1) {
+        // acordado por job_queue_wake: continua esperando
+    }
+    return rc;
+}
+
+int job_queue_pop_timed(job_queue_t *queue, job_t *job, int timeout_ms) {
+    return pop_wait(queue, job, NULL, 0, timeout_ms);
+}
+
+int job_queue_pop_for(job_queue_t *queue, job_t *job, const cap_mask_t *offers, int offer_count,
+                      int timeout_ms) {
+    if (!offers || offer_count <= 0) return 1;
+    return pop_wait(queue, job, offers, offer_count, timeout_ms);
+}
+
+void job_queue_wake(job_queue_t *queue) {
+    pthread_mutex_lock(&queue->mutex);
+    queue->wakeups++;
+    pthread_cond_broadcast(&queue->not_empty);
     pthread_mutex_unlock(&queue->mutex);
-    database_save_job(&new_node->job);
+}
+
+/* ---- Política ---- */
 
-    return new_node->job.job_id;
+static void rekey_flow(int key, void *value, void *arg) {
+    (void)key;
+    job_queue_t *queue = (job_queue_t*)arg;
+    job_flow_t *flow = (job_flow_t*)value;
+    
+    for (int i = 0; i < flow->size; i++) {
+        flow->heap[i]->key = node_key(queue, &flow->heap[i]->job);
+    }
+    for (int i = flow->size / 2 - 1; i >= 0; i--) {
+        sift_down(flow->heap, flow->size, i);
+    }
 }
 
-// NOVA FUNÇÃO: Obter próximo job considerando prioridades
-int job_queue_pop_priority(job_queue_t *queue, job_t *job) {
-    if (!queue || !job) return -1;
+// Marcas de admissão; sem marca baixa (ou baixa acima da alta) vale JOB_QUEUE_LOW_PERCENT da alta
+void job_queue_set_watermarks(job_queue_t *queue, int high, int low, size_t high_bytes, size_t low_bytes) {
+    if (!queue || high < 0 || low < 0) return;
+    if (low == 0 || low > high) low = (int)((long)high * JOB_QUEUE_LOW_PERCENT / 100);
+    if (low_bytes == 0 || low_bytes > high_bytes) low_bytes = high_bytes / 100 * JOB_QUEUE_LOW_PERCENT;
     
     pthread_mutex_lock(&queue->mutex);
+    queue->high_watermark = high;
+    queue->low_watermark = low;
+    queue->high_bytes = high_bytes;
+    queue->low_bytes = low_bytes;
+    pthread_mutex_unlock(&queue->mutex);
+    
+    tslog_info(queue->logger, "Admissão: marcas de %d/%d jobs e %zu/%zu KB (0 = sem limite)",
+               high, low, high_bytes / 1024, low_bytes / 1024);
+}
+
+// Chamar com o mutex travado
+static size_t pending_bytes(const job_queue_t *queue) {
+    return (size_t)queue->size * sizeof(job_node_t);
+}
+
+int job_queue_admit(job_queue_t *queue, int *retry_after_ms) {
+    if (!queue) return 0;
     
-    // Aguardar até que haja jobs na fila
-    while (queue->head == NULL) {
-        tslog_debug(queue->logger, "Fila vazia - aguardando jobs...");
-        pthread_cond_wait(&queue->not_empty, &queue->mutex);
+    pthread_mutex_lock(&queue->mutex);
+    size_t bytes = pending_bytes(queue);
+    int above_high = (queue->high_watermark && queue->size >= queue->high_watermark) ||
+                     (queue->high_bytes && bytes >= queue->high_bytes);
+    int below_low = (!queue->high_watermark || queue->size <= queue->low_watermark) &&
+                    (!queue->high_bytes || bytes <= queue->low_bytes);
+    int changed = 0;
+    if (!queue->overloaded && above_high) {
+        queue->overloaded = changed = 1;
+    } else if (queue->overloaded && below_low) {
+        queue->overloaded = 0;
+        changed = 1;
     }
     
-    // Sempre pega o primeiro (já está ordenado por prioridade)
-    job_node_t *node = queue->head;
-    *job = node->job;
-    job->status = JOB_RUNNING;
-    job->started_at = time(NULL);
+    int overloaded = queue->overloaded;
+    int size = queue->size;
+    if (overloaded) {
+        // Tempo para drenar até a marca baixa no ritmo recente
+        int excess = queue->size - queue->low_watermark;
+        if (excess < 1) excess = 1;
+        double interval = queue->drain_interval > 0 ? queue->drain_interval : 1.0;
+        long retry = (long)(excess * interval * 1000);
+        if (retry < JOB_QUEUE_RETRY_MIN_MS) retry = JOB_QUEUE_RETRY_MIN_MS;
+        if (retry > JOB_QUEUE_RETRY_MAX_MS) retry = JOB_QUEUE_RETRY_MAX_MS;
+        if (retry_after_ms) *retry_after_ms = (int)retry;
+        queue->rejected++;
+    } else {
+        queue->admitted++;
+    }
+    pthread_mutex_unlock(&queue->mutex);
     
-    queue->head = node->next;
-    if (queue->head == NULL) {
-        queue->tail = NULL;
+    if (changed) {
+        tslog_warn(queue->logger, overloaded ? "Fila sobrecarregada (%d jobs) - recusando submissões"
+                                             : "Fila abaixo da marca baixa (%d jobs) - aceitando submissões",
+                   size);
     }
+    return overloaded;
+}
+
+size_t job_queue_bytes(job_queue_t *queue) {
+    pthread_mutex_lock(&queue->mutex);
+    size_t bytes = pending_bytes(queue);
+    pthread_mutex_unlock(&queue->mutex);
+    return bytes;
+}
+
+int job_queue_admit_deadline(job_queue_t *queue, const job_t *job, double *estimate) {
+    *estimate = -1;
+    if (!job->deadline) return 0;
     
-    queue->size--;
-    free(node);
+    pthread_mutex_lock(&queue->mutex);
+    runtime_history_t *history = queue->history;
+    pthread_mutex_unlock(&queue->mutex);
     
-    tslog_info(queue->logger, "Job %d removido para execução (pri: %d)", 
-               job->job_id, job->priority);
+    if (history) *estimate = runtime_history_estimate(history, job->script);
+    time_t now = time(NULL);
+    return job->deadline <= now || (*estimate > 0 && difftime(job->deadline, now) < *estimate);
+}
+
+// Muda o envelhecimento: as chaves dos jobs pendentes são recalculadas (O(n))
+void job_queue_set_aging(job_queue_t *queue, int seconds) {
+    if (!queue || seconds < 0) return;
     
+    pthread_mutex_lock(&queue->mutex);
+    queue->aging = seconds;
+    int_map_foreach(&queue->flows, rekey_flow, queue);
     pthread_mutex_unlock(&queue->mutex);
-    return 0;
+    
+    tslog_info(queue->logger, "Envelhecimento de prioridade: %ds por ponto%s",
+               seconds, seconds ? "" : " (desligado)");
 }
 
-// NOVA FUNÇÃO: Verificar timeouts
-void job_queue_check_timeouts(job_queue_t *queue) {
-    if (!queue) return;
+static void apply_weight(int key, void *value, void *arg) {
+    (void)key;
+    job_flow_t *flow = (job_flow_t*)value;
+    const client_weight_t *entry = (const client_weight_t*)arg;
+    if (strcmp(flow->client, entry->client) == 0) {
+        flow->weight = entry->weight;
+    }
+}
+
+int job_queue_set_weight(job_queue_t *queue, const char *client, int weight) {
+    if (!queue || weight < 1 || weight > JOB_QUEUE_MAX_WEIGHT) return -1;
+    if (!client || !client[0]) client = DEFAULT_CLIENT;
     
     pthread_mutex_lock(&queue->mutex);
+    int key = int_map_string_key(client);
+    client_weight_t *entry;
+    while ((entry = int_map_get(&queue->weights, key)) != NULL && strcmp(entry->client, client) != 0) {
+        key = (key + 1) & 0x7fffffff;
+    }
+    if (!entry && (entry = calloc(1, sizeof(client_weight_t))) != NULL) {
+        snprintf(entry->client, sizeof(entry->client), "%s", client);
+        if (int_map_put(&queue->weights, key, entry) != 0) {
+            free(entry);
+            entry = NULL;
+        }
+    }
+    if (entry) {
+        entry->weight = weight;
+        int_map_foreach(&queue->flows, apply_weight, entry);
+    }
+    pthread_mutex_unlock(&queue->mutex);
     
-    time_t now = time(NULL);
-    job_node_t *current = queue->head;
-    int timeout_count = 0;
-    
-    while (current != NULL) {
-        if (current->job.status == JOB_RUNNING) {
-            time_t running_time = now - current->job.started_at;
-            if (running_time > current->job.timeout) {
-                tslog_warn(queue->logger, "Job %d excedeu timeout (%d > %d segundos)", 
-                          current->job.job_id, (int)running_time, current->job.timeout);
-                current->job.status = JOB_TIMEOUT;
-                timeout_count++;
-            }
+    if (!entry) return -1;
+    tslog_info(queue->logger, "Peso do cliente %s: %d", client, weight);
+    return 0;
+}
+
+typedef struct {
+    void (*callback)(const job_client_stats_t *stats, void *arg);
+    void *arg;
+    double now;
+    capability_registry_t *caps;
+} client_visit_t;
+
+static void fill_client_stats(const job_flow_t *flow, double now, capability_registry_t *caps,
+                              job_client_stats_t *out) {
+    memset(out, 0, sizeof(*out));
+    snprintf(out->client, sizeof(out->client), "%s", flow->client);
+    if (caps && flow->lane->needs) {
+        capability_format(caps, flow->lane->needs, out->needs, sizeof(out->needs));
+    }
+    out->weight = flow->weight;
+    out->depth = flow->size;
+    out->enqueued = flow->enqueued;
+    out->dequeued = flow->dequeued;
+    out->avg_wait = flow->dequeued ? flow->wait_total / flow->dequeued : 0.0;
+    out->max_wait = flow->wait_max;
+    out->head_wait = flow->size ? now - flow->heap[0]->enqueued_at : 0.0;
+}
+
+static void visit_client(int key, void *value, void *arg) {
+    (void)key;
+    client_visit_t *visit = (client_visit_t*)arg;
+    job_client_stats_t stats;
+    fill_client_stats((const job_flow_t*)value, visit->now, visit->caps, &stats);
+    visit->callback(&stats, visit->arg);
+}
+
+// O callback roda com o mutex da fila: não deve chamar a fila de volta
+void job_queue_foreach_client(job_queue_t *queue,
+                              void (*callback)(const job_client_stats_t *stats, void *arg), void *arg) {
+    if (!queue || !callback) return;
+    
+    client_visit_t visit = {callback, arg, monotonic_seconds(), queue->caps};
+    pthread_mutex_lock(&queue->mutex);
+    int_map_foreach(&queue->flows, visit_client, &visit);
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void job_queue_attach_stats(job_queue_t *queue, job_stats_t *stats) {
+    if (!queue) return;
+    queue->stats = stats;
+}
+
+void job_queue_attach_index(job_queue_t *queue, job_index_t *index) {
+    if (!queue) return;
+    pthread_mutex_lock(&queue->mutex);
+    queue->index = index;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+static const char *mode_names[] = {"fair", "edf"};
+
+const char* job_queue_mode_name(job_queue_mode_t mode) {
+    return (unsigned)mode < sizeof(mode_names) / sizeof(mode_names[0]) ? mode_names[mode] : "desconhecido";
+}
+
+int job_queue_mode_from_name(const char *name, job_queue_mode_t *mode) {
+    for (size_t i = 0; i < sizeof(mode_names) / sizeof(mode_names[0]); i++) {
+        if (strcmp(name, mode_names[i]) == 0) {
+            *mode = (job_queue_mode_t)i;
+            return 0;
         }
-        current = current->next;
     }
+    return -1;
+}
+
+int job_queue_set_mode(job_queue_t *queue, job_queue_mode_t mode) {
+    if (!queue) return -1;
     
-    if (timeout_count > 0) {
-        tslog_info(queue->logger, "%d jobs expirados por timeout", timeout_count);
+    pthread_mutex_lock(&queue->mutex);
+    int rc = queue->size == 0 ? 0 : -1;
+    if (rc == 0) {
+        queue->mode = mode;
     }
+    pthread_mutex_unlock(&queue->mutex);
     
+    if (rc == 0) {
+        tslog_info(queue->logger, "Modo da fila: %s", job_queue_mode_name(mode));
+    }
+    return rc;
+}
+
+void job_queue_attach_history(job_queue_t *queue, runtime_history_t *history) {
+    if (!queue) return;
+    pthread_mutex_lock(&queue->mutex);
+    queue->history = history;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void job_queue_set_expire_hook(job_queue_t *queue, void (*hook)(int job_id, const char *needs, void *arg),
+                               void *arg) {
+    if (!queue) return;
+    pthread_mutex_lock(&queue->mutex);
+    queue->on_expire = hook;
+    queue->expire_arg = arg;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void job_queue_set_enqueue_hook(job_queue_t *queue, void (*hook)(const job_t *job, void *arg), void *arg) {
+    if (!queue) return;
+    pthread_mutex_lock(&queue->mutex);
+    queue->on_enqueue = hook;
+    queue->enqueue_arg = arg;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void job_queue_set_dequeue_hook(job_queue_t *queue, void (*hook)(const job_t *job, void *arg), void *arg) {
+    if (!queue) return;
+    pthread_mutex_lock(&queue->mutex);
+    queue->on_dequeue = hook;
+    queue->dequeue_arg = arg;
+    pthread_mutex_unlock(&queue->mutex);
+}
+
+void job_queue_attach_capabilities(job_queue_t *queue, capability_registry_t *caps) {
+    if (!queue) return;
+    pthread_mutex_lock(&queue->mutex);
+    queue->caps = caps;
     pthread_mutex_unlock(&queue->mutex);
 }
 
 // NOVA FUNÇÃO: Estatísticas da fila
+// Lidas dos contadores incrementais: não percorre a lista nem trava o mutex.
 void job_queue_stats(job_queue_t *queue, int *total, int *pending, int *running, int *completed) {
     if (!queue) return;
     
-    pthread_mutex_lock(&queue->mutex);
-    
-    *total = queue->size;
-    *pending = 0;
-    *running = 0;
-    *completed = 0;
-    
-    job_node_t *current = queue->head;
-    while (current != NULL) {
-        switch (current->job.status) {
-            case JOB_PENDING: (*pending)++; break;
-            case JOB_RUNNING: (*running)++; break;
-            case JOB_COMPLETED: (*completed)++; break;
-            default: break;
-        }
-        current = current->next;
+    if (!queue->stats) {
+        *total = job_queue_size(queue);
+        *pending = *total;
+        *running = 0;
+        *completed = 0;
+        return;
     }
     
-    pthread_mutex_unlock(&queue->mutex);
+    job_stats_snapshot_t snap;
+    job_stats_get_total(queue->stats, &snap);
+    
+    *pending = (int)job_stats_pending(queue->stats);
+    *running = (int)job_stats_running(queue->stats);
+    *completed = (int)snap.completed;
+    *total = (int)snap.submitted;
+}
+
+void job_queue_get_stats(job_queue_t *queue, int *total, int *pending, int *running, int *completed) {
+    job_queue_stats(queue, total, pending, running, completed);
+}
+
+typedef struct {
+    tslog_t *logger;
+    capability_registry_t *caps;
+    double now;
+    time_t wall_now;
+    int aging;
+    int count;
+} list_ctx_t;
+
+static void list_flow(int key, void *value, void *arg) {
+    (void)key;
+    list_ctx_t *ctx = (list_ctx_t*)arg;
+    const job_flow_t *flow = (const job_flow_t*)value;
+    if (flow->size == 0) return;
+    
+    job_client_stats_t stats;
+    fill_client_stats(flow, ctx->now, ctx->caps, &stats);
+    tslog_info(ctx->logger, "Cliente %s%s%s%s (peso %d): %d pendentes, espera média %.2fs, máxima %.2fs",
+               stats.client, stats.needs[0] ? " [" : "", stats.needs, stats.needs[0] ? "]" : "",
+               stats.weight, stats.depth, stats.avg_wait, stats.max_wait);
+    
+    // Ordem do heap, não de execução
+    for (int i = 0; i < flow->size; i++) {
+        const job_node_t *node = flow->heap[i];
+        double wait = difftime(ctx->wall_now, node->job.submitted_at);
+        double effective = node->job.priority + (ctx->aging ? wait / ctx->aging : 0.0);
+        
+        char time_buf[64];
+        struct tm timeinfo;
+        localtime_r(&node->job.submitted_at, &timeinfo);
+        strftime(time_buf, sizeof(time_buf), "%H:%M:%S", &timeinfo);
+        
+        tslog_info(ctx->logger, "#%d: [%s] %s (pri: %d, efetiva: %.1f, timeout: %ds) - PENDENTE",
+                   node->job.job_id, time_buf, node->job.script,
+                   node->job.priority, effective, node->job.timeout);
+        ctx->count++;
+    }
 }
 
 void job_queue_list(job_queue_t *queue) {
@@ -282,35 +1060,22 @@ void job_queue_list(job_queue_t *queue) {
     
     tslog_info(queue->logger, "=== FILA DE JOBS (%d jobs) ===", queue->size);
     
-    job_node_t *current = queue->head;
-    int count = 0;
-    
-    while (current != NULL) {
-        const char *status_str;
-        switch (current->job.status) {
-            case JOB_PENDING: status_str = "PENDENTE"; break;
-            case JOB_RUNNING: status_str = "EXECUTANDO"; break;
-            case JOB_COMPLETED: status_str = "CONCLUÍDO"; break;
-            case JOB_FAILED: status_str = "FALHOU"; break;
-            case JOB_TIMEOUT: status_str = "TIMEOUT"; break;
-            default: status_str = "DESCONHECIDO";
+    list_ctx_t ctx = {queue->logger, queue->caps, monotonic_seconds(), time(NULL), queue->aging, 0};
+    int_map_foreach(&queue->flows, list_flow, &ctx);
+    
+    for (job_lane_t *lane = queue->lanes; lane; lane = lane->next) {
+        for (int i = 0; i < lane->edf_size; i++) {
+            const job_node_t *node = lane->edf[i];
+            tslog_info(queue->logger, "#%d: %s (prazo em %.0fs, cliente %s) - PENDENTE (EDF)",
+                       node->job.job_id, node->job.script,
+                       difftime(node->job.deadline, ctx.wall_now), node->job.client);
+            ctx.count++;
         }
-        
-        char time_buf[64];
-        struct tm *timeinfo = localtime(&current->job.submitted_at);
-        strftime(time_buf, sizeof(time_buf), "%H:%M:%S", timeinfo);
-        
-        tslog_info(queue->logger, "#%d: [%s] %s (pri: %d, timeout: %ds) - %s",
-                   current->job.job_id, time_buf, current->job.script,
-                   current->job.priority, current->job.timeout, status_str);
-        
-        current = current->next;
-        count++;
     }
     
-    if (count == 0) {
+    if (ctx.count == 0) {
         tslog_info(queue->logger, "Fila vazia");
     }
     
     pthread_mutex_unlock(&queue->mutex);
-}
\ No newline at end of file
+}
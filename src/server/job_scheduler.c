@@ -0,0 +1,297 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include "job_scheduler.h"
+#include "shard_ring.h"
+
+// Disparo anotado sob o mutex e executado depois (fila e database fora do lock)
+typedef struct fired_job {
+    job_t job;
+    int schedule_id;
+    time_t next_run;            // 0 = agendamento terminou
+    struct fired_job *next;
+} fired_job_t;
+
+typedef struct {
+    job_scheduler_t *sched;
+    time_t now;
+    fired_job_t *head;
+    fired_job_t **tail;
+} tick_ctx_t;
+
+int job_scheduler_init(job_scheduler_t *sched, job_queue_t *queue, tslog_t *logger) {
+    if (!sched || !queue) return -1;
+    
+    sched->queue = queue;
+    sched->logger = logger;
+    sched->next_schedule_id = 1;
+    sched->id_shard = -1;
+    sched->rand_state = (unsigned int)time(NULL);
+    sched->fired = 0;
+    sched->running = 1;
+    
+    if (pthread_mutex_init(&sched->mutex, NULL) != 0) {
+        tslog_error(logger, "Falha ao inicializar mutex do agendador");
+        return -1;
+    }
+    
+    if (int_map_init(&sched->schedules, 256) != 0 ||
+        hier_wheel_init(&sched->wheel, SCHEDULER_TICK_MS) != 0) {
+        tslog_error(logger, "Falha ao alocar agendador");
+        int_map_destroy(&sched->schedules);
+        pthread_mutex_destroy(&sched->mutex);
+        return -1;
+    }
+    
+    return 0;
+}
+
+static void free_schedule(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    free(value);
+}
+
+void job_scheduler_destroy(job_scheduler_t *sched) {
+    if (!sched) return;
+    
+    pthread_mutex_lock(&sched->mutex);
+    sched->running = 0;
+    hier_wheel_destroy(&sched->wheel);
+    int_map_foreach(&sched->schedules, free_schedule, NULL);
+    int_map_destroy(&sched->schedules);
+    pthread_mutex_unlock(&sched->mutex);
+    pthread_mutex_destroy(&sched->mutex);
+}
+
+// Próximo horário planejado depois de `prev`, pulando os já passados; 0 = não repete
+static time_t next_run_after(const schedule_t *s, time_t prev, time_t now) {
+    if (s->rec.every > 0) {
+        time_t next = prev + s->rec.every;
+        if (next <= now) {
+            next += ((now - next) / s->rec.every + 1) * s->rec.every;
+        }
+        return next;
+    }
+    if (s->rec.cron[0]) {
+        time_t next = cron_expr_next(&s->cron, prev > now ? prev : now);
+        return next > 0 ? next : 0;
+    }
+    return 0;
+}
+
+// Coloca o agendamento na roda para rec.next_run (+ jitter). Chamar com o mutex.
+static void arm(job_scheduler_t *sched, schedule_t *s, time_t now) {
+    long delay_ms = (long)(s->rec.next_run - now) * 1000;
+    if (delay_ms < 0) delay_ms = 0;
+    if (s->rec.jitter > 0) {
+        delay_ms += rand_r(&sched->rand_state) % (s->rec.jitter * 1000L + 1);
+    }
+    hier_wheel_schedule(&sched->wheel, &s->timer, delay_ms);
+}
+
+// Registra um agendamento já validado. Chamar com o mutex.
+static int insert_locked(job_scheduler_t *sched, schedule_t *s, time_t now) {
+    s->timer.data = s;
+    if (int_map_put(&sched->schedules, s->rec.schedule_id, s) != 0) {
+        return -1;
+    }
+    if (s->rec.schedule_id >= sched->next_schedule_id) {
+        sched->next_schedule_id = shard_align_id(s->rec.schedule_id + 1, sched->id_shard);
+    }
+    arm(sched, s, now);
+    return 0;
+}
+
+static void load_schedule(const schedule_record_t *rec, void *arg) {
+    job_scheduler_t *sched = (job_scheduler_t*)arg;
+    
+    schedule_t *s = calloc(1, sizeof(schedule_t));
+    if (!s) return;
+    s->rec = *rec;
+    
+    if (s->rec.cron[0] && cron_expr_parse(s->rec.cron, &s->cron) != 0) {
+        tslog_warn(sched->logger, "Agendamento %d com cron inválido ignorado: %s",
+                   rec->schedule_id, rec->cron);
+        free(s);
+        return;
+    }
+    
+    pthread_mutex_lock(&sched->mutex);
+    if (insert_locked(sched, s, time(NULL)) != 0) {
+        free(s);
+    }
+    pthread_mutex_unlock(&sched->mutex);
+}
+
+int job_scheduler_load(job_scheduler_t *sched) {
+    return database_load_schedules(load_schedule, sched);
+}
+
+int job_scheduler_add(job_scheduler_t *sched, const job_t *job, const job_options_t *opts,
+                      time_t *first_run) {
+    if (!sched || !job || !opts) return -1;
+    if (opts->every > 0 && opts->cron[0]) return -1;   // um tipo de recorrência por vez
+    
+    schedule_t *s = calloc(1, sizeof(schedule_t));
+    if (!s) {
+        tslog_error(sched->logger, "Sem memória para novo agendamento");
+        return -1;
+    }
+    
+    time_t now = time(NULL);
+    s->rec.job = *job;
+    s->rec.every = opts->every;
+    s->rec.jitter = opts->jitter;
+    snprintf(s->rec.cron, sizeof(s->rec.cron), "%s", opts->cron);
+    
+    if (s->rec.cron[0] && cron_expr_parse(s->rec.cron, &s->cron) != 0) {
+        free(s);
+        return -1;
+    }
+    
+    // Primeiro disparo: at=/delay= se houver; senão a primeira ocorrência
+    // da recorrência a partir de agora
+    if (opts->run_at > 0) {
+        s->rec.next_run = opts->run_at;
+    } else if (opts->delay > 0) {
+        s->rec.next_run = now + opts->delay;
+    } else {
+        s->rec.next_run = next_run_after(s, now, now);
+    }
+    if (s->rec.next_run <= 0) {
+        free(s);
+        return -1;
+    }
+    
+    pthread_mutex_lock(&sched->mutex);
+    s->rec.schedule_id = sched->next_schedule_id;
+    sched->next_schedule_id = shard_align_id(s->rec.schedule_id + 1, sched->id_shard);
+    pthread_mutex_unlock(&sched->mutex);
+    
+    // Persistido antes de entrar na roda: um disparo não pode apagar a linha
+    // antes de ela existir
+    if (database_save_schedule(&s->rec) != 0) {
+        free(s);
+        return -1;
+    }
+    
+    // Dentro da roda o agendamento é da thread do scheduler: um at= no
+    // passado dispara (e é liberado) no próximo tique, então só as cópias
+    // servem depois do unlock
+    int schedule_id = s->rec.schedule_id;
+    pthread_mutex_lock(&sched->mutex);
+    int rc = insert_locked(sched, s, now);
+    time_t next_run = s->rec.next_run;
+    pthread_mutex_unlock(&sched->mutex);
+    
+    if (rc != 0) {
+        database_delete_schedule(schedule_id);
+        free(s);
+        return -1;
+    }
+    
+    if (first_run) *first_run = next_run;
+    tslog_info(sched->logger, "Agendamento %d criado (próximo disparo em %lds%s%s)",
+               schedule_id, (long)(next_run - now),
+               opts->cron[0] ? ", cron " : (opts->every ? ", recorrente" : ""), opts->cron);
+    return schedule_id;
+}
+
+void job_scheduler_set_shard(job_scheduler_t *sched, int shard) {
+    pthread_mutex_lock(&sched->mutex);
+    sched->id_shard = shard;
+    sched->next_schedule_id = shard_align_id(sched->next_schedule_id, shard);
+    pthread_mutex_unlock(&sched->mutex);
+}
+
+int job_scheduler_cancel(job_scheduler_t *sched, int schedule_id) {
+    pthread_mutex_lock(&sched->mutex);
+    schedule_t *s = int_map_remove(&sched->schedules, schedule_id);
+    if (s) {
+        hier_wheel_cancel(&sched->wheel, &s->timer);
+    }
+    pthread_mutex_unlock(&sched->mutex);
+    
+    if (!s) return -1;
+    
+    free(s);
+    database_delete_schedule(schedule_id);
+    tslog_info(sched->logger, "Agendamento %d removido", schedule_id);
+    return 0;
+}
+
+int job_scheduler_count(job_scheduler_t *sched) {
+    pthread_mutex_lock(&sched->mutex);
+    int count = (int)sched->schedules.size;
+    pthread_mutex_unlock(&sched->mutex);
+    return count;
+}
+
+// Callback da roda (com o mutex): anota o job e rearma ou encerra o agendamento
+static void schedule_expired(timer_node_t *node, void *arg) {
+    tick_ctx_t *ctx = (tick_ctx_t*)arg;
+    job_scheduler_t *sched = ctx->sched;
+    schedule_t *s = (schedule_t*)node->data;
+    
+    fired_job_t *fired = malloc(sizeof(fired_job_t));
+    if (!fired) {
+        // Tenta de novo no próximo tick em vez de perder o disparo
+        hier_wheel_schedule(&sched->wheel, &s->timer, SCHEDULER_TICK_MS);
+        return;
+    }
+    fired->job = s->rec.job;
+    fired->schedule_id = s->rec.schedule_id;
+    fired->next = NULL;
+    
+    time_t next = next_run_after(s, s->rec.next_run, ctx->now);
+    if (next > 0) {
+        s->rec.next_run = next;
+        arm(sched, s, ctx->now);
+    } else {
+        int_map_remove(&sched->schedules, s->rec.schedule_id);
+        free(s);
+    }
+    fired->next_run = next;
+    
+    *ctx->tail = fired;
+    ctx->tail = &fired->next;
+    sched->fired++;
+}
+
+int job_scheduler_tick(job_scheduler_t *sched) {
+    tick_ctx_t ctx = {sched, time(NULL), NULL, NULL};
+    ctx.tail = &ctx.head;
+    
+    pthread_mutex_lock(&sched->mutex);
+    int count = hier_wheel_advance(&sched->wheel, schedule_expired, &ctx);
+    pthread_mutex_unlock(&sched->mutex);
+    
+    while (ctx.head) {
+        fired_job_t *fired = ctx.head;
+        ctx.head = fired->next;
+        
+        int job_id = job_queue_push_priority(sched->queue, &fired->job);
+        tslog_info_limited(sched->logger, "queue", "Agendamento %d disparou o job %d",
+                           fired->schedule_id, job_id);
+        
+        if (fired->next_run > 0) {
+            database_update_schedule(fired->schedule_id, fired->next_run);
+        } else {
+            database_delete_schedule(fired->schedule_id);
+        }
+        free(fired);
+    }
+    return count;
+}
+
+void* job_scheduler_thread_func(void *arg) {
+    job_scheduler_t *sched = (job_scheduler_t*)arg;
+    
+    while (sched->running) {
+        usleep(SCHEDULER_POLL_MS * 1000);
+        job_scheduler_tick(sched);
+    }
+    
+    return NULL;
+}
@@ -0,0 +1,354 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "job_stats.h"
+#include "database.h"
+
+static void counters_reset(job_counters_t *c) {
+    atomic_store(&c->submitted, 0);
+    atomic_store(&c->started, 0);
+    atomic_store(&c->completed, 0);
+    atomic_store(&c->failed, 0);
+    atomic_store(&c->exec_time_us, 0);
+    for (int i = 0; i < JOB_STATS_HIST_BUCKETS; i++) {
+        atomic_store(&c->hist[i], 0);
+    }
+}
+
+static void counters_read(job_counters_t *c, job_stats_snapshot_t *snap) {
+    snap->submitted = atomic_load_explicit(&c->submitted, memory_order_relaxed);
+    snap->started = atomic_load_explicit(&c->started, memory_order_relaxed);
+    snap->completed = atomic_load_explicit(&c->completed, memory_order_relaxed);
+    snap->failed = atomic_load_explicit(&c->failed, memory_order_relaxed);
+    snap->exec_time_us = atomic_load_explicit(&c->exec_time_us, memory_order_relaxed);
+    for (int i = 0; i < JOB_STATS_HIST_BUCKETS; i++) {
+        snap->hist[i] = atomic_load_explicit(&c->hist[i], memory_order_relaxed);
+    }
+}
+
+static void counters_add(job_counters_t *c, const job_stats_snapshot_t *snap) {
+    atomic_fetch_add(&c->submitted, snap->submitted);
+    atomic_fetch_add(&c->started, snap->started);
+    atomic_fetch_add(&c->completed, snap->completed);
+    atomic_fetch_add(&c->failed, snap->failed);
+    atomic_fetch_add(&c->exec_time_us, snap->exec_time_us);
+    for (int i = 0; i < JOB_STATS_HIST_BUCKETS; i++) {
+        atomic_fetch_add(&c->hist[i], snap->hist[i]);
+    }
+}
+
+static inline void inc(atomic_long *v) {
+    atomic_fetch_add_explicit(v, 1, memory_order_relaxed);
+}
+
+static int priority_index(int priority) {
+    return (priority >= 1 && priority <= 10) ? priority : 0;
+}
+
+// Contadores do worker (chamar com workers_mutex); create = 0 não cria:
+// resultado atrasado de um worker que já saiu não o traz de volta
+static job_counters_t *worker_counters_locked(job_stats_t *stats, int worker_id, int create) {
+    job_counters_t *c = int_map_get(&stats->by_worker, worker_id);
+    if (c || !create) return c;
+    c = calloc(1, sizeof(job_counters_t));
+    if (c && int_map_put(&stats->by_worker, worker_id, c) != 0) {
+        free(c);
+        return NULL;
+    }
+    return c;
+}
+
+// Bucket b cobre [2^(b-1), 2^b) ms; o último acumula o restante
+static int hist_bucket(double exec_time) {
+    long ms = (long)(exec_time * 1000.0);
+    int b = 0;
+    while (ms > 0 && b < JOB_STATS_HIST_BUCKETS - 1) {
+        ms >>= 1;
+        b++;
+    }
+    return b;
+}
+
+// Slot da janela do minuto atual. Quando o slot ainda guarda um minuto antigo
+// ele é zerado; incrementos concorrentes com o reset podem se perder, o que é
+// aceitável para uma visão aproximada por janela.
+static job_counters_t *current_window(job_stats_t *stats) {
+    long minute = (long)(time(NULL) / 60);
+    job_stats_window_t *w = &stats->windows[minute % JOB_STATS_WINDOWS];
+    long seen = atomic_load(&w->minute);
+
+    if (seen != minute && seen < minute &&
+        atomic_compare_exchange_strong(&w->minute, &seen, minute)) {
+        counters_reset(&w->counters);
+    }
+    return &w->counters;
+}
+
+int job_stats_init(job_stats_t *stats) {
+    if (!stats) return -1;
+    if (int_map_init(&stats->by_worker, 64) != 0) return -1;
+    pthread_mutex_init(&stats->workers_mutex, NULL);
+
+    counters_reset(&stats->total);
+    for (int i = 0; i < JOB_STATS_PRIORITIES; i++) {
+        counters_reset(&stats->by_priority[i]);
+    }
+    for (int i = 0; i < JOB_STATS_WINDOWS; i++) {
+        atomic_store(&stats->windows[i].minute, 0);
+        counters_reset(&stats->windows[i].counters);
+    }
+    atomic_store(&stats->pending, 0);
+    atomic_store(&stats->running, 0);
+    for (int i = 0; i < DEADLINE_OUTCOMES; i++) {
+        atomic_store(&stats->deadline[i], 0);
+    }
+    return 0;
+}
+
+static void free_counters(int key, void *value, void *arg) {
+    (void)key;
+    (void)arg;
+    free(value);
+}
+
+void job_stats_destroy(job_stats_t *stats) {
+    if (!stats) return;
+    pthread_mutex_lock(&stats->workers_mutex);
+    int_map_foreach(&stats->by_worker, free_counters, NULL);
+    int_map_destroy(&stats->by_worker);
+    pthread_mutex_unlock(&stats->workers_mutex);
+    pthread_mutex_destroy(&stats->workers_mutex);
+}
+
+void job_stats_record_submit(job_stats_t *stats, int priority) {
+    if (!stats) return;
+
+    inc(&stats->total.submitted);
+    inc(&stats->by_priority[priority_index(priority)].submitted);
+    inc(&current_window(stats)->submitted);
+    atomic_fetch_add(&stats->pending, 1);
+}
+
+void job_stats_record_start(job_stats_t *stats, int priority, int worker_id) {
+    if (!stats) return;
+
+    inc(&stats->total.started);
+    inc(&stats->by_priority[priority_index(priority)].started);
+    if (worker_id > 0) {
+        job_stats_record_assign(stats, worker_id);
+    }
+    inc(&current_window(stats)->started);
+    atomic_fetch_sub(&stats->pending, 1);
+    atomic_fetch_add(&stats->running, 1);
+}
+
+void job_stats_record_deadline(job_stats_t *stats, deadline_outcome_t outcome) {
+    if (!stats || outcome < 0 || outcome >= DEADLINE_OUTCOMES) return;
+
+    inc(&stats->deadline[outcome]);
+    if (outcome == DEADLINE_EXPIRED) {
+        atomic_fetch_sub(&stats->pending, 1);
+    }
+}
+
+void job_stats_record_assign(job_stats_t *stats, int worker_id) {
+    if (!stats || worker_id <= 0) return;
+
+    pthread_mutex_lock(&stats->workers_mutex);
+    job_counters_t *c = worker_counters_locked(stats, worker_id, 1);
+    if (c) inc(&c->started);
+    pthread_mutex_unlock(&stats->workers_mutex);
+}
+
+void job_stats_record_requeue(job_stats_t *stats) {
+    if (!stats) return;
+
+    atomic_fetch_sub(&stats->running, 1);
+    atomic_fetch_add(&stats->pending, 1);
+}
+
+void job_stats_record_cancel(job_stats_t *stats, int was_running) {
+    if (!stats) return;
+
+    atomic_fetch_sub(was_running ? &stats->running : &stats->pending, 1);
+}
+
+void job_stats_record_finish(job_stats_t *stats, int priority, int worker_id,
+                             int success, double exec_time) {
+    if (!stats) return;
+
+    long us = exec_time > 0 ? (long)(exec_time * 1e6) : 0;
+    int bucket = hist_bucket(exec_time > 0 ? exec_time : 0);
+    job_counters_t *targets[3];
+    int n = 0;
+
+    targets[n++] = &stats->total;
+    targets[n++] = &stats->by_priority[priority_index(priority)];
+    targets[n++] = current_window(stats);
+
+    for (int i = 0; i < n; i++) {
+        inc(success ? &targets[i]->completed : &targets[i]->failed);
+        atomic_fetch_add_explicit(&targets[i]->exec_time_us, us, memory_order_relaxed);
+        inc(&targets[i]->hist[bucket]);
+    }
+    if (worker_id > 0) {
+        // Sob o mutex: o worker pode sair (e os contadores serem liberados) ao mesmo tempo
+        pthread_mutex_lock(&stats->workers_mutex);
+        job_counters_t *c = worker_counters_locked(stats, worker_id, 0);
+        if (c) {
+            inc(success ? &c->completed : &c->failed);
+            atomic_fetch_add_explicit(&c->exec_time_us, us, memory_order_relaxed);
+            inc(&c->hist[bucket]);
+        }
+        pthread_mutex_unlock(&stats->workers_mutex);
+    }
+    atomic_fetch_sub(&stats->running, 1);
+}
+
+void job_stats_forget_worker(job_stats_t *stats, int worker_id) {
+    if (!stats || worker_id <= 0) return;
+
+    pthread_mutex_lock(&stats->workers_mutex);
+    free(int_map_remove(&stats->by_worker, worker_id));
+    pthread_mutex_unlock(&stats->workers_mutex);
+}
+
+void job_stats_get_total(job_stats_t *stats, job_stats_snapshot_t *snap) {
+    counters_read(&stats->total, snap);
+}
+
+void job_stats_get_priority(job_stats_t *stats, int priority, job_stats_snapshot_t *snap) {
+    counters_read(&stats->by_priority[priority_index(priority)], snap);
+}
+
+void job_stats_get_worker(job_stats_t *stats, int worker_id, job_stats_snapshot_t *snap) {
+    memset(snap, 0, sizeof(*snap));
+    pthread_mutex_lock(&stats->workers_mutex);
+    job_counters_t *c = worker_counters_locked(stats, worker_id, 0);
+    if (c) counters_read(c, snap);
+    pthread_mutex_unlock(&stats->workers_mutex);
+}
+
+typedef struct {
+    int *ids;
+    int count;
+    int max;
+} worker_list_t;
+
+static void collect_worker(int key, void *value, void *arg) {
+    (void)value;
+    worker_list_t *list = (worker_list_t*)arg;
+    if (list->count < list->max) list->ids[list->count++] = key;
+}
+
+static int compare_ids(const void *a, const void *b) {
+    int ia = *(const int*)a, ib = *(const int*)b;
+    return (ia > ib) - (ia < ib);
+}
+
+int job_stats_list_workers(job_stats_t *stats, int *ids, int max) {
+    worker_list_t list = {ids, 0, max};
+    pthread_mutex_lock(&stats->workers_mutex);
+    int_map_foreach(&stats->by_worker, collect_worker, &list);
+    pthread_mutex_unlock(&stats->workers_mutex);
+    qsort(ids, list.count, sizeof(int), compare_ids);
+    return list.count;
+}
+
+// Soma as janelas dos últimos `minutes` minutos (no máximo uma hora)
+void job_stats_get_window(job_stats_t *stats, int minutes, job_stats_snapshot_t *snap) {
+    memset(snap, 0, sizeof(*snap));
+    if (minutes <= 0) return;
+    if (minutes > JOB_STATS_WINDOWS) minutes = JOB_STATS_WINDOWS;
+
+    long now = (long)(time(NULL) / 60);
+    for (int i = 0; i < JOB_STATS_WINDOWS; i++) {
+        job_stats_window_t *w = &stats->windows[i];
+        long minute = atomic_load(&w->minute);
+        if (minute <= now - minutes || minute > now) continue;
+
+        job_stats_snapshot_t part;
+        counters_read(&w->counters, &part);
+        snap->submitted += part.submitted;
+        snap->started += part.started;
+        snap->completed += part.completed;
+        snap->failed += part.failed;
+        snap->exec_time_us += part.exec_time_us;
+        for (int b = 0; b < JOB_STATS_HIST_BUCKETS; b++) {
+            snap->hist[b] += part.hist[b];
+        }
+    }
+}
+
+long job_stats_pending(job_stats_t *stats) {
+    return atomic_load(&stats->pending);
+}
+
+long job_stats_running(job_stats_t *stats) {
+    return atomic_load(&stats->running);
+}
+
+long job_stats_deadline(job_stats_t *stats, deadline_outcome_t outcome) {
+    return stats ? atomic_load(&stats->deadline[outcome]) : 0;
+}
+
+double job_stats_avg_time(const job_stats_snapshot_t *snap) {
+    long finished = snap->completed + snap->failed;
+    return finished > 0 ? (double)snap->exec_time_us / 1e6 / finished : 0.0;
+}
+
+// Limite superior (em segundos) do bucket que contém o percentil p (0-100)
+double job_stats_percentile(const job_stats_snapshot_t *snap, double p) {
+    long count = 0;
+    for (int b = 0; b < JOB_STATS_HIST_BUCKETS; b++) count += snap->hist[b];
+    if (count == 0) return 0.0;
+
+    long target = (long)(count * p / 100.0);
+    if (target >= count) target = count - 1;
+
+    long seen = 0;
+    for (int b = 0; b < JOB_STATS_HIST_BUCKETS; b++) {
+        seen += snap->hist[b];
+        if (seen > target) {
+            return (double)(1L << b) / 1000.0;
+        }
+    }
+    return (double)(1L << (JOB_STATS_HIST_BUCKETS - 1)) / 1000.0;
+}
+
+int job_stats_persist(job_stats_t *stats) {
+    if (!stats) return -1;
+
+    // Por worker não: os ids recomeçam a cada execução do servidor
+    job_stats_row_t rows[1 + JOB_STATS_PRIORITIES];
+    int n = 0;
+
+    strcpy(rows[n].scope, "total");
+    rows[n].key = 0;
+    counters_read(&stats->total, &rows[n++].snap);
+
+    for (int i = 0; i < JOB_STATS_PRIORITIES; i++) {
+        strcpy(rows[n].scope, "priority");
+        rows[n].key = i;
+        counters_read(&stats->by_priority[i], &rows[n].snap);
+        if (rows[n].snap.submitted || rows[n].snap.started) n++;
+    }
+
+    return database_save_stats(rows, n);
+}
+
+static void load_row(const job_stats_row_t *row, void *arg) {
+    job_stats_t *stats = (job_stats_t*)arg;
+
+    if (strcmp(row->scope, "total") == 0) {
+        counters_add(&stats->total, &row->snap);
+    } else if (strcmp(row->scope, "priority") == 0 &&
+               row->key >= 0 && row->key < JOB_STATS_PRIORITIES) {
+        counters_add(&stats->by_priority[row->key], &row->snap);
+    }
+}
+
+int job_stats_load(job_stats_t *stats) {
+    if (!stats) return -1;
+    return database_load_stats(load_row, stats);
+}
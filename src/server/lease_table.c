@@ -0,0 +1,597 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include "lease_table.h"
+#include "database.h"
+
+// Efeitos colaterais (fila, database, worker manager) acontecem depois de
+// soltar o mutex da tabela; durante a varredura só se anota o que fazer
+typedef struct {
+    lease_t **requeue;
+    int requeue_count;
+    lease_t **dead;
+    int dead_count;
+    int (*expired)[2];          // {worker_id, job_id}
+    int expired_count;
+    job_t *hedges;              // cópias a pedir, com o worker da original
+    int *hedge_workers;
+    int hedge_count;
+    int capacity;
+} lease_actions_t;
+
+static void actions_reserve(lease_actions_t *actions) {
+    if (actions->requeue_count < actions->capacity &&
+        actions->dead_count < actions->capacity &&
+        actions->expired_count < actions->capacity &&
+        actions->hedge_count < actions->capacity) {
+        return;
+    }
+    int capacity = actions->capacity ? actions->capacity * 2 : 16;
+    actions->requeue = realloc(actions->requeue, (size_t)capacity * sizeof(lease_t*));
+    actions->dead = realloc(actions->dead, (size_t)capacity * sizeof(lease_t*));
+    actions->expired = realloc(actions->expired, (size_t)capacity * sizeof(int[2]));
+    actions->hedges = realloc(actions->hedges, (size_t)capacity * sizeof(job_t));
+    actions->hedge_workers = realloc(actions->hedge_workers, (size_t)capacity * sizeof(int));
+    actions->capacity = capacity;
+}
+
+// A cópia deixa de existir (terminou, falhou ou assumiu). Chamar com o mutex travado.
+static void end_hedge_locked(lease_table_t *table, lease_t *lease) {
+    if (lease->hedge_worker_id > 0) {
+        lease->hedge_worker_id = 0;
+        table->hedges_active--;
+    }
+}
+
+// Descarta o lease que ocupava o id. Chamar com o mutex travado.
+static void replace_locked(lease_table_t *table, int job_id) {
+    lease_t *old = int_map_remove(&table->leases, job_id);
+    if (!old) return;
+    timing_wheel_cancel(&old->timer);
+    timing_wheel_cancel(&old->hedge_timer);
+    end_hedge_locked(table, old);
+    free(old);
+}
+
+// Gancho da fila (com o mutex dela): o job saiu para execução e ainda não
+// tem worker. O prazo já corre: se a entrega nunca acontecer, o lease vence
+// e o job ganha outra tentativa.
+static void dispatching(const job_t *job, void *arg) {
+    lease_table_t *table = (lease_table_t*)arg;
+    lease_t *lease = calloc(1, sizeof(lease_t));
+    if (!lease) {
+        tslog_error(table->logger, "Sem memória para o lease do job %d", job->job_id);
+        return;
+    }
+    lease->job = *job;
+    lease->state = LEASE_DISPATCHING;
+    lease->timer.data = lease;
+    lease->hedge_timer.data = lease;
+    
+    pthread_mutex_lock(&table->mutex);
+    replace_locked(table, job->job_id);
+    if (int_map_put(&table->leases, job->job_id, lease) != 0) {
+        pthread_mutex_unlock(&table->mutex);
+        free(lease);
+        return;
+    }
+    timing_wheel_schedule(&table->timers, &lease->timer, (job->timeout + LEASE_GRACE_SECONDS) * 1000L);
+    pthread_mutex_unlock(&table->mutex);
+}
+
+int lease_table_init(lease_table_t *table, job_queue_t *queue, tslog_t *logger) {
+    if (!table || !queue) return -1;
+    
+    table->queue = queue;
+    table->logger = logger;
+    table->max_attempts = LEASE_MAX_ATTEMPTS;
+    table->next_lease_id = 0;
+    table->requeued = 0;
+    table->dead_lettered = 0;
+    table->on_dead_letter = NULL;
+    table->dead_letter_arg = NULL;
+    table->history = NULL;
+    table->hedge_percentile = 0;
+    table->hedge_budget = LEASE_HEDGE_DEFAULT_BUDGET;
+    table->hedges_active = 0;
+    table->hedged = 0;
+    table->hedge_won = 0;
+    table->hedge_lost = 0;
+    table->hedge_skipped = 0;
+    table->on_hedge = NULL;
+    table->hedge_arg = NULL;
+    
+    if (pthread_mutex_init(&table->mutex, NULL) != 0) {
+        tslog_error(logger, "Falha ao inicializar mutex da tabela de leases");
+        return -1;
+    }
+    
+    if (int_map_init(&table->leases, 256) != 0) {
+        tslog_error(logger, "Falha ao alocar tabela de leases");
+        pthread_mutex_destroy(&table->mutex);
+        return -1;
+    }
+    if (timing_wheel_init(&table->timers, LEASE_WHEEL_SLOTS, LEASE_WHEEL_TICK_MS) != 0) {
+        tslog_error(logger, "Falha ao alocar timers da tabela de leases");
+        int_map_destroy(&table->leases);
+        pthread_mutex_destroy(&table->mutex);
+        return -1;
+    }
+    
+    job_queue_set_dequeue_hook(queue, dispatching, table);
+    return 0;
+}
+
+static void free_lease(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    free(value);
+}
+
+void lease_table_destroy(lease_table_t *table) {
+    if (!table) return;
+    
+    job_queue_set_dequeue_hook(table->queue, NULL, NULL);
+    pthread_mutex_lock(&table->mutex);
+    timing_wheel_destroy(&table->timers);
+    int_map_foreach(&table->leases, free_lease, NULL);
+    int_map_destroy(&table->leases);
+    pthread_mutex_unlock(&table->mutex);
+    pthread_mutex_destroy(&table->mutex);
+}
+
+void lease_table_set_max_attempts(lease_table_t *table, int attempts) {
+    if (attempts < 1) return;
+    
+    pthread_mutex_lock(&table->mutex);
+    table->max_attempts = attempts;
+    pthread_mutex_unlock(&table->mutex);
+}
+
+void lease_table_set_dead_letter_hook(lease_table_t *table,
+                                      void (*hook)(const job_t *job, void *arg), void *arg) {
+    pthread_mutex_lock(&table->mutex);
+    table->on_dead_letter = hook;
+    table->dead_letter_arg = arg;
+    pthread_mutex_unlock(&table->mutex);
+}
+
+void lease_table_set_hedging(lease_table_t *table, runtime_history_t *history,
+                             int percentile, int budget) {
+    if (percentile < 0 || percentile > 99 || budget < 0) return;
+    
+    pthread_mutex_lock(&table->mutex);
+    table->history = history;
+    table->hedge_percentile = percentile;
+    table->hedge_budget = budget;
+    pthread_mutex_unlock(&table->mutex);
+    
+    if (percentile > 0) {
+        tslog_info(table->logger, "Execução especulativa: p%d das durações, orçamento %d%%",
+                   percentile, budget);
+    }
+}
+
+void lease_table_set_hedge_hook(lease_table_t *table,
+                                int (*hook)(const job_t *job, int worker_id, void *arg), void *arg) {
+    pthread_mutex_lock(&table->mutex);
+    table->on_hedge = hook;
+    table->hedge_arg = arg;
+    pthread_mutex_unlock(&table->mutex);
+}
+
+// Cabe mais uma cópia? Chamar com o mutex travado.
+static int hedge_allowed(lease_table_t *table) {
+    int limit = (int)(table->leases.size * (size_t)table->hedge_budget / 100);
+    if (limit < 1 && table->hedge_budget > 0) limit = 1;
+    return table->hedges_active < limit;
+}
+
+int lease_table_attach_hedge(lease_table_t *table, int job_id, int worker_id) {
+    int rc = -1;
+    
+    pthread_mutex_lock(&table->mutex);
+    lease_t *lease = int_map_get(&table->leases, job_id);
+    if (lease && lease->state == LEASE_ACTIVE && lease->hedge_worker_id == 0 &&
+        lease->worker_id != worker_id) {
+        if (hedge_allowed(table)) {
+            lease->hedge_worker_id = worker_id;
+            table->hedges_active++;
+            table->hedged++;
+            rc = 0;
+        } else {
+            table->hedge_skipped++;
+        }
+    }
+    pthread_mutex_unlock(&table->mutex);
+    
+    return rc;
+}
+
+int lease_table_acquire(lease_table_t *table, job_t *job, int worker_id) {
+    lease_t *lease = calloc(1, sizeof(lease_t));
+    if (!lease) {
+        tslog_error(table->logger, "Sem memória para o lease do job %d", job->job_id);
+        return -1;
+    }
+    
+    lease->job = *job;
+    lease->job.assigned_worker = worker_id;
+    lease->worker_id = worker_id;
+    lease->state = LEASE_ACTIVE;
+    lease->timer.data = lease;
+    lease->hedge_timer.data = lease;
+    
+    long deadline_ms = (job->timeout + LEASE_GRACE_SECONDS) * 1000L;
+    
+    pthread_mutex_lock(&table->mutex);
+    lease_t *old = int_map_get(&table->leases, job->job_id);
+    if (old && old->state == LEASE_CANCELLED) {
+        replace_locked(table, job->job_id);
+        pthread_mutex_unlock(&table->mutex);
+        free(lease);
+        tslog_info(table->logger, "Job %d cancelado antes da entrega ao worker %d", job->job_id, worker_id);
+        return 1;
+    }
+    // O lease aberto na saída da fila dá lugar ao do worker
+    replace_locked(table, job->job_id);
+    if (++table->next_lease_id <= 0) table->next_lease_id = 1;
+    lease->job.lease_id = table->next_lease_id;
+    
+    // Cópia especulativa quando passar do percentil, se isso vem antes do timeout
+    if (table->hedge_percentile > 0 && !job->no_hedge) {
+        double estimate = runtime_history_percentile(table->history, job->script, table->hedge_percentile);
+        long hedge_ms = (long)(estimate * 1000);
+        if (hedge_ms < LEASE_HEDGE_MIN_MS) hedge_ms = LEASE_HEDGE_MIN_MS;
+        if (estimate > 0 && hedge_ms < job->timeout * 1000L) {
+            timing_wheel_schedule(&table->timers, &lease->hedge_timer, hedge_ms);
+        }
+    }
+    if (int_map_put(&table->leases, job->job_id, lease) != 0) {
+        timing_wheel_cancel(&lease->hedge_timer);
+        pthread_mutex_unlock(&table->mutex);
+        free(lease);
+        return -1;
+    }
+    timing_wheel_schedule(&table->timers, &lease->timer, deadline_ms);
+    job->lease_id = lease->job.lease_id;
+    pthread_mutex_unlock(&table->mutex);
+    
+    job_index_update(table->queue->index, job->job_id, JOB_RUNNING, worker_id, job->attempts);
+    return 0;
+}
+
+// O worker executa uma das cópias ativas do job?
+static int runs_copy(const lease_t *lease, int worker_id) {
+    return lease->state == LEASE_ACTIVE &&
+           (lease->worker_id == worker_id || (lease->hedge_worker_id > 0 && lease->hedge_worker_id == worker_id));
+}
+
+// O lease que o worker recebeu no JOB ainda é o atual?
+static lease_t *current_lease(lease_table_t *table, int job_id, int lease_id, int worker_id) {
+    lease_t *lease = int_map_get(&table->leases, job_id);
+    return lease && lease->job.lease_id == lease_id && runs_copy(lease, worker_id) ? lease : NULL;
+}
+
+int lease_table_complete(lease_table_t *table, int job_id, int lease_id, int worker_id, job_t *job,
+                         int *other) {
+    pthread_mutex_lock(&table->mutex);
+    lease_t *lease = current_lease(table, job_id, lease_id, worker_id);
+    if (!lease) {
+        pthread_mutex_unlock(&table->mutex);
+        return -1;
+    }
+    int_map_remove(&table->leases, job_id);
+    timing_wheel_cancel(&lease->timer);
+    timing_wheel_cancel(&lease->hedge_timer);
+    
+    int loser = 0;
+    if (lease->hedge_worker_id > 0) {
+        int hedge_won = lease->hedge_worker_id == worker_id;
+        loser = hedge_won ? lease->worker_id : lease->hedge_worker_id;
+        if (hedge_won) {
+            table->hedge_won++;
+        } else {
+            table->hedge_lost++;
+        }
+        end_hedge_locked(table, lease);
+    } else if (lease->hedge_promoted) {
+        table->hedge_won++;
+    }
+    pthread_mutex_unlock(&table->mutex);
+    
+    if (other) *other = loser;
+    if (job) *job = lease->job;
+    free(lease);
+    return 0;
+}
+
+// Tira a cópia de `worker_id`; a outra fica com o lease. Chamar com o mutex travado.
+static int drop_copy_locked(lease_table_t *table, lease_t *lease, int worker_id) {
+    if (lease->hedge_worker_id <= 0 || !runs_copy(lease, worker_id)) return -1;
+    
+    if (lease->worker_id == worker_id) {
+        lease->worker_id = lease->hedge_worker_id;
+        lease->job.assigned_worker = lease->worker_id;
+        lease->hedge_promoted = 1;
+    }
+    end_hedge_locked(table, lease);
+    return 0;
+}
+
+int lease_table_drop_copy(lease_table_t *table, int job_id, int lease_id, int worker_id) {
+    pthread_mutex_lock(&table->mutex);
+    lease_t *lease = current_lease(table, job_id, lease_id, worker_id);
+    int rc = lease ? drop_copy_locked(table, lease, worker_id) : -1;
+    pthread_mutex_unlock(&table->mutex);
+    
+    if (rc == 0) {
+        tslog_warn(table->logger, "Job %d: cópia do worker %d descartada, a outra continua",
+                   job_id, worker_id);
+    }
+    return rc;
+}
+
+int lease_table_cancel(lease_table_t *table, int job_id) {
+    pthread_mutex_lock(&table->mutex);
+    lease_t *lease = int_map_remove(&table->leases, job_id);
+    if (lease) {
+        timing_wheel_cancel(&lease->timer);
+        timing_wheel_cancel(&lease->hedge_timer);
+        end_hedge_locked(table, lease);
+    }
+    pthread_mutex_unlock(&table->mutex);
+    
+    if (!lease) return -1;
+    
+    if (lease->state != LEASE_CANCELLED) {
+        job_queue_requeue(table->queue, &lease->job);
+    }
+    free(lease);
+    return 0;
+}
+
+int lease_table_reject(lease_table_t *table, int job_id, int lease_id, int worker_id) {
+    pthread_mutex_lock(&table->mutex);
+    lease_t *lease = current_lease(table, job_id, lease_id, worker_id);
+    if (!lease) {
+        pthread_mutex_unlock(&table->mutex);
+        return -1;
+    }
+    if (drop_copy_locked(table, lease, worker_id) == 0) {
+        pthread_mutex_unlock(&table->mutex);
+        return 0;
+    }
+    int_map_remove(&table->leases, job_id);
+    timing_wheel_cancel(&lease->timer);
+    timing_wheel_cancel(&lease->hedge_timer);
+    pthread_mutex_unlock(&table->mutex);
+    
+    job_queue_requeue(table->queue, &lease->job);
+    free(lease);
+    return 0;
+}
+
+int lease_table_abort(lease_table_t *table, int job_id, job_t *job, int workers[2]) {
+    pthread_mutex_lock(&table->mutex);
+    lease_t *lease = int_map_get(&table->leases, job_id);
+    if (lease && lease->state == LEASE_CANCELLED) {
+        lease = NULL;
+    } else if (lease && lease->state == LEASE_DISPATCHING) {
+        // Ainda sem worker: a marca fica até a entrega desistir (ou o prazo vencer)
+        lease->state = LEASE_CANCELLED;
+        if (job) *job = lease->job;
+        workers[0] = 0;
+        workers[1] = 0;
+        pthread_mutex_unlock(&table->mutex);
+        return 0;
+    }
+    if (lease) {
+        int_map_remove(&table->leases, job_id);
+        timing_wheel_cancel(&lease->timer);
+        timing_wheel_cancel(&lease->hedge_timer);
+        // Em backoff o job não está com ninguém
+        int active = lease->state == LEASE_ACTIVE;
+        workers[0] = active ? lease->worker_id : 0;
+        workers[1] = active ? lease->hedge_worker_id : 0;
+        end_hedge_locked(table, lease);
+    }
+    pthread_mutex_unlock(&table->mutex);
+    
+    if (!lease) return -1;
+    if (job) *job = lease->job;
+    free(lease);
+    return 0;
+}
+
+// Nova tentativa ou dead-letter. Chamar com o mutex travado.
+static void retry_locked(lease_table_t *table, lease_t *lease, lease_actions_t *actions) {
+    lease->job.attempts++;
+    timing_wheel_cancel(&lease->hedge_timer);
+    
+    if (lease->job.attempts >= table->max_attempts) {
+        int_map_remove(&table->leases, lease->job.job_id);
+        timing_wheel_cancel(&lease->timer);
+        actions_reserve(actions);
+        actions->dead[actions->dead_count++] = lease;
+        table->dead_lettered++;
+        return;
+    }
+    
+    // Backoff exponencial: base, 2x base, 4x base, ... até o teto
+    long delay = LEASE_BACKOFF_BASE_MS;
+    for (int i = 1; i < lease->job.attempts && delay < LEASE_BACKOFF_MAX_MS; i++) {
+        delay *= 2;
+    }
+    if (delay > LEASE_BACKOFF_MAX_MS) delay = LEASE_BACKOFF_MAX_MS;
+    
+    lease->state = LEASE_BACKOFF;
+    timing_wheel_schedule(&table->timers, &lease->timer, delay);
+    
+    tslog_warn(table->logger, "Job %d: tentativa %d/%d falhou no worker %d - volta à fila em %ldms",
+               lease->job.job_id, lease->job.attempts, table->max_attempts, lease->worker_id, delay);
+}
+
+static void run_actions(lease_table_t *table, lease_actions_t *actions,
+                        void (*on_expire)(int worker_id, int job_id, void *arg), void *arg) {
+    for (int i = 0; i < actions->expired_count; i++) {
+        if (on_expire) {
+            on_expire(actions->expired[i][0], actions->expired[i][1], arg);
+        }
+    }
+    
+    for (int i = 0; i < actions->hedge_count; i++) {
+        if (!table->on_hedge ||
+            table->on_hedge(&actions->hedges[i], actions->hedge_workers[i], table->hedge_arg) == 0) {
+            continue;
+        }
+        // Nenhum worker livre agora: a cópia volta a ser pedida mais tarde
+        pthread_mutex_lock(&table->mutex);
+        lease_t *lease = int_map_get(&table->leases, actions->hedges[i].job_id);
+        if (lease && lease->state == LEASE_ACTIVE && lease->hedge_worker_id == 0 &&
+            lease->worker_id == actions->hedge_workers[i]) {
+            lease->hedged = 0;
+            timing_wheel_schedule(&table->timers, &lease->hedge_timer, LEASE_HEDGE_RETRY_MS);
+        }
+        pthread_mutex_unlock(&table->mutex);
+    }
+    
+    for (int i = 0; i < actions->requeue_count; i++) {
+        lease_t *lease = actions->requeue[i];
+        job_queue_requeue(table->queue, &lease->job);
+        free(lease);
+    }
+    
+    for (int i = 0; i < actions->dead_count; i++) {
+        lease_t *lease = actions->dead[i];
+        char reason[128];
+        snprintf(reason, sizeof(reason), "DEAD_LETTER: %d tentativas sem resultado", lease->job.attempts);
+        
+        tslog_error(table->logger, "Job %d movido para dead-letter após %d tentativas",
+                    lease->job.job_id, lease->job.attempts);
+        database_update_job_status(lease->job.job_id, JOB_DEAD_LETTER, lease->job.attempts, reason);
+        job_index_update(table->queue->index, lease->job.job_id, JOB_DEAD_LETTER,
+                         lease->worker_id, lease->job.attempts);
+        job_stats_record_finish(table->queue->stats, lease->job.priority, lease->worker_id, 0, 0.0);
+        if (table->on_dead_letter) {
+            table->on_dead_letter(&lease->job, table->dead_letter_arg);
+        }
+        free(lease);
+    }
+    
+    free(actions->requeue);
+    free(actions->dead);
+    free(actions->expired);
+    free(actions->hedges);
+    free(actions->hedge_workers);
+}
+
+void lease_table_orphan(lease_table_t *table, int job_id, int worker_id) {
+    lease_actions_t actions;
+    memset(&actions, 0, sizeof(actions));
+    
+    pthread_mutex_lock(&table->mutex);
+    lease_t *lease = int_map_get(&table->leases, job_id);
+    // Com outra cópia em execução, basta ela continuar
+    if (lease && drop_copy_locked(table, lease, worker_id) != 0 &&
+        lease->state == LEASE_ACTIVE && lease->worker_id == worker_id) {
+        retry_locked(table, lease, &actions);
+    }
+    pthread_mutex_unlock(&table->mutex);
+    
+    run_actions(table, &actions, NULL, NULL);
+}
+
+typedef struct {
+    lease_table_t *table;
+    lease_actions_t *actions;
+} expire_ctx_t;
+
+static void expire_lease(timer_node_t *node, void *arg) {
+    expire_ctx_t *ctx = (expire_ctx_t*)arg;
+    lease_t *lease = (lease_t*)node->data;
+    
+    actions_reserve(ctx->actions);
+    
+    if (node == &lease->hedge_timer) {
+        // Passou do percentil: pede a cópia (uma por tentativa)
+        if (lease->state != LEASE_ACTIVE || lease->hedged) return;
+        lease->hedged = 1;
+        if (!hedge_allowed(ctx->table)) {
+            ctx->table->hedge_skipped++;
+            return;
+        }
+        ctx->actions->hedges[ctx->actions->hedge_count] = lease->job;
+        ctx->actions->hedge_workers[ctx->actions->hedge_count] = lease->worker_id;
+        ctx->actions->hedge_count++;
+        return;
+    }
+    
+    if (lease->state == LEASE_CANCELLED) {
+        // A entrega nunca veio buscar a marca do cancelamento
+        int_map_remove(&ctx->table->leases, lease->job.job_id);
+        free(lease);
+        return;
+    }
+    
+    if (lease->state == LEASE_BACKOFF) {
+        // Fim do backoff: sai da tabela e volta para a fila
+        int_map_remove(&ctx->table->leases, lease->job.job_id);
+        ctx->actions->requeue[ctx->actions->requeue_count++] = lease;
+        ctx->table->requeued++;
+        return;
+    }
+    
+    tslog_warn(ctx->table->logger, "Lease do job %d no worker %d venceu (timeout %ds + %ds)",
+               lease->job.job_id, lease->worker_id, lease->job.timeout, LEASE_GRACE_SECONDS);
+    ctx->actions->expired[ctx->actions->expired_count][0] = lease->worker_id;
+    ctx->actions->expired[ctx->actions->expired_count][1] = lease->job.job_id;
+    ctx->actions->expired_count++;
+    
+    // A cópia ainda pode terminar: assume o lease com um prazo novo
+    int hedge_worker = lease->hedge_worker_id;
+    if (drop_copy_locked(ctx->table, lease, lease->worker_id) == 0) {
+        tslog_warn(ctx->table->logger, "Job %d segue com a cópia do worker %d",
+                   lease->job.job_id, hedge_worker);
+        timing_wheel_schedule(&ctx->table->timers, &lease->timer,
+                              (lease->job.timeout + LEASE_GRACE_SECONDS) * 1000L);
+        return;
+    }
+    retry_locked(ctx->table, lease, ctx->actions);
+}
+
+void lease_table_check(lease_table_t *table,
+                       void (*on_expire)(int worker_id, int job_id, void *arg), void *arg) {
+    lease_actions_t actions;
+    memset(&actions, 0, sizeof(actions));
+    expire_ctx_t ctx = {table, &actions};
+    
+    pthread_mutex_lock(&table->mutex);
+    timing_wheel_advance(&table->timers, expire_lease, &ctx);
+    pthread_mutex_unlock(&table->mutex);
+    
+    run_actions(table, &actions, on_expire, arg);
+}
+
+int lease_table_count(lease_table_t *table) {
+    pthread_mutex_lock(&table->mutex);
+    int count = (int)table->leases.size;
+    pthread_mutex_unlock(&table->mutex);
+    return count;
+}
+
+void lease_table_get_hedge_counters(lease_table_t *table, long *hedged, long *won, long *lost,
+                                    long *skipped) {
+    pthread_mutex_lock(&table->mutex);
+    if (hedged) *hedged = table->hedged;
+    if (won) *won = table->hedge_won;
+    if (lost) *lost = table->hedge_lost;
+    if (skipped) *skipped = table->hedge_skipped;
+    pthread_mutex_unlock(&table->mutex);
+}
+
+void lease_table_get_counters(lease_table_t *table, long *requeued, long *dead_lettered) {
+    pthread_mutex_lock(&table->mutex);
+    if (requeued) *requeued = table->requeued;
+    if (dead_lettered) *dead_lettered = table->dead_lettered;
+    pthread_mutex_unlock(&table->mutex);
+}
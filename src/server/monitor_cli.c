@@ -8,6 +8,7 @@
 #include "monitor_cli.h"
 #include "job_queue.h"
 #include "worker_manager.h"
+#include "database.h"
 #include "../../include/tslog.h"
 
 #define INPUT_BUFFER_SIZE 256
@@ -35,13 +36,166 @@ void display_dashboard(monitor_cli_t *mon) {
     worker_manager_list(mon->wm);
     printf("\n");
     
-    printf("⚙️  COMANDOS: list, stats, pause, resume, shutdown, clear, help, quit\n");
+    printf("⚙️  COMANDOS: list, stats, history, job, pause, resume, shutdown, clear, help, quit\n");
     printf("> ");
     fflush(stdout);
     
     pthread_mutex_unlock(&mon->display_mutex);
 }
 
+static void print_snapshot(const char *label, const job_stats_snapshot_t *snap) {
+    printf("%-14s sub: %6ld  ini: %6ld  ok: %6ld  falha: %6ld  média: %.3fs  p50: %.3fs  p99: %.3fs\n",
+           label, snap->submitted, snap->started, snap->completed, snap->failed,
+           job_stats_avg_time(snap), job_stats_percentile(snap, 50), job_stats_percentile(snap, 99));
+}
+
+// Lê apenas os contadores incrementais: não trava a fila nem consulta o SQLite
+void display_stats(monitor_cli_t *mon) {
+    job_stats_t *stats = mon->queue->stats;
+    if (!stats) {
+        printf("Estatísticas indisponíveis\n");
+        return;
+    }
+    
+    job_stats_snapshot_t snap;
+    char label[32];
+    
+    printf("Pendentes: %ld  Em execução: %ld\n",
+           job_stats_pending(stats), job_stats_running(stats));
+    job_queue_t *queue = mon->queue;
+    if (queue->high_watermark || queue->high_bytes) {
+        printf("Admissão: %s  marcas %d/%d jobs, %zu/%zu KB (agora %zu KB)  aceitos %ld, recusados %ld\n",
+               queue->overloaded ? "SOBRECARGA" : "normal",
+               queue->high_watermark, queue->low_watermark,
+               queue->high_bytes / 1024, queue->low_bytes / 1024, job_queue_bytes(queue) / 1024,
+               queue->admitted, queue->rejected);
+    }
+    if (mon->wm && mon->wm->leases) {
+        long requeued, dead_lettered;
+        lease_table_get_counters(mon->wm->leases, &requeued, &dead_lettered);
+        printf("Leases ativos: %d  Reenfileirados: %ld  Dead-letter: %ld\n",
+               lease_table_count(mon->wm->leases), requeued, dead_lettered);
+        if (mon->wm->leases->hedge_percentile > 0) {
+            long hedged, won, lost, skipped;
+            lease_table_get_hedge_counters(mon->wm->leases, &hedged, &won, &lost, &skipped);
+            printf("Cópias especulativas (p%d): lançadas %ld, venceram %ld, perderam %ld, "
+                   "sem orçamento %ld\n", mon->wm->leases->hedge_percentile, hedged, won, lost, skipped);
+        }
+    }
+    if (mon->scheduler) {
+        printf("Agendamentos: %d  Disparos: %ld\n",
+               job_scheduler_count(mon->scheduler), mon->scheduler->fired);
+    }
+    if (mon->graph) {
+        long waiting, released, failed;
+        job_graph_get_counters(mon->graph, &waiting, &released, &failed);
+        printf("Aguardando dependências: %ld  Liberados: %ld  Falhas propagadas: %ld\n",
+               waiting, released, failed);
+    }
+    if (mon->replication && atomic_load(&mon->replication->role) != REPLICATION_OFF) {
+        char repl[128];
+        replication_format_status(mon->replication, repl, sizeof(repl));
+        printf("Replicação: %s\n", repl);
+    }
+    if (mon->notifier) {
+        int subscribers, topics;
+        long published, dropped;
+        notifier_get_counters(mon->notifier, &subscribers, &topics, &published, &dropped);
+        if (subscribers > 0 || published > 0) {
+            printf("Notificações: %d conexões, %d tópicos, %ld enviadas, %ld descartadas (buffer cheio)\n",
+                   subscribers, topics, published, dropped);
+        }
+    }
+    if (mon->acceptors && mon->acceptors->count > 0) {
+        acceptor_stats_t per_cpu[ACCEPTOR_MAX];
+        int count = acceptor_set_get_stats(mon->acceptors, per_cpu, ACCEPTOR_MAX);
+        for (int i = 0; i < count; i++) {
+            if (per_cpu[i].cpu >= 0) {
+                printf("Acceptor %d (CPU %d): ", per_cpu[i].index, per_cpu[i].cpu);
+            } else {
+                printf("Acceptor %d (sem afinidade): ", per_cpu[i].index);
+            }
+            printf("conexões %ld, abertas %d, %.1f accepts/s (último minuto)\n",
+                   per_cpu[i].accepted, per_cpu[i].active, per_cpu[i].rate);
+        }
+    }
+    long met = job_stats_deadline(stats, DEADLINE_MET);
+    long missed = job_stats_deadline(stats, DEADLINE_MISSED);
+    long expired = job_stats_deadline(stats, DEADLINE_EXPIRED);
+    long rejected = job_stats_deadline(stats, DEADLINE_REJECTED);
+    if (met + missed + expired + rejected > 0) {
+        long decided = met + missed + expired;
+        printf("Prazos (%s): cumpridos %ld, perdidos %ld, expirados %ld, recusados %ld (acerto %.1f%%)\n",
+               job_queue_mode_name(mon->queue->mode), met, missed, expired, rejected,
+               decided ? 100.0 * met / decided : 0.0);
+    }
+    printf("\n");
+    
+    job_stats_get_total(stats, &snap);
+    print_snapshot("Total", &snap);
+    
+    const int windows[] = {1, 5, 60};
+    for (int i = 0; i < 3; i++) {
+        job_stats_get_window(stats, windows[i], &snap);
+        snprintf(label, sizeof(label), "Últimos %dmin", windows[i]);
+        print_snapshot(label, &snap);
+    }
+    
+    printf("\nPor prioridade:\n");
+    for (int p = 10; p >= 1; p--) {
+        job_stats_get_priority(stats, p, &snap);
+        if (snap.submitted == 0 && snap.started == 0) continue;
+        snprintf(label, sizeof(label), "Prioridade %d", p);
+        print_snapshot(label, &snap);
+    }
+    
+    printf("\nPor worker:\n");
+    int ids[256];
+    int count = job_stats_list_workers(stats, ids, 256);
+    for (int i = 0; i < count; i++) {
+        job_stats_get_worker(stats, ids[i], &snap);
+        if (snap.started == 0 && snap.completed == 0 && snap.failed == 0) continue;
+        snprintf(label, sizeof(label), "Worker %d", ids[i]);
+        print_snapshot(label, &snap);
+    }
+}
+
+static const char *status_name(int status) {
+    switch (status) {
+        case JOB_PENDING: return "PENDENTE";
+        case JOB_RUNNING: return "EXECUTANDO";
+        case JOB_COMPLETED: return "CONCLUÍDO";
+        case JOB_FAILED: return "FALHOU";
+        case JOB_TIMEOUT: return "TIMEOUT";
+        case JOB_DEAD_LETTER: return "DEAD-LETTER";
+        case JOB_CANCELLED: return "CANCELADO";
+        case JOB_EXPIRED: return "EXPIRADO";
+        default: return "DESCONHECIDO";
+    }
+}
+
+static void print_job_record(const job_record_t *rec, void *arg) {
+    (void)arg;
+    printf("#%-6d %-10s pri: %2d  %s  %.2fs  %.60s\n",
+           rec->job_id, status_name(rec->status), rec->priority,
+           rec->submitted_at, rec->execution_time, rec->script);
+}
+
+static void print_rate_limit(const char *subsystem, int per_second, int sample_every,
+                             long suppressed, void *arg) {
+    (void)arg;
+    printf("%-12s %6d/s  1 em %-5d suprimidas: %ld\n",
+           subsystem, per_second, sample_every, suppressed);
+}
+
+static void print_client(const job_client_stats_t *stats, void *arg) {
+    (void)arg;
+    printf("%-20s peso %-4d pendentes %-6d atendidos %-8ld espera média %6.2fs  máx %6.2fs  próximo %6.2fs%s%s%s\n",
+           stats->client, stats->weight, stats->depth, stats->dequeued,
+           stats->avg_wait, stats->max_wait, stats->head_wait,
+           stats->needs[0] ? "  [" : "", stats->needs, stats->needs[0] ? "]" : "");
+}
+
 // CORRIGIDO: campos consistentes
 void process_command(monitor_cli_t *mon, const char *command) {
     if (strncmp(command, "list", 4) == 0) {
@@ -54,7 +208,61 @@ void process_command(monitor_cli_t *mon, const char *command) {
         
     } else if (strncmp(command, "stats", 5) == 0) {
         printf("\n=== ESTATÍSTICAS ===\n");
-        job_queue_list(mon->queue);
+        display_stats(mon);
+        printf("\nPressione Enter para continuar...");
+        getchar();
+        
+    } else if (strncmp(command, "history", 7) == 0) {
+        int limit = 20;
+        sscanf(command + 7, "%d", &limit);
+        printf("\n=== HISTÓRICO (últimos %d jobs) ===\n", limit);
+        if (database_get_job_history(limit, 0, print_job_record, NULL) <= 0) {
+            printf("Nenhum job no histórico\n");
+        }
+        printf("\nPressione Enter para continuar...");
+        getchar();
+        
+    } else if (strncmp(command, "job ", 4) == 0) {
+        job_record_t rec;
+        int job_id = atoi(command + 4);
+        if (database_get_job(job_id, &rec) == 0) {
+            print_job_record(&rec, NULL);
+            printf("Resultado: %s\n", rec.result);
+        } else {
+            printf("\nJob %d não encontrado\n", job_id);
+        }
+        printf("\nPressione Enter para continuar...");
+        getchar();
+        
+    } else if (strncmp(command, "clients", 7) == 0) {
+        printf("\n=== CLIENTES (envelhecimento: %ds por ponto) ===\n", mon->queue->aging);
+        job_queue_foreach_client(mon->queue, print_client, NULL);
+        printf("\nPressione Enter para continuar...");
+        getchar();
+        
+    } else if (strncmp(command, "weight ", 7) == 0) {
+        char client[JOB_CLIENT_MAX];
+        int weight = 0;
+        if (sscanf(command + 7, "%31s %d", client, &weight) != 2 ||
+            job_queue_set_weight(mon->queue, client, weight) != 0) {
+            printf("\nUso: weight <cliente> <peso 1-%d>\n", JOB_QUEUE_MAX_WEIGHT);
+        } else {
+            printf("\nPeso de %s: %d\n", client, weight);
+        }
+        printf("Pressione Enter para continuar...");
+        getchar();
+        
+    } else if (strncmp(command, "log", 3) == 0) {
+        char subsystem[32];
+        int per_second = 0, sample_every = 1;
+        if (sscanf(command + 3, "%31s %d %d", subsystem, &per_second, &sample_every) >= 2) {
+            if (tslog_set_rate_limit(subsystem, per_second, sample_every) == 0) {
+                tslog_info(mon->logger, "Limite de log de '%s': %d/s, 1 em %d",
+                           subsystem, per_second, sample_every);
+            }
+        }
+        printf("\n=== LIMITES DE LOG (0/s = sem limite) ===\n");
+        tslog_foreach_rate_limit(print_rate_limit, NULL);
         printf("\nPressione Enter para continuar...");
         getchar();
         
@@ -86,6 +294,11 @@ void process_command(monitor_cli_t *mon, const char *command) {
         printf("\n=== AJUDA DOS COMANDOS ===\n");
         printf("list     - Listar jobs e workers\n");
         printf("stats    - Estatísticas\n");
+        printf("history [n] - Últimos n jobs do histórico\n");
+        printf("job <id> - Detalhes de um job\n");
+        printf("clients  - Fila por cliente (profundidade e espera)\n");
+        printf("weight <cliente> <peso> - Peso do cliente na fila justa\n");
+        printf("log [subsistema n/s [1 em k]] - Limites de log por subsistema\n");
         printf("pause    - Pausar sistema\n");
         printf("resume   - Retomar sistema\n");
         printf("shutdown - Desligar sistema\n");
@@ -132,11 +345,36 @@ void* monitor_thread_func(void *arg) {
 }
 
 // CORRIGIDO: assinatura consistente com o .h
+void monitor_cli_attach_scheduler(monitor_cli_t *mon, job_scheduler_t *scheduler) {
+    mon->scheduler = scheduler;
+}
+
+void monitor_cli_attach_graph(monitor_cli_t *mon, job_graph_t *graph) {
+    mon->graph = graph;
+}
+
+void monitor_cli_attach_replication(monitor_cli_t *mon, replication_t *replication) {
+    mon->replication = replication;
+}
+
+void monitor_cli_attach_notifier(monitor_cli_t *mon, notifier_t *notifier) {
+    mon->notifier = notifier;
+}
+
+void monitor_cli_attach_acceptors(monitor_cli_t *mon, acceptor_set_t *acceptors) {
+    mon->acceptors = acceptors;
+}
+
 int monitor_cli_init(monitor_cli_t *mon, job_queue_t *queue, worker_manager_t *wm, tslog_t *logger) {
     if (!mon || !queue || !wm || !logger) return -1;
     
     mon->queue = queue;
     mon->wm = wm;  // CORRIGIDO
+    mon->scheduler = NULL;
+    mon->graph = NULL;
+    mon->replication = NULL;
+    mon->notifier = NULL;
+    mon->acceptors = NULL;
     mon->logger = logger;
     mon->running = 1;
     
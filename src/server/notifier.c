@@ -0,0 +1,414 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include "notifier.h"
+
+int notifier_init(notifier_t *notifier, tslog_t *logger) {
+    if (!notifier) return -1;
+    memset(notifier, 0, sizeof(*notifier));
+    notifier->logger = logger;
+    if (pthread_mutex_init(&notifier->mutex, NULL) != 0) return -1;
+    if (int_map_init(&notifier->topics, 64) != 0) {
+        pthread_mutex_destroy(&notifier->mutex);
+        return -1;
+    }
+    return 0;
+}
+
+static void free_topic_entry(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    notify_topic_t *topic = (notify_topic_t*)value;
+    free(topic->subscribers);
+    free(topic);
+}
+
+// Assinantes já saíram (detach de cada conexão antes de parar o servidor)
+void notifier_destroy(notifier_t *notifier) {
+    if (!notifier) return;
+    pthread_mutex_lock(&notifier->mutex);
+    int_map_foreach(&notifier->topics, free_topic_entry, NULL);
+    int_map_destroy(&notifier->topics);
+    pthread_mutex_unlock(&notifier->mutex);
+    pthread_mutex_destroy(&notifier->mutex);
+}
+
+/* ---- Mensagens ---- */
+
+static void message_release(notify_message_t *msg) {
+    if (msg && atomic_fetch_sub(&msg->refs, 1) == 1) free(msg);
+}
+
+static notify_message_t *message_new(const char *topic, const notify_event_t *event, const char *escaped) {
+    char header[NOTIFY_TOPIC_MAX + 96];
+    int header_len = snprintf(header, sizeof(header), "NOTIFY:%s:%d:%s:%.2f:", topic, event->job_id,
+                              protocol_status_name(event->status), event->exec_time);
+    size_t out_len = strlen(escaped);
+    // A linha inteira cabe no line_reader de quem recebe
+    if ((size_t)header_len + out_len + 1 >= PROTOCOL_LINE_MAX) {
+        out_len = PROTOCOL_LINE_MAX - (size_t)header_len - 2;
+    }
+    notify_message_t *msg = malloc(sizeof(notify_message_t) + (size_t)header_len + out_len + 2);
+    if (!msg) return NULL;
+    atomic_init(&msg->refs, 0);
+    memcpy(msg->line, header, (size_t)header_len);
+    memcpy(msg->line + header_len, escaped, out_len);
+    msg->len = (size_t)header_len + out_len + 1;
+    msg->line[msg->len - 1] = '\n';
+    msg->line[msg->len] = '\0';
+    return msg;
+}
+
+// Com o mutex. Buffer cheio: sai a mais antiga, que a conexão nunca veria a
+// tempo mesmo
+static void enqueue_locked(notifier_t *notifier, notify_subscriber_t *sub, notify_message_t *msg) {
+    if (sub->broken || sub->stopping) {
+        message_release(msg);
+        return;
+    }
+    if (sub->count == NOTIFY_BUFFER) {
+        message_release(sub->buffer[sub->head]);
+        sub->head = (sub->head + 1) % NOTIFY_BUFFER;
+        sub->count--;
+        sub->lost++;
+        notifier->dropped++;
+    }
+    sub->buffer[(sub->head + sub->count) % NOTIFY_BUFFER] = msg;
+    sub->count++;
+    notifier->delivered++;
+    pthread_cond_signal(&sub->ready);
+}
+
+/* ---- Envio ---- */
+
+static int send_iov(int fd, struct iovec *iov, int count) {
+    while (count > 0) {
+        struct msghdr hdr;
+        memset(&hdr, 0, sizeof(hdr));
+        hdr.msg_iov = iov;
+        hdr.msg_iovlen = (size_t)count;
+        ssize_t n = sendmsg(fd, &hdr, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        while (count > 0 && (size_t)n >= iov->iov_len) {
+            n -= (ssize_t)iov->iov_len;
+            iov++;
+            count--;
+        }
+        if (count > 0) {
+            iov->iov_base = (char*)iov->iov_base + n;
+            iov->iov_len -= (size_t)n;
+        }
+    }
+    return 0;
+}
+
+// Esvazia o buffer da conexão em lotes de até NOTIFY_SEND_BATCH linhas
+static void *sender_thread(void *arg) {
+    notify_subscriber_t *sub = (notify_subscriber_t*)arg;
+    notifier_t *notifier = sub->notifier;
+    notify_message_t *batch[NOTIFY_SEND_BATCH];
+    struct iovec iov[NOTIFY_SEND_BATCH + 1];
+    char lost_line[48];
+
+    pthread_mutex_lock(&notifier->mutex);
+    while (1) {
+        while (!sub->stopping && (sub->broken || (sub->count == 0 && sub->lost == 0))) {
+            pthread_cond_wait(&sub->ready, &notifier->mutex);
+        }
+        if (sub->stopping) break;
+
+        int count = 0, iov_count = 0;
+        if (sub->lost > 0) {
+            int len = snprintf(lost_line, sizeof(lost_line), "NOTIFY_LOST:%ld\n", sub->lost);
+            iov[iov_count].iov_base = lost_line;
+            iov[iov_count++].iov_len = (size_t)len;
+            sub->lost = 0;
+        }
+        while (sub->count > 0 && count < NOTIFY_SEND_BATCH) {
+            batch[count] = sub->buffer[sub->head];
+            iov[iov_count].iov_base = batch[count]->line;
+            iov[iov_count++].iov_len = batch[count]->len;
+            count++;
+            sub->head = (sub->head + 1) % NOTIFY_BUFFER;
+            sub->count--;
+        }
+        pthread_mutex_unlock(&notifier->mutex);
+
+        pthread_mutex_lock(&sub->send_mutex);
+        int rc = send_iov(sub->socket, iov, iov_count);
+        pthread_mutex_unlock(&sub->send_mutex);
+        for (int i = 0; i < count; i++) message_release(batch[i]);
+
+        pthread_mutex_lock(&notifier->mutex);
+        if (rc != 0 && !sub->broken) {
+            // A thread da conexão vai ver o socket fechado e chamar detach
+            tslog_warn(notifier->logger, "Envio de notificações falhou: %s", strerror(errno));
+            sub->broken = 1;
+            while (sub->count > 0) {
+                message_release(sub->buffer[sub->head]);
+                sub->head = (sub->head + 1) % NOTIFY_BUFFER;
+                sub->count--;
+            }
+        }
+    }
+    pthread_mutex_unlock(&notifier->mutex);
+    return NULL;
+}
+
+int notifier_reply(notify_subscriber_t *sub, const char *line) {
+    pthread_mutex_lock(&sub->send_mutex);
+    int rc = protocol_send_line(sub->socket, line);
+    pthread_mutex_unlock(&sub->send_mutex);
+    return rc;
+}
+
+/* ---- Assinantes ---- */
+
+notify_subscriber_t *notifier_attach(notifier_t *notifier, int socket) {
+    notify_subscriber_t *sub = calloc(1, sizeof(notify_subscriber_t));
+    if (!sub) return NULL;
+    sub->socket = socket;
+    sub->notifier = notifier;
+    pthread_mutex_init(&sub->send_mutex, NULL);
+    pthread_cond_init(&sub->ready, NULL);
+    if (pthread_create(&sub->thread, NULL, sender_thread, sub) != 0) {
+        pthread_mutex_destroy(&sub->send_mutex);
+        pthread_cond_destroy(&sub->ready);
+        free(sub);
+        return NULL;
+    }
+    pthread_mutex_lock(&notifier->mutex);
+    notifier->subscribers++;
+    pthread_mutex_unlock(&notifier->mutex);
+    return sub;
+}
+
+static notify_topic_t *find_topic_locked(notifier_t *notifier, const char *name, int create) {
+    int key = int_map_string_key(name);
+    notify_topic_t *topic;
+    while ((topic = int_map_get(&notifier->topics, key)) != NULL) {
+        if (strcmp(topic->name, name) == 0) return topic;
+        key = (key + 1) & 0x7fffffff;
+    }
+    if (!create) return NULL;
+
+    topic = calloc(1, sizeof(notify_topic_t));
+    if (!topic) return NULL;
+    snprintf(topic->name, sizeof(topic->name), "%s", name);
+    topic->map_key = key;
+    if (int_map_put(&notifier->topics, key, topic) != 0) {
+        free(topic);
+        return NULL;
+    }
+    return topic;
+}
+
+// Remove por troca com o último (ordem não importa)
+static void remove_ptr(void **array, int *count, const void *value) {
+    for (int i = 0; i < *count; i++) {
+        if (array[i] == value) {
+            array[i] = array[--*count];
+            return;
+        }
+    }
+}
+
+// Tópico sem assinantes sai do mapa. As chaves de quem colidiu com ele
+// foram sondadas a partir da dele: reinserir o resto da sequência mantém
+// todos acháveis.
+static void drop_topic_locked(notifier_t *notifier, notify_topic_t *topic) {
+    int key = topic->map_key;
+    int_map_remove(&notifier->topics, key);
+    free(topic->subscribers);
+    free(topic);
+
+    notify_topic_t *next;
+    while ((next = int_map_remove(&notifier->topics, key = (key + 1) & 0x7fffffff)) != NULL) {
+        int home = int_map_string_key(next->name);
+        while (int_map_get(&notifier->topics, home)) home = (home + 1) & 0x7fffffff;
+        next->map_key = home;
+        int_map_put(&notifier->topics, home, next);
+    }
+}
+
+static void leave_topic_locked(notifier_t *notifier, notify_subscriber_t *sub, notify_topic_t *topic) {
+    remove_ptr((void**)topic->subscribers, &topic->count, sub);
+    remove_ptr((void**)sub->topics, &sub->topic_count, topic);
+    if (topic->count == 0) drop_topic_locked(notifier, topic);
+}
+
+void notifier_detach(notifier_t *notifier, notify_subscriber_t *sub) {
+    if (!sub) return;
+    pthread_mutex_lock(&notifier->mutex);
+    while (sub->topic_count > 0) {
+        leave_topic_locked(notifier, sub, sub->topics[sub->topic_count - 1]);
+    }
+    sub->stopping = 1;
+    pthread_cond_signal(&sub->ready);
+    notifier->subscribers--;
+    pthread_mutex_unlock(&notifier->mutex);
+
+    pthread_join(sub->thread, NULL);
+    while (sub->count > 0) {
+        message_release(sub->buffer[sub->head]);
+        sub->head = (sub->head + 1) % NOTIFY_BUFFER;
+        sub->count--;
+    }
+    free(sub->topics);
+    pthread_mutex_destroy(&sub->send_mutex);
+    pthread_cond_destroy(&sub->ready);
+    free(sub);
+}
+
+int notifier_parse_topic(const char *spec, char *topic, size_t size) {
+    const char *value = strchr(spec, '=');
+    if (!value || !value[1] || strchr(value, ':') || strchr(value, ',')) return -1;
+    value++;
+
+    int written;
+    if (strncmp(spec, "job=", 4) == 0) {
+        char *end;
+        long id = strtol(value, &end, 10);
+        if (*end || id <= 0 || id > 0x7fffffff) return -1;
+        written = snprintf(topic, size, "job=%ld", id);
+    } else if (strncmp(spec, "batch=", 6) == 0 && strlen(value) < JOB_CLIENT_MAX) {
+        written = snprintf(topic, size, "batch=%s", value);
+    } else if (strncmp(spec, "tag=", 4) == 0 && strlen(value) < NOTIFY_TOPIC_MAX - 4) {
+        written = snprintf(topic, size, "tag=%s", value);
+    } else {
+        return -1;
+    }
+    return written > 0 && (size_t)written < size ? 0 : -1;
+}
+
+static int push_ptr(void ***array, int *count, int *capacity, void *value) {
+    if (*count == *capacity) {
+        int grown_capacity = *capacity ? *capacity * 2 : 4;
+        void **grown = realloc(*array, (size_t)grown_capacity * sizeof(void*));
+        if (!grown) return -1;
+        *array = grown;
+        *capacity = grown_capacity;
+    }
+    (*array)[(*count)++] = value;
+    return 0;
+}
+
+int notifier_subscribe(notifier_t *notifier, notify_subscriber_t *sub, const char *name) {
+    pthread_mutex_lock(&notifier->mutex);
+    for (int i = 0; i < sub->topic_count; i++) {
+        if (strcmp(sub->topics[i]->name, name) == 0) {
+            pthread_mutex_unlock(&notifier->mutex);
+            return 0;
+        }
+    }
+    int rc = -1;
+    notify_topic_t *topic = NULL;
+    if (sub->topic_count < NOTIFY_TOPICS_PER_CONN && (topic = find_topic_locked(notifier, name, 1)) != NULL) {
+        if (push_ptr((void***)&topic->subscribers, &topic->count, &topic->capacity, sub) == 0) {
+            if (push_ptr((void***)&sub->topics, &sub->topic_count, &sub->topic_capacity, topic) == 0) {
+                rc = 0;
+            } else {
+                topic->count--;
+            }
+        }
+        if (topic->count == 0) drop_topic_locked(notifier, topic);
+    }
+    pthread_mutex_unlock(&notifier->mutex);
+    return rc;
+}
+
+int notifier_unsubscribe(notifier_t *notifier, notify_subscriber_t *sub, const char *name) {
+    pthread_mutex_lock(&notifier->mutex);
+    for (int i = 0; i < sub->topic_count; i++) {
+        if (strcmp(sub->topics[i]->name, name) == 0) {
+            leave_topic_locked(notifier, sub, sub->topics[i]);
+            pthread_mutex_unlock(&notifier->mutex);
+            return 0;
+        }
+    }
+    pthread_mutex_unlock(&notifier->mutex);
+    return -1;
+}
+
+/* ---- Publicação ---- */
+
+// Com o mutex: uma mensagem para todos os assinantes do tópico
+static void publish_topic_locked(notifier_t *notifier, notify_topic_t *topic, const notify_event_t *event,
+                                 const char *escaped) {
+    notify_message_t *msg = message_new(topic->name, event, escaped);
+    if (!msg) {
+        tslog_warn(notifier->logger, "Sem memória para notificar %s", topic->name);
+        return;
+    }
+    atomic_store(&msg->refs, topic->count);
+    notifier->published++;
+    for (int i = 0; i < topic->count; i++) {
+        enqueue_locked(notifier, topic->subscribers[i], msg);
+    }
+}
+
+void notifier_publish(notifier_t *notifier, const notify_event_t *event) {
+    // Nomes dos tópicos e a saída escapada antes de travar
+    char names[2 + JOB_NEEDS_MAX / 2][NOTIFY_TOPIC_MAX];
+    int count = 0;
+    snprintf(names[count++], NOTIFY_TOPIC_MAX, "job=%d", event->job_id);
+    if (event->batch && event->batch[0]) {
+        snprintf(names[count++], NOTIFY_TOPIC_MAX, "batch=%s", event->batch);
+    }
+    for (const char *p = event->tags ? event->tags : ""; *p && count < (int)(sizeof(names) / sizeof(names[0])); ) {
+        size_t len = strcspn(p, ",");
+        if (len > 0) snprintf(names[count++], NOTIFY_TOPIC_MAX, "tag=%.*s", (int)len, p);
+        p += len;
+        if (*p == ',') p++;
+    }
+    char escaped[MAX_RESULT_SIZE * 2];
+    protocol_escape(event->output ? event->output : "", escaped, sizeof(escaped));
+
+    pthread_mutex_lock(&notifier->mutex);
+    if (notifier->subscribers == 0) {
+        pthread_mutex_unlock(&notifier->mutex);
+        return;
+    }
+    for (int i = 0; i < count; i++) {
+        notify_topic_t *topic = find_topic_locked(notifier, names[i], 0);
+        if (!topic) continue;
+        publish_topic_locked(notifier, topic, event, escaped);
+        // O job não termina de novo: a assinatura acaba aqui
+        if (i == 0) {
+            while (topic->count > 0) {
+                notify_subscriber_t *sub = topic->subscribers[topic->count - 1];
+                topic->count--;
+                remove_ptr((void**)sub->topics, &sub->topic_count, topic);
+            }
+            drop_topic_locked(notifier, topic);
+        }
+    }
+    pthread_mutex_unlock(&notifier->mutex);
+}
+
+void notifier_deliver(notifier_t *notifier, notify_subscriber_t *sub, const char *topic,
+                      const notify_event_t *event) {
+    char escaped[MAX_RESULT_SIZE * 2];
+    protocol_escape(event->output ? event->output : "", escaped, sizeof(escaped));
+    notify_message_t *msg = message_new(topic, event, escaped);
+    if (!msg) return;
+    atomic_store(&msg->refs, 1);
+
+    pthread_mutex_lock(&notifier->mutex);
+    notifier->published++;
+    enqueue_locked(notifier, sub, msg);
+    pthread_mutex_unlock(&notifier->mutex);
+}
+
+void notifier_get_counters(notifier_t *notifier, int *subscribers, int *topics,
+                           long *published, long *dropped) {
+    pthread_mutex_lock(&notifier->mutex);
+    if (subscribers) *subscribers = notifier->subscribers;
+    if (topics) *topics = (int)notifier->topics.size;
+    if (published) *published = notifier->published;
+    if (dropped) *dropped = notifier->dropped;
+    pthread_mutex_unlock(&notifier->mutex);
+}
@@ -0,0 +1,644 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <errno.h>
+#include <poll.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include "replication.h"
+#include "database.h"
+#include "shard_ring.h"
+
+static long now_ms(void) {
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    return (long)ts.tv_sec * 1000 + ts.tv_nsec / 1000000;
+}
+
+static void free_live(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    replication_live_t *live = (replication_live_t*)value;
+    free(live->body);
+    free(live);
+}
+
+static void free_replica(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    free(value);
+}
+
+int replication_init(replication_t *repl, job_queue_t *queue, job_index_t *index,
+                     idempotency_t *idem, tslog_t *logger) {
+    if (!repl) return -1;
+    memset(repl, 0, sizeof(*repl));
+    atomic_init(&repl->role, REPLICATION_OFF);
+    repl->queue = queue;
+    repl->index = index;
+    repl->idem = idem;
+    repl->logger = logger;
+    repl->failover_timeout = REPLICATION_DEFAULT_FAILOVER;
+
+    if (int_map_init(&repl->live, 1024) != 0) return -1;
+    if (int_map_init(&repl->replicas, 1024) != 0) {
+        int_map_destroy(&repl->live);
+        return -1;
+    }
+    pthread_mutex_init(&repl->mutex, NULL);
+    pthread_cond_init(&repl->appended, NULL);
+    return 0;
+}
+
+void replication_destroy(replication_t *repl) {
+    if (!repl) return;
+    pthread_mutex_lock(&repl->mutex);
+    if (repl->ring) {
+        for (int i = 0; i < REPLICATION_LOG_SIZE; i++) {
+            free(repl->ring[i].body);
+        }
+        free(repl->ring);
+        repl->ring = NULL;
+    }
+    int_map_foreach(&repl->live, free_live, NULL);
+    int_map_destroy(&repl->live);
+    int_map_foreach(&repl->replicas, free_replica, NULL);
+    int_map_destroy(&repl->replicas);
+    pthread_mutex_unlock(&repl->mutex);
+    pthread_mutex_destroy(&repl->mutex);
+    pthread_cond_destroy(&repl->appended);
+}
+
+// Liga o log (primário, ou standby no momento da promoção)
+static int start_logging(replication_t *repl) {
+    pthread_mutex_lock(&repl->mutex);
+    if (!repl->ring) {
+        repl->ring = calloc(REPLICATION_LOG_SIZE, sizeof(replication_slot_t));
+    }
+    repl->logging = repl->ring != NULL;
+    pthread_mutex_unlock(&repl->mutex);
+    return repl->ring ? 0 : -1;
+}
+
+void replication_enable(replication_t *repl) {
+    if (start_logging(repl) != 0) {
+        tslog_error(repl->logger, "Sem memória para o log de replicação");
+        return;
+    }
+    atomic_store(&repl->role, REPLICATION_PRIMARY);
+    tslog_info(repl->logger, "Replicação ligada: log de %d registros para standbys", REPLICATION_LOG_SIZE);
+}
+
+int replication_set_standby(replication_t *repl, const char *primary, int failover_timeout) {
+    const char *colon = primary ? strrchr(primary, ':') : NULL;
+    if (!colon || colon == primary || (size_t)(colon - primary) >= sizeof(repl->primary_host)) return -1;
+    snprintf(repl->primary_host, sizeof(repl->primary_host), "%.*s", (int)(colon - primary), primary);
+    repl->primary_port = atoi(colon + 1);
+    if (repl->primary_port <= 0 || repl->primary_port > 65535) return -1;
+    if (failover_timeout > 0) repl->failover_timeout = failover_timeout;
+    atomic_store(&repl->role, REPLICATION_STANDBY);
+    return 0;
+}
+
+int replication_is_standby(replication_t *repl) {
+    return atomic_load(&repl->role) == REPLICATION_STANDBY;
+}
+
+/* ---- Primário: log ---- */
+
+// Guarda o registro no anel e acorda os standbys. Chamar com o mutex.
+static void append_locked(replication_t *repl, char *body) {
+    long seq = ++repl->head;
+    replication_slot_t *slot = &repl->ring[seq % REPLICATION_LOG_SIZE];
+    free(slot->body);
+    slot->seq = seq;
+    slot->ts_ms = now_ms();
+    slot->body = body;
+    pthread_cond_broadcast(&repl->appended);
+}
+
+static char *format_enqueue(const job_t *job) {
+    char escaped[MAX_SCRIPT_SIZE * 2];
+    protocol_escape(job->script, escaped, sizeof(escaped));
+
+    char line[PROTOCOL_LINE_MAX];
+    snprintf(line, sizeof(line), "E:%d:%d:%d:%d:%ld:%ld:%d:%s:%s:%s", job->job_id, job->priority,
+             job->timeout, job->attempts, (long)job->submitted_at, (long)job->deadline, job->no_hedge,
+             job->client[0] ? job->client : "-", job->needs[0] ? job->needs : "-", escaped);
+    return strdup(line);
+}
+
+void replication_log_enqueue(replication_t *repl, const job_t *job) {
+    if (!repl || !repl->logging) return;
+    // Formatado fora da trava do log; a do chamador (fila) garante a ordem
+    char *body = format_enqueue(job);
+    replication_live_t *live = malloc(sizeof(replication_live_t));
+    char *copy = body ? strdup(body) : NULL;
+    if (!body || !live || !copy) {
+        free(body);
+        free(live);
+        free(copy);
+        tslog_error(repl->logger, "Sem memória: job %d fora do log de replicação", job->job_id);
+        return;
+    }
+    live->body = copy;
+    live->status = JOB_PENDING;
+    live->worker_id = 0;
+    live->attempts = job->attempts;
+
+    pthread_mutex_lock(&repl->mutex);
+    replication_live_t *old = int_map_get(&repl->live, job->job_id);
+    if (int_map_put(&repl->live, job->job_id, live) != 0) {
+        free(live->body);
+        free(live);
+    } else if (old) {
+        free_live(0, old, NULL);
+    }
+    append_locked(repl, body);
+    pthread_mutex_unlock(&repl->mutex);
+}
+
+void replication_log_status(replication_t *repl, int job_id, job_status_t status, int worker_id, int attempts) {
+    if (!repl || !repl->logging) return;
+    char line[64];
+    snprintf(line, sizeof(line), "S:%d:%d:%d:%d", job_id, (int)status, worker_id, attempts);
+    char *body = strdup(line);
+    if (!body) return;
+
+    replication_live_t *finished = NULL;
+    pthread_mutex_lock(&repl->mutex);
+    replication_live_t *live = int_map_get(&repl->live, job_id);
+    if (live && job_index_is_final(status)) {
+        finished = int_map_remove(&repl->live, job_id);
+    } else if (live) {
+        live->status = status;
+        live->worker_id = worker_id;
+        if (attempts >= 0) live->attempts = attempts;
+    }
+    append_locked(repl, body);
+    pthread_mutex_unlock(&repl->mutex);
+
+    if (finished) free_live(0, finished, NULL);
+}
+
+void replication_log_key(replication_t *repl, const char *key, idempotency_kind_t kind, int id, time_t first_run) {
+    if (!repl || !repl->logging || !key || !key[0]) return;
+    char line[JOB_KEY_MAX + 64];
+    snprintf(line, sizeof(line), "K:%d:%d:%ld:%s", (int)kind, id, (long)first_run, key);
+    char *body = strdup(line);
+    if (!body) return;
+
+    pthread_mutex_lock(&repl->mutex);
+    append_locked(repl, body);
+    pthread_mutex_unlock(&repl->mutex);
+}
+
+/* ---- Primário: envio ---- */
+
+static int send_all(int sock, const char *data, size_t len) {
+    size_t sent = 0;
+    while (sent < len) {
+        ssize_t n = send(sock, data + sent, len - sent, MSG_NOSIGNAL);
+        if (n < 0 && errno == EINTR) continue;
+        if (n <= 0) return -1;
+        sent += (size_t)n;
+    }
+    return 0;
+}
+
+// Buffer de envio que cresce conforme as linhas
+typedef struct {
+    char *data;
+    size_t len;
+    size_t capacity;
+    long seq;
+    long ts_ms;
+} out_buffer_t;
+
+static int out_reserve(out_buffer_t *out, size_t need) {
+    if (out->len + need <= out->capacity) return 0;
+    size_t capacity = out->capacity ? out->capacity * 2 : 64 * 1024;
+    while (capacity < out->len + need) capacity *= 2;
+    char *grown = realloc(out->data, capacity);
+    if (!grown) return -1;
+    out->data = grown;
+    out->capacity = capacity;
+    return 0;
+}
+
+static int out_append(out_buffer_t *out, long seq, long ts_ms, const char *body) {
+    if (out_reserve(out, strlen(body) + 48) != 0) return -1;
+    out->len += (size_t)snprintf(out->data + out->len, out->capacity - out->len,
+                                 "R:%ld:%ld:%s\n", seq, ts_ms, body);
+    return 0;
+}
+
+static void snapshot_live(int key, void *value, void *arg) {
+    (void)key;
+    replication_live_t *live = (replication_live_t*)value;
+    out_buffer_t *out = (out_buffer_t*)arg;
+    char status[64];
+    snprintf(status, sizeof(status), "S:%d:%d:%d:%d", key, (int)live->status, live->worker_id, live->attempts);
+    out_append(out, out->seq, out->ts_ms, live->body);
+    out_append(out, out->seq, out->ts_ms, status);
+}
+
+static replication_peer_t *peer_add(replication_t *repl, const char *name) {
+    replication_peer_t *peer = NULL;
+    pthread_mutex_lock(&repl->mutex);
+    for (int i = 0; i < REPLICATION_MAX_PEERS && !peer; i++) {
+        if (!repl->peers[i].active) {
+            peer = &repl->peers[i];
+            peer->active = 1;
+            peer->acked = 0;
+            snprintf(peer->peer, sizeof(peer->peer), "%s", name);
+        }
+    }
+    pthread_mutex_unlock(&repl->mutex);
+    return peer;
+}
+
+void replication_serve(replication_t *repl, int sock, line_reader_t *reader, long from, const char *name) {
+    if (atomic_load(&repl->role) != REPLICATION_PRIMARY) {
+        protocol_send_line(sock, atomic_load(&repl->role) == REPLICATION_STANDBY
+                                 ? REPLICATION_NOT_PRIMARY : "ERROR:replicação desligada (--replication)");
+        return;
+    }
+    replication_peer_t *peer = peer_add(repl, name);
+    if (!peer) {
+        protocol_send_line(sock, "ERROR:standbys demais");
+        return;
+    }
+
+    out_buffer_t out = {NULL, 0, 0, 0, 0};
+    long next;
+
+    // Sem histórico suficiente: foto dos jobs vivos no seq atual
+    pthread_mutex_lock(&repl->mutex);
+    long oldest = repl->head - REPLICATION_LOG_SIZE + 1;
+    if (from <= 0 || from < oldest || from > repl->head + 1) {
+        out.seq = repl->head;
+        out.ts_ms = now_ms();
+        if (out_reserve(&out, 32) == 0) {
+            out.len = (size_t)snprintf(out.data, out.capacity, "RESYNC:%ld\n", out.seq);
+        }
+        int_map_foreach(&repl->live, snapshot_live, &out);
+        next = repl->head + 1;
+        tslog_info(repl->logger, "Standby %s: ressincronização com %zu jobs vivos (seq %ld)",
+                   name, repl->live.size, out.seq);
+    } else {
+        next = from;
+        tslog_info(repl->logger, "Standby %s: retomando do seq %ld", name, from);
+    }
+    pthread_mutex_unlock(&repl->mutex);
+
+    while (1) {
+        if (out.len > 0) {
+            if (send_all(sock, out.data, out.len) != 0) break;
+            out.len = 0;
+        }
+
+        // ACKs do standby, sem bloquear
+        struct pollfd pfd = {sock, POLLIN, 0};
+        int closed = 0;
+        while (poll(&pfd, 1, 0) > 0) {
+            char line[128];
+            if (line_reader_next(reader, sock, line, sizeof(line)) < 0) {
+                closed = 1;
+                break;
+            }
+            long acked;
+            if (sscanf(line, "ACK:%ld", &acked) == 1) {
+                pthread_mutex_lock(&repl->mutex);
+                peer->acked = acked;
+                pthread_mutex_unlock(&repl->mutex);
+            }
+        }
+        if (closed) break;
+
+        pthread_mutex_lock(&repl->mutex);
+        if (next > repl->head) {
+            struct timespec deadline;
+            clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_nsec += (long)REPLICATION_HEARTBEAT_MS * 1000000L;
+            deadline.tv_sec += deadline.tv_nsec / 1000000000L;
+            deadline.tv_nsec %= 1000000000L;
+            pthread_cond_timedwait(&repl->appended, &repl->mutex, &deadline);
+        }
+        if (next < repl->head - REPLICATION_LOG_SIZE + 1) {
+            // Ficou para trás do anel: o standby reconecta e ressincroniza
+            pthread_mutex_unlock(&repl->mutex);
+            tslog_warn(repl->logger, "Standby %s atrasado além do log: desconectando", name);
+            break;
+        }
+        int copied = 0;
+        for (; next <= repl->head && copied < REPLICATION_BATCH; next++, copied++) {
+            replication_slot_t *slot = &repl->ring[next % REPLICATION_LOG_SIZE];
+            if (out_append(&out, slot->seq, slot->ts_ms, slot->body) != 0) break;
+        }
+        if (copied == 0) {
+            out_append(&out, repl->head, now_ms(), "H");
+        }
+        pthread_mutex_unlock(&repl->mutex);
+    }
+
+    pthread_mutex_lock(&repl->mutex);
+    peer->active = 0;
+    pthread_mutex_unlock(&repl->mutex);
+    free(out.data);
+    tslog_warn(repl->logger, "Standby %s desconectado", name);
+}
+
+/* ---- Standby: aplicação ---- */
+
+static int next_field(char **cursor, char *out, size_t size) {
+    char *colon = strchr(*cursor, ':');
+    if (!colon) return -1;
+    snprintf(out, size, "%.*s", (int)(colon - *cursor), *cursor);
+    if (strcmp(out, "-") == 0) out[0] = '\0';
+    *cursor = colon + 1;
+    return 0;
+}
+
+static int parse_enqueue(const char *body, job_t *job) {
+    memset(job, 0, sizeof(*job));
+    long submitted, deadline;
+    int offset = 0;
+    if (sscanf(body, "E:%d:%d:%d:%d:%ld:%ld:%d:%n", &job->job_id, &job->priority, &job->timeout,
+               &job->attempts, &submitted, &deadline, &job->no_hedge, &offset) != 7 || offset == 0) {
+        return -1;
+    }
+    job->submitted_at = (time_t)submitted;
+    job->deadline = (time_t)deadline;
+
+    char *cursor = (char*)body + offset;
+    if (next_field(&cursor, job->client, sizeof(job->client)) != 0 ||
+        next_field(&cursor, job->needs, sizeof(job->needs)) != 0) {
+        return -1;
+    }
+    char script[MAX_SCRIPT_SIZE * 2];
+    snprintf(script, sizeof(script), "%s", cursor);
+    protocol_unescape(script);
+    size_t len = strlen(script);
+    if (len >= sizeof(job->script)) return -1;
+    memcpy(job->script, script, len + 1);
+    job->status = JOB_PENDING;
+    return 0;
+}
+
+static void apply_enqueue(replication_t *repl, const char *body) {
+    job_t job;
+    if (parse_enqueue(body, &job) != 0) {
+        tslog_warn(repl->logger, "Registro de replicação inválido: %.60s", body);
+        return;
+    }
+
+    pthread_mutex_lock(&repl->mutex);
+    replication_replica_t *replica = int_map_get(&repl->replicas, job.job_id);
+    int is_new = replica == NULL;
+    if (is_new && (replica = malloc(sizeof(replication_replica_t))) != NULL &&
+        int_map_put(&repl->replicas, job.job_id, replica) != 0) {
+        free(replica);
+        replica = NULL;
+    }
+    if (replica) {
+        replica->job = job;
+        replica->running = 0;
+    }
+    if (job.job_id > repl->max_job_id) repl->max_job_id = job.job_id;
+    pthread_mutex_unlock(&repl->mutex);
+
+    job_index_track(repl->index, &job, JOB_PENDING);
+    if (is_new) {
+        database_save_job(&job);
+    }
+}
+
+static void apply_status(replication_t *repl, const char *body) {
+    int job_id, status, worker_id, attempts;
+    if (sscanf(body, "S:%d:%d:%d:%d", &job_id, &status, &worker_id, &attempts) != 4) return;
+
+    int known = 0;
+    pthread_mutex_lock(&repl->mutex);
+    replication_replica_t *replica = int_map_get(&repl->replicas, job_id);
+    if (replica) {
+        known = 1;
+        if (job_index_is_final((job_status_t)status)) {
+            int_map_remove(&repl->replicas, job_id);
+            free(replica);
+        } else {
+            replica->running = status == JOB_RUNNING;
+            replica->job.assigned_worker = worker_id;
+            if (attempts >= 0) replica->job.attempts = attempts;
+        }
+    }
+    pthread_mutex_unlock(&repl->mutex);
+
+    job_index_update(repl->index, job_id, (job_status_t)status, worker_id, attempts);
+    if (known && job_index_is_final((job_status_t)status)) {
+        database_update_job_status(job_id, (job_status_t)status, attempts, "replicado do primário");
+    }
+}
+
+static void apply_key(replication_t *repl, const char *body) {
+    int kind, id, offset = 0;
+    long first_run;
+    if (sscanf(body, "K:%d:%d:%ld:%n", &kind, &id, &first_run, &offset) != 3 || offset == 0) return;
+    const char *key = body + offset;
+    if (idempotency_claim(repl->idem, key, NULL) == 0) {
+        idempotency_commit(repl->idem, key, (idempotency_kind_t)kind, id, (time_t)first_run);
+    }
+}
+
+// "R:<seq>:<ms>:<registro>"; retorna -1 se a linha não é um registro
+static int apply_record(replication_t *repl, const char *line, int resyncing) {
+    long seq, ts_ms;
+    int offset = 0;
+    if (sscanf(line, "R:%ld:%ld:%n", &seq, &ts_ms, &offset) != 2 || offset == 0) return -1;
+    const char *body = line + offset;
+
+    switch (body[0]) {
+    case 'E': apply_enqueue(repl, body); break;
+    case 'S': apply_status(repl, body); break;
+    case 'K': apply_key(repl, body); break;
+    default: break;     // H: só o seq do primário
+    }
+
+    pthread_mutex_lock(&repl->mutex);
+    if (seq > repl->primary_head) repl->primary_head = seq;
+    if (body[0] != 'H' && !resyncing) {
+        repl->applied = seq;
+        repl->applied_ts_ms = ts_ms;
+        repl->applied_total++;
+    } else if (body[0] == 'H' && repl->applied >= seq) {
+        repl->applied_ts_ms = ts_ms;
+    }
+    repl->last_contact = time(NULL);
+    pthread_mutex_unlock(&repl->mutex);
+    return 0;
+}
+
+// RESYNC: esquece os jobs vivos e recebe a foto do primário
+static void clear_replicas(replication_t *repl, long seq) {
+    pthread_mutex_lock(&repl->mutex);
+    int_map_foreach(&repl->replicas, free_replica, NULL);
+    int_map_destroy(&repl->replicas);
+    int_map_init(&repl->replicas, 1024);
+    repl->applied = seq;
+    repl->applied_ts_ms = now_ms();
+    repl->resyncs++;
+    pthread_mutex_unlock(&repl->mutex);
+}
+
+typedef struct {
+    job_t *jobs;
+    int count;
+    int running;
+} promote_ctx_t;
+
+static void collect_replica(int key, void *value, void *arg) {
+    (void)key;
+    replication_replica_t *replica = (replication_replica_t*)value;
+    promote_ctx_t *ctx = (promote_ctx_t*)arg;
+    ctx->jobs[ctx->count] = replica->job;
+    ctx->jobs[ctx->count].assigned_worker = 0;
+    ctx->jobs[ctx->count].status = JOB_PENDING;
+    ctx->count++;
+    if (replica->running) ctx->running++;
+    free(replica);
+}
+
+// O primário sumiu: os jobs vivos entram na fila deste servidor
+static void promote(replication_t *repl) {
+    start_logging(repl);
+
+    pthread_mutex_lock(&repl->mutex);
+    promote_ctx_t ctx = {malloc((repl->replicas.size + 1) * sizeof(job_t)), 0, 0};
+    if (ctx.jobs) {
+        int_map_foreach(&repl->replicas, collect_replica, &ctx);
+    } else {
+        int_map_foreach(&repl->replicas, free_replica, NULL);
+    }
+    int_map_destroy(&repl->replicas);
+    int_map_init(&repl->replicas, 16);
+    int max_job_id = repl->max_job_id;
+    long applied = repl->applied;
+    pthread_mutex_unlock(&repl->mutex);
+
+    job_queue_set_next_id(repl->queue, max_job_id + 1);
+    atomic_store(&repl->role, REPLICATION_PRIMARY);
+    for (int i = 0; i < ctx.count; i++) {
+        job_queue_push_reserved(repl->queue, &ctx.jobs[i], 0);
+    }
+    free(ctx.jobs);
+
+    tslog_warn(repl->logger, "Primário %s:%d sem resposta há %ds: standby promovido no seq %ld "
+               "(%d jobs na fila, %d estavam em execução)", repl->primary_host, repl->primary_port,
+               repl->failover_timeout, applied, ctx.count, ctx.running);
+}
+
+static int primary_lost(replication_t *repl) {
+    pthread_mutex_lock(&repl->mutex);
+    // Nunca falou com o primário: não assume (ele pode só não ter subido ainda)
+    int lost = repl->last_contact > 0 && time(NULL) - repl->last_contact >= repl->failover_timeout;
+    pthread_mutex_unlock(&repl->mutex);
+    return lost;
+}
+
+void* replication_follow_thread(void *arg) {
+    replication_t *repl = (replication_t*)arg;
+    shard_t primary;
+    memset(&primary, 0, sizeof(primary));
+    snprintf(primary.host, sizeof(primary.host), "%s", repl->primary_host);
+    primary.port = repl->primary_port;
+    tslog_info(repl->logger, "Standby de %s:%d (failover em %ds)", primary.host, primary.port,
+               repl->failover_timeout);
+
+    while (replication_is_standby(repl)) {
+        int sock = shard_connect(&primary);
+        if (sock < 0) {
+            if (primary_lost(repl)) break;
+            usleep(REPLICATION_HEARTBEAT_MS * 1000);
+            continue;
+        }
+        struct timeval tv = {0, REPLICATION_HEARTBEAT_MS * 1000};
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+        pthread_mutex_lock(&repl->mutex);
+        long from = repl->applied > 0 ? repl->applied + 1 : 0;
+        pthread_mutex_unlock(&repl->mutex);
+        char line[PROTOCOL_LINE_MAX];
+        snprintf(line, sizeof(line), "REPLICATE:%ld", from);
+        if (protocol_send_line(sock, line) != 0) {
+            close(sock);
+            continue;
+        }
+
+        line_reader_t reader;
+        line_reader_init(&reader);
+        long last_ack = 0;
+        long resync_seq = -1;      // >= 0 enquanto chegam as linhas da foto
+        while (1) {
+            errno = 0;      // conexão fechada não mexe em errno
+            ssize_t n = line_reader_next(&reader, sock, line, sizeof(line));
+            if (n < 0) {
+                if ((errno == EAGAIN || errno == EWOULDBLOCK) && !primary_lost(repl)) continue;
+                break;
+            }
+            if (strncmp(line, "RESYNC:", 7) == 0) {
+                resync_seq = atol(line + 7);
+                clear_replicas(repl, resync_seq);
+                tslog_info(repl->logger, "Ressincronizando com o primário (seq %ld)", resync_seq);
+            } else if (strncmp(line, "ERROR:", 6) == 0) {
+                tslog_error(repl->logger, "Primário recusou a replicação: %s", line);
+                break;
+            } else if (line[0] == 'R') {
+                // A foto chega toda com o seq do RESYNC; o fluxo vem depois
+                long seq = atol(line + 2);
+                if (resync_seq >= 0 && seq > resync_seq) resync_seq = -1;
+                apply_record(repl, line, resync_seq >= 0);
+            }
+
+            long ms = now_ms();
+            if (ms - last_ack >= REPLICATION_ACK_MS) {
+                pthread_mutex_lock(&repl->mutex);
+                long applied = repl->applied;
+                pthread_mutex_unlock(&repl->mutex);
+                snprintf(line, sizeof(line), "ACK:%ld", applied);
+                if (protocol_send_line(sock, line) != 0) break;
+                last_ack = ms;
+            }
+        }
+        close(sock);
+        tslog_warn(repl->logger, "Conexão de replicação com %s:%d perdida", primary.host, primary.port);
+        if (primary_lost(repl)) break;
+        usleep(REPLICATION_HEARTBEAT_MS * 1000);
+    }
+
+    if (replication_is_standby(repl)) {
+        promote(repl);
+    }
+    return NULL;
+}
+
+void replication_format_status(replication_t *repl, char *buffer, size_t size) {
+    int role = atomic_load(&repl->role);
+    pthread_mutex_lock(&repl->mutex);
+    if (role == REPLICATION_STANDBY) {
+        long lag = repl->primary_head - repl->applied;
+        long lag_ms = lag > 0 ? now_ms() - repl->applied_ts_ms : 0;
+        snprintf(buffer, size, "REPL:STANDBY:%ld:%ld:%ld:%s:%d", repl->applied, lag > 0 ? lag : 0,
+                 lag_ms > 0 ? lag_ms : 0, repl->primary_host, repl->primary_port);
+    } else {
+        // Atraso do standby mais atrasado
+        int peers = 0;
+        long lag = 0;
+        for (int i = 0; i < REPLICATION_MAX_PEERS; i++) {
+            if (!repl->peers[i].active) continue;
+            peers++;
+            if (repl->head - repl->peers[i].acked > lag) lag = repl->head - repl->peers[i].acked;
+        }
+        snprintf(buffer, size, "REPL:%s:%ld:%ld:0:%d", role == REPLICATION_PRIMARY ? "PRIMARY" : "OFF",
+                 repl->head, lag, peers);
+    }
+    pthread_mutex_unlock(&repl->mutex);
+}
@@ -0,0 +1,105 @@
+#include <stdlib.h>
+#include "runtime_history.h"
+
+int runtime_history_init(runtime_history_t *history) {
+    if (!history) return -1;
+    if (int_map_init(&history->entries, 256) != 0) return -1;
+    if (pthread_mutex_init(&history->mutex, NULL) != 0) {
+        int_map_destroy(&history->entries);
+        return -1;
+    }
+    return 0;
+}
+
+static void free_entry(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    free(value);
+}
+
+void runtime_history_destroy(runtime_history_t *history) {
+    if (!history) return;
+    pthread_mutex_lock(&history->mutex);
+    int_map_foreach(&history->entries, free_entry, NULL);
+    int_map_destroy(&history->entries);
+    pthread_mutex_unlock(&history->mutex);
+    pthread_mutex_destroy(&history->mutex);
+}
+
+void runtime_history_record(runtime_history_t *history, const char *script, double seconds) {
+    if (!history || !script || seconds < 0) return;
+    int key = int_map_string_key(script);
+
+    pthread_mutex_lock(&history->mutex);
+    runtime_entry_t *entry = int_map_get(&history->entries, key);
+    if (!entry && history->entries.size < RUNTIME_HISTORY_MAX &&
+        (entry = calloc(1, sizeof(runtime_entry_t))) != NULL &&
+        int_map_put(&history->entries, key, entry) != 0) {
+        free(entry);
+        entry = NULL;
+    }
+    if (entry) {
+        if (entry->samples == 0) {
+            entry->mean = seconds;
+            entry->deviation = seconds / 2;
+        } else {
+            double error = seconds - entry->mean;
+            entry->mean += RUNTIME_HISTORY_ALPHA * error;
+            double magnitude = error < 0 ? -error : error;
+            entry->deviation += RUNTIME_HISTORY_ALPHA * (magnitude - entry->deviation);
+        }
+        entry->recent[entry->samples % RUNTIME_HISTORY_SAMPLES] = (float)seconds;
+        entry->samples++;
+    }
+    pthread_mutex_unlock(&history->mutex);
+}
+
+double runtime_history_estimate(runtime_history_t *history, const char *script) {
+    if (!history || !script) return -1;
+    int key = int_map_string_key(script);
+
+    pthread_mutex_lock(&history->mutex);
+    runtime_entry_t *entry = int_map_get(&history->entries, key);
+    double estimate = entry && entry->samples >= RUNTIME_HISTORY_MIN_SAMPLES
+                      ? entry->mean + 2 * entry->deviation : -1;
+    pthread_mutex_unlock(&history->mutex);
+    return estimate;
+}
+
+double runtime_history_percentile(runtime_history_t *history, const char *script, int percentile) {
+    if (!history || !script || percentile < 1 || percentile > 100) return -1;
+    int key = int_map_string_key(script);
+    float sorted[RUNTIME_HISTORY_SAMPLES];
+    int n = 0;
+
+    pthread_mutex_lock(&history->mutex);
+    runtime_entry_t *entry = int_map_get(&history->entries, key);
+    if (entry && entry->samples >= RUNTIME_HISTORY_MIN_SAMPLES) {
+        n = entry->samples < RUNTIME_HISTORY_SAMPLES ? (int)entry->samples : RUNTIME_HISTORY_SAMPLES;
+        for (int i = 0; i < n; i++) {
+            sorted[i] = entry->recent[i];
+        }
+    }
+    pthread_mutex_unlock(&history->mutex);
+    if (n == 0) return -1;
+
+    // Poucas amostras: inserção direta basta
+    for (int i = 1; i < n; i++) {
+        float value = sorted[i];
+        int j = i - 1;
+        while (j >= 0 && sorted[j] > value) {
+            sorted[j + 1] = sorted[j];
+            j--;
+        }
+        sorted[j + 1] = value;
+    }
+    // Menor amostra que cobre o percentil (nearest-rank)
+    int rank = (percentile * n + 99) / 100;
+    return sorted[rank > 0 ? rank - 1 : 0];
+}
+
+int runtime_history_count(runtime_history_t *history) {
+    pthread_mutex_lock(&history->mutex);
+    int count = (int)history->entries.size;
+    pthread_mutex_unlock(&history->mutex);
+    return count;
+}
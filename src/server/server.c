@@ -3,22 +3,41 @@
 #include <string.h>
 #include <unistd.h>
 #include <pthread.h>
+#include <time.h>
+#include <stdatomic.h>
 #include <sys/socket.h>
 #include <netinet/in.h>
+#include <arpa/inet.h>
 #include "../common/protocol.h"
+#include "../common/shard_ring.h"
+#include "../common/local_transport.h"
+#include "../common/uring.h"
 #include "../include/job_queue.h"
 #include "../include/tslog.h"
 #include "monitor_cli.h"
+#include "acceptor.h"
 #include "database.h"
 #include "globals.h"
 #include "worker_manager.h"  /* <-- incluído para garantir worker_manager_t */
 
-#define MAX_CLIENTS 10
-#define BUFFER_SIZE 2048
+#define LISTEN_BACKLOG SOMAXCONN   // conexões aguardando accept
+#define OVERLOAD_READ_PAUSE_MS 1000  // pausa máxima na leitura de quem recebeu RETRY_AFTER
+#define MAX_CLIENT_WEIGHTS 32
+#define BUFFER_SIZE PROTOCOL_LINE_MAX
+#define STATS_PERSIST_INTERVAL 10  // segundos
+#define LOG_ROTATE_SIZE (64 * 1024 * 1024)
+#define LOG_ROTATE_INTERVAL (24 * 60 * 60)
+#define LOG_ROTATE_KEEP 7
+#define LOG_HOT_PATH_PER_SECOND 20  // mensagens por job, por ponto de chamada
 
 typedef struct {
     int socket;
-    struct sockaddr_in address;
+    struct sockaddr_in address;     // socket local: 127.0.0.1
+    int local;                      // aceita pelo socket local (AF_UNIX)
+    acceptor_t *acceptor;           // socket TCP que aceitou (NULL = local)
+#ifdef SCHED_IO_URING
+    uring_conn_t *io;               // conexão TCP pelo anel do handler (NULL = socket direto)
+#endif
     job_queue_t *queue;
     tslog_t *logger;
 } client_thread_args_t;
@@ -28,57 +47,769 @@ extern tslog_t logger;
 extern monitor_cli_t monitor_cli;
 extern int server_running;
 extern worker_manager_t worker_manager;
+extern lease_table_t job_leases;
+extern job_scheduler_t job_scheduler;
+extern job_graph_t job_graph;
+extern capability_registry_t capabilities;
+extern runtime_history_t runtime_history;
+extern job_index_t job_index;
+extern idempotency_t idempotency;
+extern acceptor_set_t acceptors;
+
+// Acrescenta a tag à lista "a,b" se ela ainda não está lá
+static int needs_add(char *needs, size_t size, const char *tag) {
+    size_t len = strlen(tag);
+    for (const char *p = needs; *p; ) {
+        size_t n = strcspn(p, ",");
+        if (n == len && strncmp(p, tag, len) == 0) return 0;
+        p += n;
+        if (*p == ',') p++;
+    }
+    size_t used = strlen(needs);
+    int written = snprintf(needs + used, size - used, "%s%s", used ? "," : "", tag);
+    return (written < 0 || (size_t)written >= size - used) ? -1 : 0;
+}
+
+static void load_profile(const char *tags, void *arg) {
+    worker_manager_add_profile((worker_manager_t*)arg, tags);
+}
+
+// Estado final para quem assinou o job, o batch ou as tags. Antes de
+// job_graph_finish, que esquece o batch do job.
+static void publish_final(int job_id, job_status_t status, double exec_time, const char *output,
+                          const char *needs) {
+    char batch[JOB_CLIENT_MAX] = "";
+    job_graph_batch_of(&job_graph, job_id, batch, sizeof(batch));
+    notify_event_t event = {job_id, status, exec_time, output, batch, needs};
+    notifier_publish(&notifier, &event);
+}
+
+// Dead-letter também é resultado final para quem depende do job
+static void graph_dead_letter(const job_t *job, void *arg) {
+    publish_final(job->job_id, JOB_DEAD_LETTER, 0.0, "", job->needs);
+    job_graph_finish((job_graph_t*)arg, job->job_id, 0);
+}
+
+// Job descartado por prazo também é resultado final para quem depende dele
+static void graph_expired(int job_id, const char *needs, void *arg) {
+    publish_final(job_id, JOB_EXPIRED, 0.0, "", needs);
+    job_graph_finish((job_graph_t*)arg, job_id, 0);
+}
+
+// Cancelado enquanto esperava dependências, ou derrubado por uma delas
+static void notify_graph_final(int job_id, job_status_t status, const char *batch, const char *needs,
+                               void *arg) {
+    notify_event_t event = {job_id, status, 0.0, "", batch, needs};
+    notifier_publish((notifier_t*)arg, &event);
+}
+
+// Transições da fila e do índice viram registros do log de replicação
+static void replicate_enqueue(const job_t *job, void *arg) {
+    replication_log_enqueue((replication_t*)arg, job);
+}
+
+static void replicate_status(int job_id, job_status_t status, int worker_id, int attempts, void *arg) {
+    replication_log_status((replication_t*)arg, job_id, status, worker_id, attempts);
+}
+
+// Standby ainda não promovido: só consultas e a própria replicação
+static int standby_allows(const char *line) {
+    return strncmp(line, "STATUS:", 7) == 0 || strncmp(line, "LIST_JOBS", 9) == 0 ||
+           strcmp(line, "REPL_STATUS") == 0 || strcmp(line, "HEARTBEAT") == 0;
+}
+
+// Linha para a conexão, escrita só pelo handler. Com io_uring ela espera o
+// próximo io_uring_enter do handler, junto com as outras respostas.
+static int conn_send(client_thread_args_t *args, const char *line) {
+#ifdef SCHED_IO_URING
+    if (args->io) return uring_conn_queue(args->io, line);
+#endif
+    return protocol_send_line(args->socket, line);
+}
+
+// A conexão vai ser escrita por outra thread (worker manager, notificações,
+// envio do log): o que o handler acumulou sai antes
+static void conn_flush(client_thread_args_t *args) {
+#ifdef SCHED_IO_URING
+    if (args->io) uring_conn_flush(args->io);
+#else
+    (void)args;
+#endif
+}
+
+// Resposta para um cliente: com assinaturas, sem intercalar com as
+// notificações que a thread de envio dele escreve no mesmo socket
+static int client_send(client_thread_args_t *args, notify_subscriber_t *subscriber, const char *line) {
+    return subscriber ? notifier_reply(subscriber, line) : conn_send(args, line);
+}
+
+// Resposta para a conexão: workers passam pelo worker manager, que serializa
+// as linhas com os JOBs enviados pelo dispatcher
+static void reply(client_thread_args_t *args, int worker_id, const char *line) {
+    if (worker_id > 0) {
+        worker_manager_send(&worker_manager, worker_id, line);
+    } else {
+        conn_send(args, line);
+    }
+}
+
+// Resultado de um job do worker, pelo socket ou pelo anel do canal local
+static void finish_job_result(client_thread_args_t *args, int worker_id, int job_id, int lease_id,
+                              int success, double exec_time, const char *output) {
+    // Falha de uma das cópias especulativas: a outra ainda pode dar certo
+    if (!success && lease_table_drop_copy(&job_leases, job_id, lease_id, worker_id) == 0) {
+        worker_manager_release_job(&worker_manager, worker_id, job_id, NULL);
+        return;
+    }
+    
+    // Lease já vencido (o job voltou para a fila, talvez para o mesmo worker)
+    // ou cópia que perdeu: o resultado atrasado é descartado para não
+    // sobrescrever o que vale
+    job_t job;
+    int loser = 0;
+    if (lease_table_complete(&job_leases, job_id, lease_id, worker_id, &job, &loser) != 0) {
+        tslog_warn(args->logger, "Resultado atrasado do job %d (worker %d) ignorado", job_id, worker_id);
+        return;
+    }
+    if (loser > 0) {
+        worker_manager_cancel_job(&worker_manager, loser, job_id);
+    }
+    
+    database_update_job_result(job_id, success, output, exec_time);
+    job_index_update(&job_index, job_id, success ? JOB_COMPLETED : JOB_FAILED, worker_id, job.attempts);
+    publish_final(job_id, success ? JOB_COMPLETED : JOB_FAILED, exec_time, output, job.needs);
+    job_graph_finish(&job_graph, job_id, success);
+    worker_manager_release_job(&worker_manager, worker_id, job_id, NULL);
+    job_stats_record_finish(&job_stats, job.priority, worker_id, success, exec_time);
+    
+    // Só execuções completas alimentam a estimativa de duração
+    if (success) {
+        runtime_history_record(&runtime_history, job.script, exec_time);
+    }
+    if (job.deadline) {
+        job_stats_record_deadline(&job_stats, success && time(NULL) <= job.deadline
+                                              ? DEADLINE_MET : DEADLINE_MISSED);
+    }
+    
+    tslog_info_limited(args->logger, "protocol", "Job %d finalizado (sucesso: %d, tempo: %.2fs)", 
+                       job_id, success, exec_time);
+}
+
+// Trata o resultado enviado pelo worker: "JOB_RESULT:<id>:<lease>:<sucesso>:<tempo>:<saída>"
+static void handle_job_result(client_thread_args_t *args, const char *payload, int worker_id) {
+    int job_id, lease_id, success, offset = 0;
+    double exec_time;
+    
+    if (sscanf(payload, "%d:%d:%d:%lf:%n", &job_id, &lease_id, &success, &exec_time, &offset) != 4) {
+        tslog_warn(args->logger, "Resultado mal formatado: %.80s", payload);
+        return;
+    }
+    
+    char output[MAX_RESULT_SIZE];
+    snprintf(output, sizeof(output), "%s", payload + offset);
+    protocol_unescape(output);
+    finish_job_result(args, worker_id, job_id, lease_id, success, exec_time, output);
+}
+
+// Canal de memória compartilhada de um worker local (ver local_transport.h):
+// esta thread esvazia o anel de resultados enquanto o handler lê o socket
+typedef struct {
+    shm_channel_t *channel;     // do worker manager depois do attach
+    client_thread_args_t *args;
+    int worker_id;
+    atomic_int stopping;
+    pthread_t thread;
+} shm_reader_t;
+
+static void* shm_result_reader(void *arg) {
+    shm_reader_t *shm = (shm_reader_t*)arg;
+    char output[MAX_RESULT_SIZE];
+    int job_id, lease_id, success;
+    double exec_time;
+
+    // Esvazia antes de olhar stopping: resultado escrito logo antes de o
+    // worker fechar a conexão ainda conta
+    while (shm_channel_wait(shm->channel->result_event) == 0) {
+        while (shm_channel_pop_result(shm->channel, &job_id, &lease_id, &success, &exec_time,
+                                      output, sizeof(output)) == 1) {
+            worker_manager_heartbeat(&worker_manager, shm->worker_id);
+            finish_job_result(shm->args, shm->worker_id, job_id, lease_id, success, exec_time, output);
+        }
+        if (atomic_load(&shm->stopping)) break;
+    }
+    return NULL;
+}
+
+// SHM_ATTACH com memfd e eventfds (SCM_RIGHTS) de um worker push no socket local
+static shm_reader_t* handle_shm_attach(client_thread_args_t *args, line_reader_t *reader, int worker_id) {
+    int fds[SHM_CHANNEL_FDS];
+    int count = line_reader_take_fds(reader, fds, SHM_CHANNEL_FDS);
+    shm_reader_t *shm = calloc(1, sizeof(shm_reader_t));
+    shm_channel_t *channel = malloc(sizeof(shm_channel_t));
+    int usable = shm && channel && worker_id > 0 && args->local;
+    if (!usable) {
+        for (int i = 0; i < count; i++) close(fds[i]);
+    }
+    // shm_channel_open fecha os descritores se falhar
+    if (!usable || shm_channel_open(channel, fds, count) != 0) {
+        tslog_warn(args->logger, "Canal de memória compartilhada recusado (worker %d)", worker_id);
+        free(channel);
+        free(shm);
+        return NULL;
+    }
+
+    shm->channel = channel;
+    shm->args = args;
+    shm->worker_id = worker_id;
+    atomic_init(&shm->stopping, 0);
+    if (pthread_create(&shm->thread, NULL, shm_result_reader, shm) != 0) {
+        shm_channel_close(channel);
+        free(channel);
+        free(shm);
+        return NULL;
+    }
+    if (worker_manager_attach_channel(&worker_manager, worker_id, channel) != 0) {
+        atomic_store(&shm->stopping, 1);
+        shm_channel_wake(channel->result_event);
+        pthread_join(shm->thread, NULL);
+        shm_channel_close(channel);
+        free(channel);
+        free(shm);
+        return NULL;
+    }
+    return shm;
+}
+
+// Antes de worker_manager_unregister: o canal é liberado com a entrada
+static void shm_reader_stop(shm_reader_t *shm) {
+    if (!shm) return;
+    atomic_store(&shm->stopping, 1);
+    shm_channel_wake(shm->channel->result_event);
+    pthread_join(shm->thread, NULL);
+    free(shm);
+}
+
+// Cancela o job onde ele estiver: aguardando dependências, na fila (sai em
+// O(1) pelo índice da fila) ou em execução (o worker recebe CANCEL e mata o
+// processo). Retorna -1 se o job não está em nenhum desses lugares.
+static int cancel_job(int job_id) {
+    if (job_graph_cancel(&job_graph, job_id) == 0) return 0;
+    
+    job_t job;
+    int workers[2] = {0, 0};
+    int was_running = 0;
+    if (job_queue_remove(&job_queue, job_id, &job) != 0) {
+        if (lease_table_abort(&job_leases, job_id, &job, workers) != 0) return -1;
+        was_running = 1;
+    }
+    for (int i = 0; i < 2; i++) {
+        if (workers[i] > 0) {
+            worker_manager_cancel_job(&worker_manager, workers[i], job_id);
+        }
+    }
+    
+    database_update_job_status(job_id, JOB_CANCELLED, job.attempts, "cancelado pelo cliente");
+    job_index_update(&job_index, job_id, JOB_CANCELLED, 0, job.attempts);
+    job_stats_record_cancel(&job_stats, was_running);
+    publish_final(job_id, JOB_CANCELLED, 0.0, "", job.needs);
+    job_graph_finish_cancelled(&job_graph, job_id);
+    tslog_info(&logger, "Job %d cancelado (%s)", job_id, was_running ? "em execução" : "na fila");
+    return 0;
+}
+
+// "LIST_JOBS[?status=S&client=c&after=id&limit=n]" -> filtro e limite
+static int parse_list_jobs(const char *line, job_index_filter_t *filter, int *limit) {
+    memset(filter, 0, sizeof(*filter));
+    filter->status = -1;
+    *limit = JOB_INDEX_PAGE_MAX;
+    if (*line == '\0') return 0;
+    if (*line != '?') return -1;
+    
+    char options[256];
+    snprintf(options, sizeof(options), "%s", line + 1);
+    char *save = NULL;
+    for (char *opt = strtok_r(options, "&", &save); opt; opt = strtok_r(NULL, "&", &save)) {
+        char *value = strchr(opt, '=');
+        if (!value) return -1;
+        *value++ = '\0';
+        if (strcmp(opt, "status") == 0) {
+            job_status_t status;
+            if (protocol_status_from_name(value, &status) != 0) return -1;
+            filter->status = (int)status;
+        } else if (strcmp(opt, "client") == 0) {
+            snprintf(filter->client, sizeof(filter->client), "%s", value);
+        } else if (strcmp(opt, "after") == 0) {
+            filter->after = atoi(value);
+        } else if (strcmp(opt, "limit") == 0) {
+            *limit = atoi(value);
+            if (*limit < 1 || *limit > JOB_INDEX_PAGE_MAX) return -1;
+        } else {
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// "JOBS:<n>:<cursor>:<id>,<status>,<cliente>,<pri>,<worker>,<tentativas>;..."
+// Cursor 0 = fim; senão é o after= da próxima página. Jobs que não cabem na
+// linha ficam para a próxima página.
+static void format_job_list(const job_index_entry_t *entries, int count, int limit,
+                            char *response, size_t size) {
+    char body[BUFFER_SIZE];
+    size_t used = 0;
+    int shown = 0;
+    body[0] = '\0';
+    for (; shown < count; shown++) {
+        const job_index_entry_t *e = &entries[shown];
+        int n = snprintf(body + used, sizeof(body) - used, "%s%d,%s,%s,%d,%d,%d", shown ? ";" : "",
+                         e->job_id, protocol_status_name(e->status), e->client[0] ? e->client : "-", e->priority,
+                         e->worker_id, e->attempts);
+        // Reserva espaço para o cabeçalho
+        if (n < 0 || used + (size_t)n >= sizeof(body) - 48) {
+            body[used] = '\0';
+            break;
+        }
+        used += (size_t)n;
+    }
+    int cursor = shown > 0 && (shown < count || count == limit) ? entries[shown - 1].job_id : 0;
+    snprintf(response, size, "JOBS:%d:%d:%s", shown, cursor, body);
+}
+
+// JOB...: valida e encaminha ao grafo, ao agendador ou à fila. Retorna 0 com
+// o que foi criado em `created` ou -1 com o ERROR em `response`.
+static int submit_job(client_thread_args_t *args, const job_options_t *opts, const char *script,
+                      idempotency_record_t *created, char *response, size_t size) {
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    strncpy(job.script, script, MAX_SCRIPT_SIZE - 1);
+    job.script[MAX_SCRIPT_SIZE - 1] = '\0';
+    // Sem client= o cliente é identificado pelo endereço da conexão
+    if (opts->client[0]) {
+        snprintf(job.client, sizeof(job.client), "%s", opts->client);
+    } else {
+        inet_ntop(AF_INET, &args->address.sin_addr, job.client, sizeof(job.client));
+    }
+    job.priority = opts->priority ? opts->priority : 5;
+    job.timeout = opts->timeout ? opts->timeout : 30;
+    job.status = JOB_PENDING;
+    job.no_hedge = opts->no_hedge;
+
+    // O interpretador que o executor vai usar também é exigido do worker
+    snprintf(job.needs, sizeof(job.needs), "%s", opts->needs);
+    const char *runtime = protocol_script_runtime(job.script);
+    char reason[128];
+    if (runtime && needs_add(job.needs, sizeof(job.needs), runtime) != 0) {
+        snprintf(response, size, "ERROR:capacidades demais");
+        return -1;
+    }
+    if (!worker_manager_can_satisfy(&worker_manager, job.needs, reason, sizeof(reason))) {
+        snprintf(response, size, "ERROR:%s", reason);
+        return -1;
+    }
+
+    int timed = opts->run_at || opts->delay || opts->every || opts->cron[0];
+    if (timed && (opts->after[0] || opts->batch[0])) {
+        snprintf(response, size, "ERROR:dependências não se combinam com agendamento");
+        return -1;
+    }
+
+    // Prazo absoluto (deadline=) ou relativo à submissão (due=)
+    time_t now = time(NULL);
+    job.deadline = opts->deadline ? opts->deadline : (opts->due ? now + opts->due : 0);
+    if (job.deadline && timed) {
+        snprintf(response, size, "ERROR:prazo não se combina com agendamento");
+        return -1;
+    }
+    if (job.deadline) {
+        // Recusa na admissão o que já não cabe pelo histórico do script
+        double estimate;
+        if (job_queue_admit_deadline(&job_queue, &job, &estimate)) {
+            job_stats_record_deadline(&job_stats, DEADLINE_REJECTED);
+            if (estimate > 0) {
+                snprintf(response, size, "ERROR:prazo inviável (duração estimada %.1fs)", estimate);
+            } else {
+                snprintf(response, size, "ERROR:prazo inviável");
+            }
+            return -1;
+        }
+    }
+
+    // Com dependências ou batch o job passa pelo grafo
+    if (opts->after[0] || opts->batch[0]) {
+        char error[128];
+        int job_id = job_graph_submit(&job_graph, &job, opts->after, opts->batch,
+                                      error, sizeof(error));
+        if (job_id < 0) {
+            snprintf(response, size, "ERROR:%s", error);
+            return -1;
+        }
+        created->kind = IDEMPOTENCY_JOB;
+        created->id = job_id;
+        return 0;
+    }
+
+    // Com horário ou recorrência o job espera no agendador
+    if (timed) {
+        int schedule_id = job_scheduler_add(&job_scheduler, &job, opts, &created->first_run);
+        if (schedule_id < 0) {
+            snprintf(response, size, "ERROR:agendamento inválido");
+            return -1;
+        }
+        created->kind = IDEMPOTENCY_SCHEDULE;
+        created->id = schedule_id;
+        return 0;
+    }
+
+    int job_id = job_queue_push_priority(args->queue, &job);
+    if (job_id < 0) {
+        snprintf(response, size, "ERROR:falha ao enfileirar");
+        return -1;
+    }
+    created->kind = IDEMPOTENCY_JOB;
+    created->id = job_id;
+    tslog_info_limited(args->logger, "protocol", "Job %d aceito", job_id);
+    return 0;
+}
+
+// Resposta de uma submissão criada (ou repetida com a mesma chave)
+static void format_submit_reply(const idempotency_record_t *rec, char *response, size_t size) {
+    if (rec->kind == IDEMPOTENCY_SCHEDULE) {
+        snprintf(response, size, "JOB_SCHEDULED:%d:%ld", rec->id, (long)rec->first_run);
+    } else if (rec->kind == IDEMPOTENCY_JOB) {
+        snprintf(response, size, "JOB_ACCEPTED:%d", rec->id);
+    } else {
+        // A primeira submissão com esta chave ainda não terminou
+        snprintf(response, size, "RETRY_AFTER:%d", IDEMPOTENCY_PENDING_RETRY_MS);
+    }
+}
+
+// Assina o tópico para esta conexão. Job que já terminou (ou terminou
+// enquanto a assinatura entrava) recebe a notificação na hora, com a saída
+// gravada no banco, se a publicação ainda não levou a assinatura.
+static void handle_subscribe(client_thread_args_t *args, notify_subscriber_t **subscriber, const char *spec,
+                             int worker_id) {
+    char topic[NOTIFY_TOPIC_MAX];
+    char response[BUFFER_SIZE];
+    if (worker_id > 0 || notifier_parse_topic(spec, topic, sizeof(topic)) != 0) {
+        client_send(args, *subscriber, "ERROR:tópico inválido (job=<id>, batch=<nome> ou tag=<tag>)");
+        return;
+    }
+
+    int job_id = strncmp(topic, "job=", 4) == 0 ? atoi(topic + 4) : 0;
+    job_index_entry_t entry;
+    job_record_t record;
+    if (job_id > 0 && job_index_get(&job_index, job_id, &entry) != 0 && database_get_job(job_id, &record) != 0) {
+        snprintf(response, sizeof(response), "ERROR:job %d desconhecido", job_id);
+        client_send(args, *subscriber, response);
+        return;
+    }
+    if (!*subscriber) {
+        conn_flush(args);
+        if ((*subscriber = notifier_attach(&notifier, args->socket)) == NULL) {
+            conn_send(args, "ERROR:notificações indisponíveis");
+            return;
+        }
+    }
+    if (notifier_subscribe(&notifier, *subscriber, topic) != 0) {
+        snprintf(response, sizeof(response), "ERROR:limite de %d assinaturas por conexão", NOTIFY_TOPICS_PER_CONN);
+        notifier_reply(*subscriber, response);
+        return;
+    }
+    snprintf(response, sizeof(response), "SUBSCRIBED:%s", topic);
+    notifier_reply(*subscriber, response);
+
+    if (job_id == 0) return;
+    int indexed = job_index_get(&job_index, job_id, &entry) == 0;
+    if ((!indexed || job_index_is_final(entry.status)) && notifier_unsubscribe(&notifier, *subscriber, topic) == 0 &&
+        database_get_job(job_id, &record) == 0) {
+        job_status_t status = indexed ? entry.status : (job_status_t)record.status;
+        notify_event_t event = {job_id, status, record.execution_time, record.result, "", ""};
+        notifier_deliver(&notifier, *subscriber, topic, &event);
+    }
+}
 
 void* client_handler(void *arg) {
     client_thread_args_t *args = (client_thread_args_t*)arg;
     int client_socket = args->socket;
     char buffer[BUFFER_SIZE];
+    line_reader_t reader;
+    int worker_id = 0;
+    notify_subscriber_t *subscriber = NULL;     // na primeira SUBSCRIBE
+    shm_reader_t *shm = NULL;                   // worker local com SHM_ATTACH
 
+    line_reader_init(&reader);
+#ifdef SCHED_IO_URING
+    // Socket local fica no caminho portável: SHM_ATTACH traz descritores
+    if (!args->local && uring_available()) {
+        args->io = malloc(sizeof(uring_conn_t));
+        if (args->io && uring_conn_init(args->io, client_socket) == 0) {
+            line_reader_set_source(&reader, uring_conn_fill, args->io);
+        } else {
+            free(args->io);
+            args->io = NULL;
+        }
+    }
+#endif
     tslog_info(args->logger, "Nova conexão cliente aceita");
 
     while (server_running) {
-        memset(buffer, 0, BUFFER_SIZE);
-        ssize_t bytes_read = read(client_socket, buffer, BUFFER_SIZE - 1);
-
-        if (bytes_read <= 0) {
+        if (line_reader_next(&reader, client_socket, buffer, sizeof(buffer)) < 0) {
             tslog_info(args->logger, "Cliente desconectado");
             break;
         }
 
-        buffer[BUFFER_SIZE-1] = '\0'; // Garantir terminação
-        tslog_info(args->logger, "Mensagem recebida: %s", buffer);
+        if (buffer[0] == '\0') continue;
+        worker_manager_heartbeat(&worker_manager, worker_id);
+        /* Só o início da mensagem: o script inteiro já vai para o database */
+        tslog_info_limited(args->logger, "protocol", "Mensagem recebida: %.80s", buffer);
 
         char response[BUFFER_SIZE];
-        int max_msg = BUFFER_SIZE - 20; // Espaço para "Servidor recebeu: "
-        if (strlen(buffer) > (size_t) max_msg) {
-            buffer[max_msg] = '\0'; // Truncar se necessário
+
+        if (replication_is_standby(&replication) && !standby_allows(buffer)) {
+            reply(args, worker_id, REPLICATION_NOT_PRIMARY);
+            continue;
         }
-        snprintf(response, BUFFER_SIZE, "Servidor recebeu: %s", buffer);
-        write(client_socket, response, strlen(response));
 
-        if (strstr(buffer, "JOB:") != NULL) {
+        if (strncmp(buffer, "REPLICATE:", 10) == 0) {
+            // A conexão passa a ser do envio do log até o standby cair
+            char peer[64] = "socket local";
+            if (!args->local) {
+                inet_ntop(AF_INET, &args->address.sin_addr, peer, sizeof(peer));
+                snprintf(peer + strlen(peer), sizeof(peer) - strlen(peer), ":%d", ntohs(args->address.sin_port));
+            }
+            conn_flush(args);
+            replication_serve(&replication, client_socket, &reader, atol(buffer + 10), peer);
+            break;
+
+        } else if (strcmp(buffer, "REPL_STATUS") == 0) {
+            replication_format_status(&replication, response, BUFFER_SIZE);
+            client_send(args, subscriber, response);
+
+        } else if (strncmp(buffer, "JOB:", 4) == 0 || strncmp(buffer, "JOB?", 4) == 0) {
+            // JOB:<script> ou JOB?<opções>:<script> (ver job_options_t)
+            job_options_t opts;
+            const char *script = protocol_parse_job(buffer, &opts);
+            if (!script) {
+                client_send(args, subscriber, "ERROR:opções de job inválidas");
+                continue;
+            }
+
+            // Reenvio com a mesma chave: a resposta da primeira vez
+            idempotency_record_t created;
+            if (opts.key[0]) {
+                int claimed = idempotency_claim(&idempotency, opts.key, &created);
+                if (claimed == 1) {
+                    format_submit_reply(&created, response, BUFFER_SIZE);
+                    client_send(args, subscriber, response);
+                    continue;
+                }
+                if (claimed < 0) {
+                    client_send(args, subscriber, "ERROR:chave de idempotência indisponível");
+                    continue;
+                }
+            }
+
+            // Fila sobrecarregada: recusa explícita com a espera sugerida, e
+            // esta conexão fica um tempo sem ser lida (o TCP segura o produtor)
+            int retry_after_ms = 0;
+            if (job_queue_admit(args->queue, &retry_after_ms) != 0) {
+                idempotency_release(&idempotency, opts.key);
+                snprintf(response, BUFFER_SIZE, "RETRY_AFTER:%d", retry_after_ms);
+                client_send(args, subscriber, response);
+                conn_flush(args);
+                usleep((useconds_t)(retry_after_ms < OVERLOAD_READ_PAUSE_MS
+                                    ? retry_after_ms : OVERLOAD_READ_PAUSE_MS) * 1000);
+                continue;
+            }
+
+            memset(&created, 0, sizeof(created));
+            if (submit_job(args, &opts, script, &created, response, BUFFER_SIZE) == 0) {
+                idempotency_commit(&idempotency, opts.key, created.kind, created.id, created.first_run);
+                replication_log_key(&replication, opts.key, created.kind, created.id, created.first_run);
+                format_submit_reply(&created, response, BUFFER_SIZE);
+            } else {
+                idempotency_release(&idempotency, opts.key);
+            }
+            client_send(args, subscriber, response);
+
+        } else if (strncmp(buffer, "CANCEL:", 7) == 0) {
+            int job_id = atoi(buffer + 7);
+            if (cancel_job(job_id) == 0) {
+                snprintf(response, BUFFER_SIZE, "CANCELLED:%d", job_id);
+            } else {
+                snprintf(response, BUFFER_SIZE, "ERROR:job %d não está pendente nem em execução", job_id);
+            }
+            client_send(args, subscriber, response);
+
+        } else if (strncmp(buffer, "STATUS:", 7) == 0) {
+            // Só o índice em memória: nem o mutex da fila nem o SQLite
+            int job_id = atoi(buffer + 7);
+            job_index_entry_t entry;
+            if (job_index_get(&job_index, job_id, &entry) == 0) {
+                snprintf(response, BUFFER_SIZE, "JOB_STATUS:%d:%s:%d:%d:%s", job_id,
+                         protocol_status_name(entry.status), entry.worker_id, entry.attempts,
+                         entry.client[0] ? entry.client : "-");
+            } else {
+                snprintf(response, BUFFER_SIZE, "ERROR:job %d desconhecido", job_id);
+            }
+            client_send(args, subscriber, response);
+
+        } else if (strncmp(buffer, "LIST_JOBS", 9) == 0) {
+            job_index_filter_t filter;
+            int limit;
+            if (parse_list_jobs(buffer + 9, &filter, &limit) != 0) {
+                snprintf(response, BUFFER_SIZE, "ERROR:LIST_JOBS inválido");
+            } else {
+                job_index_entry_t entries[JOB_INDEX_PAGE_MAX];
+                int count = job_index_list(&job_index, &filter, entries, limit);
+                format_job_list(entries, count, limit, response, BUFFER_SIZE);
+            }
+            client_send(args, subscriber, response);
+
+        } else if (strncmp(buffer, "SUBSCRIBE:", 10) == 0) {
+            // SUBSCRIBE:job=<id> | batch=<nome> | tag=<tag> (ver notifier.h)
+            handle_subscribe(args, &subscriber, buffer + 10, worker_id);
+
+        } else if (strncmp(buffer, "UNSUBSCRIBE:", 12) == 0) {
+            char topic[NOTIFY_TOPIC_MAX];
+            if (notifier_parse_topic(buffer + 12, topic, sizeof(topic)) != 0 || !subscriber ||
+                notifier_unsubscribe(&notifier, subscriber, topic) != 0) {
+                snprintf(response, BUFFER_SIZE, "ERROR:%.64s não está assinado", buffer + 12);
+            } else {
+                snprintf(response, BUFFER_SIZE, "UNSUBSCRIBED:%s", topic);
+            }
+            client_send(args, subscriber, response);
+
+        } else if (strncmp(buffer, "UNSCHEDULE:", 11) == 0) {
+            int schedule_id = atoi(buffer + 11);
+            if (job_scheduler_cancel(&job_scheduler, schedule_id) == 0) {
+                snprintf(response, BUFFER_SIZE, "UNSCHEDULED:%d", schedule_id);
+            } else {
+                snprintf(response, BUFFER_SIZE, "ERROR:agendamento %d não existe", schedule_id);
+            }
+            client_send(args, subscriber, response);
+
+        } else if (strncmp(buffer, "REGISTER_WORKER", 15) == 0) {
+            // REGISTER_WORKER:<host>[:<slots>[:<tag,tag>]] - com slots o worker recebe jobs por push
+            char hostname[64] = "desconhecido";
+            char caps[CAPABILITY_LIST_MAX] = "";
+            int slots = 0;
+            if (buffer[15] == ':') {
+                sscanf(buffer + 16, "%63[^:]:%d:%255s", hostname, &slots, caps);
+            }
+            conn_flush(args);
+            worker_id = worker_manager_register(&worker_manager, client_socket, hostname, slots, caps);
+            if (worker_id < 0) {
+                client_send(args, subscriber, "ERROR:registro falhou");
+                worker_id = 0;
+            } else {
+                database_save_worker_profile(caps);
+            }
+
+        } else if (strcmp(buffer, "REQUEST_JOB") == 0 || strncmp(buffer, "REQUEST_JOB:", 12) == 0) {
             job_t job;
-            strncpy(job.script, buffer + 4, MAX_SCRIPT_SIZE - 1);
-            job.script[MAX_SCRIPT_SIZE - 1] = '\0';
-            job.priority = 5;
-            job.timeout = 30;
-            job.status = JOB_PENDING;
+            memset(&job, 0, sizeof(job));
+            job.assigned_worker = worker_id;
+
+            // Espera curta para não prender a conexão indefinidamente; só
+            // jobs que este worker atende. REQUEST_JOB:<ms> encurta a espera
+            // (0 = responder já): o worker de várias shards varre todas antes
+            int wait_ms = REQUEST_JOB_WAIT_MS;
+            if (buffer[11] == ':') {
+                wait_ms = atoi(buffer + 12);
+                if (wait_ms < 0 || wait_ms > REQUEST_JOB_WAIT_MS) wait_ms = REQUEST_JOB_WAIT_MS;
+            }
+            cap_mask_t offer = 0;
+            worker_manager_get_caps(&worker_manager, worker_id, &offer);
+            if (wait_ms > 0) conn_flush(args);     // respostas anteriores não esperam o job
+            int assigned = -1;
+            if (job_queue_pop_for(args->queue, &job, &offer, 1, wait_ms) == 0) {
+                assigned = worker_manager_assign_job(&worker_manager, worker_id, &job);
+                // Worker que não pode receber: o job volta já, sem contar tentativa
+                if (assigned < 0 && lease_table_cancel(&job_leases, job.job_id) != 0) {
+                    job_queue_requeue(args->queue, &job);
+                }
+            }
+            if (assigned == 0) {
+                char script[MAX_SCRIPT_SIZE * 2];
+                protocol_escape(job.script, script, sizeof(script));
+                snprintf(response, BUFFER_SIZE, "JOB:%d:%d:%s:%d", job.job_id, job.lease_id, script, job.timeout);
+            } else {
+                snprintf(response, BUFFER_SIZE, "NO_JOBS");
+            }
+            reply(args, worker_id, response);
 
-            int job_id = job_queue_push(args->queue, &job);
+        } else if (strncmp(buffer, "JOB_RESULT:", 11) == 0) {
+            handle_job_result(args, buffer + 11, worker_id);
 
-            char job_response[BUFFER_SIZE];
-            snprintf(job_response, BUFFER_SIZE, "JOB_ACCEPTED:%d", job_id);
-            write(client_socket, job_response, strlen(job_response));
+        } else if (strncmp(buffer, "JOB_REJECT:", 11) == 0) {
+            // Worker push sem slot livre: o job volta à fila já
+            int job_id = 0, lease_id = 0;
+            sscanf(buffer + 11, "%d:%d", &job_id, &lease_id);
+            if (lease_table_reject(&job_leases, job_id, lease_id, worker_id) == 0) {
+                worker_manager_release_job(&worker_manager, worker_id, job_id, NULL);
+                tslog_warn(args->logger, "Job %d recusado pelo worker %d - de volta à fila", job_id, worker_id);
+            }
+
+        } else if (strcmp(buffer, "SHM_ATTACH") == 0) {
+            if (!shm) shm = handle_shm_attach(args, &reader, worker_id);
+            reply(args, worker_id, shm ? "SHM_ATTACHED" : "SHM_REFUSED");
+
+        } else if (strcmp(buffer, "HEARTBEAT") == 0) {
+            // Já contabilizado acima: qualquer mensagem renova o prazo
 
-            tslog_info(args->logger, "Job %d aceito: %s", job_id, job.script);
+        } else {
+            snprintf(response, BUFFER_SIZE, "Servidor recebeu: %.*s", BUFFER_SIZE - 20, buffer);
+            reply(args, worker_id, response);
         }
     }
 
-    close(client_socket);
+    // Jobs ainda em execução neste worker voltam para a fila; o socket de um
+    // worker registrado é fechado pelo worker manager
+#ifdef SCHED_IO_URING
+    // Antes de o socket fechar ou voltar para o worker manager
+    if (args->io) {
+        uring_conn_destroy(args->io);
+        free(args->io);
+    }
+#endif
+    notifier_detach(&notifier, subscriber);
+    shm_reader_stop(shm);
+    line_reader_close_fds(&reader);
+    if (worker_id > 0) {
+        worker_manager_unregister(&worker_manager, worker_id);
+    } else {
+        close(client_socket);
+    }
+    if (args->acceptor) acceptor_closed(args->acceptor);
     free(args);
     return NULL;
 }
 
+// Persiste periodicamente o resumo das estatísticas incrementais
+void* stats_persister(void *arg) {
+    job_stats_t *stats = (job_stats_t*)arg;
+
+    while (server_running) {
+        sleep(STATS_PERSIST_INTERVAL);
+        job_stats_persist(stats);
+    }
+
+    return NULL;
+}
+
+// Grava em lote as chaves de idempotência novas
+void* idempotency_flusher(void *arg) {
+    idempotency_t *idem = (idempotency_t*)arg;
+
+    while (server_running) {
+        sleep(IDEMPOTENCY_FLUSH_INTERVAL);
+        idempotency_flush(idem);
+    }
+
+    return NULL;
+}
+
 void* queue_monitor(void *arg) {
     tslog_t *logger = (tslog_t*)arg;
     (void)logger; // evitar warning
@@ -91,34 +822,270 @@ void* queue_monitor(void *arg) {
     return NULL;
 }
 
-/* CORREÇÃO: renomeada para evitar conflito com pthread_t */
-void* worker_monitor_func(void *arg) {
-    worker_manager_t *manager = (worker_manager_t*)arg;
+// O handler herda a CPU da thread do acceptor (ver acceptor.h)
+static void start_client_thread(int client_socket, struct sockaddr_in client_addr, acceptor_t *acceptor) {
+    client_thread_args_t *args = calloc(1, sizeof(client_thread_args_t));
+    args->socket = client_socket;
+    args->address = client_addr;
+    args->local = acceptor == NULL;
+    args->acceptor = acceptor;
+    args->queue = &job_queue;
+    args->logger = &logger;
+
+    if (acceptor) acceptor_opened(acceptor);
+    pthread_t client_thread;
+    if (pthread_create(&client_thread, NULL, client_handler, args) != 0) {
+        tslog_error(&logger, "Erro ao criar thread para cliente");
+        if (acceptor) acceptor_closed(acceptor);
+        close(client_socket);
+        free(args);
+    } else {
+        pthread_detach(client_thread);
+    }
+}
+
+#ifdef SCHED_IO_URING
+// Accept multishot: uma submissão serve todas as conexões; cada
+// io_uring_enter entrega as que chegaram juntas. -1 se o anel não pôde
+// ser criado (o chamador volta para accept)
+static int accept_connections_uring(acceptor_t *acceptor) {
+    uring_t ring;
+    if (uring_init(&ring, URING_ENTRIES) < 0) return -1;
 
+    int armed = 0;
     while (server_running) {
-        sleep(30);
-        worker_manager_check_heartbeats(manager);
-        worker_manager_list(manager);
+        if (!armed) {
+            struct io_uring_sqe *sqe = uring_get_sqe(&ring);
+            uring_prep_accept_multishot(sqe, acceptor->listen_socket, 0);
+            armed = 1;
+        }
+        if (uring_enter(&ring, 1) < 0) {
+            tslog_error(&logger, "Erro no io_uring de aceitação");
+            break;
+        }
+
+        struct io_uring_cqe *cqe;
+        while ((cqe = uring_peek_cqe(&ring)) != NULL) {
+            int client_socket = cqe->res;
+            if (!(cqe->flags & IORING_CQE_F_MORE)) armed = 0;
+            uring_cqe_seen(&ring);
+            if (client_socket < 0) {
+                if (server_running) {
+                    tslog_error(&logger, "Erro ao aceitar conexão: %s", strerror(-client_socket));
+                }
+                continue;
+            }
+            // O multishot não devolve o endereço: getpeername por conexão
+            struct sockaddr_in client_addr;
+            socklen_t client_len = sizeof(client_addr);
+            memset(&client_addr, 0, sizeof(client_addr));
+            getpeername(client_socket, (struct sockaddr*)&client_addr, &client_len);
+            start_client_thread(client_socket, client_addr, acceptor);
+        }
     }
+    uring_destroy(&ring);
+    return 0;
+}
+#endif
 
+// Aceita conexões de um socket TCP (acceptor) ou do local (AF_UNIX, sem
+// acceptor); as do socket local contam como 127.0.0.1 (cliente da fila justa)
+static void accept_connections(int listen_socket, acceptor_t *acceptor) {
+    int local = acceptor == NULL;
+#ifdef SCHED_IO_URING
+    if (!local && uring_available() && accept_connections_uring(acceptor) == 0) return;
+#endif
+    while (server_running) {
+        struct sockaddr_in client_addr;
+        socklen_t client_len = sizeof(client_addr);
+        memset(&client_addr, 0, sizeof(client_addr));
+        int client_socket = accept(listen_socket, (struct sockaddr*)&client_addr, &client_len);
+        if (client_socket < 0) {
+            if (server_running) {
+                tslog_error(&logger, "Erro ao aceitar conexão");
+            }
+            continue;
+        }
+        if (local) {
+            memset(&client_addr, 0, sizeof(client_addr));
+            client_addr.sin_family = AF_INET;
+            client_addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        }
+        start_client_thread(client_socket, client_addr, acceptor);
+    }
+}
+
+static void* local_acceptor(void *arg) {
+    accept_connections((int)(intptr_t)arg, NULL);
+    return NULL;
+}
+
+// Uma thread por socket TCP, fixada na CPU do acceptor
+static void* tcp_acceptor(void *arg) {
+    acceptor_t *acceptor = (acceptor_t*)arg;
+    acceptor_pin(acceptor);
+    accept_connections(acceptor->listen_socket, acceptor);
     return NULL;
 }
 
-int main() {
-    int server_socket, client_socket;
-    struct sockaddr_in server_addr, client_addr;
-    socklen_t client_len = sizeof(client_addr);
+static void usage(const char *prog) {
+    fprintf(stderr, "Uso: %s [--worker-timeout segundos] [--placement p2c|round-robin|least-loaded]\n"
+                    "          [--max-attempts n] [--aging segundos] [--client-weight cliente=peso]...\n"
+                    "          [--queue-mode fair|edf] [--hedge-percentile p] [--hedge-budget pct]\n"
+                    "          [--queue-high jobs] [--queue-low jobs] [--queue-mem-mb mb] [--backlog n]\n"
+                    "          [--idem-ttl segundos] [--idem-max chaves]\n"
+                    "          [--port porta] [--shard n] [--db arquivo] [--no-unix]\n"
+                    "          [--acceptors n] [--cpus lista (ex.: 0-3,6)]\n"
+                    "          [--replication] [--standby-of host:porta] [--failover-timeout segundos]\n", prog);
+}
+
+int main(int argc, char *argv[]) {
+    int local_socket = -1;
     pthread_t worker_monitor_thread;
+    pthread_t stats_thread;
+    pthread_t idempotency_thread;
+    pthread_t dispatcher_thread;
+    pthread_t scheduler_thread;
+    pthread_t replication_thread;
+    pthread_t local_thread;
+    int use_unix = 1;
+    int worker_timeout = WORKER_TIMEOUT;
+    placement_policy_t placement = PLACEMENT_P2C;
+    int max_attempts = LEASE_MAX_ATTEMPTS;
+    int aging = JOB_QUEUE_DEFAULT_AGING;
+    job_queue_mode_t queue_mode = JOB_QUEUE_FAIR;
+    int hedge_percentile = 0;
+    int hedge_budget = LEASE_HEDGE_DEFAULT_BUDGET;
+    int queue_high = JOB_QUEUE_DEFAULT_HIGH;
+    int queue_low = 0;
+    int queue_mem_mb = JOB_QUEUE_DEFAULT_MEM_MB;
+    int backlog = LISTEN_BACKLOG;
+    int acceptor_count = 0;         // 0 = uma por CPU de --cpus, ou só uma
+    int cpus[ACCEPTOR_MAX];
+    int cpu_count = 0;
+    int idem_ttl = IDEMPOTENCY_DEFAULT_TTL;
+    int idem_max = IDEMPOTENCY_DEFAULT_MAX;
+    int port = SERVER_PORT;
+    int shard = -1;
+    const char *db_path = NULL;
+    int replicate = 0;
+    const char *standby_of = NULL;
+    int failover_timeout = REPLICATION_DEFAULT_FAILOVER;
+    const char *client_weights[MAX_CLIENT_WEIGHTS];
+    int client_weight_count = 0;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--worker-timeout") == 0 && i + 1 < argc) {
+            worker_timeout = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--max-attempts") == 0 && i + 1 < argc) {
+            max_attempts = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--aging") == 0 && i + 1 < argc) {
+            aging = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--hedge-percentile") == 0 && i + 1 < argc) {
+            hedge_percentile = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--hedge-budget") == 0 && i + 1 < argc) {
+            hedge_budget = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--queue-high") == 0 && i + 1 < argc) {
+            queue_high = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--queue-low") == 0 && i + 1 < argc) {
+            queue_low = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--queue-mem-mb") == 0 && i + 1 < argc) {
+            queue_mem_mb = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--backlog") == 0 && i + 1 < argc) {
+            backlog = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--acceptors") == 0 && i + 1 < argc) {
+            acceptor_count = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--cpus") == 0 && i + 1 < argc &&
+                   (cpu_count = acceptor_parse_cpus(argv[i + 1], cpus, ACCEPTOR_MAX)) > 0) {
+            i++;
+        } else if (strcmp(argv[i], "--idem-ttl") == 0 && i + 1 < argc) {
+            idem_ttl = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--idem-max") == 0 && i + 1 < argc) {
+            idem_max = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--port") == 0 && i + 1 < argc) {
+            port = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--shard") == 0 && i + 1 < argc) {
+            shard = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--db") == 0 && i + 1 < argc) {
+            db_path = argv[++i];
+        } else if (strcmp(argv[i], "--no-unix") == 0) {
+            use_unix = 0;
+        } else if (strcmp(argv[i], "--replication") == 0) {
+            replicate = 1;
+        } else if (strcmp(argv[i], "--standby-of") == 0 && i + 1 < argc) {
+            standby_of = argv[++i];
+        } else if (strcmp(argv[i], "--failover-timeout") == 0 && i + 1 < argc) {
+            failover_timeout = atoi(argv[++i]);
+        } else if (strcmp(argv[i], "--client-weight") == 0 && i + 1 < argc &&
+                   strchr(argv[i + 1], '=') && client_weight_count < MAX_CLIENT_WEIGHTS) {
+            client_weights[client_weight_count++] = argv[++i];
+        } else if (strcmp(argv[i], "--placement") == 0 && i + 1 < argc &&
+                   worker_manager_policy_from_name(argv[i + 1], &placement) == 0) {
+            i++;
+        } else if (strcmp(argv[i], "--queue-mode") == 0 && i + 1 < argc &&
+                   job_queue_mode_from_name(argv[i + 1], &queue_mode) == 0) {
+            i++;
+        } else {
+            usage(argv[0]);
+            return 1;
+        }
+    }
+
+    if (acceptor_count == 0) acceptor_count = cpu_count > 0 ? cpu_count : 1;
+    if (port <= 0 || port > 65535 || shard >= SHARD_MAX || failover_timeout <= 0 ||
+        acceptor_count < 1 || acceptor_count > ACCEPTOR_MAX) {
+        usage(argv[0]);
+        return 1;
+    }
+
+    /* Várias instâncias na mesma máquina: log e banco próprios por shard
+       e por papel (o standby não pode abrir o banco do primário) */
+    char log_path[64], shard_db[64], log_name[32] = "server";
+    const char *role_suffix = standby_of ? ".standby" : "";
+    if (shard >= 0) {
+        snprintf(shard_db, sizeof(shard_db), "scheduler.shard%d%s.db", shard, role_suffix);
+        snprintf(log_name, sizeof(log_name), "server.shard%d", shard);
+    } else {
+        snprintf(shard_db, sizeof(shard_db), "scheduler%s.db", role_suffix);
+    }
+    if (!db_path && (shard >= 0 || standby_of)) db_path = shard_db;
 
     /* Inicializar logger */
-    if (tslog_init(&logger, "server.log", TSLOG_INFO) != 0) {
+    /* TSLOG_BINARY=1 grava registros binários (ler com tslog-decode) */
+    const char *binary_log = getenv("TSLOG_BINARY");
+    int use_binary_log = binary_log && binary_log[0] == '1';
+    snprintf(log_path, sizeof(log_path), "%s%s%s", log_name, role_suffix, use_binary_log ? ".bin.log" : ".log");
+
+    if (tslog_init(&logger, log_path, TSLOG_INFO) != 0) {
         fprintf(stderr, "Erro ao inicializar logger\n");
         return 1;
     }
 
+    if (use_binary_log) {
+        tslog_enable_binary(&logger);
+    }
+
+    /* Log assíncrono: a escrita em disco sai das seções críticas da fila */
+    if (tslog_enable_async(&logger, 0, TSLOG_OVERFLOW_SYNC) != 0) {
+        fprintf(stderr, "Aviso: log assíncrono indisponível, usando modo síncrono\n");
+    }
+    tslog_install_crash_handler(&logger);
+
+    /* Rotação por tamanho/dia com gzip em background; SIGHUP reabre o arquivo */
+    if (tslog_enable_rotation(&logger, LOG_ROTATE_SIZE, LOG_ROTATE_INTERVAL, LOG_ROTATE_KEEP, 1) != 0) {
+        fprintf(stderr, "Aviso: rotação de log indisponível\n");
+    }
+    tslog_install_sighup(&logger);
+
+    /* Mensagens por job: limitadas por ponto de chamada (ajustável com `log` no monitor) */
+    tslog_set_rate_limit("queue", LOG_HOT_PATH_PER_SECOND, 1);
+    tslog_set_rate_limit("protocol", LOG_HOT_PATH_PER_SECOND, 1);
+    tslog_set_rate_limit("database", LOG_HOT_PATH_PER_SECOND, 1);
+
     tslog_info(&logger, "=== SERVIDOR INICIADO ===");
 
     /* INICIALIZAÇÃO DO DATABASE (NOVO) */
+    database_set_file(db_path);
     if (database_init(&logger) != 0) {
         tslog_error(&logger, "Erro ao inicializar database");
         monitor_cli_destroy(&monitor_cli);
@@ -133,12 +1100,127 @@ int main() {
         return 1;
     }
 
+    /* Estado por id para STATUS/LIST_JOBS, fora do mutex da fila */
+    if (job_index_init(&job_index) != 0) {
+        tslog_error(&logger, "Erro ao inicializar índice de jobs");
+        job_queue_destroy(&job_queue);
+        return 1;
+    }
+    job_queue_attach_index(&job_queue, &job_index);
+    if (shard >= 0) {
+        job_queue_set_shard(&job_queue, shard);
+    }
+    job_queue_set_next_id(&job_queue, database_get_max_job_id() + 1);
+
+    /* Chaves de idempotência das submissões (restauradas do banco) */
+    if (idempotency_init(&idempotency, idem_ttl, idem_max, &logger) != 0) {
+        tslog_error(&logger, "Erro ao inicializar chaves de idempotência");
+        job_queue_destroy(&job_queue);
+        return 1;
+    }
+    idempotency_load(&idempotency);
+
+    /* Replicação: log das transições para standbys, ou standby de outro servidor */
+    if (replication_init(&replication, &job_queue, &job_index, &idempotency, &logger) != 0) {
+        tslog_error(&logger, "Erro ao inicializar replicação");
+        job_queue_destroy(&job_queue);
+        return 1;
+    }
+    if (standby_of && replication_set_standby(&replication, standby_of, failover_timeout) != 0) {
+        tslog_error(&logger, "Primário inválido em --standby-of: %s", standby_of);
+        usage(argv[0]);
+        return 1;
+    }
+    if (replicate && !standby_of) {
+        replication_enable(&replication);
+    }
+    job_queue_set_enqueue_hook(&job_queue, replicate_enqueue, &replication);
+    job_index_set_update_hook(&job_index, replicate_status, &replication);
+
+    /* Capacidades exigidas pelos jobs e anunciadas pelos workers */
+    capability_registry_init(&capabilities);
+    job_queue_attach_capabilities(&job_queue, &capabilities);
+
+    /* Prazos: modo EDF e histórico de duração por script */
+    runtime_history_init(&runtime_history);
+    job_queue_attach_history(&job_queue, &runtime_history);
+    job_queue_set_mode(&job_queue, queue_mode);
+
+    /* Admissão: marcas alta/baixa de profundidade e memória */
+    job_queue_set_watermarks(&job_queue, queue_high, queue_low,
+                             (size_t)(queue_mem_mb > 0 ? queue_mem_mb : 0) * 1024 * 1024, 0);
+
+    /* Fila justa: envelhecimento de prioridade e pesos por cliente */
+    job_queue_set_aging(&job_queue, aging);
+    for (int i = 0; i < client_weight_count; i++) {
+        char client[JOB_CLIENT_MAX];
+        const char *eq = strchr(client_weights[i], '=');
+        snprintf(client, sizeof(client), "%.*s", (int)(eq - client_weights[i]), client_weights[i]);
+        if (job_queue_set_weight(&job_queue, client, atoi(eq + 1)) != 0) {
+            tslog_warn(&logger, "Peso inválido ignorado: %s", client_weights[i]);
+        }
+    }
+
+    /* Leases dos jobs em execução: prazo, nova tentativa e dead-letter */
+    if (lease_table_init(&job_leases, &job_queue, &logger) != 0) {
+        tslog_error(&logger, "Erro ao inicializar tabela de leases");
+        job_queue_destroy(&job_queue);
+        return 1;
+    }
+    lease_table_set_max_attempts(&job_leases, max_attempts);
+    lease_table_set_hedging(&job_leases, &runtime_history, hedge_percentile, hedge_budget);
+
+    /* Dependências entre jobs (after=/batch=) */
+    if (job_graph_init(&job_graph, &job_queue, &logger) != 0) {
+        tslog_error(&logger, "Erro ao inicializar grafo de dependências");
+        lease_table_destroy(&job_leases);
+        job_queue_destroy(&job_queue);
+        return 1;
+    }
+    lease_table_set_dead_letter_hook(&job_leases, graph_dead_letter, &job_graph);
+    job_queue_set_expire_hook(&job_queue, graph_expired, &job_graph);
+
+    /* Notificações de término para quem assina job=, batch= ou tag= */
+    if (notifier_init(&notifier, &logger) != 0) {
+        tslog_error(&logger, "Erro ao inicializar notificações");
+        lease_table_destroy(&job_leases);
+        job_queue_destroy(&job_queue);
+        return 1;
+    }
+    job_graph_set_final_hook(&job_graph, notify_graph_final, &notifier);
+
+    /* Jobs adiados e recorrentes (restaurados da tabela schedules) */
+    if (job_scheduler_init(&job_scheduler, &job_queue, &logger) != 0) {
+        tslog_error(&logger, "Erro ao inicializar agendador");
+        lease_table_destroy(&job_leases);
+        job_queue_destroy(&job_queue);
+        return 1;
+    }
+    if (shard >= 0) {
+        job_scheduler_set_shard(&job_scheduler, shard);
+    }
+    job_scheduler_load(&job_scheduler);
+
+    /* Estatísticas incrementais (restauradas da tabela de resumo) */
+    if (job_stats_init(&job_stats) != 0) {
+        tslog_error(&logger, "Erro ao inicializar estatísticas");
+        job_queue_destroy(&job_queue);
+        return 1;
+    }
+    job_stats_load(&job_stats);
+    job_queue_attach_stats(&job_queue, &job_stats);
+
     /* INICIALIZAÇÃO DO WORKER MANAGER (NOVO) */
     if (worker_manager_init(&worker_manager, &logger, &job_queue) != 0) {
         tslog_error(&logger, "Erro ao inicializar worker manager");
         job_queue_destroy(&job_queue);
         return 1;
     }
+    worker_manager_set_timeout(&worker_manager, worker_timeout);
+    worker_manager_set_policy(&worker_manager, placement);
+    worker_manager_attach_leases(&worker_manager, &job_leases);
+    worker_manager_attach_capabilities(&worker_manager, &capabilities);
+    database_load_worker_profiles(load_profile, &worker_manager);
 
     /* INICIALIZAÇÃO DO MONITOR CLI (NOVO) */
     if (monitor_cli_init(&monitor_cli, &job_queue, &worker_manager, &logger) != 0) {
@@ -148,33 +1230,48 @@ int main() {
         return 1;
     }
 
-    /* Criar socket */
-    server_socket = socket(AF_INET, SOCK_STREAM, 0);
-    if (server_socket < 0) {
-        tslog_error(&logger, "Erro ao criar socket");
-        return 1;
-    }
+    monitor_cli_attach_scheduler(&monitor_cli, &job_scheduler);
+    monitor_cli_attach_graph(&monitor_cli, &job_graph);
+    monitor_cli_attach_replication(&monitor_cli, &replication);
+    monitor_cli_attach_notifier(&monitor_cli, &notifier);
 
-    int opt = 1;
-    setsockopt(server_socket, SOL_SOCKET, SO_REUSEADDR, &opt, sizeof(opt));
-
-    server_addr.sin_family = AF_INET;
-    server_addr.sin_addr.s_addr = INADDR_ANY;
-    server_addr.sin_port = htons(SERVER_PORT);
-
-    if (bind(server_socket, (struct sockaddr*)&server_addr, sizeof(server_addr)) < 0) {
-        tslog_error(&logger, "Erro no bind");
-        close(server_socket);
+    /* Sockets TCP: um por acceptor (SO_REUSEPORT com mais de um) */
+    if (acceptor_set_init(&acceptors, port, backlog > 0 ? backlog : LISTEN_BACKLOG, acceptor_count,
+                          cpus, cpu_count, &logger) != 0) {
         return 1;
     }
+    monitor_cli_attach_acceptors(&monitor_cli, &acceptors);
 
-    if (listen(server_socket, MAX_CLIENTS) < 0) {
-        tslog_error(&logger, "Erro no listen");
-        close(server_socket);
-        return 1;
+    if (shard >= 0) {
+        tslog_info(&logger, "Servidor da shard %d ouvindo na porta %d", shard, port);
+    } else {
+        tslog_info(&logger, "Servidor ouvindo na porta %d", port);
+    }
+    for (int i = 0; i < acceptors.count; i++) {
+        if (acceptors.acceptors[i].cpu >= 0) {
+            tslog_info(&logger, "Acceptor %d na CPU %d", i, acceptors.acceptors[i].cpu);
+        } else if (acceptors.count > 1) {
+            tslog_info(&logger, "Acceptor %d sem afinidade", i);
+        }
     }
 
-    tslog_info(&logger, "Servidor ouvindo na porta %d", SERVER_PORT);
+    /* Socket local para clientes e workers na mesma máquina (ver local_transport.h) */
+    if (use_unix) {
+        char local_path[108];
+        local_socket_path(port, local_path, sizeof(local_path));
+        local_socket = local_listen(port, backlog > 0 ? backlog : LISTEN_BACKLOG);
+        if (local_socket < 0) {
+            tslog_warn(&logger, "Socket local %s indisponível: só TCP", local_path);
+        } else if (pthread_create(&local_thread, NULL, local_acceptor, (void*)(intptr_t)local_socket) != 0) {
+            tslog_error(&logger, "Erro ao criar thread do socket local");
+            close(local_socket);
+            local_unlink(port);
+            local_socket = -1;
+        } else {
+            pthread_detach(local_thread);
+            tslog_info(&logger, "Ouvindo também em %s", local_path);
+        }
+    }
 
     /* Thread para monitorar workers (NOVO) */
     if (pthread_create(&worker_monitor_thread, NULL, worker_monitor_thread_func, &worker_manager) != 0) {
@@ -182,64 +1279,70 @@ int main() {
         /* seguir com execução — dependendo do design, talvez deva abortar */
     }
 
-    /* Aceitar conexões */
-    while (server_running) {
-        client_socket = accept(server_socket, (struct sockaddr*)&client_addr, &client_len);
-        if (client_socket < 0) {
-            if (server_running) {
-                tslog_error(&logger, "Erro ao aceitar conexão");
-            }
-            continue;
-        }
+    /* Entrega por push aos workers que anunciam slots */
+    if (pthread_create(&dispatcher_thread, NULL, worker_dispatcher_thread_func, &worker_manager) != 0) {
+        tslog_error(&logger, "Erro ao criar thread de distribuição de jobs");
+    } else {
+        pthread_detach(dispatcher_thread);
+    }
+
+    if (pthread_create(&scheduler_thread, NULL, job_scheduler_thread_func, &job_scheduler) != 0) {
+        tslog_error(&logger, "Erro ao criar thread do agendador");
+    } else {
+        pthread_detach(scheduler_thread);
+    }
+
+    if (pthread_create(&stats_thread, NULL, stats_persister, &job_stats) != 0) {
+        tslog_error(&logger, "Erro ao criar thread de persistência de estatísticas");
+    } else {
+        pthread_detach(stats_thread);
+    }
+
+    if (pthread_create(&idempotency_thread, NULL, idempotency_flusher, &idempotency) != 0) {
+        tslog_error(&logger, "Erro ao criar thread de persistência das chaves de idempotência");
+    } else {
+        pthread_detach(idempotency_thread);
+    }
 
-        client_thread_args_t *args = malloc(sizeof(client_thread_args_t));
-        args->socket = client_socket;
-        args->address = client_addr;
-        args->queue = &job_queue;
-        args->logger = &logger;
+    if (standby_of) {
+        if (pthread_create(&replication_thread, NULL, replication_follow_thread, &replication) != 0) {
+            tslog_error(&logger, "Erro ao criar thread de replicação");
+        } else {
+            pthread_detach(replication_thread);
+        }
+    }
 
-        pthread_t client_thread;
-        if (pthread_create(&client_thread, NULL, client_handler, args) != 0) {
-            tslog_error(&logger, "Erro ao criar thread para cliente");
-            close(client_socket);
-            free(args);
+    /* Aceitar conexões: acceptor 0 na thread principal, os outros em threads próprias */
+    for (int i = 1; i < acceptors.count; i++) {
+        pthread_t acceptor_thread;
+        if (pthread_create(&acceptor_thread, NULL, tcp_acceptor, &acceptors.acceptors[i]) != 0) {
+            tslog_error(&logger, "Erro ao criar thread do acceptor %d", i);
         } else {
-            pthread_detach(client_thread);
+            pthread_detach(acceptor_thread);
         }
     }
+    tcp_acceptor(&acceptors.acceptors[0]);
 
     /* Cleanup */
     tslog_info(&logger, "Servidor finalizando...");
 
-    close(server_socket);
+    acceptor_set_destroy(&acceptors);
+    job_stats_persist(&job_stats);
+    idempotency_flush(&idempotency);
     database_close();
     monitor_cli_destroy(&monitor_cli);
     worker_manager_destroy(&worker_manager);
+    job_scheduler_destroy(&job_scheduler);
+    lease_table_destroy(&job_leases);
+    job_graph_destroy(&job_graph);
     job_queue_destroy(&job_queue);
+    job_stats_destroy(&job_stats);
+    job_index_destroy(&job_index);
+    capability_registry_destroy(&capabilities);
+    runtime_history_destroy(&runtime_history);
+    idempotency_destroy(&idempotency);
+    replication_destroy(&replication);
     tslog_destroy(&logger);
 
     return 0;
 }
-void job_queue_get_stats(job_queue_t *queue, int *total, int *pending, int *running, int *completed) {
-    if (!queue) return;
-    
-    pthread_mutex_lock(&queue->mutex);
-    
-    *total = queue->size;
-    *pending = 0;
-    *running = 0;
-    *completed = 0;
-    
-    job_node_t *current = queue->head;
-    while (current != NULL) {
-        switch (current->job.status) {
-            case JOB_PENDING: (*pending)++; break;
-            case JOB_RUNNING: (*running)++; break;
-            case JOB_COMPLETED: (*completed)++; break;
-            default: break;
-        }
-        current = current->next;
-    }
-    
-    pthread_mutex_unlock(&queue->mutex);
-}
\ No newline at end of file
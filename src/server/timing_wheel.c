@@ -0,0 +1,119 @@
+#include <stdlib.h>
+#include <time.h>
+#include "timing_wheel.h"
+
+static long monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
+static void list_init(timer_node_t *head) {
+    head->prev = head;
+    head->next = head;
+}
+
+static void list_append(timer_node_t *head, timer_node_t *node) {
+    node->prev = head->prev;
+    node->next = head;
+    head->prev->next = node;
+    head->prev = node;
+}
+
+int timing_wheel_init(timing_wheel_t *wheel, size_t slots, int tick_ms) {
+    size_t size = 16;
+    while (size < slots) size <<= 1;
+
+    wheel->slots = malloc(size * sizeof(timer_node_t));
+    if (!wheel->slots) return -1;
+
+    for (size_t i = 0; i < size; i++) {
+        list_init(&wheel->slots[i]);
+    }
+    wheel->mask = size - 1;
+    wheel->tick_ms = tick_ms > 0 ? tick_ms : 1;
+    wheel->current = 0;
+    wheel->origin_ms = monotonic_ms();
+    return 0;
+}
+
+// Os nós pertencem a quem os agendou; aqui só são desligados da roda
+void timing_wheel_destroy(timing_wheel_t *wheel) {
+    if (!wheel->slots) return;
+
+    for (size_t i = 0; i <= wheel->mask; i++) {
+        timer_node_t *head = &wheel->slots[i];
+        while (head->next != head) {
+            timing_wheel_cancel(head->next);
+        }
+    }
+    free(wheel->slots);
+    wheel->slots = NULL;
+}
+
+void timing_wheel_cancel(timer_node_t *node) {
+    if (!node->next) return;
+
+    node->prev->next = node->next;
+    node->next->prev = node->prev;
+    node->prev = NULL;
+    node->next = NULL;
+}
+
+int timing_wheel_pending(const timer_node_t *node) {
+    return node->next != NULL;
+}
+
+void timing_wheel_schedule(timing_wheel_t *wheel, timer_node_t *node, long delay_ms) {
+    timing_wheel_cancel(node);
+
+    long ticks = (delay_ms + wheel->tick_ms - 1) / wheel->tick_ms;
+    if (ticks < 1) ticks = 1;
+
+    // Conta a partir do relógio, não de `current`: a roda pode estar atrasada
+    long now_tick = (monotonic_ms() - wheel->origin_ms) / wheel->tick_ms;
+    if (now_tick < wheel->current) now_tick = wheel->current;
+
+    node->expires = now_tick + ticks;
+    list_append(&wheel->slots[node->expires & (long)wheel->mask], node);
+}
+
+int timing_wheel_advance(timing_wheel_t *wheel, void (*expire)(timer_node_t *node, void *arg), void *arg) {
+    long target = (monotonic_ms() - wheel->origin_ms) / wheel->tick_ms;
+    if (target <= wheel->current) return 0;
+
+    // Atraso maior que uma volta: uma passada por todos os slots basta,
+    // porque cada nó é comparado com `target`, não com o tick do slot
+    long first = wheel->current + 1;
+    if (target - first > (long)wheel->mask) {
+        first = target - (long)wheel->mask;
+    }
+
+    // Junta os vencidos numa lista própria antes dos callbacks, que podem
+    // cancelar ou reagendar outros timers
+    timer_node_t expired;
+    list_init(&expired);
+
+    for (long tick = first; tick <= target; tick++) {
+        timer_node_t *head = &wheel->slots[tick & (long)wheel->mask];
+        timer_node_t *node = head->next;
+        while (node != head) {
+            timer_node_t *next = node->next;
+            if (node->expires <= target) {
+                timing_wheel_cancel(node);
+                list_append(&expired, node);
+            }
+            node = next;
+        }
+    }
+    wheel->current = target;
+
+    int count = 0;
+    while (expired.next != &expired) {
+        timer_node_t *node = expired.next;
+        timing_wheel_cancel(node);
+        expire(node, arg);
+        count++;
+    }
+    return count;
+}
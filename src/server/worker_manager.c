@@ -4,67 +4,879 @@
 #include <unistd.h>
 #include <pthread.h>
 #include <time.h>
+#include <errno.h>
+#include <sys/socket.h>
 #include "worker_manager.h"
 #include "../../include/tslog.h"
 
+static long monotonic_ms(void) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return (long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+}
+
 // Implementação das funções
 int worker_manager_init(worker_manager_t *manager, tslog_t *logger, job_queue_t *queue) {
     if (!manager || !logger || !queue) return -1;
     
     manager->logger = logger;
     manager->queue = queue;
+    manager->leases = NULL;
+    manager->caps = NULL;
+    manager->next_worker_id = 0;
+    manager->heartbeat_timeout = WORKER_TIMEOUT;
+    manager->running = 1;
+    manager->profiles = NULL;
+    manager->profile_count = 0;
+    manager->profile_capacity = 0;
+    manager->available_count = 0;
+    manager->policy = PLACEMENT_P2C;
+    manager->rr_cursor = 0;
+    manager->rand_state = (unsigned int)time(NULL);
     
     if (pthread_mutex_init(&manager->lock, NULL) != 0) {
         tslog_error(logger, "Falha ao inicializar mutex do worker manager");
         return -1;
     }
     
-    tslog_info(logger, "Worker Manager inicializado");
+    if (pthread_cond_init(&manager->capacity_cond, NULL) != 0) {
+        pthread_mutex_destroy(&manager->lock);
+        tslog_error(logger, "Falha ao inicializar condition variable do worker manager");
+        return -1;
+    }
+    
+    if (int_map_init(&manager->workers, 64) != 0 ||
+        timing_wheel_init(&manager->heartbeats, WORKER_WHEEL_SLOTS, WORKER_WHEEL_TICK_MS) != 0) {
+        tslog_error(logger, "Falha ao alocar registro de workers");
+        int_map_destroy(&manager->workers);
+        pthread_cond_destroy(&manager->capacity_cond);
+        pthread_mutex_destroy(&manager->lock);
+        return -1;
+    }
+    
+    tslog_info(logger, "Worker Manager inicializado (timeout de heartbeat: %ds)",
+               manager->heartbeat_timeout);
     return 0;
 }
 
+static void free_entry(worker_entry_t *entry) {
+    close(entry->socket);
+    if (entry->channel) {
+        shm_channel_close(entry->channel);
+        free(entry->channel);
+    }
+    pthread_mutex_destroy(&entry->send_mutex);
+    free(entry);
+}
+
+static void free_worker(int key, void *value, void *arg) {
+    (void)key; (void)arg;
+    free_entry(value);
+}
+
 void worker_manager_destroy(worker_manager_t *manager) {
     if (!manager) return;
     
+    pthread_mutex_lock(&manager->lock);
+    manager->running = 0;
+    pthread_cond_broadcast(&manager->capacity_cond);
+    timing_wheel_destroy(&manager->heartbeats);
+    int_map_foreach(&manager->workers, free_worker, NULL);
+    int_map_destroy(&manager->workers);
+    for (int i = 0; i < manager->profile_count; i++) {
+        free(manager->profiles[i]->available);
+        free(manager->profiles[i]);
+    }
+    free(manager->profiles);
+    manager->profiles = NULL;
+    manager->profile_count = 0;
+    pthread_mutex_unlock(&manager->lock);
+    
+    pthread_cond_destroy(&manager->capacity_cond);
     pthread_mutex_destroy(&manager->lock);
     tslog_info(manager->logger, "Worker Manager destruído");
 }
 
-int worker_manager_register(worker_manager_t *manager, int socket, const char *hostname) {
-    (void)manager; (void)socket; (void)hostname;
-    tslog_info(manager->logger, "Worker registrado: %s", hostname);
-    return 1;
+void worker_manager_set_timeout(worker_manager_t *manager, int seconds) {
+    if (!manager || seconds <= 0) return;
+    
+    pthread_mutex_lock(&manager->lock);
+    manager->heartbeat_timeout = seconds;
+    pthread_mutex_unlock(&manager->lock);
+    
+    tslog_info(manager->logger, "Timeout de heartbeat dos workers: %ds", seconds);
+}
+
+static int hedge_job(const job_t *job, int worker_id, void *arg);
+
+void worker_manager_attach_leases(worker_manager_t *manager, lease_table_t *leases) {
+    pthread_mutex_lock(&manager->lock);
+    manager->leases = leases;
+    pthread_mutex_unlock(&manager->lock);
+    
+    // Cópias especulativas saem pelos workers push livres
+    lease_table_set_hedge_hook(leases, hedge_job, manager);
+}
+
+void worker_manager_attach_capabilities(worker_manager_t *manager, capability_registry_t *caps) {
+    pthread_mutex_lock(&manager->lock);
+    manager->caps = caps;
+    pthread_mutex_unlock(&manager->lock);
+}
+
+/* ---- Perfis de capacidades ---- */
+
+// Busca (ou cria) o perfil da máscara. Chamar com manager->lock.
+static worker_profile_t *get_profile(worker_manager_t *manager, cap_mask_t caps) {
+    for (int i = 0; i < manager->profile_count; i++) {
+        if (manager->profiles[i]->caps == caps) return manager->profiles[i];
+    }
+    
+    if (manager->profile_count == manager->profile_capacity) {
+        int capacity = manager->profile_capacity ? manager->profile_capacity * 2 : 8;
+        worker_profile_t **grown = realloc(manager->profiles, (size_t)capacity * sizeof(worker_profile_t*));
+        if (!grown) return NULL;
+        manager->profiles = grown;
+        manager->profile_capacity = capacity;
+    }
+    
+    worker_profile_t *profile = calloc(1, sizeof(worker_profile_t));
+    if (!profile) return NULL;
+    profile->caps = caps;
+    if (manager->caps) {
+        capability_format(manager->caps, caps, profile->tags, sizeof(profile->tags));
+    }
+    manager->profiles[manager->profile_count++] = profile;
+    return profile;
+}
+
+int worker_manager_add_profile(worker_manager_t *manager, const char *tags) {
+    cap_mask_t caps = 0;
+    if (manager->caps && capability_intern(manager->caps, tags, &caps) != 0) return -1;
+    
+    pthread_mutex_lock(&manager->lock);
+    worker_profile_t *profile = get_profile(manager, caps);
+    pthread_mutex_unlock(&manager->lock);
+    return profile ? 0 : -1;
+}
+
+int worker_manager_can_satisfy(worker_manager_t *manager, const char *needs,
+                               char *reason, size_t reason_size) {
+    if (!needs || !needs[0] || !manager->caps) return 1;
+    
+    char unknown[CAPABILITY_NAME_MAX] = "";
+    cap_mask_t mask = 0;
+    int rc = capability_lookup(manager->caps, needs, &mask, unknown, sizeof(unknown));
+    
+    pthread_mutex_lock(&manager->lock);
+    int known = manager->profile_count;
+    int found = 0;
+    for (int i = 0; i < manager->profile_count && !found; i++) {
+        found = capability_satisfies(manager->profiles[i]->caps, mask);
+    }
+    pthread_mutex_unlock(&manager->lock);
+    
+    // Sem nenhum worker visto ainda não há como julgar
+    if (known == 0 && rc >= 0) return 1;
+    
+    if (rc < 0) {
+        snprintf(reason, reason_size, "capacidades inválidas: %s", needs);
+    } else if (rc > 0) {
+        snprintf(reason, reason_size, "nenhum worker oferece a capacidade %s", unknown);
+    } else if (!found) {
+        snprintf(reason, reason_size, "nenhum worker oferece [%s]", needs);
+    } else {
+        return 1;
+    }
+    return 0;
+}
+
+static const char *policy_names[] = {"p2c", "round-robin", "least-loaded"};
+
+const char* worker_manager_policy_name(placement_policy_t policy) {
+    return (unsigned)policy < sizeof(policy_names) / sizeof(policy_names[0])
+           ? policy_names[policy] : "desconhecida";
+}
+
+int worker_manager_policy_from_name(const char *name, placement_policy_t *policy) {
+    for (size_t i = 0; i < sizeof(policy_names) / sizeof(policy_names[0]); i++) {
+        if (strcmp(name, policy_names[i]) == 0) {
+            *policy = (placement_policy_t)i;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+void worker_manager_set_policy(worker_manager_t *manager, placement_policy_t policy) {
+    pthread_mutex_lock(&manager->lock);
+    manager->policy = policy;
+    pthread_mutex_unlock(&manager->lock);
+    
+    tslog_info(manager->logger, "Política de distribuição: %s", worker_manager_policy_name(policy));
+}
+
+/* ---- Conjunto de workers com slot livre (chamar com manager->lock) ---- */
+
+static int active_jobs(const worker_entry_t *entry) {
+    return entry->leased_count;
+}
+
+static void available_remove(worker_manager_t *manager, worker_entry_t *entry) {
+    int index = entry->available_index;
+    if (index < 0) return;
+    
+    worker_profile_t *profile = entry->profile;
+    worker_entry_t *last = profile->available[--profile->available_count];
+    profile->available[index] = last;
+    last->available_index = index;
+    entry->available_index = -1;
+    manager->available_count--;
+}
+
+static void available_add(worker_manager_t *manager, worker_entry_t *entry) {
+    if (entry->available_index >= 0) return;
+    
+    worker_profile_t *profile = entry->profile;
+    if (profile->available_count == profile->available_capacity) {
+        int capacity = profile->available_capacity ? profile->available_capacity * 2 : 16;
+        worker_entry_t **grown = realloc(profile->available, (size_t)capacity * sizeof(worker_entry_t*));
+        if (!grown) return;   // fica fora da distribuição até a próxima mudança
+        profile->available = grown;
+        profile->available_capacity = capacity;
+    }
+    
+    entry->available_index = profile->available_count;
+    profile->available[profile->available_count++] = entry;
+    manager->available_count++;
+    pthread_cond_signal(&manager->capacity_cond);
+    // O dispatcher pode estar esperando na fila com ofertas antigas
+    job_queue_wake(manager->queue);
 }
 
+static void update_availability(worker_manager_t *manager, worker_entry_t *entry) {
+    if (!entry->removed && entry->info.is_alive && entry->slots > 0 &&
+        active_jobs(entry) < entry->slots) {
+        available_add(manager, entry);
+    } else {
+        available_remove(manager, entry);
+    }
+}
+
+static void entry_put(worker_entry_t *entry) {
+    if (--entry->refs == 0 && entry->removed) {
+        free_entry(entry);
+    }
+}
+
+// Worker morto ou desconectado: sai da distribuição e os jobs que ele ainda
+// executava ganham nova tentativa (ou contam como falha sem tabela de leases).
+// A entrada continua no registro até o handler da conexão encerrar.
+static void retire_entry(worker_manager_t *manager, worker_entry_t *entry) {
+    if (!entry->info.is_alive) return;
+    
+    for (int i = 0; i < entry->leased_count; i++) {
+        if (manager->leases) {
+            lease_table_orphan(manager->leases, entry->leased[i].job_id, entry->info.worker_id);
+        } else {
+            job_stats_record_finish(manager->queue->stats, entry->leased[i].priority,
+                                    entry->info.worker_id, 0, 0.0);
+        }
+    }
+    entry->leased_count = 0;
+    entry->info.active_jobs = 0;
+    entry->info.is_alive = 0;
+    entry->profile->workers--;
+    timing_wheel_cancel(&entry->heartbeat_timer);
+    available_remove(manager, entry);
+}
+
+// Tira o worker do registro; a memória (e o socket) esperam os envios em andamento
+static void detach_entry(worker_manager_t *manager, worker_entry_t *entry) {
+    retire_entry(manager, entry);
+    job_stats_forget_worker(manager->queue->stats, entry->info.worker_id);
+    int_map_remove(&manager->workers, entry->info.worker_id);
+    entry->removed = 1;
+    
+    entry->refs++;
+    entry_put(entry);
+}
+
+static void occupy_slot(worker_entry_t *entry, const job_t *job) {
+    worker_lease_t *lease = &entry->leased[entry->leased_count++];
+    lease->job_id = job->job_id;
+    lease->priority = job->priority;
+    lease->leased_at = monotonic_ms();
+    entry->info.active_jobs = entry->leased_count;
+}
+
+// Ocupa o slot e abre o lease na mesma seção crítica: se o worker cair logo
+// depois, detach_entry já encontra o lease para devolver o job. Retorna -1
+// (sem ocupar nada) se o job foi cancelado depois de sair da fila.
+static int lease_job(worker_manager_t *manager, worker_entry_t *entry, job_t *job) {
+    if (manager->leases && lease_table_acquire(manager->leases, job, entry->info.worker_id) > 0) {
+        return -1;
+    }
+    occupy_slot(entry, job);
+    return 0;
+}
+
+static int unlease_job(worker_entry_t *entry, int job_id, worker_lease_t *out) {
+    for (int i = 0; i < entry->leased_count; i++) {
+        if (entry->leased[i].job_id == job_id) {
+            if (out) *out = entry->leased[i];
+            entry->leased[i] = entry->leased[--entry->leased_count];
+            entry->info.active_jobs = entry->leased_count;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+/* ---- Registro ---- */
+
+int worker_manager_register(worker_manager_t *manager, int socket, const char *hostname, int slots,
+                            const char *caps) {
+    cap_mask_t mask = 0;
+    if (manager->caps && caps && caps[0] && capability_intern(manager->caps, caps, &mask) != 0) {
+        tslog_error(manager->logger, "Capacidades inválidas (ou demais) do worker %s: %s", hostname, caps);
+        return -1;
+    }
+    
+    worker_entry_t *entry = calloc(1, sizeof(worker_entry_t));
+    if (!entry) {
+        tslog_error(manager->logger, "Sem memória para registrar worker %s", hostname);
+        return -1;
+    }
+    
+    snprintf(entry->info.hostname, sizeof(entry->info.hostname), "%s", hostname);
+    entry->info.last_heartbeat = time(NULL);
+    entry->info.is_alive = 1;
+    entry->socket = socket;
+    entry->slots = slots < 0 ? 0 : (slots > WORKER_MAX_SLOTS ? WORKER_MAX_SLOTS : slots);
+    entry->available_index = -1;
+    entry->refs = 1;   // do próprio registro, até o REGISTERED sair
+    entry->heartbeat_timer.data = entry;
+    pthread_mutex_init(&entry->send_mutex, NULL);
+    
+    pthread_mutex_lock(&manager->lock);
+    entry->profile = get_profile(manager, mask);
+    entry->info.worker_id = ++manager->next_worker_id;
+    if (!entry->profile || int_map_put(&manager->workers, entry->info.worker_id, entry) != 0) {
+        pthread_mutex_unlock(&manager->lock);
+        free_entry(entry);
+        tslog_error(manager->logger, "Sem memória para registrar worker %s", hostname);
+        return -1;
+    }
+    timing_wheel_schedule(&manager->heartbeats, &entry->heartbeat_timer,
+                          manager->heartbeat_timeout * 1000L);
+    entry->profile->workers++;
+    int worker_id = entry->info.worker_id;
+    int count = (int)manager->workers.size;
+    pthread_mutex_unlock(&manager->lock);
+    
+    // A resposta sai antes de o worker entrar na distribuição: nenhum JOB
+    // pode chegar antes do REGISTERED
+    char response[64];
+    snprintf(response, sizeof(response), "REGISTERED:%d", worker_id);
+    pthread_mutex_lock(&entry->send_mutex);
+    protocol_send_line(socket, response);
+    pthread_mutex_unlock(&entry->send_mutex);
+    
+    pthread_mutex_lock(&manager->lock);
+    update_availability(manager, entry);
+    entry_put(entry);
+    pthread_mutex_unlock(&manager->lock);
+    
+    tslog_info(manager->logger, "Worker %d registrado: %s (%d slots, capacidades [%s], %d ativos)",
+               worker_id, hostname, entry->slots, entry->profile->tags, count);
+    return worker_id;
+}
+
+// Chamado pelo handler da conexão ao encerrar, antes de fechar o socket
+void worker_manager_unregister(worker_manager_t *manager, int worker_id) {
+    char hostname[64] = "";
+    
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = int_map_get(&manager->workers, worker_id);
+    if (entry) {
+        snprintf(hostname, sizeof(hostname), "%s", entry->info.hostname);
+        detach_entry(manager, entry);
+    }
+    pthread_mutex_unlock(&manager->lock);
+    
+    if (entry) {
+        tslog_info(manager->logger, "Worker %d (%s) desconectado", worker_id, hostname);
+    }
+}
+
+// Modo pull: o handler já tirou o job da fila para este worker
 int worker_manager_assign_job(worker_manager_t *manager, int worker_id, job_t *job) {
-    (void)manager; (void)worker_id; (void)job;
-    tslog_info(manager->logger, "Job atribuído ao worker %d", worker_id);
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = int_map_get(&manager->workers, worker_id);
+    if (!entry || !entry->info.is_alive || entry->leased_count >= WORKER_MAX_SLOTS) {
+        pthread_mutex_unlock(&manager->lock);
+        return -1;
+    }
+    if (lease_job(manager, entry, job) != 0) {
+        pthread_mutex_unlock(&manager->lock);
+        return 1;
+    }
+    update_availability(manager, entry);
+    pthread_mutex_unlock(&manager->lock);
+    
+    job->assigned_worker = worker_id;
+    tslog_debug(manager->logger, "Job %d atribuído ao worker %d", job->job_id, worker_id);
     return 0;
 }
 
+int worker_manager_get_caps(worker_manager_t *manager, int worker_id, cap_mask_t *caps) {
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = int_map_get(&manager->workers, worker_id);
+    if (entry) {
+        *caps = entry->profile->caps;
+    }
+    pthread_mutex_unlock(&manager->lock);
+    
+    return entry ? 0 : -1;
+}
+
+int worker_manager_release_job(worker_manager_t *manager, int worker_id, int job_id, int *priority) {
+    int found = -1;
+    worker_lease_t lease;
+    
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = int_map_get(&manager->workers, worker_id);
+    if (entry && unlease_job(entry, job_id, &lease) == 0) {
+        // Média móvel exponencial: reage a mudanças sem guardar histórico
+        double latency = (monotonic_ms() - lease.leased_at) / 1000.0;
+        entry->info.avg_latency = entry->info.avg_latency > 0
+            ? WORKER_LATENCY_ALPHA * latency + (1 - WORKER_LATENCY_ALPHA) * entry->info.avg_latency
+            : latency;
+        update_availability(manager, entry);
+        if (priority) *priority = lease.priority;
+        found = 0;
+    }
+    pthread_mutex_unlock(&manager->lock);
+    
+    return found;
+}
+
+int worker_manager_cancel_job(worker_manager_t *manager, int worker_id, int job_id) {
+    int push = 0;
+    
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = int_map_get(&manager->workers, worker_id);
+    int found = entry && unlease_job(entry, job_id, NULL) == 0;
+    if (found) {
+        push = entry->slots > 0;
+        update_availability(manager, entry);
+    }
+    pthread_mutex_unlock(&manager->lock);
+    
+    if (!found) return -1;
+    
+    // Worker pull não espera linhas fora de REQUEST_JOB: o resultado dele
+    // chega depois e é descartado como atrasado
+    if (push) {
+        char line[64];
+        snprintf(line, sizeof(line), "CANCEL:%d", job_id);
+        worker_manager_send(manager, worker_id, line);
+    }
+    return 0;
+}
+
+int worker_manager_attach_channel(worker_manager_t *manager, int worker_id, shm_channel_t *channel) {
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = int_map_get(&manager->workers, worker_id);
+    int rc = -1;
+    if (entry && entry->slots > 0 && !entry->channel) {
+        // Com o send_mutex: o dispatcher vê o canal inteiro ou não vê
+        pthread_mutex_lock(&entry->send_mutex);
+        entry->channel = channel;
+        pthread_mutex_unlock(&entry->send_mutex);
+        rc = 0;
+    }
+    pthread_mutex_unlock(&manager->lock);
+    
+    if (rc == 0) {
+        tslog_info(manager->logger, "Worker %d usando memória compartilhada para jobs e resultados", worker_id);
+    }
+    return rc;
+}
+
+int worker_manager_send(worker_manager_t *manager, int worker_id, const char *line) {
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = int_map_get(&manager->workers, worker_id);
+    if (entry) entry->refs++;
+    pthread_mutex_unlock(&manager->lock);
+    
+    if (!entry) return -1;
+    
+    pthread_mutex_lock(&entry->send_mutex);
+    int rc = protocol_send_line(entry->socket, line);
+    pthread_mutex_unlock(&entry->send_mutex);
+    
+    pthread_mutex_lock(&manager->lock);
+    entry_put(entry);
+    pthread_mutex_unlock(&manager->lock);
+    return rc;
+}
+
 void worker_manager_heartbeat(worker_manager_t *manager, int worker_id) {
-    (void)manager; (void)worker_id;
-    // tslog_debug(manager->logger, "Heartbeat do worker %d", worker_id);
+    if (worker_id <= 0) return;
+    
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = int_map_get(&manager->workers, worker_id);
+    if (entry && entry->info.is_alive) {
+        entry->info.last_heartbeat = time(NULL);
+        timing_wheel_schedule(&manager->heartbeats, &entry->heartbeat_timer,
+                              manager->heartbeat_timeout * 1000L);
+    }
+    pthread_mutex_unlock(&manager->lock);
+}
+
+// Chamado com manager->lock: o worker sai do registro e a conexão é
+// derrubada, o que faz o handler dela encerrar
+static void expire_worker(timer_node_t *node, void *arg) {
+    worker_manager_t *manager = (worker_manager_t*)arg;
+    worker_entry_t *entry = (worker_entry_t*)node->data;
+    
+    tslog_warn(manager->logger, "Worker %d (%s) sem heartbeat há %lds - considerado morto (%d jobs em execução)",
+               entry->info.worker_id, entry->info.hostname,
+               (long)(time(NULL) - entry->info.last_heartbeat), entry->leased_count);
+    
+    // O handler acorda com EOF e chama worker_manager_unregister, que libera
+    // a entrada; fechar o socket aqui deixaria o handler lendo um fd reaproveitável
+    shutdown(entry->socket, SHUT_RDWR);
+    retire_entry(manager, entry);
 }
 
 void worker_manager_check_heartbeats(worker_manager_t *manager) {
-    (void)manager;
-    //tslog_debug(manager->logger, "Verificando heartbeats");
+    pthread_mutex_lock(&manager->lock);
+    timing_wheel_advance(&manager->heartbeats, expire_worker, manager);
+    pthread_mutex_unlock(&manager->lock);
+}
+
+int worker_manager_get(worker_manager_t *manager, int worker_id, worker_info_t *info) {
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = int_map_get(&manager->workers, worker_id);
+    if (entry) {
+        *info = entry->info;
+    }
+    pthread_mutex_unlock(&manager->lock);
+    
+    return entry ? 0 : -1;
+}
+
+int worker_manager_count(worker_manager_t *manager) {
+    pthread_mutex_lock(&manager->lock);
+    int count = (int)manager->workers.size;
+    pthread_mutex_unlock(&manager->lock);
+    return count;
+}
+
+static void log_worker(int key, void *value, void *arg) {
+    (void)key;
+    worker_manager_t *manager = (worker_manager_t*)arg;
+    worker_entry_t *entry = (worker_entry_t*)value;
+    
+    tslog_info(manager->logger, "Worker %d: %s [%s] - %d/%d jobs, latência média %.3fs, último heartbeat há %lds%s",
+               entry->info.worker_id, entry->info.hostname, entry->profile->tags,
+               entry->leased_count, entry->slots,
+               entry->info.avg_latency, (long)(time(NULL) - entry->info.last_heartbeat),
+               entry->channel ? ", memória compartilhada" : "");
 }
 
 void worker_manager_list(worker_manager_t *manager) {
     if (!manager) return;
-    tslog_info(manager->logger, "Workers ativos: 0 (implementação básica)");
+    
+    pthread_mutex_lock(&manager->lock);
+    tslog_info(manager->logger, "Workers ativos: %zu (%d com slot livre, %d perfis de capacidades, política %s)",
+               manager->workers.size, manager->available_count, manager->profile_count,
+               worker_manager_policy_name(manager->policy));
+    int_map_foreach(&manager->workers, log_worker, manager);
+    pthread_mutex_unlock(&manager->lock);
+}
+
+// Lease vencido: o job já ganhou nova tentativa; só libera o slot do worker
+static void lease_expired(int worker_id, int job_id, void *arg) {
+    worker_manager_t *manager = (worker_manager_t*)arg;
+    
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = int_map_get(&manager->workers, worker_id);
+    if (entry && unlease_job(entry, job_id, NULL) == 0) {
+        update_availability(manager, entry);
+    }
+    pthread_mutex_unlock(&manager->lock);
 }
 
 void* worker_monitor_thread_func(void *arg) {
     worker_manager_t *manager = (worker_manager_t*)arg;
+    int ticks_per_list = WORKER_LIST_INTERVAL * 1000 / WORKER_WHEEL_TICK_MS;
     
-    while (1) {
-        sleep(30);
+    // Um tick da roda por iteração: um worker morto é detectado no máximo
+    // WORKER_WHEEL_TICK_MS depois do prazo
+    for (int tick = 1; manager->running; tick++) {
+        usleep(WORKER_WHEEL_TICK_MS * 1000);
         worker_manager_check_heartbeats(manager);
-        worker_manager_list(manager);
+        if (manager->leases) {
+            lease_table_check(manager->leases, lease_expired, manager);
+        }
+        
+        if (tick % ticks_per_list == 0) {
+            worker_manager_list(manager);
+        }
+    }
+    
+    return NULL;
+}
+
+/* ---- Distribuição (modo push) ---- */
+
+// Carga estimada: ocupação dos slots ponderada pela latência recente.
+// Workers sem histórico contam como latência de 1s.
+static double worker_load(const worker_entry_t *entry) {
+    double latency = entry->info.avg_latency > 0 ? entry->info.avg_latency : 1.0;
+    return (active_jobs(entry) + 1) * latency / entry->slots;
+}
+
+// i-ésimo worker livre entre os perfis que atendem `needs`. Chamar com manager->lock.
+static worker_entry_t* nth_available(worker_manager_t *manager, cap_mask_t needs, int i) {
+    for (int p = 0; p < manager->profile_count; p++) {
+        worker_profile_t *profile = manager->profiles[p];
+        if (!capability_satisfies(profile->caps, needs)) continue;
+        if (i < profile->available_count) return profile->available[i];
+        i -= profile->available_count;
+    }
+    return NULL;
+}
+
+// Worker livre que atende `needs`, ou NULL. Chamar com manager->lock.
+static worker_entry_t* pick_worker(worker_manager_t *manager, cap_mask_t needs) {
+    int n = 0;
+    for (int p = 0; p < manager->profile_count; p++) {
+        if (capability_satisfies(manager->profiles[p]->caps, needs)) {
+            n += manager->profiles[p]->available_count;
+        }
+    }
+    if (n <= 1) return n ? nth_available(manager, needs, 0) : NULL;
+    
+    switch (manager->policy) {
+        case PLACEMENT_ROUND_ROBIN:
+            return nth_available(manager, needs, (int)(manager->rr_cursor++ % (unsigned)n));
+            
+        case PLACEMENT_LEAST_LOADED: {
+            worker_entry_t *best = NULL;
+            for (int i = 0; i < n; i++) {
+                worker_entry_t *candidate = nth_available(manager, needs, i);
+                if (!best || worker_load(candidate) < worker_load(best)) {
+                    best = candidate;
+                }
+            }
+            return best;
+        }
+        
+        case PLACEMENT_P2C:
+        default: {
+            // Dois candidatos distintos sorteados; O(perfis) independente da frota
+            int a = rand_r(&manager->rand_state) % n;
+            int b = rand_r(&manager->rand_state) % (n - 1);
+            if (b >= a) b++;
+            worker_entry_t *first = nth_available(manager, needs, a);
+            worker_entry_t *second = nth_available(manager, needs, b);
+            return worker_load(second) < worker_load(first) ? second : first;
+        }
+    }
+}
+
+// Máscaras dos perfis com algum worker livre. Chamar com manager->lock.
+static int collect_offers(worker_manager_t *manager, cap_mask_t *offers, int max) {
+    int n = 0;
+    for (int p = 0; p < manager->profile_count && n < max; p++) {
+        if (manager->profiles[p]->available_count > 0) {
+            offers[n++] = manager->profiles[p]->caps;
+        }
+    }
+    return n;
+}
+
+// Envia JOB:<id>:<lease>:<script>:<timeout> pelo socket do worker, ou o job
+// pelo anel do canal local (cheio: pelo socket)
+static int deliver_job(worker_entry_t *entry, const job_t *job) {
+    pthread_mutex_lock(&entry->send_mutex);
+    if (entry->removed) {
+        pthread_mutex_unlock(&entry->send_mutex);
+        return -1;
+    }
+    if (entry->channel &&
+        shm_channel_push_job(entry->channel, job->job_id, job->lease_id, job->script, job->timeout) == 0) {
+        pthread_mutex_unlock(&entry->send_mutex);
+        return 0;
+    }
+    pthread_mutex_unlock(&entry->send_mutex);
+    
+    char line[PROTOCOL_LINE_MAX];
+    char script[MAX_SCRIPT_SIZE * 2];
+    protocol_escape(job->script, script, sizeof(script));
+    snprintf(line, sizeof(line), "JOB:%d:%d:%s:%d", job->job_id, job->lease_id, script, job->timeout);
+    
+    pthread_mutex_lock(&entry->send_mutex);
+    int rc = entry->removed ? -1 : protocol_send_line(entry->socket, line);
+    pthread_mutex_unlock(&entry->send_mutex);
+    return rc;
+}
+
+// Worker livre menos carregado que atende `needs`, fora `exclude`. Chamar com manager->lock.
+static worker_entry_t* pick_other_worker(worker_manager_t *manager, cap_mask_t needs, int exclude) {
+    worker_entry_t *best = NULL;
+    for (int p = 0; p < manager->profile_count; p++) {
+        worker_profile_t *profile = manager->profiles[p];
+        if (!capability_satisfies(profile->caps, needs)) continue;
+        for (int i = 0; i < profile->available_count; i++) {
+            worker_entry_t *candidate = profile->available[i];
+            if (candidate->info.worker_id != exclude &&
+                (!best || worker_load(candidate) < worker_load(best))) {
+                best = candidate;
+            }
+        }
+    }
+    return best;
+}
+
+// Cópia especulativa pedida pela tabela de leases (job passou do percentil
+// no worker `worker_id`): vai para outro worker livre, se houver
+static int hedge_job(const job_t *job, int worker_id, void *arg) {
+    worker_manager_t *manager = (worker_manager_t*)arg;
+    
+    cap_mask_t needs = 0;
+    if (manager->caps && job->needs[0]) {
+        capability_intern(manager->caps, job->needs, &needs);
+    }
+    
+    pthread_mutex_lock(&manager->lock);
+    worker_entry_t *entry = pick_other_worker(manager, needs, worker_id);
+    if (!entry) {
+        pthread_mutex_unlock(&manager->lock);
+        return -1;
+    }
+    if (lease_table_attach_hedge(manager->leases, job->job_id, entry->info.worker_id) != 0) {
+        // O job terminou nesse meio tempo ou o orçamento acabou
+        pthread_mutex_unlock(&manager->lock);
+        return 0;
+    }
+    occupy_slot(entry, job);
+    entry->refs++;
+    update_availability(manager, entry);
+    pthread_mutex_unlock(&manager->lock);
+    
+    int hedge_worker = entry->info.worker_id;
+    if (deliver_job(entry, job) != 0) {
+        pthread_mutex_lock(&manager->lock);
+        unlease_job(entry, job->job_id, NULL);
+        update_availability(manager, entry);
+        pthread_mutex_unlock(&manager->lock);
+        lease_table_drop_copy(manager->leases, job->job_id, job->lease_id, hedge_worker);
+    } else {
+        tslog_info(manager->logger, "Job %d lento no worker %d - cópia especulativa no worker %d",
+                   job->job_id, worker_id, hedge_worker);
+    }
+    
+    pthread_mutex_lock(&manager->lock);
+    entry_put(entry);
+    pthread_mutex_unlock(&manager->lock);
+    return 0;
+}
+
+static void wait_capacity(worker_manager_t *manager) {
+    struct timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += 1;
+    
+    while (manager->running && manager->available_count == 0) {
+        if (pthread_cond_timedwait(&manager->capacity_cond, &manager->lock, &deadline) == ETIMEDOUT) {
+            break;
+        }
+    }
+}
+
+void* worker_dispatcher_thread_func(void *arg) {
+    worker_manager_t *manager = (worker_manager_t*)arg;
+    cap_mask_t offers[WORKER_MAX_OFFERS];
+    
+    while (manager->running) {
+        // Só sai da fila um job que algum worker livre atende agora; o
+        // worker é escolhido depois, entre os perfis compatíveis com ele.
+        // Se os slots livres mudam durante a espera, a fila devolve 1 e as
+        // ofertas são recalculadas (ver available_add).
+        pthread_mutex_lock(&manager->lock);
+        wait_capacity(manager);
+        int offer_count = manager->running ? collect_offers(manager, offers, WORKER_MAX_OFFERS) : 0;
+        pthread_mutex_unlock(&manager->lock);
+        
+        if (offer_count == 0) continue;
+        
+        job_t job;
+        memset(&job, 0, sizeof(job));
+        if (job_queue_pop_for(manager->queue, &job, offers, offer_count, 1000) != 0) continue;
+        
+        cap_mask_t needs = 0;
+        if (manager->caps && job.needs[0]) {
+            capability_intern(manager->caps, job.needs, &needs);
+        }
+        
+        pthread_mutex_lock(&manager->lock);
+        int cancelled = 0;
+        worker_entry_t *entry = pick_worker(manager, needs);
+        if (entry) {
+            job.assigned_worker = entry->info.worker_id;
+            if (lease_job(manager, entry, &job) == 0) {
+                entry->refs++;
+                update_availability(manager, entry);
+            } else {
+                cancelled = 1;
+                entry = NULL;
+            }
+        }
+        pthread_mutex_unlock(&manager->lock);
+        
+        if (cancelled) continue;
+        if (!entry) {
+            // O worker livre sumiu entre a oferta e a escolha
+            if (!manager->leases || lease_table_cancel(manager->leases, job.job_id) != 0) {
+                job_queue_requeue(manager->queue, &job);
+            }
+            continue;
+        }
+        job_stats_record_assign(manager->queue->stats, job.assigned_worker);
+        
+        if (deliver_job(entry, &job) != 0) {
+            // Se o worker saiu do registro nesse meio tempo, o job já foi
+            // contabilizado junto com os outros dele
+            pthread_mutex_lock(&manager->lock);
+            int still_leased = unlease_job(entry, job.job_id, NULL) == 0;
+            update_availability(manager, entry);
+            pthread_mutex_unlock(&manager->lock);
+            
+            // O worker nunca recebeu o job: volta já, sem contar tentativa
+            if (still_leased) {
+                tslog_warn(manager->logger, "Falha ao entregar job %d ao worker %d - devolvendo à fila",
+                           job.job_id, job.assigned_worker);
+                if (manager->leases) {
+                    lease_table_cancel(manager->leases, job.job_id);
+                } else {
+                    job_queue_requeue(manager->queue, &job);
+                }
+            }
+        } else {
+            tslog_debug_limited(manager->logger, "dispatch", "Job %d entregue ao worker %d",
+                                job.job_id, job.assigned_worker);
+        }
+        
+        pthread_mutex_lock(&manager->lock);
+        entry_put(entry);
+        pthread_mutex_unlock(&manager->lock);
     }
     
     return NULL;
-}
\ No newline at end of file
+}
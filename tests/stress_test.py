@@ -20,7 +20,7 @@ def client_worker(client_id):
         sock.connect((SERVER_HOST, SERVER_PORT))
         
         script = random.choice(scripts)
-        message = f"JOB:{script}"
+        message = f"JOB:{script}\n"
         
         print(f"Client {client_id} sending: {message}")
         sock.send(message.encode())
@@ -0,0 +1,184 @@
+#include "../include/tslog.h"
+#include "../include/acceptor.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define CLIENTS 24
+
+tslog_t logger;
+
+// Porta livre agora (o kernel escolhe e ela é liberada em seguida)
+static int free_port() {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    socklen_t len = sizeof(addr);
+    int port = -1;
+    if (sock >= 0 && bind(sock, (struct sockaddr*)&addr, sizeof(addr)) == 0 &&
+        getsockname(sock, (struct sockaddr*)&addr, &len) == 0) {
+        port = ntohs(addr.sin_port);
+    }
+    if (sock >= 0) close(sock);
+    return port;
+}
+
+static int connect_local(int port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    addr.sin_port = htons(port);
+    if (sock >= 0 && connect(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0) {
+        close(sock);
+        return -1;
+    }
+    return sock;
+}
+
+// Conecta CLIENTS vezes e aceita em qualquer um dos sockets do conjunto;
+// retorna quantas conexões foram aceitas
+static int accept_all(acceptor_set_t *set, int port) {
+    int clients[CLIENTS];
+    for (int i = 0; i < CLIENTS; i++) clients[i] = connect_local(port);
+
+    int accepted = 0;
+    struct pollfd pfds[ACCEPTOR_MAX];
+    while (accepted < CLIENTS) {
+        for (int i = 0; i < set->count; i++) {
+            pfds[i].fd = set->acceptors[i].listen_socket;
+            pfds[i].events = POLLIN;
+            pfds[i].revents = 0;
+        }
+        if (poll(pfds, (nfds_t)set->count, 1000) <= 0) break;
+        for (int i = 0; i < set->count; i++) {
+            if (!(pfds[i].revents & POLLIN)) continue;
+            int conn = accept(pfds[i].fd, NULL, NULL);
+            if (conn < 0) continue;
+            acceptor_opened(&set->acceptors[i]);
+            close(conn);
+            acceptor_closed(&set->acceptors[i]);
+            accepted++;
+        }
+    }
+    for (int i = 0; i < CLIENTS; i++) {
+        if (clients[i] >= 0) close(clients[i]);
+    }
+    return accepted;
+}
+
+int test_parse_cpus() {
+    int cpus[8];
+    if (acceptor_parse_cpus("0-3,6", cpus, 8) != 5 || cpus[3] != 3 || cpus[4] != 6) {
+        fprintf(stderr, "Lista de CPUs válida lida errado\n");
+        return -1;
+    }
+    const char *invalid[] = {"3-1", "a", "1-", "-1", "0;1", "0-9"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        if (acceptor_parse_cpus(invalid[i], cpus, 8) != -1) {
+            fprintf(stderr, "Lista de CPUs inválida aceita: %s\n", invalid[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Vários sockets na mesma porta: todos recebem conexões do mesmo endereço e
+// os contadores somam o que cada um aceitou
+int test_reuseport() {
+    int port = free_port();
+    acceptor_set_t set;
+    if (port < 0 || acceptor_set_init(&set, port, 64, 3, NULL, 0, &logger) != 0) {
+        fprintf(stderr, "Conjunto de acceptors não criado na porta %d\n", port);
+        return -1;
+    }
+
+    int rc = 0;
+    if (set.count != 3) {
+        fprintf(stderr, "%d acceptors, esperado 3\n", set.count);
+        rc = -1;
+    }
+    int accepted = accept_all(&set, port);
+    acceptor_stats_t stats[ACCEPTOR_MAX];
+    int count = acceptor_set_get_stats(&set, stats, ACCEPTOR_MAX);
+    long total = 0;
+    double rate = 0;
+    for (int i = 0; i < count; i++) {
+        total += stats[i].accepted;
+        rate += stats[i].rate;
+        if (stats[i].active != 0) rc = -1;
+    }
+    if (rc == 0 && (accepted != CLIENTS || total != CLIENTS || rate <= 0)) {
+        fprintf(stderr, "%d conexões aceitas (%ld nos contadores), esperado %d\n", accepted, total, CLIENTS);
+        rc = -1;
+    }
+    acceptor_set_destroy(&set);
+    return rc;
+}
+
+// Porta já ocupada por um socket sem SO_REUSEPORT: o conjunto não entra
+// no grupo de outro processo
+int test_port_busy() {
+    int port = free_port();
+    acceptor_set_t busy, set;
+    if (port < 0 || acceptor_set_init(&busy, port, 16, 1, NULL, 0, &logger) != 0) return -1;
+
+    int rc = 0;
+    if (acceptor_set_init(&set, port, 16, 2, NULL, 0, &logger) == 0) {
+        fprintf(stderr, "Acceptors criados numa porta ocupada\n");
+        acceptor_set_destroy(&set);
+        rc = -1;
+    }
+    acceptor_set_destroy(&busy);
+    return rc;
+}
+
+// Sem SO_REUSEPORT: um socket só, sem afinidade, e as conexões chegam nele
+int test_fallback() {
+    setenv(ACCEPTOR_REUSEPORT_ENV, "0", 1);
+    int port = free_port();
+    int cpus[] = {0, 0, 0, 0};
+    acceptor_set_t set;
+    int rc = 0;
+    if (port < 0 || acceptor_set_init(&set, port, 64, 4, cpus, 4, &logger) != 0) {
+        fprintf(stderr, "Sem SO_REUSEPORT o conjunto não foi criado\n");
+        rc = -1;
+    } else {
+        if (set.count != 1 || set.acceptors[0].cpu != -1) {
+            fprintf(stderr, "%d acceptors (CPU %d) sem SO_REUSEPORT, esperado 1 sem afinidade\n",
+                    set.count, set.acceptors[0].cpu);
+            rc = -1;
+        }
+        if (rc == 0 && accept_all(&set, port) != CLIENTS) {
+            fprintf(stderr, "Acceptor único não recebeu todas as conexões\n");
+            rc = -1;
+        }
+        acceptor_set_destroy(&set);
+    }
+    unsetenv(ACCEPTOR_REUSEPORT_ENV);
+    return rc;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_acceptor.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+
+    int rc = 0;
+    if (test_parse_cpus() != 0) rc = 1;
+    if (rc == 0 && test_reuseport() != 0) rc = 1;
+    if (rc == 0 && test_port_busy() != 0) rc = 1;
+    if (rc == 0 && test_fallback() != 0) rc = 1;
+
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste dos acceptors concluído\n");
+    return rc;
+}
@@ -0,0 +1,188 @@
+#include "../include/tslog.h"
+#include "../include/job_queue.h"
+#include "../include/capability.h"
+#include "../include/worker_manager.h"
+#include <stdio.h>
+#include <string.h>
+
+tslog_t logger;
+
+// Tags viram bits na primeira vez; a ordem e as vírgulas não importam
+int test_masks() {
+    capability_registry_t caps;
+    if (capability_registry_init(&caps) != 0) return -1;
+
+    int rc = 0;
+    cap_mask_t python_gpu, gpu, reordered, unknown_mask;
+    char unknown[CAPABILITY_NAME_MAX] = "";
+    char formatted[CAPABILITY_LIST_MAX];
+    if (capability_intern(&caps, "python3,gpu", &python_gpu) != 0 ||
+        capability_intern(&caps, "gpu", &gpu) != 0 ||
+        capability_intern(&caps, ",gpu,,python3,", &reordered) != 0) {
+        fprintf(stderr, "Lista válida recusada\n");
+        rc = -1;
+    } else if (python_gpu != reordered || caps.count != 2 ||
+               !capability_satisfies(python_gpu, gpu) || capability_satisfies(gpu, python_gpu) ||
+               !capability_satisfies(gpu, 0)) {
+        fprintf(stderr, "Máscaras erradas (0x%llx, 0x%llx)\n",
+                (unsigned long long)python_gpu, (unsigned long long)gpu);
+        rc = -1;
+    } else if (capability_lookup(&caps, "gpu,cuda", &unknown_mask, unknown, sizeof(unknown)) != 1 ||
+               strcmp(unknown, "cuda") != 0 || caps.count != 2) {
+        fprintf(stderr, "Consulta registrou ou não apontou a tag desconhecida (%s)\n", unknown);
+        rc = -1;
+    } else {
+        capability_format(&caps, reordered, formatted, sizeof(formatted));
+        if (strcmp(formatted, "python3,gpu") != 0) {
+            fprintf(stderr, "Máscara formatada como \"%s\"\n", formatted);
+            rc = -1;
+        }
+    }
+
+    char long_name[CAPABILITY_NAME_MAX + 8];
+    memset(long_name, 'x', sizeof(long_name) - 1);
+    long_name[sizeof(long_name) - 1] = '\0';
+    if (rc == 0 && capability_intern(&caps, long_name, &unknown_mask) != -1) {
+        fprintf(stderr, "Tag longa demais aceita\n");
+        rc = -1;
+    }
+
+    // Bits esgotados: a 65ª tag é recusada
+    for (int i = caps.count; rc == 0 && i < CAPABILITY_MAX; i++) {
+        char tag[16];
+        snprintf(tag, sizeof(tag), "tag%d", i);
+        if (capability_intern(&caps, tag, &unknown_mask) != 0) rc = -1;
+    }
+    if (rc == 0 && capability_intern(&caps, "sobrando", &unknown_mask) != -1) {
+        fprintf(stderr, "Mais de %d capacidades aceitas\n", CAPABILITY_MAX);
+        rc = -1;
+    }
+    capability_registry_destroy(&caps);
+    return rc;
+}
+
+static int push_needs(job_queue_t *queue, const char *needs) {
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    snprintf(job.script, sizeof(job.script), "echo %s", needs);
+    snprintf(job.needs, sizeof(job.needs), "%s", needs);
+    job.priority = 5;
+    job.timeout = 60;
+    return job_queue_push(queue, &job);
+}
+
+// Só sai o job de uma faixa que a oferta atende; um job de GPU na frente não
+// segura os jobs comuns atrás dele
+int test_lanes() {
+    capability_registry_t caps;
+    job_queue_t queue;
+    if (capability_registry_init(&caps) != 0) return -1;
+    if (job_queue_init(&queue, &logger) != 0) {
+        capability_registry_destroy(&caps);
+        return -1;
+    }
+    job_queue_attach_capabilities(&queue, &caps);
+
+    int gpu_job = push_needs(&queue, "gpu");
+    int both_job = push_needs(&queue, "python3,gpu");
+    int plain_job = push_needs(&queue, "");
+
+    cap_mask_t python, gpu, python_gpu;
+    capability_intern(&caps, "python3", &python);
+    capability_intern(&caps, "gpu", &gpu);
+    capability_intern(&caps, "gpu,python3", &python_gpu);
+
+    int rc = 0;
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    if (job_queue_pop_for(&queue, &job, &python, 1, 0) != 0 || job.job_id != plain_job) {
+        fprintf(stderr, "Worker python3 recebeu o job %d, esperado %d\n", job.job_id, plain_job);
+        rc = -1;
+    }
+    if (rc == 0 && job_queue_pop_for(&queue, &job, &python, 1, 0) != 1) {
+        fprintf(stderr, "Worker python3 recebeu o job %d que exige gpu\n", job.job_id);
+        rc = -1;
+    }
+    memset(&job, 0, sizeof(job));
+    if (rc == 0 && (job_queue_pop_for(&queue, &job, &gpu, 1, 0) != 0 || job.job_id != gpu_job)) {
+        fprintf(stderr, "Worker gpu recebeu o job %d, esperado %d\n", job.job_id, gpu_job);
+        rc = -1;
+    }
+    // Duas ofertas: vale a que atende
+    cap_mask_t offers[2] = {gpu, python_gpu};
+    memset(&job, 0, sizeof(job));
+    if (rc == 0 && (job_queue_pop_for(&queue, &job, offers, 2, 0) != 0 || job.job_id != both_job ||
+                    job_queue_size(&queue) != 0)) {
+        fprintf(stderr, "Oferta combinada recebeu o job %d, esperado %d\n", job.job_id, both_job);
+        rc = -1;
+    }
+    if (rc == 0 && job_queue_pop_for(&queue, &job, NULL, 0, 0) != 1) {
+        fprintf(stderr, "Sem ofertas saiu um job\n");
+        rc = -1;
+    }
+
+    job_queue_destroy(&queue);
+    capability_registry_destroy(&caps);
+    return rc;
+}
+
+// Admissão pelo perfil dos workers já vistos: tag desconhecida ou
+// combinação que nenhum perfil oferece é recusada com o motivo
+int test_can_satisfy() {
+    capability_registry_t caps;
+    job_queue_t queue;
+    worker_manager_t manager;
+    if (capability_registry_init(&caps) != 0) return -1;
+    if (job_queue_init(&queue, &logger) != 0 || worker_manager_init(&manager, &logger, &queue) != 0) {
+        capability_registry_destroy(&caps);
+        return -1;
+    }
+    worker_manager_attach_capabilities(&manager, &caps);
+
+    int rc = 0;
+    char reason[128] = "";
+    if (!worker_manager_can_satisfy(&manager, "gpu", reason, sizeof(reason))) {
+        fprintf(stderr, "Sem perfis conhecidos recusou: %s\n", reason);
+        rc = -1;
+    }
+    worker_manager_add_profile(&manager, "python3,lua");
+    worker_manager_add_profile(&manager, "gpu");
+    if (rc == 0 && (!worker_manager_can_satisfy(&manager, "lua,python3", reason, sizeof(reason)) ||
+                    !worker_manager_can_satisfy(&manager, "", reason, sizeof(reason)))) {
+        fprintf(stderr, "Perfil existente recusado: %s\n", reason);
+        rc = -1;
+    }
+    reason[0] = '\0';
+    if (rc == 0 && (worker_manager_can_satisfy(&manager, "python3,cuda", reason, sizeof(reason)) ||
+                    !strstr(reason, "cuda"))) {
+        fprintf(stderr, "Tag desconhecida aceita (motivo \"%s\")\n", reason);
+        rc = -1;
+    }
+    reason[0] = '\0';
+    if (rc == 0 && (worker_manager_can_satisfy(&manager, "gpu,lua", reason, sizeof(reason)) ||
+                    reason[0] == '\0')) {
+        fprintf(stderr, "Combinação sem perfil aceita\n");
+        rc = -1;
+    }
+
+    worker_manager_destroy(&manager);
+    job_queue_destroy(&queue);
+    capability_registry_destroy(&caps);
+    return rc;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_capability.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+
+    int rc = 0;
+    if (test_masks() != 0) rc = 1;
+    if (rc == 0 && test_lanes() != 0) rc = 1;
+    if (rc == 0 && test_can_satisfy() != 0) rc = 1;
+
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste das capacidades concluído\n");
+    return rc;
+}
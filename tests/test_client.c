@@ -0,0 +1,197 @@
+#include "../include/tslog.h"
+#include "../include/scheduler_client.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+#define SERVER_IDLE_MS 300
+
+tslog_t logger;
+
+// Servidor falso: junta os STATUS que chegam e só responde (em ordem)
+// quando a conexão fica SERVER_IDLE_MS sem pedidos novos. Quantos pedidos
+// esperam juntos mostra a profundidade do pipeline do cliente.
+typedef struct {
+    int listener;
+    int expected;               // respostas até encerrar
+    int drop_first;             // derruba a primeira conexão sem responder
+    int connections;
+    int max_inflight;
+    int served;
+} fake_server_t;
+
+static void *server_thread(void *arg) {
+    fake_server_t *server = (fake_server_t*)arg;
+    char buffer[8192];
+    size_t len = 0;
+    int pending[256];
+    int pending_count = 0;
+    int conn = -1;
+
+    while (server->served < server->expected) {
+        if (conn < 0) {
+            conn = accept(server->listener, NULL, NULL);
+            if (conn < 0) break;
+            server->connections++;
+            len = 0;
+            pending_count = 0;
+        }
+        struct pollfd pfd = {conn, POLLIN, 0};
+        if (poll(&pfd, 1, SERVER_IDLE_MS) > 0) {
+            ssize_t n = recv(conn, buffer + len, sizeof(buffer) - len - 1, 0);
+            if (n <= 0) {
+                close(conn);
+                conn = -1;
+                continue;
+            }
+            len += (size_t)n;
+            char *start = buffer, *newline;
+            while ((newline = memchr(start, '\n', len - (size_t)(start - buffer))) != NULL) {
+                *newline = '\0';
+                int id;
+                if (sscanf(start, "STATUS:%d", &id) == 1 && pending_count < 256) pending[pending_count++] = id;
+                start = newline + 1;
+            }
+            len -= (size_t)(start - buffer);
+            memmove(buffer, start, len);
+            continue;
+        }
+        if (pending_count == 0) continue;
+        if (pending_count > server->max_inflight) server->max_inflight = pending_count;
+
+        if (server->drop_first && server->connections == 1) {
+            // Os pedidos em voo se perdem com a conexão
+            close(conn);
+            conn = -1;
+            continue;
+        }
+        for (int i = 0; i < pending_count; i++) {
+            char line[128];
+            snprintf(line, sizeof(line), "JOB_STATUS:%d:%s:0:0", pending[i], protocol_status_name(JOB_COMPLETED));
+            protocol_send_line(conn, line);
+        }
+        server->served += pending_count;
+        pending_count = 0;
+    }
+    if (conn >= 0) close(conn);
+    return NULL;
+}
+
+static int start_server(fake_server_t *server, int expected, int drop_first, shard_ring_t *ring) {
+    memset(server, 0, sizeof(*server));
+    server->expected = expected;
+    server->drop_first = drop_first;
+
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    server->listener = socket(AF_INET, SOCK_STREAM, 0);
+    if (server->listener < 0 || bind(server->listener, (struct sockaddr*)&addr, sizeof(addr)) != 0 ||
+        listen(server->listener, 4) != 0 || getsockname(server->listener, (struct sockaddr*)&addr, &len) != 0) {
+        return -1;
+    }
+    char spec[64];
+    snprintf(spec, sizeof(spec), "127.0.0.1:%d", ntohs(addr.sin_port));
+    return shard_ring_parse(ring, spec);
+}
+
+// Pedidos de status para os ids 1..count; confere que cada resposta volta
+// para o pedido certo
+static int run_requests(sched_client_t *client, int count) {
+    sched_future_t *futures[64];
+    for (int i = 0; i < count; i++) {
+        futures[i] = sched_client_status_future(client, i + 1);
+        if (!futures[i]) return -1;
+    }
+    int rc = 0;
+    for (int i = 0; i < count; i++) {
+        const sched_reply_t *reply = NULL;
+        if (sched_future_wait(futures[i], 5000) == 0) reply = sched_future_reply(futures[i]);
+        if (rc == 0 && (!reply || reply->result != SCHED_OK || reply->id != i + 1 ||
+                        reply->status != JOB_COMPLETED)) {
+            fprintf(stderr, "Pedido %d recebeu \"%s\"\n", i + 1, reply ? reply->line : "nada");
+            rc = -1;
+        }
+        sched_future_free(futures[i]);
+    }
+    return rc;
+}
+
+// Uma conexão com profundidade 8: os 8 primeiros pedidos saem sem esperar
+// resposta, o 9º espera vaga, e as respostas casam com os pedidos na ordem
+int test_pipeline_depth() {
+    fake_server_t server;
+    shard_ring_t ring;
+    if (start_server(&server, 12, 0, &ring) != 0) return -1;
+    pthread_t thread;
+    pthread_create(&thread, NULL, server_thread, &server);
+
+    sched_client_config_t config;
+    sched_client_config_init(&config);
+    config.pool_size = 1;
+    config.pipeline_depth = 8;
+    sched_client_t client;
+    int rc = sched_client_init(&client, &ring, &config, &logger);
+    if (rc == 0) {
+        rc = run_requests(&client, 12);
+        sched_client_destroy(&client);
+    }
+    pthread_join(thread, NULL);
+    close(server.listener);
+
+    if (rc == 0 && server.max_inflight != 8) {
+        fprintf(stderr, "%d pedidos em voo na conexão, esperado 8\n", server.max_inflight);
+        rc = -1;
+    }
+    return rc;
+}
+
+// Conexão perdida com pedidos em voo: o cliente reconecta e os reenvia
+int test_resend_after_drop() {
+    fake_server_t server;
+    shard_ring_t ring;
+    if (start_server(&server, 3, 1, &ring) != 0) return -1;
+    pthread_t thread;
+    pthread_create(&thread, NULL, server_thread, &server);
+
+    sched_client_config_t config;
+    sched_client_config_init(&config);
+    config.pool_size = 1;
+    sched_client_t client;
+    int rc = sched_client_init(&client, &ring, &config, &logger);
+    if (rc == 0) {
+        rc = run_requests(&client, 3);
+        sched_client_destroy(&client);
+    }
+    pthread_join(thread, NULL);
+    close(server.listener);
+
+    if (rc == 0 && server.connections != 2) {
+        fprintf(stderr, "%d conexões, esperado 2\n", server.connections);
+        rc = -1;
+    }
+    return rc;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_client.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+
+    int rc = 0;
+    if (test_pipeline_depth() != 0) rc = 1;
+    if (rc == 0 && test_resend_after_drop() != 0) rc = 1;
+
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste da biblioteca cliente concluído\n");
+    return rc;
+}
@@ -0,0 +1,275 @@
+#include "../include/cron_expr.h"
+#include "../include/hier_wheel.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+// Tick grande: o relógio real não anda um tick durante o teste, o tempo da
+// roda é simulado movendo origin_ms
+#define WHEEL_TICK_MS 1000000L
+
+// Horário em UTC (o teste roda com TZ=UTC)
+static time_t at(int year, int month, int day, int hour, int minute) {
+    struct tm tm;
+    memset(&tm, 0, sizeof(tm));
+    tm.tm_year = year - 1900;
+    tm.tm_mon = month - 1;
+    tm.tm_mday = day;
+    tm.tm_hour = hour;
+    tm.tm_min = minute;
+    tm.tm_isdst = -1;
+    return mktime(&tm);
+}
+
+static uint64_t bits_of(const int *values, int count) {
+    uint64_t bits = 0;
+    for (int i = 0; i < count; i++) bits |= 1ULL << values[i];
+    return bits;
+}
+
+int test_parse_fields() {
+    cron_expr_t expr;
+
+    int quarters[] = {0, 15, 30, 45};
+    if (cron_expr_parse("*/15 * * * *", &expr) != 0 || expr.minutes != bits_of(quarters, 4)) {
+        fprintf(stderr, "*/15 incorreto\n");
+        return -1;
+    }
+    int from_five[] = {5, 15, 25, 35, 45, 55};
+    if (cron_expr_parse("5/10 * * * *", &expr) != 0 || expr.minutes != bits_of(from_five, 6)) {
+        fprintf(stderr, "5/10 incorreto\n");
+        return -1;
+    }
+    int office[] = {9, 11, 13, 15, 17};
+    if (cron_expr_parse("0 9-17/2 * * *", &expr) != 0 || expr.hours != bits_of(office, 5)) {
+        fprintf(stderr, "9-17/2 incorreto\n");
+        return -1;
+    }
+    int weekdays[] = {1, 2, 3, 4, 5};
+    if (cron_expr_parse("0 0 * * 1-5", &expr) != 0 || expr.weekdays != bits_of(weekdays, 5) ||
+        !expr.any_day || expr.any_weekday) {
+        fprintf(stderr, "1-5 incorreto\n");
+        return -1;
+    }
+    int list[] = {1, 15, 31};
+    if (cron_expr_parse("0 0 1,15,31 * *", &expr) != 0 || expr.days != bits_of(list, 3) ||
+        expr.any_day || !expr.any_weekday) {
+        fprintf(stderr, "Lista de dias incorreta\n");
+        return -1;
+    }
+
+    // 7 é domingo, como 0
+    if (cron_expr_parse("0 0 * * 7", &expr) != 0 || expr.weekdays != 1) {
+        fprintf(stderr, "7 não virou domingo\n");
+        return -1;
+    }
+    int weekend[] = {0, 5, 6};
+    if (cron_expr_parse("0 0 * * 5-7", &expr) != 0 || expr.weekdays != bits_of(weekend, 3)) {
+        fprintf(stderr, "5-7 incorreto\n");
+        return -1;
+    }
+
+    const char *invalid[] = {
+        "", "* * * *", "* * * * * *", "60 * * * *", "* 24 * * *", "0 0 0 * *",
+        "0 0 * 13 *", "0 0 * * 8", "*/0 * * * *", "5-1 * * * *", "a * * * *",
+        "1- * * * *", "@every",
+    };
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        if (cron_expr_parse(invalid[i], &expr) == 0) {
+            fprintf(stderr, "Expressão inválida aceita: \"%s\"\n", invalid[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+int test_parse_macros() {
+    const struct {
+        const char *macro;
+        const char *expr;
+    } cases[] = {
+        {"@yearly", "0 0 1 1 *"}, {"@annually", "0 0 1 1 *"}, {"@monthly", "0 0 1 * *"},
+        {"@weekly", "0 0 * * 0"}, {"@daily", "0 0 * * *"}, {"@midnight", "0 0 * * *"},
+        {"@hourly", "0 * * * *"},
+    };
+    for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++) {
+        cron_expr_t macro, expr;
+        if (cron_expr_parse(cases[i].macro, &macro) != 0 || cron_expr_parse(cases[i].expr, &expr) != 0 ||
+            memcmp(&macro, &expr, sizeof(expr)) != 0) {
+            fprintf(stderr, "Macro %s diferente de \"%s\"\n", cases[i].macro, cases[i].expr);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+static int expect_next(const char *text, time_t after, time_t expected) {
+    cron_expr_t expr;
+    if (cron_expr_parse(text, &expr) != 0) {
+        fprintf(stderr, "Expressão rejeitada: \"%s\"\n", text);
+        return -1;
+    }
+    time_t next = cron_expr_next(&expr, after);
+    if (next != expected) {
+        fprintf(stderr, "\"%s\" depois de %ld: esperado %ld, obtido %ld\n",
+                text, (long)after, (long)expected, (long)next);
+        return -1;
+    }
+    return 0;
+}
+
+int test_next() {
+    // Estritamente depois, em minutos cheios
+    if (expect_next("*/15 * * * *", at(2025, 6, 1, 10, 7), at(2025, 6, 1, 10, 15)) != 0) return -1;
+    if (expect_next("*/15 * * * *", at(2025, 6, 1, 10, 15), at(2025, 6, 1, 10, 30)) != 0) return -1;
+    if (expect_next("*/15 * * * *", at(2025, 6, 1, 10, 45) + 30, at(2025, 6, 1, 11, 0)) != 0) return -1;
+
+    // Virada de mês e meses sem o dia
+    if (expect_next("0 0 * * *", at(2025, 1, 31, 23, 59), at(2025, 2, 1, 0, 0)) != 0) return -1;
+    if (expect_next("30 12 31 * *", at(2025, 4, 1, 0, 0), at(2025, 5, 31, 12, 30)) != 0) return -1;
+    if (expect_next("0 0 1 * *", at(2025, 2, 28, 12, 0), at(2025, 3, 1, 0, 0)) != 0) return -1;
+
+    // Virada de ano
+    if (expect_next("@yearly", at(2025, 6, 15, 8, 0), at(2026, 1, 1, 0, 0)) != 0) return -1;
+    if (expect_next("* * * * *", at(2025, 12, 31, 23, 59), at(2026, 1, 1, 0, 0)) != 0) return -1;
+    if (expect_next("59 23 31 12 *", at(2025, 12, 31, 23, 59), at(2026, 12, 31, 23, 59)) != 0) return -1;
+    if (expect_next("0 0 29 2 *", at(2025, 3, 1, 0, 0), at(2028, 2, 29, 0, 0)) != 0) return -1;
+
+    // Data que nunca existe
+    if (expect_next("0 0 31 2 *", at(2025, 1, 1, 0, 0), (time_t)-1) != 0) return -1;
+    return 0;
+}
+
+int test_day_or() {
+    // Junho de 2025: dia 1 é domingo, 2 e 9 são segundas, 10 é terça
+    // Só o dia da semana restrito: só segundas
+    if (expect_next("0 0 * * 1", at(2025, 6, 2, 0, 0), at(2025, 6, 9, 0, 0)) != 0) return -1;
+    // Só o dia do mês restrito: só o dia 10
+    if (expect_next("0 0 10 * *", at(2025, 6, 2, 0, 0), at(2025, 6, 10, 0, 0)) != 0) return -1;
+
+    // Os dois restritos: dia 10 OU segunda
+    if (expect_next("0 0 10 * 1", at(2025, 6, 1, 0, 0), at(2025, 6, 2, 0, 0)) != 0) return -1;
+    if (expect_next("0 0 10 * 1", at(2025, 6, 2, 0, 0), at(2025, 6, 9, 0, 0)) != 0) return -1;
+    if (expect_next("0 0 10 * 1", at(2025, 6, 9, 0, 0), at(2025, 6, 10, 0, 0)) != 0) return -1;
+    if (expect_next("0 0 10 * 1", at(2025, 6, 10, 0, 0), at(2025, 6, 16, 0, 0)) != 0) return -1;
+    return 0;
+}
+
+// Move o relógio da roda para o tick dado (meio tick de folga)
+static void wheel_set_tick(hier_wheel_t *wheel, long tick) {
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    long now_ms = (long)now.tv_sec * 1000 + now.tv_nsec / 1000000;
+    wheel->origin_ms = now_ms - tick * WHEEL_TICK_MS - WHEEL_TICK_MS / 2;
+}
+
+typedef struct {
+    long ticks[16];
+    long at[16];
+    int count;
+} expired_log_t;
+
+static void record_expired(timer_node_t *node, void *arg) {
+    expired_log_t *log = arg;
+    if (log->count < 16) {
+        log->ticks[log->count] = (long)(size_t)node->data;
+        log->at[log->count] = node->expires;
+        log->count++;
+    }
+}
+
+int test_wheel_cascade() {
+    // Um timer por nível e nas fronteiras entre eles (255/256, 65535/65536, 2^24)
+    const long delays[] = {70000, 1, 256, 16777221, 65535, 255, 257, 65536, 65537, 3};
+    const int count = sizeof(delays) / sizeof(delays[0]);
+    long sorted[16];
+
+    hier_wheel_t *wheel = malloc(sizeof(*wheel));
+    timer_node_t nodes[16];
+    hier_wheel_init(wheel, (int)WHEEL_TICK_MS);
+    wheel_set_tick(wheel, 0);
+
+    memset(nodes, 0, sizeof(nodes));
+    for (int i = 0; i < count; i++) {
+        nodes[i].data = (void*)(size_t)delays[i];
+        hier_wheel_schedule(wheel, &nodes[i], delays[i] * WHEEL_TICK_MS);
+        sorted[i] = delays[i];
+    }
+    for (int i = 1; i < count; i++) {
+        for (int j = i; j > 0 && sorted[j - 1] > sorted[j]; j--) {
+            long tmp = sorted[j];
+            sorted[j] = sorted[j - 1];
+            sorted[j - 1] = tmp;
+        }
+    }
+
+    // Cada timer vence exatamente no seu tick, nem um antes
+    int rc = 0;
+    expired_log_t log;
+    for (int i = 0; i < count && rc == 0; i++) {
+        memset(&log, 0, sizeof(log));
+        wheel_set_tick(wheel, sorted[i] - 1);
+        if (hier_wheel_advance(wheel, record_expired, &log) != 0) {
+            fprintf(stderr, "Timer venceu antes do tick %ld\n", sorted[i]);
+            rc = -1;
+            break;
+        }
+        wheel_set_tick(wheel, sorted[i]);
+        if (hier_wheel_advance(wheel, record_expired, &log) != 1 || log.ticks[0] != sorted[i]) {
+            fprintf(stderr, "Timer do tick %ld não venceu na hora (%d vencidos)\n", sorted[i], log.count);
+            rc = -1;
+        }
+    }
+    if (rc == 0 && wheel->count != 0) {
+        fprintf(stderr, "Roda com %ld timers depois de todos vencerem\n", wheel->count);
+        rc = -1;
+    }
+
+    // Num avanço só, os vencidos saem em ordem de vencimento; o cancelado não sai
+    if (rc == 0) {
+        hier_wheel_init(wheel, (int)WHEEL_TICK_MS);
+        wheel_set_tick(wheel, 0);
+        memset(nodes, 0, sizeof(nodes));
+        for (int i = 0; i < count; i++) {
+            nodes[i].data = (void*)(size_t)delays[i];
+            hier_wheel_schedule(wheel, &nodes[i], delays[i] * WHEEL_TICK_MS);
+        }
+        hier_wheel_cancel(wheel, &nodes[0]);   // 70000
+
+        memset(&log, 0, sizeof(log));
+        wheel_set_tick(wheel, sorted[count - 1]);
+        int expired = hier_wheel_advance(wheel, record_expired, &log);
+        int k = 0;
+        for (int i = 0; i < count && rc == 0; i++) {
+            if (sorted[i] == 70000) continue;
+            if (k >= log.count || log.ticks[k] != sorted[i] || log.at[k] != sorted[i]) {
+                fprintf(stderr, "Ordem de vencimento incorreta na posição %d\n", k);
+                rc = -1;
+            }
+            k++;
+        }
+        if (rc == 0 && (expired != count - 1 || wheel->count != 0)) {
+            fprintf(stderr, "Avanço único: %d vencidos, %ld na roda\n", expired, wheel->count);
+            rc = -1;
+        }
+    }
+
+    hier_wheel_destroy(wheel);
+    free(wheel);
+    return rc;
+}
+
+int main() {
+    setenv("TZ", "UTC", 1);
+    tzset();
+
+    if (test_parse_fields() != 0) return 1;
+    if (test_parse_macros() != 0) return 1;
+    if (test_next() != 0) return 1;
+    if (test_day_or() != 0) return 1;
+    if (test_wheel_cascade() != 0) return 1;
+
+    printf("Teste de cron e timing wheel concluído\n");
+    return 0;
+}
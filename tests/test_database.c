@@ -0,0 +1,119 @@
+#include "../include/tslog.h"
+#include "../include/database.h"
+#include <sqlite3.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define TEST_DB "test_database.db"
+
+tslog_t logger;
+
+static void remove_db(void) {
+    unlink(TEST_DB);
+    unlink(TEST_DB "-wal");
+    unlink(TEST_DB "-shm");
+}
+
+static int save(int job_id) {
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    job.job_id = job_id;
+    snprintf(job.script, sizeof(job.script), "echo %d", job_id);
+    job.priority = 5;
+    job.timeout = 60;
+    return database_save_job(&job);
+}
+
+static void collect(const job_record_t *rec, void *arg) {
+    int *ids = (int*)arg;
+    ids[++ids[0]] = rec->job_id;
+}
+
+// Consultas de leitura: job, histórico (mais novo primeiro) e maior id
+int test_reads() {
+    for (int id = 1; id <= 5; id++) {
+        if (save(id) != 0) {
+            fprintf(stderr, "Job %d não gravado\n", id);
+            return -1;
+        }
+    }
+    database_update_job_result(3, 1, "saída", 0.5);
+
+    job_record_t rec;
+    if (database_get_job(3, &rec) != 0 || rec.status != JOB_COMPLETED || strcmp(rec.result, "saída") != 0) {
+        fprintf(stderr, "Job 3 lido errado\n");
+        return -1;
+    }
+    if (database_get_job(99, &rec) != 1) {
+        fprintf(stderr, "Job inexistente encontrado\n");
+        return -1;
+    }
+
+    int ids[8] = {0};
+    if (database_get_job_history(2, 1, collect, ids) != 2 || ids[0] != 2 || ids[1] != 4 || ids[2] != 3) {
+        fprintf(stderr, "Histórico com %d jobs (%d, %d)\n", ids[0], ids[1], ids[2]);
+        return -1;
+    }
+    if (database_get_max_job_id() != 5) {
+        fprintf(stderr, "Maior id %d\n", database_get_max_job_id());
+        return -1;
+    }
+    return 0;
+}
+
+// Outra conexão com uma escrita aberta: a leitura não espera por ela e vê
+// o último estado confirmado
+int test_read_during_write() {
+    sqlite3 *writer;
+    if (sqlite3_open(TEST_DB, &writer) != SQLITE_OK) return -1;
+    int rc = 0;
+    if (sqlite3_exec(writer, "BEGIN IMMEDIATE; UPDATE jobs SET status = 3 WHERE job_id = 1;",
+                     NULL, NULL, NULL) != SQLITE_OK) {
+        fprintf(stderr, "Escrita concorrente não abriu: %s\n", sqlite3_errmsg(writer));
+        rc = -1;
+    }
+
+    struct timespec start, end;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    job_record_t rec;
+    int found = database_get_job(1, &rec);
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    double elapsed = (end.tv_sec - start.tv_sec) + (end.tv_nsec - start.tv_nsec) / 1e9;
+
+    if (rc == 0 && (found != 0 || rec.status != JOB_PENDING)) {
+        fprintf(stderr, "Leitura viu a escrita não confirmada (status %d)\n", rec.status);
+        rc = -1;
+    }
+    if (rc == 0 && elapsed > 1.0) {
+        fprintf(stderr, "Leitura esperou a escrita: %.2fs\n", elapsed);
+        rc = -1;
+    }
+    sqlite3_exec(writer, "ROLLBACK;", NULL, NULL, NULL);
+    sqlite3_close(writer);
+    return rc;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_database.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+    remove_db();
+    database_set_file(TEST_DB);
+    if (database_init(&logger) != 0) {
+        tslog_destroy(&logger);
+        return 1;
+    }
+
+    int rc = 0;
+    if (test_reads() != 0) rc = 1;
+    if (rc == 0 && test_read_during_write() != 0) rc = 1;
+
+    database_close();
+    remove_db();
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste do database concluído\n");
+    return rc;
+}
@@ -0,0 +1,169 @@
+#include "../include/tslog.h"
+#include "../include/job_queue.h"
+#include "../include/job_stats.h"
+#include "../include/runtime_history.h"
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+
+tslog_t logger;
+
+static int expired_job = 0;
+
+static void on_expire(int job_id, const char *needs, void *arg) {
+    (void)needs; (void)arg;
+    expired_job = job_id;
+}
+
+// `due` segundos a partir de agora; 0 = sem prazo
+static int push_due(job_queue_t *queue, const char *script, int due) {
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    snprintf(job.script, sizeof(job.script), "%s", script);
+    snprintf(job.client, sizeof(job.client), "edf");
+    job.priority = 5;
+    job.timeout = 60;
+    job.deadline = due ? time(NULL) + due : 0;
+    return job_queue_push(queue, &job);
+}
+
+static int pop_job(job_queue_t *queue, job_t *job) {
+    memset(job, 0, sizeof(*job));
+    return job_queue_pop_timed(queue, job, 0);
+}
+
+// Prazo mais cedo primeiro, independente da ordem de chegada e da
+// prioridade; jobs sem prazo depois
+int test_edf_order() {
+    job_queue_t queue;
+    if (job_queue_init(&queue, &logger) != 0) return -1;
+    job_queue_set_mode(&queue, JOB_QUEUE_EDF);
+
+    int ids[4];
+    ids[3] = push_due(&queue, "echo sem prazo", 0);
+    ids[2] = push_due(&queue, "echo 300", 300);
+    ids[0] = push_due(&queue, "echo 100", 100);
+    ids[1] = push_due(&queue, "echo 200", 200);
+
+    int rc = 0;
+    job_t job;
+    for (int i = 0; i < 4 && rc == 0; i++) {
+        if (pop_job(&queue, &job) != 0 || job.job_id != ids[i]) {
+            fprintf(stderr, "Retirada %d: job %d, esperado %d\n", i, job.job_id, ids[i]);
+            rc = -1;
+        }
+    }
+    // Com jobs na fila o modo não muda
+    push_due(&queue, "echo resto", 0);
+    if (rc == 0 && job_queue_set_mode(&queue, JOB_QUEUE_FAIR) == 0) {
+        fprintf(stderr, "Modo mudou com a fila cheia\n");
+        rc = -1;
+    }
+    job_queue_destroy(&queue);
+    return rc;
+}
+
+// Admissão: prazo vencido ou menor que a duração estimada é recusado
+int test_admission(runtime_history_t *history) {
+    job_queue_t queue;
+    if (job_queue_init(&queue, &logger) != 0) return -1;
+    job_queue_attach_history(&queue, history);
+
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    snprintf(job.script, sizeof(job.script), "sleep 10");
+    double estimate;
+    int rc = 0;
+
+    job.deadline = time(NULL) + 5;
+    if (job_queue_admit_deadline(&queue, &job, &estimate) != 1 || estimate < 10) {
+        fprintf(stderr, "Prazo menor que a duração aceito (estimativa %.1fs)\n", estimate);
+        rc = -1;
+    }
+    job.deadline = time(NULL) + 60;
+    if (rc == 0 && job_queue_admit_deadline(&queue, &job, &estimate) != 0) {
+        fprintf(stderr, "Prazo folgado recusado (estimativa %.1fs)\n", estimate);
+        rc = -1;
+    }
+    job.deadline = time(NULL) - 1;
+    if (rc == 0 && job_queue_admit_deadline(&queue, &job, &estimate) != 1) {
+        fprintf(stderr, "Prazo vencido aceito\n");
+        rc = -1;
+    }
+    // Sem histórico do script só o prazo vencido conta
+    snprintf(job.script, sizeof(job.script), "echo novo");
+    job.deadline = time(NULL) + 1;
+    if (rc == 0 && (job_queue_admit_deadline(&queue, &job, &estimate) != 0 || estimate != -1)) {
+        fprintf(stderr, "Script sem histórico recusado\n");
+        rc = -1;
+    }
+    job.deadline = 0;
+    if (rc == 0 && job_queue_admit_deadline(&queue, &job, &estimate) != 0) {
+        fprintf(stderr, "Job sem prazo recusado\n");
+        rc = -1;
+    }
+    job_queue_destroy(&queue);
+    return rc;
+}
+
+// Job aceito que deixou de caber (o histórico mudou enquanto esperava) é
+// descartado ao sair da fila, sem ocupar worker
+int test_expire_at_pop(runtime_history_t *history) {
+    job_queue_t queue;
+    job_stats_t stats;
+    if (job_stats_init(&stats) != 0) return -1;
+    if (job_queue_init(&queue, &logger) != 0) {
+        job_stats_destroy(&stats);
+        return -1;
+    }
+    job_queue_attach_history(&queue, history);
+    job_queue_attach_stats(&queue, &stats);
+    job_queue_set_expire_hook(&queue, on_expire, NULL);
+    job_queue_set_mode(&queue, JOB_QUEUE_EDF);
+
+    int late = push_due(&queue, "sleep 30", 60);
+    int fine = push_due(&queue, "echo rápido", 120);
+    for (int i = 0; i < RUNTIME_HISTORY_MIN_SAMPLES; i++) {
+        runtime_history_record(history, "sleep 30", 90);
+    }
+
+    int rc = 0;
+    job_t job;
+    if (pop_job(&queue, &job) != 0 || job.job_id != fine) {
+        fprintf(stderr, "Saiu o job %d, esperado %d\n", job.job_id, fine);
+        rc = -1;
+    }
+    if (rc == 0 && (expired_job != late || job_stats_deadline(&stats, DEADLINE_EXPIRED) != 1 ||
+                    job_queue_size(&queue) != 0)) {
+        fprintf(stderr, "Job %d sem prazo viável não foi descartado\n", late);
+        rc = -1;
+    }
+    job_queue_destroy(&queue);
+    job_stats_destroy(&stats);
+    return rc;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_edf.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+    runtime_history_t history;
+    if (runtime_history_init(&history) != 0) {
+        tslog_destroy(&logger);
+        return 1;
+    }
+    for (int i = 0; i < RUNTIME_HISTORY_MIN_SAMPLES; i++) {
+        runtime_history_record(&history, "sleep 10", 10);
+    }
+
+    int rc = 0;
+    if (test_edf_order() != 0) rc = 1;
+    if (rc == 0 && test_admission(&history) != 0) rc = 1;
+    if (rc == 0 && test_expire_at_pop(&history) != 0) rc = 1;
+
+    runtime_history_destroy(&history);
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste dos prazos concluído\n");
+    return rc;
+}
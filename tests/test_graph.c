@@ -0,0 +1,221 @@
+#include "../include/tslog.h"
+#include "../include/job_queue.h"
+#include "../include/job_graph.h"
+#include "../include/database.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#define TEST_DB "test_graph.db"
+
+tslog_t logger;
+
+static int final_count = 0;
+
+static void count_final(int job_id, job_status_t status, const char *batch, const char *needs, void *arg) {
+    (void)job_id; (void)status; (void)batch; (void)needs; (void)arg;
+    final_count++;
+}
+
+static int submit(job_graph_t *graph, const char *after, const char *batch) {
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    snprintf(job.script, sizeof(job.script), "echo grafo");
+    job.priority = 5;
+    job.timeout = 60;
+    char error[128] = "";
+    int id = job_graph_submit(graph, &job, after, batch, error, sizeof(error));
+    if (id < 0) fprintf(stderr, "Submissão (after=%s batch=%s): %s\n", after, batch, error);
+    return id;
+}
+
+static int expect_status(int job_id, int status) {
+    job_record_t rec;
+    if (database_get_job(job_id, &rec) != 0 || rec.status != status) {
+        fprintf(stderr, "Job %d com status %d, esperado %d\n", job_id, rec.status, status);
+        return -1;
+    }
+    return 0;
+}
+
+// Falha de um job derruba a cadeia inteira e o batch que depende dele
+int test_failure_propagation(job_graph_t *graph, job_queue_t *queue) {
+    char after[32];
+    int root = submit(graph, "", "");
+    snprintf(after, sizeof(after), "%d", root);
+    int child = submit(graph, after, "");
+    snprintf(after, sizeof(after), "%d", child);
+    int grandchild = submit(graph, after, "");
+    snprintf(after, sizeof(after), "%d", root);
+    int member = submit(graph, after, "etl");
+    int fan_in = submit(graph, "@etl", "");
+    if (root < 0 || child < 0 || grandchild < 0 || member < 0 || fan_in < 0) return -1;
+
+    long waiting;
+    job_graph_get_counters(graph, &waiting, NULL, NULL);
+    if (waiting != 4 || job_queue_size(queue) != 1) {
+        fprintf(stderr, "Aguardando %ld, fila %d (esperado 4 e 1)\n", waiting, job_queue_size(queue));
+        return -1;
+    }
+
+    job_t job;
+    job_queue_pop_timed(queue, &job, 0);
+    database_update_job_result(root, 0, "erro", 0.1);
+    final_count = 0;
+    job_graph_finish(graph, root, 0);
+
+    long failed;
+    job_graph_get_counters(graph, &waiting, NULL, &failed);
+    if (waiting != 0 || failed != 4 || final_count != 4 || graph->nodes.size != 0) {
+        fprintf(stderr, "Depois da falha: aguardando %ld, derrubados %ld, avisos %d, nós %zu\n",
+                waiting, failed, final_count, graph->nodes.size);
+        return -1;
+    }
+    if (expect_status(child, JOB_FAILED) != 0 || expect_status(grandchild, JOB_FAILED) != 0 ||
+        expect_status(member, JOB_FAILED) != 0 || expect_status(fan_in, JOB_FAILED) != 0) {
+        return -1;
+    }
+
+    // Depender de um job ou batch que já falhou: nasce falhado, sem executar
+    snprintf(after, sizeof(after), "%d", child);
+    int late = submit(graph, after, "");
+    int late_batch = submit(graph, "@etl", "");
+    if (late < 0 || late_batch < 0 || expect_status(late, JOB_FAILED) != 0 ||
+        expect_status(late_batch, JOB_FAILED) != 0 || job_queue_size(queue) != 0) {
+        fprintf(stderr, "Dependente de job falhado foi para a fila\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Sucesso libera os dependentes na ordem e o grafo não guarda mais nada
+int test_release(job_graph_t *graph, job_queue_t *queue) {
+    char after[32];
+    int first = submit(graph, "", "carga");
+    int second = submit(graph, "", "carga");
+    snprintf(after, sizeof(after), "%d", first);
+    int single = submit(graph, after, "");
+    int both = submit(graph, "@carga", "");
+    if (first < 0 || second < 0 || single < 0 || both < 0) return -1;
+
+    job_t job;
+    job_queue_pop_timed(queue, &job, 0);
+    job_queue_pop_timed(queue, &job, 0);
+    job_graph_finish(graph, first, 1);
+    if (job_queue_size(queue) != 1) {
+        fprintf(stderr, "Dependente do primeiro job não foi liberado\n");
+        return -1;
+    }
+    job_queue_pop_timed(queue, &job, 0);
+    if (job.job_id != single) {
+        fprintf(stderr, "Liberado o job %d, esperado %d\n", job.job_id, single);
+        return -1;
+    }
+    job_graph_finish(graph, single, 1);
+    job_graph_finish(graph, second, 1);
+    job_queue_pop_timed(queue, &job, 0);
+    if (job.job_id != both) {
+        fprintf(stderr, "Fan-in do batch não liberado (job %d)\n", job.job_id);
+        return -1;
+    }
+    job_graph_finish(graph, both, 1);
+    if (graph->nodes.size != 0) {
+        fprintf(stderr, "%zu nós sobraram no grafo\n", graph->nodes.size);
+        return -1;
+    }
+    return 0;
+}
+
+// Submissão recusada não deixa batch nem nó de acompanhamento para trás
+int test_failed_submit(job_graph_t *graph, job_queue_t *queue) {
+    int pending = submit(graph, "", "");
+    if (pending < 0) return -1;
+    size_t batches = graph->batches.size;
+
+    char after[64];
+    snprintf(after, sizeof(after), "%d,%d", pending, pending + 1000);
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    char error[128];
+    if (job_graph_submit(graph, &job, after, "novo", error, sizeof(error)) >= 0 ||
+        job_graph_submit(graph, &job, "@inexistente", "novo", error, sizeof(error)) >= 0) {
+        fprintf(stderr, "Dependência inexistente aceita\n");
+        return -1;
+    }
+    if (graph->batches.size != batches || graph->nodes.size != 0) {
+        fprintf(stderr, "Submissão recusada deixou %zu batches e %zu nós\n",
+                graph->batches.size - batches, graph->nodes.size);
+        return -1;
+    }
+    job_queue_pop_timed(queue, &job, 0);
+    job_graph_finish(graph, pending, 1);
+    return 0;
+}
+
+// Cancelar um job que aguarda cancela quem depende dele
+int test_cancel(job_graph_t *graph, job_queue_t *queue) {
+    char after[32];
+    int root = submit(graph, "", "");
+    snprintf(after, sizeof(after), "%d", root);
+    int waiting = submit(graph, after, "");
+    snprintf(after, sizeof(after), "%d", waiting);
+    int dependent = submit(graph, after, "");
+    if (root < 0 || waiting < 0 || dependent < 0) return -1;
+
+    if (job_graph_cancel(graph, waiting) != 0 || job_graph_cancel(graph, root) == 0) {
+        fprintf(stderr, "Cancelamento no grafo errado\n");
+        return -1;
+    }
+    if (expect_status(waiting, JOB_CANCELLED) != 0 || expect_status(dependent, JOB_CANCELLED) != 0) {
+        return -1;
+    }
+    job_t job;
+    job_queue_pop_timed(queue, &job, 0);
+    job_graph_finish(graph, root, 1);
+    if (job_queue_size(queue) != 0 || graph->nodes.size != 0) {
+        fprintf(stderr, "Dependente cancelado ainda foi liberado\n");
+        return -1;
+    }
+    return 0;
+}
+
+static void remove_db(void) {
+    unlink(TEST_DB);
+    unlink(TEST_DB "-wal");
+    unlink(TEST_DB "-shm");
+}
+
+int main() {
+    if (tslog_init(&logger, "test_graph.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+    remove_db();
+    database_set_file(TEST_DB);
+    if (database_init(&logger) != 0) {
+        tslog_destroy(&logger);
+        return 1;
+    }
+
+    job_queue_t queue;
+    job_graph_t graph;
+    if (job_queue_init(&queue, &logger) != 0 || job_graph_init(&graph, &queue, &logger) != 0) {
+        fprintf(stderr, "Erro ao inicializar fila e grafo\n");
+        return 1;
+    }
+    job_graph_set_final_hook(&graph, count_final, NULL);
+
+    int rc = 0;
+    if (test_failure_propagation(&graph, &queue) != 0) rc = 1;
+    if (rc == 0 && test_release(&graph, &queue) != 0) rc = 1;
+    if (rc == 0 && test_failed_submit(&graph, &queue) != 0) rc = 1;
+    if (rc == 0 && test_cancel(&graph, &queue) != 0) rc = 1;
+
+    job_graph_destroy(&graph);
+    job_queue_destroy(&queue);
+    database_close();
+    remove_db();
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste do grafo de dependências concluído\n");
+    return rc;
+}
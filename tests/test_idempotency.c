@@ -0,0 +1,158 @@
+#include "../include/tslog.h"
+#include "../include/idempotency.h"
+#include "../include/int_map.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+tslog_t logger;
+
+// Chaves que caem na mesma faixa que `first` (key[0] é a própria)
+static void same_stripe_keys(const char *first, char keys[][32], int count) {
+    int stripe = (int)((unsigned)int_map_string_key(first) % IDEMPOTENCY_STRIPES);
+    snprintf(keys[0], 32, "%s", first);
+    int found = 1;
+    for (int n = 0; found < count; n++) {
+        char key[32];
+        snprintf(key, sizeof(key), "chave-%d", n);
+        if ((int)((unsigned)int_map_string_key(key) % IDEMPOTENCY_STRIPES) == stripe) {
+            snprintf(keys[found++], 32, "%s", key);
+        }
+    }
+}
+
+static int expect_claim(idempotency_t *idem, const char *key, int want, int want_id) {
+    idempotency_record_t rec;
+    memset(&rec, 0, sizeof(rec));
+    int rc = idempotency_claim(idem, key, &rec);
+    if (rc != want) {
+        fprintf(stderr, "claim(%s) = %d, esperado %d\n", key, rc, want);
+        return -1;
+    }
+    if (rc == 1 && rec.id != want_id) {
+        fprintf(stderr, "claim(%s) devolveu o job %d, esperado %d\n", key, rec.id, want_id);
+        return -1;
+    }
+    return 0;
+}
+
+static int expect_counts(idempotency_t *idem, long live, long evicted) {
+    long got_evicted;
+    idempotency_get_counters(idem, NULL, NULL, &got_evicted);
+    long got_live = idempotency_count(idem);
+    if (got_live != live || got_evicted != evicted) {
+        fprintf(stderr, "Chaves vivas %ld e despejadas %ld (esperado %ld e %ld)\n",
+                got_live, got_evicted, live, evicted);
+        return -1;
+    }
+    return 0;
+}
+
+int test_hit_and_expiry() {
+    idempotency_t idem;
+    if (idempotency_init(&idem, 600, 1024, &logger) != 0) return -1;
+    int rc = 0;
+    if (expect_claim(&idem, "pedido", 0, 0) != 0) rc = -1;
+    idempotency_commit(&idem, "pedido", IDEMPOTENCY_JOB, 42, 0);
+    if (rc == 0 && expect_claim(&idem, "pedido", 1, 42) != 0) rc = -1;
+    // Repetição durante a submissão também é acerto, ainda pendente
+    if (rc == 0 && expect_claim(&idem, "outro", 0, 0) != 0) rc = -1;
+    if (rc == 0 && expect_claim(&idem, "outro", 1, 0) != 0) rc = -1;
+    idempotency_destroy(&idem);
+    if (rc != 0) return rc;
+
+    // ttl de 1s: um segundo depois a chave já venceu e volta a ser nova
+    if (idempotency_init(&idem, 1, 1024, &logger) != 0) return -1;
+    if (expect_claim(&idem, "pedido", 0, 0) != 0) rc = -1;
+    idempotency_commit(&idem, "pedido", IDEMPOTENCY_JOB, 7, 0);
+    sleep(1);
+    if (rc == 0 && expect_claim(&idem, "pedido", 0, 0) != 0) rc = -1;
+    if (rc == 0 && expect_counts(&idem, 1, 0) != 0) rc = -1;
+    idempotency_destroy(&idem);
+    return rc;
+}
+
+int test_release() {
+    idempotency_t idem;
+    if (idempotency_init(&idem, 600, 1024, &logger) != 0) return -1;
+    int rc = 0;
+    // Submissão que falhou: a nova tentativa do cliente não pode virar acerto
+    if (expect_claim(&idem, "falhou", 0, 0) != 0) rc = -1;
+    idempotency_release(&idem, "falhou");
+    if (rc == 0 && expect_counts(&idem, 0, 0) != 0) rc = -1;
+    if (rc == 0 && expect_claim(&idem, "falhou", 0, 0) != 0) rc = -1;
+    idempotency_commit(&idem, "falhou", IDEMPOTENCY_JOB, 9, 0);
+    if (rc == 0 && expect_claim(&idem, "falhou", 1, 9) != 0) rc = -1;
+
+    // Depois do commit o release não desfaz a chave
+    idempotency_release(&idem, "falhou");
+    if (rc == 0 && expect_claim(&idem, "falhou", 1, 9) != 0) rc = -1;
+
+    long hits, misses;
+    idempotency_get_counters(&idem, &hits, &misses, NULL);
+    if (rc == 0 && (hits != 2 || misses != 2)) {
+        fprintf(stderr, "Acertos %ld e erros %ld (esperado 2 e 2)\n", hits, misses);
+        rc = -1;
+    }
+    idempotency_destroy(&idem);
+    return rc;
+}
+
+int test_eviction() {
+    idempotency_t idem;
+    // Duas chaves por faixa
+    if (idempotency_init(&idem, 600, 2 * IDEMPOTENCY_STRIPES, &logger) != 0) return -1;
+    char keys[6][32];
+    same_stripe_keys("a", keys, 6);
+
+    int rc = 0;
+    for (int i = 0; i < 3 && rc == 0; i++) {
+        if (expect_claim(&idem, keys[i], 0, 0) != 0) rc = -1;
+        idempotency_commit(&idem, keys[i], IDEMPOTENCY_JOB, 100 + i, 0);
+    }
+    // A terceira despejou a mais antiga; o commit atrasado dela não volta
+    if (rc == 0 && expect_counts(&idem, 2, 1) != 0) rc = -1;
+    idempotency_commit(&idem, keys[0], IDEMPOTENCY_JOB, 999, 0);
+    if (rc == 0 && expect_counts(&idem, 2, 1) != 0) rc = -1;
+    if (rc == 0 && expect_claim(&idem, keys[2], 1, 102) != 0) rc = -1;
+    if (rc == 0 && expect_claim(&idem, keys[0], 0, 0) != 0) rc = -1;
+    // keys[0] pendente de novo despejou keys[1]
+    if (rc == 0 && expect_counts(&idem, 2, 2) != 0) rc = -1;
+
+    // Chave liberada não ocupa lugar: a próxima entra sem despejar ninguém
+    idempotency_release(&idem, keys[0]);
+    if (rc == 0 && expect_claim(&idem, keys[3], 0, 0) != 0) rc = -1;
+    if (rc == 0 && expect_counts(&idem, 2, 2) != 0) rc = -1;
+
+    // A pendente mais antiga (keys[3]) fica; sai keys[2], já respondida
+    if (rc == 0 && expect_claim(&idem, keys[4], 0, 0) != 0) rc = -1;
+    if (rc == 0 && expect_counts(&idem, 2, 3) != 0) rc = -1;
+    idempotency_commit(&idem, keys[3], IDEMPOTENCY_JOB, 103, 0);
+    if (rc == 0 && expect_claim(&idem, keys[3], 1, 103) != 0) rc = -1;
+
+    if (rc == 0 && expect_claim(&idem, keys[5], 0, 0) != 0) rc = -1;
+    if (rc == 0 && expect_counts(&idem, 2, 4) != 0) rc = -1;
+    // Só pendentes na faixa: ela passa do limite em vez de perder uma
+    if (rc == 0 && expect_claim(&idem, keys[0], 0, 0) != 0) rc = -1;
+    if (rc == 0 && expect_counts(&idem, 3, 4) != 0) rc = -1;
+    idempotency_commit(&idem, keys[4], IDEMPOTENCY_JOB, 104, 0);
+    if (rc == 0 && expect_claim(&idem, keys[4], 1, 104) != 0) rc = -1;
+    idempotency_destroy(&idem);
+    return rc;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_idempotency.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+
+    int rc = 0;
+    if (test_hit_and_expiry() != 0) rc = 1;
+    if (rc == 0 && test_release() != 0) rc = 1;
+    if (rc == 0 && test_eviction() != 0) rc = 1;
+
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste de idempotência concluído\n");
+    return rc;
+}
@@ -0,0 +1,191 @@
+#include "../include/tslog.h"
+#include "../include/job_queue.h"
+#include "../include/job_index.h"
+#include "../include/lease_table.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+tslog_t logger;
+
+static int push_job(job_queue_t *queue, const char *client) {
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    snprintf(job.script, sizeof(job.script), "echo %s", client);
+    snprintf(job.client, sizeof(job.client), "%s", client);
+    job.priority = 5;
+    job.timeout = 60;
+    return job_queue_push(queue, &job);
+}
+
+static int pop_job(job_queue_t *queue, job_t *job) {
+    memset(job, 0, sizeof(*job));
+    return job_queue_pop_timed(queue, job, 0);
+}
+
+static int expect_state(job_index_t *index, int job_id, job_status_t status, int worker_id) {
+    job_index_entry_t entry;
+    if (job_index_get(index, job_id, &entry) != 0 || entry.status != status || entry.worker_id != worker_id) {
+        fprintf(stderr, "Job %d no índice com status %d e worker %d, esperado %d e %d\n",
+                job_id, entry.status, entry.worker_id, status, worker_id);
+        return -1;
+    }
+    return 0;
+}
+
+// Cancelamento em cada ponto do caminho: na fila, entre a retirada e a
+// entrega, em execução e em backoff. Nenhum deles deixa o job voltar.
+int test_cancel_race(job_queue_t *queue, lease_table_t *table, job_index_t *index) {
+    job_t job;
+    int workers[2];
+
+    // Na fila: sai pelo id, sem passar pela tabela
+    int queued = push_job(queue, "c");
+    if (expect_state(index, queued, JOB_PENDING, 0) != 0) return -1;
+    if (job_queue_remove(queue, queued, &job) != 0 || job.job_id != queued ||
+        job_queue_remove(queue, queued, NULL) == 0 || lease_table_abort(table, queued, NULL, workers) == 0) {
+        fprintf(stderr, "Cancelamento na fila errado\n");
+        return -1;
+    }
+
+    // Retirado e ainda sem worker: a entrega desiste
+    int dispatching = push_job(queue, "c");
+    if (pop_job(queue, &job) != 0 || expect_state(index, dispatching, JOB_RUNNING, 0) != 0) return -1;
+    if (lease_table_abort(table, dispatching, NULL, workers) != 0 || workers[0] != 0 ||
+        lease_table_abort(table, dispatching, NULL, workers) == 0) {
+        fprintf(stderr, "Cancelamento a caminho do worker errado\n");
+        return -1;
+    }
+    if (lease_table_acquire(table, &job, 3) != 1 || lease_table_count(table) != 0) {
+        fprintf(stderr, "Job cancelado foi entregue ao worker\n");
+        return -1;
+    }
+
+    // Em execução: o worker é apontado para receber CANCEL e o resultado
+    // que chegar depois é descartado
+    push_job(queue, "c");
+    if (pop_job(queue, &job) != 0 || lease_table_acquire(table, &job, 3) != 0 ||
+        expect_state(index, job.job_id, JOB_RUNNING, 3) != 0) {
+        return -1;
+    }
+    job_t done;
+    if (lease_table_abort(table, job.job_id, NULL, workers) != 0 || workers[0] != 3 ||
+        lease_table_complete(table, job.job_id, job.lease_id, 3, &done, NULL) == 0) {
+        fprintf(stderr, "Cancelamento em execução errado (worker %d)\n", workers[0]);
+        return -1;
+    }
+
+    // Em backoff: não está com ninguém e não volta à fila
+    push_job(queue, "c");
+    if (pop_job(queue, &job) != 0 || lease_table_acquire(table, &job, 4) != 0) return -1;
+    lease_table_orphan(table, job.job_id, 4);
+    if (lease_table_abort(table, job.job_id, NULL, workers) != 0 || workers[0] != 0) {
+        fprintf(stderr, "Cancelamento em backoff errado\n");
+        return -1;
+    }
+    usleep((LEASE_BACKOFF_BASE_MS + 300) * 1000);
+    lease_table_check(table, NULL, NULL);
+    if (job_queue_size(queue) != 0 || lease_table_count(table) != 0) {
+        fprintf(stderr, "Job cancelado em backoff voltou à fila\n");
+        return -1;
+    }
+    return 0;
+}
+
+// LIST_JOBS: filtro por cliente e status, em ordem de id, paginado pelo cursor
+int test_list(job_index_t *index) {
+    for (int id = 1000; id < 1250; id++) {
+        job_t job;
+        memset(&job, 0, sizeof(job));
+        job.job_id = id;
+        snprintf(job.client, sizeof(job.client), "%s", id % 2 ? "impar" : "par");
+        job_index_track(index, &job, id % 5 ? JOB_PENDING : JOB_COMPLETED);
+    }
+
+    job_index_filter_t filter;
+    memset(&filter, 0, sizeof(filter));
+    filter.status = -1;
+    filter.after = 999;
+    snprintf(filter.client, sizeof(filter.client), "par");
+
+    job_index_entry_t page[JOB_INDEX_PAGE_MAX];
+    int total = 0, last = 0;
+    int n;
+    while ((n = job_index_list(index, &filter, page, JOB_INDEX_PAGE_MAX)) > 0) {
+        for (int i = 0; i < n; i++) {
+            if (page[i].job_id <= last || strcmp(page[i].client, "par") != 0) {
+                fprintf(stderr, "Página fora de ordem ou com outro cliente (job %d)\n", page[i].job_id);
+                return -1;
+            }
+            last = page[i].job_id;
+        }
+        total += n;
+        filter.after = last;
+    }
+    if (total != 125) {
+        fprintf(stderr, "Listagem paginada com %d jobs, esperado 125\n", total);
+        return -1;
+    }
+
+    filter.client[0] = '\0';
+    filter.status = JOB_COMPLETED;
+    filter.after = 999;
+    if (job_index_list(index, &filter, page, JOB_INDEX_PAGE_MAX) != 50 || page[0].job_id != 1000) {
+        fprintf(stderr, "Filtro por status errado\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Só os JOB_INDEX_RETAIN terminados mais recentes ficam; pendentes nunca saem
+int test_retention(job_index_t *index) {
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    job.job_id = 500;
+    job_index_track(index, &job, JOB_PENDING);
+
+    int first = 100000;
+    for (int i = 0; i < JOB_INDEX_RETAIN + 10; i++) {
+        job.job_id = first + i;
+        job_index_track(index, &job, JOB_COMPLETED);
+    }
+    job_index_entry_t entry;
+    if (job_index_get(index, 500, &entry) != 0) {
+        fprintf(stderr, "Job pendente saiu do índice\n");
+        return -1;
+    }
+    if (job_index_get(index, first + 9, &entry) == 0 || job_index_get(index, first + 10, &entry) != 0) {
+        fprintf(stderr, "Retenção dos terminados errada\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_index.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+
+    job_queue_t queue;
+    lease_table_t table;
+    job_index_t index;
+    if (job_index_init(&index) != 0 || job_queue_init(&queue, &logger) != 0 ||
+        lease_table_init(&table, &queue, &logger) != 0) {
+        fprintf(stderr, "Erro ao inicializar fila, leases e índice\n");
+        return 1;
+    }
+    job_queue_attach_index(&queue, &index);
+
+    int rc = 0;
+    if (test_cancel_race(&queue, &table, &index) != 0) rc = 1;
+    if (rc == 0 && test_list(&index) != 0) rc = 1;
+    if (rc == 0 && test_retention(&index) != 0) rc = 1;
+
+    lease_table_destroy(&table);
+    job_queue_destroy(&queue);
+    job_index_destroy(&index);
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste do índice de jobs concluído\n");
+    return rc;
+}
@@ -0,0 +1,242 @@
+#include "../include/tslog.h"
+#include "../include/job_queue.h"
+#include "../include/lease_table.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+tslog_t logger;
+
+static int expired_worker = 0, expired_job = 0;
+static int dead_job = 0;
+
+static void on_expire(int worker_id, int job_id, void *arg) {
+    (void)arg;
+    expired_worker = worker_id;
+    expired_job = job_id;
+}
+
+static void on_dead_letter(const job_t *job, void *arg) {
+    (void)arg;
+    dead_job = job->job_id;
+}
+
+#define HEDGE_WORKER 7
+
+static int hedge_calls = 0;
+
+// Cópia pedida: vai sempre para o mesmo worker livre
+static int on_hedge(const job_t *job, int worker_id, void *arg) {
+    (void)worker_id;
+    hedge_calls++;
+    lease_table_attach_hedge((lease_table_t*)arg, job->job_id, HEDGE_WORKER);
+    return 0;
+}
+
+// Job na fila e retirado: o gancho da fila já abriu o lease ainda sem worker.
+// `timeout` negativo encurta o prazo do lease (timeout + folga) para o teste.
+static int take_job(job_queue_t *queue, int timeout, job_t *job) {
+    job_t submitted;
+    memset(&submitted, 0, sizeof(submitted));
+    snprintf(submitted.script, sizeof(submitted.script), "sleep 1");
+    submitted.priority = 5;
+    submitted.timeout = timeout;
+    if (job_queue_push(queue, &submitted) < 0) return -1;
+    memset(job, 0, sizeof(*job));
+    return job_queue_pop_timed(queue, job, 0);
+}
+
+// Prazo vencido: o worker é avisado, o job espera o backoff e volta à fila
+// com uma tentativa a mais; o resultado atrasado não fecha o novo lease
+int test_expiry_backoff(job_queue_t *queue, lease_table_t *table) {
+    job_t job;
+    if (take_job(queue, 1 - LEASE_GRACE_SECONDS, &job) != 0) return -1;
+    if (lease_table_acquire(table, &job, 1) != 0 || job.lease_id <= 0) {
+        fprintf(stderr, "Lease não aberto\n");
+        return -1;
+    }
+    int first_lease = job.lease_id;
+
+    usleep(1300 * 1000);
+    lease_table_check(table, on_expire, NULL);
+    if (expired_worker != 1 || expired_job != job.job_id) {
+        fprintf(stderr, "Lease vencido não avisou (worker %d, job %d)\n", expired_worker, expired_job);
+        return -1;
+    }
+    if (job_queue_size(queue) != 0 || lease_table_count(table) != 1) {
+        fprintf(stderr, "Job voltou à fila antes do backoff\n");
+        return -1;
+    }
+
+    usleep((LEASE_BACKOFF_BASE_MS + 300) * 1000);
+    lease_table_check(table, on_expire, NULL);
+    long requeued;
+    lease_table_get_counters(table, &requeued, NULL);
+    if (job_queue_size(queue) != 1 || lease_table_count(table) != 0 || requeued != 1) {
+        fprintf(stderr, "Backoff terminou sem devolver o job (fila %d, requeued %ld)\n",
+                job_queue_size(queue), requeued);
+        return -1;
+    }
+
+    // Nova tentativa no mesmo worker
+    memset(&job, 0, sizeof(job));
+    job_queue_pop_timed(queue, &job, 0);
+    if (job.attempts != 1 || lease_table_acquire(table, &job, 1) != 0 || job.lease_id == first_lease) {
+        fprintf(stderr, "Nova tentativa com %d tentativas e lease %d\n", job.attempts, job.lease_id);
+        return -1;
+    }
+    job_t done;
+    if (lease_table_complete(table, job.job_id, first_lease, 1, &done, NULL) == 0) {
+        fprintf(stderr, "Resultado da primeira tentativa fechou a segunda\n");
+        return -1;
+    }
+    if (lease_table_complete(table, job.job_id, job.lease_id, 1, &done, NULL) != 0 ||
+        lease_table_count(table) != 0) {
+        fprintf(stderr, "Resultado da tentativa atual recusado\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Worker morreu com o job na última tentativa: dead-letter na hora
+int test_dead_letter(job_queue_t *queue, lease_table_t *table) {
+    job_t job;
+    lease_table_set_max_attempts(table, 1);
+    if (take_job(queue, 60, &job) != 0 || lease_table_acquire(table, &job, 2) != 0) return -1;
+
+    lease_table_orphan(table, job.job_id, 3);      // outro worker: nada muda
+    if (lease_table_count(table) != 1) {
+        fprintf(stderr, "Órfão de outro worker fechou o lease\n");
+        return -1;
+    }
+    lease_table_orphan(table, job.job_id, 2);
+    long dead;
+    lease_table_get_counters(table, NULL, &dead);
+    lease_table_set_max_attempts(table, LEASE_MAX_ATTEMPTS);
+    if (dead_job != job.job_id || dead != 1 || lease_table_count(table) != 0 || job_queue_size(queue) != 0) {
+        fprintf(stderr, "Job não foi para dead-letter (job %d, total %ld)\n", dead_job, dead);
+        return -1;
+    }
+    return 0;
+}
+
+// JOB_REJECT: volta à fila já, sem contar tentativa, só com o lease atual
+int test_reject(job_queue_t *queue, lease_table_t *table) {
+    job_t job;
+    if (take_job(queue, 60, &job) != 0 || lease_table_acquire(table, &job, 4) != 0) return -1;
+
+    if (lease_table_reject(table, job.job_id, job.lease_id + 1, 4) == 0 ||
+        lease_table_reject(table, job.job_id, job.lease_id, 5) == 0) {
+        fprintf(stderr, "Recusa de outro lease aceita\n");
+        return -1;
+    }
+    if (lease_table_reject(table, job.job_id, job.lease_id, 4) != 0 || lease_table_count(table) != 0) {
+        fprintf(stderr, "Recusa do lease atual não aceita\n");
+        return -1;
+    }
+    memset(&job, 0, sizeof(job));
+    if (job_queue_pop_timed(queue, &job, 0) != 0 || job.attempts != 0) {
+        fprintf(stderr, "Job recusado voltou com %d tentativas\n", job.attempts);
+        return -1;
+    }
+    return 0;
+}
+
+// Execução especulativa: passado o percentil sai uma cópia; o primeiro
+// resultado fecha o lease e aponta a outra cópia para ser cancelada
+int test_hedge_cancel(job_queue_t *queue, lease_table_t *table, runtime_history_t *history) {
+    for (int i = 0; i < RUNTIME_HISTORY_MIN_SAMPLES; i++) {
+        runtime_history_record(history, "sleep 1", 0.1);
+    }
+    lease_table_set_hedging(table, history, 50, 100);
+    lease_table_set_hedge_hook(table, on_hedge, table);
+    int leases = lease_table_count(table);
+
+    job_t won, lost, failed, pinned;
+    if (take_job(queue, 60, &won) != 0 || lease_table_acquire(table, &won, 1) != 0 ||
+        take_job(queue, 60, &lost) != 0 || lease_table_acquire(table, &lost, 1) != 0 ||
+        take_job(queue, 60, &failed) != 0 || lease_table_acquire(table, &failed, 1) != 0 ||
+        take_job(queue, 60, &pinned) != 0) {
+        return -1;
+    }
+    pinned.no_hedge = 1;
+    if (lease_table_acquire(table, &pinned, 1) != 0) return -1;
+
+    usleep((LEASE_HEDGE_MIN_MS + 300) * 1000);
+    lease_table_check(table, NULL, NULL);
+    if (hedge_calls != 3) {
+        fprintf(stderr, "%d cópias pedidas, esperado 3 (hedge=0 não duplica)\n", hedge_calls);
+        return -1;
+    }
+    if (lease_table_attach_hedge(table, won.job_id, HEDGE_WORKER + 1) == 0) {
+        fprintf(stderr, "Segunda cópia do mesmo job aceita\n");
+        return -1;
+    }
+
+    job_t done;
+    int other = -1;
+    if (lease_table_complete(table, won.job_id, won.lease_id, HEDGE_WORKER, &done, &other) != 0 || other != 1) {
+        fprintf(stderr, "Cópia vencedora não cancelou a original (outra %d)\n", other);
+        return -1;
+    }
+    if (lease_table_complete(table, won.job_id, won.lease_id, 1, &done, &other) == 0) {
+        fprintf(stderr, "Resultado da cópia cancelada aceito\n");
+        return -1;
+    }
+    if (lease_table_complete(table, lost.job_id, lost.lease_id, 1, &done, &other) != 0 ||
+        other != HEDGE_WORKER) {
+        fprintf(stderr, "Original vencedora não cancelou a cópia (outra %d)\n", other);
+        return -1;
+    }
+
+    // Falha de uma cópia: só ela sai, a outra continua com o lease
+    if (lease_table_drop_copy(table, failed.job_id, failed.lease_id, HEDGE_WORKER) != 0 ||
+        lease_table_drop_copy(table, failed.job_id, failed.lease_id, 1) == 0) {
+        fprintf(stderr, "Falha de uma cópia tratada errado\n");
+        return -1;
+    }
+    if (lease_table_complete(table, failed.job_id, failed.lease_id, 1, &done, &other) != 0 || other != 0 ||
+        lease_table_complete(table, pinned.job_id, pinned.lease_id, 1, &done, &other) != 0 || other != 0) {
+        fprintf(stderr, "Cópia restante não fechou o lease\n");
+        return -1;
+    }
+
+    long hedged, hedge_won, hedge_lost;
+    lease_table_get_hedge_counters(table, &hedged, &hedge_won, &hedge_lost, NULL);
+    if (hedged != 3 || hedge_won != 1 || hedge_lost != 1 || lease_table_count(table) != leases) {
+        fprintf(stderr, "Contadores: %ld cópias, %ld vencidas, %ld perdidas\n", hedged, hedge_won, hedge_lost);
+        return -1;
+    }
+    lease_table_set_hedging(table, NULL, 0, 0);
+    return 0;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_lease.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+
+    job_queue_t queue;
+    lease_table_t table;
+    runtime_history_t history;
+    if (job_queue_init(&queue, &logger) != 0 || lease_table_init(&table, &queue, &logger) != 0 ||
+        runtime_history_init(&history) != 0) {
+        fprintf(stderr, "Erro ao inicializar fila e leases\n");
+        return 1;
+    }
+    lease_table_set_dead_letter_hook(&table, on_dead_letter, NULL);
+
+    int rc = 0;
+    if (test_expiry_backoff(&queue, &table) != 0) rc = 1;
+    if (rc == 0 && test_dead_letter(&queue, &table) != 0) rc = 1;
+    if (rc == 0 && test_reject(&queue, &table) != 0) rc = 1;
+    if (rc == 0 && test_hedge_cancel(&queue, &table, &history) != 0) rc = 1;
+
+    lease_table_destroy(&table);
+    runtime_history_destroy(&history);
+    job_queue_destroy(&queue);
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste dos leases concluído\n");
+    return rc;
+}
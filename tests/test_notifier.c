@@ -0,0 +1,213 @@
+#include "../include/tslog.h"
+#include "../include/notifier.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <poll.h>
+#include <sys/socket.h>
+
+tslog_t logger;
+
+// Um assinante: a ponta do notifier e a ponta de quem lê, como a conexão
+// do cliente
+typedef struct {
+    int sockets[2];
+    line_reader_t reader;
+    notify_subscriber_t *sub;
+} peer_t;
+
+static int peer_open(notifier_t *notifier, peer_t *peer) {
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, peer->sockets) != 0) return -1;
+    line_reader_init(&peer->reader);
+    peer->sub = notifier_attach(notifier, peer->sockets[0]);
+    return peer->sub ? 0 : -1;
+}
+
+static void peer_close(notifier_t *notifier, peer_t *peer) {
+    notifier_detach(notifier, peer->sub);
+    close(peer->sockets[0]);
+    close(peer->sockets[1]);
+}
+
+// Próxima linha em até timeout_ms; 0 se nada chegou
+static int peer_read(peer_t *peer, char *line, size_t size, int timeout_ms) {
+    if (peer->reader.len == 0 || !memchr(peer->reader.data, '\n', peer->reader.len)) {
+        struct pollfd pfd = {peer->sockets[1], POLLIN, 0};
+        if (poll(&pfd, 1, timeout_ms) <= 0) return 0;
+    }
+    return line_reader_next(&peer->reader, peer->sockets[1], line, size) > 0;
+}
+
+static int expect_line(peer_t *peer, const char *name, const char *prefix) {
+    char line[PROTOCOL_LINE_MAX];
+    if (!peer_read(peer, line, sizeof(line), 2000) || strncmp(line, prefix, strlen(prefix)) != 0) {
+        fprintf(stderr, "Assinante %s: esperado \"%s...\"\n", name, prefix);
+        return -1;
+    }
+    return 0;
+}
+
+static int expect_silence(peer_t *peer, const char *name) {
+    char line[PROTOCOL_LINE_MAX];
+    if (peer_read(peer, line, sizeof(line), 100)) {
+        fprintf(stderr, "Assinante %s recebeu \"%s\" a mais\n", name, line);
+        return -1;
+    }
+    return 0;
+}
+
+int test_parse_topic() {
+    char topic[NOTIFY_TOPIC_MAX];
+    if (notifier_parse_topic("job=012", topic, sizeof(topic)) != 0 || strcmp(topic, "job=12") != 0 ||
+        notifier_parse_topic("batch=etl", topic, sizeof(topic)) != 0 ||
+        notifier_parse_topic("tag=gpu", topic, sizeof(topic)) != 0) {
+        fprintf(stderr, "Tópico válido recusado\n");
+        return -1;
+    }
+    const char *invalid[] = {"job=0", "job=abc", "job=", "batch=a:b", "tag=a,b", "fila=x", "job"};
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        if (notifier_parse_topic(invalid[i], topic, sizeof(topic)) != -1) {
+            fprintf(stderr, "Tópico inválido aceito: %s\n", invalid[i]);
+            return -1;
+        }
+    }
+    return 0;
+}
+
+// Uma linha por tópico com assinantes, entregue a cada um deles; job= vale
+// para um único término
+int test_fanout(notifier_t *notifier) {
+    peer_t a, b, c;
+    if (peer_open(notifier, &a) != 0 || peer_open(notifier, &b) != 0 || peer_open(notifier, &c) != 0) return -1;
+    notifier_subscribe(notifier, a.sub, "job=7");
+    notifier_subscribe(notifier, a.sub, "batch=etl");
+    notifier_subscribe(notifier, a.sub, "batch=etl");
+    notifier_subscribe(notifier, b.sub, "batch=etl");
+    notifier_subscribe(notifier, c.sub, "tag=gpu");
+    notifier_subscribe(notifier, c.sub, "tag=lua");
+
+    int topics;
+    long published, dropped;
+    notify_event_t event = {7, JOB_COMPLETED, 1.5, "ok", "etl", "python3,gpu"};
+    notifier_publish(notifier, &event);
+
+    int rc = 0;
+    notifier_get_counters(notifier, NULL, &topics, &published, &dropped);
+    // job=7, batch=etl e tag=gpu: tag=python3 não tem assinantes
+    if (published != 3 || topics != 3) {
+        fprintf(stderr, "%ld linhas montadas e %d tópicos, esperado 3 e 3\n", published, topics);
+        rc = -1;
+    }
+    if (rc == 0 && (expect_line(&a, "a", "NOTIFY:job=7:7:COMPLETED:1.50:ok") != 0 ||
+                    expect_line(&a, "a", "NOTIFY:batch=etl:7:") != 0 || expect_silence(&a, "a") != 0 ||
+                    expect_line(&b, "b", "NOTIFY:batch=etl:7:") != 0 || expect_silence(&b, "b") != 0 ||
+                    expect_line(&c, "c", "NOTIFY:tag=gpu:7:") != 0 || expect_silence(&c, "c") != 0)) {
+        rc = -1;
+    }
+
+    // job=7 acabou; o batch segue
+    if (rc == 0 && notifier_unsubscribe(notifier, a.sub, "job=7") != -1) {
+        fprintf(stderr, "Assinatura de job notificado continuou\n");
+        rc = -1;
+    }
+    event.job_id = 8;
+    event.tags = NULL;
+    notifier_publish(notifier, &event);
+    if (rc == 0 && (expect_line(&a, "a", "NOTIFY:batch=etl:8:") != 0 || expect_silence(&a, "a") != 0 ||
+                    expect_line(&b, "b", "NOTIFY:batch=etl:8:") != 0 || expect_silence(&c, "c") != 0)) {
+        rc = -1;
+    }
+
+    // Quem sai deixa de receber; tópico vazio some
+    notifier_unsubscribe(notifier, b.sub, "batch=etl");
+    peer_close(notifier, &c);
+    notifier_get_counters(notifier, NULL, &topics, NULL, NULL);
+    if (rc == 0 && topics != 1) {
+        fprintf(stderr, "%d tópicos depois das saídas, esperado 1\n", topics);
+        rc = -1;
+    }
+    event.job_id = 9;
+    notifier_publish(notifier, &event);
+    if (rc == 0 && (expect_line(&a, "a", "NOTIFY:batch=etl:9:") != 0 || expect_silence(&b, "b") != 0)) {
+        rc = -1;
+    }
+
+    // Resposta direta a um só assinante, pelo mesmo buffer
+    notifier_deliver(notifier, b.sub, "job=3", &event);
+    if (rc == 0 && (expect_line(&b, "b", "NOTIFY:job=3:9:") != 0 || expect_silence(&a, "a") != 0)) {
+        rc = -1;
+    }
+
+    peer_close(notifier, &a);
+    peer_close(notifier, &b);
+    return rc;
+}
+
+// Assinante que não lê: o buffer descarta as mais antigas e avisa com
+// NOTIFY_LOST; nada se perde sem ser contado e a última sempre chega
+int test_slow_subscriber(notifier_t *notifier) {
+    peer_t slow;
+    if (peer_open(notifier, &slow) != 0) return -1;
+    int small = 4096;
+    setsockopt(slow.sockets[0], SOL_SOCKET, SO_SNDBUF, &small, sizeof(small));
+    setsockopt(slow.sockets[1], SOL_SOCKET, SO_RCVBUF, &small, sizeof(small));
+    notifier_subscribe(notifier, slow.sub, "batch=lento");
+
+    long before_published, before_dropped;
+    notifier_get_counters(notifier, NULL, NULL, &before_published, &before_dropped);
+
+    char output[1024];
+    memset(output, 'x', sizeof(output) - 1);
+    output[sizeof(output) - 1] = '\0';
+    int total = NOTIFY_BUFFER * 4;
+    for (int i = 1; i <= total; i++) {
+        notify_event_t event = {i, JOB_FAILED, 0, output, "lento", NULL};
+        notifier_publish(notifier, &event);
+    }
+
+    long published, dropped;
+    notifier_get_counters(notifier, NULL, NULL, &published, &dropped);
+    dropped -= before_dropped;
+
+    int received = 0, last = 0, rc = 0;
+    long lost = 0;
+    char line[PROTOCOL_LINE_MAX];
+    while (last < total && peer_read(&slow, line, sizeof(line), 2000)) {
+        long n;
+        if (sscanf(line, "NOTIFY_LOST:%ld", &n) == 1) {
+            lost += n;
+        } else if (sscanf(line, "NOTIFY:batch=lento:%d:", &last) == 1) {
+            received++;
+        }
+    }
+    if (published - before_published != total || dropped == 0 || lost != dropped ||
+        received + lost != total || last != total) {
+        fprintf(stderr, "%d recebidas, %ld perdidas (%ld descartadas), última %d de %d\n",
+                received, lost, dropped, last, total);
+        rc = -1;
+    }
+    peer_close(notifier, &slow);
+    return rc;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_notifier.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+    notifier_t notifier;
+    if (notifier_init(&notifier, &logger) != 0) {
+        tslog_destroy(&logger);
+        return 1;
+    }
+
+    int rc = 0;
+    if (test_parse_topic() != 0) rc = 1;
+    if (rc == 0 && test_fanout(&notifier) != 0) rc = 1;
+    if (rc == 0 && test_slow_subscriber(&notifier) != 0) rc = 1;
+
+    notifier_destroy(&notifier);
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste das notificações concluído\n");
+    return rc;
+}
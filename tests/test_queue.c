@@ -0,0 +1,223 @@
+#include "../include/tslog.h"
+#include "../include/job_queue.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+tslog_t logger;
+
+static int push_job(job_queue_t *queue, const char *client, int priority) {
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    snprintf(job.script, sizeof(job.script), "echo %s", client);
+    snprintf(job.client, sizeof(job.client), "%s", client);
+    job.priority = priority;
+    job.timeout = 60;
+    return job_queue_push(queue, &job);
+}
+
+// Job que já esperou `age` segundos (requeue mantém o horário de submissão)
+static int requeue_aged(job_queue_t *queue, int job_id, const char *client, int priority, int age) {
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    job.job_id = job_id;
+    snprintf(job.script, sizeof(job.script), "echo velho");
+    snprintf(job.client, sizeof(job.client), "%s", client);
+    job.priority = priority;
+    job.timeout = 60;
+    job.submitted_at = time(NULL) - age;
+    return job_queue_requeue(queue, &job);
+}
+
+static int pop_job(job_queue_t *queue, job_t *job) {
+    memset(job, 0, sizeof(*job));
+    return job_queue_pop_timed(queue, job, 0);
+}
+
+int test_weighted_share() {
+    job_queue_t queue;
+    if (job_queue_init(&queue, &logger) != 0) return -1;
+    job_queue_set_weight(&queue, "a", 3);
+
+    // Peso 3 contra dois clientes de peso 1: 3/5, 1/5 e 1/5 a cada rodada
+    for (int i = 0; i < 40; i++) {
+        push_job(&queue, "a", 5);
+        push_job(&queue, "b", 5);
+        push_job(&queue, "c", 5);
+    }
+
+    int rc = 0;
+    int served[3] = {0, 0, 0};
+    for (int round = 1; round <= 10 && rc == 0; round++) {
+        for (int i = 0; i < 5; i++) {
+            job_t job;
+            if (pop_job(&queue, &job) != 0) {
+                fprintf(stderr, "Fila vazia antes da hora\n");
+                rc = -1;
+                break;
+            }
+            served[job.client[0] - 'a']++;
+        }
+        if (rc == 0 && (served[0] != 3 * round || served[1] != round || served[2] != round)) {
+            fprintf(stderr, "Rodada %d: a=%d b=%d c=%d (esperado %d/%d/%d)\n",
+                    round, served[0], served[1], served[2], 3 * round, round, round);
+            rc = -1;
+        }
+    }
+
+    job_queue_destroy(&queue);
+    return rc;
+}
+
+int test_flood_isolation() {
+    job_queue_t queue;
+    if (job_queue_init(&queue, &logger) != 0) return -1;
+
+    // Um cliente inunda a fila com prioridade máxima; o job do outro sai na
+    // próxima vez dele, não depois dos 1000
+    for (int i = 0; i < 1000; i++) push_job(&queue, "inunda", 10);
+    int late = push_job(&queue, "pontual", 1);
+
+    int rc = -1;
+    for (int i = 0; i < 2; i++) {
+        job_t job;
+        if (pop_job(&queue, &job) != 0) break;
+        if (job.job_id == late) {
+            rc = 0;
+            break;
+        }
+    }
+    if (rc != 0) fprintf(stderr, "Job do cliente pontual ficou atrás da inundação\n");
+
+    job_queue_destroy(&queue);
+    return rc;
+}
+
+// Envelhecimento de 30s por ponto: prioridade 1 contra 10 são 9 pontos, 270s
+static int aged_wins(int aging, int age) {
+    job_queue_t queue;
+    if (job_queue_init(&queue, &logger) != 0) return -1;
+    job_queue_set_aging(&queue, aging);
+
+    int old_id = job_queue_reserve_id(&queue);
+    requeue_aged(&queue, old_id, "x", 1, age);
+    for (int i = 0; i < 20; i++) push_job(&queue, "x", 10);
+
+    job_t job;
+    int rc = pop_job(&queue, &job) != 0 ? -1 : job.job_id == old_id;
+    job_queue_destroy(&queue);
+    return rc;
+}
+
+int test_aging() {
+    if (aged_wins(30, 0) != 0) {
+        fprintf(stderr, "Job novo de prioridade 1 passou na frente da prioridade 10\n");
+        return -1;
+    }
+    if (aged_wins(30, 250) != 0) {
+        fprintf(stderr, "Job de prioridade 1 venceu antes de envelhecer 270s\n");
+        return -1;
+    }
+    if (aged_wins(30, 290) != 1) {
+        fprintf(stderr, "Job de prioridade 1 envelhecido não passou os mais novos\n");
+        return -1;
+    }
+    if (aged_wins(0, 100000) != 0) {
+        fprintf(stderr, "Sem envelhecimento a prioridade não foi estrita\n");
+        return -1;
+    }
+
+    // Ligar o envelhecimento depois recalcula as chaves dos pendentes
+    job_queue_t queue;
+    if (job_queue_init(&queue, &logger) != 0) return -1;
+    job_queue_set_aging(&queue, 0);
+    int old_id = job_queue_reserve_id(&queue);
+    requeue_aged(&queue, old_id, "x", 1, 600);
+    for (int i = 0; i < 5; i++) push_job(&queue, "x", 10);
+    job_queue_set_aging(&queue, 30);
+
+    job_t job;
+    int rc = 0;
+    if (pop_job(&queue, &job) != 0 || job.job_id != old_id) {
+        fprintf(stderr, "job_queue_set_aging não recalculou as chaves pendentes\n");
+        rc = -1;
+    }
+    job_queue_destroy(&queue);
+    return rc;
+}
+
+// Admissão com histerese: recusa a partir da marca alta e só volta a
+// aceitar abaixo da baixa; jobs já aceitos (requeue) sempre entram
+int test_watermarks() {
+    job_queue_t queue;
+    if (job_queue_init(&queue, &logger) != 0) return -1;
+    job_queue_set_watermarks(&queue, 10, 5, 0, 0);
+
+    int rc = 0;
+    int retry = 0;
+    for (int i = 0; i < 9; i++) push_job(&queue, "x", 5);
+    if (job_queue_admit(&queue, &retry) != 0) {
+        fprintf(stderr, "Recusado abaixo da marca alta\n");
+        rc = -1;
+    }
+    push_job(&queue, "x", 5);
+    if (rc == 0 && (job_queue_admit(&queue, &retry) != 1 || retry < JOB_QUEUE_RETRY_MIN_MS ||
+                    retry > JOB_QUEUE_RETRY_MAX_MS)) {
+        fprintf(stderr, "Marca alta não recusou (retry-after %dms)\n", retry);
+        rc = -1;
+    }
+
+    job_t job;
+    for (int i = 0; i < 4; i++) pop_job(&queue, &job);
+    if (rc == 0 && job_queue_admit(&queue, &retry) != 1) {
+        fprintf(stderr, "Voltou a aceitar com %d jobs, acima da marca baixa\n", job_queue_size(&queue));
+        rc = -1;
+    }
+    if (rc == 0 && (job_queue_requeue(&queue, &job) != 0 || job_queue_size(&queue) != 7)) {
+        fprintf(stderr, "Nova tentativa barrada pela admissão\n");
+        rc = -1;
+    }
+    pop_job(&queue, &job);
+    if (rc == 0 && job_queue_admit(&queue, &retry) != 1) {
+        fprintf(stderr, "Voltou a aceitar antes da marca baixa\n");
+        rc = -1;
+    }
+    pop_job(&queue, &job);
+    if (rc == 0 && (job_queue_admit(&queue, &retry) != 0 || queue.rejected != 3)) {
+        fprintf(stderr, "Marca baixa não liberou a admissão (%ld recusas)\n", queue.rejected);
+        rc = -1;
+    }
+
+    // Marca de memória: mesma histerese, pelo tamanho dos pendentes
+    job_queue_set_watermarks(&queue, 0, 0, job_queue_bytes(&queue) + 2 * sizeof(job_node_t), 0);
+    push_job(&queue, "x", 5);
+    if (rc == 0 && job_queue_admit(&queue, &retry) != 0) {
+        fprintf(stderr, "Recusado abaixo da marca de memória\n");
+        rc = -1;
+    }
+    push_job(&queue, "x", 5);
+    if (rc == 0 && job_queue_admit(&queue, &retry) != 1) {
+        fprintf(stderr, "Marca de memória não recusou com %zu bytes\n", job_queue_bytes(&queue));
+        rc = -1;
+    }
+    job_queue_destroy(&queue);
+    return rc;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_queue.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+
+    int rc = 0;
+    if (test_weighted_share() != 0) rc = 1;
+    if (rc == 0 && test_flood_isolation() != 0) rc = 1;
+    if (rc == 0 && test_aging() != 0) rc = 1;
+    if (rc == 0 && test_watermarks() != 0) rc = 1;
+
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste da fila concluído\n");
+    return rc;
+}
@@ -0,0 +1,202 @@
+#include "../include/tslog.h"
+#include "../include/job_queue.h"
+#include "../include/job_index.h"
+#include "../include/idempotency.h"
+#include "../include/replication.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/socket.h>
+
+tslog_t logger;
+
+// Um servidor: fila, índice e chaves, como o server.c monta
+typedef struct {
+    job_queue_t queue;
+    job_index_t index;
+    idempotency_t idem;
+    replication_t repl;
+} node_t;
+
+static int node_init(node_t *node) {
+    if (job_index_init(&node->index) != 0) return -1;
+    if (job_queue_init(&node->queue, &logger) != 0 ||
+        idempotency_init(&node->idem, 600, 1024, &logger) != 0 ||
+        replication_init(&node->repl, &node->queue, &node->index, &node->idem, &logger) != 0) {
+        return -1;
+    }
+    job_queue_attach_index(&node->queue, &node->index);
+    return 0;
+}
+
+static void node_destroy(node_t *node) {
+    replication_destroy(&node->repl);
+    idempotency_destroy(&node->idem);
+    job_queue_destroy(&node->queue);
+    job_index_destroy(&node->index);
+}
+
+typedef struct {
+    replication_t *repl;
+    int sock;
+} serve_ctx_t;
+
+// Conexão do standby no primário: lê o REPLICATE e atende até ela cair
+static void *serve_thread(void *arg) {
+    serve_ctx_t *ctx = (serve_ctx_t*)arg;
+    line_reader_t reader;
+    line_reader_init(&reader);
+    char line[128];
+    long from = 0;
+    if (line_reader_next(&reader, ctx->sock, line, sizeof(line)) > 0 &&
+        sscanf(line, "REPLICATE:%ld", &from) == 1) {
+        replication_serve(ctx->repl, ctx->sock, &reader, from, "teste");
+    }
+    return NULL;
+}
+
+static int listen_local(int *port) {
+    int sock = socket(AF_INET, SOCK_STREAM, 0);
+    struct sockaddr_in addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sin_family = AF_INET;
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    socklen_t len = sizeof(addr);
+    if (sock < 0 || bind(sock, (struct sockaddr*)&addr, sizeof(addr)) != 0 || listen(sock, 4) != 0 ||
+        getsockname(sock, (struct sockaddr*)&addr, &len) != 0) {
+        if (sock >= 0) close(sock);
+        return -1;
+    }
+    *port = ntohs(addr.sin_port);
+    return sock;
+}
+
+static int push_job(node_t *node, const char *script) {
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    snprintf(job.script, sizeof(job.script), "%s", script);
+    snprintf(job.client, sizeof(job.client), "repl");
+    job.priority = 5;
+    job.timeout = 60;
+    int id = job_queue_push(&node->queue, &job);
+    job.job_id = id;
+    replication_log_enqueue(&node->repl, &job);
+    return id;
+}
+
+// Espera o standby aplicar tudo o que o primário registrou
+static int wait_applied(node_t *primary, node_t *standby) {
+    for (int waited = 0; waited < 5000; waited += 50) {
+        pthread_mutex_lock(&primary->repl.mutex);
+        long head = primary->repl.head;
+        pthread_mutex_unlock(&primary->repl.mutex);
+        pthread_mutex_lock(&standby->repl.mutex);
+        long applied = standby->repl.applied;
+        pthread_mutex_unlock(&standby->repl.mutex);
+        if (applied >= head) return 0;
+        usleep(50000);
+    }
+    fprintf(stderr, "Standby não alcançou o primário\n");
+    return -1;
+}
+
+static int expect_index(node_t *node, int job_id, job_status_t status) {
+    job_index_entry_t entry;
+    if (job_index_get(&node->index, job_id, &entry) != 0 || entry.status != status) {
+        fprintf(stderr, "Job %d no standby com status %d, esperado %d\n", job_id, entry.status, status);
+        return -1;
+    }
+    return 0;
+}
+
+// Foto inicial (RESYNC), fluxo de registros depois dela e promoção quando
+// o primário some: só os jobs vivos entram na fila do standby
+int test_apply_and_promote(node_t *primary, node_t *standby) {
+    replication_enable(&primary->repl);
+    int running = push_job(primary, "echo rodando");
+    int finished = push_job(primary, "echo terminado");
+    replication_log_status(&primary->repl, running, JOB_RUNNING, 4, 0);
+    replication_log_status(&primary->repl, finished, JOB_COMPLETED, 4, 0);
+
+    int port;
+    int listener = listen_local(&port);
+    char address[64];
+    snprintf(address, sizeof(address), "127.0.0.1:%d", port);
+    if (listener < 0 || replication_set_standby(&standby->repl, address, 1) != 0) return -1;
+
+    pthread_t follower, server;
+    pthread_create(&follower, NULL, replication_follow_thread, &standby->repl);
+    serve_ctx_t ctx = {&primary->repl, accept(listener, NULL, NULL)};
+    if (ctx.sock < 0) return -1;
+    pthread_create(&server, NULL, serve_thread, &ctx);
+
+    int rc = wait_applied(primary, standby);
+    // Só vivos na foto: o terminado nunca chega ao standby
+    job_index_entry_t entry;
+    if (rc == 0 && (expect_index(standby, running, JOB_RUNNING) != 0 ||
+                    job_index_get(&standby->index, finished, &entry) == 0)) {
+        rc = -1;
+    }
+
+    // Depois da foto, o fluxo: job novo, transição e chave de idempotência
+    int streamed = push_job(primary, "echo depois");
+    int done = push_job(primary, "echo rápido");
+    replication_log_status(&primary->repl, done, JOB_FAILED, 4, 1);
+    replication_log_key(&primary->repl, "chave-1", IDEMPOTENCY_JOB, streamed, 0);
+    if (rc == 0) rc = wait_applied(primary, standby);
+    idempotency_record_t rec;
+    if (rc == 0 && (expect_index(standby, streamed, JOB_PENDING) != 0 ||
+                    expect_index(standby, done, JOB_FAILED) != 0)) {
+        rc = -1;
+    }
+    if (rc == 0 && (idempotency_claim(&standby->idem, "chave-1", &rec) != 1 || rec.id != streamed)) {
+        fprintf(stderr, "Chave replicada não encontrada no standby\n");
+        rc = -1;
+    }
+    if (rc == 0 && (!replication_is_standby(&standby->repl) || job_queue_size(&standby->queue) != 0)) {
+        fprintf(stderr, "Standby pôs jobs na fila antes da promoção\n");
+        rc = -1;
+    }
+
+    // O primário cai: o standby assume com os vivos (em execução e pendente)
+    shutdown(ctx.sock, SHUT_RDWR);
+    close(listener);
+    pthread_join(server, NULL);
+    close(ctx.sock);
+    pthread_join(follower, NULL);
+
+    if (rc == 0 && (replication_is_standby(&standby->repl) || job_queue_size(&standby->queue) != 2)) {
+        fprintf(stderr, "Promoção com %d jobs na fila, esperado 2\n", job_queue_size(&standby->queue));
+        rc = -1;
+    }
+    if (rc == 0 && push_job(standby, "echo novo") <= done) {
+        fprintf(stderr, "Standby promovido reaproveitou ids do primário\n");
+        rc = -1;
+    }
+    return rc;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_replication.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+
+    node_t primary, standby;
+    if (node_init(&primary) != 0 || node_init(&standby) != 0) {
+        fprintf(stderr, "Erro ao inicializar primário e standby\n");
+        return 1;
+    }
+
+    int rc = 0;
+    if (test_apply_and_promote(&primary, &standby) != 0) rc = 1;
+
+    node_destroy(&standby);
+    node_destroy(&primary);
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste da replicação concluído\n");
+    return rc;
+}
@@ -0,0 +1,150 @@
+#include "../src/common/shard_ring.h"
+#include <stdio.h>
+#include <string.h>
+
+int test_parse() {
+    shard_ring_t ring;
+    if (shard_ring_parse(&ring, "3=alfa:7000/beta:7001,db.local:7100") != 0) {
+        fprintf(stderr, "Especificação válida recusada\n");
+        return -1;
+    }
+    const shard_t *first = &ring.shards[0];
+    const shard_t *second = &ring.shards[1];
+    if (ring.count != 2 || first->number != 3 || strcmp(first->host, "alfa") != 0 ||
+        first->port != 7000 || strcmp(first->standby_host, "beta") != 0 ||
+        first->standby_port != 7001) {
+        fprintf(stderr, "Shard com standby lida errado\n");
+        return -1;
+    }
+    // Sem número, a posição na lista; sem barra, sem standby
+    if (second->number != 1 || strcmp(second->host, "db.local") != 0 ||
+        second->port != 7100 || second->standby_host[0] != '\0') {
+        fprintf(stderr, "Shard sem número lida errado\n");
+        return -1;
+    }
+    if (ring.point_count != 2 * SHARD_VNODES) {
+        fprintf(stderr, "Anel com %d pontos\n", ring.point_count);
+        return -1;
+    }
+    return 0;
+}
+
+int test_reject() {
+    const char *invalid[] = {
+        "",
+        "1=a:7000,1=b:7001",        // número repetido
+        "a:7000,0=b:7001",          // repetido com a posição de a
+        "32=a:7000",                // fora de 0..SHARD_MAX-1
+        "-1=a:7000",
+        "x=a:7000",
+        "a:0",
+        "a:70000",
+        ":7000",
+        "a:7000/b",                 // standby sem porta
+    };
+    shard_ring_t ring;
+    for (size_t i = 0; i < sizeof(invalid) / sizeof(invalid[0]); i++) {
+        if (shard_ring_parse(&ring, invalid[i]) == 0) {
+            fprintf(stderr, "Especificação inválida aceita: \"%s\"\n", invalid[i]);
+            return -1;
+        }
+    }
+
+    // Lista longa: lida inteira, nunca cortada num endereço que parece válido
+    char spec[4096];
+    memset(spec, '0', sizeof(spec));
+    snprintf(spec + sizeof(spec) - 16, 16, "=a:7000");
+    if (shard_ring_parse(&ring, spec) != 0 || ring.count != 1 || ring.shards[0].port != 7000) {
+        fprintf(stderr, "Especificação longa lida errado\n");
+        return -1;
+    }
+    return 0;
+}
+
+// O maior anel possível: todas as shards, hosts do tamanho máximo e standby
+int test_max_spec() {
+    char host[SHARD_HOST_MAX], standby[SHARD_HOST_MAX];
+    memset(host, 'h', sizeof(host) - 1);
+    memset(standby, 's', sizeof(standby) - 1);
+    host[sizeof(host) - 1] = standby[sizeof(standby) - 1] = '\0';
+
+    char spec[SHARD_MAX * (2 * SHARD_HOST_MAX + 24)];
+    size_t len = 0;
+    for (int n = SHARD_MAX - 1; n >= 0; n--) {
+        len += snprintf(spec + len, sizeof(spec) - len, "%s%d=%s:65535/%s:65534",
+                        len ? "," : "", n, host, standby);
+    }
+    shard_ring_t ring;
+    if (shard_ring_parse(&ring, spec) != 0 || ring.count != SHARD_MAX) {
+        fprintf(stderr, "Especificação máxima (%zu bytes) recusada\n", len);
+        return -1;
+    }
+    const shard_t *last = &ring.shards[SHARD_MAX - 1];
+    if (last->number != 0 || strcmp(last->host, host) != 0 || last->port != 65535 ||
+        strcmp(last->standby_host, standby) != 0 || last->standby_port != 65534) {
+        fprintf(stderr, "Última shard da especificação máxima lida errado\n");
+        return -1;
+    }
+    // Uma a mais não cabe
+    snprintf(spec + len, sizeof(spec) - len, ",x:1");
+    if (shard_ring_parse(&ring, spec) == 0) {
+        fprintf(stderr, "Mais de %d shards aceitas\n", SHARD_MAX);
+        return -1;
+    }
+    return 0;
+}
+
+int test_route_order() {
+    shard_ring_t ring, reordered;
+    if (shard_ring_parse(&ring, "0=a:7000,5=b:7000,9=c:7000") != 0 ||
+        shard_ring_parse(&reordered, "9=c:7000,0=a:7000,5=b:7000") != 0) {
+        fprintf(stderr, "Especificação válida recusada\n");
+        return -1;
+    }
+    int used[SHARD_MAX] = {0};
+    for (int i = 0; i < 1000; i++) {
+        char key[32];
+        snprintf(key, sizeof(key), "cliente-%d", i);
+        const shard_t *a = shard_ring_route(&ring, key);
+        const shard_t *b = shard_ring_route(&reordered, key);
+        if (!a || !b || a->number != b->number) {
+            fprintf(stderr, "Chave %s mudou de shard com a lista reordenada\n", key);
+            return -1;
+        }
+        used[a->number]++;
+    }
+    if (!used[0] || !used[5] || !used[9]) {
+        fprintf(stderr, "Alguma shard não recebeu chaves (%d/%d/%d)\n", used[0], used[5], used[9]);
+        return -1;
+    }
+    return 0;
+}
+
+int test_align() {
+    for (int shard = 0; shard < SHARD_MAX; shard++) {
+        for (int value = 0; value < 200; value++) {
+            int id = shard_align_id(value, shard);
+            if (id <= 0 || id < value || id - value > SHARD_MAX || shard_of_id(id) != shard) {
+                fprintf(stderr, "shard_align_id(%d, %d) = %d\n", value, shard, id);
+                return -1;
+            }
+        }
+    }
+    if (shard_align_id(17, -1) != 17 || shard_of_id(0) != -1) {
+        fprintf(stderr, "Servidor único não manteve os ids\n");
+        return -1;
+    }
+    return 0;
+}
+
+int main() {
+    int rc = 0;
+    if (test_parse() != 0) rc = 1;
+    if (rc == 0 && test_reject() != 0) rc = 1;
+    if (rc == 0 && test_max_spec() != 0) rc = 1;
+    if (rc == 0 && test_route_order() != 0) rc = 1;
+    if (rc == 0 && test_align() != 0) rc = 1;
+
+    if (rc == 0) printf("Teste das shards concluído\n");
+    return rc;
+}
@@ -0,0 +1,171 @@
+#define _GNU_SOURCE
+#include "../src/common/local_transport.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+// Os dois lados do canal no mesmo processo: o worker cria, o servidor abre
+// cópias dos descritores como se tivessem chegado por SHM_ATTACH
+static int open_pair(shm_channel_t *worker, shm_channel_t *server) {
+    if (shm_channel_create(worker) != 0) return -1;
+    int fds[SHM_CHANNEL_FDS];
+    shm_channel_fds(worker, fds);
+    for (int i = 0; i < SHM_CHANNEL_FDS; i++) fds[i] = dup(fds[i]);
+    if (shm_channel_open(server, fds, SHM_CHANNEL_FDS) != 0) {
+        shm_channel_close(worker);
+        return -1;
+    }
+    return 0;
+}
+
+static void start_at(shm_area_t *area, uint32_t index) {
+    atomic_store(&area->job_head, index);
+    atomic_store(&area->job_tail, index);
+    atomic_store(&area->result_head, index);
+    atomic_store(&area->result_tail, index);
+}
+
+// Índices perto de UINT32_MAX: a ocupação (tail - head) continua certa
+// quando eles dão a volta, o anel enche em SHM_RING_SLOTS e sai em ordem
+int test_wraparound() {
+    shm_channel_t worker, server;
+    if (open_pair(&worker, &server) != 0) return -1;
+    start_at(server.area, UINT32_MAX - 5);
+
+    int rc = 0, next_push = 1, next_pop = 1;
+    for (int round = 0; round < 4 && rc == 0; round++) {
+        // Enche até recusar, esvazia metade (o último round esvazia tudo)
+        while (shm_channel_push_job(&server, next_push, next_push * 10, "echo anel", 30) == 0) next_push++;
+        if (next_push - next_pop != SHM_RING_SLOTS) {
+            fprintf(stderr, "Anel cheio com %d jobs, esperado %d\n", next_push - next_pop, SHM_RING_SLOTS);
+            rc = -1;
+            break;
+        }
+        int drain = round == 3 ? SHM_RING_SLOTS : SHM_RING_SLOTS / 2;
+        for (int i = 0; i < drain && rc == 0; i++) {
+            int job_id, lease_id, timeout;
+            char script[64];
+            if (shm_channel_pop_job(&worker, &job_id, &lease_id, script, sizeof(script), &timeout) != 1 ||
+                job_id != next_pop || lease_id != next_pop * 10 || timeout != 30 || strcmp(script, "echo anel") != 0) {
+                fprintf(stderr, "Retirada %d errada (job %d)\n", next_pop, job_id);
+                rc = -1;
+            }
+            next_pop++;
+        }
+    }
+    int job_id, lease_id, timeout;
+    char script[64];
+    if (rc == 0 && shm_channel_pop_job(&worker, &job_id, &lease_id, script, sizeof(script), &timeout) != 0) {
+        fprintf(stderr, "Anel vazio devolveu job\n");
+        rc = -1;
+    }
+    if (rc == 0 && atomic_load(&server.area->job_tail) >= UINT32_MAX - 5) {
+        fprintf(stderr, "Índices não deram a volta\n");
+        rc = -1;
+    }
+
+    // Resultados do outro lado, atravessando a volta também
+    for (int i = 0; i < 8 && rc == 0; i++) {
+        char output[16];
+        int success;
+        double exec_time;
+        if (shm_channel_push_result(&worker, i, i, 1, 0.5, "saída") != 0 ||
+            shm_channel_pop_result(&server, &job_id, &lease_id, &success, &exec_time, output, sizeof(output)) != 1 ||
+            job_id != i || strcmp(output, "saída") != 0) {
+            fprintf(stderr, "Resultado %d errado\n", i);
+            rc = -1;
+        }
+    }
+    shm_channel_close(&server);
+    shm_channel_close(&worker);
+    return rc;
+}
+
+// O servidor não confia na área: índices além da capacidade descartam o
+// anel e tamanhos fora do slot são limitados ao buffer de quem lê
+int test_corrupted_index() {
+    shm_channel_t worker, server;
+    if (open_pair(&worker, &server) != 0) return -1;
+
+    int rc = 0, job_id, lease_id, success;
+    double exec_time;
+    char output[MAX_RESULT_SIZE];
+    atomic_store(&worker.area->result_tail, SHM_RING_SLOTS + 5);
+    if (shm_channel_pop_result(&server, &job_id, &lease_id, &success, &exec_time, output, sizeof(output)) != 0 ||
+        atomic_load(&server.area->result_head) != SHM_RING_SLOTS + 5) {
+        fprintf(stderr, "Índice corrompido não descartou o anel\n");
+        rc = -1;
+    }
+
+    // Depois do descarte o anel volta a funcionar
+    shm_channel_push_result(&worker, 9, 1, 0, 1.0, "depois");
+    if (rc == 0 && (shm_channel_pop_result(&server, &job_id, &lease_id, &success, &exec_time,
+                                           output, sizeof(output)) != 1 || job_id != 9)) {
+        fprintf(stderr, "Anel não voltou depois do descarte\n");
+        rc = -1;
+    }
+
+    // Tamanho adulterado no slot: nunca passa do buffer
+    shm_channel_push_result(&worker, 10, 1, 1, 1.0, "curto");
+    uint32_t slot = atomic_load(&worker.area->result_head) % SHM_RING_SLOTS;
+    worker.area->results[slot].len = 1 << 30;
+    char small[8];
+    if (rc == 0 && (shm_channel_pop_result(&server, &job_id, &lease_id, &success, &exec_time,
+                                           small, sizeof(small)) != 1 || job_id != 10 || small[sizeof(small) - 1] != '\0')) {
+        fprintf(stderr, "Tamanho adulterado não foi limitado\n");
+        rc = -1;
+    }
+    shm_channel_push_result(&worker, 11, 1, 1, 1.0, "curto");
+    worker.area->results[(slot + 1) % SHM_RING_SLOTS].len = -7;
+    if (rc == 0 && (shm_channel_pop_result(&server, &job_id, &lease_id, &success, &exec_time,
+                                           output, sizeof(output)) != 1 || output[0] != '\0')) {
+        fprintf(stderr, "Tamanho negativo não foi limitado\n");
+        rc = -1;
+    }
+    shm_channel_close(&server);
+    shm_channel_close(&worker);
+    return rc;
+}
+
+// Descritores que não vieram de shm_channel_create são recusados
+int test_open_reject() {
+    shm_channel_t worker, server;
+    if (shm_channel_create(&worker) != 0) return -1;
+
+    int rc = 0;
+    int fds[SHM_CHANNEL_FDS];
+    shm_channel_fds(&worker, fds);
+    for (int i = 0; i < SHM_CHANNEL_FDS; i++) fds[i] = dup(fds[i]);
+    if (shm_channel_open(&server, fds, 2) == 0) {
+        fprintf(stderr, "Canal aberto com dois descritores\n");
+        rc = -1;
+    }
+    close(fds[2]);
+
+    // Mesmo tamanho, sem selos: o worker poderia encolher o arquivo
+    shm_channel_fds(&worker, fds);
+    for (int i = 1; i < SHM_CHANNEL_FDS; i++) fds[i] = dup(fds[i]);
+    fds[0] = memfd_create("teste", MFD_CLOEXEC);
+    if (fds[0] < 0 || ftruncate(fds[0], sizeof(shm_area_t)) != 0) rc = -1;
+    if (rc == 0 && shm_channel_open(&server, fds, SHM_CHANNEL_FDS) == 0) {
+        fprintf(stderr, "Canal aberto com memfd sem selos\n");
+        rc = -1;
+    }
+    if (rc == 0 && (server.memfd != -1 || server.area != NULL)) {
+        fprintf(stderr, "Canal recusado ficou com descritores\n");
+        rc = -1;
+    }
+    shm_channel_close(&worker);
+    return rc;
+}
+
+int main() {
+    int rc = 0;
+    if (test_wraparound() != 0) rc = 1;
+    if (rc == 0 && test_corrupted_index() != 0) rc = 1;
+    if (rc == 0 && test_open_reject() != 0) rc = 1;
+
+    if (rc == 0) printf("Teste do canal de memória compartilhada concluído\n");
+    return rc;
+}
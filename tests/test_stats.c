@@ -0,0 +1,106 @@
+#include "../include/tslog.h"
+#include "../include/job_queue.h"
+#include "../include/job_stats.h"
+#include <stdio.h>
+#include <string.h>
+
+tslog_t logger;
+
+// Mais workers que os antigos 64 slots: cada id tem os seus contadores
+int test_worker_ids() {
+    job_stats_t stats;
+    if (job_stats_init(&stats) != 0) return -1;
+
+    int rc = 0;
+    for (int id = 1; id <= 200; id++) {
+        job_stats_record_start(&stats, 5, id);
+        job_stats_record_finish(&stats, 5, id, id % 2, 0.01);
+    }
+    job_stats_snapshot_t snap;
+    for (int id = 1; id <= 200 && rc == 0; id++) {
+        job_stats_get_worker(&stats, id, &snap);
+        if (snap.started != 1 || snap.completed != id % 2 || snap.failed != 1 - id % 2) {
+            fprintf(stderr, "Worker %d: ini %ld ok %ld falha %ld\n",
+                    id, snap.started, snap.completed, snap.failed);
+            rc = -1;
+        }
+    }
+
+    int ids[256];
+    if (rc == 0 && (job_stats_list_workers(&stats, ids, 256) != 200 || ids[0] != 1 || ids[199] != 200)) {
+        fprintf(stderr, "Lista de workers errada\n");
+        rc = -1;
+    }
+
+    // Worker desconectado sai da lista; resultado atrasado não o recria
+    job_stats_forget_worker(&stats, 65);
+    job_stats_record_finish(&stats, 5, 65, 1, 0.01);
+    job_stats_get_worker(&stats, 65, &snap);
+    if (rc == 0 && (snap.started != 0 || snap.completed != 0 ||
+                    job_stats_list_workers(&stats, ids, 256) != 199)) {
+        fprintf(stderr, "Worker esquecido ainda tem contadores\n");
+        rc = -1;
+    }
+    job_stats_get_worker(&stats, 1, &snap);
+    if (rc == 0 && snap.started != 1) {
+        fprintf(stderr, "Esquecer o worker 65 mexeu no worker 1\n");
+        rc = -1;
+    }
+    job_stats_destroy(&stats);
+    return rc;
+}
+
+// Total da fila: tudo o que foi submetido, não só os pendentes
+int test_queue_total() {
+    job_stats_t stats;
+    job_queue_t queue;
+    if (job_stats_init(&stats) != 0) return -1;
+    if (job_queue_init(&queue, &logger) != 0) {
+        job_stats_destroy(&stats);
+        return -1;
+    }
+    job_queue_attach_stats(&queue, &stats);
+
+    for (int i = 0; i < 5; i++) {
+        job_t job;
+        memset(&job, 0, sizeof(job));
+        snprintf(job.script, sizeof(job.script), "echo %d", i);
+        snprintf(job.client, sizeof(job.client), "c");
+        job.priority = 5;
+        job.timeout = 60;
+        job_queue_push(&queue, &job);
+    }
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    job_queue_pop_timed(&queue, &job, 0);
+    job_stats_record_finish(&stats, job.priority, 0, 1, 0.1);
+    memset(&job, 0, sizeof(job));
+    job_queue_pop_timed(&queue, &job, 0);
+
+    int total, pending, running, completed;
+    job_queue_stats(&queue, &total, &pending, &running, &completed);
+    int rc = 0;
+    if (total != 5 || pending != 3 || running != 1 || completed != 1) {
+        fprintf(stderr, "Fila: total %d pendentes %d executando %d concluídos %d\n",
+                total, pending, running, completed);
+        rc = -1;
+    }
+    job_queue_destroy(&queue);
+    job_stats_destroy(&stats);
+    return rc;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_stats.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+
+    int rc = 0;
+    if (test_worker_ids() != 0) rc = 1;
+    if (rc == 0 && test_queue_total() != 0) rc = 1;
+
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste das estatísticas concluído\n");
+    return rc;
+}
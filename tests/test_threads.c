@@ -1,10 +1,15 @@
 #include "../include/tslog.h"
+#include "../src/libtslog/tslog_binary.h"
 #include <pthread.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <string.h>
+#include <dirent.h>
+#include <sys/stat.h>
 
 #define NUM_THREADS 5
 #define LOGS_PER_THREAD 10
+#define ASYNC_LOGS_PER_THREAD 2000
 
 tslog_t logger;
 
@@ -20,6 +25,293 @@ void* worker_thread(void* arg) {
     return NULL;
 }
 
+void* async_worker_thread(void* arg) {
+    int thread_id = *(int*)arg;
+    
+    for (int i = 0; i < ASYNC_LOGS_PER_THREAD; i++) {
+        tslog_info(&logger, "Async %d %d", thread_id, i);
+    }
+    return NULL;
+}
+
+// Verifica se todas as linhas chegaram e se a ordem de cada thread foi mantida
+int check_async_log(const char *filename) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) return -1;
+    
+    int next[NUM_THREADS + 1] = {0};
+    int lines = 0;
+    char line[256];
+    
+    while (fgets(line, sizeof(line), fp)) {
+        char *msg = strstr(line, "Async ");
+        int thread_id, seq;
+        if (!msg || sscanf(msg, "Async %d %d", &thread_id, &seq) != 2) continue;
+        if (thread_id < 1 || thread_id > NUM_THREADS || seq != next[thread_id]) {
+            fprintf(stderr, "Ordem violada: thread %d seq %d\n", thread_id, seq);
+            fclose(fp);
+            return -1;
+        }
+        next[thread_id]++;
+        lines++;
+    }
+    
+    fclose(fp);
+    return lines == NUM_THREADS * ASYNC_LOGS_PER_THREAD ? 0 : -1;
+}
+
+int test_async() {
+    const char *filename = "test_async.log";
+    unlink(filename);
+    
+    if (tslog_init(&logger, filename, TSLOG_INFO) != 0 ||
+        tslog_enable_async(&logger, 8 * 1024, TSLOG_OVERFLOW_BLOCK) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger assíncrono\n");
+        return -1;
+    }
+    
+    pthread_t threads[NUM_THREADS];
+    int thread_ids[NUM_THREADS];
+    
+    for (int i = 0; i < NUM_THREADS; i++) {
+        thread_ids[i] = i + 1;
+        pthread_create(&threads[i], NULL, async_worker_thread, &thread_ids[i]);
+    }
+    for (int i = 0; i < NUM_THREADS; i++) {
+        pthread_join(threads[i], NULL);
+    }
+    
+    tslog_destroy(&logger);
+    
+    if (check_async_log(filename) != 0) {
+        fprintf(stderr, "Log assíncrono incompleto ou fora de ordem\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Apaga os arquivos do diretório e o próprio diretório
+static void remove_dir(const char *dir) {
+    DIR *d = opendir(dir);
+    struct dirent *entry;
+    char path[512];
+    while (d && (entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        snprintf(path, sizeof(path), "%s/%s", dir, entry->d_name);
+        unlink(path);
+    }
+    if (d) closedir(d);
+    rmdir(dir);
+}
+
+// Rotação por tamanho: sobram o arquivo atual e no máximo `keep` segmentos .gz
+int test_rotation() {
+    char dir[] = "/tmp/test_rotation.XXXXXX";
+    const int keep = 3;
+    if (!mkdtemp(dir)) {
+        fprintf(stderr, "Erro ao criar diretório temporário\n");
+        return -1;
+    }
+
+    char filename[512];
+    snprintf(filename, sizeof(filename), "%s/rotate.log", dir);
+    if (tslog_init(&logger, filename, TSLOG_INFO) != 0 ||
+        tslog_enable_rotation(&logger, 4 * 1024, 0, keep, 1) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger com rotação\n");
+        remove_dir(dir);
+        return -1;
+    }
+
+    for (int i = 0; i < 2000; i++) {
+        tslog_info(&logger, "Rotacao %d", i);
+    }
+    tslog_destroy(&logger);
+
+    int current = 0, segments = 0, uncompressed = 0;
+    DIR *d = opendir(dir);
+    struct dirent *entry;
+    while (d && (entry = readdir(d)) != NULL) {
+        if (entry->d_name[0] == '.') continue;
+        if (strcmp(entry->d_name, "rotate.log") == 0) {
+            current++;
+        } else {
+            segments++;
+            if (!strstr(entry->d_name, ".gz")) uncompressed++;
+        }
+    }
+    if (d) closedir(d);
+    remove_dir(dir);
+
+    if (current != 1 || segments == 0 || segments > keep || uncompressed > 0) {
+        fprintf(stderr, "Rotação incorreta: atual=%d segmentos=%d sem gzip=%d\n",
+                current, segments, uncompressed);
+        return -1;
+    }
+    return 0;
+}
+
+// Limite por ponto de chamada: poucas linhas passam e o resto vira resumo
+int test_rate_limit() {
+    const char *filename = "test_rate_limit.log";
+    unlink(filename);
+
+    if (tslog_init(&logger, filename, TSLOG_INFO) != 0) {
+        return -1;
+    }
+    tslog_set_rate_limit("teste", 10, 1);
+
+    for (int i = 0; i < 1000; i++) {
+        tslog_info_limited(&logger, "teste", "Limitada %d", i);
+    }
+    tslog_destroy(&logger);
+
+    FILE *fp = fopen(filename, "r");
+    if (!fp) return -1;
+
+    char line[256];
+    int lines = 0, summaries = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        lines++;
+        if (strstr(line, "mensagens suprimidas")) summaries++;
+    }
+    fclose(fp);
+
+    long suppressed = 0;
+    tslog_get_rate_limit("teste", NULL, NULL, &suppressed);
+
+    // Uma virada de segundo no meio do laço deixa passar mais 10
+    if (summaries == 0 || lines > 25 || suppressed < 970) {
+        fprintf(stderr, "Limite de log incorreto: %d linhas, %d resumos, %ld suprimidas\n",
+                lines, summaries, suppressed);
+        return -1;
+    }
+    return 0;
+}
+
+// Rajada que para: o resumo sai pela thread escritora, sem esperar a
+// próxima chamada do site nem o tslog_destroy
+static int count_summaries(const char *filename) {
+    FILE *fp = fopen(filename, "r");
+    if (!fp) return 0;
+    char line[256];
+    int summaries = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        if (strstr(line, "mensagens suprimidas")) summaries++;
+    }
+    fclose(fp);
+    return summaries;
+}
+
+int test_rate_limit_idle() {
+    const char *filename = "test_rate_limit_idle.log";
+    unlink(filename);
+
+    if (tslog_init(&logger, filename, TSLOG_INFO) != 0 ||
+        tslog_enable_async(&logger, 0, TSLOG_OVERFLOW_BLOCK) != 0) {
+        return -1;
+    }
+    tslog_set_rate_limit("rajada", 5, 1);
+    for (int i = 0; i < 100; i++) {
+        tslog_info_limited(&logger, "rajada", "Rajada %d", i);
+    }
+
+    int summaries = 0;
+    for (int waited = 0; waited < 3000 && summaries == 0; waited += 100) {
+        usleep(100000);
+        tslog_flush(&logger);
+        summaries = count_summaries(filename);
+    }
+    tslog_destroy(&logger);
+    unlink(filename);
+
+    if (summaries == 0) {
+        fprintf(stderr, "Resumo da rajada só sairia no encerramento\n");
+        return -1;
+    }
+    return 0;
+}
+
+// Nível desligado: a linha não sai e os argumentos nem são avaliados
+static int evaluated = 0;
+
+static int side_effect(void) {
+    return ++evaluated;
+}
+
+int test_level_filter() {
+    const char *filename = "test_level_filter.log";
+    unlink(filename);
+
+    if (tslog_init(&logger, filename, TSLOG_WARN) != 0) {
+        return -1;
+    }
+    tslog_info(&logger, "Ignorada %d", side_effect());
+    tslog_debug(&logger, "Ignorada %d", side_effect());
+    int skipped = evaluated;
+    tslog_error(&logger, "Registrada %d", side_effect());
+    tslog_destroy(&logger);
+
+    FILE *fp = fopen(filename, "r");
+    if (!fp) return -1;
+    char line[256];
+    int lines = 0, ignored = 0;
+    while (fgets(line, sizeof(line), fp)) {
+        lines++;
+        if (strstr(line, "Ignorada")) ignored++;
+    }
+    fclose(fp);
+    unlink(filename);
+
+    if (skipped != 0 || evaluated != 1 || lines != 1 || ignored != 0) {
+        fprintf(stderr, "Filtro de nível incorreto: %d avaliados antes, %d linhas, %d ignoradas escritas\n",
+                skipped, lines, ignored);
+        return -1;
+    }
+    return 0;
+}
+
+// Modo binário: cabeçalho mágico, format string gravada uma vez e os
+// argumentos crus, sem o texto formatado
+static int count_bytes(const char *data, size_t size, const char *needle) {
+    size_t len = strlen(needle);
+    int found = 0;
+    for (size_t i = 0; i + len <= size; i++) {
+        if (memcmp(data + i, needle, len) == 0) found++;
+    }
+    return found;
+}
+
+int test_binary() {
+    const char *filename = "test_binary.log";
+    unlink(filename);
+
+    if (tslog_init(&logger, filename, TSLOG_INFO) != 0 || tslog_enable_binary(&logger) != 0) {
+        return -1;
+    }
+    for (int i = 0; i < 3; i++) {
+        tslog_info(&logger, "Job %d do cliente %s em %.2fs", 42 + i, "alfa", 1.5);
+    }
+    tslog_destroy(&logger);
+
+    char data[4096];
+    FILE *fp = fopen(filename, "rb");
+    if (!fp) return -1;
+    size_t size = fread(data, 1, sizeof(data), fp);
+    fclose(fp);
+    unlink(filename);
+
+    int formats = count_bytes(data, size, "Job %d do cliente %s em %.2fs");
+    if (size < TSLOG_BIN_MAGIC_LEN || memcmp(data, TSLOG_BIN_MAGIC, TSLOG_BIN_MAGIC_LEN) != 0) {
+        fprintf(stderr, "Log binário sem cabeçalho\n");
+        return -1;
+    }
+    if (formats != 1 || count_bytes(data, size, "alfa") != 3 || count_bytes(data, size, "Job 42") != 0) {
+        fprintf(stderr, "Log binário com %d format strings ou texto formatado\n", formats);
+        return -1;
+    }
+    return 0;
+}
+
 int main() {
     // Inicializar logger
     if (tslog_init(&logger, "test_concurrent.log", TSLOG_DEBUG) != 0) {
@@ -51,5 +343,32 @@ int main() {
     tslog_info(&logger, "=== FIM TESTE CONCORRÊNCIA ===");
     
     tslog_destroy(&logger);
+    
+    // Modo assíncrono com buffer pequeno para exercitar a política de bloqueio
+    if (test_async() != 0) {
+        return 1;
+    }
+
+    if (test_rotation() != 0) {
+        return 1;
+    }
+
+    if (test_rate_limit() != 0) {
+        return 1;
+    }
+
+    if (test_rate_limit_idle() != 0) {
+        return 1;
+    }
+
+    if (test_level_filter() != 0) {
+        return 1;
+    }
+
+    if (test_binary() != 0) {
+        return 1;
+    }
+    
+    printf("Teste de concorrência concluído\n");
     return 0;
-}
\ No newline at end of file
+}
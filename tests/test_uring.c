@@ -0,0 +1,116 @@
+#include "../src/common/uring.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+#ifdef SCHED_IO_URING
+
+// Lê da conexão até o EOF de leitura; retorna quantos bytes chegaram
+static int read_all(uring_conn_t *conn, char *out, size_t size) {
+    size_t total = 0;
+    ssize_t n;
+    while (total < size - 1 && (n = uring_conn_fill(conn, out + total, size - 1 - total)) > 0) {
+        total += (size_t)n;
+    }
+    out[total] = '\0';
+    return (int)total;
+}
+
+// O cliente manda o pedido e fecha só a escrita: a resposta ainda tem que chegar
+int test_half_close() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) return -1;
+    uring_conn_t conn;
+    if (uring_conn_init(&conn, fds[0]) != 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+
+    int rc = 0;
+    const char *request = "STATUS:1\n";
+    if (write(fds[1], request, strlen(request)) != (ssize_t)strlen(request) ||
+        shutdown(fds[1], SHUT_WR) != 0) {
+        rc = -1;
+    }
+
+    char received[256];
+    if (rc == 0 && (read_all(&conn, received, sizeof(received)) < 0 || strcmp(received, request) != 0)) {
+        fprintf(stderr, "Pedido lido errado: \"%s\"\n", received);
+        rc = -1;
+    }
+    if (rc == 0 && uring_conn_fill(&conn, received, sizeof(received)) != -1) {
+        fprintf(stderr, "Leitura depois do EOF não retornou -1\n");
+        rc = -1;
+    }
+    if (rc == 0 && (uring_conn_queue(&conn, "ERROR:job 1 desconhecido") != 0 ||
+                    uring_conn_queue(&conn, "FIM") != 0)) {
+        fprintf(stderr, "Resposta recusada depois do EOF de leitura\n");
+        rc = -1;
+    }
+    // Fecha o anel antes do socket, como o handler do servidor
+    uring_conn_destroy(&conn);
+    close(fds[0]);
+
+    char reply[256];
+    ssize_t total = 0, n;
+    while (rc == 0 && (n = read(fds[1], reply + total, sizeof(reply) - 1 - total)) > 0) {
+        total += n;
+    }
+    reply[total > 0 ? total : 0] = '\0';
+    if (rc == 0 && strcmp(reply, "ERROR:job 1 desconhecido\nFIM\n") != 0) {
+        fprintf(stderr, "Resposta perdida no half-close: \"%s\"\n", reply);
+        rc = -1;
+    }
+    close(fds[1]);
+    return rc;
+}
+
+// O outro lado sumiu de vez: o envio falha e a conexão para de aceitar linhas
+int test_broken() {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) return -1;
+    uring_conn_t conn;
+    if (uring_conn_init(&conn, fds[0]) != 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    close(fds[1]);
+
+    int rc = 0;
+    if (uring_conn_queue(&conn, "OK") != 0 || uring_conn_flush(&conn) != -1) {
+        fprintf(stderr, "Envio para socket fechado não falhou\n");
+        rc = -1;
+    }
+    if (rc == 0 && uring_conn_queue(&conn, "OK") != -1) {
+        fprintf(stderr, "Linha aceita depois do envio falhar\n");
+        rc = -1;
+    }
+    uring_conn_destroy(&conn);
+    close(fds[0]);
+    return rc;
+}
+
+int main() {
+    if (!uring_available()) {
+        printf("Teste do io_uring ignorado (kernel sem io_uring)\n");
+        return 0;
+    }
+    int rc = 0;
+    if (test_half_close() != 0) rc = 1;
+    if (rc == 0 && test_broken() != 0) rc = 1;
+
+    if (rc == 0) printf("Teste do io_uring concluído\n");
+    return rc;
+}
+
+#else
+
+int main() {
+    printf("Teste do io_uring ignorado (compile com make IO_URING=1)\n");
+    return 0;
+}
+
+#endif
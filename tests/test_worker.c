@@ -0,0 +1,161 @@
+#include "../include/tslog.h"
+#include "../include/job_queue.h"
+#include "../include/lease_table.h"
+#include "../include/worker_manager.h"
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/socket.h>
+
+tslog_t logger;
+
+// Registra um worker numa ponta de socketpair; a outra ponta fica com o
+// teste, no papel do processo worker. Retorna o id lido do REGISTERED.
+static int connect_worker(worker_manager_t *manager, const char *hostname, int slots, int *peer) {
+    int fds[2];
+    if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) return -1;
+    int id = worker_manager_register(manager, fds[0], hostname, slots, "");
+    if (id < 0) {
+        close(fds[0]);
+        close(fds[1]);
+        return -1;
+    }
+    char line[64] = "";
+    ssize_t n = read(fds[1], line, sizeof(line) - 1);
+    int answered = -1;
+    if (n <= 0 || sscanf(line, "REGISTERED:%d", &answered) != 1 || answered != id) {
+        fprintf(stderr, "Worker %s recebeu \"%s\" (id %d)\n", hostname, line, id);
+        close(fds[1]);
+        return -1;
+    }
+    *peer = fds[1];
+    return id;
+}
+
+// Socket derrubado pelo servidor: a ponta do worker lê EOF
+static int peer_closed(int peer) {
+    char buf[16];
+    return read(peer, buf, sizeof(buf)) == 0;
+}
+
+// Ids crescentes, consulta por id e saída do registro
+int test_registry(worker_manager_t *manager) {
+    int peers[3];
+    int ids[3];
+    const char *names[] = {"alfa", "beta", "gama"};
+    for (int i = 0; i < 3; i++) {
+        ids[i] = connect_worker(manager, names[i], i, &peers[i]);
+        if (ids[i] <= 0 || (i > 0 && ids[i] <= ids[i - 1])) return -1;
+    }
+
+    worker_info_t info;
+    if (worker_manager_count(manager) != 3 || worker_manager_get(manager, ids[1], &info) != 0 ||
+        strcmp(info.hostname, "beta") != 0 || !info.is_alive) {
+        fprintf(stderr, "Registro não encontrou o worker beta\n");
+        return -1;
+    }
+
+    worker_manager_unregister(manager, ids[1]);
+    if (worker_manager_count(manager) != 2 || worker_manager_get(manager, ids[1], &info) == 0 ||
+        !peer_closed(peers[1])) {
+        fprintf(stderr, "Worker desconectado ficou no registro\n");
+        return -1;
+    }
+    worker_manager_unregister(manager, ids[1]);   // handler e expiração chamam de novo: nada muda
+
+    for (int i = 0; i < 3; i++) {
+        if (i != 1) worker_manager_unregister(manager, ids[i]);
+        close(peers[i]);
+    }
+    return worker_manager_count(manager) == 0 ? 0 : -1;
+}
+
+// Sem mensagem dentro do prazo: o worker é dado como morto, a conexão cai e
+// o job dele volta à fila depois do backoff. Quem manda heartbeat continua.
+int test_heartbeat_expiry(worker_manager_t *manager, job_queue_t *queue, lease_table_t *leases) {
+    int silent_peer, alive_peer;
+    int silent = connect_worker(manager, "mudo", 0, &silent_peer);
+    int alive = connect_worker(manager, "vivo", 0, &alive_peer);
+    if (silent < 0 || alive < 0) return -1;
+
+    job_t job;
+    memset(&job, 0, sizeof(job));
+    snprintf(job.script, sizeof(job.script), "sleep 60");
+    job.priority = 5;
+    job.timeout = 60;
+    if (job_queue_push(queue, &job) < 0 || job_queue_pop_timed(queue, &job, 0) != 0 ||
+        worker_manager_assign_job(manager, silent, &job) != 0) {
+        fprintf(stderr, "Job não atribuído ao worker\n");
+        return -1;
+    }
+
+    // Timeout de 1s, roda de 250ms: oito voltas dão folga de sobra
+    for (int i = 0; i < 8; i++) {
+        usleep(WORKER_WHEEL_TICK_MS * 1000);
+        worker_manager_heartbeat(manager, alive);
+        worker_manager_check_heartbeats(manager);
+    }
+
+    worker_info_t info;
+    if (worker_manager_get(manager, silent, &info) != 0 || info.is_alive || info.active_jobs != 0) {
+        fprintf(stderr, "Worker sem heartbeat continua vivo\n");
+        return -1;
+    }
+    if (!peer_closed(silent_peer)) {
+        fprintf(stderr, "Conexão do worker morto não caiu\n");
+        return -1;
+    }
+    if (worker_manager_get(manager, alive, &info) != 0 || !info.is_alive) {
+        fprintf(stderr, "Worker com heartbeat expirou\n");
+        return -1;
+    }
+    // Morto não recebe job nem por pull
+    if (worker_manager_assign_job(manager, silent, &job) != -1) {
+        fprintf(stderr, "Worker morto recebeu job\n");
+        return -1;
+    }
+
+    usleep((LEASE_BACKOFF_BASE_MS + 300) * 1000);
+    lease_table_check(leases, NULL, NULL);
+    memset(&job, 0, sizeof(job));
+    if (job_queue_pop_timed(queue, &job, 0) != 0 || job.attempts != 1) {
+        fprintf(stderr, "Job do worker morto não voltou à fila\n");
+        return -1;
+    }
+
+    // O handler encerra depois do EOF e tira o worker do registro
+    worker_manager_unregister(manager, silent);
+    worker_manager_unregister(manager, alive);
+    close(silent_peer);
+    close(alive_peer);
+    return worker_manager_count(manager) == 0 ? 0 : -1;
+}
+
+int main() {
+    if (tslog_init(&logger, "test_worker.log", TSLOG_ERROR) != 0) {
+        fprintf(stderr, "Erro ao inicializar logger\n");
+        return 1;
+    }
+
+    job_queue_t queue;
+    lease_table_t leases;
+    worker_manager_t manager;
+    if (job_queue_init(&queue, &logger) != 0 || lease_table_init(&leases, &queue, &logger) != 0 ||
+        worker_manager_init(&manager, &logger, &queue) != 0) {
+        fprintf(stderr, "Erro ao inicializar fila, leases e workers\n");
+        return 1;
+    }
+    worker_manager_attach_leases(&manager, &leases);
+    worker_manager_set_timeout(&manager, 1);
+
+    int rc = 0;
+    if (test_registry(&manager) != 0) rc = 1;
+    if (rc == 0 && test_heartbeat_expiry(&manager, &queue, &leases) != 0) rc = 1;
+
+    worker_manager_destroy(&manager);
+    lease_table_destroy(&leases);
+    job_queue_destroy(&queue);
+    tslog_destroy(&logger);
+    if (rc == 0) printf("Teste do registro de workers concluído\n");
+    return rc;
+}
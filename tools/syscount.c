@@ -0,0 +1,175 @@
+// syscount: conta as chamadas de sistema de um processo e das suas threads
+// (ptrace). Os processos filhos (fork: scripts executados pelo worker) não
+// são seguidos. Usado por scripts/io_bench.sh para comparar o caminho
+// portável com o io_uring (make IO_URING=1).
+//
+// Uso: syscount <relatório> <programa> [argumentos...]
+//  - SIGUSR1 zera as contagens (início da medição)
+//  - SIGINT/SIGTERM escreve o relatório, encerra o programa e sai; o
+//    relatório também é escrito se o programa terminar sozinho
+
+#define _GNU_SOURCE
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <signal.h>
+#include <unistd.h>
+#include <sys/ptrace.h>
+#include <sys/syscall.h>
+#include <sys/wait.h>
+
+#define MAX_SYSCALL 512
+
+static unsigned long counts[MAX_SYSCALL];
+static volatile sig_atomic_t reset_requested = 0;
+static volatile sig_atomic_t stop_requested = 0;
+
+// Nomes das mais comuns no servidor e no worker; as outras saem pelo número
+static const struct {
+    long nr;
+    const char *name;
+} names[] = {
+    {SYS_read, "read"}, {SYS_write, "write"}, {SYS_close, "close"},
+    {SYS_recvfrom, "recvfrom"}, {SYS_sendto, "sendto"}, {SYS_recvmsg, "recvmsg"},
+    {SYS_sendmsg, "sendmsg"}, {SYS_accept, "accept"}, {SYS_accept4, "accept4"},
+    {SYS_futex, "futex"}, {SYS_clone, "clone"}, {SYS_clone3, "clone3"},
+    {SYS_mmap, "mmap"}, {SYS_munmap, "munmap"}, {SYS_mprotect, "mprotect"},
+    {SYS_madvise, "madvise"}, {SYS_brk, "brk"}, {SYS_rt_sigprocmask, "rt_sigprocmask"},
+    {SYS_rt_sigaction, "rt_sigaction"}, {SYS_set_robust_list, "set_robust_list"},
+    {SYS_rseq, "rseq"}, {SYS_exit, "exit"}, {SYS_execve, "execve"}, {SYS_wait4, "wait4"},
+    {SYS_pipe2, "pipe2"}, {SYS_dup3, "dup3"}, {SYS_fcntl, "fcntl"},
+    {SYS_fstat, "fstat"}, {SYS_newfstatat, "newfstatat"}, {SYS_lseek, "lseek"},
+    {SYS_pread64, "pread64"}, {SYS_pwrite64, "pwrite64"}, {SYS_fsync, "fsync"},
+    {SYS_fdatasync, "fdatasync"}, {SYS_openat, "openat"}, {SYS_getpid, "getpid"},
+    {SYS_gettid, "gettid"}, {SYS_setpgid, "setpgid"}, {SYS_kill, "kill"},
+    {SYS_clock_nanosleep, "clock_nanosleep"}, {SYS_nanosleep, "nanosleep"},
+    {SYS_getpeername, "getpeername"}, {SYS_getsockname, "getsockname"},
+    {SYS_setsockopt, "setsockopt"}, {SYS_ppoll, "ppoll"}, {SYS_eventfd2, "eventfd2"},
+    {SYS_io_uring_setup, "io_uring_setup"}, {SYS_io_uring_enter, "io_uring_enter"},
+    {SYS_io_uring_register, "io_uring_register"},
+};
+
+static const char *syscall_name(long nr, char *buf, size_t size) {
+    for (size_t i = 0; i < sizeof(names) / sizeof(names[0]); i++) {
+        if (names[i].nr == nr) return names[i].name;
+    }
+    snprintf(buf, size, "syscall_%ld", nr);
+    return buf;
+}
+
+static void on_signal(int sig) {
+    if (sig == SIGUSR1) {
+        reset_requested = 1;
+    } else {
+        stop_requested = 1;
+    }
+}
+
+static int write_report(const char *path) {
+    FILE *out = fopen(path, "w");
+    if (!out) {
+        perror(path);
+        return -1;
+    }
+    unsigned long total = 0;
+    for (int i = 0; i < MAX_SYSCALL; i++) total += counts[i];
+    fprintf(out, "total %lu\n", total);
+
+    // Maiores primeiro (seleção: são poucas centenas de posições)
+    int printed[MAX_SYSCALL] = {0};
+    for (;;) {
+        int best = -1;
+        for (int i = 0; i < MAX_SYSCALL; i++) {
+            if (!printed[i] && counts[i] > 0 && (best < 0 || counts[i] > counts[best])) best = i;
+        }
+        if (best < 0) break;
+        printed[best] = 1;
+        char buf[32];
+        fprintf(out, "%lu %s\n", counts[best], syscall_name(best, buf, sizeof(buf)));
+    }
+    fclose(out);
+    return 0;
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 3) {
+        fprintf(stderr, "Uso: %s <relatório> <programa> [argumentos...]\n", argv[0]);
+        return 1;
+    }
+    const char *report = argv[1];
+
+    pid_t child = fork();
+    if (child < 0) {
+        perror("fork");
+        return 1;
+    }
+    if (child == 0) {
+        ptrace(PTRACE_TRACEME, 0, NULL, NULL);
+        raise(SIGSTOP);
+        execvp(argv[2], argv + 2);
+        perror(argv[2]);
+        _exit(127);
+    }
+
+    int status;
+    if (waitpid(child, &status, 0) < 0 || !WIFSTOPPED(status)) {
+        fprintf(stderr, "Não foi possível rastrear %s\n", argv[2]);
+        return 1;
+    }
+    // Threads novas entram no rastreamento; fork não (TRACEFORK ausente)
+    ptrace(PTRACE_SETOPTIONS, child, NULL,
+           (void*)(long)(PTRACE_O_TRACESYSGOOD | PTRACE_O_TRACECLONE | PTRACE_O_TRACEEXEC |
+                          PTRACE_O_EXITKILL));
+    ptrace(PTRACE_SYSCALL, child, NULL, NULL);
+
+    // Sem SA_RESTART: o sinal interrompe o waitpid
+    struct sigaction sa;
+    memset(&sa, 0, sizeof(sa));
+    sa.sa_handler = on_signal;
+    sigaction(SIGUSR1, &sa, NULL);
+    sigaction(SIGINT, &sa, NULL);
+    sigaction(SIGTERM, &sa, NULL);
+
+    for (;;) {
+        if (stop_requested) {
+            write_report(report);
+            kill(child, SIGKILL);
+            return 0;
+        }
+        if (reset_requested) {
+            reset_requested = 0;
+            memset(counts, 0, sizeof(counts));
+        }
+
+        pid_t pid = waitpid(-1, &status, __WALL);
+        if (pid < 0) {
+            if (errno == EINTR) continue;
+            break;                      // nenhum rastreado sobrou
+        }
+        if (WIFEXITED(status) || WIFSIGNALED(status)) {
+            if (pid == child) break;
+            continue;
+        }
+        if (!WIFSTOPPED(status)) continue;
+
+        int sig = WSTOPSIG(status);
+        int inject = 0;
+        if (sig == (SIGTRAP | 0x80)) {
+            struct __ptrace_syscall_info info;
+            if (ptrace(PTRACE_GET_SYSCALL_INFO, pid, (void*)sizeof(info), &info) > 0 &&
+                info.op == PTRACE_SYSCALL_INFO_ENTRY && info.entry.nr < MAX_SYSCALL) {
+                counts[info.entry.nr]++;
+            }
+        } else if (status >> 16) {
+            // Evento (clone, exec): nada a repassar
+        } else if (sig != SIGSTOP) {
+            // SIGSTOP é o das threads novas; os outros vão para o programa
+            inject = sig;
+        }
+        ptrace(PTRACE_SYSCALL, pid, NULL, (void*)(long)inject);
+    }
+
+    write_report(report);
+    return 0;
+}
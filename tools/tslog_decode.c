@@ -0,0 +1,233 @@
+// tslog-decode: converte um log binário da libtslog (tslog_enable_binary)
+// de volta para o formato texto "[timestamp] [NÍVEL] mensagem".
+//
+// Uso: tslog-decode <arquivo> [formato_timestamp]
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include "../include/tslog.h"
+#include "../src/libtslog/tslog_binary.h"
+
+typedef struct {
+    const unsigned char *data;
+    size_t size;
+    size_t off;
+} reader_t;
+
+static int get(reader_t *r, void *out, size_t len) {
+    if (r->off + len > r->size) return -1;
+    memcpy(out, r->data + r->off, len);
+    r->off += len;
+    return 0;
+}
+
+static char **formats = NULL;
+static size_t formats_cap = 0;
+
+static void set_format(uint32_t id, const char *str, size_t len) {
+    if (id >= formats_cap) {
+        size_t cap = formats_cap ? formats_cap : 64;
+        while (cap <= id) cap *= 2;
+        formats = realloc(formats, cap * sizeof(char*));
+        memset(formats + formats_cap, 0, (cap - formats_cap) * sizeof(char*));
+        formats_cap = cap;
+    }
+    free(formats[id]);
+    formats[id] = strndup(str, len);
+}
+
+// Pula um registro sem interpretá-lo (usado na primeira passada)
+static int skip_record(reader_t *r, char type) {
+    uint16_t len;
+    switch (type) {
+        case 'F': {
+            uint32_t id;
+            if (get(r, &id, 4) || get(r, &len, 2) || r->off + len > r->size) return -1;
+            set_format(id, (const char*)r->data + r->off, len);
+            r->off += len;
+            return 0;
+        }
+        case 'R':
+            r->off += 1 + 4 + 8 + 4 + 4;
+            break;
+        case 'S':
+            r->off += 1 + 8 + 4 + 4;
+            break;
+        default:
+            return -1;
+    }
+    if (get(r, &len, 2) || r->off + len > r->size) return -1;
+    r->off += len;
+    return 0;
+}
+
+// Renderiza a mensagem re-aplicando cada especificador com o argumento gravado
+static void render(FILE *out, const char *format, reader_t *args) {
+    for (const char *p = format; *p; p++) {
+        if (*p != '%') {
+            fputc(*p, out);
+            continue;
+        }
+
+        tslog_spec_t spec;
+        if (tslog_parse_spec(p, &spec) != 0) {
+            fputc(*p, out);
+            continue;
+        }
+        if (spec.conversion == '%') {
+            fputc('%', out);
+            p++;
+            continue;
+        }
+
+        // Reconstrói o especificador trocando '*' pelos valores gravados e
+        // removendo 'L' (long double é gravado como double)
+        char fmt[64];
+        size_t n = 0;
+        for (size_t i = 0; i < spec.length && n < sizeof(fmt) - 16; i++) {
+            char c = p[i];
+            if (c == '*') {
+                char tag;
+                int32_t v = 0;
+                if (get(args, &tag, 1) == 0) get(args, &v, 4);
+                n += (size_t)snprintf(fmt + n, sizeof(fmt) - n, "%d", v);
+            } else if (c != 'L') {
+                fmt[n++] = c;
+            }
+        }
+        fmt[n] = '\0';
+        p += spec.length - 1;
+
+        char tag = 0;
+        if (get(args, &tag, 1) != 0) {
+            fputs("<?>", out);
+            continue;
+        }
+
+        switch (tag) {
+            case 'i': {
+                int32_t v = 0;
+                get(args, &v, 4);
+                fprintf(out, fmt, v);
+                break;
+            }
+            case 'l': {
+                int64_t v = 0;
+                get(args, &v, 8);
+                fprintf(out, fmt, (long long)v);
+                break;
+            }
+            case 'd': {
+                double v = 0;
+                get(args, &v, 8);
+                fprintf(out, fmt, v);
+                break;
+            }
+            case 'p': {
+                uint64_t v = 0;
+                get(args, &v, 8);
+                fprintf(out, fmt, (void*)(uintptr_t)v);
+                break;
+            }
+            case 's': {
+                uint16_t len = 0;
+                get(args, &len, 2);
+                char *str = strndup((const char*)args->data + args->off, len);
+                args->off += len;
+                fprintf(out, fmt, str ? str : "");
+                free(str);
+                break;
+            }
+            default:
+                fputs("<?>", out);
+                break;
+        }
+    }
+}
+
+static void print_header(FILE *out, const char *ts_format, int64_t sec, uint8_t level) {
+    char timestamp[64];
+    time_t t = (time_t)sec;
+    struct tm timeinfo;
+    localtime_r(&t, &timeinfo);
+    strftime(timestamp, sizeof(timestamp), ts_format, &timeinfo);
+    fprintf(out, "[%s] [%s] ", timestamp, tslog_level_to_string((tslog_level_t)level));
+}
+
+int main(int argc, char *argv[]) {
+    if (argc < 2) {
+        fprintf(stderr, "Uso: %s <arquivo> [formato_timestamp]\n", argv[0]);
+        return 1;
+    }
+    const char *ts_format = argc > 2 ? argv[2] : "%Y-%m-%d %H:%M:%S";
+
+    FILE *fp = fopen(argv[1], "rb");
+    if (!fp) {
+        perror(argv[1]);
+        return 1;
+    }
+
+    fseek(fp, 0, SEEK_END);
+    long size = ftell(fp);
+    fseek(fp, 0, SEEK_SET);
+
+    unsigned char *data = malloc(size > 0 ? (size_t)size : 1);
+    if (!data || fread(data, 1, (size_t)size, fp) != (size_t)size) {
+        fprintf(stderr, "Erro lendo %s\n", argv[1]);
+        fclose(fp);
+        return 1;
+    }
+    fclose(fp);
+
+    // Os registros 'F' podem aparecer depois dos 'R' que os usam (buffers de
+    // threads diferentes são drenados em qualquer ordem): duas passadas.
+    for (int pass = 0; pass < 2; pass++) {
+        reader_t r = {data, (size_t)size, 0};
+
+        while (r.off < r.size) {
+            if (r.size - r.off >= TSLOG_BIN_MAGIC_LEN &&
+                memcmp(r.data + r.off, TSLOG_BIN_MAGIC, TSLOG_BIN_MAGIC_LEN) == 0) {
+                r.off += TSLOG_BIN_MAGIC_LEN;
+                continue;
+            }
+
+            char type = (char)r.data[r.off++];
+            if (pass == 0 || type == 'F') {
+                if (skip_record(&r, type) != 0) break;
+                continue;
+            }
+
+            uint8_t level;
+            uint32_t id = 0, nsec, thread;
+            int64_t sec;
+            uint16_t len;
+
+            if (get(&r, &level, 1) ||
+                (type == 'R' && get(&r, &id, 4)) ||
+                get(&r, &sec, 8) || get(&r, &nsec, 4) || get(&r, &thread, 4) ||
+                get(&r, &len, 2) || r.off + len > r.size) {
+                fprintf(stderr, "Registro truncado no byte %zu\n", r.off);
+                break;
+            }
+
+            print_header(stdout, ts_format, sec, level);
+
+            if (type == 'S') {
+                fwrite(r.data + r.off, 1, len, stdout);
+            } else if (id < formats_cap && formats[id]) {
+                reader_t args = {r.data + r.off, len, 0};
+                render(stdout, formats[id], &args);
+            } else {
+                printf("<formato %u desconhecido>", id);
+            }
+            fputc('\n', stdout);
+            r.off += len;
+        }
+    }
+
+    free(data);
+    return 0;
+}